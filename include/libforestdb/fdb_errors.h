@@ -174,6 +174,10 @@ typedef enum {
      * Please retry in sometime.
      */
     FDB_RESULT_IN_USE_BY_COMPACTOR = -35,
+    /**
+     * The given buffer is too small to hold a single document.
+     */
+    FDB_RESULT_TOO_SMALL_BUFFER = -36,
 } fdb_status;
 
 #ifdef __cplusplus
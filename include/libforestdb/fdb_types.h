@@ -93,6 +93,47 @@ enum {
     FDB_SEQTREE_USE = 1
 };
 
+/**
+ * Prefetch modes of a DB file, used when the file is opened.
+ */
+typedef uint8_t fdb_prefetch_mode_t;
+enum {
+    /**
+     * Read the file backwards from its end for 'prefetch_duration' seconds.
+     */
+    FDB_PREFETCH_TAIL = 0,
+    /**
+     * Load the nodes of the HB+trie top-down, level by level.
+     */
+    FDB_PREFETCH_INDEX = 1,
+    /**
+     * Load the nodes of the HB+trie and then those of the sequence index.
+     */
+    FDB_PREFETCH_INDEX_SEQTREE = 2
+};
+
+/**
+ * Formats of index B+tree nodes created in a DB file.
+ */
+typedef uint8_t fdb_node_format_t;
+enum {
+    /**
+     * Keys and values are interleaved in each node. Files written in this
+     * format are readable by all versions of ForestDB.
+     */
+    FDB_NODE_FORMAT_V1 = 0,
+    /**
+     * Keys and values of the HB+trie and sequence index nodes are stored in
+     * separate arrays, so that a key search only touches the keys, and the
+     * nodes of KV stores with custom compare functions store the common
+     * prefix of their keys only once. Node blocks of a new file, or of a
+     * file written by compaction, are checksummed using CRC32C instead of
+     * the legacy CRC32. Files containing such nodes cannot be read by
+     * earlier versions of ForestDB.
+     */
+    FDB_NODE_FORMAT_V2 = 1
+};
+
 /**
  * Durability options for ForestDB.
  */
@@ -264,6 +305,75 @@ typedef struct {
      * prefetching is disabled. This is a local config to each ForestDB file.
      */
     uint64_t prefetch_duration;
+    /**
+     * Number of bits per key of the Bloom filter that is used to skip the
+     * index lookup of non-existing keys. The filter is created for a new file,
+     * and rebuilt for the new file when the file is compacted. If this is set
+     * to zero (default), the filter is not created, but an existing filter is
+     * still used and maintained. This is a local config to each ForestDB file.
+     */
+    uint8_t bloom_filter_bits_per_key;
+    /**
+     * Threshold in milliseconds above which fdb_get, fdb_set (including
+     * fdb_del), fdb_commit, and iterator seek/next/prev calls are reported
+     * through the log callback of the handle, along with the time spent on each internal
+     * phase (WAL lookup, HB+trie descent, cache misses, document reads, lock
+     * waits, WAL flush, and fsync). The entry is reported with
+     * FDB_RESULT_SUCCESS as the error code. If this is set to zero (default),
+     * slow operations are not tracked. This is a local config to each
+     * ForestDB handle.
+     */
+    uint32_t slow_op_threshold;
+    /**
+     * Flag to enable the buffer cache warm-up across restarts. If enabled,
+     * the list of the file's blocks resident in the buffer cache is saved in
+     * '<filename>.warmup' when the file is closed (or on fdb_shutdown), with
+     * index nodes and recently used blocks first. When the file is opened
+     * again, as many of those blocks as fit in the free cache space are
+     * loaded in the background, in ascending block order with batched
+     * sequential reads, instead of prefetching the tail of the file.
+     * This is a local config to each ForestDB file.
+     */
+    bool cache_warmup;
+    /**
+     * Prefetch mode used when the file is opened. FDB_PREFETCH_TAIL (default)
+     * reads the tail of the file for 'prefetch_duration' seconds. The index
+     * modes walk the HB+trie (and the sequence index, for
+     * FDB_PREFETCH_INDEX_SEQTREE) from the root down in the background, and
+     * load each level with several concurrent batched reads, so that all
+     * index nodes are cached before any document block. The cache warm-up
+     * list (see cache_warmup) takes precedence over both modes, as it is
+     * guided by the blocks actually used before the restart.
+     * This is a local config to each ForestDB file.
+     */
+    fdb_prefetch_mode_t prefetch_mode;
+    /**
+     * Maximum share of the buffer cache, in percent, that is filled by the
+     * index prefetch modes. This is a local config to each ForestDB file.
+     */
+    uint8_t prefetch_cache_ratio;
+    /**
+     * Flag to read a file opened with FDB_OPEN_FLAG_RDONLY through a memory
+     * mapping of the file. Committed blocks are then read from the mapping
+     * instead of the buffer cache and pread calls: documents are read in
+     * place, and index nodes are copied from the mapping, so that the OS
+     * page cache is the only cache of the file. The mapping is extended as
+     * the file grows, and a new one is created for the new file on
+     * compaction. Prefetching and cache warm-up are not started by such
+     * handles. Other handles of the same file (e.g., a writer) still use the
+     * buffer cache. This is ignored for handles opened without
+     * FDB_OPEN_FLAG_RDONLY, or on platforms without mmap support (Windows).
+     * This is a local config to each ForestDB handle.
+     */
+    bool mmap_readonly;
+    /**
+     * Format of index B+tree nodes created in the file. Nodes are always
+     * read in the format they were written in, and existing B+trees keep
+     * their format; this only applies to B+trees created from now on,
+     * including all those written by compaction. This is a local config to
+     * each ForestDB file.
+     */
+    fdb_node_format_t node_format;
 } fdb_config;
 
 typedef struct {
@@ -347,8 +457,10 @@ typedef struct _fdb_kvs_handle fdb_kvs_handle;
  * ForestDB iterator options.Combinational options can be passed to the iterator.
  * For example, FDB_ITR_METAONLY | FDB_ITR_NO_DELETES means
  * "Return non-deleted key and its metadata only through iterator".
+ * The upper 16 bits are reserved for the readahead window size
+ * (see FDB_ITR_PREFETCH_WINDOW).
  */
-typedef uint8_t fdb_iterator_opt_t;
+typedef uint32_t fdb_iterator_opt_t;
 enum {
     /**
      * Return both key and value through iterator.
@@ -361,9 +473,29 @@ enum {
     /**
      * Return only non-deleted items through iterator.
      */
-    FDB_ITR_NO_DELETES = 0x02
+    FDB_ITR_NO_DELETES = 0x02,
+    /**
+     * Return key, sequence number, and offset only through iterator,
+     * directly from the index and WAL without reading documents.
+     * Sequence numbers and deletion flags are only available for the items
+     * in WAL; the items in the main index have (fdb_seqnum_t)-1 as their
+     * sequence numbers. Combining with FDB_ITR_NO_DELETES, or the existence
+     * of range deletions, requires reading document headers of the items in
+     * the main index. Only supported by key iterators.
+     */
+    FDB_ITR_KEYS_ONLY = 0x04
 };
 
+/**
+ * Iterator option that makes fdb_iterator_next() look ahead the next 'n'
+ * keys (up to 65535) in the main index, and read the blocks of their
+ * documents into the buffer cache in file offset order before they are
+ * consumed. For example, FDB_ITR_NO_DELETES | FDB_ITR_PREFETCH_WINDOW(256).
+ * This has no effect if the buffer cache is disabled.
+ */
+#define FDB_ITR_PREFETCH_WINDOW(n) \
+    ((fdb_iterator_opt_t)(((uint32_t)(n) & 0xffff) << 16))
+
 /**
  * Opaque reference to ForestDB iterator structure definition, which is exposed
  * in public APIs.
@@ -416,6 +548,333 @@ typedef struct {
     uint64_t file_size;
 } fdb_file_info;
 
+/**
+ * Statistics of the Bloom filter of a ForestDB file
+ */
+typedef struct {
+    /**
+     * Number of filter stages. A new stage is added when the existing stages
+     * are full, and all stages are merged into one by compaction.
+     */
+    uint32_t num_stages;
+    /**
+     * Total number of bits in the filter.
+     */
+    uint64_t num_bits;
+    /**
+     * Memory (bytes) used by the filter.
+     */
+    uint64_t memory_used;
+    /**
+     * Number of keys added to the filter.
+     */
+    uint64_t num_keys;
+    /**
+     * Number of lookups that checked the filter since the file was opened.
+     */
+    uint64_t num_checks;
+    /**
+     * Number of lookups whose index traversal was skipped by the filter.
+     */
+    uint64_t num_negatives;
+    /**
+     * Number of lookups that passed the filter but whose key was not found in
+     * the index.
+     */
+    uint64_t num_false_positives;
+    /**
+     * False positive rate estimated from the number of keys and bits.
+     */
+    double estimated_fp_rate;
+    /**
+     * Observed false positive rate, i.e.,
+     * num_false_positives / (num_negatives + num_false_positives).
+     */
+    double observed_fp_rate;
+} fdb_bloom_stats;
+
+/**
+ * Statistics of the buffer cache, either for a single file or for the
+ * whole cache shared by all files.
+ */
+typedef struct {
+    /**
+     * Number of block lookups that hit the cache.
+     */
+    uint64_t num_hits;
+    /**
+     * Number of block lookups that missed the cache, including read-ahead
+     * lookups for blocks that are not cached yet.
+     */
+    uint64_t num_misses;
+    /**
+     * Number of clean blocks evicted.
+     */
+    uint64_t num_clean_evictions;
+    /**
+     * Number of blocks evicted after being written back, as the victim file
+     * had no clean block.
+     */
+    uint64_t num_dirty_evictions;
+    /**
+     * Number of dirty blocks written back to the file, either by eviction or
+     * by commit.
+     */
+    uint64_t num_dirty_writebacks;
+    /**
+     * Number of victim file selections and the total time (nanoseconds)
+     * spent on them. Only available in the global statistics.
+     */
+    uint64_t num_victim_selections;
+    uint64_t victim_selection_time;
+    /**
+     * Number of cached blocks, and how many of them are dirty, B+tree
+     * index nodes, and document blocks.
+     */
+    uint64_t num_cached_blocks;
+    uint64_t num_dirty_blocks;
+    uint64_t num_index_blocks;
+    uint64_t num_doc_blocks;
+    /**
+     * Capacity of the cache and the number of free blocks. Only available
+     * in the global statistics.
+     */
+    uint64_t num_total_blocks;
+    uint64_t num_free_blocks;
+} fdb_buffer_cache_stats;
+
+/**
+ * Operations and internal phases whose latencies are tracked per file.
+ */
+typedef uint8_t fdb_latency_stat_type;
+enum {
+    /**
+     * fdb_get calls.
+     */
+    FDB_LATENCY_GETS = 0,
+    /**
+     * fdb_set and fdb_del calls.
+     */
+    FDB_LATENCY_SETS = 1,
+    /**
+     * fdb_commit calls.
+     */
+    FDB_LATENCY_COMMITS = 2,
+    /**
+     * Flushes of WAL entries into the main index.
+     */
+    FDB_LATENCY_WAL_FLUSH = 3,
+    /**
+     * Block reads that miss the buffer cache and go to disk.
+     */
+    FDB_LATENCY_READ_MISS = 4,
+    /**
+     * fsync calls.
+     */
+    FDB_LATENCY_FSYNC = 5,
+    /**
+     * Compaction phase that flushes WAL and commits the old file.
+     */
+    FDB_LATENCY_COMPACT_FLUSH = 6,
+    /**
+     * Compaction phase that moves live documents into the new file.
+     */
+    FDB_LATENCY_COMPACT_MOVE = 7,
+    /**
+     * Compaction phase that switches to and commits the new file.
+     */
+    FDB_LATENCY_COMPACT_SWITCH = 8,
+    FDB_LATENCY_NUM_STATS = 9
+};
+
+/**
+ * Latency statistics of an operation, in nanoseconds.
+ * Percentiles are taken from a log-linear histogram whose relative error
+ * is less than 1/16.
+ */
+typedef struct {
+    /**
+     * Number of samples.
+     */
+    uint64_t count;
+    /**
+     * Smallest, largest, and average latencies.
+     */
+    uint64_t min;
+    uint64_t max;
+    uint64_t avg;
+    /**
+     * 50th, 90th, 99th, and 99.9th percentile latencies.
+     */
+    uint64_t p50;
+    uint64_t p90;
+    uint64_t p99;
+    uint64_t p999;
+} fdb_latency_stat;
+
+/**
+ * I/O statistics of a ForestDB file. Byte counts by category cover the
+ * writes issued to the file, so that write amplification can be computed
+ * as write_bytes / user_bytes.
+ */
+typedef struct {
+    /**
+     * Number of read calls and bytes read from the file.
+     */
+    uint64_t num_reads;
+    uint64_t read_bytes;
+    /**
+     * Number of write calls and bytes written to the file.
+     */
+    uint64_t num_writes;
+    uint64_t write_bytes;
+    /**
+     * Number of fsync calls.
+     */
+    uint64_t num_syncs;
+    /**
+     * Sum of key, metadata, and body lengths passed to fdb_set and fdb_del.
+     */
+    uint64_t user_bytes;
+    /**
+     * Bytes of document blocks written to the file.
+     */
+    uint64_t doc_bytes;
+    /**
+     * Bytes of system documents (KV store header, Bloom filter, and range
+     * deletion list) appended to document blocks. This is a part of
+     * doc_bytes once the blocks are written.
+     */
+    uint64_t kv_header_bytes;
+    /**
+     * Bytes of B+tree node blocks written to the file.
+     */
+    uint64_t index_bytes;
+    /**
+     * Bytes of DB header blocks written to the file.
+     */
+    uint64_t header_bytes;
+    /**
+     * Bytes written to the file while it was being populated by compaction.
+     * They are not counted in the doc, index, and header categories above.
+     */
+    uint64_t compaction_bytes;
+} fdb_io_stats;
+
+/**
+ * Internal phases reported to the trace callbacks. Tracing is only
+ * available when ForestDB is built with the _FDB_TRACE option.
+ */
+typedef uint8_t fdb_trace_event;
+enum {
+    /**
+     * fdb_commit calls.
+     */
+    FDB_TRACE_COMMIT = 0,
+    /**
+     * Flushes of WAL entries into the main index.
+     */
+    FDB_TRACE_WAL_FLUSH = 1,
+    /**
+     * Writes of dirty B+tree nodes at the end of an index update.
+     */
+    FDB_TRACE_BTREEBLK_END = 2,
+    /**
+     * Write-backs of all dirty blocks of a file in the buffer cache.
+     */
+    FDB_TRACE_BCACHE_FLUSH = 3,
+    /**
+     * fsync calls on commit.
+     */
+    FDB_TRACE_FSYNC = 4,
+    /**
+     * Compaction phase that flushes WAL and commits the old file.
+     */
+    FDB_TRACE_COMPACT_FLUSH = 5,
+    /**
+     * Compaction phase that moves live documents into the new file.
+     */
+    FDB_TRACE_COMPACT_MOVE = 6,
+    /**
+     * Compaction phase that switches to and commits the new file.
+     */
+    FDB_TRACE_COMPACT_SWITCH = 7,
+    /**
+     * Block reads that miss the buffer cache and go to disk.
+     */
+    FDB_TRACE_READ_MISS = 8,
+    FDB_TRACE_NUM_EVENTS = 9
+};
+
+/**
+ * Trace callback invoked at the beginning or the end of an internal phase,
+ * on the thread that runs the phase.
+ */
+typedef void (*fdb_trace_callback)(fdb_trace_event event, void *ctx);
+
+/**
+ * Lock sites profiled for contention. Lock profiling is only available
+ * when ForestDB is built with the _FDB_LOCKPROF option.
+ */
+typedef uint8_t fdb_lock_site;
+enum {
+    /**
+     * Global buffer cache lock protecting the file hash table.
+     */
+    FDB_LOCK_BCACHE = 0,
+    /**
+     * Buffer cache lock protecting the list of cached files.
+     */
+    FDB_LOCK_BCACHE_FILELIST = 1,
+    /**
+     * Buffer cache lock protecting the list of free blocks.
+     */
+    FDB_LOCK_BCACHE_FREELIST = 2,
+    /**
+     * Per-file buffer cache lock protecting the file's cached blocks.
+     */
+    FDB_LOCK_BCACHE_FILE = 3,
+    /**
+     * Per-file mutex serializing writers (filemgr_mutex_lock).
+     */
+    FDB_LOCK_FILEMGR_MUTEX = 4,
+    /**
+     * Per-file WAL lock.
+     */
+    FDB_LOCK_WAL = 5,
+    /**
+     * Per-file partial lock on the block range being read or written.
+     */
+    FDB_LOCK_PLOCK = 6,
+    FDB_LOCK_NUM_SITES = 7
+};
+
+/**
+ * Contention statistics of a lock site, accumulated over all lock instances
+ * of the site (e.g., the WAL locks of all open files).
+ */
+typedef struct {
+    /**
+     * Number of lock acquisitions.
+     */
+    uint64_t acquisitions;
+    /**
+     * Number of acquisitions that had to wait for another holder.
+     */
+    uint64_t contended;
+    /**
+     * Total time spent waiting in contended acquisitions, in nanoseconds.
+     */
+    uint64_t wait_time;
+} fdb_lock_stat;
+
+/**
+ * Contention statistics of all lock sites, indexed by fdb_lock_site.
+ */
+typedef struct {
+    fdb_lock_stat sites[FDB_LOCK_NUM_SITES];
+} fdb_lock_stats;
+
 /**
  * Information about a ForestDB KV store
  */
@@ -456,6 +915,25 @@ typedef struct {
     char **kvs_names;
 } fdb_kvs_name_list;
 
+/**
+ * List of keys that split a key range into partitions,
+ * returned by fdb_iterator_split().
+ */
+typedef struct {
+    /**
+     * Number of split keys listed in keys.
+     */
+    size_t num_keys;
+    /**
+     * Pointer to array of split keys, sorted in ascending order.
+     */
+    void **keys;
+    /**
+     * Pointer to array of lengths of split keys.
+     */
+    size_t *keylens;
+} fdb_split_key_list;
+
 
 #ifdef __cplusplus
 }
@@ -288,6 +288,32 @@ LIBFDB_API
 fdb_status fdb_del(fdb_kvs_handle *handle,
                    fdb_doc *doc);
 
+/**
+ * Delete all keys in the given range [start_key, end_key] at once.
+ * The range deletion is recorded as a range tombstone instead of deleting
+ * each key separately, so that its cost does not depend on the number of keys
+ * in the range. Documents covered by the tombstone are hidden from all get
+ * and iterator APIs immediately, and physically removed by the next
+ * compaction. The tombstone is persisted by the next commit.
+ * Note that this API is not transactional, and the sequence tree should be
+ * enabled (i.e., seqtree_opt is FDB_SEQTREE_USE).
+ *
+ * @param handle Pointer to ForestDB KV store handle.
+ * @param start_key Pointer to the smallest key to be deleted. If NULL, the
+ *        range starts from the first key of the KV store.
+ * @param start_keylen Length of the start key.
+ * @param end_key Pointer to the largest key to be deleted. If NULL, the
+ *        range ends at the last key of the KV store.
+ * @param end_keylen Length of the end key.
+ * @return FDB_RESULT_SUCCESS on success.
+ */
+LIBFDB_API
+fdb_status fdb_del_range(fdb_kvs_handle *handle,
+                         const void *start_key,
+                         size_t start_keylen,
+                         const void *end_key,
+                         size_t end_keylen);
+
 /**
  * Simplified API for fdb_get:
  * Retrieve the value (doc body in fdb_get) for a given key.
@@ -460,6 +486,32 @@ LIBFDB_API
 fdb_status fdb_iterator_next_metaonly(fdb_iterator *iterator,
                                       fdb_doc **doc);
 
+/**
+ * Get the next items (key, metadata, doc body) from the iterator in a batch.
+ * As many documents as fit are packed into the given buffer without any
+ * memory allocation: the buffer starts with an array of 'count' fdb_doc
+ * instances, and their key, metadata, and body point to the rest of the same
+ * buffer. The returned documents should not be freed by fdb_doc_free(), and
+ * they are valid until the buffer is reused or released.
+ * If the next document does not fit into the remaining space, it will be
+ * returned by the next call. Only key iterators are supported.
+ *
+ * @param iterator Pointer to the iterator.
+ * @param buf Pointer to the buffer to be filled. It should be aligned for
+ *        fdb_doc instances (e.g., allocated by malloc()).
+ * @param bufsize Size of the buffer.
+ * @param count Pointer to the number of documents packed into the buffer.
+ * @return FDB_RESULT_SUCCESS if one or more documents are returned,
+ *         FDB_RESULT_ITERATOR_FAIL if there is no more document, or
+ *         FDB_RESULT_TOO_SMALL_BUFFER if the buffer cannot hold even the next
+ *         document alone.
+ */
+LIBFDB_API
+fdb_status fdb_iterator_next_batch(fdb_iterator *iterator,
+                                   void *buf,
+                                   size_t bufsize,
+                                   size_t *count);
+
 /**
  * Fast forward / backward an iterator to return documents starting from
  * the given seek_key. If the seek key does not exist, the iterator is
@@ -483,6 +535,78 @@ fdb_status fdb_iterator_seek(fdb_iterator *iterator, const void *seek_key,
 LIBFDB_API
 fdb_status fdb_iterator_close(fdb_iterator *iterator);
 
+/**
+ * Split a key range into approximately equal-sized partitions for parallel
+ * range scans. Split keys are sampled from the upper levels of the main index
+ * without scanning the range, so that the documents in WAL are not taken into
+ * account and the partitions are not exactly balanced.
+ * Given K split keys s_1 < ... < s_K, the i-th partition covers keys in
+ * [s_i, s_(i+1)), where s_0 is start_key and s_(K+1) is end_key (inclusive).
+ * Note that the end key of fdb_iterator_init() is inclusive, so that each
+ * partition except the last one should skip the document whose key is
+ * same to its end key.
+ *
+ * @param handle Pointer to ForestDB KV store handle.
+ * @param start_key Pointer to the start key of the range. Passing NULL
+ *        means that the range starts from the beginning of the KV store.
+ * @param start_keylen Length of the start key.
+ * @param end_key Pointer to the end key of the range. Passing NULL means
+ *        that the range ends at the end of the KV store.
+ * @param end_keylen Length of the end key.
+ * @param num_partitions Number of partitions requested.
+ * @param split_keys Pointer to a list of up to (num_partitions - 1) split
+ *        keys. Fewer keys are returned if the range is too small to split.
+ *        Note that this list should be released using
+ *        fdb_free_split_key_list API call().
+ * @return FDB_RESULT_SUCCESS on success.
+ */
+LIBFDB_API
+fdb_status fdb_iterator_split(fdb_kvs_handle *handle,
+                              const void *start_key,
+                              size_t start_keylen,
+                              const void *end_key,
+                              size_t end_keylen,
+                              size_t num_partitions,
+                              fdb_split_key_list *split_keys);
+
+/**
+ * Free a list of split keys.
+ *
+ * @param split_keys Pointer to a list of split keys to be freed.
+ * @return FDB_RESULT_SUCCESS on success.
+ */
+LIBFDB_API
+fdb_status fdb_free_split_key_list(fdb_split_key_list *split_keys);
+
+/**
+ * Estimate the number of documents and their total size in a key range
+ * without scanning the range. The estimate is derived from the fan-out of
+ * the main index nodes along the paths to the start and end keys, so that
+ * its cost is proportional to the height of the index. Documents in WAL
+ * that are not reflected in the main index yet are accounted for only in
+ * proportion to the estimated fraction of the range.
+ *
+ * @param handle Pointer to ForestDB KV store handle.
+ * @param start_key Pointer to the start key of the range (inclusive).
+ *        Passing NULL means that the range starts from the beginning of
+ *        the KV store.
+ * @param start_keylen Length of the start key.
+ * @param end_key Pointer to the end key of the range (exclusive). Passing
+ *        NULL means that the range ends at the end of the KV store.
+ * @param end_keylen Length of the end key.
+ * @param count Pointer to the estimated number of documents in the range.
+ * @param bytes Pointer to the estimated size of documents in the range.
+ * @return FDB_RESULT_SUCCESS on success.
+ */
+LIBFDB_API
+fdb_status fdb_estimate_range(fdb_kvs_handle *handle,
+                              const void *start_key,
+                              size_t start_keylen,
+                              const void *end_key,
+                              size_t end_keylen,
+                              uint64_t *count,
+                              uint64_t *bytes);
+
 /**
  * Compact the current file and create a new compacted file.
  * Note that a new file name passed to this API will be ignored if the compaction
@@ -545,6 +669,153 @@ size_t fdb_estimate_space_used(fdb_file_handle *fhandle);
 LIBFDB_API
 fdb_status fdb_get_file_info(fdb_file_handle *fhandle, fdb_file_info *info);
 
+/**
+ * Return the statistics of the Bloom filter of a ForestDB file.
+ * All the fields are zero if the file does not have a filter.
+ *
+ * @param fhandle Pointer to ForestDB file handle.
+ * @param stats Pointer to Bloom filter stats instance.
+ * @return FDB_RESULT_SUCCESS on success.
+ */
+LIBFDB_API
+fdb_status fdb_get_bloom_stats(fdb_file_handle *fhandle,
+                               fdb_bloom_stats *stats);
+
+/**
+ * Return the statistics of the buffer cache. Counters are accumulated since
+ * the cache was initialized, i.e., since the first file was opened after
+ * fdb_init or fdb_shutdown. All the fields are zero if the buffer cache is
+ * disabled.
+ *
+ * @param fhandle Pointer to ForestDB file handle. It can be NULL if
+ *        file_stats is NULL.
+ * @param file_stats Pointer to the stats instance for the given file, or
+ *        NULL if not needed.
+ * @param global_stats Pointer to the stats instance for the whole cache,
+ *        or NULL if not needed.
+ * @return FDB_RESULT_SUCCESS on success.
+ */
+LIBFDB_API
+fdb_status fdb_get_buffer_cache_stats(fdb_file_handle *fhandle,
+                                      fdb_buffer_cache_stats *file_stats,
+                                      fdb_buffer_cache_stats *global_stats);
+
+/**
+ * Return the latency statistics of the given operation type on a ForestDB
+ * file. Statistics are accumulated since the file was opened or the last
+ * fdb_reset_latency_stats call, and carried over to the new file by
+ * compaction.
+ *
+ * @param fhandle Pointer to ForestDB file handle.
+ * @param stat Pointer to latency stat instance.
+ * @param type Operation type (FDB_LATENCY_*).
+ * @return FDB_RESULT_SUCCESS on success.
+ */
+LIBFDB_API
+fdb_status fdb_get_latency_stats(fdb_file_handle *fhandle,
+                                 fdb_latency_stat *stat,
+                                 fdb_latency_stat_type type);
+
+/**
+ * Reset the latency statistics of a ForestDB file.
+ *
+ * @param fhandle Pointer to ForestDB file handle.
+ * @return FDB_RESULT_SUCCESS on success.
+ */
+LIBFDB_API
+fdb_status fdb_reset_latency_stats(fdb_file_handle *fhandle);
+
+/**
+ * Return the name of the given latency stat type.
+ *
+ * @param type Operation type (FDB_LATENCY_*).
+ * @return A constant string, or NULL if the type is invalid.
+ */
+LIBFDB_API
+const char* fdb_latency_stat_name(fdb_latency_stat_type type);
+
+/**
+ * Return the I/O statistics of a ForestDB file. Statistics are accumulated
+ * since the file was opened or the last fdb_reset_io_stats call, and
+ * carried over to the new file by compaction.
+ *
+ * @param fhandle Pointer to ForestDB file handle.
+ * @param stats Pointer to I/O stats instance.
+ * @return FDB_RESULT_SUCCESS on success.
+ */
+LIBFDB_API
+fdb_status fdb_get_io_stats(fdb_file_handle *fhandle,
+                            fdb_io_stats *stats);
+
+/**
+ * Reset the I/O statistics of a ForestDB file.
+ *
+ * @param fhandle Pointer to ForestDB file handle.
+ * @return FDB_RESULT_SUCCESS on success.
+ */
+LIBFDB_API
+fdb_status fdb_reset_io_stats(fdb_file_handle *fhandle);
+
+/**
+ * Register trace callbacks that are invoked at the beginning and the end of
+ * internal phases (FDB_TRACE_*), e.g., to emit trace events to an external
+ * tracer. Callbacks are shared by all files, and should be registered
+ * before any file is opened. Pass NULL to unregister them.
+ * Without the _FDB_TRACE build option, trace points are compiled out and
+ * this function fails.
+ *
+ * @param begin_cb Callback invoked at the beginning of a phase.
+ * @param end_cb Callback invoked at the end of a phase.
+ * @param ctx Pointer passed to the callbacks.
+ * @return FDB_RESULT_SUCCESS on success, or FDB_RESULT_INVALID_CONFIG if
+ *         tracing is not compiled in.
+ */
+LIBFDB_API
+fdb_status fdb_set_trace_callbacks(fdb_trace_callback begin_cb,
+                                   fdb_trace_callback end_cb,
+                                   void *ctx);
+
+/**
+ * Return the name of the given trace event.
+ *
+ * @param event Trace event (FDB_TRACE_*).
+ * @return A constant string, or NULL if the event is invalid.
+ */
+LIBFDB_API
+const char* fdb_trace_event_name(fdb_trace_event event);
+
+/**
+ * Get the contention statistics of the profiled lock sites (FDB_LOCK_*),
+ * accumulated since the process started or the last fdb_reset_lock_stats
+ * call. Statistics are shared by all files.
+ * Without the _FDB_LOCKPROF build option, locks are not profiled and this
+ * function fails.
+ *
+ * @param stats Pointer to the lock stats instance to be populated.
+ * @return FDB_RESULT_SUCCESS on success, or FDB_RESULT_INVALID_CONFIG if
+ *         lock profiling is not compiled in.
+ */
+LIBFDB_API
+fdb_status fdb_get_lock_stats(fdb_lock_stats *stats);
+
+/**
+ * Reset the contention statistics of all profiled lock sites.
+ *
+ * @return FDB_RESULT_SUCCESS on success, or FDB_RESULT_INVALID_CONFIG if
+ *         lock profiling is not compiled in.
+ */
+LIBFDB_API
+fdb_status fdb_reset_lock_stats();
+
+/**
+ * Return the name of the given lock site.
+ *
+ * @param site Lock site (FDB_LOCK_*).
+ * @return A constant string, or NULL if the site is invalid.
+ */
+LIBFDB_API
+const char* fdb_lock_site_name(fdb_lock_site site);
+
 /**
  * Return the information about a ForestDB KV store instance.
  *
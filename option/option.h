@@ -65,6 +65,8 @@
 #define FDB_COMPACTION_BATCHSIZE (128)
 #define FDB_COMPACTOR_SLEEP_DURATION (15)
 #define FDB_DEFAULT_COMPACTION_THRESHOLD (30)
+// # index samples per partition taken by fdb_iterator_split()
+#define FDB_SPLIT_SAMPLE_FACTOR (4)
 
 // MUST BE a power of 2
 //#define BCACHE_NBUCKET (1024*1024)
@@ -77,6 +79,8 @@
 #define __BCACHE_RANDOM_VICTIM
 
 #define FILEMGR_PREFETCH_UNIT (4194304) // 4MB
+#define FILEMGR_READAHEAD_BATCH (32) // max # blocks read by a single pread
+#define FILEMGR_PREFETCH_NREADERS (4) // # concurrent readers of index prefetch
 #define __FILEMGR_MUTEX_LOCK
 #define __FILEMGR_DATA_PARTIAL_LOCK
 //#define __FILEMGR_DATA_MUTEX_LOCK
@@ -77,6 +77,7 @@
         #define spin_t OSSpinLock
         #define spin_lock(arg) OSSpinLockLock(arg)
         #define spin_unlock(arg) OSSpinLockUnlock(arg)
+        #define spin_trylock(arg) OSSpinLockTry(arg)
         #define SPIN_INITIALIZER (spin_t)(0)
         #define spin_init(arg) *(arg) = (spin_t)(0)
         #define spin_destroy(arg)
@@ -88,6 +89,7 @@
         #define mutex_init(arg) pthread_mutex_init(arg, NULL)
         #define mutex_lock(arg) pthread_mutex_lock(arg)
         #define mutex_unlock(arg) pthread_mutex_unlock(arg)
+        #define mutex_trylock(arg) (pthread_mutex_trylock(arg) == 0)
         #define MUTEX_INITIALIZER PTHREAD_MUTEX_INITIALIZER
         #define mutex_destroy(arg) pthread_mutex_destroy(arg)
     #endif
@@ -136,6 +138,7 @@
         #define spin_init(arg) pthread_mutex_init(arg, NULL)
         #define spin_lock(arg) pthread_mutex_lock(arg)
         #define spin_unlock(arg) pthread_mutex_unlock(arg)
+        #define spin_trylock(arg) (pthread_mutex_trylock(arg) == 0)
         #define spin_destroy(arg) pthread_mutex_destroy(arg)
         #define SPIN_INITIALIZER ((spin_t)PTHREAD_MUTEX_INITIALIZER)
     #endif
@@ -146,6 +149,7 @@
         #define mutex_init(arg) pthread_mutex_init(arg, NULL)
         #define mutex_lock(arg) pthread_mutex_lock(arg)
         #define mutex_unlock(arg) pthread_mutex_unlock(arg)
+        #define mutex_trylock(arg) (pthread_mutex_trylock(arg) == 0)
         #define MUTEX_INITIALIZER PTHREAD_MUTEX_INITIALIZER
         #define mutex_destroy(arg) pthread_mutex_destroy(arg)
     #endif
@@ -200,6 +204,7 @@
         #define spin_init(arg) pthread_spin_init(arg, PTHREAD_PROCESS_SHARED)
         #define spin_lock(arg) pthread_spin_lock(arg)
         #define spin_unlock(arg) pthread_spin_unlock(arg)
+        #define spin_trylock(arg) (pthread_spin_trylock(arg) == 0)
         #define spin_destroy(arg) pthread_spin_destroy(arg)
         #define SPIN_INITIALIZER (spin_t)(1)
     #endif
@@ -210,6 +215,7 @@
         #define mutex_init(arg) pthread_mutex_init(arg, NULL)
         #define mutex_lock(arg) pthread_mutex_lock(arg)
         #define mutex_unlock(arg) pthread_mutex_unlock(arg)
+        #define mutex_trylock(arg) (pthread_mutex_trylock(arg) == 0)
         #define MUTEX_INITIALIZER PTHREAD_MUTEX_INITIALIZER
         #define mutex_destroy(arg) pthread_mutex_destroy(arg)
     #endif
@@ -278,6 +284,7 @@
         #define spin_init(arg) InitializeCriticalSection(arg)
         #define spin_lock(arg) EnterCriticalSection(arg)
         #define spin_unlock(arg) LeaveCriticalSection(arg)
+        #define spin_trylock(arg) TryEnterCriticalSection(arg)
         #define spin_destroy(arg) DeleteCriticalSection(arg)
     #endif
     #ifndef mutex_t
@@ -286,6 +293,7 @@
         #define mutex_init(arg) InitializeCriticalSection(arg)
         #define mutex_lock(arg) EnterCriticalSection(arg)
         #define mutex_unlock(arg) LeaveCriticalSection(arg)
+        #define mutex_trylock(arg) TryEnterCriticalSection(arg)
         #define mutex_destroy(arg) DeleteCriticalSection(arg)
     #endif
     #ifndef thread_t
@@ -335,6 +343,7 @@
         #define spin_init(arg) pthread_spin_init(arg, PTHREAD_PROCESS_SHARED)
         #define spin_lock(arg) pthread_spin_lock(arg)
         #define spin_unlock(arg) pthread_spin_unlock(arg)
+        #define spin_trylock(arg) (pthread_spin_trylock(arg) == 0)
         #define spin_destroy(arg) pthread_spin_destroy(arg)
         #define SPIN_INITIALIZER (spin_t)(1)
     #endif
@@ -345,6 +354,7 @@
         #define mutex_init(arg) pthread_mutex_init(arg, NULL)
         #define mutex_lock(arg) pthread_mutex_lock(arg)
         #define mutex_unlock(arg) pthread_mutex_unlock(arg)
+        #define mutex_trylock(arg) (pthread_mutex_trylock(arg) == 0)
         #define MUTEX_INITIALIZER PTHREAD_MUTEX_INITIALIZER
         #define mutex_destroy(arg) pthread_mutex_destroy(arg)
     #endif
@@ -375,4 +385,18 @@
     #define INLINE make_error
 #endif
 
+// atomic operations on 64-bit counters
+#if defined(WIN32) || defined(_WIN32)
+    #define atomic_add64(ptr, val) \
+        InterlockedExchangeAdd64((volatile LONG64 *)(ptr), (LONG64)(val))
+    #define atomic_cas64(ptr, oldval, newval) \
+        (InterlockedCompareExchange64((volatile LONG64 *)(ptr), \
+                                      (LONG64)(newval), (LONG64)(oldval)) == \
+         (LONG64)(oldval))
+#else
+    #define atomic_add64(ptr, val) __sync_fetch_and_add((ptr), (val))
+    #define atomic_cas64(ptr, oldval, newval) \
+        __sync_bool_compare_and_swap((ptr), (oldval), (newval))
+#endif
+
 #endif
@@ -24,7 +24,11 @@
 #include "hash.h"
 #include "list.h"
 #include "blockcache.h"
+#include "io_stats.h"
+#include "trace.h"
+#include "lockprof.h"
 #include "avltree.h"
+#include "time_utils.h"
 
 #include "memleak.h"
 
@@ -62,6 +66,21 @@ static uint64_t bcache_nblock;
 static int bcache_blocksize;
 static size_t bcache_flush_unit;
 
+// per-file counters (protected by the lock of each file)
+struct bcache_counters {
+    uint64_t nhits;
+    uint64_t nmisses;
+    uint64_t nclean_evictions;
+    uint64_t ndirty_evictions;
+    uint64_t nwritebacks;
+};
+
+// counters of files removed from the cache (protected by BCACHE_LOCK)
+static struct bcache_counters bcache_removed_counters;
+// victim selection (protected by BCACHE_LOCK)
+static uint64_t bcache_nvictim_selections;
+static uint64_t bcache_victim_selection_time;
+
 struct fnamedic_item {
     char *filename;
     uint16_t filename_len;
@@ -87,6 +106,7 @@ struct fnamedic_item {
     spin_t lock;
     uint64_t nvictim;
     uint64_t nitems;
+    struct bcache_counters counters;
 };
 
 #define BCACHE_DIRTY (0x1)
@@ -189,7 +209,7 @@ void _bcache_move_fname_list(struct fnamedic_item *fname, struct list *list)
 {
     file_status_t fs;
 
-    spin_lock(&filelist_lock);
+    LOCKPROF_SPIN_LOCK(FDB_LOCK_BCACHE_FILELIST, &filelist_lock);
 
     if (fname->curlist != list) {
         if (list == &file_lru) {
@@ -222,7 +242,7 @@ struct fnamedic_item *_bcache_get_victim()
 {
     struct list_elem *e = NULL, *prev;
 
-    spin_lock(&filelist_lock);
+    LOCKPROF_SPIN_LOCK(FDB_LOCK_BCACHE_FILELIST, &filelist_lock);
 
 #ifdef __BCACHE_RANDOM_VICTIM
     size_t i, r;
@@ -272,7 +292,7 @@ struct bcache_item *_bcache_alloc_freeblock()
     struct list_elem *e = NULL;
     struct bcache_item *item;
 
-    spin_lock(&freelist_lock);
+    LOCKPROF_SPIN_LOCK(FDB_LOCK_BCACHE_FREELIST, &freelist_lock);
     e = list_pop_front(&freelist);
     if (e) freelist_count--;
     spin_unlock(&freelist_lock);
@@ -286,7 +306,7 @@ struct bcache_item *_bcache_alloc_freeblock()
 
 void _bcache_release_freeblock(struct bcache_item *item)
 {
-    spin_lock(&freelist_lock);
+    LOCKPROF_SPIN_LOCK(FDB_LOCK_BCACHE_FREELIST, &freelist_lock);
     item->flag = BCACHE_FREE;
     item->score = 0;
     list_push_front(&freelist, &item->list_elem);
@@ -343,10 +363,7 @@ fdb_status _bcache_evict_dirty(struct fnamedic_item *fname_item, int sync)
 #ifdef __CRC32
             if (marker == BLK_MARKER_BNODE ) {
                 // b-tree node .. calculate crc32 and put it into the block
-                memset((uint8_t *)(ptr) + BTREE_CRC_OFFSET, 0xff, BTREE_CRC_FIELD_LEN);
-                uint32_t crc = chksum(ptr, bcache_blocksize);
-                crc = _endian_encode(crc);
-                memcpy((uint8_t *)(ptr) + BTREE_CRC_OFFSET, &crc, sizeof(crc));
+                filemgr_set_blk_crc(fname_item->curfile, ptr);
             }
 #endif
             memcpy((uint8_t *)(buf) + count*bcache_blocksize, ditem->item->addr,
@@ -380,6 +397,10 @@ fdb_status _bcache_evict_dirty(struct fnamedic_item *fname_item, int sync)
 
         if (ret != count * bcache_blocksize) {
             status = FDB_RESULT_WRITE_FAIL;
+        } else {
+            fname_item->counters.nwritebacks += count;
+            io_stats_add_write(fname_item->curfile, buf,
+                               count * bcache_blocksize);
         }
         free_align(buf);
     }
@@ -390,17 +411,20 @@ fdb_status _bcache_evict_dirty(struct fnamedic_item *fname_item, int sync)
 struct list_elem * _bcache_evict(struct fnamedic_item *curfile)
 {
     size_t n_evict;
+    bool written_back;
     struct list_elem *e = NULL;
     struct bcache_item *item;
     struct fnamedic_item *victim = NULL;
+    uint64_t begin;
 
-    spin_lock(&bcache_lock);
+    LOCKPROF_SPIN_LOCK(FDB_LOCK_BCACHE, &bcache_lock);
+    begin = get_monotonic_ts();
 
     while(victim == NULL) {
         // select victim file (the tail of FILE_LRU)
         victim = _bcache_get_victim();
         while(victim) {
-            spin_lock(&victim->lock);
+            LOCKPROF_SPIN_LOCK(FDB_LOCK_BCACHE_FILE, &victim->lock);
 
             // check whether this file has at least one block to be evictied
             if (!_list_empty(victim->cleanlist) || !_tree_empty(victim->tree)) {
@@ -417,6 +441,8 @@ struct list_elem * _bcache_evict(struct fnamedic_item *curfile)
         }
     }
     assert(victim);
+    bcache_nvictim_selections++;
+    bcache_victim_selection_time += get_monotonic_ts() - begin;
     spin_unlock(&bcache_lock);
 
     victim->nvictim++;
@@ -424,6 +450,7 @@ struct list_elem * _bcache_evict(struct fnamedic_item *curfile)
     // select victim clean block of the victim file
     n_evict = 0;
     while(n_evict < BCACHE_EVICT_UNIT) {
+        written_back = false;
 
 #ifdef __BCACHE_SECOND_CHANCE
         while(1) {
@@ -435,6 +462,7 @@ struct list_elem * _bcache_evict(struct fnamedic_item *curfile)
                     spin_unlock(&victim->lock);
                     return NULL;
                 }
+                written_back = true;
 
                 // pop back from cleanlist
                 e = list_pop_back(&victim->cleanlist);
@@ -457,6 +485,7 @@ struct list_elem * _bcache_evict(struct fnamedic_item *curfile)
                 spin_unlock(&victim->lock);
                 return NULL;
             }
+            written_back = true;
 
             // pop back from cleanlist
             e = list_pop_back(&victim->cleanlist);
@@ -465,6 +494,12 @@ struct list_elem * _bcache_evict(struct fnamedic_item *curfile)
 #endif
 
         victim->nitems--;
+        if (written_back) {
+            // the block was dirty and had to be written back
+            victim->counters.ndirty_evictions++;
+        } else {
+            victim->counters.nclean_evictions++;
+        }
 
         spin_lock(&item->lock);
 
@@ -513,6 +548,7 @@ struct fnamedic_item * _fname_create(struct filemgr *file) {
     fname_new->curfile = file;
     fname_new->nvictim = 0;
     fname_new->nitems = 0;
+    memset(&fname_new->counters, 0, sizeof(struct bcache_counters));
 
     // initialize tree
     avl_init(&fname_new->tree, NULL);
@@ -569,8 +605,12 @@ int bcache_read(struct filemgr *file, bid_t bid, void *buf)
     struct bcache_item query;
     struct fnamedic_item *fname;
 
-    spin_lock(&bcache_lock);
+    LOCKPROF_SPIN_LOCK(FDB_LOCK_BCACHE, &bcache_lock);
     fname = file->bcache;
+    if (fname == NULL) {
+        // create the entry here to count misses of the file
+        fname = _fname_create(file);
+    }
     spin_unlock(&bcache_lock);
 
     if (fname) {
@@ -581,7 +621,7 @@ int bcache_read(struct filemgr *file, bid_t bid, void *buf)
         query.fname->curfile = file;
 
         // relay lock
-        spin_lock(&fname->lock);
+        LOCKPROF_SPIN_LOCK(FDB_LOCK_BCACHE_FILE, &fname->lock);
 
         // move the file to the head of FILE_LRU
         _bcache_move_fname_list(fname, &file_lru);
@@ -590,6 +630,7 @@ int bcache_read(struct filemgr *file, bid_t bid, void *buf)
         h = hash_find(&fname->hashtable, &query.hash_elem);
         if (h) {
             // cache hit
+            fname->counters.nhits++;
             item = _get_entry(h, struct bcache_item, hash_elem);
             assert(item->fname == fname);
             spin_lock(&item->lock);
@@ -613,6 +654,7 @@ int bcache_read(struct filemgr *file, bid_t bid, void *buf)
             return bcache_blocksize;
         }else {
             // cache miss
+            fname->counters.nmisses++;
             spin_unlock(&fname->lock);
         }
     }
@@ -621,6 +663,30 @@ int bcache_read(struct filemgr *file, bid_t bid, void *buf)
     return 0;
 }
 
+// check if the given block is in the cache, without copying the block,
+// updating its LRU position, or counting a hit or miss
+bool bcache_exists(struct filemgr *file, bid_t bid)
+{
+    struct hash_elem *h = NULL;
+    struct bcache_item query;
+    struct fnamedic_item *fname;
+
+    LOCKPROF_SPIN_LOCK(FDB_LOCK_BCACHE, &bcache_lock);
+    fname = file->bcache;
+    spin_unlock(&bcache_lock);
+
+    if (fname) {
+        query.bid = bid;
+        query.fname = fname;
+
+        LOCKPROF_SPIN_LOCK(FDB_LOCK_BCACHE_FILE, &fname->lock);
+        h = hash_find(&fname->hashtable, &query.hash_elem);
+        spin_unlock(&fname->lock);
+    }
+
+    return (h != NULL);
+}
+
 void bcache_invalidate_block(struct filemgr *file, bid_t bid)
 {
     struct hash_elem *h;
@@ -637,7 +703,7 @@ void bcache_invalidate_block(struct filemgr *file, bid_t bid)
         query.fname->curfile = file;
 
         // relay lock
-        spin_lock(&fname->lock);
+        LOCKPROF_SPIN_LOCK(FDB_LOCK_BCACHE_FILE, &fname->lock);
 
         // move the file to the head of FILE_LRU
         _bcache_move_fname_list(fname, &file_lru);
@@ -689,7 +755,7 @@ int bcache_write(struct filemgr *file, bid_t bid, void *buf, bcache_dirty_t dirt
     struct bcache_item query;
     struct fnamedic_item *fname_new;
 
-    spin_lock(&bcache_lock);
+    LOCKPROF_SPIN_LOCK(FDB_LOCK_BCACHE, &bcache_lock);
     fname_new = file->bcache;
     if (fname_new == NULL) {
         // filename doesn't exist in filename dictionary .. create
@@ -698,7 +764,7 @@ int bcache_write(struct filemgr *file, bid_t bid, void *buf, bcache_dirty_t dirt
     spin_unlock(&bcache_lock);
 
     // acquire lock
-    spin_lock(&fname_new->lock);
+    LOCKPROF_SPIN_LOCK(FDB_LOCK_BCACHE_FILE, &fname_new->lock);
 
     // move to the head of FILE_LRU
     _bcache_move_fname_list(fname_new, &file_lru);
@@ -719,7 +785,7 @@ int bcache_write(struct filemgr *file, bid_t bid, void *buf, bcache_dirty_t dirt
 
             _bcache_evict(fname_new);
 
-            spin_lock(&fname_new->lock);
+            LOCKPROF_SPIN_LOCK(FDB_LOCK_BCACHE_FILE, &fname_new->lock);
         }
 
         // re-search hash table
@@ -795,7 +861,7 @@ int bcache_write_partial(struct filemgr *file, bid_t bid, void *buf, size_t offs
     struct bcache_item query;
     struct fnamedic_item *fname_new;
 
-    spin_lock(&bcache_lock);
+    LOCKPROF_SPIN_LOCK(FDB_LOCK_BCACHE, &bcache_lock);
     fname_new = file->bcache;
     if (fname_new == NULL) {
         // filename doesn't exist in filename dictionary .. create
@@ -804,7 +870,7 @@ int bcache_write_partial(struct filemgr *file, bid_t bid, void *buf, size_t offs
     spin_unlock(&bcache_lock);
 
     // relay lock
-    spin_lock(&fname_new->lock);
+    LOCKPROF_SPIN_LOCK(FDB_LOCK_BCACHE_FILE, &fname_new->lock);
 
     // set query
     query.bid = bid;
@@ -868,7 +934,7 @@ void bcache_remove_dirty_blocks(struct filemgr *file)
 
     if (fname_item) {
         // acquire lock
-        spin_lock(&fname_item->lock);
+        LOCKPROF_SPIN_LOCK(FDB_LOCK_BCACHE_FILE, &fname_item->lock);
 
         // remove all dirty block
         while(!_tree_empty(fname_item->tree)) {
@@ -896,7 +962,7 @@ void bcache_remove_clean_blocks(struct filemgr *file)
 
     if (fname_item) {
         // acquire lock
-        spin_lock(&fname_item->lock);
+        LOCKPROF_SPIN_LOCK(FDB_LOCK_BCACHE_FILE, &fname_item->lock);
 
         // remove all clean blocks
         e = list_begin(&fname_item->cleanlist);
@@ -923,6 +989,16 @@ void bcache_remove_clean_blocks(struct filemgr *file)
     }
 }
 
+INLINE void _bcache_add_counters(struct bcache_counters *dst,
+                                 struct bcache_counters *src)
+{
+    dst->nhits += src->nhits;
+    dst->nmisses += src->nmisses;
+    dst->nclean_evictions += src->nclean_evictions;
+    dst->ndirty_evictions += src->ndirty_evictions;
+    dst->nwritebacks += src->nwritebacks;
+}
+
 // remove file from filename dictionary
 // MUST sure that there is no dirty block belongs to this FILE (or memory leak occurs)
 void bcache_remove_file(struct filemgr *file)
@@ -933,13 +1009,15 @@ void bcache_remove_file(struct filemgr *file)
 
     if (fname_item) {
         // acquire lock
-        spin_lock(&bcache_lock);
-        spin_lock(&fname_item->lock);
+        LOCKPROF_SPIN_LOCK(FDB_LOCK_BCACHE, &bcache_lock);
+        LOCKPROF_SPIN_LOCK(FDB_LOCK_BCACHE_FILE, &fname_item->lock);
         assert(_tree_empty(fname_item->tree));
         assert(_list_empty(fname_item->cleanlist));
 
         // remove from fname dictionary hash table
         hash_remove(&fnamedic, &fname_item->hash_elem);
+        // keep the counters for the global statistics
+        _bcache_add_counters(&bcache_removed_counters, &fname_item->counters);
         spin_unlock(&bcache_lock);
 
         _fname_free(fname_item);
@@ -960,8 +1038,9 @@ fdb_status bcache_flush(struct filemgr *file)
     fname_item = file->bcache;
 
     if (fname_item) {
+        TRACE_BEGIN(FDB_TRACE_BCACHE_FLUSH);
         // acquire lock
-        spin_lock(&fname_item->lock);
+        LOCKPROF_SPIN_LOCK(FDB_LOCK_BCACHE_FILE, &fname_item->lock);
 
         while(!_tree_empty(fname_item->tree)) {
 
@@ -972,6 +1051,7 @@ fdb_status bcache_flush(struct filemgr *file)
         }
 
         spin_unlock(&fname_item->lock);
+        TRACE_END(FDB_TRACE_BCACHE_FLUSH);
     }
     return status;
 }
@@ -991,6 +1071,9 @@ void bcache_init(int nblock, int blocksize)
     bcache_blocksize = blocksize;
     bcache_flush_unit = BCACHE_FLUSH_UNIT;
     bcache_nblock = nblock;
+    memset(&bcache_removed_counters, 0, sizeof(struct bcache_counters));
+    bcache_nvictim_selections = 0;
+    bcache_victim_selection_time = 0;
     spin_init(&bcache_lock);
     spin_init(&freelist_lock);
     spin_init(&filelist_lock);
@@ -1023,6 +1106,170 @@ uint64_t bcache_get_num_free_blocks()
     return freelist_count;
 }
 
+// add the counters and the cached blocks of the file into STATS
+//2 FNAME_LOCK must be acquired by caller
+static void _bcache_scan_file(struct fnamedic_item *fname,
+                              fdb_buffer_cache_stats *stats)
+{
+    struct list_elem *e;
+    struct avl_node *a;
+    struct bcache_item *item;
+    uint8_t marker;
+
+    stats->num_hits += fname->counters.nhits;
+    stats->num_misses += fname->counters.nmisses;
+    stats->num_clean_evictions += fname->counters.nclean_evictions;
+    stats->num_dirty_evictions += fname->counters.ndirty_evictions;
+    stats->num_dirty_writebacks += fname->counters.nwritebacks;
+
+    e = list_begin(&fname->cleanlist);
+    a = avl_first(&fname->tree);
+    while (e || a) {
+        if (e) {
+            item = _get_entry(e, struct bcache_item, list_elem);
+            e = list_next(e);
+        } else {
+            item = _get_entry(a, struct dirty_item, avl)->item;
+            a = avl_next(a);
+            stats->num_dirty_blocks++;
+        }
+        stats->num_cached_blocks++;
+#ifdef __CRC32
+        marker = *((uint8_t*)item->addr + bcache_blocksize - 1);
+        if (marker == BLK_MARKER_BNODE) {
+            stats->num_index_blocks++;
+        } else if (marker == BLK_MARKER_DOC) {
+            stats->num_doc_blocks++;
+        }
+#else
+        (void)marker;
+#endif
+    }
+}
+
+void bcache_get_file_stats(struct filemgr *file, fdb_buffer_cache_stats *stats)
+{
+    struct fnamedic_item *fname;
+
+    memset(stats, 0, sizeof(fdb_buffer_cache_stats));
+    if (bcache_nblock == 0) {
+        return;
+    }
+
+    LOCKPROF_SPIN_LOCK(FDB_LOCK_BCACHE, &bcache_lock);
+    fname = file->bcache;
+    if (fname) {
+        LOCKPROF_SPIN_LOCK(FDB_LOCK_BCACHE_FILE, &fname->lock);
+        _bcache_scan_file(fname, stats);
+        spin_unlock(&fname->lock);
+    }
+    spin_unlock(&bcache_lock);
+}
+
+// return the BIDs of the clean blocks of the file in the cache, ordered by
+// their eviction priority: blocks with a higher score (i.e., B+tree nodes)
+// first, and then more recently used ones first within the same score.
+// the returned array should be freed by the caller.
+bid_t *bcache_get_resident_bids(struct filemgr *file, size_t *nbids)
+{
+    struct fnamedic_item *fname;
+    struct list_elem *e;
+    struct bcache_item *item;
+    bid_t *bids = NULL;
+    size_t n = 0;
+    int score;
+
+    *nbids = 0;
+    if (bcache_nblock == 0) {
+        return NULL;
+    }
+
+    LOCKPROF_SPIN_LOCK(FDB_LOCK_BCACHE, &bcache_lock);
+    fname = file->bcache;
+    if (fname) {
+        LOCKPROF_SPIN_LOCK(FDB_LOCK_BCACHE_FILE, &fname->lock);
+        for (e = list_begin(&fname->cleanlist); e; e = list_next(e)) {
+            n++;
+        }
+        if (n > 0) {
+            bids = (bid_t *)malloc(sizeof(bid_t) * n);
+            n = 0;
+            // the clean list is ordered from the most recently used block
+            for (score = 1; score >= 0; --score) {
+                for (e = list_begin(&fname->cleanlist); e; e = list_next(e)) {
+                    item = _get_entry(e, struct bcache_item, list_elem);
+                    if ((score && item->score) || (!score && !item->score)) {
+                        bids[n++] = item->bid;
+                    }
+                }
+            }
+        }
+        spin_unlock(&fname->lock);
+    }
+    spin_unlock(&bcache_lock);
+
+    if (n == 0) {
+        free(bids);
+        return NULL;
+    }
+    *nbids = n;
+    return bids;
+}
+
+void bcache_get_global_stats(fdb_buffer_cache_stats *stats)
+{
+    size_t i, n = 0, nfnames = 0;
+    struct list *lists[] = {&file_lru, &file_empty};
+    struct list_elem *e;
+    struct fnamedic_item **fnames = NULL;
+
+    memset(stats, 0, sizeof(fdb_buffer_cache_stats));
+    if (bcache_nblock == 0) {
+        return;
+    }
+
+    // BCACHE_LOCK prevents files from being removed from the cache
+    LOCKPROF_SPIN_LOCK(FDB_LOCK_BCACHE, &bcache_lock);
+
+    // FILELIST_LOCK cannot be held while grabbing FNAME_LOCK,
+    // so gather files first
+    LOCKPROF_SPIN_LOCK(FDB_LOCK_BCACHE_FILELIST, &filelist_lock);
+    for (i=0; i<2; ++i) {
+        for (e = list_begin(lists[i]); e; e = list_next(e)) {
+            nfnames++;
+        }
+    }
+    fnames = (struct fnamedic_item **)
+             malloc(sizeof(struct fnamedic_item *) * (nfnames + 1));
+    for (i=0; i<2; ++i) {
+        for (e = list_begin(lists[i]); e; e = list_next(e)) {
+            fnames[n++] = _get_entry(e, struct fnamedic_item, le);
+        }
+    }
+    spin_unlock(&filelist_lock);
+
+    for (i=0; i<n; ++i) {
+        LOCKPROF_SPIN_LOCK(FDB_LOCK_BCACHE_FILE, &fnames[i]->lock);
+        _bcache_scan_file(fnames[i], stats);
+        spin_unlock(&fnames[i]->lock);
+    }
+    free(fnames);
+
+    stats->num_hits += bcache_removed_counters.nhits;
+    stats->num_misses += bcache_removed_counters.nmisses;
+    stats->num_clean_evictions += bcache_removed_counters.nclean_evictions;
+    stats->num_dirty_evictions += bcache_removed_counters.ndirty_evictions;
+    stats->num_dirty_writebacks += bcache_removed_counters.nwritebacks;
+    stats->num_victim_selections = bcache_nvictim_selections;
+    stats->victim_selection_time = bcache_victim_selection_time;
+    spin_unlock(&bcache_lock);
+
+    stats->num_total_blocks = bcache_nblock;
+    LOCKPROF_SPIN_LOCK(FDB_LOCK_BCACHE_FREELIST, &freelist_lock);
+    stats->num_free_blocks = freelist_count;
+    spin_unlock(&freelist_lock);
+}
+
 void bcache_print_items()
 {
     int n=1;
@@ -1168,12 +1415,14 @@ void bcache_shutdown()
         free(item);
     }
 
-    spin_lock(&bcache_lock);
+    LOCKPROF_SPIN_LOCK(FDB_LOCK_BCACHE, &bcache_lock);
     hash_free_active(&fnamedic, _bcache_free_fnamedic);
     spin_unlock(&bcache_lock);
 
     spin_destroy(&bcache_lock);
     spin_destroy(&freelist_lock);
     spin_destroy(&filelist_lock);
+    freelist_count = 0;
+    bcache_nblock = 0;
 }
 
@@ -31,6 +31,7 @@ typedef enum {
 
 void bcache_init(int nblock, int blocksize);
 int bcache_read(struct filemgr *file, bid_t bid, void *buf);
+bool bcache_exists(struct filemgr *file, bid_t bid);
 void bcache_invalidate_block(struct filemgr *file, bid_t bid);
 int bcache_write(struct filemgr *file, bid_t bid, void *buf, bcache_dirty_t dirty);
 int bcache_write_partial(struct filemgr *file, bid_t bid, void *buf, size_t offset, size_t len);
@@ -40,6 +41,9 @@ void bcache_remove_file(struct filemgr *file);
 fdb_status bcache_flush(struct filemgr *file);
 void bcache_shutdown();
 uint64_t bcache_get_num_free_blocks();
+void bcache_get_file_stats(struct filemgr *file, fdb_buffer_cache_stats *stats);
+void bcache_get_global_stats(fdb_buffer_cache_stats *stats);
+bid_t *bcache_get_resident_bids(struct filemgr *file, size_t *nbids);
 void bcache_print_items();
 void bcache_update_file_status(struct filemgr *file, file_status_t status);
 
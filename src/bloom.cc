@@ -0,0 +1,451 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2010 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "common.h"
+#include "bloom.h"
+
+#include "memleak.h"
+
+#ifdef __DEBUG
+#ifndef __DEBUG_BLOOM
+    #undef DBG
+    #undef DBGCMD
+    #undef DBGSW
+    #define DBG(...)
+    #define DBGCMD(...)
+    #define DBGSW(n, ...)
+#endif
+#endif
+
+INLINE uint64_t _bloom_mix(uint64_t x)
+{
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+// words are decoded in the same way as the other persisted fields,
+// so that the filter is valid on hosts of different byte order
+static uint64_t _bloom_hash(void *key, size_t keylen)
+{
+    size_t i;
+    uint8_t *p = (uint8_t *)key;
+    uint64_t h = 0x9e3779b97f4a7c15ULL ^ keylen;
+    uint64_t w;
+
+    for (i=0; i+sizeof(w) <= keylen; i+=sizeof(w)) {
+        memcpy(&w, p + i, sizeof(w));
+        h = _bloom_mix(h ^ _endian_decode(w));
+    }
+    if (i < keylen) {
+        w = 0;
+        memcpy(&w, p + i, keylen - i);
+        h = _bloom_mix(h ^ _endian_decode(w));
+    }
+    return h;
+}
+
+// stage 'n' uses 2*n more bits per key than the first stage,
+// so that the false positive rate of the whole filter stays bounded
+// (roughly 1.6 times the rate of the first stage) as stages are added.
+static void _bloom_stage_init(struct bloom_stage *stage,
+                              size_t bits_per_key,
+                              uint64_t capacity)
+{
+    stage->capacity = capacity;
+    stage->nbits = capacity * bits_per_key;
+    stage->nbits = (stage->nbits + 63) & ~((uint64_t)63);
+    stage->nkeys = 0;
+    // k = (m/n) * ln2
+    stage->nhashes = (uint32_t)(bits_per_key * 0.69 + 0.5);
+    if (stage->nhashes < 1) {
+        stage->nhashes = 1;
+    }
+    stage->bits = (uint8_t *)calloc(1, stage->nbits / 8);
+}
+
+static void _bloom_add_stage(struct bloom_filter *bf, uint64_t capacity)
+{
+    bf->stages = (struct bloom_stage *)
+                 realloc(bf->stages,
+                         sizeof(struct bloom_stage) * (bf->nstages + 1));
+    _bloom_stage_init(&bf->stages[bf->nstages],
+                      bf->bits_per_key + 2 * bf->nstages, capacity);
+    bf->nstages++;
+}
+
+// double hashing: the i-th probe is at (h1 + i*h2) % nbits
+INLINE int _bloom_stage_test(struct bloom_stage *stage,
+                             uint64_t h1, uint64_t h2)
+{
+    uint32_t i;
+    uint64_t pos;
+
+    for (i=0; i<stage->nhashes; ++i) {
+        pos = (h1 + i * h2) % stage->nbits;
+        if (!(stage->bits[pos >> 3] & (1 << (pos & 0x7)))) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void _bloom_stage_set(struct bloom_stage *stage,
+                             uint64_t h1, uint64_t h2)
+{
+    uint32_t i;
+    uint64_t pos;
+
+    for (i=0; i<stage->nhashes; ++i) {
+        pos = (h1 + i * h2) % stage->nbits;
+        stage->bits[pos >> 3] |= (1 << (pos & 0x7));
+    }
+    stage->nkeys++;
+}
+
+// free all stages (filter lock should be grabbed by the caller)
+static void _bloom_clear(struct bloom_filter *bf)
+{
+    uint32_t i;
+
+    for (i=0; i<bf->nstages; ++i) {
+        free(bf->stages[i].bits);
+    }
+    free(bf->stages);
+    bf->stages = NULL;
+    bf->nstages = 0;
+}
+
+void bloom_create(struct filemgr *file, size_t bits_per_key,
+                  uint64_t capacity)
+{
+    struct bloom_filter *bf;
+
+    if (file->bloom) {
+        return; // already exist
+    }
+
+    bf = (struct bloom_filter *)calloc(1, sizeof(struct bloom_filter));
+    bf->bits_per_key = bits_per_key;
+    bf->offset = BLK_NOT_FOUND;
+    // an empty filter also needs to be persisted,
+    // otherwise it is not loaded when the file is re-opened
+    bf->dirty = 1;
+    spin_init(&bf->lock);
+    _bloom_add_stage(bf, MAX(capacity, BLOOM_MIN_CAPACITY));
+
+    file->bloom = bf;
+    file->free_bloom = bloom_free;
+}
+
+void bloom_free(struct filemgr *file)
+{
+    struct bloom_filter *bf = file->bloom;
+
+    if (bf == NULL) {
+        return;
+    }
+
+    spin_lock(&bf->lock);
+    _bloom_clear(bf);
+    spin_unlock(&bf->lock);
+    spin_destroy(&bf->lock);
+
+    free(bf);
+    file->bloom = NULL;
+}
+
+void bloom_add(struct filemgr *file, void *key, size_t keylen)
+{
+    uint32_t i;
+    uint64_t h1, h2;
+    struct bloom_stage *stage;
+    struct bloom_filter *bf = file->bloom;
+
+    if (bf == NULL) {
+        return;
+    }
+
+    h1 = _bloom_hash(key, keylen);
+    h2 = _bloom_mix(h1) | 0x1;
+
+    spin_lock(&bf->lock);
+    // skip keys that are (probably) already added, so that updates of
+    // existing keys neither consume capacity nor make the filter dirty.
+    // the filter still answers 'maybe' for the key in case of a false
+    // positive, since bits are never cleared.
+    for (i=0; i<bf->nstages; ++i) {
+        if (_bloom_stage_test(&bf->stages[i], h1, h2)) {
+            spin_unlock(&bf->lock);
+            return;
+        }
+    }
+
+    stage = &bf->stages[bf->nstages - 1];
+    if (stage->nkeys >= stage->capacity) {
+        _bloom_add_stage(bf, stage->capacity * 2);
+        stage = &bf->stages[bf->nstages - 1];
+    }
+    _bloom_stage_set(stage, h1, h2);
+    bf->dirty = 1;
+    spin_unlock(&bf->lock);
+}
+
+// returns 0 if the key definitely does not exist in the file.
+// returns 1 if the key may exist, or there is no filter for the file.
+int bloom_may_contain(struct filemgr *file, void *key, size_t keylen)
+{
+    int ret = 0;
+    uint32_t i;
+    uint64_t h1, h2;
+    struct bloom_filter *bf = file->bloom;
+
+    if (bf == NULL) {
+        return 1;
+    }
+
+    h1 = _bloom_hash(key, keylen);
+    h2 = _bloom_mix(h1) | 0x1;
+
+    spin_lock(&bf->lock);
+    bf->nchecks++;
+    for (i=0; i<bf->nstages; ++i) {
+        if (_bloom_stage_test(&bf->stages[i], h1, h2)) {
+            ret = 1;
+            break;
+        }
+    }
+    if (!ret) {
+        bf->nnegatives++;
+    }
+    spin_unlock(&bf->lock);
+
+    return ret;
+}
+
+// called when the filter answered 'maybe' but the key was not in the index
+void bloom_report_false_positive(struct filemgr *file)
+{
+    struct bloom_filter *bf = file->bloom;
+
+    if (bf == NULL) {
+        return;
+    }
+
+    spin_lock(&bf->lock);
+    bf->nfalse_positives++;
+    spin_unlock(&bf->lock);
+}
+
+void bloom_get_stats(struct filemgr *file, fdb_bloom_stats *stats)
+{
+    uint32_t i;
+    double fpr, not_fp = 1.0;
+    struct bloom_stage *stage;
+    struct bloom_filter *bf = file->bloom;
+
+    memset(stats, 0, sizeof(fdb_bloom_stats));
+    if (bf == NULL) {
+        return;
+    }
+
+    spin_lock(&bf->lock);
+    stats->num_stages = bf->nstages;
+    stats->memory_used = sizeof(struct bloom_filter) +
+                         sizeof(struct bloom_stage) * bf->nstages;
+    for (i=0; i<bf->nstages; ++i) {
+        stage = &bf->stages[i];
+        stats->num_bits += stage->nbits;
+        stats->num_keys += stage->nkeys;
+        stats->memory_used += stage->nbits / 8;
+        // (1 - e^(-kn/m))^k
+        fpr = pow(1.0 - exp(-(double)stage->nhashes * stage->nkeys /
+                            stage->nbits),
+                  stage->nhashes);
+        not_fp *= 1.0 - fpr;
+    }
+    stats->estimated_fp_rate = 1.0 - not_fp;
+    stats->num_checks = bf->nchecks;
+    stats->num_negatives = bf->nnegatives;
+    stats->num_false_positives = bf->nfalse_positives;
+    if (bf->nnegatives + bf->nfalse_positives) {
+        stats->observed_fp_rate = (double)bf->nfalse_positives /
+                                  (bf->nnegatives + bf->nfalse_positives);
+    }
+    spin_unlock(&bf->lock);
+}
+
+uint64_t bloom_get_offset(struct filemgr *file)
+{
+    uint64_t ret;
+    struct bloom_filter *bf = file->bloom;
+
+    if (bf == NULL) {
+        return BLK_NOT_FOUND;
+    }
+
+    spin_lock(&bf->lock);
+    ret = bf->offset;
+    spin_unlock(&bf->lock);
+
+    return ret;
+}
+
+/*
+ * Persisted format:
+ * [# stages: 4 bytes][bits per key: 4 bytes]
+ * for each stage:
+ *   [# bits: 8 bytes][capacity: 8 bytes][# keys: 8 bytes]
+ *   [# hashes: 4 bytes][bit array: (# bits / 8) bytes]
+ */
+uint64_t bloom_append(struct filemgr *file,
+                      struct docio_handle *dhandle)
+{
+    char doc_key[32];
+    uint8_t *data;
+    uint32_t i, _nstages, _bits_per_key, _nhashes;
+    uint64_t _nbits, _capacity, _nkeys;
+    size_t size = 0, offset = 0;
+    struct bloom_stage *stage;
+    struct bloom_filter *bf = file->bloom;
+    struct docio_object doc;
+
+    if (bf == NULL) {
+        return BLK_NOT_FOUND;
+    }
+
+    spin_lock(&bf->lock);
+    if (!bf->dirty) {
+        spin_unlock(&bf->lock);
+        return bf->offset;
+    }
+
+    size += sizeof(_nstages) + sizeof(_bits_per_key);
+    for (i=0; i<bf->nstages; ++i) {
+        size += sizeof(_nbits) + sizeof(_capacity) + sizeof(_nkeys) +
+                sizeof(_nhashes) + bf->stages[i].nbits / 8;
+    }
+    data = (uint8_t *)malloc(size);
+
+    _nstages = _endian_encode(bf->nstages);
+    seq_memcpy(data + offset, &_nstages, sizeof(_nstages), offset);
+    _bits_per_key = _endian_encode(bf->bits_per_key);
+    seq_memcpy(data + offset, &_bits_per_key, sizeof(_bits_per_key), offset);
+
+    for (i=0; i<bf->nstages; ++i) {
+        stage = &bf->stages[i];
+        _nbits = _endian_encode(stage->nbits);
+        seq_memcpy(data + offset, &_nbits, sizeof(_nbits), offset);
+        _capacity = _endian_encode(stage->capacity);
+        seq_memcpy(data + offset, &_capacity, sizeof(_capacity), offset);
+        _nkeys = _endian_encode(stage->nkeys);
+        seq_memcpy(data + offset, &_nkeys, sizeof(_nkeys), offset);
+        _nhashes = _endian_encode(stage->nhashes);
+        seq_memcpy(data + offset, &_nhashes, sizeof(_nhashes), offset);
+        seq_memcpy(data + offset, stage->bits, stage->nbits / 8, offset);
+    }
+    bf->dirty = 0;
+    spin_unlock(&bf->lock);
+
+    memset(&doc, 0, sizeof(struct docio_object));
+    sprintf(doc_key, "bloom");
+    doc.key = (void *)doc_key;
+    doc.meta = NULL;
+    doc.body = data;
+    doc.length.keylen = strlen(doc_key) + 1;
+    doc.length.metalen = 0;
+    doc.length.bodylen = size;
+    doc.seqnum = 0;
+    bf->offset = docio_append_doc_system(dhandle, &doc);
+    free(data);
+
+    return bf->offset;
+}
+
+void bloom_read(struct filemgr *file,
+                struct docio_handle *dhandle,
+                uint64_t offset)
+{
+    size_t pos = 0;
+    uint8_t *data;
+    uint32_t i, nstages, bits_per_key, nhashes;
+    uint64_t nbits, capacity, nkeys;
+    uint64_t _offset;
+    struct bloom_stage *stage;
+    struct bloom_filter *bf;
+    struct docio_object doc;
+
+    if (offset == BLK_NOT_FOUND) {
+        // the file does not have a filter
+        return;
+    }
+
+    memset(&doc, 0, sizeof(struct docio_object));
+    _offset = docio_read_doc(dhandle, offset, &doc);
+    if (_offset == offset) {
+        return;
+    }
+    data = (uint8_t *)doc.body;
+
+    memcpy(&nstages, data + pos, sizeof(nstages));
+    pos += sizeof(nstages);
+    nstages = _endian_decode(nstages);
+    memcpy(&bits_per_key, data + pos, sizeof(bits_per_key));
+    pos += sizeof(bits_per_key);
+    bits_per_key = _endian_decode(bits_per_key);
+
+    bf = (struct bloom_filter *)calloc(1, sizeof(struct bloom_filter));
+    bf->bits_per_key = bits_per_key;
+    bf->stages = (struct bloom_stage *)
+                 calloc(nstages, sizeof(struct bloom_stage));
+    bf->nstages = nstages;
+    spin_init(&bf->lock);
+
+    for (i=0; i<nstages; ++i) {
+        stage = &bf->stages[i];
+        memcpy(&nbits, data + pos, sizeof(nbits));
+        pos += sizeof(nbits);
+        stage->nbits = _endian_decode(nbits);
+        memcpy(&capacity, data + pos, sizeof(capacity));
+        pos += sizeof(capacity);
+        stage->capacity = _endian_decode(capacity);
+        memcpy(&nkeys, data + pos, sizeof(nkeys));
+        pos += sizeof(nkeys);
+        stage->nkeys = _endian_decode(nkeys);
+        memcpy(&nhashes, data + pos, sizeof(nhashes));
+        pos += sizeof(nhashes);
+        stage->nhashes = _endian_decode(nhashes);
+        stage->bits = (uint8_t *)malloc(stage->nbits / 8);
+        memcpy(stage->bits, data + pos, stage->nbits / 8);
+        pos += stage->nbits / 8;
+    }
+    bf->offset = offset;
+    bf->dirty = 0;
+
+    file->bloom = bf;
+    file->free_bloom = bloom_free;
+
+    free_docio_object(&doc, 1, 1, 1);
+}
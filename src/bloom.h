@@ -0,0 +1,85 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2010 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#ifndef _FDB_BLOOM_H
+#define _FDB_BLOOM_H
+
+#include <stdint.h>
+#include "internal_types.h"
+#include "filemgr.h"
+#include "docio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// minimum number of keys that a filter is sized for
+#define BLOOM_MIN_CAPACITY (4096)
+
+/**
+ * A fixed-size Bloom filter sized for 'capacity' keys.
+ */
+struct bloom_stage {
+    uint8_t *bits;
+    uint64_t nbits;
+    uint64_t capacity;
+    uint64_t nkeys;
+    uint32_t nhashes;
+};
+
+/**
+ * Per-file Bloom filter over the keys indexed by the HB+trie.
+ * Keys include the KV ID prefix under the multi KV instance mode.
+ * Keys are never removed, so the filter may report deleted keys as present
+ * until it is rebuilt by compaction. When the last stage is full, a new
+ * stage with twice larger capacity is added instead of rebuilding the filter.
+ */
+struct bloom_filter {
+    struct bloom_stage *stages;
+    uint32_t nstages;
+    uint32_t bits_per_key;
+    // offset of the system document that lastly persisted the filter
+    uint64_t offset;
+    uint8_t dirty;
+    // lookup statistics (not persisted)
+    uint64_t nchecks;
+    uint64_t nnegatives;
+    uint64_t nfalse_positives;
+    spin_t lock;
+};
+
+void bloom_create(struct filemgr *file, size_t bits_per_key,
+                  uint64_t capacity);
+void bloom_free(struct filemgr *file);
+
+void bloom_add(struct filemgr *file, void *key, size_t keylen);
+int bloom_may_contain(struct filemgr *file, void *key, size_t keylen);
+void bloom_report_false_positive(struct filemgr *file);
+void bloom_get_stats(struct filemgr *file, fdb_bloom_stats *stats);
+
+uint64_t bloom_get_offset(struct filemgr *file);
+uint64_t bloom_append(struct filemgr *file,
+                      struct docio_handle *dhandle);
+void bloom_read(struct filemgr *file,
+                struct docio_handle *dhandle,
+                uint64_t offset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
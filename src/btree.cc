@@ -422,6 +422,11 @@ idx_t _btree_find_entry(struct btree *btree, struct bnode *node, void *key)
         idx_t *_map2[3] = {&temp, &end, &temp};
     #endif
 
+    if (btree->kv_ops->find_entry) {
+        // specialized search for fixed-size keys
+        return btree->kv_ops->find_entry(node, key);
+    }
+
     if (btree->kv_ops->init_kv_var) btree->kv_ops->init_kv_var(btree, k, NULL);
 
     start = middle = 0;
@@ -657,6 +662,274 @@ btree_result btree_get_key_range(
     return BTREE_RESULT_SUCCESS;
 }
 
+// find the entries of NODE that may contain keys within [MIN_KEY, MAX_KEY]
+// (NULL means no bound); they are the contiguous entries starting from FIRST
+static idx_t _btree_sample_range(struct btree *btree, struct bnode *node,
+                                 uint16_t level, void *min_key, void *max_key,
+                                 void *k, void *v, idx_t *first)
+{
+    idx_t i, n_lt_min = 0, n_le_min = 0, n_le_max = 0;
+
+    if (!min_key && !max_key) {
+        *first = 0;
+        return node->nentry;
+    }
+    for (i=0;i<node->nentry;++i){
+        btree->kv_ops->get_kv(node, i, k, v);
+        if (min_key) {
+            int cmp = btree->kv_ops->cmp(k, min_key, btree->aux);
+            n_lt_min += (cmp < 0)?(1):(0);
+            n_le_min += (cmp <= 0)?(1):(0);
+        }
+        if (!max_key || btree->kv_ops->cmp(k, max_key, btree->aux) <= 0) {
+            n_le_max++;
+        }
+    }
+    if (level == 1) {
+        // leaf entries are exact keys
+        *first = n_lt_min;
+    } else {
+        // an index entry covers the keys from its key to the next entry's key
+        *first = (n_le_min)?(n_le_min-1):(0);
+    }
+    return (n_le_max > *first)?(n_le_max - *first):(0);
+}
+
+// pick up to N values evenly spaced over the leaf entries within
+// [MIN_KEY, MAX_KEY] (NULL means no bound), by expanding the upper levels only
+// until they have at least N entries in the range in total
+btree_result btree_get_sample_values(
+    struct btree *btree, void *min_key, void *max_key,
+    size_t n, void *value_arr, size_t *nvalues)
+{
+    void *addr;
+    uint8_t *k = alca(uint8_t, btree->ksize);
+    uint8_t *v = alca(uint8_t, btree->vsize);
+    size_t i, j, nnode, total, pos, idx;
+    bid_t bid;
+    bid_t *bids, *new_bids;
+    idx_t *nentry, *first;
+    uint16_t level, lv;
+    struct bnode *node;
+
+    *nvalues = 0;
+    if (n == 0 || btree->root_bid == BTREE_BLK_NOT_FOUND) {
+        return BTREE_RESULT_FAIL;
+    }
+
+    if (btree->kv_ops->init_kv_var) btree->kv_ops->init_kv_var(btree, k, v);
+
+    bids = (bid_t *)malloc(sizeof(bid_t));
+    bids[0] = btree->root_bid;
+    nnode = 1;
+    level = btree->height;
+
+    while (1) {
+        nentry = (idx_t *)malloc(sizeof(idx_t) * nnode);
+        first = (idx_t *)malloc(sizeof(idx_t) * nnode);
+        total = 0;
+        for (i=0;i<nnode;++i){
+            addr = btree->blk_ops->blk_read(btree->blk_handle, bids[i]);
+            node = _fetch_bnode(btree, addr, level);
+            nentry[i] = _btree_sample_range(btree, node, level,
+                                            min_key, max_key, k, v, &first[i]);
+            total += nentry[i];
+        }
+        if (level == 1 || total >= n || total == 0) {
+            break;
+        }
+
+        // expand the next level
+        new_bids = (bid_t *)malloc(sizeof(bid_t) * total);
+        pos = 0;
+        for (i=0;i<nnode;++i){
+            addr = btree->blk_ops->blk_read(btree->blk_handle, bids[i]);
+            node = _fetch_bnode(btree, addr, level);
+            for (j=first[i];j<first[i]+nentry[i];++j){
+                btree->kv_ops->get_kv(node, j, k, v);
+                bid = btree->kv_ops->value2bid(v);
+                new_bids[pos++] = _endian_decode(bid);
+            }
+        }
+        free(bids);
+        free(nentry);
+        free(first);
+        bids = new_bids;
+        nnode = total;
+        level--;
+    }
+
+    if (total < n) {
+        n = total;
+    }
+    for (i=0, pos=0, idx=0; i<n; ++i){
+        // find the node that has the (i*total/n)-th entry of the level
+        size_t target = i * total / n;
+        while (idx + nentry[pos] <= target) {
+            idx += nentry[pos++];
+        }
+        addr = btree->blk_ops->blk_read(btree->blk_handle, bids[pos]);
+        node = _fetch_bnode(btree, addr, level);
+        btree->kv_ops->get_kv(node, first[pos] + target - idx, k, v);
+
+        // go down to the leftmost leaf of the entry
+        for (lv = level; lv > 1; --lv) {
+            bid = btree->kv_ops->value2bid(v);
+            bid = _endian_decode(bid);
+            addr = btree->blk_ops->blk_read(btree->blk_handle, bid);
+            node = _fetch_bnode(btree, addr, lv-1);
+            btree->kv_ops->get_kv(node, 0, k, v);
+        }
+        btree->kv_ops->set_value(btree, (uint8_t*)value_arr + i * btree->vsize, v);
+    }
+    *nvalues = n;
+
+    free(bids);
+    free(nentry);
+    free(first);
+    if (btree->kv_ops->free_kv_var) btree->kv_ops->free_kv_var(btree, k, v);
+    return BTREE_RESULT_SUCCESS;
+}
+
+// visit the nodes of BTREE level by level, from the root down to the leaves.
+// LEVEL_FUNC is called with the BIDs of each level (in key order) before the
+// nodes of the level are read, and the walk stops if it returns zero.
+// VALUE_FUNC (optional) is called for each entry in the leaf nodes.
+btree_result btree_walk_levels(struct btree *btree,
+                               btree_walk_level_func *level_func,
+                               btree_walk_value_func *value_func,
+                               void *aux)
+{
+    void *addr;
+    uint8_t *k = alca(uint8_t, btree->ksize);
+    uint8_t *v = alca(uint8_t, btree->vsize);
+    size_t i, j, nnode, total, pos;
+    bid_t bid;
+    bid_t *bids, *new_bids;
+    uint16_t level;
+    struct bnode *node;
+    btree_result ret = BTREE_RESULT_SUCCESS;
+
+    if (btree->root_bid == BTREE_BLK_NOT_FOUND) {
+        return BTREE_RESULT_FAIL;
+    }
+
+    if (btree->kv_ops->init_kv_var) btree->kv_ops->init_kv_var(btree, k, v);
+
+    bids = (bid_t *)malloc(sizeof(bid_t));
+    bids[0] = btree->root_bid;
+    nnode = 1;
+    level = btree->height;
+
+    while (1) {
+        if (!level_func(btree, level, bids, nnode, aux)) {
+            ret = BTREE_RESULT_FAIL;
+            break;
+        }
+        if (level == 1) {
+            if (value_func) {
+                for (i=0;i<nnode;++i){
+                    addr = btree->blk_ops->blk_read(btree->blk_handle, bids[i]);
+                    node = _fetch_bnode(btree, addr, level);
+                    for (j=0;j<node->nentry;++j){
+                        btree->kv_ops->get_kv(node, j, k, v);
+                        value_func(btree, k, v, aux);
+                    }
+                }
+            }
+            break;
+        }
+
+        // expand the next level (each node is read only once)
+        total = nnode * 2;
+        new_bids = (bid_t *)malloc(sizeof(bid_t) * total);
+        pos = 0;
+        for (i=0;i<nnode;++i){
+            addr = btree->blk_ops->blk_read(btree->blk_handle, bids[i]);
+            node = _fetch_bnode(btree, addr, level);
+            if (pos + node->nentry > total) {
+                total = MAX(total * 2, pos + node->nentry);
+                new_bids = (bid_t *)realloc(new_bids, sizeof(bid_t) * total);
+            }
+            for (j=0;j<node->nentry;++j){
+                btree->kv_ops->get_kv(node, j, k, v);
+                bid = btree->kv_ops->value2bid(v);
+                new_bids[pos++] = _endian_decode(bid);
+            }
+        }
+        free(bids);
+        bids = new_bids;
+        nnode = pos;
+        level--;
+    }
+
+    free(bids);
+    if (btree->kv_ops->free_kv_var) btree->kv_ops->free_kv_var(btree, k, v);
+    return ret;
+}
+
+// estimate the relative position of KEY in the entire key space of BTREE,
+// assuming that entries are evenly distributed over child nodes.
+// POS and WIDTH are set to the (fractional) offset and size of the leaf
+// entry that is the largest one smaller than or equal to KEY, and EXACT is
+// set if the entry is same to KEY.
+btree_result btree_get_key_position(
+    struct btree *btree, void *key, void *value_buf,
+    double *pos, double *width, uint8_t *exact)
+{
+    void *addr;
+    uint8_t *k = alca(uint8_t, btree->ksize);
+    uint8_t *v = alca(uint8_t, btree->vsize);
+    idx_t idx;
+    bid_t bid;
+    struct bnode *node;
+    int i;
+
+    *pos = 0;
+    *width = 1;
+    *exact = 0;
+    if (btree->root_bid == BTREE_BLK_NOT_FOUND) {
+        *width = 0;
+        return BTREE_RESULT_FAIL;
+    }
+
+    if (btree->kv_ops->init_kv_var) btree->kv_ops->init_kv_var(btree, k, v);
+
+    bid = btree->root_bid;
+    for (i=btree->height; i>=1; --i) {
+        addr = btree->blk_ops->blk_read(btree->blk_handle, bid);
+        node = _fetch_bnode(btree, addr, i);
+
+        idx = _btree_find_entry(btree, node, key);
+        if (idx == BTREE_IDX_NOT_FOUND) {
+            // KEY is smaller than all entries in this node
+            *width = 0;
+            if (btree->blk_ops->blk_operation_end)
+                btree->blk_ops->blk_operation_end(btree->blk_handle);
+            if (btree->kv_ops->free_kv_var) btree->kv_ops->free_kv_var(btree, k, v);
+            return BTREE_RESULT_FAIL;
+        }
+
+        *width /= node->nentry;
+        *pos += *width * idx;
+        btree->kv_ops->get_kv(node, idx, k, v);
+
+        if (i > 1) {
+            bid = btree->kv_ops->value2bid(v);
+            bid = _endian_decode(bid);
+        } else {
+            *exact = (btree->kv_ops->cmp(key, k, btree->aux) == 0);
+            btree->kv_ops->set_value(btree, value_buf, v);
+        }
+    }
+
+    if (btree->blk_ops->blk_operation_end) {
+        btree->blk_ops->blk_operation_end(btree->blk_handle);
+    }
+    if (btree->kv_ops->free_kv_var) btree->kv_ops->free_kv_var(btree, k, v);
+    return BTREE_RESULT_SUCCESS;
+}
+
 btree_result btree_find(struct btree *btree, void *key, void *value_buf)
 {
     void *addr;
@@ -738,7 +1011,8 @@ int _btree_split_node(
     new_node[0] = node[i];
     for (j=1;j<nnode;++j){
         addr = btree->blk_ops->blk_alloc(btree->blk_handle, &new_bid[j]);
-        new_node[j] = _btree_init_node(btree, new_bid[j], addr, 0x0,
+        new_node[j] = _btree_init_node(btree, new_bid[j], addr,
+                                       node[i]->flag & BNODE_MASK_LAYOUT,
                                        node[i]->level, NULL);
     }
 
@@ -47,7 +47,9 @@ struct bnode{
     idx_t nentry;
     // BTREE_CRC_OFFSET in option.h must be modified if this offset is changed.
     union {
-        // array of key value pair ([k1][v1][k2][v2]...)
+        // array of key value pair ([k1][v1][k2][v2]...), or
+        // key array followed by value array ([k1][k2]...[v1][v2]...)
+        // if BNODE_MASK_SEPARATED is set (see kv ops for other layouts)
         void *data;
         // The size of this union should be 8 bytes
         // even though sizeof(void*) is 4 bytes
@@ -59,6 +61,14 @@ struct bnode{
 #define BNODE_MASK_ROOT 0x1
 #define BNODE_MASK_METADATA 0x2
 #define BNODE_MASK_SEQTREE 0x4
+// keys and values are stored in separate arrays (given to btree_init();
+// only supported by the kv ops in btree_kv.h)
+#define BNODE_MASK_SEPARATED 0x8
+// keys are stored without their common prefix (given to btree_init();
+// only supported by the kv ops in btree_fast_str_kv.h)
+#define BNODE_MASK_PREFIX 0x10
+// node format flags inherited by all nodes in a tree
+#define BNODE_MASK_LAYOUT (BNODE_MASK_SEPARATED | BNODE_MASK_PREFIX)
 
 typedef uint16_t metasize_t;
 struct btree_meta{
@@ -124,6 +134,11 @@ struct btree_kv_ops {
     int (*cmp)(void *key1, void *key2, void* aux);
     bid_t (*value2bid)(void *value);
     voidref (*bid2value)(bid_t *bid);
+
+    // (optional) return index# of the largest key equal or smaller than KEY
+    // in NODE, without calling 'get_kv' and 'cmp' for each entry.
+    // The key order MUST be same to that of 'cmp'.
+    idx_t (*find_entry)(struct bnode *node, void *key);
 };
 
 struct btree_iterator {
@@ -180,6 +195,20 @@ btree_result btree_prev(struct btree_iterator *it, void *key_buf, void *value_bu
 
 btree_result btree_get_key_range(
     struct btree *btree, idx_t num, idx_t den, void *key_begin, void *key_end);
+btree_result btree_get_sample_values(
+    struct btree *btree, void *min_key, void *max_key,
+    size_t n, void *value_arr, size_t *nvalues);
+typedef int btree_walk_level_func(struct btree *btree, uint16_t level,
+                                  bid_t *bids, size_t nbids, void *aux);
+typedef void btree_walk_value_func(struct btree *btree, void *key,
+                                   void *value, void *aux);
+btree_result btree_walk_levels(struct btree *btree,
+                               btree_walk_level_func *level_func,
+                               btree_walk_value_func *value_func,
+                               void *aux);
+btree_result btree_get_key_position(
+    struct btree *btree, void *key, void *value_buf,
+    double *pos, double *width, uint8_t *exact);
 
 btree_result btree_find(struct btree *btree, void *key, void *value_buf);
 btree_result btree_insert(struct btree *btree, void *key, void *value);
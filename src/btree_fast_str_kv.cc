@@ -41,14 +41,201 @@ typedef uint16_t key_len_t;
 [key n][value n]
 
 Note that the maximum node size is limited to 2^(8*sizeof(key_len_t)) bytes
+
+=== node->data structure with prefix compression (BNODE_MASK_PREFIX) ===
+
+[length of common prefix]: sizeof(key_len_t) bytes
+[common prefix of all keys in the node]: padded to sizeof(key_len_t) bytes
+[offset of key 1]: sizeof(key_len_t) bytes
+...
+[offset of key n+1]: ...
+[key 1 suffix][value 1]
+...
+[key n suffix][value n]
+
+Each key is stored without the common prefix, and the offset array is
+used in the same way as above, so that any entry can be directly accessed
+for binary search. Unlike the format above, the node is rewritten on every
+update, since adding a key may shorten the common prefix of all entries.
 */
 
+struct fast_str_kv {
+    // a key consists of PREFIX and SUFFIX
+    uint8_t *prefix;
+    uint8_t *suffix;
+    key_len_t prefixlen;
+    key_len_t suffixlen;
+    void *value;
+};
+
+#define _prefix_area_size(prefixlen) \
+    (sizeof(key_len_t) + (((prefixlen) + 1) & ~((size_t)1)))
+
+// return the offset array of node data PTR, and the common prefix of keys
+INLINE key_len_t * _get_fast_str_layout(uint8_t *ptr, bnode_flag_t flag,
+                                        uint8_t **prefix, key_len_t *prefixlen)
+{
+    key_len_t _prefixlen;
+
+    if (flag & BNODE_MASK_PREFIX) {
+        memcpy(&_prefixlen, ptr, sizeof(key_len_t));
+        *prefixlen = _endian_decode(_prefixlen);
+        *prefix = ptr + sizeof(key_len_t);
+        return (key_len_t *)(ptr + _prefix_area_size(*prefixlen));
+    }
+    *prefixlen = 0;
+    *prefix = ptr;
+    return (key_len_t *)ptr;
+}
+
+INLINE uint8_t _fast_str_kv_byte(struct fast_str_kv *kv, size_t pos)
+{
+    return (pos < kv->prefixlen)?(kv->prefix[pos]):
+                                 (kv->suffix[pos - kv->prefixlen]);
+}
+
+// read entries [BEGIN, BEGIN+N) from node data PTR
+static void _read_fast_str_entries(uint8_t *ptr, bnode_flag_t flag, int vsize,
+                                   idx_t begin, idx_t n,
+                                   struct fast_str_kv *kv_arr)
+{
+    idx_t i;
+    uint8_t *prefix;
+    key_len_t prefixlen, offset, offset_next;
+    key_len_t *_offset_arr;
+
+    _offset_arr = _get_fast_str_layout(ptr, flag, &prefix, &prefixlen);
+    for (i=0; i<n; ++i) {
+        offset = _endian_decode(_offset_arr[begin+i]);
+        offset_next = _endian_decode(_offset_arr[begin+i+1]);
+        kv_arr[i].prefix = prefix;
+        kv_arr[i].prefixlen = prefixlen;
+        kv_arr[i].suffix = ptr + offset;
+        kv_arr[i].suffixlen = offset_next - offset - vsize;
+        kv_arr[i].value = ptr + offset_next - vsize;
+    }
+}
+
+// rewrite the prefix-compressed node using N entries in KV_ARR
+static void _write_prefix_entries(struct bnode *node, int vsize,
+                                  struct fast_str_kv *kv_arr, idx_t n)
+{
+    idx_t i;
+    size_t j, keylen;
+    uint8_t *ptr = (uint8_t *)node->data;
+    key_len_t prefixlen, offset;
+    key_len_t *_offset_arr;
+
+    // find the longest common prefix of all keys
+    prefixlen = (n)?(kv_arr[0].prefixlen + kv_arr[0].suffixlen):(0);
+    for (i=1; i<n && prefixlen; ++i) {
+        keylen = kv_arr[i].prefixlen + kv_arr[i].suffixlen;
+        for (j=0; j<prefixlen && j<keylen; ++j) {
+            if (_fast_str_kv_byte(&kv_arr[0], j) !=
+                _fast_str_kv_byte(&kv_arr[i], j)) {
+                break;
+            }
+        }
+        prefixlen = j;
+    }
+
+    offset = _endian_encode(prefixlen);
+    memcpy(ptr, &offset, sizeof(key_len_t));
+    for (j=0; j<prefixlen; ++j) {
+        ptr[sizeof(key_len_t) + j] = _fast_str_kv_byte(&kv_arr[0], j);
+    }
+
+    _offset_arr = (key_len_t *)(ptr + _prefix_area_size(prefixlen));
+    offset = _prefix_area_size(prefixlen) + sizeof(key_len_t) * (n+1);
+    for (i=0; i<n; ++i) {
+        _offset_arr[i] = _endian_encode(offset);
+        // copy the key except for the common prefix
+        keylen = kv_arr[i].prefixlen + kv_arr[i].suffixlen;
+        j = prefixlen;
+        if (j < kv_arr[i].prefixlen) {
+            memcpy(ptr + offset, kv_arr[i].prefix + j, kv_arr[i].prefixlen - j);
+            offset += kv_arr[i].prefixlen - j;
+            j = kv_arr[i].prefixlen;
+        }
+        memcpy(ptr + offset, kv_arr[i].suffix + (j - kv_arr[i].prefixlen),
+               keylen - j);
+        offset += keylen - j;
+        memcpy(ptr + offset, kv_arr[i].value, vsize);
+        offset += vsize;
+    }
+    _offset_arr[n] = _endian_encode(offset);
+}
+
+INLINE void _set_fast_str_kv_var(struct fast_str_kv *kv, void *key, void *value)
+{
+    void *key_ptr;
+    key_len_t _keylen;
+
+    memcpy(&key_ptr, key, sizeof(void *));
+    memcpy(&_keylen, key_ptr, sizeof(key_len_t));
+    kv->prefix = (uint8_t *)key_ptr + sizeof(key_len_t);
+    kv->prefixlen = _endian_decode(_keylen);
+    kv->suffix = NULL;
+    kv->suffixlen = 0;
+    kv->value = value;
+}
+
+#define PREFIX_NODE_SET (0)
+#define PREFIX_NODE_INSERT (1)
+#define PREFIX_NODE_REMOVE (2)
+
+// overwrite, insert, or remove IDX-th entry of the prefix-compressed node
+static void _update_prefix_node(struct bnode *node, idx_t idx,
+                                void *key, void *value, int mode)
+{
+    int ksize, vsize;
+    idx_t n = node->nentry;
+    size_t size = 0;
+    uint8_t *buf = NULL, *prefix;
+    key_len_t prefixlen;
+    key_len_t *_offset_arr;
+    struct fast_str_kv *kv_arr;
+
+    _get_kvsize(node->kvsize, ksize, vsize);
+    (void)ksize;
+
+    // entries point to the copy of the node, since the node is overwritten
+    kv_arr = (struct fast_str_kv *)malloc(sizeof(struct fast_str_kv) * (n+1));
+    if (n > 0) {
+        _offset_arr = _get_fast_str_layout((uint8_t *)node->data, node->flag,
+                                           &prefix, &prefixlen);
+        size = _endian_decode(_offset_arr[n]);
+        buf = (uint8_t *)malloc(size);
+        memcpy(buf, node->data, size);
+        _read_fast_str_entries(buf, node->flag, vsize, 0, n, kv_arr);
+    }
+
+    if (mode == PREFIX_NODE_SET && idx < n) {
+        _set_fast_str_kv_var(&kv_arr[idx], key, value);
+    } else if (mode == PREFIX_NODE_REMOVE) {
+        memmove(kv_arr + idx, kv_arr + idx + 1,
+                sizeof(struct fast_str_kv) * (n - (idx+1)));
+        n--;
+    } else {
+        // insert (or append)
+        memmove(kv_arr + idx + 1, kv_arr + idx,
+                sizeof(struct fast_str_kv) * (n - idx));
+        _set_fast_str_kv_var(&kv_arr[idx], key, value);
+        n++;
+    }
+    _write_prefix_entries(node, vsize, kv_arr, n);
+
+    free(buf);
+    free(kv_arr);
+}
+
 static void _get_fast_str_kv(struct bnode *node, idx_t idx, void *key, void *value)
 {
     int ksize, vsize;
     void *key_ptr, *ptr;
+    uint8_t *prefix;
     key_len_t *_offset_arr;
-    key_len_t keylen, _keylen;
+    key_len_t keylen, _keylen, prefixlen;
     key_len_t offset;
 
     _get_kvsize(node->kvsize, ksize, vsize);
@@ -58,7 +245,8 @@ static void _get_fast_str_kv(struct bnode *node, idx_t idx, void *key, void *val
     offset = 0;
 
     // get offset array
-    _offset_arr = (key_len_t*)ptr;
+    _offset_arr = _get_fast_str_layout((uint8_t *)ptr, node->flag,
+                                       &prefix, &prefixlen);
 
     // get keylen & offset
     offset = _endian_decode(_offset_arr[idx]);
@@ -71,12 +259,13 @@ static void _get_fast_str_kv(struct bnode *node, idx_t idx, void *key, void *val
     }
 
     // allocate space for key
-    key_ptr = (void*)malloc(sizeof(key_len_t) + keylen);
+    key_ptr = (void*)malloc(sizeof(key_len_t) + prefixlen + keylen);
 
     // copy key
-    _keylen = _endian_encode(keylen);
+    _keylen = _endian_encode((key_len_t)(prefixlen + keylen));
     memcpy(key_ptr, &_keylen, sizeof(key_len_t));
-    memcpy((uint8_t*)key_ptr + sizeof(key_len_t),
+    memcpy((uint8_t*)key_ptr + sizeof(key_len_t), prefix, prefixlen);
+    memcpy((uint8_t*)key_ptr + sizeof(key_len_t) + prefixlen,
            (uint8_t*)ptr + offset, keylen);
     // copy key pointer
     memcpy(key, &key_ptr, ksize);
@@ -95,6 +284,13 @@ static void _set_fast_str_kv(struct bnode *node, idx_t idx, void *key, void *val
     key_len_t _keylen_ins;
     key_len_t offset_idx, offset_next, next_len;
 
+    if (node->flag & BNODE_MASK_PREFIX) {
+        _update_prefix_node(node, idx, key, value,
+                            (idx < node->nentry)?(PREFIX_NODE_SET):
+                                                 (PREFIX_NODE_INSERT));
+        return;
+    }
+
     _get_kvsize(node->kvsize, ksize, vsize);
     ksize = sizeof(void *);
 
@@ -176,6 +372,13 @@ static void _ins_fast_str_kv(struct bnode *node, idx_t idx, void *key, void *val
     key_len_t _keylen_ins;
     key_len_t offset, offset_begin, offset_idx, offset_next, next_len;
 
+    if (node->flag & BNODE_MASK_PREFIX) {
+        _update_prefix_node(node, idx, key, value,
+                            (key && value)?(PREFIX_NODE_INSERT):
+                                           (PREFIX_NODE_REMOVE));
+        return;
+    }
+
     _get_kvsize(node->kvsize, ksize, vsize);
     ksize = sizeof(void *);
 
@@ -279,6 +482,30 @@ static void _copy_fast_str_kv(struct bnode *node_dst,
     _get_kvsize(node_src->kvsize, ksize, vsize);
     ksize = sizeof(void *);
 
+    if ((node_dst->flag | node_src->flag) & BNODE_MASK_PREFIX) {
+        struct fast_str_kv *kv_arr;
+        uint8_t *prefix;
+        key_len_t prefixlen;
+
+        // copy the source node since it may be same to the destination
+        _src_offset_arr = _get_fast_str_layout((uint8_t *)node_src->data,
+                                               node_src->flag,
+                                               &prefix, &prefixlen);
+        src_len = _endian_decode(_src_offset_arr[node_src->nentry]);
+        ptr_src = (void *)malloc(src_len);
+        memcpy(ptr_src, node_src->data, src_len);
+
+        kv_arr = (struct fast_str_kv *)
+                 malloc(sizeof(struct fast_str_kv) * (len+1));
+        _read_fast_str_entries((uint8_t *)ptr_src, node_src->flag, vsize,
+                               src_idx, len, kv_arr);
+        _write_prefix_entries(node_dst, vsize, kv_arr, len);
+
+        free(kv_arr);
+        free(ptr_src);
+        return;
+    }
+
     ptr_src = node_src->data;
     ptr_dst = node_dst->data;
 
@@ -334,6 +561,80 @@ static size_t _get_fast_str_kv_size(struct btree *tree, void *key, void *value)
     return ((key)?(sizeof(key_len_t) + keylen):0) + ((value)?tree->vsize:0);
 }
 
+// return the length of the common prefix between KEY_PTR and PREFIX
+INLINE key_len_t _get_common_prefix_len(void *key_ptr, uint8_t *prefix,
+                                        key_len_t prefixlen)
+{
+    key_len_t i, keylen, _keylen;
+    uint8_t *str = (uint8_t *)key_ptr + sizeof(key_len_t);
+
+    memcpy(&_keylen, key_ptr, sizeof(key_len_t));
+    keylen = _endian_decode(_keylen);
+    for (i=0; i<prefixlen && i<keylen && str[i] == prefix[i]; ++i);
+    return i;
+}
+
+// the common prefix may shrink by the new keys, so that the size is
+// estimated using the common prefix of the new keys and the existing prefix
+static size_t _get_prefix_data_size(
+    struct bnode *node, void *new_minkey, void *key_arr, void *value_arr, size_t len)
+{
+    int ksize, vsize;
+    size_t i, nentry, total_keylen;
+    void *key_ptr;
+    uint8_t *prefix = NULL;
+    key_len_t prefixlen, keylen, _keylen, offset;
+    key_len_t *_offset_arr;
+
+    _get_kvsize(node->kvsize, ksize, vsize);
+    ksize = sizeof(void *);
+
+    nentry = node->nentry;
+    prefixlen = 0;
+    total_keylen = 0;
+    if (nentry > 0) {
+        _offset_arr = _get_fast_str_layout((uint8_t *)node->data, node->flag,
+                                           &prefix, &prefixlen);
+        offset = _endian_decode(_offset_arr[0]);
+        total_keylen = _endian_decode(_offset_arr[nentry]) - offset -
+                       nentry * vsize + nentry * prefixlen;
+    }
+
+    if (new_minkey && nentry > 0) {
+        // replace the length of the smallest key
+        total_keylen -= _endian_decode(_offset_arr[1]) - offset - vsize +
+                        prefixlen;
+        memcpy(&key_ptr, new_minkey, ksize);
+        memcpy(&_keylen, key_ptr, sizeof(key_len_t));
+        keylen = _endian_decode(_keylen);
+        total_keylen += keylen;
+        prefixlen = _get_common_prefix_len(key_ptr, prefix, prefixlen);
+    }
+
+    if (key_arr && value_arr && len > 0) {
+        for (i=0; i<len; ++i) {
+            memcpy(&key_ptr, (uint8_t*)key_arr + ksize*i, ksize);
+            memcpy(&_keylen, key_ptr, sizeof(key_len_t));
+            keylen = _endian_decode(_keylen);
+            total_keylen += keylen;
+            if (nentry == 0 && i == 0) {
+                // the first key of an empty node
+                prefix = (uint8_t *)key_ptr + sizeof(key_len_t);
+                prefixlen = keylen;
+            } else {
+                prefixlen = _get_common_prefix_len(key_ptr, prefix, prefixlen);
+            }
+        }
+        nentry += len;
+    }
+
+    if (nentry == 0) {
+        return 0;
+    }
+    return _prefix_area_size(prefixlen) + sizeof(key_len_t) * (nentry+1) +
+           total_keylen - nentry * prefixlen + nentry * vsize;
+}
+
 static size_t _get_fast_str_data_size(
     struct bnode *node, void *new_minkey, void *key_arr, void *value_arr, size_t len)
 {
@@ -349,6 +650,10 @@ static size_t _get_fast_str_data_size(
     ptr = node->data;
     size = 0;
 
+    if (node->flag & BNODE_MASK_PREFIX) {
+        return _get_prefix_data_size(node, new_minkey, key_arr, value_arr, len);
+    }
+
     if (node->nentry == 0) return 0;
 
     // get offset array
@@ -603,6 +908,7 @@ struct btree_kv_ops * btree_fast_str_kv_get_kb64_vb64(struct btree_kv_ops *kv_op
 
     btree_kv_ops->bid2value = _fast_str_bid_to_value_64;
     btree_kv_ops->value2bid = _fast_str_value_to_bid_64;
+    btree_kv_ops->find_entry = NULL;
 
     return btree_kv_ops;
 }
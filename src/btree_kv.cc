@@ -17,80 +17,172 @@
 
 #include <stdlib.h>
 #include <string.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define _BTREE_KV_SIMD
+#endif
 
 #include "btree.h"
 #include "btree_kv.h"
 #include "memleak.h"
 
-INLINE void _get_kv(struct bnode *node, idx_t idx, void *key, void *value)
+/*
+ * Entry layout in a node.
+ * The legacy format interleaves keys and values ([k0][v0][k1][v1]...),
+ * while a node flagged as BNODE_MASK_SEPARATED stores all keys first and
+ * then all values ([k0][k1]...[v0][v1]...), so that a key search does not
+ * pull values into the cache. In the latter format the value array starts
+ * right after 'nentry' keys, thus the functions that add or remove entries
+ * relocate the value array based on the current 'nentry' (the caller
+ * updates 'nentry' afterwards).
+ */
+#define _is_separated(node) ((node)->flag & BNODE_MASK_SEPARATED)
+
+INLINE uint8_t * _key_ptr(struct bnode *node, idx_t idx,
+                          size_t ksize, size_t vsize)
 {
-    int ksize, vsize;
-    void *ptr;
-    _get_kvsize(node->kvsize, ksize, vsize);
-    ptr = (uint8_t *)node->data + (idx * (ksize+vsize));
+    if (_is_separated(node)) {
+        return (uint8_t *)node->data + idx * ksize;
+    }
+    return (uint8_t *)node->data + idx * (ksize + vsize);
+}
 
-    memcpy(key, ptr, ksize);
-    if (value) {
-        memcpy(value, (uint8_t *)ptr + ksize, vsize);
+INLINE uint8_t * _value_ptr(struct bnode *node, idx_t idx,
+                            size_t ksize, size_t vsize)
+{
+    if (_is_separated(node)) {
+        return (uint8_t *)node->data + node->nentry * ksize + idx * vsize;
     }
+    return (uint8_t *)node->data + idx * (ksize + vsize) + ksize;
 }
 
-INLINE void _set_kv(struct bnode *node, idx_t idx, void *key, void *value)
+INLINE void _get_kv_sized(struct bnode *node, idx_t idx, void *key, void *value,
+                          size_t ksize, size_t vsize)
 {
-    int ksize, vsize;
-    void *ptr;
-    _get_kvsize(node->kvsize, ksize, vsize);
-    ptr = (uint8_t *)node->data + (idx * (ksize+vsize));
+    memcpy(key, _key_ptr(node, idx, ksize, vsize), ksize);
+    if (value) {
+        memcpy(value, _value_ptr(node, idx, ksize, vsize), vsize);
+    }
+}
 
-    memcpy(ptr, key, ksize);
-    memcpy((uint8_t *)ptr + ksize, value, vsize);
+INLINE void _set_kv_sized(struct bnode *node, idx_t idx, void *key, void *value,
+                          size_t ksize, size_t vsize)
+{
+    uint8_t *ptr = (uint8_t *)node->data;
+    idx_t n = node->nentry;
+
+    if (_is_separated(node) && idx >= n) {
+        // append .. shift value array by one key
+        memmove(ptr + (n+1)*ksize, ptr + n*ksize, n*vsize);
+        memcpy(ptr + idx*ksize, key, ksize);
+        memcpy(ptr + (n+1)*ksize + idx*vsize, value, vsize);
+        return;
+    }
+    memcpy(_key_ptr(node, idx, ksize, vsize), key, ksize);
+    memcpy(_value_ptr(node, idx, ksize, vsize), value, vsize);
 }
 
-INLINE void _ins_kv(struct bnode *node, idx_t idx, void *key, void *value)
+INLINE void _ins_kv_sized(struct bnode *node, idx_t idx, void *key, void *value,
+                          size_t ksize, size_t vsize)
 {
-    int ksize, vsize, kvsize;
-    void *ptr;
-    _get_kvsize(node->kvsize, ksize, vsize);
-    kvsize = ksize + vsize;
-    ptr = node->data;
+    size_t kvsize = ksize + vsize;
+    uint8_t *ptr = (uint8_t *)node->data;
+    idx_t n = node->nentry;
+
+    if (!_is_separated(node)) {
+        if (key && value) {
+            // insert
+            memmove(ptr + (idx+1)*kvsize, ptr + idx*kvsize, (n - idx)*kvsize);
+            memcpy(ptr + idx*kvsize, key, ksize);
+            memcpy(ptr + idx*kvsize + ksize, value, vsize);
+        }else{
+            // remove
+            memmove(ptr + idx*kvsize, ptr + (idx+1)*kvsize, (n - (idx+1))*kvsize);
+        }
+        return;
+    }
 
     if (key && value) {
-        // insert
-        memmove(
-            (uint8_t *)ptr + (idx+1)*kvsize,
-            (uint8_t *)ptr + idx*kvsize,
-            (node->nentry - idx)*kvsize);
-        memcpy((uint8_t *)ptr + idx*kvsize, key, ksize);
-        memcpy((uint8_t *)ptr + idx*kvsize + ksize, value, vsize);
+        // insert .. move values first since the key array grows into them
+        memmove(ptr + (n+1)*ksize + (idx+1)*vsize, ptr + n*ksize + idx*vsize,
+                (n - idx)*vsize);
+        memmove(ptr + (n+1)*ksize, ptr + n*ksize, idx*vsize);
+        memmove(ptr + (idx+1)*ksize, ptr + idx*ksize, (n - idx)*ksize);
+        memcpy(ptr + idx*ksize, key, ksize);
+        memcpy(ptr + (n+1)*ksize + idx*vsize, value, vsize);
     }else{
-        // remove
-        memmove(
-            (uint8_t *)ptr + idx*kvsize,
-            (uint8_t *)ptr + (idx+1)*kvsize,
-            (node->nentry - (idx+1))*kvsize);
+        // remove .. move keys first since values move into the key array
+        memmove(ptr + idx*ksize, ptr + (idx+1)*ksize, (n - (idx+1))*ksize);
+        memmove(ptr + (n-1)*ksize, ptr + n*ksize, idx*vsize);
+        memmove(ptr + (n-1)*ksize + idx*vsize, ptr + n*ksize + (idx+1)*vsize,
+                (n - (idx+1))*vsize);
     }
 }
 
-INLINE void _copy_kv(
-    struct bnode *node_dst, struct bnode *node_src, idx_t dst_idx, idx_t src_idx, idx_t len)
+INLINE void _copy_kv_sized(
+    struct bnode *node_dst, struct bnode *node_src, idx_t dst_idx, idx_t src_idx, idx_t len,
+    size_t ksize, size_t vsize)
 {
-    int ksize, vsize, kvsize;
-    void *ptr_src, *ptr_dst;
+    size_t kvsize = ksize + vsize;
+    uint8_t *ptr_src = (uint8_t *)node_src->data;
+    uint8_t *ptr_dst = (uint8_t *)node_dst->data;
+    idx_t n_dst;
+
+    if (!_is_separated(node_dst)) {
+        if (node_dst == node_src) {
+            return;
+        }
+        memcpy(ptr_dst + kvsize * dst_idx, ptr_src + kvsize * src_idx,
+               kvsize * len);
+        return;
+    }
 
     if (node_dst == node_src) {
+        // the node is truncated to the first LEN entries (when split)
+        memmove(ptr_dst + len*ksize, ptr_dst + node_dst->nentry*ksize,
+                len*vsize);
         return;
     }
 
-    _get_kvsize(node_src->kvsize, ksize, vsize);
-    kvsize = ksize + vsize;
+    // DST will have (DST_IDX + LEN) entries at least
+    n_dst = node_dst->nentry;
+    if (dst_idx + len > n_dst) {
+        memmove(ptr_dst + (dst_idx + len)*ksize, ptr_dst + n_dst*ksize,
+                n_dst*vsize);
+        n_dst = dst_idx + len;
+    }
+    memcpy(ptr_dst + dst_idx*ksize, ptr_src + src_idx*ksize, len*ksize);
+    memcpy(ptr_dst + n_dst*ksize + dst_idx*vsize,
+           ptr_src + node_src->nentry*ksize + src_idx*vsize, len*vsize);
+}
 
-    ptr_src = node_src->data;
-    ptr_dst = node_dst->data;
+INLINE void _get_kv(struct bnode *node, idx_t idx, void *key, void *value)
+{
+    int ksize, vsize;
+    _get_kvsize(node->kvsize, ksize, vsize);
+    _get_kv_sized(node, idx, key, value, ksize, vsize);
+}
 
-    memcpy(
-        (uint8_t *)ptr_dst + kvsize * dst_idx,
-        (uint8_t *)ptr_src + kvsize * src_idx,
-        kvsize * len);
+INLINE void _set_kv(struct bnode *node, idx_t idx, void *key, void *value)
+{
+    int ksize, vsize;
+    _get_kvsize(node->kvsize, ksize, vsize);
+    _set_kv_sized(node, idx, key, value, ksize, vsize);
+}
+
+INLINE void _ins_kv(struct bnode *node, idx_t idx, void *key, void *value)
+{
+    int ksize, vsize;
+    _get_kvsize(node->kvsize, ksize, vsize);
+    _ins_kv_sized(node, idx, key, value, ksize, vsize);
+}
+
+INLINE void _copy_kv(
+    struct bnode *node_dst, struct bnode *node_src, idx_t dst_idx, idx_t src_idx, idx_t len)
+{
+    int ksize, vsize;
+    _get_kvsize(node_src->kvsize, ksize, vsize);
+    _copy_kv_sized(node_dst, node_src, dst_idx, src_idx, len, ksize, vsize);
 }
 
 INLINE size_t _get_data_size(
@@ -137,6 +229,96 @@ INLINE void _get_nth_splitter(struct bnode *prev_node, struct bnode *node, void
     memcpy(key, node->data, ksize);
 }
 
+/*
+ * Key-value operations specialized for fixed key and value sizes.
+ * Since the sizes are compile-time constants, the compiler can inline
+ * memcpy/memmove with the exact length instead of calling the generic
+ * routines with the sizes decoded from 'node->kvsize'. The B+tree using
+ * these operations MUST be initialized with the same 'ksize' and 'vsize'.
+ */
+template <size_t KSIZE, size_t VSIZE>
+static void _get_kv_fixed(struct bnode *node, idx_t idx, void *key, void *value)
+{
+    _get_kv_sized(node, idx, key, value, KSIZE, VSIZE);
+}
+
+template <size_t KSIZE, size_t VSIZE>
+static void _set_kv_fixed(struct bnode *node, idx_t idx, void *key, void *value)
+{
+    _set_kv_sized(node, idx, key, value, KSIZE, VSIZE);
+}
+
+template <size_t KSIZE, size_t VSIZE>
+static void _ins_kv_fixed(struct bnode *node, idx_t idx, void *key, void *value)
+{
+    _ins_kv_sized(node, idx, key, value, KSIZE, VSIZE);
+}
+
+template <size_t KSIZE, size_t VSIZE>
+static void _copy_kv_fixed(
+    struct bnode *node_dst, struct bnode *node_src, idx_t dst_idx, idx_t src_idx, idx_t len)
+{
+    _copy_kv_sized(node_dst, node_src, dst_idx, src_idx, len, KSIZE, VSIZE);
+}
+
+template <size_t KSIZE, size_t VSIZE>
+static size_t _get_data_size_fixed(
+    struct bnode *node, void *new_minkey, void *key_arr, void *value_arr, size_t len)
+{
+    return node->nentry * (KSIZE + VSIZE) +
+           ((key_arr && value_arr)?((KSIZE + VSIZE)*len):0);
+}
+
+template <size_t KSIZE, size_t VSIZE>
+static size_t _get_kv_size_fixed(struct btree *tree, void *key, void *value)
+{
+    return ((key) ? KSIZE : 0) + ((value) ? VSIZE : 0);
+}
+
+template <size_t KSIZE, size_t VSIZE>
+static void _init_kv_var_fixed(struct btree *tree, void *key, void *value)
+{
+    if (key) memset(key, 0, KSIZE);
+    if (value) memset(value, 0, VSIZE);
+}
+
+template <size_t KSIZE>
+static void _set_key_fixed(struct btree *tree, void *dst, void *src)
+{
+    memcpy(dst, src, KSIZE);
+}
+
+template <size_t VSIZE>
+static void _set_value_fixed(struct btree *tree, void *dst, void *src)
+{
+    memcpy(dst, src, VSIZE);
+}
+
+template <size_t KSIZE>
+static void _get_nth_splitter_fixed(struct bnode *prev_node, struct bnode *node, void *key)
+{
+    // always return the first key of the NODE
+    memcpy(key, node->data, KSIZE);
+}
+
+template <size_t KSIZE, size_t VSIZE>
+static void _set_kv_ops_fixed(struct btree_kv_ops *btree_kv_ops)
+{
+    btree_kv_ops->get_kv = _get_kv_fixed<KSIZE, VSIZE>;
+    btree_kv_ops->set_kv = _set_kv_fixed<KSIZE, VSIZE>;
+    btree_kv_ops->ins_kv = _ins_kv_fixed<KSIZE, VSIZE>;
+    btree_kv_ops->copy_kv = _copy_kv_fixed<KSIZE, VSIZE>;
+    btree_kv_ops->set_key = _set_key_fixed<KSIZE>;
+    btree_kv_ops->set_value = _set_value_fixed<VSIZE>;
+    btree_kv_ops->get_data_size = _get_data_size_fixed<KSIZE, VSIZE>;
+    btree_kv_ops->get_kv_size = _get_kv_size_fixed<KSIZE, VSIZE>;
+    btree_kv_ops->init_kv_var = _init_kv_var_fixed<KSIZE, VSIZE>;
+    btree_kv_ops->free_kv_var = NULL;
+
+    btree_kv_ops->get_nth_idx = _get_nth_idx;
+    btree_kv_ops->get_nth_splitter = _get_nth_splitter_fixed<KSIZE>;
+}
+
 INLINE bid_t _value_to_bid_64(void *value)
 {
     return *((bid_t *)value);
@@ -214,11 +396,154 @@ INLINE int _cmp_binary64(void *key1, void *key2, void *aux)
 #endif
 }
 
+/*
+ * Node search kernels for 8-byte keys.
+ * A node is searched by binary search until the candidate range becomes
+ * small enough, and then the number of keys equal or smaller than the
+ * given key in the range is counted using SIMD instructions if the CPU
+ * supports them. Keys are compared as unsigned 64-bit integers, either in
+ * big-endian byte order (i.e., same to memcmp) or in native byte order.
+ */
+// number of entries scanned linearly after binary search
+#define KEY64_SCAN_RANGE (16)
+
+typedef idx_t _count_le64_func(uint8_t *ptr, size_t stride, idx_t n,
+                               uint64_t key, int big_endian);
+
+INLINE uint64_t _get_key64(void *ptr, int big_endian)
+{
+    uint64_t key = deref64(ptr);
+    return (big_endian)?(_endian_decode(key)):(key);
+}
+
+static idx_t _count_le64_scalar(uint8_t *ptr, size_t stride, idx_t n,
+                                uint64_t key, int big_endian)
+{
+    idx_t i, count = 0;
+    for (i=0; i<n; ++i) {
+        count += (_get_key64(ptr + i*stride, big_endian) <= key);
+    }
+    return count;
+}
+
+#ifdef _BTREE_KV_SIMD
+__attribute__((target("sse4.2")))
+static idx_t _count_le64_sse42(uint8_t *ptr, size_t stride, idx_t n,
+                               uint64_t key, int big_endian)
+{
+    idx_t i, count = 0;
+    // signed comparison is used, so that flip the sign bit
+    const __m128i sign = _mm_set1_epi64x((long long)0x8000000000000000ULL);
+    const __m128i bswap = _mm_set_epi8(8, 9, 10, 11, 12, 13, 14, 15,
+                                       0, 1, 2, 3, 4, 5, 6, 7);
+    const __m128i k = _mm_xor_si128(_mm_set1_epi64x((long long)key), sign);
+    __m128i v, gt;
+
+    for (i=0; i+2<=n; i+=2) {
+        v = _mm_set_epi64x((long long)deref64(ptr + (i+1)*stride),
+                           (long long)deref64(ptr + i*stride));
+        if (big_endian) {
+            v = _mm_shuffle_epi8(v, bswap);
+        }
+        gt = _mm_cmpgt_epi64(_mm_xor_si128(v, sign), k);
+        count += 2 - __builtin_popcount(_mm_movemask_pd(_mm_castsi128_pd(gt)));
+    }
+    return count + _count_le64_scalar(ptr + i*stride, stride, n - i,
+                                      key, big_endian);
+}
+
+__attribute__((target("avx2")))
+static idx_t _count_le64_avx2(uint8_t *ptr, size_t stride, idx_t n,
+                              uint64_t key, int big_endian)
+{
+    idx_t i, count = 0;
+    // signed comparison is used, so that flip the sign bit
+    const __m256i sign = _mm256_set1_epi64x((long long)0x8000000000000000ULL);
+    const __m256i bswap = _mm256_set_epi8(8, 9, 10, 11, 12, 13, 14, 15,
+                                          0, 1, 2, 3, 4, 5, 6, 7,
+                                          8, 9, 10, 11, 12, 13, 14, 15,
+                                          0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i k = _mm256_xor_si256(_mm256_set1_epi64x((long long)key),
+                                       sign);
+    __m256i v, gt;
+
+    for (i=0; i+4<=n; i+=4) {
+        v = _mm256_set_epi64x((long long)deref64(ptr + (i+3)*stride),
+                              (long long)deref64(ptr + (i+2)*stride),
+                              (long long)deref64(ptr + (i+1)*stride),
+                              (long long)deref64(ptr + i*stride));
+        if (big_endian) {
+            v = _mm256_shuffle_epi8(v, bswap);
+        }
+        gt = _mm256_cmpgt_epi64(_mm256_xor_si256(v, sign), k);
+        count += 4 - __builtin_popcount(
+                         _mm256_movemask_pd(_mm256_castsi256_pd(gt)));
+    }
+    return count + _count_le64_scalar(ptr + i*stride, stride, n - i,
+                                      key, big_endian);
+}
+#endif
+
+static _count_le64_func * _select_count_le64()
+{
+#ifdef _BTREE_KV_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return _count_le64_avx2;
+    }
+    if (__builtin_cpu_supports("sse4.2")) {
+        return _count_le64_sse42;
+    }
+#endif
+    return _count_le64_scalar;
+}
+
+// chosen once at load time, so that readers never race on it
+static _count_le64_func *_count_le64 = _select_count_le64();
+
+INLINE idx_t _find_entry_key64(struct bnode *node, void *key, int big_endian)
+{
+    int ksize, vsize;
+    size_t stride;
+    uint8_t *ptr = (uint8_t *)node->data;
+    uint64_t k = _get_key64(key, big_endian);
+    idx_t start, end, middle;
+
+    _get_kvsize(node->kvsize, ksize, vsize);
+    stride = (_is_separated(node))?(ksize):(ksize + vsize);
+    start = 0;
+    end = node->nentry;
+
+    // find the first key greater than KEY
+    while (end - start > KEY64_SCAN_RANGE) {
+        middle = (start + end) >> 1;
+        if (_get_key64(ptr + middle*stride, big_endian) <= k) {
+            start = middle + 1;
+        } else {
+            end = middle;
+        }
+    }
+    start += _count_le64(ptr + start*stride, stride, end - start,
+                         k, big_endian);
+
+    return (start == 0)?(BTREE_IDX_NOT_FOUND):(start - 1);
+}
+
+static idx_t _find_entry_ku64(struct bnode *node, void *key)
+{
+    return _find_entry_key64(node, key, 0);
+}
+
+static idx_t _find_entry_kb64(struct bnode *node, void *key)
+{
+    return _find_entry_key64(node, key, 1);
+}
+
 // key: uint64_t, value: uint64_t
 static struct btree_kv_ops kv_ops_ku64_vu64 = {
     _get_kv, _set_kv, _ins_kv, _copy_kv, _get_data_size, _get_kv_size, _init_kv_var, NULL,
     _set_key, _set_value, _get_nth_idx, _get_nth_splitter,
-    _cmp_uint64_t, _value_to_bid_64, _bid_to_value_64};
+    _cmp_uint64_t, _value_to_bid_64, _bid_to_value_64, _find_entry_ku64};
 
 static struct btree_kv_ops kv_ops_ku32_vu64 = {
     _get_kv, _set_kv, _ins_kv, _copy_kv, _get_data_size, _get_kv_size, _init_kv_var, NULL,
@@ -244,24 +569,13 @@ struct btree_kv_ops * btree_kv_get_kb64_vb64(struct btree_kv_ops *kv_ops)
         btree_kv_ops = (struct btree_kv_ops *)malloc(sizeof(struct btree_kv_ops));
     }
 
-    btree_kv_ops->get_kv = _get_kv;
-    btree_kv_ops->set_kv = _set_kv;
-    btree_kv_ops->ins_kv = _ins_kv;
-    btree_kv_ops->copy_kv = _copy_kv;
-    btree_kv_ops->set_key = _set_key;
-    btree_kv_ops->set_value = _set_value;
-    btree_kv_ops->get_data_size = _get_data_size;
-    btree_kv_ops->get_kv_size = _get_kv_size;
-    btree_kv_ops->init_kv_var = _init_kv_var;
-    btree_kv_ops->free_kv_var = NULL;
-
-    btree_kv_ops->get_nth_idx = _get_nth_idx;
-    btree_kv_ops->get_nth_splitter = _get_nth_splitter;
+    _set_kv_ops_fixed<8, 8>(btree_kv_ops);
 
     btree_kv_ops->cmp = _cmp_binary64;
 
     btree_kv_ops->bid2value = _bid_to_value_64;
     btree_kv_ops->value2bid = _value_to_bid_64;
+    btree_kv_ops->find_entry = _find_entry_kb64;
 
     return btree_kv_ops;
 }
@@ -275,24 +589,13 @@ struct btree_kv_ops * btree_kv_get_kb32_vb64(struct btree_kv_ops *kv_ops)
         btree_kv_ops = (struct btree_kv_ops *)malloc(sizeof(struct btree_kv_ops));
     }
 
-    btree_kv_ops->get_kv = _get_kv;
-    btree_kv_ops->set_kv = _set_kv;
-    btree_kv_ops->ins_kv = _ins_kv;
-    btree_kv_ops->copy_kv = _copy_kv;
-    btree_kv_ops->set_key = _set_key;
-    btree_kv_ops->set_value = _set_value;
-    btree_kv_ops->get_data_size = _get_data_size;
-    btree_kv_ops->get_kv_size = _get_kv_size;
-    btree_kv_ops->init_kv_var = _init_kv_var;
-    btree_kv_ops->free_kv_var = NULL;
-
-    btree_kv_ops->get_nth_idx = _get_nth_idx;
-    btree_kv_ops->get_nth_splitter = _get_nth_splitter;
+    _set_kv_ops_fixed<4, 8>(btree_kv_ops);
 
     btree_kv_ops->cmp = _cmp_binary32;
 
     btree_kv_ops->bid2value = _bid_to_value_64;
     btree_kv_ops->value2bid = _value_to_bid_64;
+    btree_kv_ops->find_entry = NULL;
 
     return btree_kv_ops;
 }
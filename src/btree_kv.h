@@ -55,8 +55,10 @@ INLINE uint64_t deref64(const void *ptr)
 }
 
 struct btree_kv_ops;
+// key and value sizes are taken from each node
 struct btree_kv_ops * btree_kv_get_ku64_vu64();
 struct btree_kv_ops * btree_kv_get_ku32_vu64();
+// specialized for fixed key (8 or 4 bytes) and value (8 bytes) sizes
 struct btree_kv_ops * btree_kv_get_kb64_vb64(struct btree_kv_ops *kv_ops);
 struct btree_kv_ops * btree_kv_get_kb32_vb64(struct btree_kv_ops *kv_ops);
 
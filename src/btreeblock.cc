@@ -21,6 +21,7 @@
 
 #include "common.h"
 #include "btreeblock.h"
+#include "trace.h"
 
 #include "memleak.h"
 
@@ -366,7 +367,13 @@ INLINE void * _btreeblk_read(void *voidhandle, bid_t bid, int sb_no)
     block->age = 0;
 
     _btreeblk_get_aligned_block(handle, block);
-    filemgr_read(handle->file, block->bid, block->addr, handle->log_callback);
+    if (handle->use_mmap) {
+        filemgr_read_mapped(handle->file, block->bid, block->addr,
+                            handle->log_callback);
+    } else {
+        filemgr_read(handle->file, block->bid, block->addr,
+                     handle->log_callback);
+    }
     _btreeblk_decode(handle, block);
 
     list_push_front(&handle->read_list, &block->le);
@@ -383,6 +390,16 @@ INLINE void * _btreeblk_read(void *voidhandle, bid_t bid, int sb_no)
     }
 }
 
+// return the BID of the file block that contains the node BID
+bid_t btreeblk_get_file_bid(struct btreeblk_handle *handle, bid_t bid)
+{
+    bid_t _bid;
+    size_t sb, idx;
+
+    subbid2bid(bid, &sb, &idx, &_bid);
+    return _bid / handle->nnodeperblock;
+}
+
 void * btreeblk_read(void *voidhandle, bid_t bid)
 {
     return _btreeblk_read(voidhandle, bid, -1);
@@ -1082,6 +1099,7 @@ void btreeblk_end(struct btreeblk_handle *handle)
     struct list_elem *e;
     struct btreeblk_block *block;
 
+    TRACE_BEGIN(FDB_TRACE_BTREEBLK_END);
     // flush all dirty items
     btreeblk_operation_end((void *)handle);
 
@@ -1097,4 +1115,5 @@ void btreeblk_end(struct btreeblk_handle *handle)
         avl_insert(&handle->read_tree, &block->avl, _btreeblk_bid_cmp);
 #endif
     }
+    TRACE_END(FDB_TRACE_BTREEBLK_END);
 }
@@ -44,6 +44,8 @@ struct btreeblk_handle{
     struct list read_list;
     struct filemgr *file;
     err_log_callback *log_callback;
+    // read committed blocks from the memory mapping of the file
+    bool use_mmap;
 
 #ifdef __BTREEBLK_READ_TREE
     struct avl_tree read_tree;
@@ -67,6 +69,7 @@ void btreeblk_init(struct btreeblk_handle *handle, struct filemgr *file, int nod
 void btreeblk_free(struct btreeblk_handle *handle);
 void btreeblk_discard_blocks(struct btreeblk_handle *handle);
 void btreeblk_end(struct btreeblk_handle *handle);
+bid_t btreeblk_get_file_bid(struct btreeblk_handle *handle, bid_t bid);
 
 #ifdef __cplusplus
 }
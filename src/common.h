@@ -73,6 +73,11 @@ enum{
 #define BLK_MARKER_DOC (0xdd)
 #define BLK_MARKER_SIZE (1)
 
+// checksum algorithm of a b-tree node block, stored right after the 4-byte
+// CRC in the CRC field (legacy blocks have 0xff there)
+#define BLK_CRC_LEGACY (0xff)
+#define BLK_CRC_CRC32C (0x1)
+
 #define randomize() srand((unsigned)time(NULL))
 #define random(num) ((rand())%(num))
 
@@ -57,6 +57,20 @@ fdb_config get_default_config(void) {
     fconfig.multi_kv_instances = true;
     // 30 seconds by default
     fconfig.prefetch_duration = 30;
+    // Bloom filter is disabled by default
+    fconfig.bloom_filter_bits_per_key = 0;
+    // Slow operation log is disabled by default
+    fconfig.slow_op_threshold = 0;
+    // Buffer cache warm-up is disabled by default
+    fconfig.cache_warmup = false;
+    // Prefetch the tail of the file by default
+    fconfig.prefetch_mode = FDB_PREFETCH_TAIL;
+    // Index prefetch fills up to half of the buffer cache
+    fconfig.prefetch_cache_ratio = 50;
+    // Memory-mapped reads are disabled by default
+    fconfig.mmap_readonly = false;
+    // Create nodes readable by all versions by default
+    fconfig.node_format = FDB_NODE_FORMAT_V1;
 
     return fconfig;
 }
@@ -105,6 +119,23 @@ bool validate_fdb_config(fdb_config *fconfig) {
         // Sleep duration should be larger than zero
         return false;
     }
+    if (fconfig->bloom_filter_bits_per_key > 32) {
+        // More bits per key hardly improve the false positive rate
+        return false;
+    }
+    if (fconfig->prefetch_mode != FDB_PREFETCH_TAIL &&
+        fconfig->prefetch_mode != FDB_PREFETCH_INDEX &&
+        fconfig->prefetch_mode != FDB_PREFETCH_INDEX_SEQTREE) {
+        return false;
+    }
+    if (fconfig->prefetch_cache_ratio > 100) {
+        // Prefetch cache ratio should be equal or less than 100 (%).
+        return false;
+    }
+    if (fconfig->node_format != FDB_NODE_FORMAT_V1 &&
+        fconfig->node_format != FDB_NODE_FORMAT_V2) {
+        return false;
+    }
 
     return true;
 }
@@ -22,6 +22,8 @@
 #include "docio.h"
 #include "wal.h"
 #include "fdb_internal.h"
+#include "io_stats.h"
+#include "slowlog.h"
 #ifdef _DOC_COMP
 #include "snappy-c.h"
 #endif
@@ -38,6 +40,7 @@ void docio_init(struct docio_handle *handle,
     handle->lastbid = BLK_NOT_FOUND;
     handle->compress_document_body = compress_document_body;
     malloc_align(handle->readbuffer, FDB_SECTOR_SIZE, file->blocksize);
+    handle->readptr = handle->readbuffer;
 }
 
 void docio_free(struct docio_handle *handle)
@@ -347,6 +350,9 @@ INLINE bid_t _docio_append_doc(struct docio_handle *handle, struct docio_object
     memcpy((uint8_t *)buf + offset, &crc, sizeof(crc));
 #endif
 
+    if (length.flag & DOCIO_SYSTEM) {
+        io_stats_add_system_doc(handle->file, docsize);
+    }
     ret_offset = docio_append_doc_raw(handle, docsize, buf);
     free(buf);
 
@@ -419,12 +425,25 @@ bid_t docio_append_doc_system(struct docio_handle *handle, struct docio_object *
     return _docio_append_doc(handle, doc);
 }
 
-INLINE void _docio_read_through_buffer(struct docio_handle *handle, bid_t bid,
-                                       err_log_callback *log_callback)
+// return the contents of the given block
+INLINE void *_docio_read_through_buffer(struct docio_handle *handle, bid_t bid,
+                                        err_log_callback *log_callback)
 {
+    void *addr;
+
     // to reduce the overhead from memcpy the same block
     if (handle->lastbid != bid) {
+        addr = (handle->use_mmap)?
+               (filemgr_get_mapped_block(handle->file, bid)):(NULL);
+        if (addr) {
+            // committed block in the memory mapping .. read it in place
+            handle->readptr = addr;
+            handle->lastbid = bid;
+            return addr;
+        }
+
         filemgr_read(handle->file, bid, handle->readbuffer, log_callback);
+        handle->readptr = handle->readbuffer;
 
         if (filemgr_is_writable(handle->file, bid)) {
             // this block can be modified later .. must be re-read
@@ -433,6 +452,7 @@ INLINE void _docio_read_through_buffer(struct docio_handle *handle, bid_t bid,
             handle->lastbid = bid;
         }
     }
+    return handle->readptr;
 }
 
 uint64_t _docio_read_length(struct docio_handle *handle,
@@ -452,12 +472,12 @@ uint64_t _docio_read_length(struct docio_handle *handle,
 
     bid_t bid = offset / real_blocksize;
     uint32_t pos = offset % real_blocksize;
-    void *buf = handle->readbuffer;
+    void *buf;
     uint32_t restsize;
 
     restsize = blocksize - pos;
     // read length structure
-    _docio_read_through_buffer(handle, bid, log_callback);
+    buf = _docio_read_through_buffer(handle, bid, log_callback);
 
     if (restsize >= sizeof(struct docio_length)) {
         memcpy(length, (uint8_t *)buf + pos, sizeof(struct docio_length));
@@ -467,7 +487,7 @@ uint64_t _docio_read_length(struct docio_handle *handle,
         memcpy(length, (uint8_t *)buf + pos, restsize);
         // read additional block
         bid++;
-        _docio_read_through_buffer(handle, bid, log_callback);
+        buf = _docio_read_through_buffer(handle, bid, log_callback);
         // memcpy rest of data
         memcpy((uint8_t *)length + restsize, buf, sizeof(struct docio_length) - restsize);
         pos = sizeof(struct docio_length) - restsize;
@@ -492,13 +512,13 @@ uint64_t _docio_read_doc_component(struct docio_handle *handle,
     bid_t bid = offset / real_blocksize;
     uint32_t pos = offset % real_blocksize;
     //uint8_t buf[handle->file->blocksize];
-    void *buf = handle->readbuffer;
+    void *buf;
     uint32_t restsize;
 
     rest_len = len;
 
     while(rest_len > 0) {
-        _docio_read_through_buffer(handle, bid, log_callback);
+        buf = _docio_read_through_buffer(handle, bid, log_callback);
         restsize = blocksize - pos;
 
         if (restsize >= rest_len) {
@@ -601,6 +621,31 @@ struct docio_length docio_read_doc_length(struct docio_handle *handle, uint64_t
     return length;
 }
 
+// return the ID of the last block occupied by the document at the given
+// offset, whose length structure is LENGTH
+bid_t docio_get_doc_last_bid(struct docio_handle *handle, uint64_t offset,
+                             struct docio_length length)
+{
+    size_t blocksize = handle->file->blocksize;
+    size_t real_blocksize = blocksize;
+    uint64_t docsize;
+#ifdef __CRC32
+    blocksize -= BLK_MARKER_SIZE;
+#endif
+
+    docsize = sizeof(struct docio_length) + length.keylen + length.metalen +
+              length.bodylen_ondisk;
+    docsize += sizeof(timestamp_t);
+    docsize += sizeof(fdb_seqnum_t);
+#ifdef __CRC32
+    docsize += sizeof(uint32_t);
+#endif
+
+    // each block holds BLOCKSIZE bytes of documents, followed by its marker
+    return offset / real_blocksize +
+           (offset % real_blocksize + docsize - 1) / blocksize;
+}
+
 // return length.keylen = 0 if failure
 void docio_read_doc_key(struct docio_handle *handle, uint64_t offset,
                         keylen_t *keylen, void *keybuf)
@@ -667,8 +712,9 @@ void free_docio_object(struct docio_object *doc, uint8_t key_alloc,
     }
 }
 
-uint64_t docio_read_doc_key_meta(struct docio_handle *handle, uint64_t offset,
-                                 struct docio_object *doc)
+static uint64_t _docio_read_doc_key_meta(struct docio_handle *handle,
+                                         uint64_t offset,
+                                         struct docio_object *doc)
 {
     uint8_t checksum;
     uint64_t _offset;
@@ -755,8 +801,8 @@ uint64_t docio_read_doc_key_meta(struct docio_handle *handle, uint64_t offset,
     return _offset;
 }
 
-uint64_t docio_read_doc(struct docio_handle *handle, uint64_t offset,
-                        struct docio_object *doc)
+static uint64_t _docio_read_doc(struct docio_handle *handle, uint64_t offset,
+                                struct docio_object *doc)
 {
     uint8_t checksum;
     uint64_t _offset;
@@ -940,12 +986,30 @@ uint64_t docio_read_doc(struct docio_handle *handle, uint64_t offset,
     return _offset;
 }
 
+uint64_t docio_read_doc_key_meta(struct docio_handle *handle, uint64_t offset,
+                                 struct docio_object *doc)
+{
+    uint64_t begin = slowlog_phase_begin();
+    uint64_t ret = _docio_read_doc_key_meta(handle, offset, doc);
+    slowlog_phase_end(SLOWLOG_DOCIO_READ, begin);
+    return ret;
+}
+
+uint64_t docio_read_doc(struct docio_handle *handle, uint64_t offset,
+                        struct docio_object *doc)
+{
+    uint64_t begin = slowlog_phase_begin();
+    uint64_t ret = _docio_read_doc(handle, offset, doc);
+    slowlog_phase_end(SLOWLOG_DOCIO_READ, begin);
+    return ret;
+}
+
 int docio_check_buffer(struct docio_handle *handle, bid_t bid)
 {
     uint8_t marker[BLK_MARKER_SIZE];
     err_log_callback *log_callback = handle->log_callback;
-    _docio_read_through_buffer(handle, bid, log_callback);
-    marker[0] = *(((uint8_t *)handle->readbuffer)
+    void *buf = _docio_read_through_buffer(handle, bid, log_callback);
+    marker[0] = *(((uint8_t *)buf)
                  + handle->file->blocksize - BLK_MARKER_SIZE);
     return (marker[0] == BLK_MARKER_DOC);
 }
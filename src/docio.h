@@ -35,8 +35,13 @@ struct docio_handle {
     // for buffer purpose
     bid_t lastbid;
     void *readbuffer;
+    // contents of 'lastbid': 'readbuffer', or the block in the memory
+    // mapping of the file
+    void *readptr;
     err_log_callback *log_callback;
     bool compress_document_body;
+    // read committed blocks from the memory mapping of the file
+    bool use_mmap;
 };
 
 #define DOCIO_NORMAL (0x00)
@@ -97,6 +102,8 @@ bid_t docio_append_doc_system(struct docio_handle *handle, struct docio_object *
 
 struct docio_length docio_read_doc_length(struct docio_handle *handle,
                                           uint64_t offset);
+bid_t docio_get_doc_last_bid(struct docio_handle *handle, uint64_t offset,
+                             struct docio_length length);
 void docio_read_doc_key(struct docio_handle *handle,
                         uint64_t offset,
                         keylen_t *keylen,
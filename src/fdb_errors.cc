@@ -132,6 +132,9 @@ const char* fdb_error_msg(fdb_status err_code)
         case FDB_RESULT_IN_USE_BY_COMPACTOR:
             return "file is in use by compactor, retry later";
 
+        case FDB_RESULT_TOO_SMALL_BUFFER:
+            return "buffer is too small to hold a document";
+
         default:
             return "unknown error";
     }
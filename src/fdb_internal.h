@@ -33,6 +33,7 @@ struct kvs_header {
     fdb_custom_cmp_variable default_kvs_cmp;
     struct avl_tree *idx_name;
     struct avl_tree *idx_id;
+    struct avl_tree *idx_dropped; // IDs of dropped KV stores (by avl_id)
     uint8_t custom_cmp_enabled;
     spin_t lock;
 };
@@ -54,10 +55,24 @@ struct kvs_node {
 #define FDB_FLAG_SEQTREE_USE (0x1)
 #define FDB_FLAG_ROOT_INITIALIZED (0x2)
 #define FDB_FLAG_ROOT_CUSTOM_CMP (0x4)
+#define FDB_FLAG_BLK_CRC32C (0x8)
+// the range tombstone offset follows the file names in the DB header
+#define FDB_FLAG_RANGE_DEL (0x10)
+// the Bloom filter offset follows the range tombstone offset
+#define FDB_FLAG_BLOOM (0x20)
+
+// position of the file name lengths in the DB header; new header fields
+// are appended after the file names so that this offset never changes.
+#define FDB_HEADER_FILENAME_OFFSET (64)
 
 size_t _fdb_readkey_wrap(void *handle, uint64_t offset, void *buf);
 size_t _fdb_readseq_wrap(void *handle, uint64_t offset, void *buf);
 int _fdb_custom_cmp_wrap(void *key1, void *key2, void *aux);
+int _fdb_keycmp(void *key1, size_t keylen1, void *key2, size_t keylen2);
+int _fdb_range_del_exist(fdb_kvs_handle *handle);
+int _fdb_range_del_covered(fdb_kvs_handle *handle,
+                           void *key, size_t keylen,
+                           fdb_seqnum_t seqnum);
 
 fdb_status fdb_log(err_log_callback *callback,
                    fdb_status status,
@@ -82,6 +97,8 @@ void fdb_fetch_header(void *header_buf,
                       uint64_t *last_wal_flush_hdr_bid,
                       uint64_t *kv_info_offset,
                       uint64_t *header_flags,
+                      uint64_t *range_del_offset,
+                      uint64_t *bloom_offset,
                       char **new_filename,
                       char **old_filename);
 uint64_t fdb_set_file_header(fdb_kvs_handle *handle);
@@ -104,6 +121,8 @@ void fdb_file_handle_parse_cmp_func(fdb_file_handle *fhandle,
                                     char **kvs_names,
                                     fdb_custom_cmp_variable *functions);
 void fdb_file_handle_free(fdb_file_handle *fhandle);
+void fdb_file_handle_get_log_callback(fdb_file_handle *fhandle,
+                                      err_log_callback *log_callback);
 
 fdb_status fdb_kvs_cmp_check(fdb_kvs_handle *handle);
 void * fdb_kvs_find_cmp_chunk(void *chunk, void *aux);
@@ -130,6 +149,8 @@ void _fdb_kvs_header_import(struct kvs_header *kv_header,
 void _fdb_kvs_header_free(struct kvs_header *kv_header);
 fdb_seqnum_t _fdb_kvs_get_seqnum(struct kvs_header *kv_header,
                                     fdb_kvs_id_t id);
+int _fdb_kvs_is_dropped(struct kvs_header *kv_header, fdb_kvs_id_t id);
+size_t _fdb_kvs_get_num_dropped(struct kvs_header *kv_header);
 
 void fdb_kvs_header_free(struct filemgr *file);
 
@@ -34,6 +34,12 @@
 #include "list.h"
 #include "fdb_internal.h"
 #include "time_utils.h"
+#include "latency.h"
+#include "io_stats.h"
+#include "trace.h"
+#include "slowlog.h"
+#include "lockprof.h"
+#include "warmup.h"
 
 #include "memleak.h"
 
@@ -74,6 +80,7 @@ static struct list temp_buf;
 static spin_t temp_buf_lock;
 
 static void _filemgr_free_func(struct hash_elem *h);
+static void _filemgr_free_mmap(struct filemgr *file);
 
 static void spin_init_wrap(void *lock) {
     spin_init((spin_t*)lock);
@@ -99,8 +106,10 @@ static void mutex_destroy_wrap(void *lock) {
     mutex_destroy((mutex_t*)lock);
 }
 
+// used for the per-range locks of plock: a call blocks if it waits for an
+// overlapping range, and acquisitions are counted after plock_lock returns.
 static void mutex_lock_wrap(void *lock) {
-    mutex_lock((mutex_t*)lock);
+    LOCKPROF_MUTEX_WAIT(FDB_LOCK_PLOCK, (mutex_t*)lock);
 }
 
 static void mutex_unlock_wrap(void *lock) {
@@ -292,6 +301,7 @@ fdb_status _filemgr_read_header(struct filemgr *file)
         do {
             ssize_t rv = file->ops->pread(file->fd, buf, file->blocksize,
                              file->pos - file->blocksize);
+            io_stats_add_read(file, file->blocksize);
             if (rv != file->blocksize) {
                 status = FDB_RESULT_READ_FAIL;
                 DBG("Unable to read file %s blocksize %llu\n",
@@ -385,9 +395,32 @@ size_t filemgr_get_ref_count(struct filemgr *file)
 struct filemgr_prefetch_args {
     struct filemgr *file;
     uint64_t duration;
+    // blocks to be loaded by cache warm-up (sorted in ascending order),
+    // or NULL for prefetching the tail of the file
+    bid_t *bids;
+    size_t nbids;
+    // custom prefetch function (see filemgr_prefetch_custom())
+    filemgr_prefetch_func *func;
     void *aux;
 };
 
+// read the blocks in the warm-up list, FILEMGR_PREFETCH_UNIT at a time,
+// until the list is exhausted or the block cache is full
+static void _filemgr_warmup(struct filemgr_prefetch_args *args)
+{
+    size_t i, n;
+    size_t unit = FILEMGR_PREFETCH_UNIT / args->file->blocksize;
+
+    for (i = 0; i < args->nbids; i += n) {
+        if (args->file->prefetch_status == FILEMGR_PREFETCH_ABORT ||
+            bcache_get_num_free_blocks() == 0) {
+            break;
+        }
+        n = MIN(unit, args->nbids - i);
+        filemgr_readahead(args->file, args->bids + i, n, NULL);
+    }
+}
+
 void *_filemgr_prefetch_thread(void *voidargs)
 {
     struct filemgr_prefetch_args *args = (struct filemgr_prefetch_args*)voidargs;
@@ -398,6 +431,14 @@ void *_filemgr_prefetch_thread(void *voidargs)
     bool terminate = false;
     struct timeval begin, cur, gap;
 
+    if (args->bids) {
+        _filemgr_warmup(args);
+        terminate = true;
+    } else if (args->func) {
+        args->func(args->file, args->aux);
+        terminate = true;
+    }
+
     spin_lock(&args->file->lock);
     cur_pos = args->file->last_commit;
     spin_unlock(&args->file->lock);
@@ -447,10 +488,66 @@ void *_filemgr_prefetch_thread(void *voidargs)
     }
 
     args->file->prefetch_status = FILEMGR_PREFETCH_IDLE;
+    free(args->bids);
     free(args);
     return NULL;
 }
 
+// load the blocks in the warm-up list in the background
+static void _filemgr_start_warmup(struct filemgr *file, bid_t *bids,
+                                  size_t nbids)
+{
+    struct filemgr_prefetch_args *args;
+    args = (struct filemgr_prefetch_args *)
+           calloc(1, sizeof(struct filemgr_prefetch_args));
+    args->file = file;
+    args->bids = bids;
+    args->nbids = nbids;
+
+    spin_lock(&file->lock);
+    file->prefetch_status = FILEMGR_PREFETCH_RUNNING;
+    thread_create(&file->prefetch_tid, _filemgr_prefetch_thread, args);
+    spin_unlock(&file->lock);
+}
+
+bool filemgr_prefetch_custom(struct filemgr *file,
+                             filemgr_prefetch_func *func, void *aux)
+{
+    bool ret = false;
+
+    spin_lock(&file->lock);
+    if (file->prefetch_status == FILEMGR_PREFETCH_IDLE) {
+        struct filemgr_prefetch_args *args;
+        args = (struct filemgr_prefetch_args *)
+               calloc(1, sizeof(struct filemgr_prefetch_args));
+        args->file = file;
+        args->func = func;
+        args->aux = aux;
+
+        file->prefetch_status = FILEMGR_PREFETCH_RUNNING;
+        thread_create(&file->prefetch_tid, _filemgr_prefetch_thread, args);
+        ret = true;
+    }
+    spin_unlock(&file->lock);
+    return ret;
+}
+
+bool filemgr_prefetch_aborted(struct filemgr *file)
+{
+    return file->prefetch_status == FILEMGR_PREFETCH_ABORT;
+}
+
+// save the warm-up list of the file to be closed, unless the file is
+// going to be removed
+static void _filemgr_save_warmup(struct filemgr *file, const char *filename)
+{
+    if ((file->config->options & FILEMGR_CACHE_WARMUP) &&
+        global_config.ncacheblock > 0 &&
+        (file->status == FILE_NORMAL || file->status == FILE_CLOSED)) {
+        warmup_save(file, filename);
+    }
+}
+
 // prefetch the given DB file
 void filemgr_prefetch(struct filemgr *file,
                       struct filemgr_config *config)
@@ -533,6 +630,9 @@ filemgr_open_result filemgr_open(char *filename, struct filemgr_ops *ops,
                 }
             } else { // Reopening the closed file is succeed.
                 file->status = FILE_NORMAL;
+                // the file may have been replaced while it was closed,
+                // and no handle refers to the old mappings
+                _filemgr_free_mmap(file);
                 if (config->options & FILEMGR_SYNC) {
                     file->fflags |= FILEMGR_SYNC;
                 } else {
@@ -609,6 +709,13 @@ filemgr_open_result filemgr_open(char *filename, struct filemgr_ops *ops,
     file->bcache = NULL;
     file->in_place_compaction = false;
     file->kv_header = NULL;
+    file->range_del = NULL;
+    file->bloom = NULL;
+    // legacy checksum unless the DB header or the node format of a new
+    // file says otherwise (see _fdb_open)
+    file->blk_crc_type = BLK_CRC_LEGACY;
+    latency_init(file);
+    io_stats_init(file);
     file->prefetch_status = FILEMGR_PREFETCH_IDLE;
 
     _filemgr_read_header(file);
@@ -675,7 +782,17 @@ filemgr_open_result filemgr_open(char *filename, struct filemgr_ops *ops,
     wal_add_transaction(file, &file->global_txn);
 
     hash_insert(&hash, &file->e);
-    if (config->prefetch_duration > 0) {
+    if ((config->options & FILEMGR_CACHE_WARMUP) &&
+        global_config.ncacheblock > 0) {
+        size_t nbids;
+        bid_t *bids = warmup_load(file, bcache_get_num_free_blocks(), &nbids);
+        if (bids) {
+            // the warm-up list replaces prefetching the tail of the file
+            _filemgr_start_warmup(file, bids, nbids);
+        }
+    }
+    if (file->prefetch_status == FILEMGR_PREFETCH_IDLE &&
+        config->prefetch_duration > 0) {
         filemgr_prefetch(file, config);
     }
     spin_unlock(&filemgr_openlock);
@@ -861,6 +978,7 @@ fdb_status filemgr_close(struct filemgr *file, bool cleanup_cache_onclose,
             _log_errno_str(file->ops, log_callback, (fdb_status)rv, "CLOSE", file->filename);
             // remove file
             remove(file->filename);
+            warmup_remove(file->filename);
             // we can release lock becuase no one will open this file
             spin_unlock(&file->lock);
             struct hash_elem *ret = hash_remove(&hash, &file->e);
@@ -870,6 +988,7 @@ fdb_status filemgr_close(struct filemgr *file, bool cleanup_cache_onclose,
             return (fdb_status) rv;
         } else {
             if (cleanup_cache_onclose) {
+                const char *warmup_filename = file->filename;
                 _log_errno_str(file->ops, log_callback, (fdb_status)rv, "CLOSE", file->filename);
                 if (file->in_place_compaction && orig_file_name) {
                     struct hash_elem *elem = NULL;
@@ -882,9 +1001,12 @@ fdb_status filemgr_close(struct filemgr *file, bool cleanup_cache_onclose,
                         // identified and opened in the next fdb_open call.
                         _log_errno_str(file->ops, log_callback, FDB_RESULT_FILE_RENAME_FAIL,
                                        "CLOSE", file->filename);
+                    } else if (!elem) {
+                        warmup_filename = orig_file_name;
                     }
                 }
                 spin_unlock(&file->lock);
+                _filemgr_save_warmup(file, warmup_filename);
                 // Clean up global hash table, WAL index, and buffer cache.
                 struct hash_elem *ret = hash_remove(&hash, &file->e);
                 assert(ret);
@@ -904,6 +1026,87 @@ fdb_status filemgr_close(struct filemgr *file, bool cleanup_cache_onclose,
     return (fdb_status) rv;
 }
 
+// map the file up to twice of 'size' bytes, so that the mapping does not
+// need to be replaced on every commit of a growing file
+static struct filemgr_mmap *_filemgr_remap(struct filemgr *file, uint64_t size)
+{
+    struct filemgr_mmap *m, *ret;
+    uint64_t len = size * 2;
+    void *addr;
+
+    addr = file->ops->mmap(file->fd, len);
+    if (!addr) {
+        return NULL;
+    }
+    m = (struct filemgr_mmap *)malloc(sizeof(struct filemgr_mmap));
+    m->addr = (uint8_t *)addr;
+    m->len = len;
+
+    spin_lock(&file->lock);
+    if (file->mmap && file->mmap->len >= size) {
+        // already remapped by another thread
+        ret = file->mmap;
+        spin_unlock(&file->lock);
+        file->ops->munmap(addr, len);
+        free(m);
+        return ret;
+    }
+    if (file->mmap) {
+        file->mmap->prev = file->mmap_retired;
+        file->mmap_retired = file->mmap;
+    }
+    m->prev = NULL;
+    file->mmap = m;
+    spin_unlock(&file->lock);
+    return m;
+}
+
+// unmap all mappings of the file (no reader should remain)
+static void _filemgr_free_mmap(struct filemgr *file)
+{
+    struct filemgr_mmap *m, *prev;
+
+    if (file->mmap) {
+        file->mmap->prev = file->mmap_retired;
+        file->mmap_retired = file->mmap;
+        file->mmap = NULL;
+    }
+    for (m = file->mmap_retired; m; m = prev) {
+        prev = m->prev;
+        file->ops->munmap(m->addr, m->len);
+        free(m);
+    }
+    file->mmap_retired = NULL;
+}
+
+// return the address of the given block in the memory mapping of the file,
+// or NULL if the file cannot be mapped or the block is not committed yet.
+// the address remains valid until the file is freed.
+void *filemgr_get_mapped_block(struct filemgr *file, bid_t bid)
+{
+    struct filemgr_mmap *m;
+    uint64_t pos = bid * file->blocksize;
+    uint64_t last_commit;
+
+    spin_lock(&file->lock);
+    last_commit = file->last_commit;
+    m = file->mmap;
+    spin_unlock(&file->lock);
+
+    if (pos + file->blocksize > last_commit) {
+        // uncommitted blocks can still be modified
+        return NULL;
+    }
+    if (!m || pos + file->blocksize > m->len) {
+        // the file has grown since it was mapped
+        m = _filemgr_remap(file, last_commit);
+        if (!m) {
+            return NULL;
+        }
+    }
+    return m->addr + pos;
+}
+
 static void _filemgr_free_func(struct hash_elem *h)
 {
     struct filemgr *file = _get_entry(h, struct filemgr, e);
@@ -932,6 +1135,20 @@ static void _filemgr_free_func(struct hash_elem *h)
         file->free_kv_header(file);
     }
 
+    if (file->range_del) {
+        // range tombstones exist
+        file->free_range_del(file);
+    }
+
+    if (file->bloom) {
+        // Bloom filter exists
+        file->free_bloom(file);
+    }
+
+    latency_free(file);
+    io_stats_free(file);
+    _filemgr_free_mmap(file);
+
     // free global transaction
     wal_remove_transaction(file, &file->global_txn);
     free(file->global_txn.items);
@@ -997,12 +1214,19 @@ void filemgr_remove_file(struct filemgr *file)
     _filemgr_free_func(&file->e);
 }
 
+static void _filemgr_shutdown_func(struct hash_elem *h)
+{
+    struct filemgr *file = _get_entry(h, struct filemgr, e);
+    _filemgr_save_warmup(file, file->filename);
+    _filemgr_free_func(h);
+}
+
 void filemgr_shutdown()
 {
     if (filemgr_initialized) {
         spin_lock(&initial_lock);
 
-        hash_free_active(&hash, _filemgr_free_func);
+        hash_free_active(&hash, _filemgr_shutdown_func);
         if (global_config.ncacheblock > 0) {
             bcache_shutdown();
         }
@@ -1089,19 +1313,43 @@ bid_t filemgr_alloc_multiple_cond(struct filemgr *file, bid_t nextbid, int nbloc
 }
 
 #ifdef __CRC32
+INLINE uint32_t _filemgr_blk_crc(uint8_t crc_type, void *buf, size_t len)
+{
+    if (crc_type == BLK_CRC_CRC32C) {
+        return crc32c(buf, len, 0);
+    }
+    return chksum(buf, len);
+}
+
 INLINE void _filemgr_crc32_check(struct filemgr *file, void *buf)
 {
     if ( *((uint8_t*)buf + file->blocksize-1) == BLK_MARKER_BNODE ) {
         uint32_t crc_file, crc;
+        uint8_t crc_type;
         memcpy(&crc_file, (uint8_t *) buf + BTREE_CRC_OFFSET, sizeof(crc_file));
         crc_file = _endian_decode(crc_file);
+        crc_type = *((uint8_t *) buf + BTREE_CRC_OFFSET + sizeof(crc_file));
         memset((uint8_t *) buf + BTREE_CRC_OFFSET, 0xff, BTREE_CRC_FIELD_LEN);
-        crc = chksum(buf, file->blocksize);
+        crc = _filemgr_blk_crc(crc_type, buf, file->blocksize);
         assert(crc == crc_file);
     }
 }
 #endif
 
+void filemgr_set_blk_crc(struct filemgr *file, void *buf)
+{
+#ifdef __CRC32
+    uint8_t crc_type = file->blk_crc_type;
+    memset((uint8_t *)buf + BTREE_CRC_OFFSET, 0xff, BTREE_CRC_FIELD_LEN);
+    uint32_t crc = _filemgr_blk_crc(crc_type, buf, file->blocksize);
+    crc = _endian_encode(crc);
+    memcpy((uint8_t *)buf + BTREE_CRC_OFFSET, &crc, sizeof(crc));
+    if (crc_type != BLK_CRC_LEGACY) {
+        *((uint8_t *)buf + BTREE_CRC_OFFSET + sizeof(crc)) = crc_type;
+    }
+#endif
+}
+
 void filemgr_invalidate_block(struct filemgr *file, bid_t bid)
 {
     if (global_config.ncacheblock > 0) {
@@ -1131,6 +1379,7 @@ fdb_status filemgr_read(struct filemgr *file, bid_t bid, void *buf,
         if (filemgr_is_writable(file, bid)) {
 #ifdef __FILEMGR_DATA_PARTIAL_LOCK
             plock_entry = plock_lock(&file->plock, &bid, &is_writer);
+            LOCKPROF_ACQUIRED(FDB_LOCK_PLOCK);
 #elif defined(__FILEMGR_DATA_MUTEX_LOCK)
             mutex_lock(&file->data_mutex[lock_no]);
 #else
@@ -1143,7 +1392,11 @@ fdb_status filemgr_read(struct filemgr *file, bid_t bid, void *buf,
         if (r == 0) {
             // cache miss
             // if normal file, just read a block
+            uint64_t begin = get_monotonic_ts();
+            TRACE_BEGIN(FDB_TRACE_READ_MISS);
             r = file->ops->pread(file->fd, buf, file->blocksize, pos);
+            io_stats_add_read(file, file->blocksize);
+            TRACE_END(FDB_TRACE_READ_MISS);
             if (r != file->blocksize) {
                 _log_errno_str(file->ops, log_callback,
                                (fdb_status) r, "READ", file->filename);
@@ -1161,6 +1414,8 @@ fdb_status filemgr_read(struct filemgr *file, bid_t bid, void *buf,
 #ifdef __CRC32
             _filemgr_crc32_check(file, buf);
 #endif
+            latency_update(file, FDB_LATENCY_READ_MISS, begin);
+            slowlog_phase_end(SLOWLOG_CACHE_MISS, begin);
             r = bcache_write(file, bid, buf, BCACHE_REQ_CLEAN);
             if (r != global_config.blocksize) {
                 _log_errno_str(file->ops, log_callback,
@@ -1178,7 +1433,11 @@ fdb_status filemgr_read(struct filemgr *file, bid_t bid, void *buf,
 #endif //__FILEMGR_DATA_PARTIAL_LOCK
         }
     } else {
+        uint64_t begin = get_monotonic_ts();
+        TRACE_BEGIN(FDB_TRACE_READ_MISS);
         r = file->ops->pread(file->fd, buf, file->blocksize, pos);
+        io_stats_add_read(file, file->blocksize);
+        TRACE_END(FDB_TRACE_READ_MISS);
         if (r != file->blocksize) {
             _log_errno_str(file->ops, log_callback, (fdb_status) r, "READ",
                            file->filename);
@@ -1188,10 +1447,100 @@ fdb_status filemgr_read(struct filemgr *file, bid_t bid, void *buf,
 #ifdef __CRC32
         _filemgr_crc32_check(file, buf);
 #endif
+        latency_update(file, FDB_LATENCY_READ_MISS, begin);
+        slowlog_phase_end(SLOWLOG_CACHE_MISS, begin);
     }
     return FDB_RESULT_SUCCESS;
 }
 
+// read a committed block from the memory mapping of the file, bypassing the
+// block cache; other blocks are read by filemgr_read()
+fdb_status filemgr_read_mapped(struct filemgr *file, bid_t bid, void *buf,
+                               err_log_callback *log_callback)
+{
+    void *addr = filemgr_get_mapped_block(file, bid);
+    if (addr) {
+        memcpy(buf, addr, file->blocksize);
+#ifdef __CRC32
+        _filemgr_crc32_check(file, buf);
+#endif
+        return FDB_RESULT_SUCCESS;
+    }
+    return filemgr_read(file, bid, buf, log_callback);
+}
+
+// read the given blocks into the block cache in advance.
+// 'bids' should be sorted in ascending order. blocks that are already cached
+// or not committed yet are skipped, and each run of consecutive missing blocks
+// is read by a single pread.
+void filemgr_readahead(struct filemgr *file, bid_t *bids, size_t n,
+                       err_log_callback *log_callback)
+{
+    size_t i, j, nblocks = 0;
+    ssize_t r;
+    uint8_t *buf;
+    uint64_t last_commit;
+    bid_t begin = BLK_NOT_FOUND;
+
+    if (global_config.ncacheblock == 0 || n == 0) {
+        // nothing to do without block cache
+        return;
+    }
+
+    spin_lock(&file->lock);
+    last_commit = file->last_commit;
+    spin_unlock(&file->lock);
+
+    buf = (uint8_t *)malloc(file->blocksize * FILEMGR_READAHEAD_BATCH);
+
+    for (i=0; i<=n; ++i) {
+        if (i < n) {
+            if (i > 0 && bids[i] == bids[i-1]) {
+                continue; // duplicate
+            }
+            if ((bids[i] + 1) * file->blocksize > last_commit ||
+                bcache_exists(file, bids[i])) {
+                // not committed yet, or already cached
+                continue;
+            }
+            if (nblocks > 0 && nblocks < FILEMGR_READAHEAD_BATCH &&
+                begin + nblocks == bids[i]) {
+                // extend the current run
+                nblocks++;
+                continue;
+            }
+        }
+
+        if (nblocks > 0) {
+            // read the current run at once
+            uint64_t ts = slowlog_phase_begin();
+            r = file->ops->pread(file->fd, buf, file->blocksize * nblocks,
+                                 begin * file->blocksize);
+            io_stats_add_read(file, file->blocksize * nblocks);
+            slowlog_phase_end(SLOWLOG_CACHE_MISS, ts);
+            if (r != (ssize_t)(file->blocksize * nblocks)) {
+                _log_errno_str(file->ops, log_callback,
+                               (fdb_status) r, "READ", file->filename);
+                break;
+            }
+            for (j=0; j<nblocks; ++j) {
+#ifdef __CRC32
+                _filemgr_crc32_check(file, buf + j * file->blocksize);
+#endif
+                bcache_write(file, begin + j, buf + j * file->blocksize,
+                             BCACHE_REQ_CLEAN);
+            }
+        }
+        if (i < n) {
+            // start a new run
+            begin = bids[i];
+            nblocks = 1;
+        }
+    }
+
+    free(buf);
+}
+
 fdb_status filemgr_write_offset(struct filemgr *file, bid_t bid,
                                 uint64_t offset, uint64_t len, void *buf,
                                 err_log_callback *log_callback)
@@ -1236,6 +1585,7 @@ fdb_status filemgr_write_offset(struct filemgr *file, bid_t bid,
 #ifdef __FILEMGR_DATA_PARTIAL_LOCK
                     bid_t is_writer = 1;
                     plock_entry = plock_lock(&file->plock, &bid, &is_writer);
+                    LOCKPROF_ACQUIRED(FDB_LOCK_PLOCK);
 #elif defined(__FILEMGR_DATA_MUTEX_LOCK)
                     mutex_lock(&file->data_mutex[lock_no]);
 #else
@@ -1245,6 +1595,7 @@ fdb_status filemgr_write_offset(struct filemgr *file, bid_t bid,
 
                     r = file->ops->pread(file->fd, _buf, file->blocksize,
                                          bid * file->blocksize);
+                    io_stats_add_read(file, file->blocksize);
                     if (r != file->blocksize) {
                         _filemgr_release_temp_buf(_buf);
                         _log_errno_str(file->ops, log_callback, (fdb_status) r,
@@ -1280,10 +1631,7 @@ fdb_status filemgr_write_offset(struct filemgr *file, bid_t bid,
         if (len == file->blocksize) {
             uint8_t marker = *((uint8_t*)buf + file->blocksize - 1);
             if (marker == BLK_MARKER_BNODE) {
-                memset((uint8_t *)buf + BTREE_CRC_OFFSET, 0xff, BTREE_CRC_FIELD_LEN);
-                uint32_t crc32 = chksum(buf, file->blocksize);
-                crc32 = _endian_encode(crc32);
-                memcpy((uint8_t *)buf + BTREE_CRC_OFFSET, &crc32, sizeof(crc32));
+                filemgr_set_blk_crc(file, buf);
             }
         }
 #endif
@@ -1293,6 +1641,7 @@ fdb_status filemgr_write_offset(struct filemgr *file, bid_t bid,
         if (r != len) {
             return FDB_RESULT_READ_FAIL;
         }
+        io_stats_add_write(file, buf, len);
     }
     return FDB_RESULT_SUCCESS;
 }
@@ -1377,6 +1726,7 @@ fdb_status filemgr_commit(struct filemgr *file,
             spin_unlock(&file->lock);
             return FDB_RESULT_WRITE_FAIL;
         }
+        io_stats_add_write(file, buf, file->blocksize);
         file->header.bid = file->pos / file->blocksize;
         file->pos += file->blocksize;
 
@@ -1391,7 +1741,13 @@ fdb_status filemgr_commit(struct filemgr *file,
     spin_unlock(&file->lock);
 
     if (file->fflags & FILEMGR_SYNC) {
+        uint64_t begin = get_monotonic_ts();
+        TRACE_BEGIN(FDB_TRACE_FSYNC);
         result = file->ops->fsync(file->fd);
+        TRACE_END(FDB_TRACE_FSYNC);
+        latency_update(file, FDB_LATENCY_FSYNC, begin);
+        slowlog_phase_end(SLOWLOG_FSYNC, begin);
+        io_stats_add_sync(file);
         _log_errno_str(file->ops, log_callback, (fdb_status)result, "FSYNC", file->filename);
     }
     return (fdb_status) result;
@@ -1410,7 +1766,13 @@ fdb_status filemgr_sync(struct filemgr *file, err_log_callback *log_callback)
     }
 
     if (file->fflags & FILEMGR_SYNC) {
+        uint64_t begin = get_monotonic_ts();
+        TRACE_BEGIN(FDB_TRACE_FSYNC);
         int rv = file->ops->fsync(file->fd);
+        TRACE_END(FDB_TRACE_FSYNC);
+        latency_update(file, FDB_LATENCY_FSYNC, begin);
+        slowlog_phase_end(SLOWLOG_FSYNC, begin);
+        io_stats_add_sync(file);
         _log_errno_str(file->ops, log_callback, (fdb_status)rv, "FSYNC", file->filename);
         return (fdb_status) rv;
     }
@@ -1460,6 +1822,7 @@ void filemgr_remove_pending(struct filemgr *old_file, struct filemgr *new_file)
         // immediatly remove
         spin_unlock(&old_file->lock);
         remove(old_file->filename);
+        warmup_remove(old_file->filename);
         filemgr_remove_file(old_file);
     }
 }
@@ -1529,12 +1892,15 @@ fdb_status filemgr_destroy_file(char *filename,
         if (remove(filename)) {
             status = FDB_RESULT_FILE_REMOVE_FAIL;
         }
+        warmup_remove(filename);
     } else { // file not in memory, read on-disk to destroy older versions..
         file = (struct filemgr *)alca(struct filemgr, 1);
         file->filename = filename;
         file->ops = get_filemgr_ops();
         file->fd = file->ops->open(file->filename, O_RDWR, 0666);
         file->blocksize = global_config.blocksize;
+        file->io_stats = NULL;
+        file->mmap = NULL;
         if (file->fd < 0) {
             if (file->fd != FDB_RESULT_NO_SUCH_FILE) {
                 if (!destroy_file_set) { // top level or non-recursive call
@@ -1553,15 +1919,16 @@ fdb_status filemgr_destroy_file(char *filename,
                 file->pos = offset;
                 _filemgr_read_header(file);
                 if (file->header.data) {
-                    uint16_t *new_filename_len_ptr = (uint16_t *)((char *)
-                                                     file->header.data + 64);
-                    uint16_t new_filename_len =
-                                      _endian_decode(*new_filename_len_ptr);
-                    uint16_t *old_filename_len_ptr = (uint16_t *)((char *)
-                                                     file->header.data + 66);
-                    uint16_t old_filename_len =
-                                      _endian_decode(*old_filename_len_ptr);
-                    old_filename = (char *)file->header.data + 68
+                    uint8_t *ptr = (uint8_t *)file->header.data +
+                                   FDB_HEADER_FILENAME_OFFSET;
+                    uint16_t new_filename_len;
+                    uint16_t old_filename_len;
+                    memcpy(&new_filename_len, ptr, sizeof(uint16_t));
+                    new_filename_len = _endian_decode(new_filename_len);
+                    memcpy(&old_filename_len, ptr + sizeof(uint16_t),
+                           sizeof(uint16_t));
+                    old_filename_len = _endian_decode(old_filename_len);
+                    old_filename = (char *)ptr + sizeof(uint16_t) * 2
                                    + new_filename_len;
                     if (old_filename_len) {
                         status = filemgr_destroy_file(old_filename, config,
@@ -1573,6 +1940,7 @@ fdb_status filemgr_destroy_file(char *filename,
                     if (remove(filename)) {
                         status = FDB_RESULT_FILE_REMOVE_FAIL;
                     }
+                    warmup_remove(filename);
                 }
             }
             file->ops->close(file->fd);
@@ -1625,6 +1993,18 @@ void filemgr_set_in_place_compaction(struct filemgr *file,
     spin_unlock(&file->lock);
 }
 
+uint8_t filemgr_get_blk_crc_type(struct filemgr *file)
+{
+    return file->blk_crc_type;
+}
+
+void filemgr_set_blk_crc_type(struct filemgr *file, uint8_t crc_type)
+{
+    spin_lock(&file->lock);
+    file->blk_crc_type = crc_type;
+    spin_unlock(&file->lock);
+}
+
 void filemgr_mutex_openlock(struct filemgr_config *config)
 {
     filemgr_init(config);
@@ -1639,11 +2019,13 @@ void filemgr_mutex_openunlock(void)
 
 void filemgr_mutex_lock(struct filemgr *file)
 {
+    uint64_t begin = slowlog_phase_begin();
 #ifdef __FILEMGR_MUTEX_LOCK
-    mutex_lock(&file->mutex);
+    LOCKPROF_MUTEX_LOCK(FDB_LOCK_FILEMGR_MUTEX, &file->mutex);
 #else
-    spin_lock(&file->mutex);
+    LOCKPROF_SPIN_LOCK(FDB_LOCK_FILEMGR_MUTEX, &file->mutex);
 #endif
+    slowlog_phase_end(SLOWLOG_LOCK_WAIT, begin);
 }
 
 void filemgr_mutex_unlock(struct filemgr *file)
@@ -42,6 +42,7 @@ struct filemgr_config {
 #define FILEMGR_READONLY 0x02
 #define FILEMGR_ROLLBACK_IN_PROG 0x04
 #define FILEMGR_CREATE 0x08
+#define FILEMGR_CACHE_WARMUP 0x10
     uint64_t prefetch_duration;
 };
 
@@ -55,6 +56,10 @@ struct filemgr_ops {
     int (*fdatasync)(int fd);
     int (*fsync)(int fd);
     void (*get_errno_str)(char *buf, size_t size);
+    // map the first 'len' bytes of the file for reading (NULL if failed or
+    // not supported), and unmap them
+    void *(*mmap)(int fd, size_t len);
+    int (*munmap)(void *addr, size_t len);
 };
 
 struct filemgr_buffer{
@@ -88,6 +93,18 @@ enum {
 struct wal;
 struct fnamedic_item;
 struct kvs_header;
+struct range_del_list;
+struct bloom_filter;
+struct latency_stats;
+struct io_stats;
+
+// memory mapping of a file
+struct filemgr_mmap {
+    uint8_t *addr;
+    uint64_t len;
+    struct filemgr_mmap *prev;
+};
+
 struct filemgr {
     char *filename; // Current file name.
     uint8_t ref_count;
@@ -110,11 +127,26 @@ struct filemgr {
     bool in_place_compaction;
     struct kvs_header *kv_header;
     void (*free_kv_header)(struct filemgr *file); // callback function
+    struct range_del_list *range_del;
+    void (*free_range_del)(struct filemgr *file); // callback function
+    struct bloom_filter *bloom;
+    void (*free_bloom)(struct filemgr *file); // callback function
+    // checksum algorithm for b-tree node blocks written to this file
+    uint8_t blk_crc_type;
+    struct latency_stats *latency;
+    struct io_stats *io_stats;
 
     // variables related to prefetching
     volatile filemgr_prefetch_status_t prefetch_status;
     thread_t prefetch_tid;
 
+    // memory mapping that committed blocks are read from by the handles
+    // opened with 'mmap_readonly'.
+    // replaced mappings are kept in 'mmap_retired' until the file is freed,
+    // since docio handles may still point into them.
+    struct filemgr_mmap *mmap;
+    struct filemgr_mmap *mmap_retired;
+
     // spin lock for small region
     spin_t lock;
 
@@ -180,7 +212,21 @@ void filemgr_invalidate_block(struct filemgr *file, bid_t bid);
 fdb_status filemgr_read(struct filemgr *file,
                   bid_t bid, void *buf,
                   err_log_callback *log_callback);
-
+void *filemgr_get_mapped_block(struct filemgr *file, bid_t bid);
+fdb_status filemgr_read_mapped(struct filemgr *file, bid_t bid, void *buf,
+                               err_log_callback *log_callback);
+
+void filemgr_readahead(struct filemgr *file, bid_t *bids, size_t n,
+                       err_log_callback *log_callback);
+
+typedef void filemgr_prefetch_func(struct filemgr *file, void *aux);
+// run FUNC in the prefetch thread of the file instead of prefetching the tail
+// of the file. returns false (and FUNC is not called) if another prefetch or
+// cache warm-up is in progress. FUNC should check filemgr_prefetch_aborted()
+// regularly, since freeing the file waits for the thread to finish.
+bool filemgr_prefetch_custom(struct filemgr *file,
+                             filemgr_prefetch_func *func, void *aux);
+bool filemgr_prefetch_aborted(struct filemgr *file);
 fdb_status filemgr_write_offset(struct filemgr *file, bid_t bid, uint64_t offset,
                           uint64_t len, void *buf, err_log_callback *log_callback);
 fdb_status filemgr_write(struct filemgr *file, bid_t bid, void *buf,
@@ -211,6 +257,10 @@ void filemgr_set_rollback(struct filemgr *file, uint8_t new_val);
 void filemgr_set_in_place_compaction(struct filemgr *file,
                                      bool in_place_compaction);
 
+uint8_t filemgr_get_blk_crc_type(struct filemgr *file);
+void filemgr_set_blk_crc_type(struct filemgr *file, uint8_t crc_type);
+void filemgr_set_blk_crc(struct filemgr *file, void *buf);
+
 void filemgr_mutex_openlock(struct filemgr_config *config);
 void filemgr_mutex_openunlock(void);
 void filemgr_mutex_lock(struct filemgr *file);
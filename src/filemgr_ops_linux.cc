@@ -17,6 +17,7 @@
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <unistd.h>
 #include <stdint.h>
 #include <fcntl.h>
@@ -153,6 +154,24 @@ void _filemgr_linux_get_errno_str(char *buf, size_t size) {
     }
 }
 
+void *_filemgr_linux_mmap(int fd, size_t len)
+{
+    // pages beyond the end of the file become valid as the file grows
+    void *addr = mmap(NULL, len, PROT_READ, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+        return NULL;
+    }
+    return addr;
+}
+
+int _filemgr_linux_munmap(void *addr, size_t len)
+{
+    if (munmap(addr, len) < 0) {
+        return FDB_RESULT_CLOSE_FAIL;
+    }
+    return FDB_RESULT_SUCCESS;
+}
+
 struct filemgr_ops linux_ops = {
     _filemgr_linux_open,
     _filemgr_linux_pwrite,
@@ -162,7 +181,9 @@ struct filemgr_ops linux_ops = {
     _filemgr_linux_file_size,
     _filemgr_linux_fdatasync,
     _filemgr_linux_fsync,
-    _filemgr_linux_get_errno_str
+    _filemgr_linux_get_errno_str,
+    _filemgr_linux_mmap,
+    _filemgr_linux_munmap
 };
 
 struct filemgr_ops * get_linux_filemgr_ops()
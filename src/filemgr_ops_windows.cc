@@ -193,6 +193,17 @@ void _filemgr_win_get_errno_str(char *buf, size_t size)
     LocalFree(win_msg);
 }
 
+void *_filemgr_win_mmap(int fd, size_t len)
+{
+    // not supported .. committed blocks are read by pread
+    return NULL;
+}
+
+int _filemgr_win_munmap(void *addr, size_t len)
+{
+    return FDB_RESULT_SUCCESS;
+}
+
 struct filemgr_ops win_ops = {
     _filemgr_win_open,
     _filemgr_win_pwrite,
@@ -202,7 +213,9 @@ struct filemgr_ops win_ops = {
     _filemgr_win_file_size,
     _filemgr_win_fdatasync,
     _filemgr_win_fsync,
-    _filemgr_win_get_errno_str
+    _filemgr_win_get_errno_str,
+    _filemgr_win_mmap,
+    _filemgr_win_munmap
 };
 
 struct filemgr_ops * get_win_filemgr_ops()
@@ -38,6 +38,15 @@
 #include "common.h"
 #include "wal.h"
 #include "snapshot.h"
+#include "range_del.h"
+#include "bloom.h"
+#include "latency.h"
+#include "io_stats.h"
+#include "trace.h"
+#include "slowlog.h"
+#include "lockprof.h"
+#include "prefetch.h"
+#include "blockcache.h"
 #include "filemgr_ops.h"
 #include "configuration.h"
 #include "internal_types.h"
@@ -64,9 +73,6 @@ static volatile unsigned int initial_lock_status = 0;
 static spin_t initial_lock;
 #endif
 
-static fdb_status _fdb_wal_snapshot_func(void *handle, fdb_doc *doc,
-                                         uint64_t offset);
-
 INLINE int _cmp_uint64_t_endian_safe(void *key1, void *key2, void *aux)
 {
     (void) aux;
@@ -149,6 +155,8 @@ void fdb_fetch_header(void *header_buf,
                       uint64_t *last_wal_flush_hdr_bid,
                       uint64_t *kv_info_offset,
                       uint64_t *header_flags,
+                      uint64_t *range_del_offset,
+                      uint64_t *bloom_offset,
                       char **new_filename,
                       char **old_filename)
 {
@@ -200,9 +208,24 @@ void fdb_fetch_header(void *header_buf,
     offset += new_filename_len;
     if (old_filename && old_filename_len) {
         *old_filename = (char *) malloc(old_filename_len);
-        seq_memcpy(*old_filename,
-                   (uint8_t *)header_buf + offset,
-                   old_filename_len, offset);
+        memcpy(*old_filename, (uint8_t *)header_buf + offset,
+               old_filename_len);
+    }
+    offset += old_filename_len;
+
+    // optional fields appended after the file names;
+    // headers written before they were introduced don't carry them.
+    *range_del_offset = BLK_NOT_FOUND;
+    if (*header_flags & FDB_FLAG_RANGE_DEL) {
+        seq_memcpy(range_del_offset, (uint8_t *)header_buf + offset,
+                   sizeof(uint64_t), offset);
+        *range_del_offset = _endian_decode(*range_del_offset);
+    }
+    *bloom_offset = BLK_NOT_FOUND;
+    if (*header_flags & FDB_FLAG_BLOOM) {
+        seq_memcpy(bloom_offset, (uint8_t *)header_buf + offset,
+                   sizeof(uint64_t), offset);
+        *bloom_offset = _endian_decode(*bloom_offset);
     }
 }
 
@@ -515,7 +538,8 @@ INLINE fdb_status _fdb_recover_compaction(fdb_kvs_handle *handle,
                         free(doc.body);
                         offset = _offset;
                     } else {
-                        if (doc.length.flag & DOCIO_SYSTEM) {
+                        if ((doc.length.flag & DOCIO_SYSTEM) &&
+                            !strcmp((char*)doc.key, "KV_header")) {
                             // KV instances header
                             // free existing KV header of handle->file
                             if (handle->file->kv_header) {
@@ -852,9 +876,7 @@ fdb_status fdb_snapshot_open(fdb_kvs_handle *handle_in, fdb_kvs_handle **ptr_han
 
     if (fs == FDB_RESULT_SUCCESS) {
         if (seqnum == FDB_SNAPSHOT_INMEM) {
-            snap_init(handle->shandle, handle);
-            wal_snapshot(handle->file, (void *)handle->shandle,
-                         handle_in->txn, _fdb_wal_snapshot_func);
+            snap_init_inmem(handle->shandle, handle, handle_in->txn);
         }
         *ptr_handle = handle;
     } else {
@@ -937,6 +959,8 @@ fdb_status fdb_rollback(fdb_kvs_handle **handle_ptr, fdb_seqnum_t seqnum)
         filemgr_mutex_lock(handle_in->file);
         old_seqnum = filemgr_get_seqnum(handle_in->file);
         filemgr_set_seqnum(handle_in->file, seqnum);
+        // discard range deletions performed after the rollback point
+        range_del_rollback(handle_in->file, NULL, 0, seqnum);
         filemgr_mutex_unlock(handle_in->file);
 
         fs = _fdb_commit(handle, FDB_COMMIT_NORMAL);
@@ -963,6 +987,34 @@ fdb_status fdb_rollback(fdb_kvs_handle **handle_ptr, fdb_seqnum_t seqnum)
     return fs;
 }
 
+// whether the handle reads committed blocks from the memory mapping of the
+// file (a per-handle choice; other handles of the file use the block cache)
+INLINE bool _fdb_use_mmap(const fdb_config *config)
+{
+    return config->mmap_readonly && (config->flags & FDB_OPEN_FLAG_RDONLY);
+}
+
+// node layout of the index b-trees created by the handle
+INLINE uint8_t _fdb_btree_node_flag(const fdb_config *config)
+{
+    return (config->node_format == FDB_NODE_FORMAT_V2)?
+           (BNODE_MASK_SEPARATED):(0x0);
+}
+
+// node layout of the HB+trie leaf b-trees (custom compare functions)
+INLINE uint8_t _fdb_btree_leaf_node_flag(const fdb_config *config)
+{
+    return (config->node_format == FDB_NODE_FORMAT_V2)?
+           (BNODE_MASK_PREFIX):(0x0);
+}
+
+// checksum algorithm of the b-tree node blocks of a new file
+INLINE uint8_t _fdb_blk_crc_type(const fdb_config *config)
+{
+    return (config->node_format == FDB_NODE_FORMAT_V2)?
+           (BLK_CRC_CRC32C):(BLK_CRC_LEGACY);
+}
+
 static void _fdb_init_file_config(const fdb_config *config,
                                   struct filemgr_config *fconfig) {
     fconfig->blocksize = config->blocksize;
@@ -978,6 +1030,9 @@ static void _fdb_init_file_config(const fdb_config *config,
     if (!(config->durability_opt & FDB_DRB_ASYNC)) {
         fconfig->options |= FILEMGR_SYNC;
     }
+    if (config->cache_warmup && !_fdb_use_mmap(config)) {
+        fconfig->options |= FILEMGR_CACHE_WARMUP;
+    }
 
     fconfig->flag = 0x0;
     if (config->durability_opt & FDB_DRB_ODIRECT) {
@@ -985,6 +1040,11 @@ static void _fdb_init_file_config(const fdb_config *config,
     }
 
     fconfig->prefetch_duration = config->prefetch_duration;
+    if (config->prefetch_mode != FDB_PREFETCH_TAIL || _fdb_use_mmap(config)) {
+        // index nodes are loaded by _fdb_open() instead, or
+        // the OS page cache is the only cache of the mapped blocks
+        fconfig->prefetch_duration = 0;
+    }
 }
 
 fdb_status _fdb_open(fdb_kvs_handle *handle,
@@ -1002,6 +1062,9 @@ fdb_status _fdb_open(fdb_kvs_handle *handle,
     uint64_t last_wal_flush_hdr_bid = BLK_NOT_FOUND;
     uint64_t kv_info_offset = BLK_NOT_FOUND;
     uint64_t header_flags = 0;
+    uint64_t range_del_offset = BLK_NOT_FOUND;
+    uint64_t bloom_offset = BLK_NOT_FOUND;
+    uint64_t dummy64;
     uint8_t header_buf[FDB_BLOCKSIZE];
     char *compacted_filename = NULL;
     char *prev_filename = NULL;
@@ -1053,7 +1116,8 @@ fdb_status _fdb_open(fdb_kvs_handle *handle,
         fdb_fetch_header(header_buf, &trie_root_bid,
                          &seq_root_bid, &ndocs, &nlivenodes,
                          &datasize, &last_wal_flush_hdr_bid, &kv_info_offset,
-                         &header_flags, &compacted_filename, &prev_filename);
+                         &header_flags, &range_del_offset, &bloom_offset,
+                         &compacted_filename, &prev_filename);
         // use existing setting for seqtree_opt
         if (header_flags & FDB_FLAG_SEQTREE_USE) {
             seqtree_opt = FDB_SEQTREE_USE;
@@ -1073,12 +1137,19 @@ fdb_status _fdb_open(fdb_kvs_handle *handle,
         if (header_flags & FDB_FLAG_ROOT_CUSTOM_CMP) {
             handle->fhandle->flags |= FHANDLE_ROOT_CUSTOM_CMP;
         }
+        // keep using the checksum algorithm that the file was created with
+        filemgr_set_blk_crc_type(handle->file,
+                                 (header_flags & FDB_FLAG_BLK_CRC32C)?
+                                 (BLK_CRC_CRC32C):(BLK_CRC_LEGACY));
         // use existing setting for multi KV instance mode
         if (kv_info_offset == BLK_NOT_FOUND) {
             multi_kv_instances = false;
         } else {
             multi_kv_instances = true;
         }
+    } else {
+        // new file
+        filemgr_set_blk_crc_type(handle->file, _fdb_blk_crc_type(config));
     }
 
     handle->config = *config;
@@ -1087,10 +1158,28 @@ fdb_status _fdb_open(fdb_kvs_handle *handle,
 
     handle->dhandle = (struct docio_handle *)calloc(1, sizeof(struct docio_handle));
     handle->dhandle->log_callback = &handle->log_callback;
+    handle->dhandle->use_mmap = _fdb_use_mmap(config);
     handle->new_file = NULL;
     handle->new_dhandle = NULL;
     docio_init(handle->dhandle, handle->file, config->compress_document_body);
 
+    if (handle->file->range_del == NULL) {
+        // range tombstones are not loaded yet .. read & import
+        range_del_read(handle->file, handle->dhandle, range_del_offset);
+    }
+
+    if (handle->file->bloom == NULL) {
+        if (bloom_offset != BLK_NOT_FOUND) {
+            // Bloom filter is not loaded yet .. read & import
+            bloom_read(handle->file, handle->dhandle, bloom_offset);
+        } else if (header_len == 0 && filemgr_get_pos(handle->file) == 0 &&
+                   config->bloom_filter_bits_per_key) {
+            // filter can be created only for an empty file,
+            // since it should contain all keys in the file
+            bloom_create(handle->file, config->bloom_filter_bits_per_key, 0);
+        }
+    }
+
     if (handle->shandle && handle->max_seqnum == FDB_SNAPSHOT_INMEM) {
         handle->max_seqnum = seqnum;
         filemgr_mutex_unlock(handle->file);
@@ -1114,6 +1203,7 @@ fdb_status _fdb_open(fdb_kvs_handle *handle,
                                      &seq_root_bid, &ndocs, &nlivenodes,
                                      &datasize, &last_wal_flush_hdr_bid,
                                      &kv_info_offset, &header_flags,
+                                     &dummy64, &dummy64,
                                      &compacted_filename, NULL);
                     handle->last_hdr_bid = hdr_bid;
 
@@ -1183,6 +1273,7 @@ fdb_status _fdb_open(fdb_kvs_handle *handle,
     handle->bhandle = (struct btreeblk_handle *)
                       calloc(1, sizeof(struct btreeblk_handle));
     handle->bhandle->log_callback = &handle->log_callback;
+    handle->bhandle->use_mmap = _fdb_use_mmap(config);
 
     handle->dirty_updates = 0;
 
@@ -1254,6 +1345,8 @@ fdb_status _fdb_open(fdb_kvs_handle *handle,
     handle->trie->aux = NULL;
     hbtrie_set_leaf_height_limit(handle->trie, 0xff);
     hbtrie_set_leaf_cmp(handle->trie, _fdb_custom_cmp_wrap);
+    hbtrie_set_node_flag(handle->trie, _fdb_btree_node_flag(config),
+                         _fdb_btree_leaf_node_flag(config));
 
     if (handle->kvs) {
         hbtrie_set_map_function(handle->trie, fdb_kvs_find_cmp_chunk);
@@ -1270,12 +1363,16 @@ fdb_status _fdb_open(fdb_kvs_handle *handle,
                         (void *)handle->bhandle, handle->btreeblkops,
                         (void *)handle->dhandle, _fdb_readseq_wrap);
             handle->seqtrie->aux = NULL;
+            hbtrie_set_node_flag(handle->seqtrie, _fdb_btree_node_flag(config),
+                                 _fdb_btree_leaf_node_flag(config));
 
         } else {
             // single KV instance mode .. normal B+tree
             struct btree_kv_ops *seq_kv_ops =
                 (struct btree_kv_ops *)malloc(sizeof(struct btree_kv_ops));
             seq_kv_ops = btree_kv_get_kb64_vb64(seq_kv_ops);
+            // same order to the binary comparison, so that 'find_entry'
+            // of the ops is still valid
             seq_kv_ops->cmp = _cmp_uint64_t_endian_safe;
 
             handle->seqtree = (struct btree*)malloc(sizeof(struct btree));
@@ -1283,7 +1380,8 @@ fdb_status _fdb_open(fdb_kvs_handle *handle,
                 btree_init(handle->seqtree, (void *)handle->bhandle,
                            handle->btreeblkops, seq_kv_ops,
                            handle->config.blocksize, sizeof(fdb_seqnum_t),
-                           OFFSET_SIZE, 0x0, NULL);
+                           OFFSET_SIZE,
+                           _fdb_btree_node_flag(&handle->config), NULL);
              }else{
                  btree_init_from_bid(handle->seqtree, (void *)handle->bhandle,
                                      handle->btreeblkops, seq_kv_ops,
@@ -1334,6 +1432,23 @@ fdb_status _fdb_open(fdb_kvs_handle *handle,
         }
     }
 
+    if (config->prefetch_mode != FDB_PREFETCH_TAIL && !handle->shandle &&
+        !_fdb_use_mmap(config) && filemgr_get_ref_count(handle->file) == 1) {
+        // first open of the file .. load the index nodes in the background
+        struct prefetch_index_config pconfig;
+        pconfig.chunksize = config->chunksize;
+        pconfig.trie_root_bid = trie_root_bid;
+        pconfig.seq_root_bid = BLK_NOT_FOUND;
+        if (config->prefetch_mode == FDB_PREFETCH_INDEX_SEQTREE &&
+            handle->config.seqtree_opt == FDB_SEQTREE_USE) {
+            pconfig.seq_root_bid = seq_root_bid;
+        }
+        pconfig.seqtrie = handle->config.multi_kv_instances;
+        pconfig.max_blocks = config->buffercache_size / config->blocksize *
+                             config->prefetch_cache_ratio / 100;
+        prefetch_index_start(handle->file, &pconfig);
+    }
+
     btreeblk_end(handle->bhandle);
 
     // do not register read-only handles
@@ -1502,11 +1617,6 @@ INLINE uint64_t _fdb_wal_get_old_offset(void *voidhandle,
     return old_offset;
 }
 
-INLINE fdb_status _fdb_wal_snapshot_func(void *handle, fdb_doc *doc,
-                                         uint64_t offset) {
-    return snap_insert((struct snap_handle *)handle, doc, offset);
-}
-
 INLINE void _fdb_wal_flush_func(void *voidhandle, struct wal_item *item)
 {
     hbtrie_result hr;
@@ -1543,6 +1653,7 @@ INLINE void _fdb_wal_flush_func(void *voidhandle, struct wal_item *item)
                            item->header->keylen,
                            (void *)&_offset,
                            (void *)&old_offset);
+        bloom_add(file, item->header->key, item->header->keylen);
 
         btreeblk_end(handle->bhandle);
         old_offset = _endian_decode(old_offset);
@@ -1636,6 +1747,7 @@ void fdb_sync_db_header(fdb_kvs_handle *handle)
                              &dummy64, &dummy64,
                              &dummy64, &handle->last_wal_flush_hdr_bid,
                              &handle->kv_info_offset, &header_flags,
+                             &dummy64, &dummy64,
                              &compacted_filename, &prev_filename);
 
             if (handle->dirty_updates) {
@@ -1679,7 +1791,7 @@ void fdb_check_file_reopen(fdb_kvs_handle *handle)
     // check whether the compaction is done
     if (filemgr_get_file_status(handle->file) == FILE_REMOVED_PENDING) {
         uint64_t ndocs, datasize, nlivenodes, last_wal_flush_hdr_bid;
-        uint64_t kv_info_offset, header_flags;
+        uint64_t kv_info_offset, header_flags, range_del_offset, bloom_offset;
         size_t header_len;
         char *new_filename;
         uint8_t *buf = alca(uint8_t, handle->config.blocksize);
@@ -1712,12 +1824,14 @@ void fdb_check_file_reopen(fdb_kvs_handle *handle)
                              &trie_root_bid, &seq_root_bid,
                              &ndocs, &nlivenodes, &datasize, &last_wal_flush_hdr_bid,
                              &kv_info_offset, &header_flags,
+                             &range_del_offset, &bloom_offset,
                              &new_filename, NULL);
 
             // reset trie (id-tree)
             handle->trie->root_bid = trie_root_bid;
             handle->trie->btreeblk_handle = handle->bhandle;
             handle->trie->doc_handle = handle->dhandle;
+            hbtrie_invalidate_path_cache(handle->trie);
 
             // reset seq tree
             if (handle->config.seqtree_opt == FDB_SEQTREE_USE) {
@@ -1726,6 +1840,7 @@ void fdb_check_file_reopen(fdb_kvs_handle *handle)
                     handle->seqtrie->root_bid = seq_root_bid;
                     handle->seqtrie->btreeblk_handle = handle->bhandle;
                     handle->seqtrie->doc_handle = handle->dhandle;
+                    hbtrie_invalidate_path_cache(handle->seqtrie);
                 } else {
                     if (seq_root_bid != BLK_NOT_FOUND) {
                         btree_init_from_bid(handle->seqtree, (void *)handle->bhandle,
@@ -1739,7 +1854,8 @@ void fdb_check_file_reopen(fdb_kvs_handle *handle)
                                    handle->seqtree->kv_ops,
                                    handle->config.blocksize,
                                    sizeof(fdb_seqnum_t),
-                                   OFFSET_SIZE, 0x0, NULL);
+                                   OFFSET_SIZE,
+                           _fdb_btree_node_flag(&handle->config), NULL);
                     }
                 }
             }
@@ -1770,6 +1886,7 @@ void fdb_check_file_reopen(fdb_kvs_handle *handle)
                                  &trie_root_bid, &seq_root_bid,
                                  &ndocs, &nlivenodes, &datasize, &last_wal_flush_hdr_bid,
                                  &kv_info_offset, &header_flags,
+                                 &range_del_offset, &bloom_offset,
                                  &new_filename, NULL);
                 _fdb_close(handle);
                 _fdb_open(handle, new_filename, &config);
@@ -1793,14 +1910,89 @@ void fdb_link_new_file(fdb_kvs_handle *handle)
         handle->new_dhandle = (struct docio_handle *)
                               calloc(1, sizeof(struct docio_handle));
         handle->new_dhandle->log_callback = &handle->log_callback;
+        handle->new_dhandle->use_mmap = handle->dhandle->use_mmap;
         docio_init(handle->new_dhandle,
                    handle->new_file,
                    handle->config.compress_document_body);
     }
 }
 
-LIBFDB_API
-fdb_status fdb_get(fdb_kvs_handle *handle, fdb_doc *doc)
+// compares two keys of range tombstones ('aux' is a KV store handle)
+static int _fdb_range_del_keycmp(void *key1, size_t keylen1,
+                                 void *key2, size_t keylen2,
+                                 void *aux)
+{
+    fdb_kvs_handle *handle = (fdb_kvs_handle *)aux;
+    fdb_custom_cmp_variable cmp;
+
+    if (handle->kvs) {
+        // multi KV instance mode
+        // KV ID should be compared separately
+        size_t size_id = sizeof(fdb_kvs_id_t);
+        fdb_kvs_id_t a_id, b_id, _a_id, _b_id;
+        _a_id = *(fdb_kvs_id_t*)key1;
+        _b_id = *(fdb_kvs_id_t*)key2;
+        a_id = _endian_decode(_a_id);
+        b_id = _endian_decode(_b_id);
+
+        if (a_id < b_id) {
+            return -1;
+        } else if (a_id > b_id) {
+            return 1;
+        }
+        if (keylen1 == size_id || keylen2 == size_id) {
+            // the ID-only key precedes all other keys of the KV store
+            return (int)((int)keylen1 - (int)keylen2);
+        }
+        // the handle may be a root handle used by the compactor,
+        // so find the custom compare function using KV ID.
+        cmp = (fdb_custom_cmp_variable)fdb_kvs_find_cmp_chunk(key1,
+                                                              handle->trie);
+        if (cmp) {
+            return cmp((uint8_t*)key1 + size_id, keylen1 - size_id,
+                       (uint8_t*)key2 + size_id, keylen2 - size_id);
+        }
+    } else if (handle->kvs_config.custom_cmp) {
+        return handle->kvs_config.custom_cmp(key1, keylen1, key2, keylen2);
+    }
+    return _fdb_keycmp(key1, keylen1, key2, keylen2);
+}
+
+// returns 1 if the file or the new file has any range tombstone
+int _fdb_range_del_exist(fdb_kvs_handle *handle)
+{
+    if (range_del_get_count(handle->file)) {
+        return 1;
+    }
+    if (handle->new_file && range_del_get_count(handle->new_file)) {
+        // range deletion performed during compaction
+        return 1;
+    }
+    return 0;
+}
+
+// returns 1 if the document is deleted by any range tombstone
+int _fdb_range_del_covered(fdb_kvs_handle *handle,
+                           void *key, size_t keylen,
+                           fdb_seqnum_t seqnum)
+{
+    // snapshot cannot see range deletions performed after its creation
+    fdb_seqnum_t max_seqnum = (handle->shandle)?(handle->max_seqnum):(0);
+
+    if (range_del_covered(handle->file, key, keylen, seqnum, max_seqnum,
+                          _fdb_range_del_keycmp, (void *)handle)) {
+        return 1;
+    }
+    if (handle->new_file &&
+        range_del_covered(handle->new_file, key, keylen, seqnum, max_seqnum,
+                          _fdb_range_del_keycmp, (void *)handle)) {
+        // range deletion performed during compaction
+        return 1;
+    }
+    return 0;
+}
+
+INLINE fdb_status _fdb_get(fdb_kvs_handle *handle, fdb_doc *doc)
 {
     uint64_t offset, _offset;
     struct docio_object _doc;
@@ -1858,6 +2050,17 @@ fdb_status fdb_get(fdb_kvs_handle *handle, fdb_doc *doc)
     if (wr == FDB_RESULT_KEY_NOT_FOUND) {
         bool locked = false;
         bid_t dirty_idtree_root, dirty_seqtree_root;
+        bool bloom_checked = false;
+
+        // skip the index traversal if the key does not exist in the file.
+        // the filter is not used for custom compare functions, since
+        // keys that are not bitwise identical may be regarded as same.
+        if (!handle->kvs_config.custom_cmp) {
+            if (!bloom_may_contain(handle->file, doc_kv.key, doc_kv.keylen)) {
+                return FDB_RESULT_KEY_NOT_FOUND;
+            }
+            bloom_checked = true;
+        }
 
         if (handle->dirty_updates) {
             // grab lock for writer if there are dirty updates
@@ -1887,6 +2090,10 @@ fdb_status fdb_get(fdb_kvs_handle *handle, fdb_doc *doc)
         btreeblk_end(handle->bhandle);
         offset = _endian_decode(offset);
 
+        if (bloom_checked && hr == HBTRIE_RESULT_FAIL) {
+            bloom_report_false_positive(handle->file);
+        }
+
         if (locked) {
             // grab lock for writer if there are dirty updates
             filemgr_mutex_unlock(handle->file);
@@ -1927,7 +2134,9 @@ fdb_status fdb_get(fdb_kvs_handle *handle, fdb_doc *doc)
         doc->offset = offset;
 
         if (_doc.length.keylen != doc_kv.keylen ||
-            _doc.length.flag & DOCIO_DELETED) {
+            _doc.length.flag & DOCIO_DELETED ||
+            _fdb_range_del_covered(handle, _doc.key, _doc.length.keylen,
+                                   _doc.seqnum)) {
             return FDB_RESULT_KEY_NOT_FOUND;
         }
 
@@ -1937,6 +2146,19 @@ fdb_status fdb_get(fdb_kvs_handle *handle, fdb_doc *doc)
     return FDB_RESULT_KEY_NOT_FOUND;
 }
 
+LIBFDB_API
+fdb_status fdb_get(fdb_kvs_handle *handle, fdb_doc *doc)
+{
+    bool slow_tracked = slowlog_op_begin(handle->config.slow_op_threshold);
+    uint64_t begin = get_monotonic_ts();
+    fdb_status fs = _fdb_get(handle, doc);
+    // the handle may have been switched to a new file by compaction
+    latency_update(handle->file, FDB_LATENCY_GETS, begin);
+    slowlog_op_end(slow_tracked, handle->config.slow_op_threshold,
+                   &handle->log_callback, "fdb_get", handle->file->filename);
+    return fs;
+}
+
 // search document metadata using key
 LIBFDB_API
 fdb_status fdb_get_metaonly(fdb_kvs_handle *handle, fdb_doc *doc)
@@ -2000,6 +2222,17 @@ fdb_status fdb_get_metaonly(fdb_kvs_handle *handle, fdb_doc *doc)
     if (wr == FDB_RESULT_KEY_NOT_FOUND) {
         bool locked = false;
         bid_t dirty_idtree_root, dirty_seqtree_root;
+        bool bloom_checked = false;
+
+        // skip the index traversal if the key does not exist in the file.
+        // the filter is not used for custom compare functions, since
+        // keys that are not bitwise identical may be regarded as same.
+        if (!handle->kvs_config.custom_cmp) {
+            if (!bloom_may_contain(handle->file, doc_kv.key, doc_kv.keylen)) {
+                return FDB_RESULT_KEY_NOT_FOUND;
+            }
+            bloom_checked = true;
+        }
 
         if (handle->dirty_updates) {
             // grab lock for writer if there are dirty updates
@@ -2030,6 +2263,10 @@ fdb_status fdb_get_metaonly(fdb_kvs_handle *handle, fdb_doc *doc)
         btreeblk_end(handle->bhandle);
         offset = _endian_decode(offset);
 
+        if (bloom_checked && hr == HBTRIE_RESULT_FAIL) {
+            bloom_report_false_positive(handle->file);
+        }
+
         if (locked) {
             filemgr_mutex_unlock(handle->file);
         }
@@ -2063,7 +2300,9 @@ fdb_status fdb_get_metaonly(fdb_kvs_handle *handle, fdb_doc *doc)
         doc->size_ondisk = _fdb_get_docsize(_doc.length);
         doc->offset = offset;
 
-        if (_doc.length.keylen != doc_kv.keylen) {
+        if (_doc.length.keylen != doc_kv.keylen ||
+            _fdb_range_del_covered(handle, _doc.key, _doc.length.keylen,
+                                   _doc.seqnum)) {
             return FDB_RESULT_KEY_NOT_FOUND;
         }
 
@@ -2084,6 +2323,7 @@ fdb_status fdb_get_byseq(fdb_kvs_handle *handle, fdb_doc *doc)
     fdb_status wr;
     btree_result br = BTREE_RESULT_FAIL;
     fdb_seqnum_t _seqnum;
+    int covered;
     fdb_txn *txn = handle->fhandle->root->txn;
 
     if (doc->seqnum == SEQNUM_NOT_USED) {
@@ -2186,6 +2426,9 @@ fdb_status fdb_get_byseq(fdb_kvs_handle *handle, fdb_doc *doc)
         if (_offset == offset) {
             return FDB_RESULT_KEY_NOT_FOUND;
         }
+        // check range tombstones before the KV ID prefix is removed
+        covered = _fdb_range_del_covered(handle, _doc.key,
+                                         _doc.length.keylen, _doc.seqnum);
 
         doc->seqnum = _doc.seqnum;
         if (handle->kvs) {
@@ -2205,7 +2448,7 @@ fdb_status fdb_get_byseq(fdb_kvs_handle *handle, fdb_doc *doc)
         doc->size_ondisk = _fdb_get_docsize(_doc.length);
         doc->offset = offset;
 
-        if (_doc.length.flag & DOCIO_DELETED) {
+        if (_doc.length.flag & DOCIO_DELETED || covered) {
             return FDB_RESULT_KEY_NOT_FOUND;
         }
 
@@ -2228,6 +2471,7 @@ fdb_status fdb_get_metaonly_byseq(fdb_kvs_handle *handle, fdb_doc *doc)
     fdb_status wr;
     btree_result br = BTREE_RESULT_FAIL;
     fdb_seqnum_t _seqnum;
+    int covered;
     fdb_txn *txn = handle->fhandle->root->txn;
 
     if (doc->seqnum == SEQNUM_NOT_USED) {
@@ -2325,6 +2569,9 @@ fdb_status fdb_get_metaonly_byseq(fdb_kvs_handle *handle, fdb_doc *doc)
         if (body_offset == offset) {
             return FDB_RESULT_KEY_NOT_FOUND;
         }
+        // check range tombstones before the KV ID prefix is removed
+        covered = _fdb_range_del_covered(handle, _doc.key,
+                                         _doc.length.keylen, _doc.seqnum);
 
         if (handle->kvs) {
             int size_id = sizeof(fdb_kvs_id_t);
@@ -2345,6 +2592,10 @@ fdb_status fdb_get_metaonly_byseq(fdb_kvs_handle *handle, fdb_doc *doc)
 
         assert(doc->seqnum == _doc.seqnum);
 
+        if (covered) {
+            return FDB_RESULT_KEY_NOT_FOUND;
+        }
+
         return FDB_RESULT_SUCCESS;
     }
 
@@ -2478,8 +2729,7 @@ static uint64_t _fdb_get_wal_threshold(fdb_kvs_handle *handle)
     return handle->config.wal_threshold;
 }
 
-LIBFDB_API
-fdb_status fdb_set(fdb_kvs_handle *handle, fdb_doc *doc)
+INLINE fdb_status _fdb_set(fdb_kvs_handle *handle, fdb_doc *doc)
 {
     uint64_t offset;
     struct docio_object _doc;
@@ -2677,6 +2927,22 @@ fdb_set_start:
     return FDB_RESULT_SUCCESS;
 }
 
+LIBFDB_API
+fdb_status fdb_set(fdb_kvs_handle *handle, fdb_doc *doc)
+{
+    bool slow_tracked = slowlog_op_begin(handle->config.slow_op_threshold);
+    uint64_t begin = get_monotonic_ts();
+    fdb_status fs = _fdb_set(handle, doc);
+    latency_update(handle->file, FDB_LATENCY_SETS, begin);
+    if (fs == FDB_RESULT_SUCCESS) {
+        io_stats_add_user_bytes(handle->file,
+                                doc->keylen + doc->metalen + doc->bodylen);
+    }
+    slowlog_op_end(slow_tracked, handle->config.slow_op_threshold,
+                   &handle->log_callback, "fdb_set", handle->file->filename);
+    return fs;
+}
+
 LIBFDB_API
 fdb_status fdb_del(fdb_kvs_handle *handle, fdb_doc *doc)
 {
@@ -2699,6 +2965,123 @@ fdb_status fdb_del(fdb_kvs_handle *handle, fdb_doc *doc)
     return fdb_set(handle, &_doc);
 }
 
+LIBFDB_API
+fdb_status fdb_del_range(fdb_kvs_handle *handle,
+                         const void *start_key,
+                         size_t start_keylen,
+                         const void *end_key,
+                         size_t end_keylen)
+{
+    uint8_t *start = NULL, *end = NULL;
+    size_t size_id = 0;
+    struct filemgr *file;
+    bool sub_handle = false;
+    fdb_kvs_id_t kv_id, _kv_id;
+
+    if (handle->config.flags & FDB_OPEN_FLAG_RDONLY) {
+        return fdb_log(&handle->log_callback, FDB_RESULT_RONLY_VIOLATION,
+                       "Warning: DEL_RANGE is not allowed on the read-only DB file '%s'.",
+                       handle->file->filename);
+    }
+
+    // Sequence trees are a must for range tombstones
+    if (handle->config.seqtree_opt != FDB_SEQTREE_USE) {
+        return FDB_RESULT_INVALID_CONFIG;
+    }
+
+    if ((start_key && (start_keylen == 0 || start_keylen > FDB_MAX_KEYLEN)) ||
+        (end_key && (end_keylen == 0 || end_keylen > FDB_MAX_KEYLEN))) {
+        return FDB_RESULT_INVALID_ARGS;
+    }
+    if (!start_key) {
+        start_keylen = 0;
+    }
+    if (!end_key) {
+        end_keylen = 0;
+    }
+
+    if (handle->kvs) {
+        // multi KV instance mode
+        // the range should be confined to the KV ID prefix
+        size_id = sizeof(fdb_kvs_id_t);
+        kv_id = handle->kvs->id;
+        _kv_id = _endian_encode(kv_id);
+
+        start = alca(uint8_t, size_id + start_keylen);
+        memcpy(start, &_kv_id, size_id);
+        memcpy(start + size_id, start_key, start_keylen);
+        start_keylen += size_id;
+
+        end = alca(uint8_t, size_id + end_keylen);
+        if (end_key) {
+            memcpy(end, &_kv_id, size_id);
+            memcpy(end + size_id, end_key, end_keylen);
+            end_keylen += size_id;
+        } else {
+            // the first key of the next KV store
+            _kv_id = _endian_encode(kv_id + 1);
+            memcpy(end, &_kv_id, size_id);
+            end_keylen = size_id;
+        }
+
+        if (handle->kvs->type == KVS_SUB) {
+            sub_handle = true;
+        }
+    } else {
+        start = (uint8_t *)start_key;
+        end = (uint8_t *)end_key;
+    }
+
+fdb_del_range_start:
+    fdb_check_file_reopen(handle);
+    fdb_sync_db_header(handle);
+
+    if (handle->new_file == NULL) {
+        file = handle->file;
+        filemgr_mutex_lock(file);
+
+        fdb_link_new_file(handle);
+        if (handle->new_file) {
+            // compaction is being performed and new file exists
+            // relay lock
+            filemgr_mutex_lock(handle->new_file);
+            filemgr_mutex_unlock(handle->file);
+            file = handle->new_file;
+        }
+    } else {
+        file = handle->new_file;
+        filemgr_mutex_lock(file);
+    }
+
+    if (filemgr_is_rollback_on(file)) {
+        filemgr_mutex_unlock(file);
+        return FDB_RESULT_FAIL_BY_ROLLBACK;
+    }
+
+    if (!(file->status == FILE_NORMAL ||
+          file->status == FILE_COMPACT_NEW)) {
+        // we must not write into this file
+        // file status was changed by other thread .. start over
+        filemgr_mutex_unlock(file);
+        goto fdb_del_range_start;
+    }
+
+    // documents whose sequence numbers are smaller than
+    // the tombstone's sequence number are regarded as deleted
+    if (sub_handle) {
+        handle->seqnum = fdb_kvs_get_seqnum(file, handle->kvs->id) + 1;
+        fdb_kvs_set_seqnum(file, handle->kvs->id, handle->seqnum);
+    } else {
+        handle->seqnum = filemgr_get_seqnum(file) + 1;
+        filemgr_set_seqnum(file, handle->seqnum);
+    }
+    range_del_insert(file, start, start_keylen, end, end_keylen,
+                     handle->seqnum);
+
+    filemgr_mutex_unlock(file);
+    return FDB_RESULT_SUCCESS;
+}
+
 uint64_t _fdb_export_header_flags(fdb_kvs_handle *handle)
 {
     uint64_t rv = 0;
@@ -2714,6 +3097,13 @@ uint64_t _fdb_export_header_flags(fdb_kvs_handle *handle)
         // the default KVS is based on custom key order
         rv |= FDB_FLAG_ROOT_CUSTOM_CMP;
     }
+    if (filemgr_get_blk_crc_type(handle->file) == BLK_CRC_CRC32C) {
+        // b-tree nodes are checksummed using CRC32C
+        rv |= FDB_FLAG_BLK_CRC32C;
+    }
+    // range tombstone and Bloom filter offsets are appended
+    // after the file names
+    rv |= FDB_FLAG_RANGE_DEL | FDB_FLAG_BLOOM;
     return rv;
 }
 
@@ -2734,8 +3124,16 @@ uint64_t fdb_set_file_header(fdb_kvs_handle *handle)
     [    66]: Size of old file name before compaction :  2 bytes
     [    68]: File name of newly compacted file : x bytes
     [  68+x]: File name of old file before compcation : y bytes
-    [68+x+y]: CRC32: 4 bytes
-    total size (header's length): 72+x+y bytes
+    [68+x+y]: Offset of the document containing range tombstones: 8 bytes
+              (only if FDB_FLAG_RANGE_DEL is set)
+    [76+x+y]: Offset of the document containing Bloom filter: 8 bytes
+              (only if FDB_FLAG_BLOOM is set)
+    [84+x+y]: CRC32: 4 bytes
+    total size (header's length): 88+x+y bytes
+
+    New fields must be appended after the file names and flagged in
+    the header flags, so that headers written by older versions
+    are still parsed correctly.
 
     Note: the list of functions that need to be modified
           if the header structure is changed:
@@ -2820,6 +3218,15 @@ uint64_t fdb_set_file_header(fdb_kvs_handle *handle)
                    old_filename_len, offset);
     }
 
+    // range tombstones offset
+    _edn_safe_64 = _endian_encode(range_del_get_offset(handle->file));
+    seq_memcpy(buf + offset, &_edn_safe_64,
+               sizeof(_edn_safe_64), offset);
+    // Bloom filter offset
+    _edn_safe_64 = _endian_encode(bloom_get_offset(handle->file));
+    seq_memcpy(buf + offset, &_edn_safe_64,
+               sizeof(_edn_safe_64), offset);
+
     // crc32
     crc = chksum(buf, offset);
     crc = _endian_encode(crc);
@@ -2844,7 +3251,21 @@ static void _fdb_append_commit_mark(void *voidhandle, uint64_t offset)
 LIBFDB_API
 fdb_status fdb_commit(fdb_file_handle *fhandle, fdb_commit_opt_t opt)
 {
-    return _fdb_commit(fhandle->root, opt);
+    fdb_kvs_handle *root = fhandle->root;
+    bool slow_tracked = slowlog_op_begin(root->config.slow_op_threshold);
+    uint64_t begin = get_monotonic_ts();
+    TRACE_BEGIN(FDB_TRACE_COMMIT);
+    fdb_status fs = _fdb_commit(root, opt);
+    TRACE_END(FDB_TRACE_COMMIT);
+    latency_update(root->file, FDB_LATENCY_COMMITS, begin);
+    if (slow_tracked) {
+        // the root handle is not exposed, so report to a KV store handle
+        err_log_callback log_callback;
+        fdb_file_handle_get_log_callback(fhandle, &log_callback);
+        slowlog_op_end(slow_tracked, root->config.slow_op_threshold,
+                       &log_callback, "fdb_commit", root->file->filename);
+    }
+    return fs;
 }
 
 fdb_status _fdb_commit(fdb_kvs_handle *handle, fdb_commit_opt_t opt)
@@ -2953,6 +3374,10 @@ fdb_status _fdb_commit(fdb_kvs_handle *handle, fdb_commit_opt_t opt)
             handle->kv_info_offset = fdb_kvs_header_append(handle->file,
                                                            handle->dhandle);
         }
+        // append range tombstones if they have been changed
+        range_del_append(handle->file, handle->dhandle);
+        // append Bloom filter if it has been changed
+        bloom_append(handle->file, handle->dhandle);
 
         // Note: Getting header BID must be done after
         //       all other data are written into the file!!
@@ -3026,6 +3451,10 @@ static fdb_status _fdb_commit_and_remove_pending(fdb_kvs_handle *handle,
         // empty WAL
         wal_set_dirty_status(handle->file, FDB_WAL_CLEAN);
     }
+    // append range tombstones if they have been changed
+    range_del_append(handle->file, handle->dhandle);
+    // append Bloom filter if it has been changed
+    bloom_append(handle->file, handle->dhandle);
 
     handle->last_hdr_bid = filemgr_get_next_alloc_block(handle->file);
     if (wal_get_dirty_status(handle->file) == FDB_WAL_CLEAN) {
@@ -3098,9 +3527,13 @@ INLINE void _fdb_compact_move_docs(fdb_kvs_handle *handle,
                                    struct btreeblk_handle *new_bhandle)
 {
     uint8_t deleted;
+    uint8_t *key = NULL;
+    bool skip_dropped = false;
+    size_t keylen;
     uint64_t offset;
     uint64_t new_offset;
     uint64_t *offset_array;
+    fdb_kvs_id_t kv_id, _kv_id;
     uint64_t n_moved_docs;
     size_t i, j, c, count;
     size_t offset_array_max;
@@ -3132,12 +3565,38 @@ INLINE void _fdb_compact_move_docs(fdb_kvs_handle *handle,
     offset_array = (uint64_t*)malloc(sizeof(uint64_t) * offset_array_max);
     c = count = n_moved_docs = 0;
 
+    // documents belonging to dropped KV stores don't need to be moved.
+    // if there is any dropped KV store, we need to fetch the key (KV ID)
+    // of each document to skip the sub-trie of the dropped KV ID.
+    if (handle->kvs &&
+        _fdb_kvs_get_num_dropped(handle->file->kv_header) > 0) {
+        skip_dropped = true;
+        key = alca(uint8_t, HBTRIE_MAX_KEYLEN);
+    }
+
     hr = hbtrie_iterator_init(handle->trie, &it, NULL, 0);
 
     while( hr != HBTRIE_RESULT_FAIL ) {
 
-        hr = hbtrie_next_value_only(&it, (void*)&offset);
-        btreeblk_end(handle->bhandle);
+        if (skip_dropped) {
+            hr = hbtrie_next(&it, key, &keylen, (void*)&offset);
+            btreeblk_end(handle->bhandle);
+            if (hr != HBTRIE_RESULT_FAIL) {
+                memcpy(&_kv_id, key, sizeof(_kv_id));
+                kv_id = _endian_decode(_kv_id);
+                if (_fdb_kvs_is_dropped(handle->file->kv_header, kv_id)) {
+                    // jump to the first key of the next KV ID
+                    _kv_id = _endian_encode(kv_id + 1);
+                    hbtrie_iterator_free(&it);
+                    hr = hbtrie_iterator_init(handle->trie, &it,
+                                              &_kv_id, sizeof(_kv_id));
+                    continue;
+                }
+            }
+        } else {
+            hr = hbtrie_next_value_only(&it, (void*)&offset);
+            btreeblk_end(handle->bhandle);
+        }
         offset = _endian_decode(offset);
 
         if ( hr != HBTRIE_RESULT_FAIL ) {
@@ -3168,13 +3627,17 @@ INLINE void _fdb_compact_move_docs(fdb_kvs_handle *handle,
                 for(j=i; j<MIN(c, i+FDB_COMPACTION_BATCHSIZE); ++j){
                     // compare timestamp
                     deleted = doc[j-i].length.flag & DOCIO_DELETED;
-                    if (!deleted ||
-                        (cur_timestamp < doc[j-i].timestamp + handle->config.purging_interval &&
-                         deleted)) {
+                    if ((!deleted ||
+                         (cur_timestamp < doc[j-i].timestamp + handle->config.purging_interval &&
+                          deleted)) &&
+                        !_fdb_range_del_covered(handle, doc[j-i].key,
+                                                doc[j-i].length.keylen,
+                                                doc[j-i].seqnum)) {
                         // re-write the document to new file when
                         // 1. the document is not deleted
                         // 2. the document is logically deleted but
                         //    its timestamp isn't overdue
+                        // and the document is not deleted by range tombstones
                         new_offset = docio_append_doc(new_dhandle, &doc[j-i], deleted, 0);
 
                         wal_doc.keylen = doc[j-i].length.keylen;
@@ -3272,6 +3735,8 @@ fdb_status fdb_compact_file(fdb_file_handle *fhandle,
     size_t old_filename_len = 0;
     fdb_kvs_handle *handle = fhandle->root;
     fdb_seqnum_t seqnum;
+    fdb_status fs;
+    uint64_t begin;
 
     // prevent update to the target file
     filemgr_mutex_lock(handle->file);
@@ -3317,6 +3782,9 @@ fdb_status fdb_compact_file(fdb_file_handle *fhandle,
     // sync handle
     fdb_sync_db_header(handle);
 
+    begin = get_monotonic_ts();
+    TRACE_BEGIN(FDB_TRACE_COMPACT_FLUSH);
+
     // set filemgr configuration
     fconfig.blocksize = handle->config.blocksize;
     fconfig.ncacheblock = handle->config.buffercache_size / handle->config.blocksize;
@@ -3336,6 +3804,7 @@ fdb_status fdb_compact_file(fdb_file_handle *fhandle,
                                               &handle->log_callback);
     if (result.rv != FDB_RESULT_SUCCESS) {
         filemgr_mutex_unlock(handle->file);
+        TRACE_END(FDB_TRACE_COMPACT_FLUSH);
         return (fdb_status) result.rv;
     }
 
@@ -3343,6 +3812,9 @@ fdb_status fdb_compact_file(fdb_file_handle *fhandle,
     assert(new_file);
 
     filemgr_set_in_place_compaction(new_file, in_place_compaction);
+    filemgr_set_blk_crc_type(new_file, _fdb_blk_crc_type(&handle->config));
+    // writes to the new file are accounted as compaction until the switch
+    io_stats_set_compacting(new_file, 1);
     // prevent update to the new_file
     filemgr_mutex_lock(new_file);
 
@@ -3377,6 +3849,8 @@ fdb_status fdb_compact_file(fdb_file_handle *fhandle,
     new_trie->aux = handle->trie->aux;
     new_trie->flag = handle->trie->flag;
     new_trie->leaf_height_limit = handle->trie->leaf_height_limit;
+    new_trie->btree_node_flag = handle->trie->btree_node_flag;
+    new_trie->btree_leaf_node_flag = handle->trie->btree_leaf_node_flag;
     new_trie->map = handle->trie->map;
 
     if (handle->config.seqtree_opt == FDB_SEQTREE_USE) {
@@ -3388,6 +3862,9 @@ fdb_status fdb_compact_file(fdb_file_handle *fhandle,
                         OFFSET_SIZE, new_file->blocksize, BLK_NOT_FOUND,
                         (void *)new_bhandle, handle->btreeblkops,
                         (void *)new_dhandle, _fdb_readseq_wrap);
+            hbtrie_set_node_flag(new_seqtrie,
+                                 _fdb_btree_node_flag(&handle->config),
+                                 _fdb_btree_leaf_node_flag(&handle->config));
         } else {
             new_seqtree = (struct btree *)calloc(1, sizeof(struct btree));
             old_seqtree = handle->seqtree;
@@ -3395,7 +3872,8 @@ fdb_status fdb_compact_file(fdb_file_handle *fhandle,
             btree_init(new_seqtree, (void *)new_bhandle,
                        old_seqtree->blk_ops, old_seqtree->kv_ops,
                        old_seqtree->blksize, old_seqtree->ksize,
-                       old_seqtree->vsize, 0x0, NULL);
+                       old_seqtree->vsize,
+                       _fdb_btree_node_flag(&handle->config), NULL);
         }
         // copy old file's seqnum to new file
         // (KV instances' seq numbers will be copied along with KV header)
@@ -3418,6 +3896,27 @@ fdb_status fdb_compact_file(fdb_file_handle *fhandle,
     wal_txn_migration((void*)handle, (void*)new_dhandle,
                       handle->file, new_file, _fdb_doc_move);
 
+    // range tombstones are physically applied while moving documents,
+    // so they are discarded unless uncommitted items have been migrated.
+    range_del_create(new_file);
+    if (wal_get_size(new_file)) {
+        range_del_copy(handle->file, new_file);
+    }
+
+    // Bloom filter is rebuilt while moving documents and migrated items are
+    // added when they are flushed, so the new filter is sized for the number
+    // of live documents.
+    if (handle->file->bloom || handle->config.bloom_filter_bits_per_key) {
+        bloom_create(new_file,
+                     (handle->config.bloom_filter_bits_per_key)?
+                     (handle->config.bloom_filter_bits_per_key):
+                     (handle->file->bloom->bits_per_key),
+                     _kvs_stat_get_sum(handle->file, KVS_STAT_NDOCS) +
+                     wal_get_size(new_file));
+    }
+    // the filter of the old file includes the keys flushed above
+    bloom_append(handle->file, handle->dhandle);
+
     // mark name of new file in old file
     filemgr_set_compaction_old(handle->file, new_file);
 
@@ -3428,13 +3927,17 @@ fdb_status fdb_compact_file(fdb_file_handle *fhandle,
     btreeblk_end(handle->bhandle);
 
     // Commit the current file handle to record the compaction filename
-    fdb_status fs = filemgr_commit(handle->file, &handle->log_callback);
+    fs = filemgr_commit(handle->file, &handle->log_callback);
     wal_release_flushed_items(handle->file, &flush_items);
     if (fs != FDB_RESULT_SUCCESS) {
+        io_stats_set_compacting(new_file, 0);
         filemgr_mutex_unlock(handle->file);
         filemgr_mutex_unlock(new_file);
+        TRACE_END(FDB_TRACE_COMPACT_FLUSH);
         return fs;
     }
+    TRACE_END(FDB_TRACE_COMPACT_FLUSH);
+    latency_update(handle->file, FDB_LATENCY_COMPACT_FLUSH, begin);
 
     // reset last_wal_flush_hdr_bid
     handle->last_wal_flush_hdr_bid = BLK_NOT_FOUND;
@@ -3445,6 +3948,8 @@ fdb_status fdb_compact_file(fdb_file_handle *fhandle,
     filemgr_mutex_unlock(new_file);
     // now compactor & another writer can be interleaved
 
+    begin = get_monotonic_ts();
+    TRACE_BEGIN(FDB_TRACE_COMPACT_MOVE);
     if (handle->kvs) {
         _fdb_compact_move_docs(handle, new_file, new_trie, new_idtree,
                                (struct btree*)new_seqtrie, new_dhandle,
@@ -3453,12 +3958,19 @@ fdb_status fdb_compact_file(fdb_file_handle *fhandle,
         _fdb_compact_move_docs(handle, new_file, new_trie, new_idtree, new_seqtree,
                                new_dhandle, new_bhandle);
     }
+    TRACE_END(FDB_TRACE_COMPACT_MOVE);
+    latency_update(handle->file, FDB_LATENCY_COMPACT_MOVE, begin);
 
+    begin = get_monotonic_ts();
+    TRACE_BEGIN(FDB_TRACE_COMPACT_SWITCH);
     filemgr_mutex_lock(new_file);
 
     old_file = handle->file;
     compactor_switch_file(old_file, new_file);
     handle->file = new_file;
+    // carry over latency and I/O stats of the old file
+    latency_merge(new_file, old_file);
+    io_stats_merge(new_file, old_file);
 
     btreeblk_free(handle->bhandle);
     free(handle->bhandle);
@@ -3495,7 +4007,11 @@ fdb_status fdb_compact_file(fdb_file_handle *fhandle,
     // 1) commit new file
     // 2) set remove pending flag of the old file
     // 3) close the old file
-    return _fdb_commit_and_remove_pending(handle, old_file, new_file);
+    fs = _fdb_commit_and_remove_pending(handle, old_file, new_file);
+    io_stats_set_compacting(new_file, 0);
+    TRACE_END(FDB_TRACE_COMPACT_SWITCH);
+    latency_update(new_file, FDB_LATENCY_COMPACT_SWITCH, begin);
+    return fs;
 }
 
 LIBFDB_API
@@ -3876,6 +4392,172 @@ fdb_status fdb_get_file_info(fdb_file_handle *fhandle, fdb_file_info *info)
     return FDB_RESULT_SUCCESS;
 }
 
+LIBFDB_API
+fdb_status fdb_get_bloom_stats(fdb_file_handle *fhandle,
+                               fdb_bloom_stats *stats)
+{
+    fdb_kvs_handle *handle;
+
+    if (!fhandle || !stats) {
+        return FDB_RESULT_INVALID_ARGS;
+    }
+    handle = fhandle->root;
+
+    fdb_check_file_reopen(handle);
+    fdb_link_new_file(handle);
+    fdb_sync_db_header(handle);
+
+    bloom_get_stats(handle->file, stats);
+
+    return FDB_RESULT_SUCCESS;
+}
+
+LIBFDB_API
+fdb_status fdb_get_buffer_cache_stats(fdb_file_handle *fhandle,
+                                      fdb_buffer_cache_stats *file_stats,
+                                      fdb_buffer_cache_stats *global_stats)
+{
+    fdb_kvs_handle *handle;
+
+    if (file_stats) {
+        if (!fhandle) {
+            return FDB_RESULT_INVALID_ARGS;
+        }
+        handle = fhandle->root;
+
+        fdb_check_file_reopen(handle);
+        fdb_link_new_file(handle);
+        fdb_sync_db_header(handle);
+
+        bcache_get_file_stats(handle->file, file_stats);
+    }
+    if (global_stats) {
+        bcache_get_global_stats(global_stats);
+    }
+
+    return FDB_RESULT_SUCCESS;
+}
+
+LIBFDB_API
+fdb_status fdb_get_latency_stats(fdb_file_handle *fhandle,
+                                 fdb_latency_stat *stat,
+                                 fdb_latency_stat_type type)
+{
+    fdb_kvs_handle *handle;
+
+    if (!fhandle || !stat || type >= FDB_LATENCY_NUM_STATS) {
+        return FDB_RESULT_INVALID_ARGS;
+    }
+    handle = fhandle->root;
+
+    fdb_check_file_reopen(handle);
+    fdb_link_new_file(handle);
+    fdb_sync_db_header(handle);
+
+    latency_get_stat(handle->file, type, stat);
+
+    return FDB_RESULT_SUCCESS;
+}
+
+LIBFDB_API
+fdb_status fdb_reset_latency_stats(fdb_file_handle *fhandle)
+{
+    fdb_kvs_handle *handle;
+
+    if (!fhandle) {
+        return FDB_RESULT_INVALID_ARGS;
+    }
+    handle = fhandle->root;
+
+    fdb_check_file_reopen(handle);
+    fdb_link_new_file(handle);
+    fdb_sync_db_header(handle);
+
+    latency_reset(handle->file);
+
+    return FDB_RESULT_SUCCESS;
+}
+
+LIBFDB_API
+const char* fdb_latency_stat_name(fdb_latency_stat_type type)
+{
+    return latency_get_name(type);
+}
+
+LIBFDB_API
+fdb_status fdb_set_trace_callbacks(fdb_trace_callback begin_cb,
+                                   fdb_trace_callback end_cb,
+                                   void *ctx)
+{
+    return trace_set_callbacks(begin_cb, end_cb, ctx);
+}
+
+LIBFDB_API
+const char* fdb_trace_event_name(fdb_trace_event event)
+{
+    return trace_get_name(event);
+}
+
+LIBFDB_API
+fdb_status fdb_get_lock_stats(fdb_lock_stats *stats)
+{
+    if (!stats) {
+        return FDB_RESULT_INVALID_ARGS;
+    }
+    return lockprof_get_stats(stats);
+}
+
+LIBFDB_API
+fdb_status fdb_reset_lock_stats()
+{
+    return lockprof_reset();
+}
+
+LIBFDB_API
+const char* fdb_lock_site_name(fdb_lock_site site)
+{
+    return lockprof_get_name(site);
+}
+
+LIBFDB_API
+fdb_status fdb_get_io_stats(fdb_file_handle *fhandle,
+                            fdb_io_stats *stats)
+{
+    fdb_kvs_handle *handle;
+
+    if (!fhandle || !stats) {
+        return FDB_RESULT_INVALID_ARGS;
+    }
+    handle = fhandle->root;
+
+    fdb_check_file_reopen(handle);
+    fdb_link_new_file(handle);
+    fdb_sync_db_header(handle);
+
+    io_stats_get(handle->file, stats);
+
+    return FDB_RESULT_SUCCESS;
+}
+
+LIBFDB_API
+fdb_status fdb_reset_io_stats(fdb_file_handle *fhandle)
+{
+    fdb_kvs_handle *handle;
+
+    if (!fhandle) {
+        return FDB_RESULT_INVALID_ARGS;
+    }
+    handle = fhandle->root;
+
+    fdb_check_file_reopen(handle);
+    fdb_link_new_file(handle);
+    fdb_sync_db_header(handle);
+
+    io_stats_reset(handle->file);
+
+    return FDB_RESULT_SUCCESS;
+}
+
 LIBFDB_API
 fdb_status fdb_shutdown()
 {
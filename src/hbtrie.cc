@@ -26,6 +26,7 @@
 #include "btree_kv.h"
 #include "btree_fast_str_kv.h"
 #include "internal_types.h"
+#include "slowlog.h"
 
 #include "memleak.h"
 
@@ -131,6 +132,13 @@ int _hbtrie_reform_key_reverse(struct hbtrie *trie,
 #define _set_leaf_inf_key btree_fast_str_kv_set_inf_key
 #define _free_leaf_key btree_fast_str_kv_free_key
 
+// node format of a new b-tree: non-leaf b-trees use the layout given by
+// hbtrie_set_node_flag(), while leaf b-trees store variable-length keys
+// without their common prefix
+#define _get_btree_node_flag(trie, kv_ops) \
+    (((kv_ops) == (trie)->btree_kv_ops)?((trie)->btree_node_flag): \
+                                        ((trie)->btree_leaf_node_flag))
+
 void hbtrie_init(struct hbtrie *trie, int chunksize, int valuelen,
                  int btree_nodesize, bid_t root_bid, void *btreeblk_handle,
                  struct btree_blk_ops *btree_blk_ops, void *doc_handle,
@@ -147,6 +155,8 @@ void hbtrie_init(struct hbtrie *trie, int chunksize, int valuelen,
     trie->root_bid = root_bid;
     trie->flag = 0x0;
     trie->leaf_height_limit = 0;
+    trie->btree_node_flag = 0x0;
+    trie->btree_leaf_node_flag = 0x0;
 
     // assign key-value operations
     btree_kv_ops = (struct btree_kv_ops *)malloc(sizeof(struct btree_kv_ops));
@@ -170,6 +180,11 @@ void hbtrie_init(struct hbtrie *trie, int chunksize, int valuelen,
     trie->map = NULL;
     trie->last_map_chunk = (void *)malloc(chunksize);
     memset(trie->last_map_chunk, 0xff, chunksize); // set 0xffff...
+
+    trie->path_cache = (struct hbtrie_path_cache *)
+                       calloc(1, sizeof(struct hbtrie_path_cache));
+    trie->path_cache->root_bid = BLK_NOT_FOUND;
+    trie->path_cache->key = (uint8_t *)malloc(HBTRIE_MAX_KEYLEN);
 }
 
 void hbtrie_free(struct hbtrie *trie)
@@ -177,6 +192,11 @@ void hbtrie_free(struct hbtrie *trie)
     free(trie->btree_kv_ops);
     free(trie->btree_leaf_kv_ops);
     free(trie->last_map_chunk);
+    if (trie->path_cache) {
+        free(trie->path_cache->key);
+        free(trie->path_cache);
+        trie->path_cache = NULL;
+    }
 }
 
 void hbtrie_set_flag(struct hbtrie *trie, uint8_t flag)
@@ -192,6 +212,15 @@ void hbtrie_set_leaf_height_limit(struct hbtrie *trie, uint8_t limit)
     trie->leaf_height_limit = limit;
 }
 
+// set the node layout of non-leaf b-trees (BNODE_MASK_SEPARATED or 0x0) and
+// leaf b-trees (BNODE_MASK_PREFIX or 0x0) created from now on;
+// existing b-trees keep their layout
+void hbtrie_set_node_flag(struct hbtrie *trie, uint8_t flag, uint8_t leaf_flag)
+{
+    trie->btree_node_flag = flag;
+    trie->btree_leaf_node_flag = leaf_flag;
+}
+
 void hbtrie_set_leaf_cmp(struct hbtrie *trie,
                          int (*cmp)(void *key1, void *key2, void* aux))
 {
@@ -204,6 +233,16 @@ void hbtrie_set_map_function(struct hbtrie *trie,
     trie->map = map_func;
 }
 
+// should be called when the trie is switched to another file,
+// since the same BID may point to a different node
+void hbtrie_invalidate_path_cache(struct hbtrie *trie)
+{
+    if (trie->path_cache) {
+        trie->path_cache->root_bid = BLK_NOT_FOUND;
+        trie->path_cache->nlevels = 0;
+    }
+}
+
 // IMPORTANT: hbmeta doesn't have own allocated memory space (pointers only)
 void _hbtrie_fetch_meta(struct hbtrie *trie, int metasize,
                         struct hbtrie_meta *hbmeta, void *buf)
@@ -356,6 +395,7 @@ hbtrie_result hbtrie_iterator_init(
     // MUST NOT affect the original trie due to sharing the same memory segment
     it->trie.last_map_chunk = (void *)malloc(it->trie.chunksize);
     memset(it->trie.last_map_chunk, 0xff, it->trie.chunksize);
+    it->trie.path_cache = NULL;
 
     it->curkey = (void *)malloc(HBTRIE_MAX_KEYLEN);
     memset(it->curkey, 0, HBTRIE_MAX_KEYLEN);
@@ -912,6 +952,25 @@ void _hbtrie_btree_cascaded_update(struct hbtrie *trie,
     }
 }
 
+// returns the path cache if it can be used for the current root node
+INLINE struct hbtrie_path_cache * _hbtrie_get_path_cache(struct hbtrie *trie)
+{
+    struct hbtrie_path_cache *cache = trie->path_cache;
+
+    if (cache->root_bid != trie->root_bid) {
+        // root node is changed .. drop the cached path
+        cache->nlevels = 0;
+        if (trie->btree_blk_ops->blk_is_writable(trie->btreeblk_handle,
+                                                 trie->root_bid)) {
+            // nodes that are not committed yet may be modified in-place
+            cache->root_bid = BLK_NOT_FOUND;
+            return NULL;
+        }
+        cache->root_bid = trie->root_bid;
+    }
+    return cache;
+}
+
 hbtrie_result _hbtrie_find(struct hbtrie *trie, void *key, int keylen,
                            void *valuebuf, struct list *btreelist, uint8_t flag)
 {
@@ -929,7 +988,9 @@ hbtrie_result _hbtrie_find(struct hbtrie *trie, void *key, int keylen,
     uint8_t *btree_value = alca(uint8_t, trie->valuelen);
     void *chunk = NULL;
     void *void_cmp;
-    bid_t bid_new;
+    bid_t bid_new, bid_start;
+    int level;
+    struct hbtrie_path_cache *cache = NULL;
     nchunk = _get_nchunk(trie, key, keylen);
 
     meta.data = buf;
@@ -961,10 +1022,32 @@ hbtrie_result _hbtrie_find(struct hbtrie *trie, void *key, int keylen,
         // retrieval fail
         return HBTRIE_RESULT_FAIL;
     } else {
-        // read from root_bid
+        bid_start = trie->root_bid;
+        if (trie->path_cache && !btreelist && !(flag & HBTRIE_PARTIAL_MATCH)) {
+            cache = _hbtrie_get_path_cache(trie);
+        }
+        if (cache) {
+            // find the deepest cached sub-tree that the key leads to
+            for (level = cache->nlevels; level > 0; --level) {
+                int c = cache->levels[level-1].chunkno;
+                if (c < nchunk &&
+                    !memcmp(cache->key, key, (c+1) * trie->chunksize)) {
+                    break;
+                }
+            }
+            cache->nlevels = level;
+            if (level > 0) {
+                // start from the sub-tree as if it is reached from its parent
+                bid_start = cache->levels[level-1].bid;
+                curchunkno = cache->levels[level-1].chunkno;
+                cache->nhits++;
+            }
+        }
+
+        // read from root_bid (or the cached sub-tree)
         r = btree_init_from_bid(btree, trie->btreeblk_handle, trie->btree_blk_ops,
                                 trie->btree_kv_ops, trie->btree_nodesize,
-                                trie->root_bid);
+                                bid_start);
         if (r != BTREE_RESULT_SUCCESS) {
             return HBTRIE_RESULT_FAIL;
         }
@@ -1054,6 +1137,12 @@ hbtrie_result _hbtrie_find(struct hbtrie *trie, void *key, int keylen,
                     list_push_back(btreelist, &btreeitem->e);
                     btree = &btreeitem->btree;
                 }
+                if (cache && cache->nlevels < HBTRIE_PATH_CACHE_DEPTH) {
+                    cache->levels[cache->nlevels].chunkno = curchunkno;
+                    cache->levels[cache->nlevels].bid = bid_new;
+                    cache->nlevels++;
+                    memcpy(cache->key, key, (curchunkno+1) * trie->chunksize);
+                }
 
                 // fetch sub-tree
                 r = btree_init_from_bid(btree, trie->btreeblk_handle, trie->btree_blk_ops,
@@ -1109,9 +1198,14 @@ hbtrie_result hbtrie_find(struct hbtrie *trie, void *rawkey,
     int nchunk = _get_nchunk_raw(trie, rawkey, rawkeylen);
     uint8_t *key = alca(uint8_t, nchunk * trie->chunksize);
     int keylen;
+    uint64_t begin;
+    hbtrie_result hr;
 
     keylen = _hbtrie_reform_key(trie, rawkey, rawkeylen, key);
-    return _hbtrie_find(trie, key, keylen, valuebuf, NULL, 0x0);
+    begin = slowlog_phase_begin();
+    hr = _hbtrie_find(trie, key, keylen, valuebuf, NULL, 0x0);
+    slowlog_phase_end(SLOWLOG_HBTRIE, begin);
+    return hr;
 }
 
 hbtrie_result hbtrie_find_offset(struct hbtrie *trie, void *rawkey,
@@ -1120,10 +1214,15 @@ hbtrie_result hbtrie_find_offset(struct hbtrie *trie, void *rawkey,
     int nchunk = _get_nchunk_raw(trie, rawkey, rawkeylen);
     uint8_t *key = alca(uint8_t, nchunk * trie->chunksize);
     int keylen;
+    uint64_t begin;
+    hbtrie_result hr;
 
     keylen = _hbtrie_reform_key(trie, rawkey, rawkeylen, key);
-    return _hbtrie_find(trie, key, keylen, valuebuf, NULL,
-                        HBTRIE_PREFIX_MATCH_ONLY);
+    begin = slowlog_phase_begin();
+    hr = _hbtrie_find(trie, key, keylen, valuebuf, NULL,
+                      HBTRIE_PREFIX_MATCH_ONLY);
+    slowlog_phase_end(SLOWLOG_HBTRIE, begin);
+    return hr;
 }
 
 hbtrie_result hbtrie_find_partial(struct hbtrie *trie, void *rawkey,
@@ -1132,10 +1231,522 @@ hbtrie_result hbtrie_find_partial(struct hbtrie *trie, void *rawkey,
     int nchunk = _get_nchunk_raw(trie, rawkey, rawkeylen);
     uint8_t *key = alca(uint8_t, nchunk * trie->chunksize);
     int keylen;
+    uint64_t begin;
+    hbtrie_result hr;
 
     keylen = _hbtrie_reform_key(trie, rawkey, rawkeylen, key);
-    return _hbtrie_find(trie, key, keylen, valuebuf, NULL,
-                        HBTRIE_PARTIAL_MATCH);
+    begin = slowlog_phase_begin();
+    hr = _hbtrie_find(trie, key, keylen, valuebuf, NULL,
+                      HBTRIE_PARTIAL_MATCH);
+    slowlog_phase_end(SLOWLOG_HBTRIE, begin);
+    return hr;
+}
+
+// read the smallest key in the sub-trie that VALUE points to
+// (returns 0 if there is no key)
+static size_t _hbtrie_leftmost_key(struct hbtrie *trie, void *value,
+                                   void *key_buf)
+{
+    struct btree btree;
+    struct btree_iterator btree_it;
+    struct btree_meta bmeta;
+    struct hbtrie_meta hbmeta;
+    btree_result br;
+    uint8_t *k = alca(uint8_t, trie->chunksize);
+    uint8_t *v = alca(uint8_t, trie->valuelen);
+    uint64_t offset;
+    uint8_t leaf;
+    bid_t bid;
+
+    memcpy(v, value, trie->valuelen);
+    bmeta.data = (void *)mempool_alloc(trie->btree_nodesize);
+    while (_hbtrie_is_msb_set(trie, v)) {
+        // MSB is set -> sub b-tree
+        _hbtrie_clear_msb(trie, v);
+        bid = trie->btree_kv_ops->value2bid(v);
+        bid = _endian_decode(bid);
+        btree_init_from_bid(
+            &btree, trie->btreeblk_handle, trie->btree_blk_ops,
+            trie->btree_kv_ops, trie->btree_nodesize, bid);
+        btree.aux = trie->aux;
+
+        bmeta.size = btree_read_meta(&btree, bmeta.data);
+        _hbtrie_fetch_meta(trie, bmeta.size, &hbmeta, bmeta.data);
+        if (hbmeta.value) {
+            // the key same to the prefix of this b-tree is the smallest
+            memcpy(v, hbmeta.value, trie->valuelen);
+            break;
+        }
+
+        leaf = _is_leaf_btree(hbmeta.chunkno);
+        if (leaf) {
+            btree.kv_ops = trie->btree_leaf_kv_ops;
+        }
+        memset(k, 0, trie->chunksize);
+        btree_iterator_init(&btree, &btree_it, NULL);
+        br = btree_next(&btree_it, k, v);
+        btree_iterator_free(&btree_it);
+        if (leaf) {
+            _free_leaf_key(k);
+        }
+        if (br == BTREE_RESULT_FAIL) {
+            mempool_free(bmeta.data);
+            return 0;
+        }
+    }
+    mempool_free(bmeta.data);
+
+    offset = trie->btree_kv_ops->value2bid(v);
+    return trie->readkey(trie->doc_handle, offset, key_buf);
+}
+
+// compare the skipped prefix of a b-tree (chunks between PREVCHUNKNO and
+// CURCHUNKNO) with the corresponding chunks of KEY
+static int _hbtrie_cmp_skipped_prefix(struct hbtrie *trie,
+                                      uint8_t *key, int nchunk,
+                                      struct hbtrie_meta *hbmeta,
+                                      int prevchunkno, int curchunkno)
+{
+    int i, cmp = 0;
+    for (i = prevchunkno+1; i < curchunkno && cmp == 0; ++i) {
+        if (i >= nchunk) {
+            // KEY is shorter than the prefix
+            return -1;
+        }
+        cmp = memcmp(key + i * trie->chunksize,
+                     (uint8_t*)hbmeta->prefix +
+                         (i - (prevchunkno+1)) * trie->chunksize,
+                     trie->chunksize);
+    }
+    return cmp;
+}
+
+hbtrie_result hbtrie_get_sample_keys(struct hbtrie *trie,
+                                     void *start_key, int start_keylen,
+                                     void *end_key, int end_keylen,
+                                     int prefixlen,
+                                     size_t n,
+                                     hbtrie_sample_func *func,
+                                     void *aux)
+{
+    struct btree btree;
+    struct btree_meta bmeta;
+    struct hbtrie_meta hbmeta;
+    hbtrie_result hr = HBTRIE_RESULT_SUCCESS;
+    btree_result br;
+    uint8_t *v = alca(uint8_t, trie->valuelen);
+    uint8_t *kmin = alca(uint8_t, trie->chunksize);
+    uint8_t *kmax = alca(uint8_t, trie->chunksize);
+    uint8_t *key_buf, *value_arr;
+    uint8_t *skey = NULL, *ekey = NULL;
+    uint8_t *min_key = NULL, *max_key = NULL;
+    uint8_t *chunk;
+    uint8_t leaf;
+    uint64_t offset;
+    size_t i, nvalues, keylen, rawchunklen;
+    int snchunk = 0, enchunk = 0;
+    int prevchunkno, curchunkno = 0;
+    int scmp, ecmp;
+    void *void_cmp;
+    bid_t bid;
+
+    if (trie->root_bid == BLK_NOT_FOUND || n == 0) {
+        return HBTRIE_RESULT_FAIL;
+    }
+
+    if (start_key && start_keylen) {
+        snchunk = _get_nchunk_raw(trie, start_key, start_keylen);
+        skey = alca(uint8_t, snchunk * trie->chunksize);
+        _hbtrie_reform_key(trie, start_key, start_keylen, skey);
+    }
+    if (end_key && end_keylen) {
+        enchunk = _get_nchunk_raw(trie, end_key, end_keylen);
+        ekey = alca(uint8_t, enchunk * trie->chunksize);
+        _hbtrie_reform_key(trie, end_key, end_keylen, ekey);
+    }
+
+    if (trie->map && skey &&
+        memcmp(trie->last_map_chunk, skey, trie->chunksize)) {
+        // get cmp function corresponding to the key
+        void_cmp = trie->map(skey, (void *)trie);
+        if (void_cmp) {
+            memcpy(trie->last_map_chunk, skey, trie->chunksize);
+            trie->aux = void_cmp;
+        }
+    }
+
+    key_buf = (uint8_t *)malloc(HBTRIE_MAX_KEYLEN);
+    bmeta.data = (void *)mempool_alloc(trie->btree_nodesize);
+    btree_init_from_bid(
+        &btree, trie->btreeblk_handle, trie->btree_blk_ops,
+        trie->btree_kv_ops, trie->btree_nodesize, trie->root_bid);
+    btree.aux = trie->aux;
+
+    // go down to the b-tree that covers all keys starting with the common
+    // PREFIX of START_KEY and END_KEY (only full chunks of PREFIX are used)
+    while (1) {
+        bmeta.size = btree_read_meta(&btree, bmeta.data);
+        _hbtrie_fetch_meta(trie, bmeta.size, &hbmeta, bmeta.data);
+        prevchunkno = curchunkno;
+        leaf = _is_leaf_btree(hbmeta.chunkno);
+        curchunkno = _get_chunkno(hbmeta.chunkno);
+
+        // compare skipped prefix of the b-tree with the range
+        scmp = (skey)?(_hbtrie_cmp_skipped_prefix(trie, skey, snchunk, &hbmeta,
+                                                  prevchunkno, curchunkno))
+                     :(-1);
+        ecmp = (ekey)?(_hbtrie_cmp_skipped_prefix(trie, ekey, enchunk, &hbmeta,
+                                                  prevchunkno, curchunkno))
+                     :(1);
+        if (scmp > 0 || ecmp < 0) {
+            // all keys in this b-tree are out of the range
+            hr = HBTRIE_RESULT_FAIL;
+            goto out;
+        }
+
+        if (leaf) {
+            // leaf b-tree stores the rest of keys as a whole
+            btree.kv_ops = trie->btree_leaf_kv_ops;
+            break;
+        }
+        if ((curchunkno+1) * trie->chunksize > prefixlen) {
+            break;
+        }
+
+        br = btree_find(&btree, skey + curchunkno * trie->chunksize, v);
+        if (br == BTREE_RESULT_FAIL) {
+            // no key with the prefix
+            hr = HBTRIE_RESULT_FAIL;
+            goto out;
+        }
+        if (ekey && (curchunkno >= enchunk ||
+                     memcmp(ekey + curchunkno * trie->chunksize,
+                            skey + curchunkno * trie->chunksize,
+                            trie->chunksize))) {
+            // PREFIX is not shared with END_KEY (e.g., the next KV ID)
+            // .. END_KEY is greater than all keys in the sub b-tree
+            ekey = NULL;
+        }
+        if (!_hbtrie_is_msb_set(trie, v)) {
+            // MSB is not set -> the only doc with the prefix
+            offset = trie->btree_kv_ops->value2bid(v);
+            keylen = trie->readkey(trie->doc_handle, offset, key_buf);
+            if (keylen) {
+                func(key_buf, keylen, aux);
+            }
+            goto out;
+        }
+
+        _hbtrie_clear_msb(trie, v);
+        bid = trie->btree_kv_ops->value2bid(v);
+        bid = _endian_decode(bid);
+        btree_init_from_bid(
+            &btree, trie->btreeblk_handle, trie->btree_blk_ops,
+            trie->btree_kv_ops, trie->btree_nodesize, bid);
+        btree.aux = trie->aux;
+    }
+
+    // bound the b-tree by START_KEY and END_KEY, if the keys of the b-tree
+    // share the preceding chunks with them
+    if (leaf) {
+        if (scmp == 0 && start_keylen > curchunkno * trie->chunksize) {
+            chunk = skey + curchunkno * trie->chunksize;
+            rawchunklen = _hbtrie_reform_key_reverse(
+                trie, chunk, (snchunk - curchunkno) * trie->chunksize);
+            _set_leaf_key(kmin, chunk, rawchunklen);
+            min_key = kmin;
+        }
+        if (ecmp == 0 && end_keylen > curchunkno * trie->chunksize) {
+            chunk = ekey + curchunkno * trie->chunksize;
+            rawchunklen = _hbtrie_reform_key_reverse(
+                trie, chunk, (enchunk - curchunkno) * trie->chunksize);
+            _set_leaf_key(kmax, chunk, rawchunklen);
+            max_key = kmax;
+        }
+    } else {
+        if (scmp == 0 && curchunkno < snchunk) {
+            min_key = skey + curchunkno * trie->chunksize;
+        }
+        if (ecmp == 0 && curchunkno < enchunk) {
+            max_key = ekey + curchunkno * trie->chunksize;
+        }
+    }
+
+    // sample entries of the b-tree within the range,
+    // and take the smallest key of each entry
+    value_arr = (uint8_t *)malloc(n * trie->valuelen);
+    btree_get_sample_values(&btree, min_key, max_key, n, value_arr, &nvalues);
+    for (i=0; i<nvalues; ++i) {
+        keylen = _hbtrie_leftmost_key(trie, value_arr + i * trie->valuelen,
+                                      key_buf);
+        if (keylen) {
+            func(key_buf, keylen, aux);
+        }
+    }
+    free(value_arr);
+    if (leaf) {
+        if (min_key) {
+            _free_leaf_key(kmin);
+        }
+        if (max_key) {
+            _free_leaf_key(kmax);
+        }
+    }
+
+out:
+    mempool_free(bmeta.data);
+    free(key_buf);
+    return hr;
+}
+
+// estimate the fraction of keys in the trie that are smaller than RAWKEY,
+// using the fan-out of b-tree nodes along the path to RAWKEY.
+hbtrie_result hbtrie_get_key_position(struct hbtrie *trie,
+                                      void *rawkey, int rawkeylen,
+                                      double *pos_out)
+{
+    int nchunk = _get_nchunk_raw(trie, rawkey, rawkeylen);
+    int cmp;
+    int prevchunkno, curchunkno = 0, i;
+    uint8_t leaf;
+    uint8_t exact;
+    uint8_t *key = alca(uint8_t, nchunk * trie->chunksize);
+    uint8_t *k = alca(uint8_t, trie->chunksize);
+    uint8_t *v = alca(uint8_t, trie->valuelen);
+    uint8_t *chunk;
+    uint8_t *docrawkey;
+    size_t rawchunklen, docrawkeylen;
+    uint64_t offset;
+    double base = 0, scale = 1, pos, width;
+    struct btree btree;
+    struct btree_meta bmeta;
+    struct hbtrie_meta hbmeta;
+    btree_result br;
+    void *void_cmp;
+    bid_t bid;
+
+    *pos_out = 0;
+    if (trie->root_bid == BLK_NOT_FOUND) {
+        return HBTRIE_RESULT_FAIL;
+    }
+    _hbtrie_reform_key(trie, rawkey, rawkeylen, key);
+
+    if (trie->map &&
+        memcmp(trie->last_map_chunk, key, trie->chunksize)) {
+        // get cmp function corresponding to the key
+        void_cmp = trie->map(key, (void *)trie);
+        if (void_cmp) {
+            memcpy(trie->last_map_chunk, key, trie->chunksize);
+            trie->aux = void_cmp;
+        }
+    }
+
+    bmeta.data = (void *)mempool_alloc(trie->btree_nodesize);
+    btree_init_from_bid(
+        &btree, trie->btreeblk_handle, trie->btree_blk_ops,
+        trie->btree_kv_ops, trie->btree_nodesize, trie->root_bid);
+    btree.aux = trie->aux;
+
+    while (1) {
+        bmeta.size = btree_read_meta(&btree, bmeta.data);
+        _hbtrie_fetch_meta(trie, bmeta.size, &hbmeta, bmeta.data);
+        prevchunkno = curchunkno;
+        leaf = _is_leaf_btree(hbmeta.chunkno);
+        curchunkno = _get_chunkno(hbmeta.chunkno);
+        if (leaf) {
+            btree.kv_ops = trie->btree_leaf_kv_ops;
+        }
+
+        // compare skipped prefix of the b-tree
+        cmp = 0;
+        for (i = prevchunkno+1; i < curchunkno && cmp == 0; ++i) {
+            if (i >= nchunk) {
+                // KEY is shorter than the prefix
+                cmp = -1;
+                break;
+            }
+            cmp = memcmp(key + i * trie->chunksize,
+                         (uint8_t*)hbmeta.prefix +
+                             (i - (prevchunkno+1)) * trie->chunksize,
+                         trie->chunksize);
+        }
+        if (cmp) {
+            // all keys in this b-tree are greater (or smaller) than KEY
+            *pos_out = (cmp < 0)?(base):(base + scale);
+            break;
+        }
+
+        if ((leaf && rawkeylen == curchunkno * trie->chunksize) ||
+            (!leaf && nchunk == curchunkno)) {
+            // KEY is same to the prefix .. the smallest one in the b-tree
+            *pos_out = base;
+            break;
+        }
+
+        chunk = key + curchunkno * trie->chunksize;
+        if (leaf) {
+            rawchunklen = _hbtrie_reform_key_reverse(
+                trie, chunk, (nchunk - curchunkno) * trie->chunksize);
+            _set_leaf_key(k, chunk, rawchunklen);
+            br = btree_get_key_position(&btree, k, v, &pos, &width, &exact);
+            _free_leaf_key(k);
+        } else {
+            br = btree_get_key_position(&btree, chunk, v, &pos, &width, &exact);
+        }
+
+        if (br == BTREE_RESULT_FAIL) {
+            // KEY is smaller than all keys in this b-tree
+            *pos_out = base;
+            break;
+        }
+        if (!exact) {
+            *pos_out = base + scale * (pos + width);
+            break;
+        }
+        if (leaf) {
+            *pos_out = base + scale * pos;
+            break;
+        }
+
+        if (_hbtrie_is_msb_set(trie, v)) {
+            // go down to the sub b-tree, narrowing the range
+            base += scale * pos;
+            scale *= width;
+            _hbtrie_clear_msb(trie, v);
+            bid = trie->btree_kv_ops->value2bid(v);
+            bid = _endian_decode(bid);
+            btree_init_from_bid(
+                &btree, trie->btreeblk_handle, trie->btree_blk_ops,
+                trie->btree_kv_ops, trie->btree_nodesize, bid);
+            btree.aux = trie->aux;
+        } else {
+            // single document .. compare its key with KEY
+            docrawkey = (uint8_t *)malloc(HBTRIE_MAX_KEYLEN);
+            offset = trie->btree_kv_ops->value2bid(v);
+            docrawkeylen = trie->readkey(trie->doc_handle, offset, docrawkey);
+            cmp = memcmp(docrawkey, rawkey,
+                         (docrawkeylen < (size_t)rawkeylen)?
+                             (docrawkeylen):(rawkeylen));
+            if (cmp == 0) {
+                cmp = (docrawkeylen < (size_t)rawkeylen)?(-1):(0);
+            }
+            free(docrawkey);
+            *pos_out = base + scale * ((cmp < 0)?(pos + width):(pos));
+            break;
+        }
+    }
+
+    mempool_free(bmeta.data);
+    return HBTRIE_RESULT_SUCCESS;
+}
+
+struct hbtrie_walk_ctx {
+    struct hbtrie *trie;
+    hbtrie_walk_func *func;
+    void *aux;
+    // root BIDs of the sub-trees to be visited
+    bid_t *roots;
+    size_t nroots;
+    size_t size;
+};
+
+static int _hbtrie_walk_level(struct btree *btree, uint16_t level,
+                              bid_t *bids, size_t nbids, void *aux)
+{
+    struct hbtrie_walk_ctx *ctx = (struct hbtrie_walk_ctx *)aux;
+    if (level == btree->height) {
+        // the root node has already been passed along with the other roots
+        return 1;
+    }
+    return ctx->func(ctx->trie, bids, nbids, ctx->aux);
+}
+
+static void _hbtrie_walk_value(struct btree *btree, void *key, void *value,
+                               void *aux)
+{
+    struct hbtrie_walk_ctx *ctx = (struct hbtrie_walk_ctx *)aux;
+    struct hbtrie *trie = ctx->trie;
+    uint8_t *v = alca(uint8_t, trie->valuelen);
+    bid_t bid;
+
+    if (!_hbtrie_is_msb_set(trie, value)) {
+        // document offset
+        return;
+    }
+    memcpy(v, value, trie->valuelen);
+    _hbtrie_clear_msb(trie, v);
+    bid = trie->btree_kv_ops->value2bid(v);
+    if (ctx->nroots == ctx->size) {
+        ctx->size *= 2;
+        ctx->roots = (bid_t *)realloc(ctx->roots, sizeof(bid_t) * ctx->size);
+    }
+    ctx->roots[ctx->nroots++] = _endian_decode(bid);
+}
+
+// visit the b-tree nodes of the HB+trie from the top: each b-tree is walked
+// level by level, and the sub-trees are visited after all b-trees of the
+// parent depth. FUNC is called with the BIDs of the nodes to be read next
+// (the roots of the sub-trees at the same depth, or a level of a b-tree),
+// and the walk stops if it returns zero. the leaf nodes of each b-tree are
+// read to find the sub-trees, except for leaf b-trees.
+hbtrie_result hbtrie_walk_nodes(struct hbtrie *trie,
+                                hbtrie_walk_func *func, void *aux)
+{
+    struct btree btree;
+    struct btree_meta bmeta;
+    struct hbtrie_meta hbmeta;
+    struct hbtrie_walk_ctx ctx;
+    hbtrie_result hr = HBTRIE_RESULT_SUCCESS;
+    btree_result br;
+    size_t i, begin, end;
+
+    if (trie->root_bid == BLK_NOT_FOUND) {
+        return HBTRIE_RESULT_FAIL;
+    }
+
+    ctx.trie = trie;
+    ctx.func = func;
+    ctx.aux = aux;
+    ctx.size = 16;
+    ctx.roots = (bid_t *)malloc(sizeof(bid_t) * ctx.size);
+    ctx.roots[0] = trie->root_bid;
+    ctx.nroots = 1;
+    bmeta.data = (void *)mempool_alloc(trie->btree_nodesize);
+
+    for (begin = 0; begin < ctx.nroots && hr == HBTRIE_RESULT_SUCCESS;
+         begin = end) {
+        // the roots of all sub-trees at the same depth
+        end = ctx.nroots;
+        if (!func(trie, ctx.roots + begin, end - begin, aux)) {
+            hr = HBTRIE_RESULT_FAIL;
+            break;
+        }
+        for (i = begin; i < end; ++i) {
+            btree_init_from_bid(
+                &btree, trie->btreeblk_handle, trie->btree_blk_ops,
+                trie->btree_kv_ops, trie->btree_nodesize, ctx.roots[i]);
+            btree.aux = trie->aux;
+            bmeta.size = btree_read_meta(&btree, bmeta.data);
+            _hbtrie_fetch_meta(trie, bmeta.size, &hbmeta, bmeta.data);
+
+            if (_is_leaf_btree(hbmeta.chunkno)) {
+                // leaf b-tree has no sub-tree
+                btree.kv_ops = trie->btree_leaf_kv_ops;
+                br = btree_walk_levels(&btree, _hbtrie_walk_level, NULL, &ctx);
+            } else {
+                br = btree_walk_levels(&btree, _hbtrie_walk_level,
+                                       _hbtrie_walk_value, &ctx);
+            }
+            if (br != BTREE_RESULT_SUCCESS) {
+                hr = HBTRIE_RESULT_FAIL;
+                break;
+            }
+        }
+    }
+
+    mempool_free(bmeta.data);
+    free(ctx.roots);
+    return hr;
 }
 
 INLINE hbtrie_result _hbtrie_remove(struct hbtrie *trie,
@@ -1340,7 +1951,7 @@ void _hbtrie_extend_leaf_tree(
 
     btree_init(&new_btree, trie->btreeblk_handle, trie->btree_blk_ops,
         trie->btree_kv_ops, trie->btree_nodesize, chunksize, trie->valuelen,
-        0x0, &meta);
+        _get_btree_node_flag(trie, trie->btree_kv_ops), &meta);
     new_btree.aux = trie->aux;
 
     // reset BTREEITEM
@@ -1391,7 +2002,6 @@ INLINE hbtrie_result _hbtrie_insert(struct hbtrie *trie,
     */
 
     int nchunk;
-    int keylen;
     int prevchunkno, curchunkno;
     int cpt_node = 0;
     int leaf_cond = 0;
@@ -1419,8 +2029,7 @@ INLINE hbtrie_result _hbtrie_insert(struct hbtrie *trie,
 
     meta.data = buf;
     curchunkno = 0;
-    keylen = _hbtrie_reform_key(trie, rawkey, rawkeylen, key);
-    (void)keylen;
+    _hbtrie_reform_key(trie, rawkey, rawkeylen, key);
 
     if (trie->map) { // custom cmp functions exist
         if (!memcmp(trie->last_map_chunk, key, trie->chunksize)) {
@@ -1447,7 +2056,8 @@ INLINE hbtrie_result _hbtrie_insert(struct hbtrie *trie,
         _hbtrie_store_meta(trie, &meta.size, 0, HBMETA_NORMAL, NULL, 0, NULL, buf);
         r = btree_init(
             &btreeitem->btree, trie->btreeblk_handle, trie->btree_blk_ops, trie->btree_kv_ops,
-            trie->btree_nodesize, trie->chunksize, trie->valuelen, 0x0, &meta);
+            trie->btree_nodesize, trie->chunksize, trie->valuelen,
+            _get_btree_node_flag(trie, trie->btree_kv_ops), &meta);
         if (r != BTREE_RESULT_SUCCESS) {
             return HBTRIE_RESULT_FAIL;
         }
@@ -1519,7 +2129,9 @@ INLINE hbtrie_result _hbtrie_insert(struct hbtrie *trie,
                 r = btree_init(&btreeitem_new->btree, trie->btreeblk_handle,
                                trie->btree_blk_ops, trie->btree_kv_ops,
                                trie->btree_nodesize, trie->chunksize,
-                               trie->valuelen, 0x0, &meta);
+                               trie->valuelen,
+                               _get_btree_node_flag(trie, trie->btree_kv_ops),
+                               &meta);
                 if (r != BTREE_RESULT_SUCCESS) {
                     return HBTRIE_RESULT_FAIL;
                 }
@@ -1755,7 +2367,8 @@ INLINE hbtrie_result _hbtrie_insert(struct hbtrie *trie,
                     r = btree_init(
                             &btreeitem_new->btree, trie->btreeblk_handle,
                             trie->btree_blk_ops, kv_ops,
-                            trie->btree_nodesize, trie->chunksize, trie->valuelen, 0x0, &meta);
+                            trie->btree_nodesize, trie->chunksize, trie->valuelen,
+                            _get_btree_node_flag(trie, kv_ops), &meta);
                     if (r == BTREE_RESULT_FAIL) {
                         return HBTRIE_RESULT_FAIL;
                     }
@@ -1795,7 +2408,8 @@ INLINE hbtrie_result _hbtrie_insert(struct hbtrie *trie,
                     r = btree_init(
                             &btreeitem_new->btree, trie->btreeblk_handle,
                             trie->btree_blk_ops, kv_ops,
-                            trie->btree_nodesize, trie->chunksize, trie->valuelen, 0x0, &meta);
+                            trie->btree_nodesize, trie->chunksize, trie->valuelen,
+                            _get_btree_node_flag(trie, kv_ops), &meta);
                     if (r == BTREE_RESULT_FAIL) {
                         ret_result = HBTRIE_RESULT_FAIL;
                     }
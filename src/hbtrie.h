@@ -31,6 +31,9 @@ extern "C" {
 typedef size_t hbtrie_func_readkey(void *handle, uint64_t offset, void *buf);
 typedef int hbtrie_cmp_func(void *key1, void *key2, void* aux);
 typedef voidref hbtrie_cmp_map(void *chunk, void *aux);
+typedef void hbtrie_sample_func(void *key, size_t keylen, void *aux);
+typedef int hbtrie_walk_func(struct hbtrie *trie, bid_t *bids, size_t nbids,
+                             void *aux);
 
 typedef enum {
     HBTRIE_RESULT_SUCCESS,
@@ -41,6 +44,28 @@ typedef enum {
 #define HBTRIE_FLAG_COMPACT (0x01)
 struct btree_blk_ops;
 struct btree_kv_ops;
+
+#define HBTRIE_PATH_CACHE_DEPTH (8)
+/**
+ * Root BIDs of the sub-trees visited by the last lookup. A lookup for a key
+ * sharing a prefix with the cached key starts from the deepest matching
+ * sub-tree, instead of descending from the root B+tree.
+ * Only paths under a committed (thus immutable) root node are cached, so the
+ * cache is dropped when the root node is changed by WAL flush, and becomes
+ * usable once the new root node is committed.
+ */
+struct hbtrie_path_cache {
+    bid_t root_bid;
+    int nlevels;
+    struct {
+        // the sub-tree is determined by the first (chunkno+1) chunks of key
+        int chunkno;
+        bid_t bid;
+    } levels[HBTRIE_PATH_CACHE_DEPTH];
+    uint8_t *key;
+    uint64_t nhits;
+};
+
 struct hbtrie {
     uint8_t chunksize;
     uint8_t valuelen;
@@ -58,6 +83,9 @@ struct hbtrie {
     hbtrie_func_readkey *readkey;
     hbtrie_cmp_map *map;
     void *last_map_chunk;
+    struct hbtrie_path_cache *path_cache;
+    uint8_t btree_node_flag; // node layout of new non-leaf b-trees
+    uint8_t btree_leaf_node_flag; // node layout of new leaf b-trees
 };
 
 struct hbtrie_iterator {
@@ -96,10 +124,12 @@ void hbtrie_free(struct hbtrie *trie);
 
 void hbtrie_set_flag(struct hbtrie *trie, uint8_t flag);
 void hbtrie_set_leaf_height_limit(struct hbtrie *trie, uint8_t limit);
+void hbtrie_set_node_flag(struct hbtrie *trie, uint8_t flag, uint8_t leaf_flag);
 void hbtrie_set_leaf_cmp(struct hbtrie *trie,
                          int (*cmp)(void *key1, void *key2, void* aux));
 void hbtrie_set_map_function(struct hbtrie *trie,
                              hbtrie_cmp_map *map_func);
+void hbtrie_invalidate_path_cache(struct hbtrie *trie);
 
 hbtrie_result hbtrie_iterator_init(
     struct hbtrie *trie, struct hbtrie_iterator *it, void *initial_key, size_t keylen);
@@ -120,6 +150,19 @@ hbtrie_result hbtrie_find_offset(struct hbtrie *trie, void *rawkey,
                         int rawkeylen, void *valuebuf);
 hbtrie_result hbtrie_find_partial(struct hbtrie *trie, void *rawkey,
                                   int rawkeylen, void *valuebuf);
+hbtrie_result hbtrie_get_sample_keys(struct hbtrie *trie,
+                                     void *start_key, int start_keylen,
+                                     void *end_key, int end_keylen,
+                                     int prefixlen,
+                                     size_t n,
+                                     hbtrie_sample_func *func,
+                                     void *aux);
+hbtrie_result hbtrie_get_key_position(struct hbtrie *trie,
+                                      void *rawkey, int rawkeylen,
+                                      double *pos_out);
+
+hbtrie_result hbtrie_walk_nodes(struct hbtrie *trie,
+                                hbtrie_walk_func *func, void *aux);
 
 hbtrie_result hbtrie_remove(struct hbtrie *trie, void *rawkey, int rawkeylen);
 hbtrie_result hbtrie_remove_partial(struct hbtrie *trie,
@@ -396,6 +396,44 @@ struct _fdb_iterator {
      * Key offset.
      */
     uint64_t _offset;
+    /**
+     * Buffer of document offsets for readahead.
+     */
+    uint64_t *prefetch_offsets;
+    /**
+     * Buffer of document block IDs for readahead.
+     */
+    bid_t *prefetch_bids;
+    /**
+     * Number of entries that the block ID buffer can hold.
+     */
+    size_t prefetch_bids_size;
+    /**
+     * Number of keys that can be consumed before the next readahead.
+     */
+    size_t prefetch_remain;
+    /**
+     * Key of the document that did not fit into the last batch
+     * (NULL if there is no such document).
+     */
+    void *pending_key;
+    /**
+     * Length of the pending key.
+     */
+    size_t pending_keylen;
+    /**
+     * Offset of the pending document.
+     */
+    uint64_t pending_offset;
+    /**
+     * Docio handle to read the pending document.
+     */
+    struct docio_handle *pending_dhandle;
+    /**
+     * Flag indicating that the last batch reached the end of the iteration,
+     * so that the next call returns no more document.
+     */
+    uint8_t pending_end;
 };
 
 struct wal_txn_wrapper;
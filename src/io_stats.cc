@@ -0,0 +1,157 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2010 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "common.h"
+#include "io_stats.h"
+
+#include "memleak.h"
+
+void io_stats_init(struct filemgr *file)
+{
+    file->io_stats = (struct io_stats *)calloc(1, sizeof(struct io_stats));
+}
+
+void io_stats_free(struct filemgr *file)
+{
+    free(file->io_stats);
+    file->io_stats = NULL;
+}
+
+void io_stats_add_read(struct filemgr *file, uint64_t len)
+{
+    if (!file || !file->io_stats) {
+        return;
+    }
+    atomic_add64(&file->io_stats->stats.num_reads, 1);
+    atomic_add64(&file->io_stats->stats.read_bytes, len);
+}
+
+void io_stats_add_write(struct filemgr *file, void *buf, uint64_t len)
+{
+    uint8_t marker;
+    uint64_t i, doc = 0, index = 0, header = 0;
+    fdb_io_stats *stats;
+
+    if (!file || !file->io_stats) {
+        return;
+    }
+    stats = &file->io_stats->stats;
+    atomic_add64(&stats->num_writes, 1);
+    atomic_add64(&stats->write_bytes, len);
+
+    if (file->io_stats->compacting) {
+        atomic_add64(&stats->compaction_bytes, len);
+        return;
+    }
+
+    if (len % file->blocksize) {
+        // partial block writes are issued by docio only
+        // (when the block cache is disabled)
+        atomic_add64(&stats->doc_bytes, len);
+        return;
+    }
+    for (i=0; i<len; i+=file->blocksize) {
+        marker = *((uint8_t *)buf + i + file->blocksize - BLK_MARKER_SIZE);
+        if (marker == BLK_MARKER_BNODE) {
+            index += file->blocksize;
+        } else if (marker == BLK_MARKER_DBHEADER) {
+            header += file->blocksize;
+        } else if (marker == BLK_MARKER_DOC) {
+            doc += file->blocksize;
+        }
+    }
+    if (doc) {
+        atomic_add64(&stats->doc_bytes, doc);
+    }
+    if (index) {
+        atomic_add64(&stats->index_bytes, index);
+    }
+    if (header) {
+        atomic_add64(&stats->header_bytes, header);
+    }
+}
+
+void io_stats_add_sync(struct filemgr *file)
+{
+    if (!file || !file->io_stats) {
+        return;
+    }
+    atomic_add64(&file->io_stats->stats.num_syncs, 1);
+}
+
+void io_stats_add_user_bytes(struct filemgr *file, uint64_t len)
+{
+    if (!file || !file->io_stats) {
+        return;
+    }
+    atomic_add64(&file->io_stats->stats.user_bytes, len);
+}
+
+void io_stats_add_system_doc(struct filemgr *file, uint64_t len)
+{
+    if (!file || !file->io_stats || file->io_stats->compacting) {
+        return;
+    }
+    atomic_add64(&file->io_stats->stats.kv_header_bytes, len);
+}
+
+void io_stats_set_compacting(struct filemgr *file, uint8_t compacting)
+{
+    if (!file || !file->io_stats) {
+        return;
+    }
+    file->io_stats->compacting = compacting;
+}
+
+void io_stats_get(struct filemgr *file, fdb_io_stats *stats)
+{
+    if (!file->io_stats) {
+        memset(stats, 0, sizeof(fdb_io_stats));
+        return;
+    }
+    *stats = file->io_stats->stats;
+}
+
+void io_stats_reset(struct filemgr *file)
+{
+    if (!file->io_stats) {
+        return;
+    }
+    memset(&file->io_stats->stats, 0, sizeof(fdb_io_stats));
+}
+
+void io_stats_merge(struct filemgr *dst, struct filemgr *src)
+{
+    size_t i;
+    uint64_t *d, *s;
+
+    if (!dst->io_stats || !src->io_stats) {
+        return;
+    }
+    // all the fields are 64-bit counters
+    d = (uint64_t *)&dst->io_stats->stats;
+    s = (uint64_t *)&src->io_stats->stats;
+    for (i=0; i<sizeof(fdb_io_stats) / sizeof(uint64_t); ++i) {
+        if (s[i]) {
+            atomic_add64(&d[i], s[i]);
+        }
+    }
+}
@@ -0,0 +1,60 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2010 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#ifndef _FDB_IO_STATS_H
+#define _FDB_IO_STATS_H
+
+#include <stdint.h>
+#include "internal_types.h"
+#include "filemgr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Per-file I/O counters. Counters are updated by atomic increments, as
+ * reads, block cache flushes, and commits may run concurrently.
+ */
+struct io_stats {
+    fdb_io_stats stats;
+    // set while the file is the destination of compaction
+    volatile uint8_t compacting;
+};
+
+void io_stats_init(struct filemgr *file);
+void io_stats_free(struct filemgr *file);
+
+void io_stats_add_read(struct filemgr *file, uint64_t len);
+// count a write of 'len' bytes; blocks in 'buf' are classified by their
+// markers if 'len' is a multiple of the block size.
+void io_stats_add_write(struct filemgr *file, void *buf, uint64_t len);
+void io_stats_add_sync(struct filemgr *file);
+void io_stats_add_user_bytes(struct filemgr *file, uint64_t len);
+void io_stats_add_system_doc(struct filemgr *file, uint64_t len);
+void io_stats_set_compacting(struct filemgr *file, uint8_t compacting);
+
+void io_stats_get(struct filemgr *file, fdb_io_stats *stats);
+void io_stats_reset(struct filemgr *file);
+// add the counters of 'src' into 'dst' (used when a file is compacted)
+void io_stats_merge(struct filemgr *dst, struct filemgr *src);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -33,6 +33,9 @@
 #include "list.h"
 #include "internal_types.h"
 #include "btree_var_kv_ops.h"
+#include "range_del.h"
+#include "slowlog.h"
+#include "lockprof.h"
 
 #include "memleak.h"
 
@@ -112,12 +115,13 @@ int _fdb_wal_cmp(struct avl_node *a, struct avl_node *b, void *aux)
     }
 }
 
-int _fdb_key_cmp(fdb_iterator *iterator, void *key1, size_t keylen1,
-                 void *key2, size_t keylen2) {
+static int _fdb_kvs_key_cmp(fdb_kvs_handle *handle,
+                            void *key1, size_t keylen1,
+                            void *key2, size_t keylen2) {
     int cmp;
-    if (iterator->handle.kvs_config.custom_cmp) {
+    if (handle->kvs_config.custom_cmp) {
         // custom compare function for variable length key
-        if (iterator->handle.kvs) {
+        if (handle->kvs) {
             // multi KV instance mode
             // KV ID should be compared separately
             size_t size_id = sizeof(fdb_kvs_id_t);
@@ -137,13 +141,13 @@ int _fdb_key_cmp(fdb_iterator *iterator, void *key1, size_t keylen1,
                 } else if (keylen2 == size_id) { // key1 > key2
                     return 1;
                 }
-                cmp = iterator->handle.kvs_config.custom_cmp(
+                cmp = handle->kvs_config.custom_cmp(
                           (uint8_t*)key1 + size_id, keylen1 - size_id,
                           (uint8_t*)key2 + size_id, keylen2 - size_id);
             }
         } else {
-            cmp = iterator->handle.kvs_config.custom_cmp(key1, keylen1,
-                                                       key2, keylen2);
+            cmp = handle->kvs_config.custom_cmp(key1, keylen1,
+                                                key2, keylen2);
         }
     } else {
         cmp = _fdb_keycmp(key1, keylen1, key2, keylen2);
@@ -151,6 +155,151 @@ int _fdb_key_cmp(fdb_iterator *iterator, void *key1, size_t keylen1,
     return cmp;
 }
 
+int _fdb_key_cmp(fdb_iterator *iterator, void *key1, size_t keylen1,
+                 void *key2, size_t keylen2) {
+    return _fdb_kvs_key_cmp(&iterator->handle, key1, keylen1, key2, keylen2);
+}
+
+// readahead window size encoded in the upper 16 bits of iterator option
+#define _FDB_ITR_PREFETCH_WINDOW(opt) (((opt) >> 16) & 0xffff)
+
+static int _fdb_offset_cmp(const void *a, const void *b)
+{
+    uint64_t aa = *(uint64_t *)a;
+    uint64_t bb = *(uint64_t *)b;
+
+    if (aa < bb) {
+        return -1;
+    } else if (aa > bb) {
+        return 1;
+    }
+    return 0;
+}
+
+// look ahead the next keys in hb-trie from the current key, and read
+// the blocks of their documents into the buffer cache in offset order,
+// once every WINDOW keys.
+static void _fdb_iterator_readahead(fdb_iterator *iterator)
+{
+    size_t i, n = 0, m = 0, keylen;
+    size_t window = _FDB_ITR_PREFETCH_WINDOW(iterator->opt);
+    size_t blocksize = iterator->handle.file->blocksize;
+    uint8_t *key = alca(uint8_t, FDB_MAX_KEYLEN_INTERNAL);
+    uint64_t offset;
+    bid_t bid, last_bid;
+    hbtrie_result hr;
+    struct hbtrie_iterator it;
+    struct docio_length length;
+
+    if (iterator->prefetch_remain > 0) {
+        // documents of this key have been already prefetched
+        iterator->prefetch_remain--;
+        return;
+    }
+
+    hr = hbtrie_iterator_init(iterator->handle.trie, &it,
+                              iterator->_key, iterator->_keylen);
+    while (hr == HBTRIE_RESULT_SUCCESS && n < window) {
+        hr = hbtrie_next(&it, key, &keylen, (void*)&offset);
+        if (hr == HBTRIE_RESULT_FAIL) {
+            break;
+        }
+        if (iterator->end_key &&
+            _fdb_key_cmp(iterator, key, keylen,
+                         iterator->end_key, iterator->end_keylen) > 0) {
+            break;
+        }
+        iterator->prefetch_offsets[n++] = _endian_decode(offset);
+    }
+    hbtrie_iterator_free(&it);
+    btreeblk_end(iterator->handle.bhandle);
+
+    // read the first block of each document, which contains its length
+    qsort(iterator->prefetch_offsets, n, sizeof(uint64_t), _fdb_offset_cmp);
+    for (i=0; i<n; ++i) {
+        iterator->prefetch_bids[i] = iterator->prefetch_offsets[i] / blocksize;
+    }
+    filemgr_readahead(iterator->handle.file, iterator->prefetch_bids, n,
+                      &iterator->handle.log_callback);
+
+    // and then the rest of the blocks of documents spanning multiple blocks
+    for (i=0; i<n; ++i) {
+        offset = iterator->prefetch_offsets[i];
+        length = docio_read_doc_length(iterator->handle.dhandle, offset);
+        if (length.keylen == 0) {
+            continue;
+        }
+        last_bid = docio_get_doc_last_bid(iterator->handle.dhandle,
+                                          offset, length);
+        for (bid = offset / blocksize + 1; bid <= last_bid; ++bid) {
+            if (m == iterator->prefetch_bids_size) {
+                iterator->prefetch_bids_size *= 2;
+                iterator->prefetch_bids = (bid_t *)
+                    realloc(iterator->prefetch_bids,
+                            sizeof(bid_t) * iterator->prefetch_bids_size);
+            }
+            iterator->prefetch_bids[m++] = bid;
+        }
+    }
+    filemgr_readahead(iterator->handle.file, iterator->prefetch_bids, m,
+                      &iterator->handle.log_callback);
+    // the current key is consumed by the caller
+    iterator->prefetch_remain = (n > 0)?(n - 1):(0);
+}
+
+// copy an entry of the snapshot, since the entries of in-memory snapshots
+// are shared and may be modified by WAL while iterating
+static struct snap_wal_entry * _fdb_snap_item_copy(struct snap_wal_entry *entry)
+{
+    struct snap_wal_entry *snap_item;
+
+    snap_item = (struct snap_wal_entry*)malloc(sizeof(struct snap_wal_entry));
+    snap_item->keylen = entry->keylen;
+    snap_item->key = (void*)malloc(snap_item->keylen);
+    memcpy(snap_item->key, entry->key, snap_item->keylen);
+    snap_item->seqnum = entry->seqnum;
+    snap_item->action = entry->action;
+    snap_item->offset = entry->offset;
+    snap_item->flag = entry->flag;
+    return snap_item;
+}
+
+static void _fdb_snap_scan_bykey(void *ctx, struct snap_wal_entry *entry)
+{
+    fdb_iterator *iterator = (fdb_iterator *)ctx;
+    struct snap_wal_entry *snap_item;
+
+    if (iterator->start_key &&
+        _fdb_key_cmp(iterator, iterator->start_key, iterator->start_keylen,
+                     entry->key, entry->keylen) > 0) {
+        return;
+    }
+    snap_item = _fdb_snap_item_copy(entry);
+    avl_insert(iterator->wal_tree, &snap_item->avl, _fdb_wal_cmp);
+}
+
+static void _fdb_snap_scan_byseq(void *ctx, struct snap_wal_entry *entry)
+{
+    fdb_iterator *iterator = (fdb_iterator *)ctx;
+    struct snap_wal_entry *snap_item;
+    fdb_kvs_id_t kv_id, _kv_id;
+
+    if (entry->seqnum < iterator->_seqnum) {
+        return;
+    }
+    if (iterator->handle.kvs) { // multi KV instance mode
+        // get KV ID from key
+        _kv_id = *((fdb_kvs_id_t*)entry->key);
+        kv_id = _endian_decode(_kv_id);
+        if (kv_id != iterator->handle.kvs->id) {
+            // KV instance doesn't match
+            return;
+        }
+    }
+    snap_item = _fdb_snap_item_copy(entry);
+    avl_insert(iterator->wal_tree, &snap_item->avl, _fdb_seqnum_cmp);
+}
+
 fdb_status fdb_iterator_init(fdb_kvs_handle *handle,
                              fdb_iterator **ptr_iterator,
                              const void *start_key,
@@ -191,6 +340,18 @@ fdb_status fdb_iterator_init(fdb_kvs_handle *handle,
     iterator->hbtrie_iterator = NULL;
     iterator->idtree_iterator = NULL;
     iterator->seqtree_iterator = NULL;
+    if (_FDB_ITR_PREFETCH_WINDOW(opt) && !(opt & FDB_ITR_KEYS_ONLY)) {
+        iterator->prefetch_bids_size = _FDB_ITR_PREFETCH_WINDOW(opt);
+        iterator->prefetch_offsets = (uint64_t *)
+            malloc(sizeof(uint64_t) * iterator->prefetch_bids_size);
+        iterator->prefetch_bids = (bid_t *)
+            malloc(sizeof(bid_t) * iterator->prefetch_bids_size);
+    } else {
+        iterator->prefetch_offsets = NULL;
+        iterator->prefetch_bids = NULL;
+        iterator->prefetch_bids_size = 0;
+    }
+    iterator->prefetch_remain = 0;
 
     if (handle->kvs) {
         // multi KV instance mode .. prepend KV ID
@@ -283,7 +444,7 @@ fdb_status fdb_iterator_init(fdb_kvs_handle *handle,
         iterator->wal_tree = (struct avl_tree*)malloc(sizeof(struct avl_tree));
         avl_init(iterator->wal_tree, (void*)handle);
 
-        spin_lock(&wal_file->wal->lock);
+        LOCKPROF_SPIN_LOCK(FDB_LOCK_WAL, &wal_file->wal->lock);
         he = list_begin(&wal_file->wal->list);
         while(he) {
             wal_item_header = _get_entry(he, struct wal_item_header, list_elem);
@@ -313,6 +474,7 @@ fdb_status fdb_iterator_init(fdb_kvs_handle *handle,
                     snap_item->keylen = wal_item_header->keylen;
                     snap_item->key = (void*)malloc(snap_item->keylen);
                     memcpy(snap_item->key, wal_item_header->key, snap_item->keylen);
+                    snap_item->seqnum = wal_item->seqnum;
                     snap_item->action = wal_item->action;
                     snap_item->offset = wal_item->offset;
                     if (wal_file == handle->new_file) {
@@ -330,7 +492,10 @@ fdb_status fdb_iterator_init(fdb_kvs_handle *handle,
 
         spin_unlock(&wal_file->wal->lock);
     } else {
-        iterator->wal_tree = handle->shandle->key_tree;
+        // copy the entries visible to the snapshot
+        iterator->wal_tree = (struct avl_tree*)malloc(sizeof(struct avl_tree));
+        avl_init(iterator->wal_tree, (void*)handle);
+        snap_scan(handle->shandle, (void *)iterator, _fdb_snap_scan_bykey);
     }
 
     if (iterator->wal_tree) {
@@ -366,7 +531,7 @@ fdb_status fdb_iterator_sequence_init(fdb_kvs_handle *handle,
     uint8_t *start_seq_kv;
 
     if (handle == NULL || ptr_iterator == NULL ||
-        start_seq > end_seq) {
+        start_seq > end_seq || (opt & FDB_ITR_KEYS_ONLY)) {
         return FDB_RESULT_INVALID_ARGS;
     }
 
@@ -450,7 +615,7 @@ fdb_status fdb_iterator_sequence_init(fdb_kvs_handle *handle,
                              malloc(sizeof(struct avl_tree));
         avl_init(iterator->wal_tree, (void*)_fdb_seqnum_cmp);
 
-        spin_lock(&wal_file->wal->lock);
+        LOCKPROF_SPIN_LOCK(FDB_LOCK_WAL, &wal_file->wal->lock);
         he = list_begin(&wal_file->wal->list);
         while(he) {
             wal_item_header = _get_entry(he, struct wal_item_header, list_elem);
@@ -503,7 +668,11 @@ fdb_status fdb_iterator_sequence_init(fdb_kvs_handle *handle,
         }
         spin_unlock(&wal_file->wal->lock);
     } else {
-        iterator->wal_tree = handle->shandle->seq_tree;
+        // copy the entries visible to the snapshot
+        iterator->wal_tree = (struct avl_tree*)
+                             malloc(sizeof(struct avl_tree));
+        avl_init(iterator->wal_tree, (void*)_fdb_seqnum_cmp);
+        snap_scan(handle->shandle, (void *)iterator, _fdb_snap_scan_byseq);
     }
 
     if (iterator->wal_tree) {
@@ -523,6 +692,91 @@ fdb_status fdb_iterator_sequence_init(fdb_kvs_handle *handle,
     return FDB_RESULT_SUCCESS;
 }
 
+// get the sequence number and deletion flag of the item that is just taken
+// by the key iterator (SNAP_ITEM is NULL if the item is from the main index),
+// without reading the document if possible
+static fdb_status _fdb_iterator_key_entry(fdb_iterator *iterator,
+                                          void *key, size_t keylen,
+                                          uint64_t offset,
+                                          struct docio_handle *dhandle,
+                                          struct snap_wal_entry *snap_item,
+                                          fdb_seqnum_t *seqnum,
+                                          bool *deleted)
+{
+    uint64_t _offset;
+    struct docio_object _doc;
+
+    if (snap_item) {
+        // WAL entry already has both of them
+        // (REMOVE and NO_DELETES are already filtered out)
+        *seqnum = snap_item->seqnum;
+        *deleted = (snap_item->action == WAL_ACT_LOGICAL_REMOVE);
+    } else if (_fdb_range_del_exist(&iterator->handle)) {
+        // sequence number is necessary to check range tombstones
+        memset(&_doc, 0x0, sizeof(struct docio_object));
+        _doc.key = key;
+        _offset = docio_read_doc_key_meta(dhandle, offset, &_doc);
+        if (_offset == offset) {
+            return FDB_RESULT_KEY_NOT_FOUND;
+        }
+        free(_doc.meta);
+        *seqnum = _doc.seqnum;
+        *deleted = _doc.length.flag & DOCIO_DELETED;
+        if (*deleted && (iterator->opt & FDB_ITR_NO_DELETES)) {
+            return FDB_RESULT_KEY_NOT_FOUND;
+        }
+    } else if (iterator->opt & FDB_ITR_NO_DELETES) {
+        // read the length header only
+        struct docio_length length = docio_read_doc_length(dhandle, offset);
+        if (length.keylen == 0 || length.flag & DOCIO_DELETED) {
+            return FDB_RESULT_KEY_NOT_FOUND;
+        }
+        *seqnum = SEQNUM_NOT_USED;
+        *deleted = false;
+        return FDB_RESULT_SUCCESS;
+    } else {
+        *seqnum = SEQNUM_NOT_USED;
+        *deleted = false;
+        return FDB_RESULT_SUCCESS;
+    }
+
+    if (_fdb_range_del_covered(&iterator->handle, key, keylen, *seqnum)) {
+        // deleted by range tombstone
+        return FDB_RESULT_KEY_NOT_FOUND;
+    }
+    return FDB_RESULT_SUCCESS;
+}
+
+// create a document that contains the key only
+static fdb_status _fdb_iterator_key_doc(fdb_iterator *iterator,
+                                        fdb_doc **doc,
+                                        void *key, size_t keylen,
+                                        uint64_t offset,
+                                        struct docio_handle *dhandle,
+                                        struct snap_wal_entry *snap_item)
+{
+    bool deleted;
+    fdb_seqnum_t seqnum;
+    fdb_status fs;
+    size_t size_id = (iterator->handle.kvs)?(sizeof(fdb_kvs_id_t)):(0);
+
+    fs = _fdb_iterator_key_entry(iterator, key, keylen, offset, dhandle,
+                                 snap_item, &seqnum, &deleted);
+    if (fs != FDB_RESULT_SUCCESS) {
+        return fs;
+    }
+    // eliminate KV ID from 'key'
+    fs = fdb_doc_create(doc, (uint8_t*)key + size_id, keylen - size_id,
+                        NULL, 0, NULL, 0);
+    if (fs != FDB_RESULT_SUCCESS) {
+        return fs;
+    }
+    (*doc)->seqnum = seqnum;
+    (*doc)->deleted = deleted;
+    (*doc)->offset = offset;
+    return FDB_RESULT_SUCCESS;
+}
+
 // DOC returned by this function must be freed using 'fdb_doc_free'
 static fdb_status _fdb_iterator_prev(fdb_iterator *iterator,
                                      fdb_doc **doc)
@@ -634,6 +888,14 @@ start:
         }
     }
 
+    if (iterator->opt & FDB_ITR_KEYS_ONLY) {
+        if (iterator->status != FDB_ITR_WAL) {
+            snap_item = NULL;
+        }
+        return _fdb_iterator_key_doc(iterator, doc, key, keylen, offset,
+                                     dhandle, snap_item);
+    }
+
     _doc.key = key;
     _doc.length.keylen = keylen;
     _doc.length.bodylen = 0;
@@ -660,6 +922,13 @@ start:
             return FDB_RESULT_KEY_NOT_FOUND;
         }
     }
+    if (_fdb_range_del_covered(&iterator->handle, _doc.key,
+                               _doc.length.keylen, _doc.seqnum)) {
+        // deleted by range tombstone
+        free(_doc.meta);
+        free(_doc.body);
+        return FDB_RESULT_KEY_NOT_FOUND;
+    }
 
     if (iterator->handle.kvs) {
         // eliminate KV ID from 'key'
@@ -685,9 +954,127 @@ start:
 
     return FDB_RESULT_SUCCESS;
 }
+
+// caller-provided buffer for batched iteration:
+// fdb_doc array grows from the head, and packed data grows from the tail
+struct _fdb_itr_arena {
+    uint8_t *buf;
+    size_t head;
+    size_t tail;
+    size_t count;
+};
+
+// read the document at OFFSET into ARENA without any memory allocation
+static fdb_status _fdb_iterator_fetch_arena(fdb_iterator *iterator,
+                                            void *key, size_t keylen,
+                                            uint64_t offset,
+                                            struct docio_handle *dhandle,
+                                            struct snap_wal_entry *snap_item,
+                                            struct _fdb_itr_arena *arena)
+{
+    size_t size_id = (iterator->handle.kvs)?(sizeof(fdb_kvs_id_t)):(0);
+    size_t datalen;
+    uint64_t _offset;
+    uint8_t *data;
+    bool deleted;
+    fdb_seqnum_t seqnum;
+    fdb_status fs;
+    fdb_doc *doc;
+    struct docio_object _doc;
+    struct docio_length length;
+
+    if (iterator->opt & FDB_ITR_KEYS_ONLY) {
+        fs = _fdb_iterator_key_entry(iterator, key, keylen, offset, dhandle,
+                                     snap_item, &seqnum, &deleted);
+        if (fs != FDB_RESULT_SUCCESS) {
+            return fs;
+        }
+        datalen = keylen - size_id;
+        if (arena->head + sizeof(fdb_doc) + datalen > arena->tail) {
+            goto pending;
+        }
+        data = arena->buf + arena->tail - datalen;
+        memcpy(data, (uint8_t*)key + size_id, keylen - size_id);
+
+        doc = (fdb_doc *)(arena->buf + arena->head);
+        memset(doc, 0x0, sizeof(fdb_doc));
+        doc->key = data;
+        doc->keylen = keylen - size_id;
+        doc->seqnum = seqnum;
+        doc->deleted = deleted;
+        doc->offset = offset;
+        goto done;
+    }
+
+    length = docio_read_doc_length(dhandle, offset);
+    if (length.keylen != keylen) {
+        return FDB_RESULT_KEY_NOT_FOUND;
+    }
+    if (length.flag & DOCIO_DELETED && (iterator->opt & FDB_ITR_NO_DELETES)) {
+        return FDB_RESULT_KEY_NOT_FOUND;
+    }
+
+    datalen = keylen - size_id + length.metalen;
+    if (!(iterator->opt & FDB_ITR_METAONLY)) {
+        datalen += length.bodylen;
+    }
+    if (arena->head + sizeof(fdb_doc) + datalen > arena->tail) {
+pending:
+        // not enough space .. return this document at the next call
+        iterator->pending_key = key;
+        iterator->pending_keylen = keylen;
+        iterator->pending_offset = offset;
+        iterator->pending_dhandle = dhandle;
+        return FDB_RESULT_TOO_SMALL_BUFFER;
+    }
+
+    // [user key][meta][body]
+    data = arena->buf + arena->tail - datalen;
+    _doc.key = key;
+    _doc.length.keylen = keylen;
+    _doc.meta = data + keylen - size_id;
+    _doc.body = data + keylen - size_id + length.metalen;
+    if (iterator->opt & FDB_ITR_METAONLY) {
+        _offset = docio_read_doc_key_meta(dhandle, offset, &_doc);
+        _doc.length.bodylen = 0;
+    } else {
+        _offset = docio_read_doc(dhandle, offset, &_doc);
+    }
+    if (_offset == offset) {
+        return FDB_RESULT_KEY_NOT_FOUND;
+    }
+    if (_fdb_range_del_covered(&iterator->handle, _doc.key,
+                               _doc.length.keylen, _doc.seqnum)) {
+        // deleted by range tombstone
+        return FDB_RESULT_KEY_NOT_FOUND;
+    }
+    memcpy(data, (uint8_t*)key + size_id, keylen - size_id);
+
+    doc = (fdb_doc *)(arena->buf + arena->head);
+    memset(doc, 0x0, sizeof(fdb_doc));
+    doc->key = data;
+    doc->keylen = keylen - size_id;
+    doc->meta = (_doc.length.metalen)?(_doc.meta):(NULL);
+    doc->metalen = _doc.length.metalen;
+    doc->body = (_doc.length.bodylen)?(_doc.body):(NULL);
+    doc->bodylen = _doc.length.bodylen;
+    doc->seqnum = _doc.seqnum;
+    doc->deleted = _doc.length.flag & DOCIO_DELETED;
+    doc->offset = offset;
+
+done:
+    arena->head += sizeof(fdb_doc);
+    arena->tail -= datalen;
+    arena->count++;
+
+    return FDB_RESULT_SUCCESS;
+}
+
 // DOC returned by this function must be freed using 'fdb_doc_free'
+// (if ARENA is given, the document is packed into ARENA instead)
 static fdb_status _fdb_iterator_next(fdb_iterator *iterator,
-                                     fdb_doc **doc)
+                                     fdb_doc **doc,
+                                     struct _fdb_itr_arena *arena)
 {
     int cmp;
     void *key;
@@ -699,6 +1086,25 @@ static fdb_status _fdb_iterator_next(fdb_iterator *iterator,
     struct docio_handle *dhandle;
     struct snap_wal_entry *snap_item = NULL;
 
+    if (iterator->pending_end) {
+        // the last batch already reached the end
+        iterator->pending_end = 0;
+        return FDB_RESULT_ITERATOR_FAIL;
+    }
+    if (iterator->pending_key) {
+        // the document that did not fit into the last batch buffer
+        key = iterator->pending_key;
+        keylen = iterator->pending_keylen;
+        offset = iterator->pending_offset;
+        dhandle = iterator->pending_dhandle;
+        if (iterator->status == FDB_ITR_WAL) {
+            snap_item = _get_entry(iterator->tree_cursor_prev,
+                                   struct snap_wal_entry, avl);
+        }
+        iterator->pending_key = NULL;
+        goto fetch;
+    }
+
     if (iterator->direction == FDB_ITR_REVERSE) {
         iterator->_offset = BLK_NOT_FOUND; // need to re-examine Trie/trees
         if (iterator->tree_cursor) {
@@ -730,6 +1136,9 @@ start:
                          &iterator->_keylen, (void*)&iterator->_offset);
         btreeblk_end(iterator->handle.bhandle);
         iterator->_offset = _endian_decode(iterator->_offset);
+        if (hr != HBTRIE_RESULT_FAIL && iterator->prefetch_bids) {
+            _fdb_iterator_readahead(iterator);
+        }
     }
 
     keylen = iterator->_keylen;
@@ -804,6 +1213,20 @@ start:
         }
     }
 
+fetch:
+    if (iterator->status != FDB_ITR_WAL) {
+        // SNAP_ITEM is the WAL item that is returned
+        snap_item = NULL;
+    }
+    if (arena) {
+        return _fdb_iterator_fetch_arena(iterator, key, keylen, offset,
+                                         dhandle, snap_item, arena);
+    }
+    if (iterator->opt & FDB_ITR_KEYS_ONLY) {
+        return _fdb_iterator_key_doc(iterator, doc, key, keylen, offset,
+                                     dhandle, snap_item);
+    }
+
     _doc.key = key;
     _doc.length.keylen = keylen;
     _doc.length.bodylen = 0;
@@ -830,6 +1253,13 @@ start:
             return FDB_RESULT_KEY_NOT_FOUND;
         }
     }
+    if (_fdb_range_del_covered(&iterator->handle, _doc.key,
+                               _doc.length.keylen, _doc.seqnum)) {
+        // deleted by range tombstone
+        free(_doc.meta);
+        free(_doc.body);
+        return FDB_RESULT_KEY_NOT_FOUND;
+    }
 
     if (iterator->handle.kvs) {
         // eliminate KV ID from 'key'
@@ -856,8 +1286,9 @@ start:
     return FDB_RESULT_SUCCESS;
 }
 
-fdb_status fdb_iterator_seek(fdb_iterator *iterator, const void *seek_key,
-                             const size_t seek_keylen) {
+static fdb_status _fdb_iterator_seek(fdb_iterator *iterator,
+                                     const void *seek_key,
+                                     const size_t seek_keylen) {
     hbtrie_result hr = HBTRIE_RESULT_SUCCESS;
     struct snap_wal_entry *snap_item = NULL;
     int dir; // compare result gives seek direction >0 is forward, <=0 reverse
@@ -872,6 +1303,9 @@ fdb_status fdb_iterator_seek(fdb_iterator *iterator, const void *seek_key,
         seek_keylen > iterator->handle.config.blocksize - 256) {
         return FDB_RESULT_INVALID_ARGS;
     }
+    // the document pending for the next batch is discarded
+    iterator->pending_key = NULL;
+    iterator->pending_end = 0;
 
     if (iterator->handle.kvs) {
         seek_keylen_kv = seek_keylen + sizeof(fdb_kvs_id_t);
@@ -902,6 +1336,8 @@ fdb_status fdb_iterator_seek(fdb_iterator *iterator, const void *seek_key,
     dir = _fdb_key_cmp(iterator, (void *)seek_key_kv, seek_keylen_kv,
                     (void *)iterator->_key, iterator->_keylen);
     save_direction = dir;
+    // readahead should be restarted from the new position
+    iterator->prefetch_remain = 0;
 
     // Roll the hb-trie/btree iterator to seek key based on direction
     while (hr == HBTRIE_RESULT_SUCCESS && finalRun--) {
@@ -997,6 +1433,23 @@ fdb_status fdb_iterator_seek(fdb_iterator *iterator, const void *seek_key,
     return FDB_RESULT_SUCCESS;
 }
 
+static void _fdb_iterator_slowlog_end(fdb_iterator *iterator, bool tracked,
+                                      const char *op_name)
+{
+    slowlog_op_end(tracked, iterator->handle.config.slow_op_threshold,
+                   &iterator->handle.log_callback, op_name,
+                   iterator->handle.file->filename);
+}
+
+fdb_status fdb_iterator_seek(fdb_iterator *iterator, const void *seek_key,
+                             const size_t seek_keylen) {
+    bool slow_tracked =
+        slowlog_op_begin(iterator->handle.config.slow_op_threshold);
+    fdb_status result = _fdb_iterator_seek(iterator, seek_key, seek_keylen);
+    _fdb_iterator_slowlog_end(iterator, slow_tracked, "fdb_iterator_seek");
+    return result;
+}
+
 // DOC returned by this function must be freed using 'fdb_doc_free'
 static fdb_status _fdb_iterator_seq_prev(fdb_iterator *iterator,
                                      fdb_doc **doc)
@@ -1129,6 +1582,14 @@ start_seq:
             return FDB_RESULT_KEY_NOT_FOUND;
         }
     }
+    if (_fdb_range_del_covered(&iterator->handle, _doc.key,
+                               _doc.length.keylen, _doc.seqnum)) {
+        // deleted by range tombstone
+        free(_doc.key);
+        free(_doc.meta);
+        free(_doc.body);
+        return FDB_RESULT_KEY_NOT_FOUND;
+    }
 
     // To prevent returning duplicate items from sequence iterator, only return
     // those b-tree items that exist in HB-trie but not WAL
@@ -1363,6 +1824,14 @@ start_seq:
             return FDB_RESULT_KEY_NOT_FOUND;
         }
     }
+    if (_fdb_range_del_covered(&iterator->handle, _doc.key,
+                               _doc.length.keylen, _doc.seqnum)) {
+        // deleted by range tombstone
+        free(_doc.key);
+        free(_doc.meta);
+        free(_doc.body);
+        return FDB_RESULT_KEY_NOT_FOUND;
+    }
 
     // To prevent returning duplicate items from sequence iterator, only return
     // those b-tree items that exist in HB-trie but not WAL (visit WAL later)
@@ -1459,6 +1928,11 @@ fdb_status fdb_iterator_next_metaonly(fdb_iterator *iterator,
 fdb_status fdb_iterator_prev(fdb_iterator *iterator, fdb_doc **doc)
 {
     fdb_status result = FDB_RESULT_SUCCESS;
+    bool slow_tracked =
+        slowlog_op_begin(iterator->handle.config.slow_op_threshold);
+    // the document pending for the next batch is skipped
+    iterator->pending_key = NULL;
+    iterator->pending_end = 0;
     if (iterator->hbtrie_iterator || iterator->idtree_iterator) {
         while ((result = _fdb_iterator_prev(iterator, doc)) ==
                 FDB_RESULT_KEY_NOT_FOUND);
@@ -1484,22 +1958,15 @@ fdb_status fdb_iterator_prev(fdb_iterator *iterator, fdb_doc **doc)
             }
         }
     }
+    _fdb_iterator_slowlog_end(iterator, slow_tracked, "fdb_iterator_prev");
     return result;
 }
 
-fdb_status fdb_iterator_next(fdb_iterator *iterator, fdb_doc **doc)
+// rewind the WAL cursor when the forward iteration reaches the end,
+// so that the following reverse iteration starts from the last document
+static void _fdb_iterator_next_end(fdb_iterator *iterator)
 {
-    fdb_status result = FDB_RESULT_SUCCESS;
-    if (iterator->hbtrie_iterator || iterator->idtree_iterator) {
-        while ((result = _fdb_iterator_next(iterator, doc)) ==
-                FDB_RESULT_KEY_NOT_FOUND);
-    } else {
-        while ((result = _fdb_iterator_seq_next(iterator, doc)) ==
-                FDB_RESULT_KEY_NOT_FOUND);
-    }
-    if (result == FDB_RESULT_SUCCESS) {
-        iterator->direction = FDB_ITR_FORWARD;
-    } else if (iterator->direction != FDB_ITR_DIR_NONE) {
+    if (iterator->direction != FDB_ITR_DIR_NONE) {
         iterator->direction = FDB_ITR_DIR_NONE;
         if (iterator->seqtree_iterator &&
             iterator->status == FDB_ITR_IDX) {
@@ -1514,6 +1981,73 @@ fdb_status fdb_iterator_next(fdb_iterator *iterator, fdb_doc **doc)
             iterator->tree_cursor_prev = iterator->tree_cursor;
         }
     }
+}
+
+fdb_status fdb_iterator_next(fdb_iterator *iterator, fdb_doc **doc)
+{
+    fdb_status result = FDB_RESULT_SUCCESS;
+    bool slow_tracked =
+        slowlog_op_begin(iterator->handle.config.slow_op_threshold);
+    if (iterator->hbtrie_iterator || iterator->idtree_iterator) {
+        while ((result = _fdb_iterator_next(iterator, doc, NULL)) ==
+                FDB_RESULT_KEY_NOT_FOUND);
+    } else {
+        while ((result = _fdb_iterator_seq_next(iterator, doc)) ==
+                FDB_RESULT_KEY_NOT_FOUND);
+    }
+    if (result == FDB_RESULT_SUCCESS) {
+        iterator->direction = FDB_ITR_FORWARD;
+    } else {
+        _fdb_iterator_next_end(iterator);
+    }
+    _fdb_iterator_slowlog_end(iterator, slow_tracked, "fdb_iterator_next");
+    return result;
+}
+
+fdb_status fdb_iterator_next_batch(fdb_iterator *iterator,
+                                   void *buf, size_t bufsize,
+                                   size_t *count)
+{
+    fdb_status result = FDB_RESULT_SUCCESS;
+    struct _fdb_itr_arena arena;
+
+    if (!iterator || !buf || !count) {
+        return FDB_RESULT_INVALID_ARGS;
+    }
+    *count = 0;
+    if (!(iterator->hbtrie_iterator || iterator->idtree_iterator)) {
+        // sequence iterator is not supported
+        return FDB_RESULT_INVALID_ARGS;
+    }
+
+    arena.buf = (uint8_t *)buf;
+    arena.head = 0;
+    // keep fdb_doc array aligned
+    arena.tail = bufsize - (bufsize % sizeof(void *));
+    arena.count = 0;
+
+    while (true) {
+        result = _fdb_iterator_next(iterator, NULL, &arena);
+        if (result == FDB_RESULT_SUCCESS) {
+            iterator->direction = FDB_ITR_FORWARD;
+        } else if (result != FDB_RESULT_KEY_NOT_FOUND) {
+            break;
+        }
+    }
+    if (result == FDB_RESULT_ITERATOR_FAIL) {
+        _fdb_iterator_next_end(iterator);
+        if (arena.count) {
+            // report the end of iteration at the next call
+            iterator->pending_end = 1;
+        }
+    } else if (result == FDB_RESULT_TOO_SMALL_BUFFER) {
+        iterator->direction = FDB_ITR_FORWARD;
+    }
+
+    *count = arena.count;
+    if (arena.count) {
+        return FDB_RESULT_SUCCESS;
+    }
     return result;
 }
 
@@ -1545,22 +2079,290 @@ fdb_status fdb_iterator_close(fdb_iterator *iterator)
     if (iterator->end_key) {
         free(iterator->end_key);
     }
+    free(iterator->prefetch_offsets);
+    free(iterator->prefetch_bids);
 
-    if (!iterator->handle.shandle) {
-        a = avl_first(iterator->wal_tree);
-        while(a) {
-            snap_item = _get_entry(a, struct snap_wal_entry, avl);
-            a = avl_next(a);
-            avl_remove(iterator->wal_tree, &snap_item->avl);
-
-            free(snap_item->key);
-            free(snap_item);
-        }
+    a = avl_first(iterator->wal_tree);
+    while(a) {
+        snap_item = _get_entry(a, struct snap_wal_entry, avl);
+        a = avl_next(a);
+        avl_remove(iterator->wal_tree, &snap_item->avl);
 
-        free(iterator->wal_tree);
+        free(snap_item->key);
+        free(snap_item);
     }
+    free(iterator->wal_tree);
     free(iterator->_key);
     free(iterator);
 
     return FDB_RESULT_SUCCESS;
 }
+
+struct _fdb_split_samples {
+    fdb_kvs_handle *handle;
+    void *start_key;
+    size_t start_keylen;
+    void *end_key;
+    size_t end_keylen;
+    void **keys;
+    size_t *keylens;
+    size_t num;
+    size_t size;
+};
+
+// callback for hbtrie_get_sample_keys(); keep the keys within the range only
+static void _fdb_split_sample_cb(void *key, size_t keylen, void *aux)
+{
+    struct _fdb_split_samples *samples = (struct _fdb_split_samples *)aux;
+    fdb_kvs_handle *handle = samples->handle;
+
+    if (samples->num == samples->size) {
+        return;
+    }
+    if (samples->start_key &&
+        _fdb_kvs_key_cmp(handle, key, keylen, samples->start_key,
+                         samples->start_keylen) <= 0) {
+        return;
+    }
+    if (samples->end_key &&
+        _fdb_kvs_key_cmp(handle, key, keylen, samples->end_key,
+                         samples->end_keylen) >= 0) {
+        return;
+    }
+    if (samples->num &&
+        _fdb_kvs_key_cmp(handle, key, keylen,
+                         samples->keys[samples->num-1],
+                         samples->keylens[samples->num-1]) <= 0) {
+        // duplicate (samples are given in the key order)
+        return;
+    }
+    samples->keys[samples->num] = (void *)malloc(keylen);
+    memcpy(samples->keys[samples->num], key, keylen);
+    samples->keylens[samples->num] = keylen;
+    samples->num++;
+}
+
+fdb_status fdb_iterator_split(fdb_kvs_handle *handle,
+                              const void *start_key,
+                              size_t start_keylen,
+                              const void *end_key,
+                              size_t end_keylen,
+                              size_t num_partitions,
+                              fdb_split_key_list *split_keys)
+{
+    size_t i, idx, prev_idx, nkeys, datasize;
+    size_t prefixlen, size_id, nsample;
+    uint8_t *ptr;
+    struct _fdb_split_samples samples;
+
+    if (handle == NULL || split_keys == NULL || num_partitions == 0 ||
+        start_keylen > FDB_MAX_KEYLEN ||
+        end_keylen > FDB_MAX_KEYLEN) {
+        return FDB_RESULT_INVALID_ARGS;
+    }
+    split_keys->num_keys = 0;
+    split_keys->keys = NULL;
+    split_keys->keylens = NULL;
+    if (num_partitions == 1) {
+        return FDB_RESULT_SUCCESS;
+    }
+
+    if (!handle->shandle) {
+        fdb_check_file_reopen(handle);
+        fdb_link_new_file(handle);
+        fdb_sync_db_header(handle);
+    }
+
+    memset(&samples, 0x0, sizeof(samples));
+    samples.handle = handle;
+    size_id = (handle->kvs)?(sizeof(fdb_kvs_id_t)):(0);
+    if (handle->kvs) {
+        // multi KV instance mode .. prepend KV ID
+        fdb_kvs_id_t _kv_id = _endian_encode(handle->kvs->id);
+
+        samples.start_keylen = size_id + ((start_key)?(start_keylen):(0));
+        samples.start_key = alca(uint8_t, samples.start_keylen);
+        memcpy(samples.start_key, &_kv_id, size_id);
+        if (start_key) {
+            memcpy((uint8_t*)samples.start_key + size_id,
+                   start_key, start_keylen);
+        }
+
+        if (end_key) {
+            samples.end_keylen = size_id + end_keylen;
+            samples.end_key = alca(uint8_t, samples.end_keylen);
+            memcpy(samples.end_key, &_kv_id, size_id);
+            memcpy((uint8_t*)samples.end_key + size_id, end_key, end_keylen);
+        } else {
+            // NULL key of the next KV ID
+            _kv_id = _endian_encode(handle->kvs->id+1);
+            samples.end_keylen = size_id;
+            samples.end_key = alca(uint8_t, size_id);
+            memcpy(samples.end_key, &_kv_id, size_id);
+        }
+    } else if (start_key || end_key) {
+        samples.start_key = (void *)start_key;
+        samples.start_keylen = (start_key)?(start_keylen):(0);
+        samples.end_key = (void *)end_key;
+        samples.end_keylen = (end_key)?(end_keylen):(0);
+    }
+
+    // every key in the range has the common prefix of start and end keys
+    // (only KV ID is used for custom compare functions)
+    prefixlen = size_id;
+    if (!handle->kvs_config.custom_cmp && start_key && end_key) {
+        while (prefixlen < samples.start_keylen &&
+               prefixlen < samples.end_keylen &&
+               ((uint8_t*)samples.start_key)[prefixlen] ==
+               ((uint8_t*)samples.end_key)[prefixlen]) {
+            prefixlen++;
+        }
+    }
+
+    nsample = num_partitions * FDB_SPLIT_SAMPLE_FACTOR;
+    samples.size = nsample;
+    samples.keys = (void **)malloc(sizeof(void *) * nsample);
+    samples.keylens = (size_t *)malloc(sizeof(size_t) * nsample);
+    hbtrie_get_sample_keys(handle->trie,
+                           samples.start_key, samples.start_keylen,
+                           samples.end_key, samples.end_keylen, prefixlen,
+                           nsample, _fdb_split_sample_cb, &samples);
+    btreeblk_end(handle->bhandle);
+
+    // pick (num_partitions - 1) keys evenly from the samples
+    nkeys = 0;
+    datasize = 0;
+    prev_idx = samples.num;
+    for (i=1; i<num_partitions; ++i) {
+        idx = i * samples.num / num_partitions;
+        if (idx == prev_idx || idx >= samples.num) {
+            continue;
+        }
+        ptr = (uint8_t *)samples.keys[nkeys];
+        samples.keys[nkeys] = samples.keys[idx];
+        samples.keys[idx] = ptr;
+        samples.keylens[nkeys] = samples.keylens[idx];
+        datasize += samples.keylens[nkeys] - size_id;
+        prev_idx = idx;
+        nkeys++;
+    }
+
+    if (nkeys) {
+        // [key pointers][key lengths][keys] in a single memory block
+        ptr = (uint8_t *)malloc(nkeys * (sizeof(void *) + sizeof(size_t)) +
+                                datasize);
+        split_keys->keys = (void **)ptr;
+        split_keys->keylens = (size_t *)(ptr + nkeys * sizeof(void *));
+        ptr += nkeys * (sizeof(void *) + sizeof(size_t));
+        for (i=0; i<nkeys; ++i) {
+            // eliminate KV ID from the key
+            split_keys->keylens[i] = samples.keylens[i] - size_id;
+            split_keys->keys[i] = ptr;
+            memcpy(ptr, (uint8_t*)samples.keys[i] + size_id,
+                   split_keys->keylens[i]);
+            ptr += split_keys->keylens[i];
+        }
+        split_keys->num_keys = nkeys;
+    }
+
+    for (i=0; i<samples.num; ++i) {
+        free(samples.keys[i]);
+    }
+    free(samples.keys);
+    free(samples.keylens);
+
+    return FDB_RESULT_SUCCESS;
+}
+
+fdb_status fdb_free_split_key_list(fdb_split_key_list *split_keys)
+{
+    if (!split_keys) {
+        return FDB_RESULT_INVALID_ARGS;
+    }
+    free(split_keys->keys);
+    split_keys->keys = NULL;
+    split_keys->keylens = NULL;
+    split_keys->num_keys = 0;
+
+    return FDB_RESULT_SUCCESS;
+}
+
+fdb_status fdb_estimate_range(fdb_kvs_handle *handle,
+                              const void *start_key,
+                              size_t start_keylen,
+                              const void *end_key,
+                              size_t end_keylen,
+                              uint64_t *count,
+                              uint64_t *bytes)
+{
+    double pos_begin, pos_end, pos_start, pos_stop, ratio;
+    size_t size_id;
+    uint8_t *key;
+    fdb_kvs_id_t kv_id, _kv_id;
+    fdb_kvs_info info;
+    struct kvs_stat stat;
+
+    if (handle == NULL || count == NULL || bytes == NULL ||
+        start_keylen > FDB_MAX_KEYLEN ||
+        end_keylen > FDB_MAX_KEYLEN) {
+        return FDB_RESULT_INVALID_ARGS;
+    }
+    *count = 0;
+    *bytes = 0;
+
+    if (!handle->shandle) {
+        fdb_check_file_reopen(handle);
+        fdb_link_new_file(handle);
+        fdb_sync_db_header(handle);
+    }
+
+    size_id = (handle->kvs)?(sizeof(fdb_kvs_id_t)):(0);
+    kv_id = (handle->kvs)?(handle->kvs->id):(0);
+    key = alca(uint8_t, size_id + FDB_MAX_KEYLEN);
+
+    // the whole key space of the KV store is [pos_begin, pos_end)
+    pos_begin = 0;
+    pos_end = 1;
+    if (handle->kvs) {
+        // multi KV instance mode .. NULL keys of this and the next KV IDs
+        _kv_id = _endian_encode(kv_id);
+        hbtrie_get_key_position(handle->trie, &_kv_id, size_id, &pos_begin);
+        _kv_id = _endian_encode(kv_id+1);
+        hbtrie_get_key_position(handle->trie, &_kv_id, size_id, &pos_end);
+    }
+
+    pos_start = pos_begin;
+    if (start_key) {
+        _kv_id = _endian_encode(kv_id);
+        memcpy(key, &_kv_id, size_id);
+        memcpy(key + size_id, start_key, start_keylen);
+        hbtrie_get_key_position(handle->trie, key, size_id + start_keylen,
+                                &pos_start);
+    }
+    pos_stop = pos_end;
+    if (end_key) {
+        _kv_id = _endian_encode(kv_id);
+        memcpy(key, &_kv_id, size_id);
+        memcpy(key + size_id, end_key, end_keylen);
+        hbtrie_get_key_position(handle->trie, key, size_id + end_keylen,
+                                &pos_stop);
+    }
+    btreeblk_end(handle->bhandle);
+
+    if (pos_end <= pos_begin || pos_stop <= pos_start) {
+        return FDB_RESULT_SUCCESS;
+    }
+    ratio = (pos_stop - pos_start) / (pos_end - pos_begin);
+    if (ratio > 1) {
+        ratio = 1;
+    }
+
+    fdb_get_kvs_info(handle, &info);
+    _kvs_stat_get(handle->file, kv_id, &stat);
+    *count = (uint64_t)(info.doc_count * ratio + 0.5);
+    if (info.doc_count) {
+        *bytes = (uint64_t)((double)stat.datasize * *count / info.doc_count);
+    }
+
+    return FDB_RESULT_SUCCESS;
+}
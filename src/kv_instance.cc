@@ -31,6 +31,7 @@
 #include "wal.h"
 #include "hbtrie.h"
 #include "btreeblock.h"
+#include "range_del.h"
 
 #include "memleak.h"
 
@@ -101,6 +102,33 @@ void fdb_file_handle_close_all(fdb_file_handle *fhandle)
     spin_unlock(&fhandle->lock);
 }
 
+// copy the log callback to be used for file-level operations (e.g., commit):
+// the root handle's one if set, otherwise the one of the first opened
+// KV store handle that has a callback.
+void fdb_file_handle_get_log_callback(fdb_file_handle *fhandle,
+                                      err_log_callback *log_callback)
+{
+    struct list_elem *e;
+    struct kvs_opened_node *node;
+
+    *log_callback = fhandle->root->log_callback;
+    if (log_callback->callback) {
+        return;
+    }
+
+    spin_lock(&fhandle->lock);
+    e = list_begin(fhandle->handles);
+    while (e) {
+        node = _get_entry(e, struct kvs_opened_node, le);
+        if (node->handle->log_callback.callback) {
+            *log_callback = node->handle->log_callback;
+            break;
+        }
+        e = list_next(e);
+    }
+    spin_unlock(&fhandle->lock);
+}
+
 void fdb_file_handle_parse_cmp_func(fdb_file_handle *fhandle,
                                     size_t n_func,
                                     char **kvs_names,
@@ -405,8 +433,10 @@ void _fdb_kvs_header_create(struct kvs_header **kv_header_ptr)
     kv_header->custom_cmp_enabled = 0;
     kv_header->idx_name = (struct avl_tree*)malloc(sizeof(struct avl_tree));
     kv_header->idx_id = (struct avl_tree*)malloc(sizeof(struct avl_tree));
+    kv_header->idx_dropped = (struct avl_tree*)malloc(sizeof(struct avl_tree));
     avl_init(kv_header->idx_name, NULL);
     avl_init(kv_header->idx_id, NULL);
+    avl_init(kv_header->idx_dropped, NULL);
     spin_init(&kv_header->lock);
 }
 
@@ -436,6 +466,23 @@ static void fdb_kvs_header_reset_all_stats(struct filemgr *file)
     spin_unlock(&kv_header->lock);
 }
 
+static void fdb_kvs_header_purge_dropped(struct filemgr *file)
+{
+    struct avl_node *a;
+    struct kvs_node *node;
+    struct kvs_header *kv_header = file->kv_header;
+
+    spin_lock(&kv_header->lock);
+    a = avl_first(kv_header->idx_dropped);
+    while (a) {
+        node = _get_entry(a, struct kvs_node, avl_id);
+        a = avl_next(a);
+        avl_remove(kv_header->idx_dropped, &node->avl_id);
+        free(node);
+    }
+    spin_unlock(&kv_header->lock);
+}
+
 void fdb_kvs_header_copy(fdb_kvs_handle *handle,
                          struct filemgr *new_file,
                          struct docio_handle *new_dhandle)
@@ -449,6 +496,9 @@ void fdb_kvs_header_copy(fdb_kvs_handle *handle,
     handle->kv_info_offset = fdb_kvs_header_append(new_file,
                                                       new_dhandle);
     fdb_kvs_header_reset_all_stats(new_file);
+    // documents of dropped KV stores are not moved into the new file,
+    // so their IDs don't need to be tracked anymore.
+    fdb_kvs_header_purge_dropped(new_file);
     spin_lock(&handle->file->kv_header->lock);
     spin_lock(&new_file->kv_header->lock);
     new_file->kv_header->default_kvs_cmp =
@@ -476,13 +526,18 @@ void _fdb_kvs_header_export(struct kvs_header *kv_header,
      * [data size]:             8 bytes
      * [flags]:                 8 bytes
      * ...
+     * ---
+     * [# dropped KV IDs]:      8 bytes
+     * [dropped KV ID]:         8 bytes
+     * ...
      */
 
     int size = 0;
     int offset = 0;
     uint16_t name_len, _name_len;
     uint64_t c = 0;
-    uint64_t _n_kv, _kv_id, _flags;
+    uint64_t n_dropped = 0;
+    uint64_t _n_kv, _kv_id, _flags, _n_dropped;
     uint64_t _nlivenodes, _ndocs, _datasize;
     fdb_kvs_id_t _id_counter;
     fdb_seqnum_t _seqnum;
@@ -514,6 +569,13 @@ void _fdb_kvs_header_export(struct kvs_header *kv_header,
         size += sizeof(node->flags); // flags
         a = avl_next(a);
     }
+    size += sizeof(uint64_t); // # dropped KV IDs
+    a = avl_first(kv_header->idx_dropped);
+    while(a) {
+        n_dropped++;
+        size += sizeof(fdb_kvs_id_t); // dropped KV ID
+        a = avl_next(a);
+    }
 
     *data = (void *)malloc(size);
 
@@ -574,6 +636,20 @@ void _fdb_kvs_header_export(struct kvs_header *kv_header,
         a = avl_next(a);
     }
 
+    // # dropped KV IDs
+    _n_dropped = _endian_encode(n_dropped);
+    memcpy((uint8_t*)*data + offset, &_n_dropped, sizeof(_n_dropped));
+    offset += sizeof(_n_dropped);
+
+    a = avl_first(kv_header->idx_dropped);
+    while(a) {
+        node = _get_entry(a, struct kvs_node, avl_id);
+        _kv_id = _endian_encode(node->id);
+        memcpy((uint8_t*)*data + offset, &_kv_id, sizeof(_kv_id));
+        offset += sizeof(_kv_id);
+        a = avl_next(a);
+    }
+
     *len = size;
 
     spin_unlock(&kv_header->lock);
@@ -585,10 +661,12 @@ void _fdb_kvs_header_import(struct kvs_header *kv_header,
     int i, offset = 0;
     uint16_t name_len, _name_len;
     uint64_t n_kv, _n_kv, kv_id, _kv_id, flags, _flags;
+    uint64_t n_dropped, _n_dropped;
     uint64_t _nlivenodes, _ndocs, _datasize;
     fdb_kvs_id_t id_counter, _id_counter;
     fdb_seqnum_t seqnum, _seqnum;
     struct kvs_node *node;
+    struct avl_node *a;
 
     // # KV instances
     memcpy(&_n_kv, (uint8_t*)data + offset, sizeof(_n_kv));
@@ -655,6 +733,28 @@ void _fdb_kvs_header_import(struct kvs_header *kv_header,
         avl_insert(kv_header->idx_name, &node->avl_name, _kvs_cmp_name);
         avl_insert(kv_header->idx_id, &node->avl_id, _kvs_cmp_id);
     }
+
+    // dropped KV IDs
+    // (KV headers written by older versions don't have this section)
+    if (offset + sizeof(_n_dropped) <= len) {
+        memcpy(&_n_dropped, (uint8_t*)data + offset, sizeof(_n_dropped));
+        offset += sizeof(_n_dropped);
+        n_dropped = _endian_decode(_n_dropped);
+
+        for (i=0;i<n_dropped;++i){
+            memcpy(&_kv_id, (uint8_t*)data + offset, sizeof(_kv_id));
+            offset += sizeof(_kv_id);
+
+            node = (struct kvs_node *)calloc(1, sizeof(struct kvs_node));
+            node->id = _endian_decode(_kv_id);
+            a = avl_search(kv_header->idx_dropped, &node->avl_id, _kvs_cmp_id);
+            if (a) { // already exists
+                free(node);
+            } else {
+                avl_insert(kv_header->idx_dropped, &node->avl_id, _kvs_cmp_id);
+            }
+        }
+    }
     spin_unlock(&kv_header->lock);
 }
 
@@ -726,6 +826,36 @@ fdb_seqnum_t _fdb_kvs_get_seqnum(struct kvs_header *kv_header,
     return seqnum;
 }
 
+int _fdb_kvs_is_dropped(struct kvs_header *kv_header, fdb_kvs_id_t id)
+{
+    int ret;
+    struct kvs_node query;
+
+    spin_lock(&kv_header->lock);
+    query.id = id;
+    ret = (avl_search(kv_header->idx_dropped, &query.avl_id, _kvs_cmp_id))
+          ? (1) : (0);
+    spin_unlock(&kv_header->lock);
+
+    return ret;
+}
+
+size_t _fdb_kvs_get_num_dropped(struct kvs_header *kv_header)
+{
+    size_t c = 0;
+    struct avl_node *a;
+
+    spin_lock(&kv_header->lock);
+    a = avl_first(kv_header->idx_dropped);
+    while (a) {
+        c++;
+        a = avl_next(a);
+    }
+    spin_unlock(&kv_header->lock);
+
+    return c;
+}
+
 fdb_seqnum_t fdb_kvs_get_seqnum(struct filemgr *file,
                                 fdb_kvs_id_t id)
 {
@@ -810,8 +940,16 @@ void _fdb_kvs_header_free(struct kvs_header *kv_header)
         free(node->kvs_name);
         free(node);
     }
+    a = avl_first(kv_header->idx_dropped);
+    while (a) {
+        node = _get_entry(a, struct kvs_node, avl_id);
+        a = avl_next(a);
+        avl_remove(kv_header->idx_dropped, &node->avl_id);
+        free(node);
+    }
     free(kv_header->idx_name);
     free(kv_header->idx_id);
+    free(kv_header->idx_dropped);
     free(kv_header);
 }
 
@@ -1368,6 +1506,9 @@ fdb_status fdb_kvs_rollback(fdb_kvs_handle **handle_ptr, fdb_seqnum_t seqnum)
                                         handle_in->kvs->id);
         fdb_kvs_set_seqnum(handle_in->file,
                            handle_in->kvs->id, seqnum);
+        // discard range deletions of the KV instance
+        // performed after the rollback point
+        range_del_rollback(handle_in->file, &_kv_id, sizeof(_kv_id), seqnum);
         filemgr_mutex_unlock(super_handle->file);
 
         fs = _fdb_commit(super_handle, FDB_COMMIT_NORMAL);
@@ -1513,15 +1654,18 @@ fdb_kvs_remove_start:
 
         avl_remove(kv_header->idx_name, &node->avl_name);
         avl_remove(kv_header->idx_id, &node->avl_id);
+
+        // KV IDs are never reused, so dropping a KV store is done by
+        // marking its ID as dead in the KV header. Its documents are
+        // unreachable from now on, and will be skipped (not moved)
+        // by the next compaction.
+        free(node->kvs_name);
+        node->kvs_name = NULL;
+        avl_insert(kv_header->idx_dropped, &node->avl_id, _kvs_cmp_id);
         spin_unlock(&kv_header->lock);
         spin_unlock(&root_handle->fhandle->lock);
 
         kv_id = node->id;
-        _kv_id = _endian_encode(kv_id);
-
-        // free node
-        free(node->kvs_name);
-        free(node);
     }
 
     // sync dirty root nodes
@@ -1535,12 +1679,16 @@ fdb_kvs_remove_start:
         root_handle->seqtree->root_bid = dirty_seqtree_root;
     }
 
-    // remove from super handle's HB+trie
-    hbtrie_remove_partial(root_handle->trie, &_kv_id, sizeof(_kv_id));
-    btreeblk_end(root_handle->bhandle);
-    if (root_handle->config.seqtree_opt == FDB_SEQTREE_USE) {
-        hbtrie_remove_partial(root_handle->seqtrie, &_kv_id, sizeof(_kv_id));
+    if (kv_id == 0) {
+        // the default KV store remains alive (with the same ID)
+        // so that its documents should be removed from the indexes.
+        hbtrie_remove_partial(root_handle->trie, &_kv_id, sizeof(_kv_id));
         btreeblk_end(root_handle->bhandle);
+        if (root_handle->config.seqtree_opt == FDB_SEQTREE_USE) {
+            hbtrie_remove_partial(root_handle->seqtrie, &_kv_id,
+                                  sizeof(_kv_id));
+            btreeblk_end(root_handle->bhandle);
+        }
     }
 
     // append system doc
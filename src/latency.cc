@@ -0,0 +1,217 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2010 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "common.h"
+#include "latency.h"
+
+#include "memleak.h"
+
+static const char *latency_names[FDB_LATENCY_NUM_STATS] = {
+    "get",
+    "set",
+    "commit",
+    "wal_flush",
+    "read_miss",
+    "fsync",
+    "compact_flush",
+    "compact_move",
+    "compact_switch"
+};
+
+INLINE int _latency_msb(uint64_t value)
+{
+#if defined(__GNUC__)
+    return 63 - __builtin_clzll(value);
+#else
+    int msb = 0;
+    while (value >>= 1) {
+        msb++;
+    }
+    return msb;
+#endif
+}
+
+INLINE size_t _latency_bucket(uint64_t value)
+{
+    int msb;
+    if (value < (1 << LATENCY_SUB_BITS)) {
+        return value;
+    }
+    msb = _latency_msb(value);
+    if (msb >= LATENCY_MAX_BITS) {
+        return LATENCY_NBUCKETS - 1;
+    }
+    return ((msb - LATENCY_SUB_BITS + 1) << LATENCY_SUB_BITS) +
+           ((value >> (msb - LATENCY_SUB_BITS)) &
+            ((1 << LATENCY_SUB_BITS) - 1));
+}
+
+// the largest value that falls into the given bucket
+INLINE uint64_t _latency_bucket_max(size_t idx)
+{
+    int msb;
+    uint64_t sub;
+    if (idx < (1 << LATENCY_SUB_BITS)) {
+        return idx;
+    }
+    msb = (idx >> LATENCY_SUB_BITS) + LATENCY_SUB_BITS - 1;
+    sub = idx & ((1 << LATENCY_SUB_BITS) - 1);
+    return ((uint64_t)1 << msb) + ((sub + 1) << (msb - LATENCY_SUB_BITS)) - 1;
+}
+
+static void _latency_hist_reset(struct latency_histogram *hist)
+{
+    memset(hist, 0, sizeof(struct latency_histogram));
+    hist->min = (uint64_t)-1;
+}
+
+void latency_init(struct filemgr *file)
+{
+    int i;
+    file->latency = (struct latency_stats *)
+                    malloc(sizeof(struct latency_stats));
+    for (i=0; i<FDB_LATENCY_NUM_STATS; ++i) {
+        _latency_hist_reset(&file->latency->hists[i]);
+    }
+}
+
+void latency_free(struct filemgr *file)
+{
+    free(file->latency);
+    file->latency = NULL;
+}
+
+void latency_update(struct filemgr *file, fdb_latency_stat_type type,
+                    uint64_t begin)
+{
+    uint64_t elapsed, cur;
+    struct latency_histogram *hist;
+
+    if (!file || !file->latency || type >= FDB_LATENCY_NUM_STATS) {
+        return;
+    }
+    elapsed = get_monotonic_ts() - begin;
+    hist = &file->latency->hists[type];
+
+    atomic_add64(&hist->buckets[_latency_bucket(elapsed)], 1);
+    atomic_add64(&hist->count, 1);
+    atomic_add64(&hist->sum, elapsed);
+    cur = hist->min;
+    while (elapsed < cur && !atomic_cas64(&hist->min, cur, elapsed)) {
+        cur = hist->min;
+    }
+    cur = hist->max;
+    while (elapsed > cur && !atomic_cas64(&hist->max, cur, elapsed)) {
+        cur = hist->max;
+    }
+}
+
+void latency_get_stat(struct filemgr *file, fdb_latency_stat_type type,
+                      fdb_latency_stat *stat)
+{
+    size_t i, j;
+    uint64_t count, sum;
+    const double ratios[] = {0.5, 0.9, 0.99, 0.999};
+    uint64_t *percentiles[] = {&stat->p50, &stat->p90, &stat->p99,
+                               &stat->p999};
+    struct latency_histogram *hist;
+
+    memset(stat, 0, sizeof(fdb_latency_stat));
+    if (!file->latency || type >= FDB_LATENCY_NUM_STATS) {
+        return;
+    }
+    hist = &file->latency->hists[type];
+
+    // take the count from the buckets, which may be slightly different
+    // from 'hist->count' under concurrent updates
+    count = 0;
+    for (i=0; i<LATENCY_NBUCKETS; ++i) {
+        count += hist->buckets[i];
+    }
+    if (count == 0) {
+        return;
+    }
+    stat->count = count;
+    stat->min = hist->min;
+    stat->max = hist->max;
+    stat->avg = hist->sum / ((hist->count)?(hist->count):(1));
+
+    sum = 0;
+    j = 0;
+    for (i=0; i<LATENCY_NBUCKETS && j<4; ++i) {
+        sum += hist->buckets[i];
+        while (j < 4 && sum >= (uint64_t)(ratios[j] * count + 0.5)) {
+            // report the upper bound of the bucket, but not above the max
+            *percentiles[j] = _latency_bucket_max(i);
+            if (*percentiles[j] > stat->max) {
+                *percentiles[j] = stat->max;
+            }
+            j++;
+        }
+    }
+}
+
+void latency_reset(struct filemgr *file)
+{
+    int i;
+    if (!file->latency) {
+        return;
+    }
+    for (i=0; i<FDB_LATENCY_NUM_STATS; ++i) {
+        _latency_hist_reset(&file->latency->hists[i]);
+    }
+}
+
+void latency_merge(struct filemgr *dst, struct filemgr *src)
+{
+    int i;
+    size_t j;
+    struct latency_histogram *d, *s;
+
+    if (!dst->latency || !src->latency) {
+        return;
+    }
+    for (i=0; i<FDB_LATENCY_NUM_STATS; ++i) {
+        d = &dst->latency->hists[i];
+        s = &src->latency->hists[i];
+        for (j=0; j<LATENCY_NBUCKETS; ++j) {
+            if (s->buckets[j]) {
+                atomic_add64(&d->buckets[j], s->buckets[j]);
+            }
+        }
+        atomic_add64(&d->count, s->count);
+        atomic_add64(&d->sum, s->sum);
+        if (s->min < d->min) {
+            d->min = s->min;
+        }
+        if (s->max > d->max) {
+            d->max = s->max;
+        }
+    }
+}
+
+const char * latency_get_name(fdb_latency_stat_type type)
+{
+    if (type >= FDB_LATENCY_NUM_STATS) {
+        return NULL;
+    }
+    return latency_names[type];
+}
@@ -0,0 +1,72 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2010 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#ifndef _FDB_LATENCY_H
+#define _FDB_LATENCY_H
+
+#include <stdint.h>
+#include "internal_types.h"
+#include "filemgr.h"
+#include "time_utils.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// log-linear histogram: each power of two range is divided into
+// (1 << LATENCY_SUB_BITS) buckets, up to (1 << LATENCY_MAX_BITS) ns.
+#define LATENCY_SUB_BITS (4)
+#define LATENCY_MAX_BITS (40)
+#define LATENCY_NBUCKETS \
+    ((LATENCY_MAX_BITS - LATENCY_SUB_BITS + 1) << LATENCY_SUB_BITS)
+
+struct latency_histogram {
+    uint64_t count;
+    uint64_t sum;
+    uint64_t min;
+    uint64_t max;
+    uint64_t buckets[LATENCY_NBUCKETS];
+};
+
+/**
+ * Per-file latency histograms, one for each fdb_latency_stat_type.
+ * Samples are added by atomic increments so that concurrent readers and
+ * writers do not contend on a lock.
+ */
+struct latency_stats {
+    struct latency_histogram hists[FDB_LATENCY_NUM_STATS];
+};
+
+void latency_init(struct filemgr *file);
+void latency_free(struct filemgr *file);
+
+// add the time elapsed since 'begin' (obtained by get_monotonic_ts())
+void latency_update(struct filemgr *file, fdb_latency_stat_type type,
+                    uint64_t begin);
+void latency_get_stat(struct filemgr *file, fdb_latency_stat_type type,
+                      fdb_latency_stat *stat);
+void latency_reset(struct filemgr *file);
+// add the samples of 'src' into 'dst' (used when a file is compacted)
+void latency_merge(struct filemgr *dst, struct filemgr *src);
+
+const char * latency_get_name(fdb_latency_stat_type type);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
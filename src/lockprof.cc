@@ -0,0 +1,99 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2010 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "common.h"
+#include "lockprof.h"
+
+#include "memleak.h"
+
+static const char *lockprof_names[FDB_LOCK_NUM_SITES] = {
+    "bcache",
+    "bcache_filelist",
+    "bcache_freelist",
+    "bcache_file",
+    "filemgr_mutex",
+    "wal",
+    "plock"
+};
+
+#ifdef _FDB_LOCKPROF
+
+// each site is padded to its own cache line so that the counters of
+// different locks do not share a line
+struct lockprof_site {
+    fdb_lock_stat stat;
+    uint8_t padding[64 - sizeof(fdb_lock_stat)];
+};
+
+static struct lockprof_site lockprof_sites[FDB_LOCK_NUM_SITES];
+
+void lockprof_acquired(fdb_lock_site site)
+{
+    atomic_add64(&lockprof_sites[site].stat.acquisitions, 1);
+}
+
+void lockprof_waited(fdb_lock_site site, uint64_t begin)
+{
+    atomic_add64(&lockprof_sites[site].stat.contended, 1);
+    atomic_add64(&lockprof_sites[site].stat.wait_time,
+                 get_monotonic_ts() - begin);
+}
+
+fdb_status lockprof_get_stats(fdb_lock_stats *stats)
+{
+    int i;
+    for (i=0; i<FDB_LOCK_NUM_SITES; ++i) {
+        stats->sites[i] = lockprof_sites[i].stat;
+    }
+    return FDB_RESULT_SUCCESS;
+}
+
+fdb_status lockprof_reset()
+{
+    int i;
+    for (i=0; i<FDB_LOCK_NUM_SITES; ++i) {
+        memset(&lockprof_sites[i].stat, 0, sizeof(fdb_lock_stat));
+    }
+    return FDB_RESULT_SUCCESS;
+}
+
+#else
+
+fdb_status lockprof_get_stats(fdb_lock_stats *stats)
+{
+    (void)stats;
+    return FDB_RESULT_INVALID_CONFIG;
+}
+
+fdb_status lockprof_reset()
+{
+    return FDB_RESULT_INVALID_CONFIG;
+}
+
+#endif
+
+const char * lockprof_get_name(fdb_lock_site site)
+{
+    if (site >= FDB_LOCK_NUM_SITES) {
+        return NULL;
+    }
+    return lockprof_names[site];
+}
@@ -0,0 +1,87 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2010 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#ifndef _FDB_LOCKPROF_H
+#define _FDB_LOCKPROF_H
+
+#include <stdint.h>
+#include "common.h"
+#include "libforestdb/fdb_types.h"
+#include "libforestdb/fdb_errors.h"
+#include "time_utils.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef _FDB_LOCKPROF
+
+void lockprof_acquired(fdb_lock_site site);
+// add a contended acquisition that started waiting at 'begin'
+void lockprof_waited(fdb_lock_site site, uint64_t begin);
+
+// an uncontended acquisition only costs a trylock and a counter update;
+// the clock is read only when the lock is already held by someone else.
+#define LOCKPROF_SPIN_LOCK(site, lock) \
+    do { \
+        if (!spin_trylock(lock)) { \
+            uint64_t __lp_begin = get_monotonic_ts(); \
+            spin_lock(lock); \
+            lockprof_waited((site), __lp_begin); \
+        } \
+        lockprof_acquired(site); \
+    } while (0)
+#define LOCKPROF_MUTEX_LOCK(site, lock) \
+    do { \
+        if (!mutex_trylock(lock)) { \
+            uint64_t __lp_begin = get_monotonic_ts(); \
+            mutex_lock(lock); \
+            lockprof_waited((site), __lp_begin); \
+        } \
+        lockprof_acquired(site); \
+    } while (0)
+// same as above but only records waits, for locks whose acquisitions are
+// counted elsewhere (e.g., the per-range locks inside plock_lock)
+#define LOCKPROF_MUTEX_WAIT(site, lock) \
+    do { \
+        if (!mutex_trylock(lock)) { \
+            uint64_t __lp_begin = get_monotonic_ts(); \
+            mutex_lock(lock); \
+            lockprof_waited((site), __lp_begin); \
+        } \
+    } while (0)
+#define LOCKPROF_ACQUIRED(site) lockprof_acquired(site)
+
+#else
+
+// locks are not profiled
+#define LOCKPROF_SPIN_LOCK(site, lock) spin_lock(lock)
+#define LOCKPROF_MUTEX_LOCK(site, lock) mutex_lock(lock)
+#define LOCKPROF_MUTEX_WAIT(site, lock) mutex_lock(lock)
+#define LOCKPROF_ACQUIRED(site)
+
+#endif
+
+fdb_status lockprof_get_stats(fdb_lock_stats *stats);
+fdb_status lockprof_reset();
+const char * lockprof_get_name(fdb_lock_site site);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
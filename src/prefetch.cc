@@ -0,0 +1,225 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2010 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "filemgr.h"
+#include "blockcache.h"
+#include "btree.h"
+#include "btree_kv.h"
+#include "btreeblock.h"
+#include "hbtrie.h"
+#include "prefetch.h"
+
+#include "memleak.h"
+
+struct prefetch_ctx {
+    struct filemgr *file;
+    struct btreeblk_handle bhandle;
+    struct prefetch_index_config config;
+    // # blocks that can still be loaded
+    size_t budget;
+    // block BIDs of the current level
+    bid_t *bids;
+    size_t size;
+};
+
+struct prefetch_reader_args {
+    struct filemgr *file;
+    bid_t *bids;
+    size_t n;
+};
+
+static int _prefetch_bid_cmp(const void *a, const void *b)
+{
+    bid_t aa = *(bid_t *)a, bb = *(bid_t *)b;
+    if (aa < bb) {
+        return -1;
+    } else if (aa > bb) {
+        return 1;
+    }
+    return 0;
+}
+
+static void *_prefetch_reader(void *voidargs)
+{
+    struct prefetch_reader_args *args = (struct prefetch_reader_args *)voidargs;
+    filemgr_readahead(args->file, args->bids, args->n, NULL);
+    return NULL;
+}
+
+// read the given blocks (sorted) by up to FILEMGR_PREFETCH_NREADERS readers,
+// each of which loads a contiguous range of the blocks
+static void _prefetch_read_blocks(struct filemgr *file, bid_t *bids, size_t n)
+{
+    size_t i, nreaders, unit;
+    void *ret;
+    thread_t tids[FILEMGR_PREFETCH_NREADERS];
+    struct prefetch_reader_args args[FILEMGR_PREFETCH_NREADERS];
+
+    nreaders = (n + FILEMGR_READAHEAD_BATCH - 1) / FILEMGR_READAHEAD_BATCH;
+    nreaders = MIN(nreaders, FILEMGR_PREFETCH_NREADERS);
+    if (nreaders <= 1) {
+        filemgr_readahead(file, bids, n, NULL);
+        return;
+    }
+
+    unit = (n + nreaders - 1) / nreaders;
+    for (i = 0; i < nreaders; ++i) {
+        args[i].file = file;
+        args[i].bids = bids + i * unit;
+        args[i].n = MIN(unit, n - i * unit);
+    }
+    // the last range is read by this thread
+    for (i = 0; i < nreaders - 1; ++i) {
+        thread_create(&tids[i], _prefetch_reader, &args[i]);
+    }
+    _prefetch_reader(&args[nreaders - 1]);
+    for (i = 0; i < nreaders - 1; ++i) {
+        thread_join(tids[i], &ret);
+    }
+}
+
+// load the blocks of the given nodes, which are going to be read next.
+// returns zero if the walk should stop.
+static int _prefetch_nodes(struct prefetch_ctx *ctx, bid_t *bids, size_t n)
+{
+    size_t i, m;
+    bool last = false;
+
+    if (filemgr_prefetch_aborted(ctx->file) || ctx->budget == 0 ||
+        bcache_get_num_free_blocks() == 0) {
+        return 0;
+    }
+    // the nodes of the previous level are not needed anymore .. free the
+    // copies of them now, rather than keeping them until they age out,
+    // so that a level is not held in memory twice (here and in the cache)
+    btreeblk_discard_blocks(&ctx->bhandle);
+
+    if (n > ctx->size) {
+        ctx->size = n;
+        ctx->bids = (bid_t *)realloc(ctx->bids, sizeof(bid_t) * n);
+    }
+    for (i = 0; i < n; ++i) {
+        ctx->bids[i] = btreeblk_get_file_bid(&ctx->bhandle, bids[i]);
+    }
+    qsort(ctx->bids, n, sizeof(bid_t), _prefetch_bid_cmp);
+    for (i = m = 0; i < n; ++i) {
+        if (m == 0 || ctx->bids[m-1] != ctx->bids[i]) {
+            ctx->bids[m++] = ctx->bids[i];
+        }
+    }
+    if (m >= ctx->budget) {
+        // load as many blocks as allowed, and do not go further down
+        m = ctx->budget;
+        last = true;
+    }
+
+    _prefetch_read_blocks(ctx->file, ctx->bids, m);
+    ctx->budget -= m;
+    return (last)?(0):(1);
+}
+
+static int _prefetch_trie_level(struct hbtrie *trie, bid_t *bids, size_t n,
+                                void *aux)
+{
+    return _prefetch_nodes((struct prefetch_ctx *)aux, bids, n);
+}
+
+static int _prefetch_btree_level(struct btree *btree, uint16_t level,
+                                 bid_t *bids, size_t n, void *aux)
+{
+    if (level == btree->height) {
+        // the root node has already been loaded
+        return 1;
+    }
+    return _prefetch_nodes((struct prefetch_ctx *)aux, bids, n);
+}
+
+static bool _prefetch_trie(struct prefetch_ctx *ctx, int chunksize,
+                           bid_t root_bid)
+{
+    struct hbtrie trie;
+    hbtrie_result hr;
+
+    hbtrie_init(&trie, chunksize, OFFSET_SIZE, ctx->file->blocksize, root_bid,
+                (void *)&ctx->bhandle, btreeblk_get_ops(), NULL, NULL);
+    hr = hbtrie_walk_nodes(&trie, _prefetch_trie_level, (void *)ctx);
+    hbtrie_free(&trie);
+    return hr == HBTRIE_RESULT_SUCCESS;
+}
+
+static void _prefetch_seqtree(struct prefetch_ctx *ctx, bid_t root_bid)
+{
+    struct btree btree;
+    struct btree_kv_ops *kv_ops;
+
+    if (!_prefetch_nodes(ctx, &root_bid, 1)) {
+        return;
+    }
+    kv_ops = (struct btree_kv_ops *)malloc(sizeof(struct btree_kv_ops));
+    kv_ops = btree_kv_get_kb64_vb64(kv_ops);
+    btree_init_from_bid(&btree, (void *)&ctx->bhandle, btreeblk_get_ops(),
+                        kv_ops, ctx->file->blocksize, root_bid);
+    btree_walk_levels(&btree, _prefetch_btree_level, NULL, (void *)ctx);
+    free(kv_ops);
+}
+
+static void _prefetch_index(struct filemgr *file, void *aux)
+{
+    struct prefetch_ctx *ctx = (struct prefetch_ctx *)aux;
+    struct prefetch_index_config *config = &ctx->config;
+
+    btreeblk_init(&ctx->bhandle, file, file->blocksize);
+
+    if (_prefetch_trie(ctx, config->chunksize, config->trie_root_bid) &&
+        config->seq_root_bid != BLK_NOT_FOUND) {
+        // the sequence index is loaded only if the whole HB+trie is cached
+        if (config->seqtrie) {
+            _prefetch_trie(ctx, sizeof(fdb_kvs_id_t), config->seq_root_bid);
+        } else {
+            _prefetch_seqtree(ctx, config->seq_root_bid);
+        }
+    }
+
+    btreeblk_free(&ctx->bhandle);
+    free(ctx->bids);
+    free(ctx);
+}
+
+bool prefetch_index_start(struct filemgr *file,
+                          struct prefetch_index_config *config)
+{
+    struct prefetch_ctx *ctx;
+
+    if (config->trie_root_bid == BLK_NOT_FOUND || config->max_blocks == 0) {
+        return false;
+    }
+
+    ctx = (struct prefetch_ctx *)calloc(1, sizeof(struct prefetch_ctx));
+    ctx->file = file;
+    ctx->config = *config;
+    ctx->budget = config->max_blocks;
+    if (!filemgr_prefetch_custom(file, _prefetch_index, (void *)ctx)) {
+        free(ctx);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,61 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2010 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#ifndef _FDB_PREFETCH_H
+#define _FDB_PREFETCH_H
+
+#include <stdint.h>
+#include "internal_types.h"
+#include "filemgr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Index-first prefetch. The B+tree nodes of the HB+trie (and optionally of
+ * the sequence index) are loaded top-down in the prefetch thread of the
+ * file, one level at a time, before any document block. Each level is read
+ * in ascending block order by several readers concurrently, and the walk
+ * stops when the given number of blocks has been loaded, the buffer cache
+ * is full, or the file is being closed.
+ * The leaf nodes of the HB+trie b-trees are loaded (and read, to find the
+ * sub-tries) as part of the HB+trie, so the sequence index is loaded only
+ * after all of them; leaf b-trees have no sub-trie, so their leaf nodes are
+ * loaded but not read.
+ */
+struct prefetch_index_config {
+    int chunksize;
+    bid_t trie_root_bid;
+    // BLK_NOT_FOUND if the sequence index is not loaded
+    bid_t seq_root_bid;
+    // true if the sequence index is an HB+trie (multi KV instance mode)
+    bool seqtrie;
+    // max # blocks to be loaded
+    size_t max_blocks;
+};
+
+// start loading the index nodes of the file in the background.
+// returns false if another prefetch or cache warm-up is in progress.
+bool prefetch_index_start(struct filemgr *file,
+                          struct prefetch_index_config *config);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,421 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2010 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "common.h"
+#include "range_del.h"
+
+#include "memleak.h"
+
+#ifdef __DEBUG
+#ifndef __DEBUG_RANGE_DEL
+    #undef DBG
+    #undef DBGCMD
+    #undef DBGSW
+    #define DBG(...)
+    #define DBGCMD(...)
+    #define DBGSW(n, ...)
+#endif
+#endif
+
+static struct range_del_item * _range_del_item_create(void *start_key,
+                                                      size_t start_keylen,
+                                                      void *end_key,
+                                                      size_t end_keylen,
+                                                      fdb_seqnum_t seqnum)
+{
+    struct range_del_item *item;
+
+    item = (struct range_del_item *)calloc(1, sizeof(struct range_del_item));
+    item->start_keylen = start_keylen;
+    if (start_keylen) {
+        item->start_key = (void *)malloc(start_keylen);
+        memcpy(item->start_key, start_key, start_keylen);
+    }
+    item->end_keylen = end_keylen;
+    if (end_keylen) {
+        item->end_key = (void *)malloc(end_keylen);
+        memcpy(item->end_key, end_key, end_keylen);
+    }
+    item->seqnum = seqnum;
+
+    return item;
+}
+
+static void _range_del_item_free(struct range_del_item *item)
+{
+    free(item->start_key);
+    free(item->end_key);
+    free(item);
+}
+
+// remove all items in the list (list lock should be grabbed by the caller)
+static void _range_del_clear(struct range_del_list *rlist)
+{
+    struct list_elem *e;
+    struct range_del_item *item;
+
+    e = list_begin(&rlist->items);
+    while (e) {
+        item = _get_entry(e, struct range_del_item, le);
+        e = list_remove(&rlist->items, e);
+        _range_del_item_free(item);
+    }
+    rlist->count = 0;
+}
+
+void range_del_create(struct filemgr *file)
+{
+    struct range_del_list *rlist;
+
+    if (file->range_del) {
+        return; // already exist
+    }
+
+    rlist = (struct range_del_list *)calloc(1, sizeof(struct range_del_list));
+    list_init(&rlist->items);
+    rlist->count = 0;
+    rlist->offset = BLK_NOT_FOUND;
+    rlist->dirty = 0;
+    spin_init(&rlist->lock);
+
+    file->range_del = rlist;
+    file->free_range_del = range_del_free;
+}
+
+void range_del_free(struct filemgr *file)
+{
+    struct range_del_list *rlist = file->range_del;
+
+    if (rlist == NULL) {
+        return;
+    }
+
+    spin_lock(&rlist->lock);
+    _range_del_clear(rlist);
+    spin_unlock(&rlist->lock);
+    spin_destroy(&rlist->lock);
+
+    free(rlist);
+    file->range_del = NULL;
+}
+
+size_t range_del_get_count(struct filemgr *file)
+{
+    if (file->range_del == NULL) {
+        return 0;
+    }
+    return file->range_del->count;
+}
+
+void range_del_insert(struct filemgr *file,
+                      void *start_key, size_t start_keylen,
+                      void *end_key, size_t end_keylen,
+                      fdb_seqnum_t seqnum)
+{
+    struct range_del_item *item;
+    struct range_del_list *rlist;
+
+    range_del_create(file);
+    rlist = file->range_del;
+
+    item = _range_del_item_create(start_key, start_keylen,
+                                  end_key, end_keylen, seqnum);
+
+    spin_lock(&rlist->lock);
+    list_push_back(&rlist->items, &item->le);
+    rlist->count++;
+    rlist->dirty = 1;
+    spin_unlock(&rlist->lock);
+}
+
+int range_del_covered(struct filemgr *file,
+                      void *key, size_t keylen,
+                      fdb_seqnum_t seqnum,
+                      fdb_seqnum_t max_seqnum,
+                      range_del_cmp_func *cmp, void *aux)
+{
+    int ret = 0;
+    struct list_elem *e;
+    struct range_del_item *item;
+    struct range_del_list *rlist = file->range_del;
+
+    if (rlist == NULL || rlist->count == 0) {
+        // fast path: there is no range tombstone
+        return 0;
+    }
+
+    spin_lock(&rlist->lock);
+    e = list_begin(&rlist->items);
+    while (e) {
+        item = _get_entry(e, struct range_del_item, le);
+        e = list_next(e);
+
+        if (seqnum >= item->seqnum) {
+            // the document was written after the range deletion
+            continue;
+        }
+        if (max_seqnum && item->seqnum > max_seqnum) {
+            // the range deletion is not visible to the snapshot
+            continue;
+        }
+        if (item->start_keylen &&
+            cmp(item->start_key, item->start_keylen, key, keylen, aux) > 0) {
+            continue;
+        }
+        if (item->end_keylen &&
+            cmp(key, keylen, item->end_key, item->end_keylen, aux) > 0) {
+            continue;
+        }
+        ret = 1;
+        break;
+    }
+    spin_unlock(&rlist->lock);
+
+    return ret;
+}
+
+void range_del_rollback(struct filemgr *file,
+                        void *prefix, size_t prefixlen,
+                        fdb_seqnum_t seqnum)
+{
+    struct list_elem *e;
+    struct range_del_item *item;
+    struct range_del_list *rlist = file->range_del;
+
+    if (rlist == NULL) {
+        return;
+    }
+
+    spin_lock(&rlist->lock);
+    e = list_begin(&rlist->items);
+    while (e) {
+        item = _get_entry(e, struct range_del_item, le);
+        if (item->seqnum > seqnum &&
+            (prefixlen == 0 ||
+             (item->start_keylen >= prefixlen &&
+              !memcmp(item->start_key, prefix, prefixlen)))) {
+            // range deletion performed after the rollback point
+            e = list_remove(&rlist->items, e);
+            _range_del_item_free(item);
+            rlist->count--;
+            rlist->dirty = 1;
+        } else {
+            e = list_next(e);
+        }
+    }
+    spin_unlock(&rlist->lock);
+}
+
+void range_del_copy(struct filemgr *src_file, struct filemgr *dst_file)
+{
+    struct list_elem *e;
+    struct range_del_item *item, *new_item;
+    struct range_del_list *src = src_file->range_del;
+    struct range_del_list *dst;
+
+    if (src == NULL) {
+        return;
+    }
+
+    range_del_create(dst_file);
+    dst = dst_file->range_del;
+
+    spin_lock(&src->lock);
+    spin_lock(&dst->lock);
+    e = list_begin(&src->items);
+    while (e) {
+        item = _get_entry(e, struct range_del_item, le);
+        new_item = _range_del_item_create(item->start_key, item->start_keylen,
+                                          item->end_key, item->end_keylen,
+                                          item->seqnum);
+        list_push_back(&dst->items, &new_item->le);
+        dst->count++;
+        dst->dirty = 1;
+        e = list_next(e);
+    }
+    spin_unlock(&dst->lock);
+    spin_unlock(&src->lock);
+}
+
+uint64_t range_del_get_offset(struct filemgr *file)
+{
+    if (file->range_del == NULL) {
+        return BLK_NOT_FOUND;
+    }
+    return file->range_del->offset;
+}
+
+uint64_t range_del_append(struct filemgr *file,
+                          struct docio_handle *dhandle)
+{
+    /* << raw data structure >>
+     * [# range tombstones]:    8 bytes
+     * ---
+     * [start key length]:      2 bytes
+     * [start key]:             x bytes
+     * [end key length]:        2 bytes
+     * [end key]:               y bytes
+     * [sequence number]:       8 bytes
+     * ...
+     */
+    char *doc_key = alca(char, 32);
+    uint8_t *data;
+    size_t size = 0, offset = 0;
+    uint16_t _keylen;
+    uint64_t _count;
+    fdb_seqnum_t _seqnum;
+    struct list_elem *e;
+    struct range_del_item *item;
+    struct range_del_list *rlist = file->range_del;
+    struct docio_object doc;
+
+    if (rlist == NULL) {
+        return BLK_NOT_FOUND;
+    }
+
+    spin_lock(&rlist->lock);
+    if (!rlist->dirty) {
+        spin_unlock(&rlist->lock);
+        return rlist->offset;
+    }
+
+    // pre-scan to estimate the size of data
+    size += sizeof(uint64_t);
+    e = list_begin(&rlist->items);
+    while (e) {
+        item = _get_entry(e, struct range_del_item, le);
+        size += sizeof(uint16_t) + item->start_keylen;
+        size += sizeof(uint16_t) + item->end_keylen;
+        size += sizeof(fdb_seqnum_t);
+        e = list_next(e);
+    }
+
+    data = (uint8_t *)malloc(size);
+
+    _count = _endian_encode((uint64_t)rlist->count);
+    seq_memcpy(data + offset, &_count, sizeof(_count), offset);
+
+    e = list_begin(&rlist->items);
+    while (e) {
+        item = _get_entry(e, struct range_del_item, le);
+
+        _keylen = _endian_encode(item->start_keylen);
+        seq_memcpy(data + offset, &_keylen, sizeof(_keylen), offset);
+        seq_memcpy(data + offset, item->start_key, item->start_keylen, offset);
+
+        _keylen = _endian_encode(item->end_keylen);
+        seq_memcpy(data + offset, &_keylen, sizeof(_keylen), offset);
+        seq_memcpy(data + offset, item->end_key, item->end_keylen, offset);
+
+        _seqnum = _endian_encode(item->seqnum);
+        seq_memcpy(data + offset, &_seqnum, sizeof(_seqnum), offset);
+
+        e = list_next(e);
+    }
+    rlist->dirty = 0;
+    spin_unlock(&rlist->lock);
+
+    memset(&doc, 0, sizeof(struct docio_object));
+    sprintf(doc_key, "range_del");
+    doc.key = (void *)doc_key;
+    doc.meta = NULL;
+    doc.body = data;
+    doc.length.keylen = strlen(doc_key) + 1;
+    doc.length.metalen = 0;
+    doc.length.bodylen = size;
+    doc.seqnum = 0;
+    rlist->offset = docio_append_doc_system(dhandle, &doc);
+    free(data);
+
+    return rlist->offset;
+}
+
+void range_del_read(struct filemgr *file,
+                    struct docio_handle *dhandle,
+                    uint64_t offset)
+{
+    size_t i, pos = 0;
+    uint16_t start_keylen, end_keylen;
+    uint64_t count;
+    uint8_t *data;
+    fdb_seqnum_t seqnum;
+    uint64_t _offset;
+    struct range_del_item *item;
+    struct range_del_list *rlist;
+    struct docio_object doc;
+
+    range_del_create(file);
+    rlist = file->range_del;
+
+    if (offset == BLK_NOT_FOUND) {
+        return;
+    }
+
+    memset(&doc, 0, sizeof(struct docio_object));
+    _offset = docio_read_doc(dhandle, offset, &doc);
+    if (_offset == offset) {
+        return;
+    }
+    data = (uint8_t *)doc.body;
+
+    spin_lock(&rlist->lock);
+    _range_del_clear(rlist);
+
+    memcpy(&count, data + pos, sizeof(count));
+    pos += sizeof(count);
+    count = _endian_decode(count);
+
+    for (i=0; i<count; ++i) {
+        memcpy(&start_keylen, data + pos, sizeof(start_keylen));
+        pos += sizeof(start_keylen);
+        start_keylen = _endian_decode(start_keylen);
+        item = (struct range_del_item *)
+               calloc(1, sizeof(struct range_del_item));
+        item->start_keylen = start_keylen;
+        if (start_keylen) {
+            item->start_key = (void *)malloc(start_keylen);
+            memcpy(item->start_key, data + pos, start_keylen);
+            pos += start_keylen;
+        }
+
+        memcpy(&end_keylen, data + pos, sizeof(end_keylen));
+        pos += sizeof(end_keylen);
+        end_keylen = _endian_decode(end_keylen);
+        item->end_keylen = end_keylen;
+        if (end_keylen) {
+            item->end_key = (void *)malloc(end_keylen);
+            memcpy(item->end_key, data + pos, end_keylen);
+            pos += end_keylen;
+        }
+
+        memcpy(&seqnum, data + pos, sizeof(seqnum));
+        pos += sizeof(seqnum);
+        item->seqnum = _endian_decode(seqnum);
+
+        list_push_back(&rlist->items, &item->le);
+        rlist->count++;
+    }
+    rlist->offset = offset;
+    rlist->dirty = 0;
+    spin_unlock(&rlist->lock);
+
+    free_docio_object(&doc, 1, 1, 1);
+}
@@ -0,0 +1,92 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2010 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#ifndef _FDB_RANGE_DEL_H
+#define _FDB_RANGE_DEL_H
+
+#include <stdint.h>
+#include "internal_types.h"
+#include "filemgr.h"
+#include "docio.h"
+#include "list.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Range tombstone. Every document whose key is in [start_key, end_key]
+ * and whose sequence number is smaller than 'seqnum' is regarded as deleted.
+ * Keys include the KV ID prefix under the multi KV instance mode.
+ * 'start_keylen' ('end_keylen') of zero means that there is no lower (upper)
+ * bound.
+ */
+struct range_del_item {
+    void *start_key;
+    void *end_key;
+    uint16_t start_keylen;
+    uint16_t end_keylen;
+    fdb_seqnum_t seqnum;
+    struct list_elem le;
+};
+
+/**
+ * Per-file list of range tombstones.
+ */
+struct range_del_list {
+    struct list items;
+    volatile size_t count;
+    // offset of the system document that lastly persisted the list
+    uint64_t offset;
+    uint8_t dirty;
+    spin_t lock;
+};
+
+typedef int range_del_cmp_func(void *key1, size_t keylen1,
+                               void *key2, size_t keylen2,
+                               void *aux);
+
+void range_del_create(struct filemgr *file);
+void range_del_free(struct filemgr *file);
+size_t range_del_get_count(struct filemgr *file);
+
+void range_del_insert(struct filemgr *file,
+                      void *start_key, size_t start_keylen,
+                      void *end_key, size_t end_keylen,
+                      fdb_seqnum_t seqnum);
+int range_del_covered(struct filemgr *file,
+                      void *key, size_t keylen,
+                      fdb_seqnum_t seqnum,
+                      fdb_seqnum_t max_seqnum,
+                      range_del_cmp_func *cmp, void *aux);
+void range_del_rollback(struct filemgr *file,
+                        void *prefix, size_t prefixlen,
+                        fdb_seqnum_t seqnum);
+void range_del_copy(struct filemgr *src_file, struct filemgr *dst_file);
+
+uint64_t range_del_get_offset(struct filemgr *file);
+uint64_t range_del_append(struct filemgr *file,
+                          struct docio_handle *dhandle);
+void range_del_read(struct filemgr *file,
+                    struct docio_handle *dhandle,
+                    uint64_t offset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
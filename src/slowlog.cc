@@ -0,0 +1,82 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2010 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "libforestdb/forestdb.h"
+#include "common.h"
+#include "fdb_internal.h"
+#include "slowlog.h"
+
+#include "memleak.h"
+
+SLOWLOG_TLS struct slowlog_ctx slowlog_cur;
+
+static const char *slowlog_phase_names[SLOWLOG_NUM_PHASES] = {
+    "wal_lookup",
+    "hbtrie",
+    "cache_miss",
+    "docio_read",
+    "lock_wait",
+    "wal_flush",
+    "fsync"
+};
+
+bool slowlog_op_begin(uint32_t threshold)
+{
+    if (!threshold || slowlog_cur.begin) {
+        return false;
+    }
+    memset(&slowlog_cur, 0, sizeof(slowlog_cur));
+    slowlog_cur.begin = get_monotonic_ts();
+    return true;
+}
+
+void slowlog_op_end(bool tracked, uint32_t threshold,
+                    err_log_callback *log_callback,
+                    const char *op_name, const char *filename)
+{
+    int i;
+    size_t len;
+    uint64_t elapsed;
+    char msg[512];
+
+    if (!tracked) {
+        return;
+    }
+    elapsed = get_monotonic_ts() - slowlog_cur.begin;
+    slowlog_cur.begin = 0;
+    if (elapsed < (uint64_t)threshold * 1000000) {
+        return;
+    }
+
+    // e.g., "slow op=fdb_get file='a.fdb' total_us=51234 wal_lookup_us=3
+    //        wal_lookup_count=1 ..."
+    len = snprintf(msg, sizeof(msg), "slow op=%s file='%s' total_us=%llu",
+                   op_name, (filename)?(filename):(""),
+                   (unsigned long long)(elapsed / 1000));
+    for (i=0; i<SLOWLOG_NUM_PHASES && len < sizeof(msg); ++i) {
+        len += snprintf(msg + len, sizeof(msg) - len, " %s_us=%llu %s_count=%llu",
+                        slowlog_phase_names[i],
+                        (unsigned long long)(slowlog_cur.time[i] / 1000),
+                        slowlog_phase_names[i],
+                        (unsigned long long)slowlog_cur.count[i]);
+    }
+    fdb_log(log_callback, FDB_RESULT_SUCCESS, "%s", msg);
+}
@@ -0,0 +1,87 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2010 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#ifndef _FDB_SLOWLOG_H
+#define _FDB_SLOWLOG_H
+
+#include <stdint.h>
+#include "internal_types.h"
+#include "time_utils.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(_MSC_VER)
+#define SLOWLOG_TLS __declspec(thread)
+#else
+#define SLOWLOG_TLS __thread
+#endif
+
+// internal phases whose elapsed time is reported by the slow operation log
+typedef enum {
+    SLOWLOG_WAL_LOOKUP = 0,
+    SLOWLOG_HBTRIE,
+    SLOWLOG_CACHE_MISS,
+    SLOWLOG_DOCIO_READ,
+    SLOWLOG_LOCK_WAIT,
+    SLOWLOG_WAL_FLUSH,
+    SLOWLOG_FSYNC,
+    SLOWLOG_NUM_PHASES
+} slowlog_phase_t;
+
+/**
+ * Phase breakdown of the API call running on the current thread.
+ * Phases may nest (e.g., cache misses during the HB+trie descent), so
+ * their sum can exceed the elapsed time of the call.
+ */
+struct slowlog_ctx {
+    uint64_t time[SLOWLOG_NUM_PHASES];
+    uint64_t count[SLOWLOG_NUM_PHASES];
+    // start time of the tracked call, or 0 if no call is tracked
+    uint64_t begin;
+};
+
+extern SLOWLOG_TLS struct slowlog_ctx slowlog_cur;
+
+// returns 0 if no call is tracked on this thread, so that untracked calls
+// skip reading the clock
+static inline uint64_t slowlog_phase_begin()
+{
+    return (slowlog_cur.begin)?(get_monotonic_ts()):(0);
+}
+
+static inline void slowlog_phase_end(slowlog_phase_t phase, uint64_t begin)
+{
+    if (begin && slowlog_cur.begin) {
+        slowlog_cur.time[phase] += get_monotonic_ts() - begin;
+        slowlog_cur.count[phase]++;
+    }
+}
+
+// start tracking an API call if 'threshold' (ms) is set and no outer call is
+// tracked. returns true if the call should be passed to slowlog_op_end().
+bool slowlog_op_begin(uint32_t threshold);
+void slowlog_op_end(bool tracked, uint32_t threshold,
+                    err_log_callback *log_callback,
+                    const char *op_name, const char *filename);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
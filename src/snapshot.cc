@@ -22,6 +22,7 @@
 
 #include "common.h"
 #include "avltree.h"
+#include "filemgr.h"
 #include "snapshot.h"
 
 #include "memleak.h"
@@ -62,14 +63,14 @@ int _snp_seqnum_cmp(struct avl_node *a, struct avl_node *b, void *aux)
 
 int _snp_wal_cmp(struct avl_node *a, struct avl_node *b, void *aux)
 {
-    fdb_kvs_handle *handle = (fdb_kvs_handle*)aux;
+    struct snap_wal_index *index = (struct snap_wal_index*)aux;
     struct snap_wal_entry *aa, *bb;
     aa = _get_entry(a, struct snap_wal_entry, avl);
     bb = _get_entry(b, struct snap_wal_entry, avl);
 
-    if (handle->kvs_config.custom_cmp) {
+    if (index->custom_cmp) {
         // custom compare function for variable-length key
-        if (handle->kvs) {
+        if (index->multi_kv_instances) {
             // multi KV instance mode
             // KV ID should be compared separately
             size_t size_id = sizeof(fdb_kvs_id_t);
@@ -84,13 +85,13 @@ int _snp_wal_cmp(struct avl_node *a, struct avl_node *b, void *aux)
             } else if (a_id > b_id) {
                 return 1;
             } else {
-                return handle->kvs_config.custom_cmp(
+                return index->custom_cmp(
                             (uint8_t*)aa->key + size_id, aa->keylen - size_id,
                             (uint8_t*)bb->key + size_id, bb->keylen - size_id);
             }
         } else {
-            return handle->kvs_config.custom_cmp(aa->key, aa->keylen,
-                                               bb->key, bb->keylen);
+            return index->custom_cmp(aa->key, aa->keylen,
+                                     bb->key, bb->keylen);
         }
     } else {
         return _snp_keycmp(aa->key, aa->keylen, bb->key, bb->keylen);
@@ -98,21 +99,238 @@ int _snp_wal_cmp(struct avl_node *a, struct avl_node *b, void *aux)
 }
 
 
+static void _snap_entry_free(struct snap_wal_entry *snap_item)
+{
+    free(snap_item->key);
+    free(snap_item);
+}
+
+static void _snap_index_free(struct snap_wal_index *index)
+{
+    struct avl_node *a;
+    struct snap_wal_entry *snap_item, *older;
+
+    a = avl_first(&index->key_tree);
+    while (a) {
+        snap_item = _get_entry(a, struct snap_wal_entry, avl);
+        a = avl_next(a);
+        avl_remove(&index->key_tree, &snap_item->avl);
+        // free all versions of the key
+        while (snap_item) {
+            older = snap_item->older;
+            _snap_entry_free(snap_item);
+            snap_item = older;
+        }
+    }
+    spin_destroy(&index->lock);
+    free(index);
+}
+
+static void _snap_index_acquire(struct snap_wal_index *index)
+{
+    spin_lock(&index->lock);
+    index->ref_count++;
+    spin_unlock(&index->lock);
+}
+
+static void _snap_index_release(void *voidindex)
+{
+    struct snap_wal_index *index = (struct snap_wal_index *)voidindex;
+    uint32_t ref_count;
+
+    spin_lock(&index->lock);
+    ref_count = --index->ref_count;
+    spin_unlock(&index->lock);
+    if (ref_count == 0) {
+        _snap_index_free(index);
+    }
+}
+
+// attach a snapshot to the index (lock should be grabbed by the caller).
+// The snapshot sees the versions applied to the index so far.
+static void _snap_attach_index(struct snap_handle *shandle,
+                               struct snap_wal_index *index)
+{
+    index->ref_count++;
+    list_push_back(&index->snapshots, &shandle->le);
+    shandle->stamp = index->stamp;
+    shandle->index = index;
+    shandle->key_tree = &index->key_tree;
+    shandle->seq_tree = &index->seq_tree;
+}
+
+// return the newest version of the key visible to the snapshot
+// (lock should be grabbed by the caller)
+static struct snap_wal_entry * _snap_visible(struct snap_handle *shandle,
+                                             struct snap_wal_entry *snap_item)
+{
+    while (snap_item && snap_item->stamp > shandle->stamp) {
+        snap_item = snap_item->older;
+    }
+    return snap_item;
+}
+
 fdb_status snap_init(struct snap_handle *shandle, fdb_kvs_handle *handle)
 {
-    shandle->key_tree = (struct avl_tree *) malloc(sizeof(struct avl_tree));
-    if (!shandle->key_tree) {
+    struct snap_wal_index *index;
+
+    index = (struct snap_wal_index *)calloc(1, sizeof(struct snap_wal_index));
+    if (!index) {
         return FDB_RESULT_ALLOC_FAIL;
     }
-    avl_init(shandle->key_tree, (void *) handle);
-    shandle->seq_tree = (struct avl_tree *) malloc(sizeof(struct avl_tree));
-    if (!shandle->seq_tree) {
-        return FDB_RESULT_ALLOC_FAIL;
+    avl_init(&index->key_tree, (void *) index);
+    avl_init(&index->seq_tree, NULL);
+    index->custom_cmp = handle->kvs_config.custom_cmp;
+    index->multi_kv_instances = (handle->kvs)?(1):(0);
+    list_init(&index->snapshots);
+    spin_init(&index->lock);
+    _snap_attach_index(shandle, index);
+    return FDB_RESULT_SUCCESS;
+}
+
+static fdb_status _snap_wal_snapshot_func(void *shandle, fdb_doc *doc,
+                                          uint64_t offset)
+{
+    return snap_insert((struct snap_handle *)shandle, doc, offset);
+}
+
+// remove versions of the key that are not visible to any snapshot anymore
+// (lock should be grabbed by the caller)
+static void _snap_index_prune(struct snap_wal_index *index,
+                              struct snap_wal_entry *snap_item)
+{
+    struct list_elem *e;
+    struct snap_wal_entry *older;
+    uint64_t min_stamp;
+
+    // snapshots are attached in the order of their stamps
+    e = list_begin(&index->snapshots);
+    if (e) {
+        min_stamp = _get_entry(e, struct snap_handle, le)->stamp;
+    } else {
+        min_stamp = index->stamp;
+    }
+
+    // versions older than the one visible to the oldest snapshot
+    // are not visible to any snapshot
+    while (snap_item && snap_item->stamp > min_stamp) {
+        snap_item = snap_item->older;
+    }
+    if (!snap_item) {
+        return;
+    }
+    older = snap_item->older;
+    snap_item->older = NULL;
+    while (older) {
+        snap_item = older;
+        older = snap_item->older;
+        avl_remove(&index->seq_tree, &snap_item->avl_seq);
+        _snap_entry_free(snap_item);
+    }
+}
+
+// add a new version of a key to the shared index (called by WAL).
+// The version is visible only to the snapshots attached after that.
+static void _snap_index_apply(void *voidindex, fdb_doc *doc, uint64_t offset)
+{
+    struct snap_wal_index *index = (struct snap_wal_index *)voidindex;
+    struct snap_wal_entry query;
+    struct snap_wal_entry *item, *head = NULL;
+    struct avl_node *node;
+    wal_item_action action;
+
+    action = doc->deleted ? WAL_ACT_LOGICAL_REMOVE : WAL_ACT_INSERT;
+    memset(&query, 0, sizeof(snap_wal_entry));
+    query.key = doc->key;
+    query.keylen = doc->keylen;
+
+    spin_lock(&index->lock);
+    node = avl_search(&index->key_tree, &query.avl, _snp_wal_cmp);
+    if (node) {
+        head = _get_entry(node, struct snap_wal_entry, avl);
+        if (head->seqnum == doc->seqnum && head->offset == offset &&
+            head->action == action) {
+            // not changed
+            spin_unlock(&index->lock);
+            return;
+        }
+    }
+
+    item = (struct snap_wal_entry *) malloc(sizeof(struct snap_wal_entry));
+    item->keylen = doc->keylen;
+    item->key = malloc(item->keylen);
+    memcpy(item->key, doc->key, item->keylen);
+    item->seqnum = doc->seqnum;
+    item->action = action;
+    item->offset = offset;
+    item->flag = 0;
+    item->stamp = ++index->stamp;
+    item->older = head;
+    if (head) {
+        // the previous version is still reachable through 'older'
+        // (and the sequence number tree)
+        avl_remove(&index->key_tree, &head->avl);
+    }
+    avl_insert(&index->key_tree, &item->avl, _snp_wal_cmp);
+    avl_insert(&index->seq_tree, &item->avl_seq, _snp_seqnum_cmp);
+    _snap_index_prune(index, item);
+    spin_unlock(&index->lock);
+}
+
+// capture unflushed WAL entries for an in-memory snapshot.
+// All in-memory snapshots share the same index, which WAL keeps up to date
+// as new changes become visible to snapshots, so that opening a snapshot
+// only takes the current stamp of the index. Sequence numbers cannot order
+// the changes of different transactions by visibility (a transaction may
+// commit an older sequence number after a newer one), so each version is
+// tagged with the stamp of the index when it was applied instead.
+// The index is copied from WAL again only after WAL items are removed
+// (by flush, compaction or rollback).
+fdb_status snap_init_inmem(struct snap_handle *shandle,
+                           fdb_kvs_handle *handle, fdb_txn *txn)
+{
+    struct wal *wal = handle->file->wal;
+    struct snap_wal_index *index;
+    fdb_status fs;
+
+    // entries of an ongoing transaction are visible to its own snapshot only
+    if (txn && list_begin(txn->items)) {
+        fs = snap_init(shandle, handle);
+        if (fs != FDB_RESULT_SUCCESS) {
+            return fs;
+        }
+        wal_snapshot(handle->file, (void *)shandle, txn,
+                     _snap_wal_snapshot_func);
+        return FDB_RESULT_SUCCESS;
     }
-    avl_init(shandle->seq_tree, NULL);
+
+    spin_lock(&wal->lock);
+    index = (struct snap_wal_index *)wal->snap_cache;
+    if (index &&
+        index->custom_cmp == handle->kvs_config.custom_cmp &&
+        index->multi_kv_instances == ((handle->kvs)?(1):(0))) {
+        spin_lock(&index->lock);
+        _snap_attach_index(shandle, index);
+        spin_unlock(&index->lock);
+        spin_unlock(&wal->lock);
+        return FDB_RESULT_SUCCESS;
+    }
+    spin_unlock(&wal->lock);
+
+    fs = snap_init(shandle, handle);
+    if (fs != FDB_RESULT_SUCCESS) {
+        return fs;
+    }
+    // reference held by WAL
+    _snap_index_acquire(shandle->index);
+    wal_snapshot_share(handle->file, (void *)shandle, (void *)shandle->index,
+                       _snap_wal_snapshot_func, _snap_index_apply,
+                       _snap_index_release);
     return FDB_RESULT_SUCCESS;
 }
 
+// insert an entry copied from WAL or restored from the file
+// (the index is not shared yet)
 fdb_status snap_insert(struct snap_handle *shandle, fdb_doc *doc,
                         uint64_t offset)
 {
@@ -132,6 +350,8 @@ fdb_status snap_insert(struct snap_handle *shandle, fdb_doc *doc,
         item->action = doc->deleted ? WAL_ACT_LOGICAL_REMOVE : WAL_ACT_INSERT;
         item->offset = offset;
         item->flag = 0;
+        item->stamp = 0;
+        item->older = NULL;
         avl_insert(shandle->key_tree, &item->avl, _snp_wal_cmp);
         avl_insert(shandle->seq_tree, &item->avl_seq, _snp_seqnum_cmp);
     } else {
@@ -155,70 +375,97 @@ fdb_status snap_insert(struct snap_handle *shandle, fdb_doc *doc,
 fdb_status snap_find(struct snap_handle *shandle, fdb_doc *doc,
                       uint64_t *offset)
 {
-    struct snap_wal_entry query;
+    struct snap_wal_entry query, *item = NULL;
     struct avl_node *node;
+
+    if (!shandle->index) {
+        return FDB_RESULT_KEY_NOT_FOUND;
+    }
     memset(&query, 0, sizeof(snap_wal_entry));
+
+    spin_lock(&shandle->index->lock);
     if (doc->seqnum == SEQNUM_NOT_USED || (doc->key && doc->keylen > 0)) {
-        if (!shandle->key_tree) {
-            return FDB_RESULT_KEY_NOT_FOUND;
-        }
         // search by key
         query.key = doc->key;
         query.keylen = doc->keylen;
         node = avl_search(shandle->key_tree, &query.avl, _snp_wal_cmp);
-        if (!node) {
-            return FDB_RESULT_KEY_NOT_FOUND;
-        } else {
-            struct snap_wal_entry *item;
-            item = _get_entry(node, struct snap_wal_entry, avl);
-            *offset = item->offset;
-            if (item->action == WAL_ACT_INSERT) {
-                doc->deleted = false;
-            } else {
-                doc->deleted = true;
-            }
-            return FDB_RESULT_SUCCESS;
+        if (node) {
+            item = _snap_visible(shandle,
+                        _get_entry(node, struct snap_wal_entry, avl));
         }
     } else {
-        if (!shandle->seq_tree) {
-            return FDB_RESULT_KEY_NOT_FOUND;
-        }
         // search by sequence number
         query.seqnum = doc->seqnum;
         node = avl_search(shandle->seq_tree, &query.avl_seq, _snp_seqnum_cmp);
-        if (!node) {
-            return FDB_RESULT_KEY_NOT_FOUND;
-        } else {
-            struct snap_wal_entry *item;
+        if (node) {
             item = _get_entry(node, struct snap_wal_entry, avl_seq);
-            *offset = item->offset;
-            if (item->action == WAL_ACT_INSERT) {
-                doc->deleted = false;
-            } else {
-                doc->deleted = true;
+            if (item->stamp > shandle->stamp) {
+                item = NULL;
+            } else if (shandle->index->stamp) {
+                // the version should be the newest one of the key
+                // visible to the snapshot
+                node = avl_search(shandle->key_tree, &item->avl,
+                                  _snp_wal_cmp);
+                if (!node || _snap_visible(shandle,
+                                _get_entry(node, struct snap_wal_entry,
+                                           avl)) != item) {
+                    item = NULL;
+                }
             }
-            return FDB_RESULT_SUCCESS;
         }
     }
-    return FDB_RESULT_KEY_NOT_FOUND;
+    if (item) {
+        *offset = item->offset;
+        if (item->action == WAL_ACT_INSERT) {
+            doc->deleted = false;
+        } else {
+            doc->deleted = true;
+        }
+    }
+    spin_unlock(&shandle->index->lock);
+
+    return (item)?(FDB_RESULT_SUCCESS):(FDB_RESULT_KEY_NOT_FOUND);
 }
 
-fdb_status snap_close(struct snap_handle *shandle)
+// call FUNC for each entry visible to the snapshot in key order
+// (entries may be modified by WAL concurrently, so FUNC should copy them)
+void snap_scan(struct snap_handle *shandle, void *ctx, snap_scan_func *func)
 {
     struct avl_node *a;
     struct snap_wal_entry *snap_item;
 
-    if (shandle->key_tree) {
-        a = avl_first(shandle->key_tree);
-        while (a) {
-            snap_item = _get_entry(a, struct snap_wal_entry, avl);
-            a = avl_next(a);
-            avl_remove(shandle->key_tree, &snap_item->avl);
-            free(snap_item->key);
-            free(snap_item);
+    if (!shandle->index) {
+        return;
+    }
+    spin_lock(&shandle->index->lock);
+    a = avl_first(shandle->key_tree);
+    while (a) {
+        snap_item = _snap_visible(shandle,
+                        _get_entry(a, struct snap_wal_entry, avl));
+        if (snap_item) {
+            func(ctx, snap_item);
+        }
+        a = avl_next(a);
+    }
+    spin_unlock(&shandle->index->lock);
+}
+
+fdb_status snap_close(struct snap_handle *shandle)
+{
+    struct snap_wal_index *index = shandle->index;
+    uint32_t ref_count;
+
+    if (index) {
+        spin_lock(&index->lock);
+        list_remove(&index->snapshots, &shandle->le);
+        ref_count = --index->ref_count;
+        spin_unlock(&index->lock);
+        if (ref_count == 0) {
+            _snap_index_free(index);
         }
-        free(shandle->key_tree);
-        free(shandle->seq_tree);
+        shandle->index = NULL;
+        shandle->key_tree = NULL;
+        shandle->seq_tree = NULL;
     }
     return FDB_RESULT_SUCCESS;
 }
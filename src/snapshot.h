@@ -37,10 +37,57 @@ struct snap_wal_entry {
     uint8_t flag;
     uint16_t keylen;
     uint64_t offset;
+    /**
+     * Change stamp of the index when this version was applied
+     * (0 for entries copied from WAL or restored from the file)
+     */
+    uint64_t stamp;
+    /**
+     * Previous version of the same key that is still visible to
+     * older snapshots (only the newest version is in the key tree)
+     */
+    struct snap_wal_entry *older;
     struct avl_node avl;
     struct avl_node avl_seq;
 };
 
+/**
+ * Unflushed WAL entries captured by snapshots. In-memory snapshots share
+ * the same instance, which is kept up to date by WAL as new changes become
+ * visible, so that each snapshot sees the versions applied before it opened.
+ */
+struct snap_wal_index {
+    /**
+     * AVL tree of WAL entries by key range
+     */
+    struct avl_tree key_tree;
+    /**
+     * AVL tree of WAL entries by sequence number
+     */
+    struct avl_tree seq_tree;
+    /**
+     * Custom compare function used for the key tree
+     */
+    fdb_custom_cmp_variable custom_cmp;
+    /**
+     * Flag indicating that keys are prefixed by KV ID
+     */
+    uint8_t multi_kv_instances;
+    /**
+     * Stamp of the last version applied to this instance
+     */
+    uint64_t stamp;
+    /**
+     * Snapshots attached to this instance in the order of their stamps
+     */
+    struct list snapshots;
+    /**
+     * Number of snapshots (and WAL) referring to this instance
+     */
+    uint32_t ref_count;
+    spin_t lock;
+};
+
 struct snap_handle {
     /**
      * Snapshot marker indicating highest sequence number
@@ -54,14 +101,29 @@ struct snap_handle {
      * AVL tree to store unflushed WAL entries of a snapshot by sequence number
      */
      struct avl_tree *seq_tree;
+    /**
+     * WAL entries that the above trees belong to
+     */
+     struct snap_wal_index *index;
+    /**
+     * Stamp of the index when this snapshot was opened. Versions applied
+     * after that are invisible to the snapshot.
+     */
+     uint64_t stamp;
+     struct list_elem le;
 };
 
+typedef void snap_scan_func(void *ctx, struct snap_wal_entry *entry);
+
 fdb_status snap_init(struct snap_handle *shandle, fdb_kvs_handle *handle);
+fdb_status snap_init_inmem(struct snap_handle *shandle,
+                           fdb_kvs_handle *handle, fdb_txn *txn);
 fdb_status snap_insert(struct snap_handle *shandle, fdb_doc *doc,
                         uint64_t offset);
 fdb_status snap_find(struct snap_handle *shandle, fdb_doc *doc,
                       uint64_t *offset);
 fdb_status snap_remove(struct snap_handle *shandle, fdb_doc *doc);
+void snap_scan(struct snap_handle *shandle, void *ctx, snap_scan_func *func);
 fdb_status snap_close(struct snap_handle *shandle);
 
 #ifdef __cplusplus
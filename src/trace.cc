@@ -0,0 +1,62 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2010 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include <stdlib.h>
+
+#include "common.h"
+#include "trace.h"
+
+static const char *trace_names[FDB_TRACE_NUM_EVENTS] = {
+    "commit",
+    "wal_flush",
+    "btreeblk_end",
+    "bcache_flush",
+    "fsync",
+    "compact_flush",
+    "compact_move",
+    "compact_switch",
+    "read_miss"
+};
+
+#ifdef _FDB_TRACE
+struct trace_sink trace_sink = {NULL, NULL, NULL};
+#endif
+
+fdb_status trace_set_callbacks(fdb_trace_callback begin_cb,
+                               fdb_trace_callback end_cb,
+                               void *ctx)
+{
+#ifdef _FDB_TRACE
+    trace_sink.begin = begin_cb;
+    trace_sink.end = end_cb;
+    trace_sink.ctx = ctx;
+    return FDB_RESULT_SUCCESS;
+#else
+    (void)begin_cb;
+    (void)end_cb;
+    (void)ctx;
+    return FDB_RESULT_INVALID_CONFIG;
+#endif
+}
+
+const char * trace_get_name(fdb_trace_event event)
+{
+    if (event >= FDB_TRACE_NUM_EVENTS) {
+        return NULL;
+    }
+    return trace_names[event];
+}
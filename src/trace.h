@@ -0,0 +1,67 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2010 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#ifndef _FDB_TRACE_H
+#define _FDB_TRACE_H
+
+#include "internal_types.h"
+#include "libforestdb/fdb_errors.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef _FDB_TRACE
+
+struct trace_sink {
+    fdb_trace_callback begin;
+    fdb_trace_callback end;
+    void *ctx;
+};
+extern struct trace_sink trace_sink;
+
+#define TRACE_BEGIN(event) \
+    do { \
+        if (trace_sink.begin) { \
+            trace_sink.begin((event), trace_sink.ctx); \
+        } \
+    } while (0)
+#define TRACE_END(event) \
+    do { \
+        if (trace_sink.end) { \
+            trace_sink.end((event), trace_sink.ctx); \
+        } \
+    } while (0)
+
+#else
+
+// trace points are compiled out
+#define TRACE_BEGIN(event)
+#define TRACE_END(event)
+
+#endif
+
+fdb_status trace_set_callbacks(fdb_trace_callback begin_cb,
+                               fdb_trace_callback end_cb,
+                               void *ctx);
+const char * trace_get_name(fdb_trace_event event);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
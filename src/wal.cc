@@ -27,6 +27,10 @@
 #include "wal.h"
 #include "hash_functions.h"
 #include "fdb_internal.h"
+#include "latency.h"
+#include "trace.h"
+#include "slowlog.h"
+#include "lockprof.h"
 
 #include "memleak.h"
 
@@ -104,6 +108,7 @@ fdb_status wal_init(struct filemgr *file, int nbucket)
     file->wal->num_flushable = 0;
     file->wal->datasize = 0;
     file->wal->wal_dirty = FDB_WAL_CLEAN;
+    file->wal->snap_cache = NULL;
     hash_init(&file->wal->hash_bykey, nbucket, _wal_hash_bykey, _wal_cmp_bykey);
     hash_init(&file->wal->hash_byseq, nbucket, _wal_hash_byseq, _wal_cmp_byseq);
     list_init(&file->wal->list);
@@ -119,6 +124,55 @@ int wal_is_initialized(struct filemgr *file)
     return file->wal->flag & WAL_FLAG_INITIALIZED;
 }
 
+// apply the item of HEADER visible to snapshots to the shared WAL snapshot
+// (WAL lock should be grabbed by the caller)
+static void _wal_snap_cache_update(struct filemgr *file,
+                                   struct wal_item_header *header)
+{
+    struct list_elem *e;
+    struct wal_item *item;
+    fdb_doc doc;
+
+    if (!file->wal->snap_cache) {
+        return;
+    }
+    e = list_begin(&header->items);
+    while (e) {
+        item = _get_entry(e, struct wal_item, list_elem);
+        if ((item->flag & WAL_ITEM_COMMITTED) ||
+            item->txn == &file->global_txn) {
+            doc.keylen = header->keylen;
+            doc.key = header->key;
+            doc.seqnum = item->seqnum;
+            doc.deleted = (item->action == WAL_ACT_LOGICAL_REMOVE ||
+                           item->action == WAL_ACT_REMOVE);
+            file->wal->snap_cache_apply(file->wal->snap_cache,
+                                        &doc, item->offset);
+            return;
+        }
+        e = list_next(e);
+    }
+}
+
+// detach the shared WAL snapshot when items are removed from WAL,
+// so that the next in-memory snapshot copies the remaining items again.
+// Snapshots already referring to it are not affected.
+// (WAL lock should be grabbed by the caller, and the returned snapshot
+//  should be released by _wal_snap_cache_free() after unlocking)
+static void * _wal_snap_cache_detach(struct filemgr *file)
+{
+    void *snap_cache = file->wal->snap_cache;
+    file->wal->snap_cache = NULL;
+    return snap_cache;
+}
+
+static void _wal_snap_cache_free(struct filemgr *file, void *snap_cache)
+{
+    if (snap_cache) {
+        file->wal->snap_cache_free(snap_cache);
+    }
+}
+
 static fdb_status _wal_insert(fdb_txn *txn,
                               struct filemgr *file,
                               fdb_doc *doc,
@@ -142,7 +196,7 @@ static fdb_status _wal_insert(fdb_txn *txn,
     query.key = key;
     query.keylen = keylen;
 
-    spin_lock(&file->wal->lock);
+    LOCKPROF_SPIN_LOCK(FDB_LOCK_WAL, &file->wal->lock);
 
     he = hash_find(&file->wal->hash_bykey, &query.he_key);
 
@@ -285,6 +339,11 @@ static fdb_status _wal_insert(fdb_txn *txn,
         list_push_back(&file->wal->list, &header->list_elem);
         ++file->wal->size;
     }
+    if (txn == &file->global_txn || is_compactor) {
+        // items of the other transactions are invisible to snapshots
+        // until they are committed
+        _wal_snap_cache_update(file, header);
+    }
 
     spin_unlock(&file->wal->lock);
 
@@ -317,7 +376,7 @@ static fdb_status _wal_find(fdb_txn *txn,
     void *key = doc->key;
     size_t keylen = doc->keylen;
 
-    spin_lock(&file->wal->lock);
+    LOCKPROF_SPIN_LOCK(FDB_LOCK_WAL, &file->wal->lock);
 
     if (doc->seqnum == SEQNUM_NOT_USED || (key && keylen>0)) {
         // search by key
@@ -383,7 +442,10 @@ static fdb_status _wal_find(fdb_txn *txn,
 
 fdb_status wal_find(fdb_txn *txn, struct filemgr *file, fdb_doc *doc, uint64_t *offset)
 {
-    return _wal_find(txn, file, 0, doc, offset);
+    uint64_t begin = slowlog_phase_begin();
+    fdb_status fs = _wal_find(txn, file, 0, doc, offset);
+    slowlog_phase_end(SLOWLOG_WAL_LOOKUP, begin);
+    return fs;
 }
 
 fdb_status wal_find_kv_id(fdb_txn *txn,
@@ -392,7 +454,10 @@ fdb_status wal_find_kv_id(fdb_txn *txn,
                           fdb_doc *doc,
                           uint64_t *offset)
 {
-    return _wal_find(txn, file, kv_id, doc, offset);
+    uint64_t begin = slowlog_phase_begin();
+    fdb_status fs = _wal_find(txn, file, kv_id, doc, offset);
+    slowlog_phase_end(SLOWLOG_WAL_LOOKUP, begin);
+    return fs;
 }
 
 // move all uncommitted items into 'new_file'
@@ -409,8 +474,9 @@ fdb_status wal_txn_migration(void *dbhandle,
     struct wal_item_header *header;
     struct wal_item *item;
     struct list_elem *e1, *e2;
+    void *snap_cache;
 
-    spin_lock(&old_file->wal->lock);
+    LOCKPROF_SPIN_LOCK(FDB_LOCK_WAL, &old_file->wal->lock);
 
     e1 = list_begin(&old_file->wal->list);
     while(e1) {
@@ -479,8 +545,10 @@ fdb_status wal_txn_migration(void *dbhandle,
             e1 = list_next(e1);
         }
     }
+    snap_cache = _wal_snap_cache_detach(old_file);
 
     spin_unlock(&old_file->wal->lock);
+    _wal_snap_cache_free(old_file, snap_cache);
 
     return FDB_RESULT_SUCCESS;
 }
@@ -494,7 +562,7 @@ fdb_status wal_commit(fdb_txn *txn, struct filemgr *file, wal_commit_mark_func *
     struct list_elem *e1, *e2;
     fdb_kvs_id_t kv_id, *_kv_id;
 
-    spin_lock(&file->wal->lock);
+    LOCKPROF_SPIN_LOCK(FDB_LOCK_WAL, &file->wal->lock);
 
     e1 = list_begin(txn->items);
     while(e1) {
@@ -560,6 +628,7 @@ fdb_status wal_commit(fdb_txn *txn, struct filemgr *file, wal_commit_mark_func *
             // move the committed item to the end of the wal_item_header's list
             list_remove(&item->header->items, &item->list_elem);
             list_push_back(&item->header->items, &item->list_elem);
+            _wal_snap_cache_update(file, item->header);
         }
 
         // remove from transaction's list
@@ -599,9 +668,10 @@ fdb_status wal_release_flushed_items(struct filemgr *file,
     struct avl_node *a;
     struct wal_item *item;
     fdb_kvs_id_t kv_id, *_kv_id;
+    void *snap_cache;
 
     // scan and remove entries in the avl-tree
-    spin_lock(&file->wal->lock);
+    LOCKPROF_SPIN_LOCK(FDB_LOCK_WAL, &file->wal->lock);
     while (1) {
         if ((a = avl_first(tree)) == NULL) {
             break;
@@ -640,7 +710,9 @@ fdb_status wal_release_flushed_items(struct filemgr *file,
         }
         free(item);
     }
+    snap_cache = _wal_snap_cache_detach(file);
     spin_unlock(&file->wal->lock);
+    _wal_snap_cache_free(file, snap_cache);
 
     return FDB_RESULT_SUCCESS;
 }
@@ -657,9 +729,11 @@ fdb_status _wal_flush(struct filemgr *file,
     struct list_elem *e, *ee;
     struct wal_item *item;
     struct wal_item_header *header;
+    uint64_t begin = get_monotonic_ts();
 
+    TRACE_BEGIN(FDB_TRACE_WAL_FLUSH);
     // sort by old byte-offset of the document (for sequential access)
-    spin_lock(&file->wal->lock);
+    LOCKPROF_SPIN_LOCK(FDB_LOCK_WAL, &file->wal->lock);
     avl_init(tree, NULL);
     e = list_begin(&file->wal->list);
     while(e){
@@ -684,7 +758,7 @@ fdb_status _wal_flush(struct filemgr *file,
                 spin_unlock(&file->wal->lock);
                 item->old_offset = get_old_offset(dbhandle, item);
                 avl_insert(tree, &item->avl, _wal_flush_cmp);
-                spin_lock(&file->wal->lock);
+                LOCKPROF_SPIN_LOCK(FDB_LOCK_WAL, &file->wal->lock);
             }
             ee = list_prev(ee);
         }
@@ -703,6 +777,9 @@ fdb_status _wal_flush(struct filemgr *file,
             flush_func(dbhandle, item);
         }
     }
+    TRACE_END(FDB_TRACE_WAL_FLUSH);
+    latency_update(file, FDB_LATENCY_WAL_FLUSH, begin);
+    slowlog_phase_end(SLOWLOG_WAL_FLUSH, begin);
 
     return FDB_RESULT_SUCCESS;
 }
@@ -727,16 +804,15 @@ fdb_status wal_flush_by_compactor(struct filemgr *file,
                       flush_items, true);
 }
 
-// Used to copy all the WAL items for non-durable snapshots
-fdb_status wal_snapshot(struct filemgr *file,
-                        void *dbhandle, fdb_txn *txn,
-                        wal_snapshot_func *snapshot_func)
+// copy all the WAL items visible to TXN (WAL lock should be grabbed)
+static void _wal_snapshot(struct filemgr *file,
+                          void *dbhandle, fdb_txn *txn,
+                          wal_snapshot_func *snapshot_func)
 {
     struct list_elem *e, *ee;
     struct wal_item *item;
     struct wal_item_header *header;
 
-    spin_lock(&file->wal->lock);
     e = list_begin(&file->wal->list);
     while(e){
         header = _get_entry(e, struct wal_item_header, list_elem);
@@ -761,18 +837,52 @@ fdb_status wal_snapshot(struct filemgr *file,
         }
         e = list_next(e);
     }
+}
+
+// Used to copy all the WAL items for non-durable snapshots
+fdb_status wal_snapshot(struct filemgr *file,
+                        void *dbhandle, fdb_txn *txn,
+                        wal_snapshot_func *snapshot_func)
+{
+    LOCKPROF_SPIN_LOCK(FDB_LOCK_WAL, &file->wal->lock);
+    _wal_snapshot(file, dbhandle, txn, snapshot_func);
     spin_unlock(&file->wal->lock);
 
     return FDB_RESULT_SUCCESS;
 }
 
+// Copy all the committed WAL items into SNAPSHOT, and share it with the
+// next in-memory snapshots. WAL applies the changes visible to snapshots
+// to the shared one by APPLY_FUNC until it is detached and released by
+// FREE_FUNC.
+fdb_status wal_snapshot_share(struct filemgr *file,
+                              void *dbhandle, void *snapshot,
+                              wal_snapshot_func *snapshot_func,
+                              wal_snapshot_apply_func *apply_func,
+                              wal_snapshot_free_func *free_func)
+{
+    void *snap_cache;
+
+    LOCKPROF_SPIN_LOCK(FDB_LOCK_WAL, &file->wal->lock);
+    _wal_snapshot(file, dbhandle, NULL, snapshot_func);
+    snap_cache = _wal_snap_cache_detach(file);
+    file->wal->snap_cache = snapshot;
+    file->wal->snap_cache_apply = apply_func;
+    file->wal->snap_cache_free = free_func;
+    spin_unlock(&file->wal->lock);
+    _wal_snap_cache_free(file, snap_cache);
+
+    return FDB_RESULT_SUCCESS;
+}
+
 // discard entries in txn
 fdb_status wal_discard(struct filemgr *file, fdb_txn *txn)
 {
     struct wal_item *item;
     struct list_elem *e;
+    void *snap_cache = NULL;
 
-    spin_lock(&file->wal->lock);
+    LOCKPROF_SPIN_LOCK(FDB_LOCK_WAL, &file->wal->lock);
 
     e = list_begin(txn->items);
     while(e) {
@@ -805,8 +915,14 @@ fdb_status wal_discard(struct filemgr *file, fdb_txn *txn)
         free(item);
         file->wal->size--;
     }
+    if (txn == &file->global_txn) {
+        // uncommitted items of the other transactions are not visible
+        // to snapshots
+        snap_cache = _wal_snap_cache_detach(file);
+    }
 
     spin_unlock(&file->wal->lock);
+    _wal_snap_cache_free(file, snap_cache);
     return FDB_RESULT_SUCCESS;
 }
 
@@ -826,6 +942,7 @@ fdb_status _wal_close(struct filemgr *file,
     fdb_kvs_id_t *_kv_id, kv_id, kv_id_req;
     bool committed;
     wal_item_action committed_item_action;
+    void *snap_cache;
 
     if (type == WAL_DISCARD_KV_INS) { // multi KV ins mode
         if (aux == NULL) { // aux must contain pointer to KV ID
@@ -834,7 +951,7 @@ fdb_status _wal_close(struct filemgr *file,
         kv_id_req = *(fdb_kvs_id_t*)aux;
     }
 
-    spin_lock(&file->wal->lock);
+    LOCKPROF_SPIN_LOCK(FDB_LOCK_WAL, &file->wal->lock);
 
     e1 = list_begin(&file->wal->list);
     while(e1){
@@ -905,8 +1022,10 @@ fdb_status _wal_close(struct filemgr *file,
             }
         }
     }
+    snap_cache = _wal_snap_cache_detach(file);
 
     spin_unlock(&file->wal->lock);
+    _wal_snap_cache_free(file, snap_cache);
     return FDB_RESULT_SUCCESS;
 }
 
@@ -952,7 +1071,7 @@ size_t wal_get_num_deletes(struct filemgr *file) {
 size_t wal_get_datasize(struct filemgr *file)
 {
     size_t datasize = 0;
-    spin_lock(&file->wal->lock);
+    LOCKPROF_SPIN_LOCK(FDB_LOCK_WAL, &file->wal->lock);
     datasize = file->wal->datasize;
     spin_unlock(&file->wal->lock);
 
@@ -961,7 +1080,7 @@ size_t wal_get_datasize(struct filemgr *file)
 
 void wal_set_dirty_status(struct filemgr *file, wal_dirty_t status)
 {
-    spin_lock(&file->wal->lock);
+    LOCKPROF_SPIN_LOCK(FDB_LOCK_WAL, &file->wal->lock);
     file->wal->wal_dirty = status;
     spin_unlock(&file->wal->lock);
 }
@@ -969,7 +1088,7 @@ void wal_set_dirty_status(struct filemgr *file, wal_dirty_t status)
 wal_dirty_t wal_get_dirty_status(struct filemgr *file)
 {
     wal_dirty_t ret;
-    spin_lock(&file->wal->lock);
+    LOCKPROF_SPIN_LOCK(FDB_LOCK_WAL, &file->wal->lock);
     ret = file->wal->wal_dirty;
     spin_unlock(&file->wal->lock);
     return ret;
@@ -977,14 +1096,14 @@ wal_dirty_t wal_get_dirty_status(struct filemgr *file)
 
 void wal_add_transaction(struct filemgr *file, fdb_txn *txn)
 {
-    spin_lock(&file->wal->lock);
+    LOCKPROF_SPIN_LOCK(FDB_LOCK_WAL, &file->wal->lock);
     list_push_front(&file->wal->txn_list, &txn->wrapper->le);
     spin_unlock(&file->wal->lock);
 }
 
 void wal_remove_transaction(struct filemgr *file, fdb_txn *txn)
 {
-    spin_lock(&file->wal->lock);
+    LOCKPROF_SPIN_LOCK(FDB_LOCK_WAL, &file->wal->lock);
     list_remove(&file->wal->txn_list, &txn->wrapper->le);
     spin_unlock(&file->wal->lock);
 }
@@ -997,7 +1116,7 @@ fdb_txn * wal_earliest_txn(struct filemgr *file, fdb_txn *cur_txn)
     fdb_txn *ret = NULL;
     bid_t bid = BLK_NOT_FOUND;
 
-    spin_lock(&file->wal->lock);
+    LOCKPROF_SPIN_LOCK(FDB_LOCK_WAL, &file->wal->lock);
 
     le = list_begin(&file->wal->txn_list);
     while(le) {
@@ -1022,7 +1141,7 @@ bool wal_txn_exists(struct filemgr *file)
     struct wal_txn_wrapper *txn_wrapper;
     fdb_txn *txn;
 
-    spin_lock(&file->wal->lock);
+    LOCKPROF_SPIN_LOCK(FDB_LOCK_WAL, &file->wal->lock);
 
     le = list_begin(&file->wal->txn_list);
     while(le) {
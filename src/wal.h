@@ -66,6 +66,9 @@ struct wal_item{
 typedef void wal_flush_func(void *dbhandle, struct wal_item *item);
 typedef fdb_status wal_snapshot_func(void *shandle, fdb_doc *doc,
                                      uint64_t offset);
+typedef void wal_snapshot_apply_func(void *snapshot, fdb_doc *doc,
+                                     uint64_t offset);
+typedef void wal_snapshot_free_func(void *snapshot);
 typedef uint64_t wal_get_old_offset_func(void *dbhandle,
                                          struct wal_item *item);
 typedef uint64_t wal_doc_move_func(void *dbhandle,
@@ -95,6 +98,9 @@ struct wal {
     struct list list; // list of 'wal_item_header's
     struct list txn_list; // list of active transactions
     wal_dirty_t wal_dirty;
+    void *snap_cache; // WAL snapshot shared by in-memory snapshots
+    wal_snapshot_apply_func *snap_cache_apply;
+    wal_snapshot_free_func *snap_cache_free;
     spin_t lock;
 };
 
@@ -139,6 +145,11 @@ fdb_status wal_flush_by_compactor(struct filemgr *file,
 fdb_status wal_snapshot(struct filemgr *file,
                         void *dbhandle, fdb_txn *txn,
                         wal_snapshot_func *snapshot_func);
+fdb_status wal_snapshot_share(struct filemgr *file,
+                              void *dbhandle, void *snapshot,
+                              wal_snapshot_func *snapshot_func,
+                              wal_snapshot_apply_func *apply_func,
+                              wal_snapshot_free_func *free_func);
 fdb_status wal_discard(struct filemgr *file, fdb_txn *txn);
 fdb_status wal_close(struct filemgr *file);
 fdb_status wal_shutdown(struct filemgr *file);
@@ -0,0 +1,196 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2010 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+
+#include "common.h"
+#include "filemgr.h"
+#include "filemgr_ops.h"
+#include "blockcache.h"
+#include "warmup.h"
+
+#include "memleak.h"
+
+// "FDBWARM1"
+#define WARMUP_MAGIC (0x4644425741524d31ULL)
+// magic (8 bytes) + blocksize (4 bytes) + # BIDs (8 bytes)
+#define WARMUP_HEADER_SIZE (20)
+// DB file name + ".warmup"
+#define WARMUP_MAX_PATHLEN (FDB_MAX_FILENAME_LEN + 8)
+
+static void _warmup_get_path(const char *filename, char *path)
+{
+    sprintf(path, "%s.warmup", filename);
+}
+
+void warmup_save(struct filemgr *file, const char *filename)
+{
+    int fd;
+    size_t i, nbids, len;
+    uint8_t *buf, *ptr;
+    uint32_t blocksize, crc;
+    uint64_t magic, n;
+    bid_t *bids, bid;
+    char path[WARMUP_MAX_PATHLEN];
+
+    bids = bcache_get_resident_bids(file, &nbids);
+    if (!bids) {
+        return;
+    }
+
+    len = WARMUP_HEADER_SIZE + sizeof(bid_t) * nbids + sizeof(crc);
+    buf = (uint8_t *)malloc(len);
+    ptr = buf;
+
+    magic = _endian_encode(WARMUP_MAGIC);
+    memcpy(ptr, &magic, sizeof(magic));
+    ptr += sizeof(magic);
+    blocksize = file->blocksize;
+    blocksize = _endian_encode(blocksize);
+    memcpy(ptr, &blocksize, sizeof(blocksize));
+    ptr += sizeof(blocksize);
+    n = _endian_encode((uint64_t)nbids);
+    memcpy(ptr, &n, sizeof(n));
+    ptr += sizeof(n);
+    for (i=0; i<nbids; ++i) {
+        bid = _endian_encode(bids[i]);
+        memcpy(ptr, &bid, sizeof(bid));
+        ptr += sizeof(bid);
+    }
+    crc = chksum(buf, len - sizeof(crc));
+    crc = _endian_encode(crc);
+    memcpy(ptr, &crc, sizeof(crc));
+
+    // the list is only a hint, so failures are ignored
+    _warmup_get_path(filename, path);
+    fd = file->ops->open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd >= 0) {
+        if (file->ops->pwrite(fd, buf, len, 0) != (ssize_t)len) {
+            file->ops->close(fd);
+            remove(path);
+        } else {
+            file->ops->close(fd);
+        }
+    }
+
+    free(buf);
+    free(bids);
+}
+
+static int _warmup_bid_cmp(const void *a, const void *b)
+{
+    bid_t aa = *(bid_t *)a, bb = *(bid_t *)b;
+    if (aa < bb) {
+        return -1;
+    } else if (aa > bb) {
+        return 1;
+    }
+    return 0;
+}
+
+bid_t *warmup_load(struct filemgr *file, size_t max, size_t *nbids)
+{
+    int fd;
+    size_t i, n = 0;
+    ssize_t len;
+    cs_off_t size;
+    uint8_t *buf, *ptr;
+    uint32_t blocksize, crc;
+    uint64_t magic, nentries, last_bid;
+    bid_t *bids = NULL, bid;
+    char path[WARMUP_MAX_PATHLEN];
+
+    *nbids = 0;
+    _warmup_get_path(file->filename, path);
+    size = file->ops->file_size(path);
+    if (size < (cs_off_t)(WARMUP_HEADER_SIZE + sizeof(crc))) {
+        // the list doesn't exist, or is corrupted
+        remove(path);
+        return NULL;
+    }
+    fd = file->ops->open(path, O_RDONLY, 0644);
+    if (fd < 0) {
+        return NULL;
+    }
+    buf = (uint8_t *)malloc(size);
+    len = file->ops->pread(fd, buf, size, 0);
+    file->ops->close(fd);
+    // the list is consumed here, and saved again when the file is closed
+    remove(path);
+    if (len != (ssize_t)size) {
+        free(buf);
+        return NULL;
+    }
+
+    ptr = buf;
+    memcpy(&magic, ptr, sizeof(magic));
+    ptr += sizeof(magic);
+    memcpy(&blocksize, ptr, sizeof(blocksize));
+    ptr += sizeof(blocksize);
+    memcpy(&nentries, ptr, sizeof(nentries));
+    ptr += sizeof(nentries);
+    memcpy(&crc, buf + size - sizeof(crc), sizeof(crc));
+    magic = _endian_decode(magic);
+    blocksize = _endian_decode(blocksize);
+    nentries = _endian_decode(nentries);
+    crc = _endian_decode(crc);
+
+    if (magic != WARMUP_MAGIC || blocksize != file->blocksize ||
+        WARMUP_HEADER_SIZE + nentries * sizeof(bid_t) + sizeof(crc) !=
+            (uint64_t)size ||
+        crc != chksum(buf, size - sizeof(crc))) {
+        free(buf);
+        return NULL;
+    }
+
+    spin_lock(&file->lock);
+    last_bid = file->last_commit / file->blocksize;
+    spin_unlock(&file->lock);
+
+    if (nentries > 0 && max > 0) {
+        bids = (bid_t *)malloc(sizeof(bid_t) * MIN(nentries, max));
+        // entries are in priority order, so take the first 'max' ones
+        for (i=0; i<nentries && n<max; ++i) {
+            memcpy(&bid, ptr + i * sizeof(bid), sizeof(bid));
+            bid = _endian_decode(bid);
+            if (bid < last_bid) {
+                // blocks beyond the last commit may not be valid anymore
+                bids[n++] = bid;
+            }
+        }
+    }
+    free(buf);
+
+    if (n == 0) {
+        free(bids);
+        return NULL;
+    }
+    // sort by BID so that consecutive blocks are read by a single pread
+    qsort(bids, n, sizeof(bid_t), _warmup_bid_cmp);
+    *nbids = n;
+    return bids;
+}
+
+void warmup_remove(const char *filename)
+{
+    char path[WARMUP_MAX_PATHLEN];
+    _warmup_get_path(filename, path);
+    remove(path);
+}
@@ -0,0 +1,52 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2010 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#ifndef _FDB_WARMUP_H
+#define _FDB_WARMUP_H
+
+#include <stdint.h>
+#include "internal_types.h"
+#include "filemgr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Buffer cache warm-up list, stored next to a DB file as '<filename>.warmup'.
+ * When the file is closed, the BIDs of its resident clean blocks are saved
+ * in eviction priority order (B+tree nodes and recently used blocks first),
+ * and they are read back into the cache when the file is opened again.
+ */
+
+// save the list of the file's resident blocks as the warm-up list of
+// 'filename' (which may differ from the current file name, e.g., when an
+// in-place compacted file is renamed on close)
+void warmup_save(struct filemgr *file, const char *filename);
+// read and remove the warm-up list of the file, and return at most 'max'
+// committed BIDs of the highest priority, sorted in ascending order.
+// returns NULL if there is no valid list. the array should be freed by the
+// caller.
+bid_t *warmup_load(struct filemgr *file, size_t max, size_t *nbids);
+// remove the warm-up list of the given DB file, if any
+void warmup_remove(const char *filename);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
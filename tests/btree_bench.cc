@@ -0,0 +1,207 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2010 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+/*
+ * B+tree lookup microbenchmark.
+ * Compares point lookups on 8-byte keys using the specialized node search
+ * ('find_entry' of kv ops) against the generic search that calls 'get_kv'
+ * and 'cmp' at each probe, on both interleaved and separated node layouts.
+ *
+ * usage: btree_bench [# keys] [# lookups]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "btree.h"
+#include "btree_kv.h"
+#include "test.h"
+
+#include "memleak.h"
+
+// in-memory blocks, so that the node search dominates the lookup cost
+#define BENCH_BLOCKSIZE (4096)
+
+struct mem_blocks {
+    uint8_t **blocks;
+    size_t nblocks;
+    size_t capacity;
+};
+
+static voidref _mem_blk_alloc(void *voidhandle, bid_t *bid)
+{
+    struct mem_blocks *handle = (struct mem_blocks *)voidhandle;
+    if (handle->nblocks == handle->capacity) {
+        handle->capacity = (handle->capacity)?(handle->capacity * 2):(64);
+        handle->blocks = (uint8_t **)realloc(handle->blocks,
+                                    sizeof(uint8_t *) * handle->capacity);
+    }
+    *bid = handle->nblocks;
+    handle->blocks[handle->nblocks] = (uint8_t *)calloc(1, BENCH_BLOCKSIZE);
+    return handle->blocks[handle->nblocks++];
+}
+
+static voidref _mem_blk_read(void *voidhandle, bid_t bid)
+{
+    struct mem_blocks *handle = (struct mem_blocks *)voidhandle;
+    return handle->blocks[bid];
+}
+
+static voidref _mem_blk_move(void *voidhandle, bid_t bid, bid_t *new_bid)
+{
+    void *addr = _mem_blk_alloc(voidhandle, new_bid);
+    memcpy(addr, _mem_blk_read(voidhandle, bid), BENCH_BLOCKSIZE);
+    return addr;
+}
+
+static void _mem_blk_remove(void *voidhandle, bid_t bid)
+{
+    (void)voidhandle;
+    (void)bid;
+}
+
+static int _mem_blk_is_writable(void *voidhandle, bid_t bid)
+{
+    (void)voidhandle;
+    (void)bid;
+    return 1;
+}
+
+static size_t _mem_blk_get_size(void *voidhandle, bid_t bid)
+{
+    (void)voidhandle;
+    (void)bid;
+    return BENCH_BLOCKSIZE;
+}
+
+static void _mem_blk_set_dirty(void *voidhandle, bid_t bid)
+{
+    (void)voidhandle;
+    (void)bid;
+}
+
+static struct btree_blk_ops mem_blk_ops = {
+    _mem_blk_alloc, NULL, NULL, _mem_blk_read, _mem_blk_move,
+    _mem_blk_remove, _mem_blk_is_writable, _mem_blk_get_size,
+    _mem_blk_set_dirty, NULL};
+
+static double _run_lookups(struct btree *btree, uint64_t *queries,
+                           size_t nlookups, int big_endian,
+                           uint64_t *checksum)
+{
+    size_t i;
+    uint64_t key, value;
+    struct timeval ts_begin, ts_end, ts_gap;
+
+    *checksum = 0;
+    gettimeofday(&ts_begin, NULL);
+    for (i=0; i<nlookups; ++i) {
+        key = (big_endian)?(_endian_encode(queries[i])):(queries[i]);
+        if (btree_find(btree, &key, &value) == BTREE_RESULT_SUCCESS) {
+            *checksum += value;
+        }
+    }
+    gettimeofday(&ts_end, NULL);
+    ts_gap = _utime_gap(ts_begin, ts_end);
+
+    return ts_gap.tv_sec + ts_gap.tv_usec / 1000000.0;
+}
+
+static void _bench(const char *name, struct btree_kv_ops *kv_ops,
+                   int big_endian, bnode_flag_t flag,
+                   size_t nkeys, size_t nlookups)
+{
+    size_t i;
+    uint64_t key, value, checksum[2];
+    uint64_t *queries;
+    double elapsed[2];
+    struct mem_blocks handle;
+    struct btree btree;
+    struct btree_kv_ops generic_ops;
+
+    memset(&handle, 0, sizeof(handle));
+    btree_init(&btree, (void*)&handle, &mem_blk_ops, kv_ops,
+               BENCH_BLOCKSIZE, sizeof(key), sizeof(value), flag, NULL);
+
+    // even numbers only .. half of lookups fail
+    for (i=0; i<nkeys; ++i) {
+        key = i * 2;
+        key = (big_endian)?(_endian_encode(key)):(key);
+        value = i;
+        btree_insert(&btree, &key, &value);
+    }
+
+    queries = (uint64_t *)malloc(sizeof(uint64_t) * nlookups);
+    for (i=0; i<nlookups; ++i) {
+        queries[i] = ((uint64_t)rand() * RAND_MAX + rand()) % (nkeys * 2);
+    }
+
+    elapsed[0] = _run_lookups(&btree, queries, nlookups, big_endian,
+                              &checksum[0]);
+    generic_ops = *kv_ops;
+    generic_ops.find_entry = NULL;
+    btree.kv_ops = &generic_ops;
+    elapsed[1] = _run_lookups(&btree, queries, nlookups, big_endian,
+                              &checksum[1]);
+    btree.kv_ops = kv_ops;
+
+    if (checksum[0] != checksum[1]) {
+        fprintf(stderr, "%s: lookup results mismatch\n", name);
+    }
+    printf("%s (%d levels): find_entry %.0f ops/sec, generic %.0f ops/sec "
+           "(x%.2f)\n", name, btree.height,
+           nlookups / elapsed[0], nlookups / elapsed[1],
+           elapsed[1] / elapsed[0]);
+
+    free(queries);
+    for (i=0; i<handle.nblocks; ++i) {
+        free(handle.blocks[i]);
+    }
+    free(handle.blocks);
+}
+
+int main(int argc, char **argv)
+{
+    size_t nkeys = 1000000;
+    size_t nlookups = 2000000;
+    struct btree_kv_ops *kv_ops;
+
+    if (argc > 1) {
+        nkeys = strtoul(argv[1], NULL, 10);
+    }
+    if (argc > 2) {
+        nlookups = strtoul(argv[2], NULL, 10);
+    }
+    if (nkeys == 0 || nlookups == 0) {
+        fprintf(stderr, "usage: %s [# keys] [# lookups]\n", argv[0]);
+        return 1;
+    }
+
+    // native 64-bit integer keys
+    _bench("ku64_vu64", btree_kv_get_ku64_vu64(), 0, 0x0, nkeys, nlookups);
+
+    // 8-byte binary keys (hbtrie chunks and sequence numbers)
+    kv_ops = btree_kv_get_kb64_vb64(NULL);
+    _bench("kb64_vb64", kv_ops, 1, 0x0, nkeys, nlookups);
+    // same keys on nodes whose keys and values are stored separately
+    _bench("kb64_vb64 (separated)", kv_ops, 1, BNODE_MASK_SEPARATED,
+           nkeys, nlookups);
+    free(kv_ops);
+
+    return 0;
+}
@@ -0,0 +1,265 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "btree.h"
+#include "btree_fast_str_kv.h"
+#include "test.h"
+#include "common.h"
+#include "memleak.h"
+#include "option.h"
+
+#define NODE_SIZE (4096)
+
+struct bnode* dummy_node(uint8_t ksize, uint8_t vsize, bnode_flag_t flag)
+{
+    struct bnode *node;
+    node = (struct bnode*)malloc(sizeof(bnode) + NODE_SIZE);
+    memset(node, 0, sizeof(bnode));
+
+    node->kvsize = ksize<<4 | vsize;
+    node->level = 1;
+    node->flag = flag;
+    node->data = (uint8_t *)node + sizeof(bnode);
+    return node;
+}
+
+// keys sharing a long common prefix
+static void _make_key(void *key, int i)
+{
+    char str[64];
+    int len = sprintf(str, "tenant0001:region-a:object:%08d", i);
+    btree_fast_str_kv_set_key(key, str, len);
+}
+
+static int _key_eq(void *key1, void *key2)
+{
+    char str1[256], str2[256];
+    size_t len1, len2;
+    btree_fast_str_kv_get_key(key1, str1, &len1);
+    btree_fast_str_kv_get_key(key2, str2, &len2);
+    return len1 == len2 && !memcmp(str1, str2, len1);
+}
+
+/*
+ * Test: kv_prefix_node_test
+ *
+ * verifies that a prefix-compressed node holds same entries as a node in
+ * the legacy format after inserts, updates, removals, and a split, while
+ * using less space
+ */
+void kv_prefix_node_test()
+{
+    TEST_INIT();
+    memleak_start();
+
+    int i, r;
+    idx_t idx, n_half, n;
+    uint64_t value, value1, value2;
+    void *key = NULL, *key1 = NULL, *key2 = NULL;
+    size_t size[2];
+    bnoderef node[2], split_node[2];
+    btree_kv_ops *kv_ops = btree_fast_str_kv_get_kb64_vb64(NULL);
+
+    for (i=0; i<2; ++i) {
+        node[i] = dummy_node(sizeof(void *), sizeof(value), 0x0);
+        split_node[i] = dummy_node(sizeof(void *), sizeof(value), 0x0);
+    }
+    node[1]->flag = split_node[1]->flag = BNODE_MASK_PREFIX;
+
+    for (r=0; r<60; ++r) {
+        n = node[0]->nentry;
+        idx = (n)?(rand() % (n + 1)):(0);
+        value = r;
+        _make_key(&key, rand() % 1000);
+        for (i=0; i<2; ++i) {
+            if (r % 5 == 4 && n > 0) {
+                // remove
+                kv_ops->ins_kv(node[i], idx % n, NULL, NULL);
+                node[i]->nentry--;
+            } else if (r % 5 == 3 && idx < n) {
+                // update
+                kv_ops->set_kv(node[i], idx, &key, &value);
+            } else if (idx < n) {
+                // insert
+                kv_ops->ins_kv(node[i], idx, &key, &value);
+                node[i]->nentry++;
+            } else {
+                // append
+                kv_ops->set_kv(node[i], idx, &key, &value);
+                node[i]->nentry++;
+            }
+        }
+        btree_fast_str_kv_free_key(&key);
+    }
+
+    // a key breaking the common prefix
+    btree_fast_str_kv_set_key(&key, (void *)"tenant0001:zone", 15);
+    for (i=0; i<2; ++i) {
+        size[i] = kv_ops->get_data_size(node[i], NULL, &key, &value, 1);
+        kv_ops->set_kv(node[i], node[i]->nentry, &key, &value);
+        node[i]->nentry++;
+        // estimated size should not be smaller than the actual size
+        TEST_CHK(size[i] >= kv_ops->get_data_size(node[i], NULL, NULL,
+                                                  NULL, 0));
+    }
+    btree_fast_str_kv_free_key(&key);
+
+    TEST_CHK(node[0]->nentry == node[1]->nentry);
+    TEST_CHK(kv_ops->get_data_size(node[1], NULL, NULL, NULL, 0) <
+             kv_ops->get_data_size(node[0], NULL, NULL, NULL, 0));
+    for (idx=0; idx<node[0]->nentry; ++idx) {
+        kv_ops->get_kv(node[0], idx, &key1, &value1);
+        kv_ops->get_kv(node[1], idx, &key2, &value2);
+        TEST_CHK(_key_eq(&key1, &key2) && value1 == value2);
+    }
+
+    // split: copy the upper half into a new node, and truncate the node
+    n_half = node[0]->nentry / 2;
+    for (i=0; i<2; ++i) {
+        kv_ops->copy_kv(split_node[i], node[i], 0, n_half,
+                        node[i]->nentry - n_half);
+        kv_ops->copy_kv(node[i], node[i], 0, 0, n_half);
+        split_node[i]->nentry = node[i]->nentry - n_half;
+        node[i]->nentry = n_half;
+    }
+    for (idx=0; idx<node[0]->nentry; ++idx) {
+        kv_ops->get_kv(node[0], idx, &key1, &value1);
+        kv_ops->get_kv(node[1], idx, &key2, &value2);
+        TEST_CHK(_key_eq(&key1, &key2) && value1 == value2);
+    }
+    for (idx=0; idx<split_node[0]->nentry; ++idx) {
+        kv_ops->get_kv(split_node[0], idx, &key1, &value1);
+        kv_ops->get_kv(split_node[1], idx, &key2, &value2);
+        TEST_CHK(_key_eq(&key1, &key2) && value1 == value2);
+    }
+    btree_fast_str_kv_free_key(&key1);
+    btree_fast_str_kv_free_key(&key2);
+
+    for (i=0; i<2; ++i) {
+        free(node[i]);
+        free(split_node[i]);
+    }
+    free(kv_ops);
+
+    memleak_end();
+    TEST_RESULT("kv prefix node test");
+}
+
+// in-memory blocks
+struct mem_blocks {
+    uint8_t *blocks[4096];
+    size_t nblocks;
+};
+
+static voidref _mem_blk_alloc(void *voidhandle, bid_t *bid)
+{
+    struct mem_blocks *handle = (struct mem_blocks *)voidhandle;
+    *bid = handle->nblocks;
+    handle->blocks[handle->nblocks] = (uint8_t *)calloc(1, NODE_SIZE);
+    return handle->blocks[handle->nblocks++];
+}
+
+static voidref _mem_blk_read(void *voidhandle, bid_t bid)
+{
+    return ((struct mem_blocks *)voidhandle)->blocks[bid];
+}
+
+static voidref _mem_blk_move(void *voidhandle, bid_t bid, bid_t *new_bid)
+{
+    void *addr = _mem_blk_alloc(voidhandle, new_bid);
+    memcpy(addr, _mem_blk_read(voidhandle, bid), NODE_SIZE);
+    return addr;
+}
+
+static void _mem_blk_remove(void *voidhandle, bid_t bid)
+{
+}
+
+static int _mem_blk_is_writable(void *voidhandle, bid_t bid)
+{
+    return 1;
+}
+
+static size_t _mem_blk_get_size(void *voidhandle, bid_t bid)
+{
+    return NODE_SIZE;
+}
+
+static void _mem_blk_set_dirty(void *voidhandle, bid_t bid)
+{
+}
+
+static struct btree_blk_ops mem_blk_ops = {
+    _mem_blk_alloc, NULL, NULL, _mem_blk_read, _mem_blk_move,
+    _mem_blk_remove, _mem_blk_is_writable, _mem_blk_get_size,
+    _mem_blk_set_dirty, NULL};
+
+/*
+ * Test: btree_prefix_test
+ *
+ * builds B+trees using both node formats, and verifies that all keys are
+ * retrieved and the prefix-compressed tree uses fewer nodes
+ */
+void btree_prefix_test()
+{
+    TEST_INIT();
+    memleak_start();
+
+    int i, j, n = 5000;
+    uint64_t value, value_out;
+    void *key = NULL;
+    size_t nblocks[2];
+    struct mem_blocks handle;
+    struct btree btree;
+    btree_kv_ops *kv_ops = btree_fast_str_kv_get_kb64_vb64(NULL);
+    btree_result br;
+
+    for (j=0; j<2; ++j) {
+        memset(&handle, 0, sizeof(handle));
+        btree_init(&btree, (void *)&handle, &mem_blk_ops, kv_ops, NODE_SIZE,
+                   sizeof(void *), sizeof(value),
+                   (j)?(BNODE_MASK_PREFIX):(0x0), NULL);
+        for (i=0; i<n; ++i) {
+            // scattered insertion order
+            _make_key(&key, (i * 7919) % n);
+            value = (i * 7919) % n;
+            btree_insert(&btree, &key, &value);
+            btree_fast_str_kv_free_key(&key);
+        }
+        for (i=0; i<n; ++i) {
+            _make_key(&key, i);
+            br = btree_find(&btree, &key, &value_out);
+            TEST_CHK(br == BTREE_RESULT_SUCCESS);
+            TEST_CHK(value_out == (uint64_t)i);
+            btree_fast_str_kv_free_key(&key);
+        }
+        _make_key(&key, n);
+        br = btree_find(&btree, &key, &value_out);
+        TEST_CHK(br == BTREE_RESULT_FAIL);
+        btree_fast_str_kv_free_key(&key);
+
+        nblocks[j] = handle.nblocks;
+        for (i=0; i<(int)handle.nblocks; ++i) {
+            free(handle.blocks[i]);
+        }
+    }
+    TEST_CHK(nblocks[1] < nblocks[0]);
+    free(kv_ops);
+
+    memleak_end();
+    TEST_RESULT("btree prefix test");
+}
+
+int main()
+{
+    #ifdef _MEMPOOL
+        mempool_init();
+    #endif
+
+    kv_prefix_node_test();
+    btree_prefix_test();
+
+    return 0;
+}
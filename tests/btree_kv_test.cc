@@ -864,6 +864,250 @@ void kv_bid_to_value_to_bid_test(btree_kv_ops *kv_ops)
     TEST_RESULT("kv_bid_to_value_to_bid_test");
 }
 
+static btree_kv_ops *sort_kv_ops;
+
+static int _sort_cmp(const void *a, const void *b)
+{
+    return sort_kv_ops->cmp((void *)a, (void *)b, NULL);
+}
+
+/*
+ * Test: kv_find_entry_test
+ *
+ * verifies that the specialized node search returns same index as
+ * the search using the compare function
+ */
+void kv_find_entry_test(btree_kv_ops *kv_ops)
+{
+    TEST_INIT();
+    memleak_start();
+
+    bnoderef node;
+    int i, j, n;
+    idx_t idx, expected;
+    uint64_t query, v = 0;
+    uint64_t *keys;
+    const uint8_t ksize = 8;
+    const uint8_t vsize = 8;
+    const int max_n = FDB_BLOCKSIZE / (ksize + vsize);
+
+    TEST_CHK(kv_ops->find_entry != NULL);
+    keys = (uint64_t *)malloc(sizeof(uint64_t) * max_n);
+    sort_kv_ops = kv_ops;
+
+    for (n=0; n<=max_n; n+=(n<40)?(1):(37)) {
+        node = dummy_node(ksize, vsize, 1);
+        for (i=0; i<n; ++i) {
+            // random keys including ones whose MSB is set
+            keys[i] = ((uint64_t)rand() << 33) ^ ((uint64_t)rand() << 11) ^
+                      (uint64_t)rand();
+        }
+        qsort(keys, n, sizeof(uint64_t), _sort_cmp);
+        for (i=0; i<n; ++i) {
+            kv_ops->set_kv(node, i, &keys[i], &v);
+        }
+        node->nentry = n;
+
+        for (i=0; i<n*3+1; ++i) {
+            switch (i % 3) {
+            case 0: // exact key
+                query = keys[i/3 % ((n)?(n):(1))];
+                break;
+            case 1: // key next to an existing one
+                query = keys[i/3 % ((n)?(n):(1))] + 1;
+                break;
+            default: // random key
+                query = ((uint64_t)rand() << 33) ^ (uint64_t)rand();
+            }
+            if (n == 0) {
+                query = i;
+            }
+
+            expected = BTREE_IDX_NOT_FOUND;
+            for (j=0; j<n; ++j) {
+                if (kv_ops->cmp(&keys[j], &query, NULL) <= 0) {
+                    expected = j;
+                }
+            }
+            idx = kv_ops->find_entry(node, &query);
+            TEST_CHK(idx == expected);
+        }
+        free(node);
+    }
+    free(keys);
+
+    memleak_end();
+    TEST_RESULT("kv find entry test");
+}
+
+/*
+ * Test: kv_fixed_ops_test
+ *
+ * verifies that the operations specialized for fixed key/value sizes
+ * produce same node contents as the generic operations
+ */
+void kv_fixed_ops_test(btree_kv_ops *kv_ops, uint8_t ksize)
+{
+    TEST_INIT();
+    memleak_start();
+
+    int i, n = 16;
+    const uint8_t vsize = 8;
+    bnoderef node1, node2, node3, node4;
+    uint8_t key[8], value[8], key1[8], value1[8], key2[8], value2[8];
+    btree_kv_ops *generic_ops = btree_kv_get_ku64_vu64();
+    struct btree tree;
+
+    node1 = dummy_node(ksize, vsize, 1);
+    node2 = dummy_node(ksize, vsize, 1);
+    node3 = dummy_node(ksize, vsize, 1);
+    node4 = dummy_node(ksize, vsize, 1);
+
+    // insert in reverse order, so that entries are shifted by ins_kv
+    for (i=0; i<n; ++i) {
+        memset(key, 'a' + i, ksize);
+        memset(value, 'A' + i, vsize);
+        kv_ops->ins_kv(node1, 0, key, value);
+        generic_ops->ins_kv(node2, 0, key, value);
+        node1->nentry++;
+        node2->nentry++;
+    }
+    TEST_CHK(!memcmp(node1->data, node2->data, n * (ksize + vsize)));
+    TEST_CHK(kv_ops->get_data_size(node1, NULL, NULL, NULL, 0) ==
+             generic_ops->get_data_size(node2, NULL, NULL, NULL, 0));
+    TEST_CHK(kv_ops->get_data_size(node1, NULL, key, value, 3) ==
+             generic_ops->get_data_size(node2, NULL, key, value, 3));
+
+    for (i=0; i<n; ++i) {
+        kv_ops->get_kv(node1, i, key1, value1);
+        generic_ops->get_kv(node2, i, key2, value2);
+        TEST_CHK(!memcmp(key1, key2, ksize));
+        TEST_CHK(!memcmp(value1, value2, vsize));
+    }
+
+    // overwrite, copy, and remove entries
+    memset(key, 'z', ksize);
+    memset(value, 'Z', vsize);
+    kv_ops->set_kv(node1, 3, key, value);
+    generic_ops->set_kv(node2, 3, key, value);
+    kv_ops->copy_kv(node3, node1, 0, 4, 8);
+    generic_ops->copy_kv(node4, node2, 0, 4, 8);
+    TEST_CHK(!memcmp(node3->data, node4->data, 8 * (ksize + vsize)));
+    kv_ops->ins_kv(node1, 5, NULL, NULL);
+    generic_ops->ins_kv(node2, 5, NULL, NULL);
+    TEST_CHK(!memcmp(node1->data, node2->data, (n-1) * (ksize + vsize)));
+
+    kv_ops->get_nth_splitter(node1, node3, key1);
+    generic_ops->get_nth_splitter(node2, node4, key2);
+    TEST_CHK(!memcmp(key1, key2, ksize));
+
+    tree.ksize = ksize;
+    tree.vsize = vsize;
+    TEST_CHK(kv_ops->get_kv_size(&tree, key, value) == (size_t)ksize + vsize);
+    TEST_CHK(kv_ops->get_kv_size(&tree, key, NULL) == ksize);
+    kv_ops->set_key(&tree, key1, key);
+    TEST_CHK(!memcmp(key1, key, ksize));
+    kv_ops->set_value(&tree, value1, value);
+    TEST_CHK(!memcmp(value1, value, vsize));
+
+    free(node1);
+    free(node2);
+    free(node3);
+    free(node4);
+
+    memleak_end();
+    TEST_RESULT("kv fixed ops test");
+}
+
+/*
+ * Test: kv_separated_layout_test
+ *
+ * verifies that a node storing keys and values in separate arrays holds
+ * same entries as a node in the interleaved layout after a sequence of
+ * inserts, updates, removals, and a split
+ */
+void kv_separated_layout_test(btree_kv_ops *kv_ops)
+{
+    TEST_INIT();
+    memleak_start();
+
+    int i, r;
+    idx_t idx, n_half;
+    uint64_t key, value, key1, value1, key2, value2;
+    bnoderef node[2], split_node[2];
+    const uint8_t ksize = 8;
+    const uint8_t vsize = 8;
+
+    for (i=0; i<2; ++i) {
+        node[i] = dummy_node(ksize, vsize, 1);
+        split_node[i] = dummy_node(ksize, vsize, 1);
+    }
+    node[1]->flag = split_node[1]->flag = BNODE_MASK_SEPARATED;
+
+    for (r=0; r<400; ++r) {
+        idx = (node[0]->nentry)?(rand() % (node[0]->nentry + 1)):(0);
+        key = rand();
+        value = r;
+        for (i=0; i<2; ++i) {
+            if (r % 5 == 4 && node[i]->nentry > 0) {
+                // remove
+                idx = idx % node[i]->nentry;
+                kv_ops->ins_kv(node[i], idx, NULL, NULL);
+                node[i]->nentry--;
+            } else if (r % 5 == 3 && idx < node[i]->nentry) {
+                // update
+                kv_ops->set_kv(node[i], idx, &key, &value);
+            } else if (idx < node[i]->nentry) {
+                // insert
+                kv_ops->ins_kv(node[i], idx, &key, &value);
+                node[i]->nentry++;
+            } else {
+                // append
+                kv_ops->set_kv(node[i], idx, &key, &value);
+                node[i]->nentry++;
+            }
+        }
+    }
+    TEST_CHK(node[0]->nentry == node[1]->nentry);
+    TEST_CHK(kv_ops->get_data_size(node[0], NULL, NULL, NULL, 0) ==
+             kv_ops->get_data_size(node[1], NULL, NULL, NULL, 0));
+    for (idx=0; idx<node[0]->nentry; ++idx) {
+        kv_ops->get_kv(node[0], idx, &key1, &value1);
+        kv_ops->get_kv(node[1], idx, &key2, &value2);
+        TEST_CHK(key1 == key2 && value1 == value2);
+    }
+
+    // split: copy the upper half into a new node, and truncate the node
+    n_half = node[0]->nentry / 2;
+    for (i=0; i<2; ++i) {
+        kv_ops->copy_kv(split_node[i], node[i], 0, n_half,
+                        node[i]->nentry - n_half);
+        kv_ops->copy_kv(node[i], node[i], 0, 0, n_half);
+        split_node[i]->nentry = node[i]->nentry - n_half;
+        node[i]->nentry = n_half;
+    }
+    for (idx=0; idx<node[0]->nentry; ++idx) {
+        kv_ops->get_kv(node[0], idx, &key1, &value1);
+        kv_ops->get_kv(node[1], idx, &key2, &value2);
+        TEST_CHK(key1 == key2 && value1 == value2);
+    }
+    for (idx=0; idx<split_node[0]->nentry; ++idx) {
+        kv_ops->get_kv(split_node[0], idx, &key1, &value1);
+        kv_ops->get_kv(split_node[1], idx, &key2, &value2);
+        TEST_CHK(key1 == key2 && value1 == value2);
+    }
+    kv_ops->get_nth_splitter(node[1], split_node[1], &key1);
+    kv_ops->get_kv(split_node[0], 0, &key2, NULL);
+    TEST_CHK(key1 == key2);
+
+    for (i=0; i<2; ++i) {
+        free(node[i]);
+        free(split_node[i]);
+    }
+
+    memleak_end();
+    TEST_RESULT("kv separated layout test");
+}
 
 int main()
 {
@@ -877,6 +1121,22 @@ int main()
     ops[0] = btree_kv_get_ku64_vu64();
     ops[1] = btree_kv_get_ku32_vu64();
 
+    // specialized search on fixed-size keys
+    kv_find_entry_test(ops[0]);
+    btree_kv_ops *kb64_ops = btree_kv_get_kb64_vb64(NULL);
+    kv_find_entry_test(kb64_ops);
+
+    // operations specialized for fixed key/value sizes
+    kv_fixed_ops_test(kb64_ops, 8);
+
+    // nodes storing keys and values separately
+    kv_separated_layout_test(ops[0]);
+    kv_separated_layout_test(kb64_ops);
+    free(kb64_ops);
+    btree_kv_ops *kb32_ops = btree_kv_get_kb32_vb64(NULL);
+    kv_fixed_ops_test(kb32_ops, 4);
+    free(kb32_ops);
+
     for (i=0; i<2; i++){
 
         kv_init_ops_test(i);
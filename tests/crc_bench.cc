@@ -0,0 +1,91 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2010 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+/*
+ * Block checksum microbenchmark.
+ * Compares the throughput of the legacy CRC32 (slicing-by-8) against
+ * CRC32C computed by the table-driven and the runtime-selected
+ * (possibly hardware-accelerated) implementations, over blocks of the
+ * given size as done for every b-tree node read and written.
+ *
+ * usage: crc_bench [block size] [# blocks]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test.h"
+#include "crc32.h"
+
+typedef uint32_t crc_func(void *data, size_t len, uint32_t prev_value);
+
+static void _bench(const char *name, crc_func *func, uint8_t *buf,
+                   size_t blocksize, size_t nblocks)
+{
+    size_t i;
+    uint32_t crc = 0;
+    double elapsed;
+    struct timeval ts_begin, ts_end, ts_gap;
+
+    gettimeofday(&ts_begin, NULL);
+    for (i=0; i<nblocks; ++i) {
+        // blocks are checksummed independently
+        crc ^= func(buf + (i % 64) * blocksize, blocksize, 0);
+    }
+    gettimeofday(&ts_end, NULL);
+    ts_gap = _utime_gap(ts_begin, ts_end);
+    elapsed = ts_gap.tv_sec + ts_gap.tv_usec / 1000000.0;
+
+    printf("%-20s %10.1f MB/s %12.0f blocks/sec (%08x)\n", name,
+           blocksize * nblocks / elapsed / (1024 * 1024),
+           nblocks / elapsed, crc);
+}
+
+int main(int argc, char **argv)
+{
+    size_t i;
+    size_t blocksize = 4096;
+    size_t nblocks = 1000000;
+    uint8_t *buf;
+
+    if (argc > 1) {
+        blocksize = strtoul(argv[1], NULL, 10);
+    }
+    if (argc > 2) {
+        nblocks = strtoul(argv[2], NULL, 10);
+    }
+    if (blocksize == 0 || nblocks == 0) {
+        fprintf(stderr, "usage: %s [block size] [# blocks]\n", argv[0]);
+        return 1;
+    }
+
+    // 64 distinct blocks, so that the data stays in the CPU cache
+    buf = (uint8_t *)malloc(blocksize * 64);
+    for (i=0; i<blocksize * 64; ++i) {
+        buf[i] = rand();
+    }
+
+    printf("block size %d bytes, CRC32C implementation: %s\n",
+           (int)blocksize, crc32c_impl_name());
+    _bench("crc32 (slicing-8)", crc32_8, buf, blocksize, nblocks);
+    _bench("crc32c (slicing-8)", crc32c_8, buf, blocksize, nblocks);
+    _bench("crc32c", crc32c, buf, blocksize, nblocks);
+
+    free(buf);
+    return 0;
+}
@@ -110,9 +110,43 @@ void endian_test()
 
 }
 
+void crc32c_test()
+{
+    TEST_INIT();
+
+    size_t i, len = 4096 + 7;
+    uint8_t *buf;
+    uint32_t r1, r2, r3;
+    char str[] = "123456789";
+
+    // check value of CRC32C
+    TEST_CHK(crc32c_8(str, strlen(str), 0) == 0xe3069283);
+    TEST_CHK(crc32c(str, strlen(str), 0) == 0xe3069283);
+
+    buf = (uint8_t *)malloc(len + 8);
+    for (i=0; i<len + 8; ++i) {
+        buf[i] = rand();
+    }
+    // the selected implementation should produce the same value for
+    // unaligned and incrementally checksummed data
+    for (i=0; i<8; ++i) {
+        r1 = crc32c_8(buf + i, len, 0);
+        r2 = crc32c(buf + i, len, 0);
+        r3 = crc32c(buf + i, 1000 + i, 0);
+        r3 = crc32c(buf + i + 1000 + i, len - 1000 - i, r3);
+        TEST_CHK(r1 == r2);
+        TEST_CHK(r1 == r3);
+    }
+    free(buf);
+
+    DBG("crc32c implementation: %s\n", crc32c_impl_name());
+    TEST_RESULT("crc32c test");
+}
+
 int main()
 {
     basic_test();
+    crc32c_test();
     adler_test();
     endian_test();
     return 0;
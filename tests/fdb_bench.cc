@@ -0,0 +1,1003 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2010 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+/*
+ * Multi-threaded ForestDB benchmark.
+ * Each thread opens its own file handle and runs the given workload for a
+ * fixed duration (or number of operations). Throughput, latency percentiles
+ * of each operation type, and write amplification are reported as JSON on
+ * stdout.
+ *
+ * workloads:
+ *   load         sequential insertion of --keys keys
+ *   load-random  random order insertion of --keys keys
+ *   ycsb-a       50% read, 50% update
+ *   ycsb-b       95% read, 5% update
+ *   ycsb-c       100% read
+ *   ycsb-d       95% read (latest keys), 5% insert
+ *   ycsb-e       95% range scan, 5% insert
+ *   ycsb-f       50% read, 50% read-modify-write
+ *   get          100% point get
+ *   scan         100% range scan
+ *   commit       update followed by a durable commit
+ *   compact      ycsb-a mix while another thread repeatedly compacts the file
+ *
+ * usage: fdb_bench [--option=value ...] (see _print_usage())
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "libforestdb/forestdb.h"
+#include "test.h"
+#include "time_utils.h"
+
+#define BENCH_MAX_KEYSIZE (256)
+
+typedef enum {
+    OP_READ = 0,
+    OP_UPDATE,
+    OP_INSERT,
+    OP_SCAN,
+    OP_RMW,
+    OP_COMMIT,
+    OP_COMPACT,
+    NUM_OPS
+} bench_op_t;
+
+static const char *op_names[NUM_OPS] = {
+    "read", "update", "insert", "scan", "read_modify_write", "commit",
+    "compact"
+};
+
+typedef enum {
+    DIST_FIXED = 0,
+    DIST_UNIFORM,
+    DIST_ZIPFIAN,
+    DIST_LATEST
+} bench_dist_t;
+
+struct bench_config {
+    const char *workload;
+    const char *filename;
+    size_t nthreads;
+    uint64_t nkeys;
+    uint64_t nops; // per thread, 0: run for 'duration'
+    double duration;
+    size_t keysize;
+    size_t value_min, value_max;
+    bench_dist_t key_dist;
+    bench_dist_t value_dist;
+    double zipf_theta;
+    size_t scan_length;
+    size_t batch;
+    double compact_interval;
+    bool keep_file;
+    fdb_config fconfig;
+};
+
+// operation mix of a workload, in percent
+struct bench_mix {
+    int ratio[NUM_OPS];
+    bool load;
+    bool random_load;
+    bool compaction;
+};
+
+// log-linear latency histogram (nanoseconds), kept per thread and merged
+// after the run
+#define HIST_SUB_BITS (4)
+#define HIST_MAX_BITS (40)
+#define HIST_NBUCKETS ((HIST_MAX_BITS - HIST_SUB_BITS + 1) << HIST_SUB_BITS)
+
+struct bench_hist {
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+    uint64_t buckets[HIST_NBUCKETS];
+};
+
+static size_t _hist_bucket(uint64_t value)
+{
+    int msb = 0;
+    if (value < (1 << HIST_SUB_BITS)) {
+        return value;
+    }
+    while (value >> (msb + 1)) {
+        msb++;
+    }
+    if (msb >= HIST_MAX_BITS) {
+        return HIST_NBUCKETS - 1;
+    }
+    return ((msb - HIST_SUB_BITS + 1) << HIST_SUB_BITS) +
+           ((value >> (msb - HIST_SUB_BITS)) & ((1 << HIST_SUB_BITS) - 1));
+}
+
+static uint64_t _hist_bucket_max(size_t idx)
+{
+    int msb;
+    uint64_t sub;
+    if (idx < (1 << HIST_SUB_BITS)) {
+        return idx;
+    }
+    msb = (idx >> HIST_SUB_BITS) + HIST_SUB_BITS - 1;
+    sub = idx & ((1 << HIST_SUB_BITS) - 1);
+    return ((uint64_t)1 << msb) + ((sub + 1) << (msb - HIST_SUB_BITS)) - 1;
+}
+
+static void _hist_add(struct bench_hist *hist, uint64_t value)
+{
+    hist->buckets[_hist_bucket(value)]++;
+    hist->count++;
+    hist->sum += value;
+    if (value > hist->max) {
+        hist->max = value;
+    }
+}
+
+static void _hist_merge(struct bench_hist *dst, struct bench_hist *src)
+{
+    size_t i;
+    for (i=0; i<HIST_NBUCKETS; ++i) {
+        dst->buckets[i] += src->buckets[i];
+    }
+    dst->count += src->count;
+    dst->sum += src->sum;
+    if (src->max > dst->max) {
+        dst->max = src->max;
+    }
+}
+
+static uint64_t _hist_percentile(struct bench_hist *hist, double ratio)
+{
+    size_t i;
+    uint64_t sum = 0, value;
+    for (i=0; i<HIST_NBUCKETS; ++i) {
+        sum += hist->buckets[i];
+        if (sum >= (uint64_t)(ratio * hist->count + 0.5) && sum) {
+            value = _hist_bucket_max(i);
+            return (value < hist->max)?(value):(hist->max);
+        }
+    }
+    return hist->max;
+}
+
+// xorshift64*
+static uint64_t _rand64(uint64_t *state)
+{
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 2685821657736338717ULL;
+}
+
+static double _rand_double(uint64_t *state)
+{
+    return (_rand64(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static uint64_t _fnv64(uint64_t value)
+{
+    int i;
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (i=0; i<8; ++i) {
+        hash ^= value & 0xff;
+        hash *= 1099511628211ULL;
+        value >>= 8;
+    }
+    return hash;
+}
+
+// Zipfian generator of Gray et al. (as used by YCSB), over [0, n)
+struct zipf_gen {
+    uint64_t n;
+    double theta, alpha, zetan, eta;
+};
+
+static void _zipf_init(struct zipf_gen *zipf, uint64_t n, double theta)
+{
+    uint64_t i;
+    double zeta2 = 1.0 + pow(0.5, theta);
+
+    zipf->n = (n)?(n):(1);
+    zipf->theta = theta;
+    zipf->alpha = 1.0 / (1.0 - theta);
+    zipf->zetan = 0;
+    for (i=1; i<=zipf->n; ++i) {
+        zipf->zetan += 1.0 / pow((double)i, theta);
+    }
+    zipf->eta = (1.0 - pow(2.0 / zipf->n, 1.0 - theta)) /
+                (1.0 - zeta2 / zipf->zetan);
+}
+
+static uint64_t _zipf_next(struct zipf_gen *zipf, uint64_t *state)
+{
+    double u = _rand_double(state);
+    double uz = u * zipf->zetan;
+    uint64_t ret;
+
+    if (uz < 1.0) {
+        return 0;
+    }
+    if (uz < 1.0 + pow(0.5, zipf->theta)) {
+        return 1;
+    }
+    ret = (uint64_t)(zipf->n * pow(zipf->eta * u - zipf->eta + 1.0,
+                                   zipf->alpha));
+    return (ret < zipf->n)?(ret):(zipf->n - 1);
+}
+
+// state shared by all threads
+struct bench_shared {
+    struct bench_config *config;
+    struct bench_mix *mix;
+    struct zipf_gen key_zipf;
+    struct zipf_gen value_zipf;
+    uint8_t *value_buf;
+    spin_t lock;
+    // number of keys inserted so far (key indexes are [0, nkeys_inserted))
+    uint64_t nkeys_inserted;
+    // next key index to be loaded
+    uint64_t load_cursor;
+    volatile int stop;
+};
+
+struct bench_thread {
+    int tid;
+    struct bench_shared *shared;
+    uint64_t rand_state;
+    uint64_t nops;
+    uint64_t nnot_found;
+    uint64_t user_bytes;
+    struct bench_hist hists[NUM_OPS];
+    // I/O stats of the file at the end of the run (compactor only)
+    fdb_io_stats io;
+    fdb_status error;
+};
+
+static size_t _make_key(struct bench_config *config, uint64_t idx, bool hashed,
+                        char *buf)
+{
+    size_t i;
+    uint64_t limit = 1;
+
+    if (hashed) {
+        // spread keys over the key space, as YCSB does
+        idx = _fnv64(idx);
+    }
+    for (i=0; i<config->keysize && i<19; ++i) {
+        limit *= 10;
+    }
+    if (config->keysize < 20) {
+        idx %= limit;
+    }
+    sprintf(buf, "%0*llu", (int)config->keysize, (unsigned long long)idx);
+    return config->keysize;
+}
+
+static size_t _value_size(struct bench_thread *t)
+{
+    struct bench_config *config = t->shared->config;
+    size_t range = config->value_max - config->value_min + 1;
+
+    switch (config->value_dist) {
+    case DIST_UNIFORM:
+        return config->value_min + _rand64(&t->rand_state) % range;
+    case DIST_ZIPFIAN:
+        // smaller values are more frequent
+        return config->value_min +
+               _zipf_next(&t->shared->value_zipf, &t->rand_state);
+    default:
+        return config->value_min;
+    }
+}
+
+static uint64_t _next_key_idx(struct bench_thread *t)
+{
+    uint64_t n, rank;
+    struct bench_shared *shared = t->shared;
+
+    spin_lock(&shared->lock);
+    n = shared->nkeys_inserted;
+    spin_unlock(&shared->lock);
+    if (n == 0) {
+        return 0;
+    }
+
+    switch (shared->config->key_dist) {
+    case DIST_ZIPFIAN:
+        rank = _zipf_next(&shared->key_zipf, &t->rand_state);
+        // scatter popular keys
+        return _fnv64(rank) % n;
+    case DIST_LATEST:
+        rank = _zipf_next(&shared->key_zipf, &t->rand_state);
+        return (rank < n)?(n - 1 - rank):(0);
+    default:
+        return _rand64(&t->rand_state) % n;
+    }
+}
+
+static fdb_status _do_set(struct bench_thread *t, fdb_kvs_handle *db,
+                          uint64_t idx, bench_op_t op)
+{
+    char key[BENCH_MAX_KEYSIZE];
+    size_t keylen, vlen;
+    uint64_t begin;
+    fdb_doc doc;
+    fdb_status s;
+    struct bench_config *config = t->shared->config;
+
+    keylen = _make_key(config, idx, !t->shared->mix->load ||
+                                    t->shared->mix->random_load, key);
+    vlen = _value_size(t);
+
+    memset(&doc, 0, sizeof(doc));
+    doc.key = key;
+    doc.keylen = keylen;
+    doc.body = t->shared->value_buf +
+               _rand64(&t->rand_state) % (config->value_max + 1);
+    doc.bodylen = vlen;
+
+    begin = get_monotonic_ts();
+    s = fdb_set(db, &doc);
+    if (op != OP_RMW) {
+        _hist_add(&t->hists[op], get_monotonic_ts() - begin);
+    }
+    t->user_bytes += keylen + vlen;
+    return s;
+}
+
+static fdb_status _do_get(struct bench_thread *t, fdb_kvs_handle *db,
+                          uint64_t idx, bench_op_t op)
+{
+    char key[BENCH_MAX_KEYSIZE];
+    uint64_t begin;
+    fdb_doc doc;
+    fdb_status s;
+
+    memset(&doc, 0, sizeof(doc));
+    doc.key = key;
+    doc.keylen = _make_key(t->shared->config, idx, true, key);
+
+    begin = get_monotonic_ts();
+    s = fdb_get(db, &doc);
+    if (op != OP_RMW) {
+        _hist_add(&t->hists[op], get_monotonic_ts() - begin);
+    }
+    free(doc.meta);
+    free(doc.body);
+    if (s == FDB_RESULT_KEY_NOT_FOUND) {
+        // inserted by another thread but not committed yet
+        t->nnot_found++;
+        s = FDB_RESULT_SUCCESS;
+    }
+    return s;
+}
+
+static fdb_status _do_scan(struct bench_thread *t, fdb_kvs_handle *db)
+{
+    char key[BENCH_MAX_KEYSIZE];
+    size_t i, len;
+    uint64_t begin;
+    fdb_iterator *it;
+    fdb_doc *doc;
+    fdb_status s;
+    struct bench_config *config = t->shared->config;
+
+    _make_key(config, _next_key_idx(t), true, key);
+    len = 1 + _rand64(&t->rand_state) % config->scan_length;
+
+    begin = get_monotonic_ts();
+    s = fdb_iterator_init(db, &it, key, config->keysize, NULL, 0,
+                          FDB_ITR_NO_DELETES);
+    if (s != FDB_RESULT_SUCCESS) {
+        return s;
+    }
+    for (i=0; i<len; ++i) {
+        doc = NULL;
+        if (fdb_iterator_next(it, &doc) != FDB_RESULT_SUCCESS) {
+            break;
+        }
+        fdb_doc_free(doc);
+    }
+    fdb_iterator_close(it);
+    _hist_add(&t->hists[OP_SCAN], get_monotonic_ts() - begin);
+    return FDB_RESULT_SUCCESS;
+}
+
+static fdb_status _do_commit(struct bench_thread *t, fdb_file_handle *dbfile)
+{
+    uint64_t begin = get_monotonic_ts();
+    fdb_status s = fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+    _hist_add(&t->hists[OP_COMMIT], get_monotonic_ts() - begin);
+    return s;
+}
+
+static bench_op_t _choose_op(struct bench_thread *t)
+{
+    int i, r = _rand64(&t->rand_state) % 100;
+    for (i=0; i<NUM_OPS; ++i) {
+        if (r < t->shared->mix->ratio[i]) {
+            return (bench_op_t)i;
+        }
+        r -= t->shared->mix->ratio[i];
+    }
+    return OP_READ;
+}
+
+static bool _run_finished(struct bench_thread *t, uint64_t begin)
+{
+    struct bench_config *config = t->shared->config;
+    if (t->shared->stop) {
+        return true;
+    }
+    if (config->nops) {
+        return t->nops >= config->nops;
+    }
+    return (get_monotonic_ts() - begin) / 1e9 >= config->duration;
+}
+
+static void * _worker(void *voidargs)
+{
+    struct bench_thread *t = (struct bench_thread *)voidargs;
+    struct bench_shared *shared = t->shared;
+    struct bench_config *config = shared->config;
+    fdb_file_handle *dbfile;
+    fdb_kvs_handle *db;
+    fdb_kvs_config kvs_config = fdb_get_default_kvs_config();
+    fdb_status s = FDB_RESULT_SUCCESS;
+    uint64_t begin, rmw_begin, idx, nwrites = 0;
+    bench_op_t op;
+
+    s = fdb_open(&dbfile, config->filename, &config->fconfig);
+    if (s != FDB_RESULT_SUCCESS) {
+        t->error = s;
+        return NULL;
+    }
+    fdb_kvs_open_default(dbfile, &db, &kvs_config);
+
+    begin = get_monotonic_ts();
+    while (s == FDB_RESULT_SUCCESS) {
+        if (shared->mix->load) {
+            // take the next key to be loaded
+            spin_lock(&shared->lock);
+            idx = shared->load_cursor++;
+            spin_unlock(&shared->lock);
+            if (idx >= config->nkeys) {
+                break;
+            }
+            s = _do_set(t, db, idx, OP_INSERT);
+            op = OP_INSERT;
+        } else {
+            if (_run_finished(t, begin)) {
+                break;
+            }
+            op = _choose_op(t);
+            switch (op) {
+            case OP_READ:
+                s = _do_get(t, db, _next_key_idx(t), OP_READ);
+                break;
+            case OP_UPDATE:
+                s = _do_set(t, db, _next_key_idx(t), OP_UPDATE);
+                break;
+            case OP_INSERT:
+                spin_lock(&shared->lock);
+                idx = shared->nkeys_inserted++;
+                spin_unlock(&shared->lock);
+                s = _do_set(t, db, idx, OP_INSERT);
+                break;
+            case OP_SCAN:
+                s = _do_scan(t, db);
+                break;
+            case OP_RMW:
+                rmw_begin = get_monotonic_ts();
+                idx = _next_key_idx(t);
+                s = _do_get(t, db, idx, OP_RMW);
+                if (s == FDB_RESULT_SUCCESS) {
+                    s = _do_set(t, db, idx, OP_RMW);
+                }
+                _hist_add(&t->hists[OP_RMW], get_monotonic_ts() - rmw_begin);
+                break;
+            default:
+                break;
+            }
+        }
+        t->nops++;
+
+        if (op == OP_UPDATE || op == OP_INSERT || op == OP_RMW) {
+            nwrites++;
+            if (config->batch && nwrites % config->batch == 0 &&
+                s == FDB_RESULT_SUCCESS) {
+                s = _do_commit(t, dbfile);
+            }
+        }
+    }
+    if (s == FDB_RESULT_SUCCESS && nwrites % ((config->batch)?
+                                              (config->batch):(1))) {
+        s = _do_commit(t, dbfile);
+    }
+    t->error = s;
+
+    fdb_kvs_close(db);
+    fdb_close(dbfile);
+    return NULL;
+}
+
+static void * _compactor(void *voidargs)
+{
+    struct bench_thread *t = (struct bench_thread *)voidargs;
+    struct bench_shared *shared = t->shared;
+    struct bench_config *config = shared->config;
+    fdb_file_handle *dbfile;
+    fdb_status s;
+    uint64_t begin, last;
+
+    s = fdb_open(&dbfile, config->filename, &config->fconfig);
+    if (s != FDB_RESULT_SUCCESS) {
+        t->error = s;
+        return NULL;
+    }
+
+    last = get_monotonic_ts();
+    while (!shared->stop) {
+        if ((get_monotonic_ts() - last) / 1e9 < config->compact_interval) {
+            sleep(1);
+            continue;
+        }
+        begin = get_monotonic_ts();
+        // in-place compaction
+        s = fdb_compact(dbfile, NULL);
+        last = get_monotonic_ts();
+        if (s == FDB_RESULT_SUCCESS) {
+            _hist_add(&t->hists[OP_COMPACT], last - begin);
+            t->nops++;
+        }
+    }
+    // other handles may not have been switched to the compacted file
+    fdb_get_io_stats(dbfile, &t->io);
+    fdb_close(dbfile);
+    return NULL;
+}
+
+static int _set_mix(const char *workload, struct bench_mix *mix,
+                    struct bench_config *config)
+{
+    memset(mix, 0, sizeof(struct bench_mix));
+    if (!strcmp(workload, "load")) {
+        mix->load = true;
+    } else if (!strcmp(workload, "load-random")) {
+        mix->load = mix->random_load = true;
+    } else if (!strcmp(workload, "ycsb-a") || !strcmp(workload, "compact")) {
+        mix->ratio[OP_READ] = 50;
+        mix->ratio[OP_UPDATE] = 50;
+        mix->compaction = !strcmp(workload, "compact");
+    } else if (!strcmp(workload, "ycsb-b")) {
+        mix->ratio[OP_READ] = 95;
+        mix->ratio[OP_UPDATE] = 5;
+    } else if (!strcmp(workload, "ycsb-c") || !strcmp(workload, "get")) {
+        mix->ratio[OP_READ] = 100;
+    } else if (!strcmp(workload, "ycsb-d")) {
+        mix->ratio[OP_READ] = 95;
+        mix->ratio[OP_INSERT] = 5;
+        config->key_dist = DIST_LATEST;
+    } else if (!strcmp(workload, "ycsb-e")) {
+        mix->ratio[OP_SCAN] = 95;
+        mix->ratio[OP_INSERT] = 5;
+    } else if (!strcmp(workload, "ycsb-f")) {
+        mix->ratio[OP_READ] = 50;
+        mix->ratio[OP_RMW] = 50;
+    } else if (!strcmp(workload, "scan")) {
+        mix->ratio[OP_SCAN] = 100;
+    } else if (!strcmp(workload, "commit")) {
+        mix->ratio[OP_UPDATE] = 100;
+        config->batch = 1;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+static int _parse_dist(const char *str, bench_dist_t *dist)
+{
+    if (!strcmp(str, "fixed")) {
+        *dist = DIST_FIXED;
+    } else if (!strcmp(str, "uniform")) {
+        *dist = DIST_UNIFORM;
+    } else if (!strcmp(str, "zipfian")) {
+        *dist = DIST_ZIPFIAN;
+    } else if (!strcmp(str, "latest")) {
+        *dist = DIST_LATEST;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+static void _print_usage(const char *name)
+{
+    fprintf(stderr,
+        "usage: %s [--option=value ...]\n"
+        "  --workload=NAME          load, load-random, ycsb-[a-f], get, scan,\n"
+        "                           commit, compact (default: ycsb-a)\n"
+        "  --file=PATH              database file (default: ./fdb_bench.fdb)\n"
+        "  --keep                   do not remove the file after the run\n"
+        "  --threads=N              number of worker threads (default: 4)\n"
+        "  --keys=N                 number of keys loaded (default: 100000)\n"
+        "  --duration=SEC           run time of each thread (default: 10)\n"
+        "  --ops=N                  operations per thread, instead of duration\n"
+        "  --key-size=N             key length (default: 16)\n"
+        "  --value-size=MIN[:MAX]   value length (default: 100)\n"
+        "  --key-dist=DIST          uniform, zipfian, latest (default: uniform)\n"
+        "  --value-dist=DIST        fixed, uniform, zipfian (default: fixed,\n"
+        "                           uniform if MAX is given)\n"
+        "  --zipf-theta=T           skew of zipfian distributions (default: 0.99)\n"
+        "  --scan-length=N          maximum keys per scan (default: 100)\n"
+        "  --batch=N                writes per commit (default: 100)\n"
+        "  --compact-interval=SEC   interval between compactions (default: 1)\n"
+        "  --wal-threshold=N        WAL size (default: library default)\n"
+        "  --cache-mb=N             buffer cache size in MB\n"
+        "  --blocksize=N            block size in bytes\n"
+        "  --durability=MODE        sync, async, odirect (default: sync)\n"
+        "  --seqtree=0|1            use the sequence index (default: 1)\n"
+        "  --bloom-bits=N           Bloom filter bits per key (default: 0)\n",
+        name);
+}
+
+static int _parse_args(int argc, char **argv, struct bench_config *config)
+{
+    int i;
+    char *arg, *value;
+    bool value_dist_set = false;
+
+    for (i=1; i<argc; ++i) {
+        arg = argv[i];
+        if (strncmp(arg, "--", 2)) {
+            return -1;
+        }
+        arg += 2;
+        value = strchr(arg, '=');
+        if (value) {
+            *value++ = 0;
+        }
+        if (!strcmp(arg, "keep")) {
+            config->keep_file = true;
+            continue;
+        }
+        if (!value) {
+            return -1;
+        }
+
+        if (!strcmp(arg, "workload")) {
+            config->workload = value;
+        } else if (!strcmp(arg, "file")) {
+            config->filename = value;
+        } else if (!strcmp(arg, "threads")) {
+            config->nthreads = strtoul(value, NULL, 10);
+        } else if (!strcmp(arg, "keys")) {
+            config->nkeys = strtoull(value, NULL, 10);
+        } else if (!strcmp(arg, "duration")) {
+            config->duration = atof(value);
+        } else if (!strcmp(arg, "ops")) {
+            config->nops = strtoull(value, NULL, 10);
+        } else if (!strcmp(arg, "key-size")) {
+            config->keysize = strtoul(value, NULL, 10);
+        } else if (!strcmp(arg, "value-size")) {
+            config->value_min = config->value_max = strtoul(value, &value, 10);
+            if (*value == ':') {
+                config->value_max = strtoul(value + 1, NULL, 10);
+                if (!value_dist_set) {
+                    config->value_dist = DIST_UNIFORM;
+                }
+            }
+        } else if (!strcmp(arg, "key-dist")) {
+            if (_parse_dist(value, &config->key_dist) < 0 ||
+                config->key_dist == DIST_FIXED) {
+                return -1;
+            }
+        } else if (!strcmp(arg, "value-dist")) {
+            if (_parse_dist(value, &config->value_dist) < 0 ||
+                config->value_dist == DIST_LATEST) {
+                return -1;
+            }
+            value_dist_set = true;
+        } else if (!strcmp(arg, "zipf-theta")) {
+            config->zipf_theta = atof(value);
+        } else if (!strcmp(arg, "scan-length")) {
+            config->scan_length = strtoul(value, NULL, 10);
+        } else if (!strcmp(arg, "batch")) {
+            config->batch = strtoul(value, NULL, 10);
+        } else if (!strcmp(arg, "compact-interval")) {
+            config->compact_interval = atof(value);
+        } else if (!strcmp(arg, "wal-threshold")) {
+            config->fconfig.wal_threshold = strtoull(value, NULL, 10);
+        } else if (!strcmp(arg, "cache-mb")) {
+            config->fconfig.buffercache_size =
+                strtoull(value, NULL, 10) * 1024 * 1024;
+        } else if (!strcmp(arg, "blocksize")) {
+            config->fconfig.blocksize = strtoul(value, NULL, 10);
+        } else if (!strcmp(arg, "durability")) {
+            if (!strcmp(value, "sync")) {
+                config->fconfig.durability_opt = FDB_DRB_NONE;
+            } else if (!strcmp(value, "async")) {
+                config->fconfig.durability_opt = FDB_DRB_ASYNC;
+            } else if (!strcmp(value, "odirect")) {
+                config->fconfig.durability_opt = FDB_DRB_ODIRECT;
+            } else {
+                return -1;
+            }
+        } else if (!strcmp(arg, "seqtree")) {
+            config->fconfig.seqtree_opt = (atoi(value))?
+                                          (FDB_SEQTREE_USE):
+                                          (FDB_SEQTREE_NOT_USE);
+        } else if (!strcmp(arg, "bloom-bits")) {
+            config->fconfig.bloom_filter_bits_per_key = atoi(value);
+        } else {
+            return -1;
+        }
+    }
+
+    if (config->nthreads == 0 || config->keysize == 0 ||
+        config->keysize >= BENCH_MAX_KEYSIZE ||
+        config->value_max < config->value_min || config->scan_length == 0 ||
+        config->zipf_theta <= 0 || config->zipf_theta >= 1 ||
+        (config->nops == 0 && config->duration <= 0)) {
+        return -1;
+    }
+    return 0;
+}
+
+static void _print_hist(const char *name, struct bench_hist *hist,
+                        double elapsed, bool last)
+{
+    printf("    \"%s\": {\"count\": %llu, \"ops_per_sec\": %.1f, "
+           "\"avg_us\": %.2f, \"p50_us\": %.2f, \"p95_us\": %.2f, "
+           "\"p99_us\": %.2f, \"p999_us\": %.2f, \"max_us\": %.2f}%s\n",
+           name, (unsigned long long)hist->count, hist->count / elapsed,
+           (hist->count)?(hist->sum / 1000.0 / hist->count):(0),
+           _hist_percentile(hist, 0.5) / 1000.0,
+           _hist_percentile(hist, 0.95) / 1000.0,
+           _hist_percentile(hist, 0.99) / 1000.0,
+           _hist_percentile(hist, 0.999) / 1000.0,
+           hist->max / 1000.0, (last)?(""):(","));
+}
+
+static fdb_status _preload(struct bench_config *config,
+                           struct bench_shared *shared)
+{
+    // load keys by a single thread before the measured run
+    struct bench_mix mix, *saved_mix = shared->mix;
+    struct bench_thread *t;
+
+    memset(&mix, 0, sizeof(mix));
+    mix.load = mix.random_load = true;
+    shared->mix = &mix;
+    t = (struct bench_thread *)calloc(1, sizeof(struct bench_thread));
+    t->shared = shared;
+    t->rand_state = 0x9e3779b97f4a7c15ULL;
+    _worker(t);
+    shared->mix = saved_mix;
+    shared->nkeys_inserted = config->nkeys;
+    fdb_status s = t->error;
+    free(t);
+    return s;
+}
+
+int main(int argc, char **argv)
+{
+    size_t i;
+    int j;
+    struct bench_config config;
+    struct bench_mix mix;
+    struct bench_shared shared;
+    struct bench_thread *threads, compactor;
+    struct bench_hist total[NUM_OPS];
+    thread_t *tids, compactor_tid;
+    uint64_t begin, user_bytes = 0, nops = 0, nnot_found = 0;
+    double elapsed;
+    fdb_status s;
+    fdb_file_handle *dbfile;
+    fdb_file_info info;
+    fdb_io_stats io;
+    fdb_lock_stats locks;
+    int lockprof;
+    char cmd[1024];
+    void *ret;
+
+    memset(&config, 0, sizeof(config));
+    config.workload = "ycsb-a";
+    config.filename = "./fdb_bench.fdb";
+    config.nthreads = 4;
+    config.nkeys = 100000;
+    config.duration = 10;
+    config.keysize = 16;
+    config.value_min = config.value_max = 100;
+    config.key_dist = DIST_UNIFORM;
+    config.value_dist = DIST_FIXED;
+    config.zipf_theta = 0.99;
+    config.scan_length = 100;
+    config.batch = 100;
+    config.compact_interval = 1;
+    config.fconfig = fdb_get_default_config();
+    config.fconfig.compaction_threshold = 0;
+
+    if (_parse_args(argc, argv, &config) < 0 ||
+        _set_mix(config.workload, &mix, &config) < 0) {
+        _print_usage(argv[0]);
+        return 1;
+    }
+
+    sprintf(cmd, SHELL_DEL" %s* > errorlog.txt", config.filename);
+    j = system(cmd);
+    (void)j;
+
+    memset(&shared, 0, sizeof(shared));
+    shared.config = &config;
+    shared.mix = &mix;
+    spin_init(&shared.lock);
+    _zipf_init(&shared.key_zipf, config.nkeys, config.zipf_theta);
+    _zipf_init(&shared.value_zipf, config.value_max - config.value_min + 1,
+               config.zipf_theta);
+    shared.value_buf = (uint8_t *)malloc(config.value_max * 2 + 1);
+    for (i=0; i<config.value_max * 2 + 1; ++i) {
+        shared.value_buf[i] = 'a' + i % 26;
+    }
+
+    if (!mix.load) {
+        s = _preload(&config, &shared);
+        if (s != FDB_RESULT_SUCCESS) {
+            fprintf(stderr, "preload failed: %s\n", fdb_error_msg(s));
+            return 1;
+        }
+    }
+
+    threads = (struct bench_thread *)
+              calloc(config.nthreads, sizeof(struct bench_thread));
+    tids = (thread_t *)malloc(sizeof(thread_t) * config.nthreads);
+    memset(&compactor, 0, sizeof(compactor));
+    compactor.shared = &shared;
+
+    // keep a handle open during the run, so that the I/O stats of the file
+    // are not discarded when all workers close their handles
+    s = fdb_open(&dbfile, config.filename, &config.fconfig);
+    if (s != FDB_RESULT_SUCCESS) {
+        fprintf(stderr, "open failed: %s\n", fdb_error_msg(s));
+        return 1;
+    }
+    fdb_reset_io_stats(dbfile);
+    // fails if lock profiling is not compiled in
+    lockprof = (fdb_reset_lock_stats() == FDB_RESULT_SUCCESS);
+
+    begin = get_monotonic_ts();
+    for (i=0; i<config.nthreads; ++i) {
+        threads[i].tid = i;
+        threads[i].shared = &shared;
+        threads[i].rand_state = _fnv64(i + 1);
+        thread_create(&tids[i], _worker, &threads[i]);
+    }
+    if (mix.compaction) {
+        thread_create(&compactor_tid, _compactor, &compactor);
+    }
+    for (i=0; i<config.nthreads; ++i) {
+        thread_join(tids[i], &ret);
+    }
+    elapsed = (get_monotonic_ts() - begin) / 1e9;
+    if (mix.compaction) {
+        shared.stop = 1;
+        thread_join(compactor_tid, &ret);
+    }
+    fdb_get_io_stats(dbfile, &io);
+    if (lockprof) {
+        fdb_get_lock_stats(&locks);
+    }
+    if (mix.compaction) {
+        io = compactor.io;
+    }
+    fdb_get_file_info(dbfile, &info);
+    fdb_close(dbfile);
+
+    // merge per-thread results
+    memset(total, 0, sizeof(total));
+    for (i=0; i<config.nthreads; ++i) {
+        if (threads[i].error != FDB_RESULT_SUCCESS) {
+            fprintf(stderr, "thread %d failed: %s\n", (int)i,
+                    fdb_error_msg(threads[i].error));
+        }
+        for (j=0; j<NUM_OPS; ++j) {
+            _hist_merge(&total[j], &threads[i].hists[j]);
+        }
+        nops += threads[i].nops;
+        nnot_found += threads[i].nnot_found;
+        user_bytes += threads[i].user_bytes;
+    }
+    _hist_merge(&total[OP_COMPACT], &compactor.hists[OP_COMPACT]);
+
+    printf("{\n");
+    printf("  \"workload\": \"%s\",\n", config.workload);
+    printf("  \"threads\": %d,\n", (int)config.nthreads);
+    printf("  \"keys\": %llu,\n", (unsigned long long)config.nkeys);
+    printf("  \"key_size\": %d,\n", (int)config.keysize);
+    printf("  \"value_size\": [%d, %d],\n",
+           (int)config.value_min, (int)config.value_max);
+    printf("  \"elapsed_sec\": %.3f,\n", elapsed);
+    printf("  \"ops\": %llu,\n", (unsigned long long)nops);
+    printf("  \"throughput_ops_per_sec\": %.1f,\n", nops / elapsed);
+    printf("  \"not_found\": %llu,\n", (unsigned long long)nnot_found);
+    printf("  \"operations\": {\n");
+    // find the last non-empty entry to place commas
+    for (j=NUM_OPS-1; j>=0; --j) {
+        if (total[j].count) {
+            break;
+        }
+    }
+    for (i=0; (int)i<=j; ++i) {
+        if (total[i].count) {
+            _print_hist(op_names[i], &total[i], elapsed, (int)i == j);
+        }
+    }
+    printf("  },\n");
+    printf("  \"user_bytes_written\": %llu,\n",
+           (unsigned long long)user_bytes);
+    printf("  \"bytes_written\": %llu,\n", (unsigned long long)io.write_bytes);
+    printf("  \"write_amplification\": %.2f,\n",
+           (user_bytes)?((double)io.write_bytes / user_bytes):(0));
+    printf("  \"io\": {\"reads\": %llu, \"read_bytes\": %llu, "
+           "\"writes\": %llu, \"syncs\": %llu, \"doc_bytes\": %llu, "
+           "\"kv_header_bytes\": %llu, \"index_bytes\": %llu, "
+           "\"header_bytes\": %llu, \"compaction_bytes\": %llu},\n",
+           (unsigned long long)io.num_reads,
+           (unsigned long long)io.read_bytes,
+           (unsigned long long)io.num_writes,
+           (unsigned long long)io.num_syncs,
+           (unsigned long long)io.doc_bytes,
+           (unsigned long long)io.kv_header_bytes,
+           (unsigned long long)io.index_bytes,
+           (unsigned long long)io.header_bytes,
+           (unsigned long long)io.compaction_bytes);
+    if (lockprof) {
+        printf("  \"locks\": {\n");
+        for (i=0; i<FDB_LOCK_NUM_SITES; ++i) {
+            printf("    \"%s\": {\"acquisitions\": %llu, \"contended\": %llu, "
+                   "\"wait_ms\": %.3f}%s\n",
+                   fdb_lock_site_name((fdb_lock_site)i),
+                   (unsigned long long)locks.sites[i].acquisitions,
+                   (unsigned long long)locks.sites[i].contended,
+                   locks.sites[i].wait_time / 1e6,
+                   (i + 1 < FDB_LOCK_NUM_SITES)?(","):(""));
+        }
+        printf("  },\n");
+    }
+    printf("  \"file_size\": %llu,\n", (unsigned long long)info.file_size);
+    printf("  \"doc_count\": %llu\n", (unsigned long long)info.doc_count);
+    printf("}\n");
+
+    fdb_shutdown();
+    if (!config.keep_file) {
+        sprintf(cmd, SHELL_DEL" %s* > errorlog.txt", config.filename);
+        j = system(cmd);
+        (void)j;
+    }
+
+    free(shared.value_buf);
+    free(threads);
+    free(tids);
+    return 0;
+}
@@ -380,7 +380,7 @@ void error_to_str_test()
     int i;
     const char *err_msg;
 
-    for (i = FDB_RESULT_SUCCESS; i >= FDB_RESULT_IN_USE_BY_COMPACTOR; --i) {
+    for (i = FDB_RESULT_SUCCESS; i >= FDB_RESULT_TOO_SMALL_BUFFER; --i) {
         err_msg = fdb_error_msg((fdb_status)i);
         // Verify that all error codes have corresponding error messages
         TEST_CHK(strcmp(err_msg, "unknown error"));
@@ -2709,23 +2709,21 @@ void iterator_seek_test()
     TEST_RESULT("iterator seek test");
 }
 
-void sequence_iterator_test()
+void iterator_prefetch_test()
 {
     TEST_INIT();
 
     memleak_start();
 
     int i, r;
-    int n = 10;
-    int count;
+    int n = 1000;
     fdb_file_handle *dbfile;
     fdb_kvs_handle *db;
-    fdb_doc **doc = alca(fdb_doc*, n);
-    fdb_doc *rdoc;
+    fdb_doc *doc, *rdoc;
     fdb_status status;
     fdb_iterator *iterator;
 
-    char keybuf[256], metabuf[256], bodybuf[256];
+    char keybuf[256], bodybuf[256];
 
     // remove previous dummy files
     r = system(SHELL_DEL" dummy* > errorlog.txt");
@@ -2733,7 +2731,7 @@ void sequence_iterator_test()
 
     fdb_config fconfig = fdb_get_default_config();
     fdb_kvs_config kvs_config = fdb_get_default_kvs_config();
-    fconfig.buffercache_size = 0;
+    fconfig.buffercache_size = 16*1024*1024;
     fconfig.wal_threshold = 1024;
     fconfig.flags = FDB_OPEN_FLAG_CREATE;
     fconfig.compaction_threshold = 0;
@@ -2741,218 +2739,140 @@ void sequence_iterator_test()
     // open db
     fdb_open(&dbfile, "./dummy1", &fconfig);
     fdb_kvs_open_default(dbfile, &db, &kvs_config);
-    status = fdb_set_log_callback(db, logCallbackFunc,
-                                  (void *) "sequence_iterator_test");
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-    // insert documents of even number
-    for (i=0;i<n;i+=2){
-        sprintf(keybuf, "key%d", i);
-        sprintf(metabuf, "meta%d", i);
-        sprintf(bodybuf, "body%d", i);
-        fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
-            (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
-        fdb_set(db, doc[i]);
+    // insert documents in reverse key order,
+    // so that the key order is opposite to the file offset order
+    for (i=n-1;i>=0;--i){
+        sprintf(keybuf, "key%04d", i);
+        sprintf(bodybuf, "body%04d", i);
+        fdb_doc_create(&doc, (void*)keybuf, strlen(keybuf),
+            NULL, 0, (void*)bodybuf, strlen(bodybuf));
+        fdb_set(db, doc);
+        fdb_doc_free(doc);
     }
-    // manually flush WAL & commit
     fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
 
-    // insert documents of odd number
-    for (i=1;i<n;i+=2){
-        sprintf(keybuf, "key%d", i);
-        sprintf(metabuf, "meta%d", i);
-        sprintf(bodybuf, "body%d", i);
-        fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
-            (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
-        fdb_set(db, doc[i]);
+    // update some documents in WAL
+    for (i=0;i<n;i+=100){
+        sprintf(keybuf, "key%04d", i);
+        sprintf(bodybuf, "BODY%04d", i);
+        fdb_doc_create(&doc, (void*)keybuf, strlen(keybuf),
+            NULL, 0, (void*)bodybuf, strlen(bodybuf));
+        fdb_set(db, doc);
+        fdb_doc_free(doc);
     }
-    // commit without WAL flush
     fdb_commit(dbfile, FDB_COMMIT_NORMAL);
 
-    // now even number docs are in hb-trie & odd number docs are in WAL
-
-    // create an iterator over sequence number range over FULL RANGE
-    fdb_iterator_sequence_init(db, &iterator, 0, 0, FDB_ITR_NONE);
-
-    // repeat until fail
-    i=0;
-    count = 0;
-    while(1){
-        status = fdb_iterator_next(iterator, &rdoc);
-        if (status == FDB_RESULT_ITERATOR_FAIL) break;
-
-        TEST_CHK(!memcmp(rdoc->key, doc[i]->key, rdoc->keylen));
-        TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
-        TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
-
-        fdb_doc_free(rdoc);
-        i = (i + 2 >= n) ? 1: i + 2; // by-seq, first come even docs, then odd
-        count++;
-    };
-    TEST_CHK(count==n);
-    fdb_iterator_close(iterator);
-
-    // create an iterator over sequence number with META ONLY
-    fdb_iterator_sequence_init(db, &iterator, 0, 0, FDB_ITR_METAONLY);
-
-    // repeat until fail
-    i=0;
-    count = 0;
-    while(1){
-        status = fdb_iterator_next_metaonly(iterator, &rdoc);
-        if (status == FDB_RESULT_ITERATOR_FAIL) break;
-
-        TEST_CHK(!memcmp(rdoc->key, doc[i]->key, rdoc->keylen));
-        TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
-        TEST_CHK(rdoc->body == NULL);
-
+    // full range scan with readahead
+    status = fdb_iterator_init(db, &iterator, NULL, 0, NULL, 0,
+                               FDB_ITR_NONE | FDB_ITR_PREFETCH_WINDOW(64));
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    i = 0;
+    while (fdb_iterator_next(iterator, &rdoc) == FDB_RESULT_SUCCESS) {
+        sprintf(keybuf, "key%04d", i);
+        sprintf(bodybuf, (i % 100)?("body%04d"):("BODY%04d"), i);
+        TEST_CHK(!memcmp(rdoc->key, keybuf, rdoc->keylen));
+        TEST_CHK(!memcmp(rdoc->body, bodybuf, rdoc->bodylen));
         fdb_doc_free(rdoc);
-        i = (i + 2 >= n) ? 1: i + 2; // by-seq, first come even docs, then odd
-        count++;
-    };
-    TEST_CHK(count==n);
+        i++;
+    }
+    TEST_CHK(i == n);
     fdb_iterator_close(iterator);
 
-    // create another iterator starts from seq number 2 and ends at 9
-    fdb_iterator_sequence_init(db, &iterator, 2, 7, FDB_ITR_NONE);
-
-    // repeat until fail
-    i=2;
-    count = 0;
-    while(1){
-        status = fdb_iterator_next(iterator, &rdoc);
-        if (status == FDB_RESULT_ITERATOR_FAIL) break;
-
-        TEST_CHK(!memcmp(rdoc->key, doc[i]->key, rdoc->keylen));
-        TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
-        TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
-
-        fdb_doc_free(rdoc);
-        i = (i + 2 >= n) ? 1: i + 2; // by-seq, first come even docs, then odd
-        count++;
-    };
-    TEST_CHK(count==6);
-    fdb_iterator_close(iterator);
-    // remove document #8 and #9
-    fdb_doc_create(&rdoc, doc[8]->key, doc[8]->keylen, doc[8]->meta, doc[8]->metalen, NULL, 0);
-    status = fdb_del(db, rdoc);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
-    fdb_doc_free(rdoc);
-    fdb_doc_create(&rdoc, doc[9]->key, doc[9]->keylen, doc[9]->meta, doc[9]->metalen, NULL, 0);
-    status = fdb_del(db, rdoc);
+    // ranged scan with readahead, and seek in the middle
+    status = fdb_iterator_init(db, &iterator, "key0100", 7, "key0599", 7,
+                               FDB_ITR_NONE | FDB_ITR_PREFETCH_WINDOW(16));
     TEST_CHK(status == FDB_RESULT_SUCCESS);
-    fdb_doc_free(rdoc);
-    // commit
-    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
-
-    // create an iterator for full range
-    fdb_iterator_sequence_init(db, &iterator, 0, 0, FDB_ITR_NONE);
-    // repeat until fail
-    i=0;
-    count=0;
-    while(1){
-        status = fdb_iterator_next(iterator, &rdoc);
-        if (status == FDB_RESULT_ITERATOR_FAIL) break;
-
-        if (count != 8 && count != 9) { // do not look validate key8 and key9
-            TEST_CHK(!memcmp(rdoc->key, doc[i]->key, rdoc->keylen));
-            TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
-            TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
-        } else {
-            TEST_CHK(rdoc->deleted == true);
-        }
-
+    i = 100;
+    while (fdb_iterator_next(iterator, &rdoc) == FDB_RESULT_SUCCESS) {
+        sprintf(keybuf, "key%04d", i);
+        TEST_CHK(!memcmp(rdoc->key, keybuf, rdoc->keylen));
         fdb_doc_free(rdoc);
-        // Turn around when we hit 8 as the last items, key8 and key9 are gone
-        i = (i + 2 >= 8) ? 1: i + 2; // by-seq, first come even docs, then odd
-        count++;
-    };
-    TEST_CHK(count==10); // 10 items, with 2 deletions
-    fdb_iterator_close(iterator);
-
-    // create an iterator for full range, but no deletes.
-    fdb_iterator_sequence_init(db, &iterator, 0, 0, FDB_ITR_NO_DELETES);
-    // repeat until fail
-    i=0;
-    count=0;
-    while(1){
-        status = fdb_iterator_next(iterator, &rdoc);
-        if (status == FDB_RESULT_ITERATOR_FAIL) break;
-
-        if (i != 8 && i != 9) { // key8 and key9 are deleted
-            TEST_CHK(!memcmp(rdoc->key, doc[i]->key, rdoc->keylen));
-            TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
-            TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
+        if (++i == 150) {
+            status = fdb_iterator_seek(iterator, "key0400", 7);
+            TEST_CHK(status == FDB_RESULT_SUCCESS);
+            i = 400;
         }
-
-        fdb_doc_free(rdoc);
-        i = (i + 2 >= 8) ? 1: i + 2; // by-seq, first come even docs, then odd
-        count++;
-    };
-    TEST_CHK(count==8); // 10 items, with 2 deletions
+    }
+    TEST_CHK(i == 600);
     fdb_iterator_close(iterator);
 
-    // Update first document and test for absence of duplicates
-    *((char *)doc[0]->body) = 'K'; // update key0 to Key0
-    fdb_set(db, doc[0]);
-    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+    // close db file
+    fdb_kvs_close(db);
+    fdb_close(dbfile);
 
-    fdb_iterator_sequence_init(db, &iterator, 0, 0, FDB_ITR_NO_DELETES);
-    // repeat until fail
-    i=2; // i == 0 should not appear until the end
-    count=0;
-    while(1){
-        status = fdb_iterator_next(iterator, &rdoc);
-        if (status == FDB_RESULT_ITERATOR_FAIL) break;
+    // documents spanning multiple blocks
+    int nlarge = 100;
+    size_t large_bodylen = fconfig.blocksize * 8 + 100;
+    char *large_body = (char *)malloc(large_bodylen);
+    fdb_io_stats io_stats;
 
-        if (i != 8 && i != 9) { // key8 and key9 are deleted
-            TEST_CHK(!memcmp(rdoc->key, doc[i]->key, rdoc->keylen));
-            TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
-            TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
-        }
+    fdb_open(&dbfile, "./dummy2", &fconfig);
+    fdb_kvs_open_default(dbfile, &db, &kvs_config);
+    for (i=nlarge-1;i>=0;--i){
+        sprintf(keybuf, "key%04d", i);
+        memset(large_body, 'a' + (i % 26), large_bodylen);
+        fdb_doc_create(&doc, (void*)keybuf, strlen(keybuf),
+            NULL, 0, (void*)large_body, large_bodylen);
+        fdb_set(db, doc);
+        fdb_doc_free(doc);
+    }
+    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
+    fdb_kvs_close(db);
+    fdb_close(dbfile);
 
+    // reopen the file and scan it
+    fdb_open(&dbfile, "./dummy2", &fconfig);
+    fdb_kvs_open_default(dbfile, &db, &kvs_config);
+    fdb_reset_io_stats(dbfile);
+    status = fdb_iterator_init(db, &iterator, NULL, 0, NULL, 0,
+                               FDB_ITR_NONE | FDB_ITR_PREFETCH_WINDOW(64));
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    i = 0;
+    while (fdb_iterator_next(iterator, &rdoc) == FDB_RESULT_SUCCESS) {
+        sprintf(keybuf, "key%04d", i);
+        memset(large_body, 'a' + (i % 26), large_bodylen);
+        TEST_CHK(!memcmp(rdoc->key, keybuf, rdoc->keylen));
+        TEST_CHK(rdoc->bodylen == large_bodylen);
+        TEST_CHK(!memcmp(rdoc->body, large_body, large_bodylen));
         fdb_doc_free(rdoc);
-        i = (i + 2 >= 8) ? 1: i + 2; // by-seq, first come even docs, then odd
-        if (count == 6) i = 0; // go back to test for i=0 at the end
-        count++;
-    };
-    TEST_CHK(count==8); // 10 items, with 2 deletions
+        i++;
+    }
+    TEST_CHK(i == nlarge);
     fdb_iterator_close(iterator);
 
-    // close db file
+    // the blocks following the first block of each document are read by
+    // batched readahead, not by a separate read for each block
+    fdb_get_io_stats(dbfile, &io_stats);
+    TEST_CHK(io_stats.num_reads < (uint64_t)nlarge * 3);
+
+    free(large_body);
     fdb_kvs_close(db);
     fdb_close(dbfile);
 
-    // free all documents
-    for (i=0;i<n;++i){
-        fdb_doc_free(doc[i]);
-    }
-
     // free all resources
     fdb_shutdown();
 
     memleak_end();
 
-    TEST_RESULT("sequence iterator test");
+    TEST_RESULT("iterator prefetch test");
 }
 
-void sequence_iterator_duplicate_test()
+void iterator_batch_test()
 {
-    // Unit test for MB-12225
     TEST_INIT();
 
     memleak_start();
 
     int i, r;
     int n = 100;
-    int count;
+    size_t j, count, bufsize;
+    void *buf;
     fdb_file_handle *dbfile;
-    fdb_kvs_handle *db;
-    fdb_doc **doc = alca(fdb_doc*, n);
-    fdb_doc *rdoc;
+    fdb_kvs_handle *db, *kv1;
+    fdb_doc *doc, *docs;
     fdb_status status;
     fdb_iterator *iterator;
-    fdb_seqnum_t seqnum;
 
     char keybuf[256], metabuf[256], bodybuf[256];
 
@@ -2964,107 +2884,152 @@ void sequence_iterator_duplicate_test()
     fdb_kvs_config kvs_config = fdb_get_default_kvs_config();
     fconfig.buffercache_size = 0;
     fconfig.wal_threshold = 1024;
+    fconfig.flags = FDB_OPEN_FLAG_CREATE;
     fconfig.compaction_threshold = 0;
 
     // open db
     fdb_open(&dbfile, "./dummy1", &fconfig);
     fdb_kvs_open_default(dbfile, &db, &kvs_config);
-    status = fdb_set_log_callback(db, logCallbackFunc,
-                                  (void *) "sequence_iterator_test");
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    fdb_kvs_open(dbfile, &kv1, "kv1", &kvs_config);
 
-    // insert documents first time
-    for (i=0;i<n;i++){
-        sprintf(keybuf, "key%d", i);
-        sprintf(metabuf, "meta%d", i);
-        sprintf(bodybuf, "body%d(first)", i);
-        fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
+    // insert documents: even keys into the main index, odd keys into WAL
+    for (i=0;i<n;i+=2){
+        sprintf(keybuf, "key%04d", i);
+        sprintf(metabuf, "meta%04d", i);
+        sprintf(bodybuf, "body%04d", i);
+        fdb_doc_create(&doc, (void*)keybuf, strlen(keybuf),
             (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
-        fdb_set(db, doc[i]);
-    }
-    // manually flush WAL & commit
-    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
-
-    // insert documents second time
-    for (i=0;i<n;i++){
-        sprintf(bodybuf, "body%d(second)", i);
-        fdb_doc_update(&doc[i], NULL, 0, bodybuf, strlen(bodybuf));
-        fdb_set(db, doc[i]);
+        fdb_set(db, doc);
+        fdb_set(kv1, doc);
+        fdb_doc_free(doc);
     }
-    // manually flush WAL & commit
     fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
-
-    // insert documents third time (only even number documents)
-    for (i=0;i<n;i+=2){
-        sprintf(bodybuf, "body%d(third)", i);
-        fdb_doc_update(&doc[i], NULL, 0, bodybuf, strlen(bodybuf));
-        fdb_set(db, doc[i]);
+    for (i=1;i<n;i+=2){
+        sprintf(keybuf, "key%04d", i);
+        sprintf(metabuf, "meta%04d", i);
+        sprintf(bodybuf, "body%04d", i);
+        fdb_doc_create(&doc, (void*)keybuf, strlen(keybuf),
+            (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
+        fdb_set(db, doc);
+        fdb_set(kv1, doc);
+        fdb_doc_free(doc);
     }
-    // commit without WAL flushing
     fdb_commit(dbfile, FDB_COMMIT_NORMAL);
 
-    // create an iterator over sequence number
-    fdb_iterator_sequence_init(db, &iterator, 0, 220, FDB_ITR_NONE);
+    // each document takes sizeof(fdb_doc) + 7 + 8 + 8 bytes,
+    // so that 10 documents fit into the buffer and the 11th does not
+    bufsize = (sizeof(fdb_doc) + 23) * 10 + 16;
+    buf = malloc(bufsize);
 
-    // repeat until fail
-    count = 0;
-    while(1){
-        status = fdb_iterator_next(iterator, &rdoc);
-        if (status == FDB_RESULT_ITERATOR_FAIL) break;
-        if (count<50) {
-            // HB+trie
-            i = count*2 + 1;
-            seqnum = 100 + (count+1)*2;
-            sprintf(bodybuf, "body%d(second)", i);
-        } else {
-            // WAL
-            i = (count-50)*2;
-            seqnum = 200 + (count-50+1);
-            sprintf(bodybuf, "body%d(third)", i);
+    // a too small buffer
+    status = fdb_iterator_init(db, &iterator, NULL, 0, NULL, 0, FDB_ITR_NONE);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    status = fdb_iterator_next_batch(iterator, buf, sizeof(fdb_doc), &count);
+    TEST_CHK(status == FDB_RESULT_TOO_SMALL_BUFFER);
+    TEST_CHK(count == 0);
+
+    // the document that did not fit should be returned first
+    i = 0;
+    while ((status = fdb_iterator_next_batch(iterator, buf, bufsize, &count))
+           == FDB_RESULT_SUCCESS) {
+        TEST_CHK(count == 10);
+        docs = (fdb_doc *)buf;
+        for (j=0;j<count;++j){
+            sprintf(keybuf, "key%04d", i);
+            sprintf(metabuf, "meta%04d", i);
+            sprintf(bodybuf, "body%04d", i);
+            TEST_CHK(docs[j].keylen == strlen(keybuf));
+            TEST_CHK(!memcmp(docs[j].key, keybuf, docs[j].keylen));
+            TEST_CHK(!memcmp(docs[j].meta, metabuf, docs[j].metalen));
+            TEST_CHK(!memcmp(docs[j].body, bodybuf, docs[j].bodylen));
+            i++;
         }
+    }
+    TEST_CHK(status == FDB_RESULT_ITERATOR_FAIL);
+    TEST_CHK(count == 0);
+    TEST_CHK(i == n);
+    fdb_iterator_close(iterator);
 
-        TEST_CHK(!memcmp(rdoc->key, doc[i]->key, rdoc->keylen));
-        TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
-        TEST_CHK(!memcmp(rdoc->body, bodybuf, rdoc->bodylen));
-        TEST_CHK(rdoc->seqnum == seqnum);
+    // mix with fdb_iterator_next() on a non-default KV store,
+    // the KV ID prefix should be stripped from the keys
+    status = fdb_iterator_init(kv1, &iterator, "key0005", 7, "key0054", 7,
+                               FDB_ITR_NONE);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    i = 5;
+    while (true) {
+        status = fdb_iterator_next_batch(iterator, buf, bufsize, &count);
+        if (status != FDB_RESULT_SUCCESS) {
+            break;
+        }
+        docs = (fdb_doc *)buf;
+        for (j=0;j<count;++j){
+            sprintf(keybuf, "key%04d", i);
+            TEST_CHK(docs[j].keylen == strlen(keybuf));
+            TEST_CHK(!memcmp(docs[j].key, keybuf, docs[j].keylen));
+            i++;
+        }
+        status = fdb_iterator_next(iterator, &doc);
+        if (status != FDB_RESULT_SUCCESS) {
+            break;
+        }
+        sprintf(keybuf, "key%04d", i);
+        TEST_CHK(!memcmp(doc->key, keybuf, doc->keylen));
+        fdb_doc_free(doc);
+        i++;
+    }
+    TEST_CHK(status == FDB_RESULT_ITERATOR_FAIL);
+    TEST_CHK(i == 55);
+    fdb_iterator_close(iterator);
 
-        count++;
-        fdb_doc_free(rdoc);
-    };
-    TEST_CHK(count==70);
+    // metadata only
+    status = fdb_iterator_init(db, &iterator, NULL, 0, NULL, 0,
+                               FDB_ITR_METAONLY);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    status = fdb_iterator_next_batch(iterator, buf, bufsize, &count);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    // bodies are excluded, so that more documents fit into the buffer
+    TEST_CHK(count == (bufsize & ~(sizeof(void*) - 1)) / (sizeof(fdb_doc) + 15));
+    docs = (fdb_doc *)buf;
+    for (j=0;j<count;++j){
+        sprintf(metabuf, "meta%04d", (int)j);
+        TEST_CHK(!memcmp(docs[j].meta, metabuf, docs[j].metalen));
+        TEST_CHK(docs[j].body == NULL && docs[j].bodylen == 0);
+    }
     fdb_iterator_close(iterator);
 
+    free(buf);
+
     // close db file
+    fdb_kvs_close(kv1);
     fdb_kvs_close(db);
     fdb_close(dbfile);
-    // free all documents
-    for (i=0;i<n;++i){
-        fdb_doc_free(doc[i]);
-    }
+
     // free all resources
     fdb_shutdown();
 
     memleak_end();
 
-    TEST_RESULT("sequence iterator duplicate test");
+    TEST_RESULT("iterator batch test");
 }
 
-void reverse_sequence_iterator_test()
+void iterator_keys_only_test()
 {
     TEST_INIT();
 
     memleak_start();
 
-    int i, r, count;
-    int n = 10;
+    int i, r;
+    int n = 100;
+    size_t j, count;
+    uint8_t buf[4096];
+    uint64_t *offsets = alca(uint64_t, n);
     fdb_file_handle *dbfile;
     fdb_kvs_handle *db;
-    fdb_doc **doc = alca(fdb_doc*, n);
-    fdb_doc *rdoc;
+    fdb_doc *doc, *rdoc, *docs;
     fdb_status status;
     fdb_iterator *iterator;
 
-    char keybuf[256], metabuf[256], bodybuf[256];
+    char keybuf[256], bodybuf[256];
 
     // remove previous dummy files
     r = system(SHELL_DEL" dummy* > errorlog.txt");
@@ -3072,7 +3037,6 @@ void reverse_sequence_iterator_test()
 
     fdb_config fconfig = fdb_get_default_config();
     fdb_kvs_config kvs_config = fdb_get_default_kvs_config();
-    fconfig.buffercache_size = 0;
     fconfig.wal_threshold = 1024;
     fconfig.flags = FDB_OPEN_FLAG_CREATE;
     fconfig.compaction_threshold = 0;
@@ -3080,138 +3044,161 @@ void reverse_sequence_iterator_test()
     // open db
     fdb_open(&dbfile, "./dummy1", &fconfig);
     fdb_kvs_open_default(dbfile, &db, &kvs_config);
-    status = fdb_set_log_callback(db, logCallbackFunc,
-                                  (void *) "reverse_sequence_iterator_test");
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-    // insert documents of even number
-    for (i=0;i<n;i+=2){
-        sprintf(keybuf, "key%d", i);
-        sprintf(metabuf, "meta%d", i);
-        sprintf(bodybuf, "body%d", i);
-        fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
-            (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
-        fdb_set(db, doc[i]);
+    // insert documents into the main index
+    for (i=0;i<n;++i){
+        sprintf(keybuf, "key%04d", i);
+        sprintf(bodybuf, "body%04d", i);
+        fdb_doc_create(&doc, (void*)keybuf, strlen(keybuf),
+            NULL, 0, (void*)bodybuf, strlen(bodybuf));
+        fdb_set(db, doc);
+        fdb_doc_free(doc);
     }
-    // manually flush WAL & commit
     fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
 
-    // insert documents of odd number
-    for (i=1;i<n;i+=2){
-        sprintf(keybuf, "key%d", i);
-        sprintf(metabuf, "meta%d", i);
-        sprintf(bodybuf, "body%d", i);
-        fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
-            (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
-        fdb_set(db, doc[i]);
+    // update every 10th document and delete every 7th document in WAL
+    for (i=0;i<n;i+=10){
+        sprintf(keybuf, "key%04d", i);
+        sprintf(bodybuf, "BODY%04d", i);
+        fdb_doc_create(&doc, (void*)keybuf, strlen(keybuf),
+            NULL, 0, (void*)bodybuf, strlen(bodybuf));
+        fdb_set(db, doc);
+        fdb_doc_free(doc);
+    }
+    for (i=0;i<n;i+=7){
+        sprintf(keybuf, "key%04d", i);
+        fdb_doc_create(&doc, (void*)keybuf, strlen(keybuf),
+            NULL, 0, NULL, 0);
+        fdb_del(db, doc);
+        fdb_doc_free(doc);
     }
-    // commit without WAL flush
     fdb_commit(dbfile, FDB_COMMIT_NORMAL);
 
-    // now even number docs are in hb-trie & odd number docs are in WAL
-
-    // First test reverse sequence iteration as it only involves btrees
-    // create an iterator over sequence number range over FULL RANGE
-    fdb_iterator_sequence_init(db, &iterator, 0, 0, FDB_ITR_NONE);
-
-    // move iterator forward up till middle...
-    i=0;
-    count = 0;
-    while(1){
-        status = fdb_iterator_next(iterator, &rdoc);
-        if (status == FDB_RESULT_ITERATOR_FAIL) break;
-
-        TEST_CHK(!memcmp(rdoc->key, doc[i]->key, rdoc->keylen));
-        TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
-        TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
-
+    // collect offsets through the normal iterator
+    status = fdb_iterator_init(db, &iterator, NULL, 0, NULL, 0,
+                               FDB_ITR_NO_DELETES);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    while (fdb_iterator_next(iterator, &rdoc) == FDB_RESULT_SUCCESS) {
+        memcpy(keybuf, rdoc->key, rdoc->keylen);
+        keybuf[rdoc->keylen] = 0;
+        offsets[atoi(keybuf + 3)] = rdoc->offset;
         fdb_doc_free(rdoc);
-        count++;
-        if (i + 2 >= n) break;
-        i = i + 2; // by-seq, first come even docs, then odd
-    };
-    TEST_CHK(count==n/2);
-
-    // Now test reverse sequence iterator from mid-way..
-
-    i = i - 2;
-    status = fdb_iterator_prev(iterator, &rdoc);
-    TEST_CHK(status != FDB_RESULT_ITERATOR_FAIL);
-
-    TEST_CHK(!memcmp(rdoc->key, doc[i]->key, rdoc->keylen));
-    TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
-    TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
-
-    fdb_doc_free(rdoc);
-    count++;
-
-    i = i + 2;
-    while(1){
-        status = fdb_iterator_next(iterator, &rdoc);
-        if (status == FDB_RESULT_ITERATOR_FAIL) break;
-
-        TEST_CHK(!memcmp(rdoc->key, doc[i]->key, rdoc->keylen));
-        TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
-        TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
+    }
+    fdb_iterator_close(iterator);
 
+    // keys only, including deleted items
+    status = fdb_iterator_init(db, &iterator, NULL, 0, NULL, 0,
+                               FDB_ITR_KEYS_ONLY);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    i = 0;
+    while (fdb_iterator_next(iterator, &rdoc) == FDB_RESULT_SUCCESS) {
+        sprintf(keybuf, "key%04d", i);
+        TEST_CHK(!memcmp(rdoc->key, keybuf, rdoc->keylen));
+        TEST_CHK(rdoc->meta == NULL && rdoc->body == NULL);
+        if (i % 7 == 0) {
+            TEST_CHK(rdoc->deleted);
+        } else {
+            TEST_CHK(!rdoc->deleted);
+            TEST_CHK(rdoc->offset == offsets[i]);
+        }
+        if (i % 7 == 0 || i % 10 == 0) {
+            // items in WAL have sequence numbers
+            TEST_CHK(rdoc->seqnum > (fdb_seqnum_t)n);
+        }
         fdb_doc_free(rdoc);
-        i = (i + 2 >= n) ? 1 : i + 2;// by-seq, first come even docs, then odd
-        count++;
-    };
-
-    TEST_CHK(count==n+2); // two items were double counted due to reverse
-
-    // Reached End, now reverse iterate till start
-    i = n - 1;
-    count = n;
-    while (1) {
-       status = fdb_iterator_prev(iterator, &rdoc);
-        if (status == FDB_RESULT_ITERATOR_FAIL) break;
-
-        TEST_CHK(!memcmp(rdoc->key, doc[i]->key, rdoc->keylen));
-        TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
-        TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
+        i++;
+    }
+    TEST_CHK(i == n);
 
+    // reverse
+    while (fdb_iterator_prev(iterator, &rdoc) == FDB_RESULT_SUCCESS) {
+        i--;
+        sprintf(keybuf, "key%04d", i);
+        TEST_CHK(!memcmp(rdoc->key, keybuf, rdoc->keylen));
         fdb_doc_free(rdoc);
-        i = (i - 2 < 0) ? n - 2 : i - 2;
-        if (count) count--;
     }
-    TEST_CHK(count == 0);
+    TEST_CHK(i == 0);
+    fdb_iterator_close(iterator);
+
+    // keys only without deleted items, in batch
+    status = fdb_iterator_init(db, &iterator, NULL, 0, NULL, 0,
+                               FDB_ITR_KEYS_ONLY | FDB_ITR_NO_DELETES);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    i = 0;
+    while (fdb_iterator_next_batch(iterator, buf, sizeof(buf), &count) ==
+           FDB_RESULT_SUCCESS) {
+        docs = (fdb_doc *)buf;
+        for (j=0;j<count;++j){
+            if (i % 7 == 0) {
+                i++;
+            }
+            sprintf(keybuf, "key%04d", i);
+            TEST_CHK(docs[j].keylen == strlen(keybuf));
+            TEST_CHK(!memcmp(docs[j].key, keybuf, docs[j].keylen));
+            TEST_CHK(docs[j].offset == offsets[i]);
+            TEST_CHK(!docs[j].deleted);
+            i++;
+        }
+    }
+    TEST_CHK(i == n);
     fdb_iterator_close(iterator);
 
+    // not supported by sequence iterators
+    status = fdb_iterator_sequence_init(db, &iterator, 0, 0,
+                                        FDB_ITR_KEYS_ONLY);
+    TEST_CHK(status == FDB_RESULT_INVALID_ARGS);
+
     // close db file
     fdb_kvs_close(db);
     fdb_close(dbfile);
 
-    // free all documents
-    for (i=0;i<n;++i){
-        fdb_doc_free(doc[i]);
-    }
-
     // free all resources
     fdb_shutdown();
 
     memleak_end();
 
-    TEST_RESULT("reverse sequence iterator test");
+    TEST_RESULT("iterator keys only test");
 }
 
-void reverse_iterator_test()
+static int _count_partition(fdb_kvs_handle *db,
+                            void *start_key, size_t start_keylen,
+                            void *end_key, size_t end_keylen,
+                            bool last)
+{
+    int count = 0;
+    fdb_doc *rdoc;
+    fdb_iterator *iterator;
+
+    fdb_iterator_init(db, &iterator, start_key, start_keylen,
+                      end_key, end_keylen, FDB_ITR_NONE);
+    while (fdb_iterator_next(iterator, &rdoc) == FDB_RESULT_SUCCESS) {
+        // the end key belongs to the next partition
+        if (last || rdoc->keylen != end_keylen ||
+            memcmp(rdoc->key, end_key, end_keylen)) {
+            count++;
+        }
+        fdb_doc_free(rdoc);
+    }
+    fdb_iterator_close(iterator);
+    return count;
+}
+
+void iterator_split_test()
 {
     TEST_INIT();
 
     memleak_start();
 
-    int i, r;
-    int n = 10;
+    int i, r, c, total;
+    int n = 10000;
+    size_t j, nparts = 4;
     fdb_file_handle *dbfile;
-    fdb_kvs_handle *db;
-    fdb_doc **doc = alca(fdb_doc*, n);
-    fdb_doc *rdoc;
+    fdb_kvs_handle *db, *kv1, *kvs[2];
+    fdb_doc *doc;
     fdb_status status;
-    fdb_iterator *iterator;
+    fdb_split_key_list split_keys;
 
-    char keybuf[256], metabuf[256], bodybuf[256];
+    char keybuf[256], bodybuf[256];
 
     // remove previous dummy files
     r = system(SHELL_DEL" dummy* > errorlog.txt");
@@ -3219,7 +3206,6 @@ void reverse_iterator_test()
 
     fdb_config fconfig = fdb_get_default_config();
     fdb_kvs_config kvs_config = fdb_get_default_kvs_config();
-    fconfig.buffercache_size = 0;
     fconfig.wal_threshold = 1024;
     fconfig.flags = FDB_OPEN_FLAG_CREATE;
     fconfig.compaction_threshold = 0;
@@ -3227,160 +3213,235 @@ void reverse_iterator_test()
     // open db
     fdb_open(&dbfile, "./dummy1", &fconfig);
     fdb_kvs_open_default(dbfile, &db, &kvs_config);
-    status = fdb_set_log_callback(db, logCallbackFunc,
-                                  (void *) "reverse_iterator_test");
+    fdb_kvs_open(dbfile, &kv1, "kv1", &kvs_config);
+    kvs[0] = db;
+    kvs[1] = kv1;
+
+    // a single partition for an empty KV store
+    status = fdb_iterator_split(db, NULL, 0, NULL, 0, nparts, &split_keys);
     TEST_CHK(status == FDB_RESULT_SUCCESS);
+    TEST_CHK(split_keys.num_keys == 0);
+    fdb_free_split_key_list(&split_keys);
 
-    // insert documents of even number
-    for (i=0;i<n;i+=2){
-        sprintf(keybuf, "key%d", i);
-        sprintf(metabuf, "meta%d", i);
-        sprintf(bodybuf, "body%d", i);
-        fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
-            (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
-        fdb_set(db, doc[i]);
+    for (i=0;i<n;++i){
+        sprintf(keybuf, "key%06d", i);
+        sprintf(bodybuf, "body%06d", i);
+        fdb_doc_create(&doc, (void*)keybuf, strlen(keybuf),
+            NULL, 0, (void*)bodybuf, strlen(bodybuf));
+        fdb_set(db, doc);
+        // only odd keys in the other KV store
+        if (i % 2) {
+            fdb_set(kv1, doc);
+        }
+        fdb_doc_free(doc);
     }
-    // manually flush WAL & commit
     fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
 
-    // insert documents of odd number
-    for (i=1;i<n;i+=2){
-        sprintf(keybuf, "key%d", i);
-        sprintf(metabuf, "meta%d", i);
-        sprintf(bodybuf, "body%d", i);
-        fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
-            (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
-        fdb_set(db, doc[i]);
+    for (c=0;c<2;++c){
+        // whole KV store
+        status = fdb_iterator_split(kvs[c], NULL, 0, NULL, 0, nparts,
+                                    &split_keys);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        TEST_CHK(split_keys.num_keys == nparts-1);
+
+        total = 0;
+        for (j=0;j<=split_keys.num_keys;++j){
+            r = _count_partition(kvs[c],
+                    (j)?(split_keys.keys[j-1]):(NULL),
+                    (j)?(split_keys.keylens[j-1]):(0),
+                    (j<split_keys.num_keys)?(split_keys.keys[j]):(NULL),
+                    (j<split_keys.num_keys)?(split_keys.keylens[j]):(0),
+                    (j == split_keys.num_keys));
+            // roughly balanced
+            TEST_CHK(r > (n >> c) / (int)nparts / 2);
+            TEST_CHK(r < (n >> c) / (int)nparts * 2);
+            total += r;
+        }
+        TEST_CHK(total == (n >> c));
+        fdb_free_split_key_list(&split_keys);
     }
-    // commit without WAL flush
-    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
 
-    // now even number docs are in hb-trie & odd number docs are in WAL
+    // sub range
+    status = fdb_iterator_split(db, "key001000", 9, "key002999", 9, nparts,
+                                &split_keys);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    TEST_CHK(split_keys.num_keys > 0 && split_keys.num_keys < nparts);
+    total = 0;
+    for (j=0;j<=split_keys.num_keys;++j){
+        if (j) {
+            // split keys should be within the range in ascending order
+            TEST_CHK(memcmp(split_keys.keys[j-1], "key001000", 9) > 0);
+            TEST_CHK(memcmp(split_keys.keys[j-1], "key002999", 9) < 0);
+        }
+        if (j > 1) {
+            TEST_CHK(memcmp(split_keys.keys[j-2], split_keys.keys[j-1], 9) < 0);
+        }
+        total += _count_partition(db,
+                    (j)?(split_keys.keys[j-1]):((void*)"key001000"),
+                    (j)?(split_keys.keylens[j-1]):(9),
+                    (j<split_keys.num_keys)?
+                        (split_keys.keys[j]):((void*)"key002999"),
+                    (j<split_keys.num_keys)?(split_keys.keylens[j]):(9),
+                    (j == split_keys.num_keys));
+    }
+    TEST_CHK(total == 2000);
+    fdb_free_split_key_list(&split_keys);
+
+    // narrow range in the middle of a large sub-trie; samples should be
+    // drawn from the range only, so that the partitions are still balanced
+    status = fdb_iterator_split(db, "key001000", 9, "key001199", 9, nparts,
+                                &split_keys);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    TEST_CHK(split_keys.num_keys == nparts-1);
+    total = 0;
+    for (j=0;j<=split_keys.num_keys;++j){
+        if (j) {
+            TEST_CHK(memcmp(split_keys.keys[j-1], "key001000", 9) > 0);
+            TEST_CHK(memcmp(split_keys.keys[j-1], "key001199", 9) < 0);
+        }
+        r = _count_partition(db,
+                (j)?(split_keys.keys[j-1]):((void*)"key001000"),
+                (j)?(split_keys.keylens[j-1]):(9),
+                (j<split_keys.num_keys)?
+                    (split_keys.keys[j]):((void*)"key001199"),
+                (j<split_keys.num_keys)?(split_keys.keylens[j]):(9),
+                (j == split_keys.num_keys));
+        TEST_CHK(r > 200 / (int)nparts / 2);
+        TEST_CHK(r < 200 / (int)nparts * 2);
+        total += r;
+    }
+    TEST_CHK(total == 200);
+    fdb_free_split_key_list(&split_keys);
 
-    // Reverse iteration over key range which involves hb-tries
-    // create an iterator for full range
-    fdb_iterator_init(db, &iterator, NULL, 0, NULL, 0, FDB_ITR_NONE);
+    // close db file
+    fdb_kvs_close(kv1);
+    fdb_kvs_close(db);
+    fdb_close(dbfile);
 
-    // first test forward iterator - repeat until fail
-    i=0;
-    while(1){
-        status = fdb_iterator_next(iterator, &rdoc);
-        if (status == FDB_RESULT_ITERATOR_FAIL) break;
-
-        TEST_CHK(!memcmp(rdoc->key, doc[i]->key, rdoc->keylen));
-        TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
-        TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
-
-        fdb_doc_free(rdoc);
-        i++;
-    };
-    TEST_CHK(i==10);
-
-    // Now test reverse iterator..
-    i--;
-    while (1) {
-        status = fdb_iterator_prev(iterator, &rdoc);
-
-        if (status == FDB_RESULT_ITERATOR_FAIL) break;
-
-        TEST_CHK(!memcmp(rdoc->key, doc[i]->key, rdoc->keylen));
-        TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
-        TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
+    // free all resources
+    fdb_shutdown();
 
-        fdb_doc_free(rdoc);
-        if (i == 5) break; // Change direction at half point
-        i--;
-    }
-    TEST_CHK(i == 5);
+    memleak_end();
 
-    // Mid-way reverse direction, again test forward iterator...
-    i++;
-    status = fdb_iterator_next(iterator, &rdoc);
-    TEST_CHK(status != FDB_RESULT_ITERATOR_FAIL);
+    TEST_RESULT("iterator split test");
+}
 
-    TEST_CHK(!memcmp(rdoc->key, doc[i]->key, rdoc->keylen));
-    TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
-    TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
+void estimate_range_test()
+{
+    TEST_INIT();
 
-    fdb_doc_free(rdoc);
+    memleak_start();
 
-    // Mid-way reverse direction, again test forward iterator...
-    i++;
-    status = fdb_iterator_next(iterator, &rdoc);
-    TEST_CHK(status != FDB_RESULT_ITERATOR_FAIL);
+    int i, r, c;
+    int n = 10000;
+    uint64_t count, bytes;
+    fdb_file_handle *dbfile;
+    fdb_kvs_handle *db, *kv1, *kvs[2];
+    fdb_doc *doc;
+    fdb_status status;
+    fdb_kvs_info info;
 
-    TEST_CHK(!memcmp(rdoc->key, doc[i]->key, rdoc->keylen));
-    TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
-    TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
+    char keybuf[256], bodybuf[256];
 
-    fdb_doc_free(rdoc);
+    // remove previous dummy files
+    r = system(SHELL_DEL" dummy* > errorlog.txt");
+    (void)r;
 
-    // Again change direction and test reverse iterator..
-    i--;
-    while (1) {
-        status = fdb_iterator_prev(iterator, &rdoc);
+    fdb_config fconfig = fdb_get_default_config();
+    fdb_kvs_config kvs_config = fdb_get_default_kvs_config();
+    fconfig.wal_threshold = 1024;
+    fconfig.flags = FDB_OPEN_FLAG_CREATE;
+    fconfig.compaction_threshold = 0;
 
-        if (status == FDB_RESULT_ITERATOR_FAIL) break;
+    // open db
+    fdb_open(&dbfile, "./dummy1", &fconfig);
+    fdb_kvs_open_default(dbfile, &db, &kvs_config);
+    fdb_kvs_open(dbfile, &kv1, "kv1", &kvs_config);
+    kvs[0] = db;
+    kvs[1] = kv1;
 
-        TEST_CHK(!memcmp(rdoc->key, doc[i]->key, rdoc->keylen));
-        TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
-        TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
+    // nothing in an empty KV store
+    status = fdb_estimate_range(db, NULL, 0, NULL, 0, &count, &bytes);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    TEST_CHK(count == 0 && bytes == 0);
 
-        fdb_doc_free(rdoc);
-        i--;
+    for (i=0;i<n;++i){
+        sprintf(keybuf, "key%06d", i);
+        sprintf(bodybuf, "body%06d", i);
+        fdb_doc_create(&doc, (void*)keybuf, strlen(keybuf),
+            NULL, 0, (void*)bodybuf, strlen(bodybuf));
+        fdb_set(db, doc);
+        // only odd keys in the other KV store
+        if (i % 2) {
+            fdb_set(kv1, doc);
+        }
+        fdb_doc_free(doc);
     }
-    TEST_CHK(i == -1);
-
-    // Reached end - now test forward iterator...
-    i++;
-    while(1){
-        status = fdb_iterator_next(iterator, &rdoc);
-        if (status == FDB_RESULT_ITERATOR_FAIL) break;
+    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
 
-        TEST_CHK(!memcmp(rdoc->key, doc[i]->key, rdoc->keylen));
-        TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
-        TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
+    for (c=0;c<2;++c){
+        // whole KV store
+        status = fdb_estimate_range(kvs[c], NULL, 0, NULL, 0, &count, &bytes);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        fdb_get_kvs_info(kvs[c], &info);
+        TEST_CHK(count == info.doc_count);
+        TEST_CHK(count == (uint64_t)(n >> c));
+        TEST_CHK(bytes > 0);
+
+        // a fifth of the KV store
+        status = fdb_estimate_range(kvs[c], "key002000", 9, "key004000", 9,
+                                    &count, &bytes);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        TEST_CHK(count > (uint64_t)(n >> c) / 5 / 2);
+        TEST_CHK(count < (uint64_t)(n >> c) / 5 * 2);
+        TEST_CHK(bytes > 0);
 
-        fdb_doc_free(rdoc);
-        i++;
-    };
-    TEST_CHK(i==10);
+        // open-ended ranges
+        status = fdb_estimate_range(kvs[c], NULL, 0, "key005000", 9,
+                                    &count, &bytes);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        TEST_CHK(count > (uint64_t)(n >> c) / 2 / 2);
+        TEST_CHK(count < (uint64_t)(n >> c) / 2 * 2);
+        status = fdb_estimate_range(kvs[c], "zzz", 3, NULL, 0,
+                                    &count, &bytes);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        TEST_CHK(count == 0);
 
-    fdb_iterator_close(iterator);
+        // reversed range
+        status = fdb_estimate_range(kvs[c], "key004000", 9, "key002000", 9,
+                                    &count, &bytes);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        TEST_CHK(count == 0 && bytes == 0);
+    }
 
     // close db file
+    fdb_kvs_close(kv1);
     fdb_kvs_close(db);
     fdb_close(dbfile);
 
-    // free all documents
-    for (i=0;i<n;++i){
-        fdb_doc_free(doc[i]);
-    }
-
     // free all resources
     fdb_shutdown();
 
     memleak_end();
 
-    TEST_RESULT("reverse iterator test");
+    TEST_RESULT("estimate range test");
 }
 
-void reverse_sequence_iterator_kvs_test()
+void sequence_iterator_test()
 {
-
     TEST_INIT();
+
     memleak_start();
 
-    int i, r, count;
+    int i, r;
     int n = 10;
+    int count;
     fdb_file_handle *dbfile;
-    fdb_kvs_handle *kv1, *kv2;
+    fdb_kvs_handle *db;
     fdb_doc **doc = alca(fdb_doc*, n);
-    fdb_doc **doc2 = alca(fdb_doc*, n);
     fdb_doc *rdoc;
     fdb_status status;
     fdb_iterator *iterator;
-    fdb_iterator *iterator2;
 
     char keybuf[256], metabuf[256], bodybuf[256];
 
@@ -3397,193 +3458,221 @@ void reverse_sequence_iterator_kvs_test()
 
     // open db
     fdb_open(&dbfile, "./dummy1", &fconfig);
-    fdb_kvs_open_default(dbfile, &kv1, &kvs_config);
-    status = fdb_set_log_callback(kv1, logCallbackFunc,
-                                  (void *) "reverse_sequence_iterator_kvs_test");
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
-
-    // Create another KV store...
-    status = fdb_kvs_open(dbfile, &kv2, "kv2", &kvs_config);
+    fdb_kvs_open_default(dbfile, &db, &kvs_config);
+    status = fdb_set_log_callback(db, logCallbackFunc,
+                                  (void *) "sequence_iterator_test");
     TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-    // to 'kv2' with entire range
-    for (i=0;i<n;++i) {
-        sprintf(keybuf, "kEy%d", i);
-        sprintf(metabuf, "mEta%d", i);
-        sprintf(bodybuf, "bOdy%d", i);
-        fdb_doc_create(&doc2[i], (void*)keybuf, strlen(keybuf),
-            (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
-        status = fdb_set(kv2, doc2[i]);
-        TEST_CHK(status == FDB_RESULT_SUCCESS);
-    }
-
-    // insert kv1 documents of even number
-    for (i=0;i<n;i+=2) {
+    // insert documents of even number
+    for (i=0;i<n;i+=2){
         sprintf(keybuf, "key%d", i);
         sprintf(metabuf, "meta%d", i);
         sprintf(bodybuf, "body%d", i);
         fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
             (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
-        fdb_set(kv1, doc[i]);
+        fdb_set(db, doc[i]);
     }
-
     // manually flush WAL & commit
     fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
 
-    // insert kv1 documents of odd number
-    for (i=1;i<n;i+=2) {
+    // insert documents of odd number
+    for (i=1;i<n;i+=2){
         sprintf(keybuf, "key%d", i);
         sprintf(metabuf, "meta%d", i);
         sprintf(bodybuf, "body%d", i);
         fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
             (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
-        fdb_set(kv1, doc[i]);
+        fdb_set(db, doc[i]);
     }
     // commit without WAL flush
     fdb_commit(dbfile, FDB_COMMIT_NORMAL);
 
-    // iterate even docs on kv1
-    fdb_iterator_sequence_init(kv1, &iterator, 0, 0, FDB_ITR_NONE);
+    // now even number docs are in hb-trie & odd number docs are in WAL
+
+    // create an iterator over sequence number range over FULL RANGE
+    fdb_iterator_sequence_init(db, &iterator, 0, 0, FDB_ITR_NONE);
+
+    // repeat until fail
     i=0;
     count = 0;
-    while (1) {
+    while(1){
         status = fdb_iterator_next(iterator, &rdoc);
         if (status == FDB_RESULT_ITERATOR_FAIL) break;
+
         TEST_CHK(!memcmp(rdoc->key, doc[i]->key, rdoc->keylen));
         TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
         TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
-        fdb_doc_free(rdoc);
-        count++;
-        if (i + 2 >= n) {
-            break;
-        }
-        i = i + 2; // by-seq, first come even docs, then odd
-    }
-    TEST_CHK(count==n/2);
 
-    // iterate all docs over kv2
-    fdb_iterator_sequence_init(kv2, &iterator2, 0, 0, FDB_ITR_NONE);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
-    while(1) {
-        status = fdb_iterator_next(iterator2, &rdoc);
-        if (status == FDB_RESULT_ITERATOR_FAIL) {
-            break;
-        }
         fdb_doc_free(rdoc);
-    }
+        i = (i + 2 >= n) ? 1: i + 2; // by-seq, first come even docs, then odd
+        count++;
+    };
+    TEST_CHK(count==n);
+    fdb_iterator_close(iterator);
 
-    // manually flush WAL & commit
-    // iterators should be unaffected
-    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
+    // create an iterator over sequence number with META ONLY
+    fdb_iterator_sequence_init(db, &iterator, 0, 0, FDB_ITR_METAONLY);
 
-    // reverse iterate even docs over kv1
-     i = n - 4;
+    // repeat until fail
+    i=0;
     count = 0;
-    while (1) {
-        status = fdb_iterator_prev(iterator, &rdoc);
-        if (status == FDB_RESULT_ITERATOR_FAIL) {
-            break;
-        }
+    while(1){
+        status = fdb_iterator_next_metaonly(iterator, &rdoc);
+        if (status == FDB_RESULT_ITERATOR_FAIL) break;
+
         TEST_CHK(!memcmp(rdoc->key, doc[i]->key, rdoc->keylen));
         TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
-        TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
-        fdb_doc_free(rdoc);
-        i-=2;
-        count++;
-    }
-
-    TEST_CHK(count==4);
-    fdb_iterator_close(iterator);
+        TEST_CHK(rdoc->body == NULL);
 
-    i = n-1;
-    count = 0;
-    // reverse iterate all docs over kv2
-    while (1) {
-        status = fdb_iterator_prev(iterator2, &rdoc);
-        if (status == FDB_RESULT_ITERATOR_FAIL) {
-            break;
-        }
-        TEST_CHK(!memcmp(rdoc->key, doc2[i]->key, rdoc->keylen));
-        TEST_CHK(!memcmp(rdoc->meta, doc2[i]->meta, rdoc->metalen));
-        TEST_CHK(!memcmp(rdoc->body, doc2[i]->body, rdoc->bodylen));
         fdb_doc_free(rdoc);
-        i--;
+        i = (i + 2 >= n) ? 1: i + 2; // by-seq, first come even docs, then odd
         count++;
-    }
+    };
     TEST_CHK(count==n);
-    fdb_iterator_close(iterator2);
+    fdb_iterator_close(iterator);
 
-    // re-open iterator after commit should return all docs for kv1
-    i = 0;
+    // create another iterator starts from seq number 2 and ends at 9
+    fdb_iterator_sequence_init(db, &iterator, 2, 7, FDB_ITR_NONE);
+
+    // repeat until fail
+    i=2;
     count = 0;
-    fdb_iterator_sequence_init(kv1, &iterator, 0, 0, FDB_ITR_NONE);
-    while (1) {
+    while(1){
         status = fdb_iterator_next(iterator, &rdoc);
-        if (status == FDB_RESULT_ITERATOR_FAIL) {
-            break;
-        }
+        if (status == FDB_RESULT_ITERATOR_FAIL) break;
+
         TEST_CHK(!memcmp(rdoc->key, doc[i]->key, rdoc->keylen));
         TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
         TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
+
         fdb_doc_free(rdoc);
-        if (i == 8) {
-            i=1; // switch to odds
-        } else {
-            i+=2;
-        }
+        i = (i + 2 >= n) ? 1: i + 2; // by-seq, first come even docs, then odd
         count++;
-    }
-    TEST_CHK(count==n);
+    };
+    TEST_CHK(count==6);
+    fdb_iterator_close(iterator);
+    // remove document #8 and #9
+    fdb_doc_create(&rdoc, doc[8]->key, doc[8]->keylen, doc[8]->meta, doc[8]->metalen, NULL, 0);
+    status = fdb_del(db, rdoc);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    fdb_doc_free(rdoc);
+    fdb_doc_create(&rdoc, doc[9]->key, doc[9]->keylen, doc[9]->meta, doc[9]->metalen, NULL, 0);
+    status = fdb_del(db, rdoc);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    fdb_doc_free(rdoc);
+    // commit
+    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+
+    // create an iterator for full range
+    fdb_iterator_sequence_init(db, &iterator, 0, 0, FDB_ITR_NONE);
+    // repeat until fail
+    i=0;
+    count=0;
+    while(1){
+        status = fdb_iterator_next(iterator, &rdoc);
+        if (status == FDB_RESULT_ITERATOR_FAIL) break;
+
+        if (count != 8 && count != 9) { // do not look validate key8 and key9
+            TEST_CHK(!memcmp(rdoc->key, doc[i]->key, rdoc->keylen));
+            TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
+            TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
+        } else {
+            TEST_CHK(rdoc->deleted == true);
+        }
+
+        fdb_doc_free(rdoc);
+        // Turn around when we hit 8 as the last items, key8 and key9 are gone
+        i = (i + 2 >= 8) ? 1: i + 2; // by-seq, first come even docs, then odd
+        count++;
+    };
+    TEST_CHK(count==10); // 10 items, with 2 deletions
+    fdb_iterator_close(iterator);
+
+    // create an iterator for full range, but no deletes.
+    fdb_iterator_sequence_init(db, &iterator, 0, 0, FDB_ITR_NO_DELETES);
+    // repeat until fail
+    i=0;
+    count=0;
+    while(1){
+        status = fdb_iterator_next(iterator, &rdoc);
+        if (status == FDB_RESULT_ITERATOR_FAIL) break;
+
+        if (i != 8 && i != 9) { // key8 and key9 are deleted
+            TEST_CHK(!memcmp(rdoc->key, doc[i]->key, rdoc->keylen));
+            TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
+            TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
+        }
+
+        fdb_doc_free(rdoc);
+        i = (i + 2 >= 8) ? 1: i + 2; // by-seq, first come even docs, then odd
+        count++;
+    };
+    TEST_CHK(count==8); // 10 items, with 2 deletions
+    fdb_iterator_close(iterator);
+
+    // Update first document and test for absence of duplicates
+    *((char *)doc[0]->body) = 'K'; // update key0 to Key0
+    fdb_set(db, doc[0]);
+    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+
+    fdb_iterator_sequence_init(db, &iterator, 0, 0, FDB_ITR_NO_DELETES);
+    // repeat until fail
+    i=2; // i == 0 should not appear until the end
+    count=0;
+    while(1){
+        status = fdb_iterator_next(iterator, &rdoc);
+        if (status == FDB_RESULT_ITERATOR_FAIL) break;
+
+        if (i != 8 && i != 9) { // key8 and key9 are deleted
+            TEST_CHK(!memcmp(rdoc->key, doc[i]->key, rdoc->keylen));
+            TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
+            TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
+        }
+
+        fdb_doc_free(rdoc);
+        i = (i + 2 >= 8) ? 1: i + 2; // by-seq, first come even docs, then odd
+        if (count == 6) i = 0; // go back to test for i=0 at the end
+        count++;
+    };
+    TEST_CHK(count==8); // 10 items, with 2 deletions
     fdb_iterator_close(iterator);
 
+    // close db file
+    fdb_kvs_close(db);
+    fdb_close(dbfile);
+
     // free all documents
-    for (i=0;i<n;++i) {
+    for (i=0;i<n;++i){
         fdb_doc_free(doc[i]);
-        fdb_doc_free(doc2[i]);
     }
 
-    fdb_kvs_close(kv1);
-    fdb_kvs_close(kv2);
-    fdb_close(dbfile);
-
+    // free all resources
     fdb_shutdown();
-    memleak_end();
-    TEST_RESULT("reverse sequence iterator kvs test");
 
-}
-
-static int _cmp_double(void *key1, size_t keylen1, void *key2, size_t keylen2)
-{
-    double aa, bb;
-    aa = *(double *)key1;
-    bb = *(double *)key2;
+    memleak_end();
 
-    if (aa<bb) {
-        return -1;
-    } else if (aa>bb) {
-        return 1;
-    } else {
-        return 0;
-    }
+    TEST_RESULT("sequence iterator test");
 }
 
-void custom_compare_primitive_test()
+void sequence_iterator_duplicate_test()
 {
+    // Unit test for MB-12225
     TEST_INIT();
 
     memleak_start();
 
     int i, r;
-    int n = 10;
+    int n = 100;
+    int count;
     fdb_file_handle *dbfile;
     fdb_kvs_handle *db;
     fdb_doc **doc = alca(fdb_doc*, n);
     fdb_doc *rdoc;
     fdb_status status;
     fdb_iterator *iterator;
+    fdb_seqnum_t seqnum;
 
-    char keybuf[256], bodybuf[256];
-    double key_double, key_double_prev;
+    char keybuf[256], metabuf[256], bodybuf[256];
 
     // remove previous dummy files
     r = system(SHELL_DEL" dummy* > errorlog.txt");
@@ -3593,115 +3682,107 @@ void custom_compare_primitive_test()
     fdb_kvs_config kvs_config = fdb_get_default_kvs_config();
     fconfig.buffercache_size = 0;
     fconfig.wal_threshold = 1024;
-    fconfig.flags = FDB_OPEN_FLAG_CREATE;
     fconfig.compaction_threshold = 0;
-    fconfig.multi_kv_instances = true;
 
-    kvs_config.custom_cmp = _cmp_double;
-
-    // open db with custom compare function for double key type
+    // open db
     fdb_open(&dbfile, "./dummy1", &fconfig);
     fdb_kvs_open_default(dbfile, &db, &kvs_config);
     status = fdb_set_log_callback(db, logCallbackFunc,
-                                  (void *) "custom_compare_primitive_test");
+                                  (void *) "sequence_iterator_test");
     TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-    for (i=0;i<n;++i){
-        key_double = 10000/(i*11.0);
-        memcpy(keybuf, &key_double, sizeof(key_double));
-        sprintf(bodybuf, "value: %d, %f", i, key_double);
-        fdb_doc_create(&doc[i], (void*)keybuf, sizeof(key_double), NULL, 0,
-            (void*)bodybuf, strlen(bodybuf)+1);
+    // insert documents first time
+    for (i=0;i<n;i++){
+        sprintf(keybuf, "key%d", i);
+        sprintf(metabuf, "meta%d", i);
+        sprintf(bodybuf, "body%d(first)", i);
+        fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
+            (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
         fdb_set(db, doc[i]);
     }
+    // manually flush WAL & commit
+    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
 
-    // range scan (before flushing WAL)
-    fdb_iterator_init(db, &iterator, NULL, 0, NULL, 0, 0x0);
-    key_double_prev = -1;
-    while(1){
-        if ( (status = fdb_iterator_next(iterator, &rdoc)) == FDB_RESULT_ITERATOR_FAIL)
-            break;
-        memcpy(&key_double, rdoc->key, rdoc->keylen);
-        TEST_CHK(key_double > key_double_prev);
-        key_double_prev = key_double;
-        fdb_doc_free(rdoc);
-    };
-    fdb_iterator_close(iterator);
-
+    // insert documents second time
+    for (i=0;i<n;i++){
+        sprintf(bodybuf, "body%d(second)", i);
+        fdb_doc_update(&doc[i], NULL, 0, bodybuf, strlen(bodybuf));
+        fdb_set(db, doc[i]);
+    }
+    // manually flush WAL & commit
     fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
 
-    // range scan (after flushing WAL)
-    fdb_iterator_init(db, &iterator, NULL, 0, NULL, 0, 0x0);
-    key_double_prev = -1;
-    while(1){
-        if (fdb_iterator_next(iterator, &rdoc) == FDB_RESULT_ITERATOR_FAIL)
-            break;
-        memcpy(&key_double, rdoc->key, rdoc->keylen);
-        TEST_CHK(key_double > key_double_prev);
-        key_double_prev = key_double;
-        fdb_doc_free(rdoc);
-    };
-    fdb_iterator_close(iterator);
+    // insert documents third time (only even number documents)
+    for (i=0;i<n;i+=2){
+        sprintf(bodybuf, "body%d(third)", i);
+        fdb_doc_update(&doc[i], NULL, 0, bodybuf, strlen(bodybuf));
+        fdb_set(db, doc[i]);
+    }
+    // commit without WAL flushing
+    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
 
-    // do compaction
-    fdb_compact(dbfile, (char *) "./dummy2");
+    // create an iterator over sequence number
+    fdb_iterator_sequence_init(db, &iterator, 0, 220, FDB_ITR_NONE);
 
-    // range scan (after compaction)
-    fdb_iterator_init(db, &iterator, NULL, 0, NULL, 0, 0x0);
-    key_double_prev = -1;
+    // repeat until fail
+    count = 0;
     while(1){
-        if (fdb_iterator_next(iterator, &rdoc) == FDB_RESULT_ITERATOR_FAIL)
-            break;
-        memcpy(&key_double, rdoc->key, rdoc->keylen);
-        TEST_CHK(key_double > key_double_prev);
-        key_double_prev = key_double;
+        status = fdb_iterator_next(iterator, &rdoc);
+        if (status == FDB_RESULT_ITERATOR_FAIL) break;
+        if (count<50) {
+            // HB+trie
+            i = count*2 + 1;
+            seqnum = 100 + (count+1)*2;
+            sprintf(bodybuf, "body%d(second)", i);
+        } else {
+            // WAL
+            i = (count-50)*2;
+            seqnum = 200 + (count-50+1);
+            sprintf(bodybuf, "body%d(third)", i);
+        }
+
+        TEST_CHK(!memcmp(rdoc->key, doc[i]->key, rdoc->keylen));
+        TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
+        TEST_CHK(!memcmp(rdoc->body, bodybuf, rdoc->bodylen));
+        TEST_CHK(rdoc->seqnum == seqnum);
+
+        count++;
         fdb_doc_free(rdoc);
     };
+    TEST_CHK(count==70);
     fdb_iterator_close(iterator);
 
     // close db file
     fdb_kvs_close(db);
     fdb_close(dbfile);
-
     // free all documents
     for (i=0;i<n;++i){
         fdb_doc_free(doc[i]);
     }
-
     // free all resources
     fdb_shutdown();
 
     memleak_end();
 
-    TEST_RESULT("custom compare function for primitive key test");
-}
-
-static int _cmp_variable(void *key1, size_t keylen1, void *key2, size_t keylen2)
-{
-    // compare only 3rd~8th bytes (ignore the others)
-    return memcmp((uint8_t*)key1+2, (uint8_t*)key2+2, 6);
+    TEST_RESULT("sequence iterator duplicate test");
 }
 
-void custom_compare_variable_test()
+void reverse_sequence_iterator_test()
 {
     TEST_INIT();
 
     memleak_start();
 
-    int i, j, r;
-    int n = 1000;
-    uint64_t count;
+    int i, r, count;
+    int n = 10;
     fdb_file_handle *dbfile;
-    fdb_kvs_handle *db, *db2;
+    fdb_kvs_handle *db;
     fdb_doc **doc = alca(fdb_doc*, n);
     fdb_doc *rdoc;
     fdb_status status;
     fdb_iterator *iterator;
 
-    size_t keylen = 16;
-    size_t prev_keylen;
-    char keybuf[256], bodybuf[256];
-    char prev_key[256];
+    char keybuf[256], metabuf[256], bodybuf[256];
 
     // remove previous dummy files
     r = system(SHELL_DEL" dummy* > errorlog.txt");
@@ -3713,143 +3794,111 @@ void custom_compare_variable_test()
     fconfig.wal_threshold = 1024;
     fconfig.flags = FDB_OPEN_FLAG_CREATE;
     fconfig.compaction_threshold = 0;
-    fconfig.multi_kv_instances = true;
-
-    kvs_config.custom_cmp = _cmp_variable;
 
-    // open db with custom compare function for variable length key type
-    //fdb_open_cmp_variable(&dbfile, "./dummy1", &fconfig);
+    // open db
     fdb_open(&dbfile, "./dummy1", &fconfig);
     fdb_kvs_open_default(dbfile, &db, &kvs_config);
     status = fdb_set_log_callback(db, logCallbackFunc,
-                                  (void *) "custom_compare_variable_test");
+                                  (void *) "reverse_sequence_iterator_test");
     TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-    for (i=0;i<n;++i){
-        for (j=0;j<2;++j){
-            keybuf[j] = 'a' + rand()%('z'-'a');
-        }
-        sprintf(keybuf+2, "%06d", i);
-        for (j=8;j<keylen-1;++j){
-            keybuf[j] = 'a' + rand()%('z'-'a');
-        }
-        keybuf[keylen-1] = 0;
-        sprintf(bodybuf, "value: %d", i);
-        fdb_doc_create(&doc[i], (void*)keybuf, keylen, NULL, 0,
-            (void*)bodybuf, strlen(bodybuf)+1);
+    // insert documents of even number
+    for (i=0;i<n;i+=2){
+        sprintf(keybuf, "key%d", i);
+        sprintf(metabuf, "meta%d", i);
+        sprintf(bodybuf, "body%d", i);
+        fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
+            (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
         fdb_set(db, doc[i]);
     }
+    // manually flush WAL & commit
+    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
 
-    // point query
-    for (i=0;i<n;++i){
-        fdb_doc_create(&rdoc, doc[i]->key, doc[i]->keylen, NULL, 0, NULL, 0);
-        status = fdb_get(db, rdoc);
+    // insert documents of odd number
+    for (i=1;i<n;i+=2){
+        sprintf(keybuf, "key%d", i);
+        sprintf(metabuf, "meta%d", i);
+        sprintf(bodybuf, "body%d", i);
+        fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
+            (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
+        fdb_set(db, doc[i]);
+    }
+    // commit without WAL flush
+    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
 
-        TEST_CHK(status == FDB_RESULT_SUCCESS);
-        TEST_CHK(rdoc->bodylen == doc[i]->bodylen);
-        TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
+    // now even number docs are in hb-trie & odd number docs are in WAL
 
-        fdb_doc_free(rdoc);
-    }
+    // First test reverse sequence iteration as it only involves btrees
+    // create an iterator over sequence number range over FULL RANGE
+    fdb_iterator_sequence_init(db, &iterator, 0, 0, FDB_ITR_NONE);
 
-    // range scan (before flushing WAL)
-    fdb_iterator_init(db, &iterator, NULL, 0, NULL, 0, 0x0);
-    sprintf(prev_key, "%016d", 0);
+    // move iterator forward up till middle...
+    i=0;
     count = 0;
-    prev_keylen = 16;
     while(1){
-        if (fdb_iterator_next(iterator, &rdoc) == FDB_RESULT_ITERATOR_FAIL)
-            break;
-        TEST_CHK(_cmp_variable(prev_key, prev_keylen, rdoc->key, rdoc->keylen) <= 0);
-        prev_keylen = rdoc->keylen;
-        memcpy(prev_key, rdoc->key, rdoc->keylen);
-        fdb_doc_free(rdoc);
-        count++;
-    };
-    TEST_CHK(count == n);
-    fdb_iterator_close(iterator);
+        status = fdb_iterator_next(iterator, &rdoc);
+        if (status == FDB_RESULT_ITERATOR_FAIL) break;
 
-    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
+        TEST_CHK(!memcmp(rdoc->key, doc[i]->key, rdoc->keylen));
+        TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
+        TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
 
-    // range scan (after flushing WAL)
-    fdb_iterator_init(db, &iterator, NULL, 0, NULL, 0, 0x0);
-    sprintf(prev_key, "%016d", 0);
-    count = 0;
-    prev_keylen = 16;
-    while(1){
-        if (fdb_iterator_next(iterator, &rdoc) == FDB_RESULT_ITERATOR_FAIL)
-            break;
-        TEST_CHK(_cmp_variable(prev_key, prev_keylen, rdoc->key, rdoc->keylen) <= 0);
-        prev_keylen = rdoc->keylen;
-        memcpy(prev_key, rdoc->key, rdoc->keylen);
         fdb_doc_free(rdoc);
         count++;
+        if (i + 2 >= n) break;
+        i = i + 2; // by-seq, first come even docs, then odd
     };
-    TEST_CHK(count == n);
-    fdb_iterator_close(iterator);
+    TEST_CHK(count==n/2);
 
-    // do compaction
-    fdb_compact(dbfile, (char *) "./dummy2");
+    // Now test reverse sequence iterator from mid-way..
 
-    // range scan (after compaction)
-    fdb_iterator_init(db, &iterator, NULL, 0, NULL, 0, 0x0);
-    sprintf(prev_key, "%016d", 0);
-    count = 0;
-    prev_keylen = 16;
-    while(1){
-        if (fdb_iterator_next(iterator, &rdoc) == FDB_RESULT_ITERATOR_FAIL)
-            break;
-        TEST_CHK(_cmp_variable(prev_key, prev_keylen, rdoc->key, rdoc->keylen) <= 0);
-        prev_keylen = rdoc->keylen;
-        memcpy(prev_key, rdoc->key, rdoc->keylen);
-        fdb_doc_free(rdoc);
-        count++;
-    };
-    TEST_CHK(count == n);
-    fdb_iterator_close(iterator);
+    i = i - 2;
+    status = fdb_iterator_prev(iterator, &rdoc);
+    TEST_CHK(status != FDB_RESULT_ITERATOR_FAIL);
 
-    // range scan by sequence
-    fdb_iterator_sequence_init(db, &iterator, 0, 0, 0x0);
-    count = 0;
-    while(1){ // forward
+    TEST_CHK(!memcmp(rdoc->key, doc[i]->key, rdoc->keylen));
+    TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
+    TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
+
+    fdb_doc_free(rdoc);
+    count++;
+
+    i = i + 2;
+    while(1){
         status = fdb_iterator_next(iterator, &rdoc);
-        if (status == FDB_RESULT_ITERATOR_FAIL) {
-            break;
-        }
+        if (status == FDB_RESULT_ITERATOR_FAIL) break;
+
+        TEST_CHK(!memcmp(rdoc->key, doc[i]->key, rdoc->keylen));
+        TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
+        TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
+
         fdb_doc_free(rdoc);
+        i = (i + 2 >= n) ? 1 : i + 2;// by-seq, first come even docs, then odd
         count++;
     };
-    TEST_CHK(count == n);
-    while(1){ // backward
-        status = fdb_iterator_prev(iterator, &rdoc);
-        if (status == FDB_RESULT_ITERATOR_FAIL) {
-            break;
-        }
-        fdb_doc_free(rdoc);
-        count--;
-    };
-    TEST_CHK(count == 0);
-    fdb_iterator_close(iterator);
 
-    // open another handle
-    kvs_config.custom_cmp = NULL;
-    fdb_kvs_open_default(dbfile, &db2, &kvs_config);
+    TEST_CHK(count==n+2); // two items were double counted due to reverse
 
-    // point query
-    for (i=0;i<n;++i){
-        fdb_doc_create(&rdoc, doc[i]->key, doc[i]->keylen, NULL, 0, NULL, 0);
-        status = fdb_get(db2, rdoc);
+    // Reached End, now reverse iterate till start
+    i = n - 1;
+    count = n;
+    while (1) {
+       status = fdb_iterator_prev(iterator, &rdoc);
+        if (status == FDB_RESULT_ITERATOR_FAIL) break;
 
-        TEST_CHK(status == FDB_RESULT_SUCCESS);
-        TEST_CHK(rdoc->bodylen == doc[i]->bodylen);
+        TEST_CHK(!memcmp(rdoc->key, doc[i]->key, rdoc->keylen));
+        TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
         TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
 
         fdb_doc_free(rdoc);
+        i = (i - 2 < 0) ? n - 2 : i - 2;
+        if (count) count--;
     }
+    TEST_CHK(count == 0);
+    fdb_iterator_close(iterator);
 
     // close db file
     fdb_kvs_close(db);
-    fdb_kvs_close(db2);
     fdb_close(dbfile);
 
     // free all documents
@@ -3862,25 +3911,21 @@ void custom_compare_variable_test()
 
     memleak_end();
 
-    TEST_RESULT("custom compare function for variable length key test");
+    TEST_RESULT("reverse sequence iterator test");
 }
 
-void snapshot_test()
+void reverse_iterator_test()
 {
     TEST_INIT();
 
     memleak_start();
 
     int i, r;
-    int n = 20;
-    int count;
+    int n = 10;
     fdb_file_handle *dbfile;
     fdb_kvs_handle *db;
-    fdb_kvs_handle *snap_db;
-    fdb_seqnum_t snap_seq;
     fdb_doc **doc = alca(fdb_doc*, n);
     fdb_doc *rdoc;
-    fdb_kvs_info kvs_info;
     fdb_status status;
     fdb_iterator *iterator;
 
@@ -3897,32 +3942,15 @@ void snapshot_test()
     fconfig.flags = FDB_OPEN_FLAG_CREATE;
     fconfig.compaction_threshold = 0;
 
-    // remove previous dummy files
-    r = system(SHELL_DEL" dummy* > errorlog.txt");
-    (void)r;
-
     // open db
-    status = fdb_open(&dbfile, "./dummy1", &fconfig);
+    fdb_open(&dbfile, "./dummy1", &fconfig);
     fdb_kvs_open_default(dbfile, &db, &kvs_config);
+    status = fdb_set_log_callback(db, logCallbackFunc,
+                                  (void *) "reverse_iterator_test");
     TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-    // Create a snapshot from an empty database file
-    status = fdb_snapshot_open(db, &snap_db, 0);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
-    // check if snapshot's sequence number is zero.
-    fdb_get_kvs_info(snap_db, &kvs_info);
-    TEST_CHK(kvs_info.last_seqnum == 0);
-    // create an iterator on the snapshot for full range
-    fdb_iterator_init(snap_db, &iterator, NULL, 0, NULL, 0, FDB_ITR_NONE);
-    // Iterator should not return any items.
-    status = fdb_iterator_next(iterator, &rdoc);
-    TEST_CHK(status == FDB_RESULT_ITERATOR_FAIL);
-    fdb_iterator_close(iterator);
-    fdb_kvs_close(snap_db);
-
-    // ------- Setup test ----------------------------------
-    // insert documents of 0-4
-    for (i=0; i<n/4; i++){
+    // insert documents of even number
+    for (i=0;i<n;i+=2){
         sprintf(keybuf, "key%d", i);
         sprintf(metabuf, "meta%d", i);
         sprintf(bodybuf, "body%d", i);
@@ -3930,12 +3958,11 @@ void snapshot_test()
             (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
         fdb_set(db, doc[i]);
     }
-
-    // commit with a manual WAL flush (these docs go into HB-trie)
+    // manually flush WAL & commit
     fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
 
-    // insert documents from 4 - 8
-    for (; i < n/2 - 1; i++){
+    // insert documents of odd number
+    for (i=1;i<n;i+=2){
         sprintf(keybuf, "key%d", i);
         sprintf(metabuf, "meta%d", i);
         sprintf(bodybuf, "body%d", i);
@@ -3943,82 +3970,74 @@ void snapshot_test()
             (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
         fdb_set(db, doc[i]);
     }
+    // commit without WAL flush
+    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
 
-    // We want to create:
-    // |WALFlushHDR|Key-Value1|HDR|Key-Value2|SnapshotHDR|Key-Value1|HDR|
-    // Insert doc 9 with a different value to test duplicate elimination..
-    sprintf(keybuf, "key%d", i);
-    sprintf(metabuf, "meta%d", i);
-    sprintf(bodybuf, "Body%d", i);
-    fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
-            (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
-    fdb_set(db, doc[i]);
+    // now even number docs are in hb-trie & odd number docs are in WAL
 
-    // commit again without a WAL flush (last doc goes into the AVL tree)
-    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+    // Reverse iteration over key range which involves hb-tries
+    // create an iterator for full range
+    fdb_iterator_init(db, &iterator, NULL, 0, NULL, 0, FDB_ITR_NONE);
 
-    // Insert doc 9 now again with expected value..
-    *(char *)doc[i]->body = 'b';
-    fdb_set(db, doc[i]);
-    // commit again without a WAL flush (these documents go into the AVL trees)
-    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+    // first test forward iterator - repeat until fail
+    i=0;
+    while(1){
+        status = fdb_iterator_next(iterator, &rdoc);
+        if (status == FDB_RESULT_ITERATOR_FAIL) break;
 
-    // TAKE SNAPSHOT: pick up sequence number of a commit without a WAL flush
-    snap_seq = doc[i]->seqnum;
+        TEST_CHK(!memcmp(rdoc->key, doc[i]->key, rdoc->keylen));
+        TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
+        TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
 
-    // Now re-insert doc 9 as another duplicate (only newer sequence number)
-    fdb_set(db, doc[i]);
-    // commit again without a WAL flush (last doc goes into the AVL tree)
-    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+        fdb_doc_free(rdoc);
+        i++;
+    };
+    TEST_CHK(i==10);
 
-    // insert documents from 10-14 into HB-trie
-    for (++i; i < (n/2 + n/4); i++){
-        sprintf(keybuf, "key%d", i);
-        sprintf(metabuf, "meta%d", i);
-        sprintf(bodybuf, "body%d", i);
-        fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
-            (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
-        fdb_set(db, doc[i]);
+    // Now test reverse iterator..
+    i--;
+    while (1) {
+        status = fdb_iterator_prev(iterator, &rdoc);
+
+        if (status == FDB_RESULT_ITERATOR_FAIL) break;
+
+        TEST_CHK(!memcmp(rdoc->key, doc[i]->key, rdoc->keylen));
+        TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
+        TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
+
+        fdb_doc_free(rdoc);
+        if (i == 5) break; // Change direction at half point
+        i--;
     }
-    // manually flush WAL & commit
-    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
+    TEST_CHK(i == 5);
 
-    status = fdb_set_log_callback(db, logCallbackFunc,
-                                  (void *) "snapshot_test");
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
-    // ---------- Snapshot tests begin -----------------------
-    // Attempt to take snapshot with out-of-range marker..
-    status = fdb_snapshot_open(db, &snap_db, 999999);
-    TEST_CHK(status == FDB_RESULT_NO_DB_INSTANCE);
+    // Mid-way reverse direction, again test forward iterator...
+    i++;
+    status = fdb_iterator_next(iterator, &rdoc);
+    TEST_CHK(status != FDB_RESULT_ITERATOR_FAIL);
 
-    // Init Snapshot of open file with saved document seqnum as marker
-    status = fdb_snapshot_open(db, &snap_db, snap_seq);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    TEST_CHK(!memcmp(rdoc->key, doc[i]->key, rdoc->keylen));
+    TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
+    TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
 
-    // check snapshot's sequence number
-    fdb_get_kvs_info(snap_db, &kvs_info);
-    TEST_CHK(kvs_info.last_seqnum == snap_seq);
+    fdb_doc_free(rdoc);
 
-    // insert documents from 15 - 19 on file into the WAL
-    for (; i < n; i++){
-        sprintf(keybuf, "key%d", i);
-        sprintf(metabuf, "meta%d", i);
-        sprintf(bodybuf, "body%d", i);
-        fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
-            (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
-        fdb_set(db, doc[i]);
-    }
-    // commit without a WAL flush (This WAL must not affect snapshot)
-    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+    // Mid-way reverse direction, again test forward iterator...
+    i++;
+    status = fdb_iterator_next(iterator, &rdoc);
+    TEST_CHK(status != FDB_RESULT_ITERATOR_FAIL);
 
-    // create an iterator on the snapshot for full range
-    fdb_iterator_init(snap_db, &iterator, NULL, 0, NULL, 0, FDB_ITR_NONE);
+    TEST_CHK(!memcmp(rdoc->key, doc[i]->key, rdoc->keylen));
+    TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
+    TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
+
+    fdb_doc_free(rdoc);
+
+    // Again change direction and test reverse iterator..
+    i--;
+    while (1) {
+        status = fdb_iterator_prev(iterator, &rdoc);
 
-    // repeat until fail
-    i=0;
-    count=0;
-    while(1){
-        status = fdb_iterator_next(iterator, &rdoc);
         if (status == FDB_RESULT_ITERATOR_FAIL) break;
 
         TEST_CHK(!memcmp(rdoc->key, doc[i]->key, rdoc->keylen));
@@ -4026,19 +4045,29 @@ void snapshot_test()
         TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
 
         fdb_doc_free(rdoc);
-        i ++;
-        count++;
+        i--;
     }
+    TEST_CHK(i == -1);
 
-    TEST_CHK(count==n/2); // Only unique items from the first half
+    // Reached end - now test forward iterator...
+    i++;
+    while(1){
+        status = fdb_iterator_next(iterator, &rdoc);
+        if (status == FDB_RESULT_ITERATOR_FAIL) break;
+
+        TEST_CHK(!memcmp(rdoc->key, doc[i]->key, rdoc->keylen));
+        TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
+        TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
+
+        fdb_doc_free(rdoc);
+        i++;
+    };
+    TEST_CHK(i==10);
 
     fdb_iterator_close(iterator);
 
-    // close db handle
-    fdb_kvs_close(db);
-    // close snapshot handle
-    fdb_kvs_close(snap_db);
     // close db file
+    fdb_kvs_close(db);
     fdb_close(dbfile);
 
     // free all documents
@@ -4051,27 +4080,25 @@ void snapshot_test()
 
     memleak_end();
 
-    TEST_RESULT("snapshot test");
+    TEST_RESULT("reverse iterator test");
 }
 
-void in_memory_snapshot_test()
+void reverse_sequence_iterator_kvs_test()
 {
-    TEST_INIT();
 
+    TEST_INIT();
     memleak_start();
 
-    int i, r;
-    int n = 20;
-    int count;
+    int i, r, count;
+    int n = 10;
     fdb_file_handle *dbfile;
-    fdb_kvs_handle *db;
-    fdb_kvs_handle *snap_db;
-    fdb_seqnum_t snap_seq;
+    fdb_kvs_handle *kv1, *kv2;
     fdb_doc **doc = alca(fdb_doc*, n);
+    fdb_doc **doc2 = alca(fdb_doc*, n);
     fdb_doc *rdoc;
-    fdb_kvs_info kvs_info;
     fdb_status status;
     fdb_iterator *iterator;
+    fdb_iterator *iterator2;
 
     char keybuf[256], metabuf[256], bodybuf[256];
 
@@ -4086,182 +4113,195 @@ void in_memory_snapshot_test()
     fconfig.flags = FDB_OPEN_FLAG_CREATE;
     fconfig.compaction_threshold = 0;
 
-    // remove previous dummy files
-    r = system(SHELL_DEL" dummy* > errorlog.txt");
-    (void)r;
-
     // open db
-    status = fdb_open(&dbfile, "./dummy1", &fconfig);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
-    status = fdb_kvs_open_default(dbfile, &db, &kvs_config);
+    fdb_open(&dbfile, "./dummy1", &fconfig);
+    fdb_kvs_open_default(dbfile, &kv1, &kvs_config);
+    status = fdb_set_log_callback(kv1, logCallbackFunc,
+                                  (void *) "reverse_sequence_iterator_kvs_test");
     TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-    // Create a snapshot from an empty database file
-    status = fdb_snapshot_open(db, &snap_db, 0);
+    // Create another KV store...
+    status = fdb_kvs_open(dbfile, &kv2, "kv2", &kvs_config);
     TEST_CHK(status == FDB_RESULT_SUCCESS);
-    // check if snapshot's sequence number is zero.
-    fdb_get_kvs_info(snap_db, &kvs_info);
-    TEST_CHK(kvs_info.last_seqnum == 0);
-    // create an iterator on the snapshot for full range
-    fdb_iterator_init(snap_db, &iterator, NULL, 0, NULL, 0, FDB_ITR_NONE);
-    // Iterator should not return any items.
-    status = fdb_iterator_next(iterator, &rdoc);
-    TEST_CHK(status == FDB_RESULT_ITERATOR_FAIL);
-    fdb_iterator_close(iterator);
-    fdb_kvs_close(snap_db);
-
-    // ------- Setup test ----------------------------------
-    // insert documents of 0-4
-    for (i=0; i<n/4; i++){
-        sprintf(keybuf, "key%d", i);
-        sprintf(metabuf, "meta%d", i);
-        sprintf(bodybuf, "body%d", i);
-        fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
-            (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
-        fdb_set(db, doc[i]);
-    }
-
-    // commit with a manual WAL flush (these docs go into HB-trie)
-    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
 
-    // insert documents from 5 - 8
-    for (; i < n/2 - 1; i++){
-        sprintf(keybuf, "key%d", i);
-        sprintf(metabuf, "meta%d", i);
-        sprintf(bodybuf, "body%d", i);
-        fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
+    // to 'kv2' with entire range
+    for (i=0;i<n;++i) {
+        sprintf(keybuf, "kEy%d", i);
+        sprintf(metabuf, "mEta%d", i);
+        sprintf(bodybuf, "bOdy%d", i);
+        fdb_doc_create(&doc2[i], (void*)keybuf, strlen(keybuf),
             (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
-        fdb_set(db, doc[i]);
+        status = fdb_set(kv2, doc2[i]);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
     }
 
-    // We want to create:
-    // |WALFlushHDR|Key-Value1|HDR|Key-Value2|SnapshotHDR|Key-Value1|HDR|
-    // Insert doc 9 with a different value to test duplicate elimination..
-    sprintf(keybuf, "key%d", i);
-    sprintf(metabuf, "meta%d", i);
-    sprintf(bodybuf, "Body%d", i);
-    fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
-            (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
-    fdb_set(db, doc[i]);
-
-    // commit again without a WAL flush (last doc goes into the AVL tree)
-    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
-
-    // Insert doc 9 now again with expected value..
-    *(char *)doc[i]->body = 'b';
-    fdb_set(db, doc[i]);
-
-    // TAKE SNAPSHOT: pick up sequence number of a commit without a WAL flush
-    snap_seq = doc[i]->seqnum;
-
-    // ---------- Snapshot tests begin -----------------------
-    // Initialize an in-memory snapshot Without a Commit...
-    // WAL items are not flushed...
-    status = fdb_snapshot_open(db, &snap_db, FDB_SNAPSHOT_INMEM);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
-
-    // commit again without a WAL flush (these documents go into the AVL trees)
-    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
-
-    // Now re-insert doc 9 as another duplicate (only newer sequence number)
-    fdb_set(db, doc[i]);
-    // commit again without a WAL flush (last doc goes into the AVL tree)
-    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
-
-    // insert documents from 10-14 into HB-trie
-    for (++i; i < (n/2 + n/4); i++){
+    // insert kv1 documents of even number
+    for (i=0;i<n;i+=2) {
         sprintf(keybuf, "key%d", i);
         sprintf(metabuf, "meta%d", i);
         sprintf(bodybuf, "body%d", i);
         fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
             (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
-        fdb_set(db, doc[i]);
+        fdb_set(kv1, doc[i]);
     }
 
-    status = fdb_set_log_callback(db, logCallbackFunc,
-                                  (void *) "in_memory_snapshot_test");
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
-
-    // check snapshot's sequence number
-    fdb_get_kvs_info(snap_db, &kvs_info);
-    TEST_CHK(kvs_info.last_seqnum == snap_seq);
+    // manually flush WAL & commit
+    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
 
-    // insert documents from 15 - 19 on file into the WAL
-    for (; i < n; i++){
+    // insert kv1 documents of odd number
+    for (i=1;i<n;i+=2) {
         sprintf(keybuf, "key%d", i);
         sprintf(metabuf, "meta%d", i);
         sprintf(bodybuf, "body%d", i);
         fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
             (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
-        fdb_set(db, doc[i]);
+        fdb_set(kv1, doc[i]);
     }
-    // commit without a WAL flush (This WAL must not affect snapshot)
+    // commit without WAL flush
     fdb_commit(dbfile, FDB_COMMIT_NORMAL);
 
-    // create an iterator on the snapshot for full range
-    fdb_iterator_init(snap_db, &iterator, NULL, 0, NULL, 0, FDB_ITR_NONE);
-
-    // repeat until fail
+    // iterate even docs on kv1
+    fdb_iterator_sequence_init(kv1, &iterator, 0, 0, FDB_ITR_NONE);
     i=0;
-    count=0;
-    while(1){
+    count = 0;
+    while (1) {
         status = fdb_iterator_next(iterator, &rdoc);
         if (status == FDB_RESULT_ITERATOR_FAIL) break;
-
         TEST_CHK(!memcmp(rdoc->key, doc[i]->key, rdoc->keylen));
         TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
         TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
-
         fdb_doc_free(rdoc);
-        i++;
         count++;
+        if (i + 2 >= n) {
+            break;
+        }
+        i = i + 2; // by-seq, first come even docs, then odd
     }
+    TEST_CHK(count==n/2);
 
-    TEST_CHK(count==n/2); // Only unique items from the first half
-
-    fdb_iterator_close(iterator);
+    // iterate all docs over kv2
+    fdb_iterator_sequence_init(kv2, &iterator2, 0, 0, FDB_ITR_NONE);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    while(1) {
+        status = fdb_iterator_next(iterator2, &rdoc);
+        if (status == FDB_RESULT_ITERATOR_FAIL) {
+            break;
+        }
+        fdb_doc_free(rdoc);
+    }
 
-    // close db handle
-    fdb_kvs_close(db);
-    // close snapshot handle
-    fdb_kvs_close(snap_db);
+    // manually flush WAL & commit
+    // iterators should be unaffected
+    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
 
-    // close db file
-    fdb_close(dbfile);
+    // reverse iterate even docs over kv1
+     i = n - 4;
+    count = 0;
+    while (1) {
+        status = fdb_iterator_prev(iterator, &rdoc);
+        if (status == FDB_RESULT_ITERATOR_FAIL) {
+            break;
+        }
+        TEST_CHK(!memcmp(rdoc->key, doc[i]->key, rdoc->keylen));
+        TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
+        TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
+        fdb_doc_free(rdoc);
+        i-=2;
+        count++;
+    }
+
+    TEST_CHK(count==4);
+    fdb_iterator_close(iterator);
+
+    i = n-1;
+    count = 0;
+    // reverse iterate all docs over kv2
+    while (1) {
+        status = fdb_iterator_prev(iterator2, &rdoc);
+        if (status == FDB_RESULT_ITERATOR_FAIL) {
+            break;
+        }
+        TEST_CHK(!memcmp(rdoc->key, doc2[i]->key, rdoc->keylen));
+        TEST_CHK(!memcmp(rdoc->meta, doc2[i]->meta, rdoc->metalen));
+        TEST_CHK(!memcmp(rdoc->body, doc2[i]->body, rdoc->bodylen));
+        fdb_doc_free(rdoc);
+        i--;
+        count++;
+    }
+    TEST_CHK(count==n);
+    fdb_iterator_close(iterator2);
 
+    // re-open iterator after commit should return all docs for kv1
+    i = 0;
+    count = 0;
+    fdb_iterator_sequence_init(kv1, &iterator, 0, 0, FDB_ITR_NONE);
+    while (1) {
+        status = fdb_iterator_next(iterator, &rdoc);
+        if (status == FDB_RESULT_ITERATOR_FAIL) {
+            break;
+        }
+        TEST_CHK(!memcmp(rdoc->key, doc[i]->key, rdoc->keylen));
+        TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
+        TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
+        fdb_doc_free(rdoc);
+        if (i == 8) {
+            i=1; // switch to odds
+        } else {
+            i+=2;
+        }
+        count++;
+    }
+    TEST_CHK(count==n);
+    fdb_iterator_close(iterator);
 
     // free all documents
-    for (i=0;i<n;++i){
+    for (i=0;i<n;++i) {
         fdb_doc_free(doc[i]);
+        fdb_doc_free(doc2[i]);
     }
 
-    // free all resources
-    fdb_shutdown();
+    fdb_kvs_close(kv1);
+    fdb_kvs_close(kv2);
+    fdb_close(dbfile);
 
+    fdb_shutdown();
     memleak_end();
+    TEST_RESULT("reverse sequence iterator kvs test");
 
-    TEST_RESULT("in-memory snapshot test");
 }
 
-void rollback_test()
+static int _cmp_double(void *key1, size_t keylen1, void *key2, size_t keylen2)
+{
+    double aa, bb;
+    aa = *(double *)key1;
+    bb = *(double *)key2;
+
+    if (aa<bb) {
+        return -1;
+    } else if (aa>bb) {
+        return 1;
+    } else {
+        return 0;
+    }
+}
+
+void custom_compare_primitive_test()
 {
     TEST_INIT();
 
     memleak_start();
 
     int i, r;
-    int n = 20;
-    int count;
-    fdb_file_handle *dbfile, *dbfile_txn;
-    fdb_kvs_handle *db, *db_txn;
-    fdb_seqnum_t rollback_seq;
+    int n = 10;
+    fdb_file_handle *dbfile;
+    fdb_kvs_handle *db;
     fdb_doc **doc = alca(fdb_doc*, n);
     fdb_doc *rdoc;
-    fdb_kvs_info kvs_info;
     fdb_status status;
     fdb_iterator *iterator;
 
-    char keybuf[256], metabuf[256], bodybuf[256];
+    char keybuf[256], bodybuf[256];
+    double key_double, key_double_prev;
 
     // remove previous dummy files
     r = system(SHELL_DEL" dummy* > errorlog.txt");
@@ -4273,130 +4313,261 @@ void rollback_test()
     fconfig.wal_threshold = 1024;
     fconfig.flags = FDB_OPEN_FLAG_CREATE;
     fconfig.compaction_threshold = 0;
+    fconfig.multi_kv_instances = true;
 
-    // remove previous dummy files
-    r = system(SHELL_DEL" dummy* > errorlog.txt");
-    (void)r;
+    kvs_config.custom_cmp = _cmp_double;
 
-    // open db
+    // open db with custom compare function for double key type
     fdb_open(&dbfile, "./dummy1", &fconfig);
     fdb_kvs_open_default(dbfile, &db, &kvs_config);
+    status = fdb_set_log_callback(db, logCallbackFunc,
+                                  (void *) "custom_compare_primitive_test");
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-   // ------- Setup test ----------------------------------
-   // insert documents of 0-4
-    for (i=0; i<n/4; i++){
-        sprintf(keybuf, "key%d", i);
-        sprintf(metabuf, "meta%d", i);
-        sprintf(bodybuf, "body%d", i);
-        fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
-            (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
+    for (i=0;i<n;++i){
+        key_double = 10000/(i*11.0);
+        memcpy(keybuf, &key_double, sizeof(key_double));
+        sprintf(bodybuf, "value: %d, %f", i, key_double);
+        fdb_doc_create(&doc[i], (void*)keybuf, sizeof(key_double), NULL, 0,
+            (void*)bodybuf, strlen(bodybuf)+1);
         fdb_set(db, doc[i]);
     }
 
-    // commit with a manual WAL flush (these docs go into HB-trie)
+    // range scan (before flushing WAL)
+    fdb_iterator_init(db, &iterator, NULL, 0, NULL, 0, 0x0);
+    key_double_prev = -1;
+    while(1){
+        if ( (status = fdb_iterator_next(iterator, &rdoc)) == FDB_RESULT_ITERATOR_FAIL)
+            break;
+        memcpy(&key_double, rdoc->key, rdoc->keylen);
+        TEST_CHK(key_double > key_double_prev);
+        key_double_prev = key_double;
+        fdb_doc_free(rdoc);
+    };
+    fdb_iterator_close(iterator);
+
     fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
 
-    // insert documents from 4 - 9
-    for (; i < n/2; i++){
-        sprintf(keybuf, "key%d", i);
-        sprintf(metabuf, "meta%d", i);
-        sprintf(bodybuf, "body%d", i);
-        fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
-            (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
-        fdb_set(db, doc[i]);
-    }
+    // range scan (after flushing WAL)
+    fdb_iterator_init(db, &iterator, NULL, 0, NULL, 0, 0x0);
+    key_double_prev = -1;
+    while(1){
+        if (fdb_iterator_next(iterator, &rdoc) == FDB_RESULT_ITERATOR_FAIL)
+            break;
+        memcpy(&key_double, rdoc->key, rdoc->keylen);
+        TEST_CHK(key_double > key_double_prev);
+        key_double_prev = key_double;
+        fdb_doc_free(rdoc);
+    };
+    fdb_iterator_close(iterator);
 
-    // commit again without a WAL flush
-    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+    // do compaction
+    fdb_compact(dbfile, (char *) "./dummy2");
 
-    // ROLLBACK POINT: pick up sequence number of a commit without a WAL flush
-    rollback_seq = doc[i-1]->seqnum;
+    // range scan (after compaction)
+    fdb_iterator_init(db, &iterator, NULL, 0, NULL, 0, 0x0);
+    key_double_prev = -1;
+    while(1){
+        if (fdb_iterator_next(iterator, &rdoc) == FDB_RESULT_ITERATOR_FAIL)
+            break;
+        memcpy(&key_double, rdoc->key, rdoc->keylen);
+        TEST_CHK(key_double > key_double_prev);
+        key_double_prev = key_double;
+        fdb_doc_free(rdoc);
+    };
+    fdb_iterator_close(iterator);
 
-    // insert documents from 10-14 into HB-trie
-    for (; i < (n/2 + n/4); i++){
-        sprintf(keybuf, "key%d", i);
-        sprintf(metabuf, "meta%d", i);
-        sprintf(bodybuf, "body%d", i);
-        fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
-            (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
-        fdb_set(db, doc[i]);
-    }
-    // manually flush WAL & commit
-    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
+    // close db file
+    fdb_kvs_close(db);
+    fdb_close(dbfile);
 
-    // insert documents from 15 - 19 on file into the WAL
-    for (; i < n; i++){
-        sprintf(keybuf, "key%d", i);
-        sprintf(metabuf, "meta%d", i);
-        sprintf(bodybuf, "body%d", i);
-        fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
-            (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
-        fdb_set(db, doc[i]);
+    // free all documents
+    for (i=0;i<n;++i){
+        fdb_doc_free(doc[i]);
     }
-    // commit without a WAL flush
-    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
 
-    status = fdb_set_log_callback(db, logCallbackFunc,
-                                  (void *) "rollback_test");
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    // free all resources
+    fdb_shutdown();
 
-    // ---------- Rollback tests begin -----------------------
-    // We have DB file with 5 HB-trie docs, 5 unflushed WAL docs occuring twice
-    // Attempt to rollback to out-of-range marker..
-    status = fdb_rollback(&db, 999999);
-    TEST_CHK(status == FDB_RESULT_NO_DB_INSTANCE);
+    memleak_end();
 
-    // Open another handle & begin transaction
-    fdb_open(&dbfile_txn, "./dummy1", &fconfig);
-    fdb_kvs_open_default(dbfile_txn, &db_txn, &kvs_config);
-    fdb_begin_transaction(dbfile_txn, FDB_ISOLATION_READ_COMMITTED);
-    // Attempt to rollback while the transaction is active
-    status =  fdb_rollback(&db, rollback_seq);
-    // Must fail
-    TEST_CHK(status == FDB_RESULT_FAIL_BY_TRANSACTION);
-    fdb_abort_transaction(dbfile_txn);
-    fdb_kvs_close(db_txn);
-    fdb_close(dbfile_txn);
+    TEST_RESULT("custom compare function for primitive key test");
+}
 
-    // Rollback to saved marker from above
-    status = fdb_rollback(&db, rollback_seq);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
+static int _cmp_variable(void *key1, size_t keylen1, void *key2, size_t keylen2)
+{
+    // compare only 3rd~8th bytes (ignore the others)
+    return memcmp((uint8_t*)key1+2, (uint8_t*)key2+2, 6);
+}
 
-    // check handle's sequence number
-    fdb_get_kvs_info(db, &kvs_info);
-    TEST_CHK(kvs_info.last_seqnum == rollback_seq);
+void custom_compare_variable_test()
+{
+    TEST_INIT();
 
-    // Modify an item and update into the rollbacked file..
-    i = n/2;
-    *(char *)doc[i]->body = 'B';
-    fdb_set(db, doc[i]);
-    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+    memleak_start();
 
-    // create an iterator on the rollback for full range
-    fdb_iterator_sequence_init(db, &iterator, 0, 0, FDB_ITR_NONE);
+    int i, j, r;
+    int n = 1000;
+    uint64_t count;
+    fdb_file_handle *dbfile;
+    fdb_kvs_handle *db, *db2;
+    fdb_doc **doc = alca(fdb_doc*, n);
+    fdb_doc *rdoc;
+    fdb_status status;
+    fdb_iterator *iterator;
 
-    // repeat until fail
-    i=0;
-    count=0;
-    while(1){
-        status = fdb_iterator_next(iterator, &rdoc);
-        if (status == FDB_RESULT_ITERATOR_FAIL) break;
+    size_t keylen = 16;
+    size_t prev_keylen;
+    char keybuf[256], bodybuf[256];
+    char prev_key[256];
 
-        TEST_CHK(!memcmp(rdoc->key, doc[i]->key, rdoc->keylen));
-        TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
+    // remove previous dummy files
+    r = system(SHELL_DEL" dummy* > errorlog.txt");
+    (void)r;
+
+    fdb_config fconfig = fdb_get_default_config();
+    fdb_kvs_config kvs_config = fdb_get_default_kvs_config();
+    fconfig.buffercache_size = 0;
+    fconfig.wal_threshold = 1024;
+    fconfig.flags = FDB_OPEN_FLAG_CREATE;
+    fconfig.compaction_threshold = 0;
+    fconfig.multi_kv_instances = true;
+
+    kvs_config.custom_cmp = _cmp_variable;
+
+    // open db with custom compare function for variable length key type
+    //fdb_open_cmp_variable(&dbfile, "./dummy1", &fconfig);
+    fdb_open(&dbfile, "./dummy1", &fconfig);
+    fdb_kvs_open_default(dbfile, &db, &kvs_config);
+    status = fdb_set_log_callback(db, logCallbackFunc,
+                                  (void *) "custom_compare_variable_test");
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+
+    for (i=0;i<n;++i){
+        for (j=0;j<2;++j){
+            keybuf[j] = 'a' + rand()%('z'-'a');
+        }
+        sprintf(keybuf+2, "%06d", i);
+        for (j=8;j<keylen-1;++j){
+            keybuf[j] = 'a' + rand()%('z'-'a');
+        }
+        keybuf[keylen-1] = 0;
+        sprintf(bodybuf, "value: %d", i);
+        fdb_doc_create(&doc[i], (void*)keybuf, keylen, NULL, 0,
+            (void*)bodybuf, strlen(bodybuf)+1);
+        fdb_set(db, doc[i]);
+    }
+
+    // point query
+    for (i=0;i<n;++i){
+        fdb_doc_create(&rdoc, doc[i]->key, doc[i]->keylen, NULL, 0, NULL, 0);
+        status = fdb_get(db, rdoc);
+
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        TEST_CHK(rdoc->bodylen == doc[i]->bodylen);
         TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
 
         fdb_doc_free(rdoc);
-        i ++;
-        count++;
     }
 
-    TEST_CHK(count==n/2 + 1); // Items from first half and newly set item
+    // range scan (before flushing WAL)
+    fdb_iterator_init(db, &iterator, NULL, 0, NULL, 0, 0x0);
+    sprintf(prev_key, "%016d", 0);
+    count = 0;
+    prev_keylen = 16;
+    while(1){
+        if (fdb_iterator_next(iterator, &rdoc) == FDB_RESULT_ITERATOR_FAIL)
+            break;
+        TEST_CHK(_cmp_variable(prev_key, prev_keylen, rdoc->key, rdoc->keylen) <= 0);
+        prev_keylen = rdoc->keylen;
+        memcpy(prev_key, rdoc->key, rdoc->keylen);
+        fdb_doc_free(rdoc);
+        count++;
+    };
+    TEST_CHK(count == n);
+    fdb_iterator_close(iterator);
+
+    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
+
+    // range scan (after flushing WAL)
+    fdb_iterator_init(db, &iterator, NULL, 0, NULL, 0, 0x0);
+    sprintf(prev_key, "%016d", 0);
+    count = 0;
+    prev_keylen = 16;
+    while(1){
+        if (fdb_iterator_next(iterator, &rdoc) == FDB_RESULT_ITERATOR_FAIL)
+            break;
+        TEST_CHK(_cmp_variable(prev_key, prev_keylen, rdoc->key, rdoc->keylen) <= 0);
+        prev_keylen = rdoc->keylen;
+        memcpy(prev_key, rdoc->key, rdoc->keylen);
+        fdb_doc_free(rdoc);
+        count++;
+    };
+    TEST_CHK(count == n);
+    fdb_iterator_close(iterator);
+
+    // do compaction
+    fdb_compact(dbfile, (char *) "./dummy2");
+
+    // range scan (after compaction)
+    fdb_iterator_init(db, &iterator, NULL, 0, NULL, 0, 0x0);
+    sprintf(prev_key, "%016d", 0);
+    count = 0;
+    prev_keylen = 16;
+    while(1){
+        if (fdb_iterator_next(iterator, &rdoc) == FDB_RESULT_ITERATOR_FAIL)
+            break;
+        TEST_CHK(_cmp_variable(prev_key, prev_keylen, rdoc->key, rdoc->keylen) <= 0);
+        prev_keylen = rdoc->keylen;
+        memcpy(prev_key, rdoc->key, rdoc->keylen);
+        fdb_doc_free(rdoc);
+        count++;
+    };
+    TEST_CHK(count == n);
+    fdb_iterator_close(iterator);
 
+    // range scan by sequence
+    fdb_iterator_sequence_init(db, &iterator, 0, 0, 0x0);
+    count = 0;
+    while(1){ // forward
+        status = fdb_iterator_next(iterator, &rdoc);
+        if (status == FDB_RESULT_ITERATOR_FAIL) {
+            break;
+        }
+        fdb_doc_free(rdoc);
+        count++;
+    };
+    TEST_CHK(count == n);
+    while(1){ // backward
+        status = fdb_iterator_prev(iterator, &rdoc);
+        if (status == FDB_RESULT_ITERATOR_FAIL) {
+            break;
+        }
+        fdb_doc_free(rdoc);
+        count--;
+    };
+    TEST_CHK(count == 0);
     fdb_iterator_close(iterator);
 
+    // open another handle
+    kvs_config.custom_cmp = NULL;
+    fdb_kvs_open_default(dbfile, &db2, &kvs_config);
+
+    // point query
+    for (i=0;i<n;++i){
+        fdb_doc_create(&rdoc, doc[i]->key, doc[i]->keylen, NULL, 0, NULL, 0);
+        status = fdb_get(db2, rdoc);
+
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        TEST_CHK(rdoc->bodylen == doc[i]->bodylen);
+        TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
+
+        fdb_doc_free(rdoc);
+    }
+
     // close db file
     fdb_kvs_close(db);
+    fdb_kvs_close(db2);
     fdb_close(dbfile);
 
     // free all documents
@@ -4409,262 +4580,216 @@ void rollback_test()
 
     memleak_end();
 
-    TEST_RESULT("rollback test");
+    TEST_RESULT("custom compare function for variable length key test");
 }
 
-void rollback_and_snapshot_test()
+void snapshot_test()
 {
     TEST_INIT();
 
     memleak_start();
 
-    fdb_seqnum_t seqnum, rollback_seqnum;
+    int i, r;
+    int n = 20;
+    int count;
+    fdb_file_handle *dbfile;
+    fdb_kvs_handle *db;
+    fdb_kvs_handle *snap_db;
+    fdb_seqnum_t snap_seq;
+    fdb_doc **doc = alca(fdb_doc*, n);
+    fdb_doc *rdoc;
     fdb_kvs_info kvs_info;
     fdb_status status;
-    fdb_config config;
-    fdb_kvs_config kvs_config;
-    fdb_file_handle *dbfile;
-    fdb_kvs_handle *db,  *snapshot;
-    int r;
+    fdb_iterator *iterator;
+
+    char keybuf[256], metabuf[256], bodybuf[256];
 
     // remove previous dummy files
     r = system(SHELL_DEL" dummy* > errorlog.txt");
     (void)r;
 
-    // MB-12530 open db
-    config = fdb_get_default_config();
-    kvs_config = fdb_get_default_kvs_config();
-    status = fdb_open(&dbfile, "dummy", &config);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
-    status = fdb_kvs_open(dbfile, &db, NULL, &kvs_config);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    fdb_config fconfig = fdb_get_default_config();
+    fdb_kvs_config kvs_config = fdb_get_default_kvs_config();
+    fconfig.buffercache_size = 0;
+    fconfig.wal_threshold = 1024;
+    fconfig.flags = FDB_OPEN_FLAG_CREATE;
+    fconfig.compaction_threshold = 0;
 
-    // 2. Create Key 'a' and Commit
-    status = fdb_set_kv(db, (void *) "a", 1, (void *)"val-a", 5);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
-    status = fdb_commit(dbfile, FDB_COMMIT_NORMAL);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    // remove previous dummy files
+    r = system(SHELL_DEL" dummy* > errorlog.txt");
+    (void)r;
 
-    status = fdb_get_kvs_info(db, &kvs_info);
+    // open db
+    status = fdb_open(&dbfile, "./dummy1", &fconfig);
+    fdb_kvs_open_default(dbfile, &db, &kvs_config);
     TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-    // 3. Create Key 'b' and Commit
-    status = fdb_set_kv(db, (void *)"b", 1, (void *)"val-b", 5);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
-    status = fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+    // Create a snapshot from an empty database file
+    status = fdb_snapshot_open(db, &snap_db, 0);
     TEST_CHK(status == FDB_RESULT_SUCCESS);
+    // check if snapshot's sequence number is zero.
+    fdb_get_kvs_info(snap_db, &kvs_info);
+    TEST_CHK(kvs_info.last_seqnum == 0);
+    // create an iterator on the snapshot for full range
+    fdb_iterator_init(snap_db, &iterator, NULL, 0, NULL, 0, FDB_ITR_NONE);
+    // Iterator should not return any items.
+    status = fdb_iterator_next(iterator, &rdoc);
+    TEST_CHK(status == FDB_RESULT_ITERATOR_FAIL);
+    fdb_iterator_close(iterator);
+    fdb_kvs_close(snap_db);
 
-    status = fdb_get_kvs_info(db, &kvs_info);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
-    seqnum = kvs_info.last_seqnum;
+    // ------- Setup test ----------------------------------
+    // insert documents of 0-4
+    for (i=0; i<n/4; i++){
+        sprintf(keybuf, "key%d", i);
+        sprintf(metabuf, "meta%d", i);
+        sprintf(bodybuf, "body%d", i);
+        fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
+            (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
+        fdb_set(db, doc[i]);
+    }
 
-    // 4.  Remember this as our rollback point
-    rollback_seqnum = seqnum;
+    // commit with a manual WAL flush (these docs go into HB-trie)
+    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
 
-    // 5. Create Key 'c' and Commit
-    status = fdb_set_kv(db, (void *)"c", 1,(void *) "val-c", 5);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
-    status = fdb_commit(dbfile, FDB_COMMIT_NORMAL);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    // insert documents from 4 - 8
+    for (; i < n/2 - 1; i++){
+        sprintf(keybuf, "key%d", i);
+        sprintf(metabuf, "meta%d", i);
+        sprintf(bodybuf, "body%d", i);
+        fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
+            (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
+        fdb_set(db, doc[i]);
+    }
 
-    status = fdb_get_kvs_info(db, &kvs_info);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
-
-    // 6. Rollback to rollback point (seq 2)
-    status = fdb_rollback(&db, rollback_seqnum);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
-
-    status = fdb_get_kvs_info(db, &kvs_info);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
-    seqnum = kvs_info.last_seqnum;
-
-    // 7. Verify that Key 'c' is not found
-    void *val;
-    size_t vallen;
-    status = fdb_get_kv(db, (void *)"c", 1, &val, &vallen);
-    TEST_CHK(status == FDB_RESULT_KEY_NOT_FOUND);
-
-    // 8. Open a snapshot at the same point
-    status = fdb_snapshot_open(db, &snapshot, seqnum);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
-
-    // 9. Verify that Key 'c' is not found
-    status = fdb_get_kv(snapshot, (void *)"c", 1, &val, &vallen);
-    TEST_CHK(status == FDB_RESULT_KEY_NOT_FOUND);
-
-    // close the snapshot db
-    fdb_kvs_close(snapshot);
-
-    // close db file
-    fdb_close(dbfile);
-
-    // free all resources
-    fdb_shutdown();
-
-    memleak_end();
-
-    TEST_RESULT("rollback and snapshot test");
-}
-
-void doc_compression_test()
-{
-    TEST_INIT();
-
-    memleak_start();
-
-    int i, r;
-    int n = 10;
-    int dummy_len = 32;
-    fdb_file_handle *dbfile;
-    fdb_kvs_handle *db;
-    fdb_doc **doc = alca(fdb_doc*, n);
-    fdb_doc *rdoc;
-    fdb_status status;
-
-    char keybuf[256], metabuf[256], bodybuf[256], temp[256];
+    // We want to create:
+    // |WALFlushHDR|Key-Value1|HDR|Key-Value2|SnapshotHDR|Key-Value1|HDR|
+    // Insert doc 9 with a different value to test duplicate elimination..
+    sprintf(keybuf, "key%d", i);
+    sprintf(metabuf, "meta%d", i);
+    sprintf(bodybuf, "Body%d", i);
+    fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
+            (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
+    fdb_set(db, doc[i]);
 
-    // remove previous dummy files
-    r = system(SHELL_DEL" dummy* > errorlog.txt");
-    (void)r;
+    // commit again without a WAL flush (last doc goes into the AVL tree)
+    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
 
-    fdb_config fconfig = fdb_get_default_config();
-    fdb_kvs_config kvs_config = fdb_get_default_kvs_config();
-    fconfig.buffercache_size = 0;
-    fconfig.wal_threshold = 1024;
-    fconfig.flags = FDB_OPEN_FLAG_CREATE;
-    fconfig.compress_document_body = true;
-    fconfig.compaction_threshold = 0;
+    // Insert doc 9 now again with expected value..
+    *(char *)doc[i]->body = 'b';
+    fdb_set(db, doc[i]);
+    // commit again without a WAL flush (these documents go into the AVL trees)
+    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
 
-    // open db
-    fdb_open(&dbfile, "./dummy1", &fconfig);
-    fdb_kvs_open_default(dbfile, &db, &kvs_config);
-    status = fdb_set_log_callback(db, logCallbackFunc,
-                                  (void *) "doc_compression_test");
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    // TAKE SNAPSHOT: pick up sequence number of a commit without a WAL flush
+    snap_seq = doc[i]->seqnum;
 
-    // set dummy str
-    memset(temp, 'a', dummy_len);
-    temp[dummy_len]=0;
+    // Now re-insert doc 9 as another duplicate (only newer sequence number)
+    fdb_set(db, doc[i]);
+    // commit again without a WAL flush (last doc goes into the AVL tree)
+    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
 
-    // insert documents
-    for (i=0;i<n;++i){
+    // insert documents from 10-14 into HB-trie
+    for (++i; i < (n/2 + n/4); i++){
         sprintf(keybuf, "key%d", i);
         sprintf(metabuf, "meta%d", i);
-        sprintf(bodybuf, "body%d_%s", i, temp);
+        sprintf(bodybuf, "body%d", i);
         fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
             (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
         fdb_set(db, doc[i]);
     }
+    // manually flush WAL & commit
+    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
 
-    // remove document #5
-    fdb_doc_create(&rdoc, doc[5]->key, doc[5]->keylen, doc[5]->meta, doc[5]->metalen, NULL, 0);
-    status = fdb_del(db, rdoc);
+    status = fdb_set_log_callback(db, logCallbackFunc,
+                                  (void *) "snapshot_test");
     TEST_CHK(status == FDB_RESULT_SUCCESS);
-    fdb_doc_free(rdoc);
-
-    // commit
-    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
-
-    // close the db
-    fdb_kvs_close(db);
-    fdb_close(dbfile);
+    // ---------- Snapshot tests begin -----------------------
+    // Attempt to take snapshot with out-of-range marker..
+    status = fdb_snapshot_open(db, &snap_db, 999999);
+    TEST_CHK(status == FDB_RESULT_NO_DB_INSTANCE);
 
-    // reopen
-    fdb_open(&dbfile, "./dummy1", &fconfig);
-    fdb_kvs_open_default(dbfile, &db, &kvs_config);
-    status = fdb_set_log_callback(db, logCallbackFunc,
-                                  (void *) "doc_compression_test");
+    // Init Snapshot of open file with saved document seqnum as marker
+    status = fdb_snapshot_open(db, &snap_db, snap_seq);
     TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-    // update dummy str
-    dummy_len = 64;
-    memset(temp, 'b', dummy_len);
-    temp[dummy_len]=0;
+    // check snapshot's sequence number
+    fdb_get_kvs_info(snap_db, &kvs_info);
+    TEST_CHK(kvs_info.last_seqnum == snap_seq);
 
-    // update document #0 and #1
-    for (i=0;i<2;++i){
-        sprintf(metabuf, "newmeta%d", i);
-        sprintf(bodybuf, "newbody%d_%s", i, temp);
-        fdb_doc_update(&doc[i], (void *)metabuf, strlen(metabuf),
-            (void *)bodybuf, strlen(bodybuf));
+    // insert documents from 15 - 19 on file into the WAL
+    for (; i < n; i++){
+        sprintf(keybuf, "key%d", i);
+        sprintf(metabuf, "meta%d", i);
+        sprintf(bodybuf, "body%d", i);
+        fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
+            (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
         fdb_set(db, doc[i]);
     }
-
-    // commit
+    // commit without a WAL flush (This WAL must not affect snapshot)
     fdb_commit(dbfile, FDB_COMMIT_NORMAL);
 
-    // retrieve documents
-    for (i=0;i<n;++i){
-        // search by key
-        fdb_doc_create(&rdoc, doc[i]->key, doc[i]->keylen, NULL, 0, NULL, 0);
-        status = fdb_get(db, rdoc);
+    // create an iterator on the snapshot for full range
+    fdb_iterator_init(snap_db, &iterator, NULL, 0, NULL, 0, FDB_ITR_NONE);
 
-        if (i != 5) {
-            // updated documents
-            TEST_CHK(status == FDB_RESULT_SUCCESS);
-            TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
-            TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
-        } else {
-            // removed document
-            TEST_CHK(status == FDB_RESULT_KEY_NOT_FOUND);
-        }
+    // repeat until fail
+    i=0;
+    count=0;
+    while(1){
+        status = fdb_iterator_next(iterator, &rdoc);
+        if (status == FDB_RESULT_ITERATOR_FAIL) break;
+
+        TEST_CHK(!memcmp(rdoc->key, doc[i]->key, rdoc->keylen));
+        TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
+        TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
 
-        // free result document
         fdb_doc_free(rdoc);
+        i ++;
+        count++;
     }
 
-    // do compaction
-    fdb_compact(dbfile, (char *) "./dummy2");
-
-    // retrieve documents after compaction
-    for (i=0;i<n;++i){
-        // search by key
-        fdb_doc_create(&rdoc, doc[i]->key, doc[i]->keylen, NULL, 0, NULL, 0);
-        status = fdb_get(db, rdoc);
+    TEST_CHK(count==n/2); // Only unique items from the first half
 
-        if (i != 5) {
-            // updated documents
-            TEST_CHK(status == FDB_RESULT_SUCCESS);
-            TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
-            TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
-        } else {
-            // removed document
-            TEST_CHK(status == FDB_RESULT_KEY_NOT_FOUND);
-        }
+    fdb_iterator_close(iterator);
 
-        // free result document
-        fdb_doc_free(rdoc);
-    }
+    // close db handle
+    fdb_kvs_close(db);
+    // close snapshot handle
+    fdb_kvs_close(snap_db);
+    // close db file
+    fdb_close(dbfile);
 
     // free all documents
     for (i=0;i<n;++i){
         fdb_doc_free(doc[i]);
     }
 
-    // close db file
-    fdb_kvs_close(db);
-    fdb_close(dbfile);
-
     // free all resources
     fdb_shutdown();
 
     memleak_end();
 
-    TEST_RESULT("document compression test");
+    TEST_RESULT("snapshot test");
 }
 
-void read_doc_by_offset_test()
+void in_memory_snapshot_test()
 {
     TEST_INIT();
+
     memleak_start();
 
     int i, r;
-    int n = 100;
+    int n = 20;
+    int count;
     fdb_file_handle *dbfile;
     fdb_kvs_handle *db;
+    fdb_kvs_handle *snap_db;
+    fdb_seqnum_t snap_seq;
     fdb_doc **doc = alca(fdb_doc*, n);
     fdb_doc *rdoc;
+    fdb_kvs_info kvs_info;
     fdb_status status;
+    fdb_iterator *iterator;
 
     char keybuf[256], metabuf[256], bodybuf[256];
 
@@ -4677,18 +4802,35 @@ void read_doc_by_offset_test()
     fconfig.buffercache_size = 0;
     fconfig.wal_threshold = 1024;
     fconfig.flags = FDB_OPEN_FLAG_CREATE;
-    fconfig.purging_interval = 3600;
     fconfig.compaction_threshold = 0;
 
+    // remove previous dummy files
+    r = system(SHELL_DEL" dummy* > errorlog.txt");
+    (void)r;
+
     // open db
-    fdb_open(&dbfile, "./dummy1", &fconfig);
-    fdb_kvs_open_default(dbfile, &db, &kvs_config);
-    status = fdb_set_log_callback(db, logCallbackFunc,
-                                  (void *) "read_doc_by_offset_test");
+    status = fdb_open(&dbfile, "./dummy1", &fconfig);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    status = fdb_kvs_open_default(dbfile, &db, &kvs_config);
     TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-    // insert documents
-    for (i=0;i<n;++i){
+    // Create a snapshot from an empty database file
+    status = fdb_snapshot_open(db, &snap_db, 0);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    // check if snapshot's sequence number is zero.
+    fdb_get_kvs_info(snap_db, &kvs_info);
+    TEST_CHK(kvs_info.last_seqnum == 0);
+    // create an iterator on the snapshot for full range
+    fdb_iterator_init(snap_db, &iterator, NULL, 0, NULL, 0, FDB_ITR_NONE);
+    // Iterator should not return any items.
+    status = fdb_iterator_next(iterator, &rdoc);
+    TEST_CHK(status == FDB_RESULT_ITERATOR_FAIL);
+    fdb_iterator_close(iterator);
+    fdb_kvs_close(snap_db);
+
+    // ------- Setup test ----------------------------------
+    // insert documents of 0-4
+    for (i=0; i<n/4; i++){
         sprintf(keybuf, "key%d", i);
         sprintf(metabuf, "meta%d", i);
         sprintf(bodybuf, "body%d", i);
@@ -4697,109 +4839,73 @@ void read_doc_by_offset_test()
         fdb_set(db, doc[i]);
     }
 
-    // commit
-    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+    // commit with a manual WAL flush (these docs go into HB-trie)
+    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
 
-    // update documents from #0 to #49
-    for (i=0;i<n/2;++i){
-        sprintf(metabuf, "meta2%d", i);
-        sprintf(bodybuf, "body2%d", i);
-        fdb_doc_update(&doc[i], (void *)metabuf, strlen(metabuf),
-            (void *)bodybuf, strlen(bodybuf));
+    // insert documents from 5 - 8
+    for (; i < n/2 - 1; i++){
+        sprintf(keybuf, "key%d", i);
+        sprintf(metabuf, "meta%d", i);
+        sprintf(bodybuf, "body%d", i);
+        fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
+            (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
         fdb_set(db, doc[i]);
     }
 
-    // remove document #50
-    fdb_doc_create(&rdoc, doc[50]->key, doc[50]->keylen, doc[50]->meta,
-                   doc[50]->metalen, NULL, 0);
-    status = fdb_del(db, rdoc);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
-    fdb_doc_free(rdoc);
+    // We want to create:
+    // |WALFlushHDR|Key-Value1|HDR|Key-Value2|SnapshotHDR|Key-Value1|HDR|
+    // Insert doc 9 with a different value to test duplicate elimination..
+    sprintf(keybuf, "key%d", i);
+    sprintf(metabuf, "meta%d", i);
+    sprintf(bodybuf, "Body%d", i);
+    fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
+            (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
+    fdb_set(db, doc[i]);
 
-    // commit
+    // commit again without a WAL flush (last doc goes into the AVL tree)
     fdb_commit(dbfile, FDB_COMMIT_NORMAL);
 
-    fdb_doc_create(&rdoc, doc[5]->key, doc[5]->keylen, NULL, 0, NULL, 0);
-    status = fdb_get_metaonly(db, rdoc);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
-    TEST_CHK(rdoc->deleted == false);
-    TEST_CHK(!memcmp(rdoc->meta, doc[5]->meta, rdoc->metalen));
-    // Fetch #5 doc using its offset.
-    status = fdb_get_byoffset(db, rdoc);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
-    TEST_CHK(rdoc->deleted == false);
-    TEST_CHK(!memcmp(rdoc->meta, doc[5]->meta, rdoc->metalen));
-    TEST_CHK(!memcmp(rdoc->body, doc[5]->body, rdoc->bodylen));
-    fdb_doc_free(rdoc);
+    // Insert doc 9 now again with expected value..
+    *(char *)doc[i]->body = 'b';
+    fdb_set(db, doc[i]);
 
-    // do compaction
-    fdb_compact(dbfile, (char *) "./dummy2");
+    // TAKE SNAPSHOT: pick up sequence number of a commit without a WAL flush
+    snap_seq = doc[i]->seqnum;
 
-    fdb_doc_create(&rdoc, doc[50]->key, doc[50]->keylen, NULL, 0, NULL, 0);
-    status = fdb_get_metaonly(db, rdoc);
+    // ---------- Snapshot tests begin -----------------------
+    // Initialize an in-memory snapshot Without a Commit...
+    // WAL items are not flushed...
+    status = fdb_snapshot_open(db, &snap_db, FDB_SNAPSHOT_INMEM);
     TEST_CHK(status == FDB_RESULT_SUCCESS);
-    TEST_CHK(rdoc->deleted == true);
-    TEST_CHK(!memcmp(rdoc->meta, doc[50]->meta, rdoc->metalen));
-    // Fetch #50 doc using its offset.
-    status = fdb_get_byoffset(db, rdoc);
-    TEST_CHK(status == FDB_RESULT_KEY_NOT_FOUND);
-    TEST_CHK(rdoc->deleted == true);
-    fdb_doc_free(rdoc);
-
-    // free all documents
-    for (i=0;i<n;++i){
-        fdb_doc_free(doc[i]);
-    }
-
-    // close db file
-    fdb_kvs_close(db);
-    fdb_close(dbfile);
-
-    // free all resources
-    fdb_shutdown();
-
-    memleak_end();
-
-    TEST_RESULT("read_doc_by_offset test");
-}
-
-void purge_logically_deleted_doc_test()
-{
-    TEST_INIT();
-
-    memleak_start();
-
-    int i, r;
-    int n = 10;
-    fdb_file_handle *dbfile;
-    fdb_kvs_handle *db;
-    fdb_doc **doc = alca(fdb_doc*, n);
-    fdb_doc *rdoc;
-    fdb_status status;
 
-    char keybuf[256], metabuf[256], bodybuf[256];
+    // commit again without a WAL flush (these documents go into the AVL trees)
+    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
 
-    // remove previous dummy files
-    r = system(SHELL_DEL" dummy* fdb_test_config.json > errorlog.txt");
-    (void)r;
+    // Now re-insert doc 9 as another duplicate (only newer sequence number)
+    fdb_set(db, doc[i]);
+    // commit again without a WAL flush (last doc goes into the AVL tree)
+    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
 
-    fdb_config fconfig = fdb_get_default_config();
-    fdb_kvs_config kvs_config = fdb_get_default_kvs_config();
-    fconfig.buffercache_size = 0;
-    fconfig.wal_threshold = 1024;
-    fconfig.flags = FDB_OPEN_FLAG_CREATE;
-    fconfig.purging_interval = 2;
-    fconfig.compaction_threshold = 0;
+    // insert documents from 10-14 into HB-trie
+    for (++i; i < (n/2 + n/4); i++){
+        sprintf(keybuf, "key%d", i);
+        sprintf(metabuf, "meta%d", i);
+        sprintf(bodybuf, "body%d", i);
+        fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
+            (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
+        fdb_set(db, doc[i]);
+    }
 
-    // open db
-    fdb_open(&dbfile, "./dummy1", &fconfig);
-    fdb_kvs_open_default(dbfile, &db, &kvs_config);
     status = fdb_set_log_callback(db, logCallbackFunc,
-                                  (void *) "purge_logically_deleted_doc_test");
+                                  (void *) "in_memory_snapshot_test");
     TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-    // insert documents
-    for (i=0;i<n;++i){
+    // check snapshot's sequence number
+    fdb_get_kvs_info(snap_db, &kvs_info);
+    TEST_CHK(kvs_info.last_seqnum == snap_seq);
+
+    // insert documents from 15 - 19 on file into the WAL
+    for (; i < n; i++){
         sprintf(keybuf, "key%d", i);
         sprintf(metabuf, "meta%d", i);
         sprintf(bodybuf, "body%d", i);
@@ -4807,85 +4913,41 @@ void purge_logically_deleted_doc_test()
             (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
         fdb_set(db, doc[i]);
     }
-
-    // remove document #5
-    fdb_doc_create(&rdoc, doc[5]->key, doc[5]->keylen, doc[5]->meta, doc[5]->metalen, NULL, 0);
-    status = fdb_del(db, rdoc);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
-    fdb_doc_free(rdoc);
-
-    // commit
+    // commit without a WAL flush (This WAL must not affect snapshot)
     fdb_commit(dbfile, FDB_COMMIT_NORMAL);
 
-    // do compaction
-    fdb_compact(dbfile, (char *) "./dummy2");
+    // create an iterator on the snapshot for full range
+    fdb_iterator_init(snap_db, &iterator, NULL, 0, NULL, 0, FDB_ITR_NONE);
 
-    // retrieve documents after compaction
-    for (i=0;i<n;++i){
-        // search by key
-        fdb_doc_create(&rdoc, doc[i]->key, doc[i]->keylen, NULL, 0, NULL, 0);
-        status = fdb_get(db, rdoc);
+    // repeat until fail
+    i=0;
+    count=0;
+    while(1){
+        status = fdb_iterator_next(iterator, &rdoc);
+        if (status == FDB_RESULT_ITERATOR_FAIL) break;
 
-        if (i != 5) {
-            // updated documents
-            TEST_CHK(status == FDB_RESULT_SUCCESS);
-            TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
-            TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
-        } else {
-            // removed document
-            TEST_CHK(status == FDB_RESULT_KEY_NOT_FOUND);
-        }
-        // free result document
-        fdb_doc_free(rdoc);
+        TEST_CHK(!memcmp(rdoc->key, doc[i]->key, rdoc->keylen));
+        TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
+        TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
 
-        // retrieve metadata
-        // all documents including logically deleted document should exist
-        fdb_doc_create(&rdoc, doc[i]->key, doc[i]->keylen, NULL, 0, NULL, 0);
-        status = fdb_get_metaonly(db, rdoc);
-        TEST_CHK(status == FDB_RESULT_SUCCESS);
         fdb_doc_free(rdoc);
+        i++;
+        count++;
     }
 
-    printf("wait for 3 seconds..\n");
-    sleep(3);
-
-    // do one more compaction
-    fdb_compact(dbfile, (char *) "./dummy3");
-
-    // retrieve documents after compaction
-    for (i=0;i<n;++i){
-        // search by key
-        fdb_doc_create(&rdoc, doc[i]->key, doc[i]->keylen, NULL, 0, NULL, 0);
-        status = fdb_get(db, rdoc);
+    TEST_CHK(count==n/2); // Only unique items from the first half
 
-        if (i != 5) {
-            // updated documents
-            TEST_CHK(status == FDB_RESULT_SUCCESS);
-            TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
-            TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
-        } else {
-            // removed document
-            TEST_CHK(status == FDB_RESULT_KEY_NOT_FOUND);
-        }
-        // free result document
-        fdb_doc_free(rdoc);
+    fdb_iterator_close(iterator);
 
-        // retrieve metadata
-        fdb_doc_create(&rdoc, doc[i]->key, doc[i]->keylen, NULL, 0, NULL, 0);
-        status = fdb_get_metaonly(db, rdoc);
-        if (i != 5) {
-            TEST_CHK(status == FDB_RESULT_SUCCESS);
-        } else {
-            // logically deletec document must be purged during the compaction
-            TEST_CHK(status == FDB_RESULT_KEY_NOT_FOUND);
-        }
-        fdb_doc_free(rdoc);
-    }
+    // close db handle
+    fdb_kvs_close(db);
+    // close snapshot handle
+    fdb_kvs_close(snap_db);
 
     // close db file
-    fdb_kvs_close(db);
     fdb_close(dbfile);
 
+
     // free all documents
     for (i=0;i<n;++i){
         fdb_doc_free(doc[i]);
@@ -4896,29 +4958,24 @@ void purge_logically_deleted_doc_test()
 
     memleak_end();
 
-    TEST_RESULT("purge logically deleted doc test");
+    TEST_RESULT("in-memory snapshot test");
 }
 
-void compaction_daemon_test(size_t time_sec)
+void in_memory_snapshot_share_test()
 {
     TEST_INIT();
 
     memleak_start();
 
     int i, r;
-    int n = 10000;
-    int compaction_threshold = 30;
-    int escape = 0;
-    fdb_file_handle *dbfile, *dbfile_less, *dbfile_non, *dbfile_manual, *dbfile_new;
-    fdb_kvs_handle *db, *db_less, *db_non, *db_manual;
-    fdb_kvs_handle *snapshot;
-    fdb_doc **doc = alca(fdb_doc*, n);
-    fdb_doc *rdoc;
-    fdb_file_info info;
+    int n = 10;
+    fdb_file_handle *dbfile, *dbfile_txn;
+    fdb_kvs_handle *db, *db_txn;
+    fdb_kvs_handle *snap_db[4];
+    fdb_doc *doc, *rdoc;
     fdb_status status;
-    struct timeval ts_begin, ts_cur, ts_gap;
 
-    char keybuf[256], metabuf[256], bodybuf[256];
+    char keybuf[256], bodybuf[256];
 
     // remove previous dummy files
     r = system(SHELL_DEL" dummy* > errorlog.txt");
@@ -4926,288 +4983,320 @@ void compaction_daemon_test(size_t time_sec)
 
     fdb_config fconfig = fdb_get_default_config();
     fdb_kvs_config kvs_config = fdb_get_default_kvs_config();
-    fconfig.buffercache_size = 0;
     fconfig.wal_threshold = 1024;
     fconfig.flags = FDB_OPEN_FLAG_CREATE;
-    fconfig.compaction_mode = FDB_COMPACTION_AUTO;
-    fconfig.compaction_threshold = compaction_threshold;
-    fconfig.compactor_sleep_duration = 1; // for quick test
+    fconfig.compaction_threshold = 0;
 
     // open db
-    fdb_open(&dbfile, "dummy", &fconfig);
+    fdb_open(&dbfile, "./dummy1", &fconfig);
     fdb_kvs_open_default(dbfile, &db, &kvs_config);
-    status = fdb_set_log_callback(db, logCallbackFunc,
-                                  (void *) "compaction_daemon_test");
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
-    // insert documents
-    printf("Initialize..\n");
+    fdb_open(&dbfile_txn, "./dummy1", &fconfig);
+    fdb_kvs_open_default(dbfile_txn, &db_txn, &kvs_config);
+
+    // keep documents in WAL
     for (i=0;i<n;++i){
-        sprintf(keybuf, "key%04d", i);
-        sprintf(metabuf, "meta%04d", i);
-        sprintf(bodybuf, "body%04d", i);
-        fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf)+1,
-            (void*)metabuf, strlen(metabuf)+1, (void*)bodybuf, strlen(bodybuf)+1);
-        fdb_set(db, doc[i]);
+        sprintf(keybuf, "key%d", i);
+        sprintf(bodybuf, "body%d", i);
+        fdb_doc_create(&doc, (void*)keybuf, strlen(keybuf),
+            NULL, 0, (void*)bodybuf, strlen(bodybuf));
+        fdb_set(db, doc);
+        fdb_doc_free(doc);
     }
-    // commit
     fdb_commit(dbfile, FDB_COMMIT_NORMAL);
-    // close db file
-    fdb_close(dbfile);
 
-    // ---- basic retrieve test ------------------------
-    // reopen db file
-    status = fdb_open(&dbfile, "dummy", &fconfig);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
-    status = fdb_kvs_open_default(dbfile, &db, &kvs_config);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
-    status = fdb_set_log_callback(db, logCallbackFunc,
-                                  (void *) "compaction_daemon_test");
+    // two snapshots on the same WAL
+    status = fdb_snapshot_open(db, &snap_db[0], FDB_SNAPSHOT_INMEM);
     TEST_CHK(status == FDB_RESULT_SUCCESS);
-    // check db filename
-    fdb_get_file_info(dbfile, &info);
-    TEST_CHK(!strcmp(info.filename, "dummy"));
-
-    // retrieve documents
-    for (i=0;i<n;++i){
-        sprintf(keybuf, "key%04d", i);
-        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf)+1,
-            NULL, 0, NULL, 0);
-        status = fdb_get(db, rdoc);
-        //printf("%s %s\n", rdoc->key, rdoc->body);
-        TEST_CHK(status == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
-        fdb_doc_free(rdoc);
-    }
-
-    // create a snapshot
-    status = fdb_snapshot_open(db, &snapshot, n);
+    status = fdb_snapshot_open(db, &snap_db[1], FDB_SNAPSHOT_INMEM);
     TEST_CHK(status == FDB_RESULT_SUCCESS);
-    // close snapshot
-    fdb_kvs_close(snapshot);
-
-    // close db file
-    fdb_close(dbfile);
 
-    // ---- handling when metafile is removed ------------
-    // remove meta file
-    r = system(SHELL_DEL" dummy.meta > errorlog.txt");
-    (void)r;
-    // reopen db file
-    status = fdb_open(&dbfile, "dummy", &fconfig);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
-    status = fdb_kvs_open_default(dbfile, &db, &kvs_config);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
-    status = fdb_set_log_callback(db, logCallbackFunc,
-                                  (void *) "compaction_daemon_test");
+    // update a document after the snapshots are taken
+    fdb_doc_create(&doc, (void*)"key0", 4, NULL, 0, (void*)"updated", 7);
+    fdb_set(db, doc);
+    fdb_doc_free(doc);
+    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+    status = fdb_snapshot_open(db, &snap_db[2], FDB_SNAPSHOT_INMEM);
     TEST_CHK(status == FDB_RESULT_SUCCESS);
-    // retrieve documents
-    for (i=0;i<n;++i){
-        sprintf(keybuf, "key%04d", i);
-        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf)+1,
-            NULL, 0, NULL, 0);
-        status = fdb_get(db, rdoc);
-        //printf("%s %s\n", rdoc->key, rdoc->body);
-        TEST_CHK(status == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
-        fdb_doc_free(rdoc);
-    }
-    // close db file
-    fdb_close(dbfile);
 
-    // ---- handling when metafile points to non-exist file ------------
-    // remove meta file
-    r = system(SHELL_MOVE" dummy.0 dummy.23 > errorlog.txt");
-    (void)r;
-    // reopen db file
-    status = fdb_open(&dbfile, "dummy", &fconfig);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
-    status = fdb_kvs_open_default(dbfile, &db, &kvs_config);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
-    status = fdb_set_log_callback(db, logCallbackFunc,
-                                  (void *) "compaction_daemon_test");
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
-    // retrieve documents
+    // the first snapshot is closed while the second one is still alive
+    fdb_kvs_close(snap_db[0]);
     for (i=0;i<n;++i){
-        sprintf(keybuf, "key%04d", i);
-        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf)+1,
-            NULL, 0, NULL, 0);
-        status = fdb_get(db, rdoc);
-        //printf("%s %s\n", rdoc->key, rdoc->body);
+        sprintf(keybuf, "key%d", i);
+        sprintf(bodybuf, "body%d", i);
+        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf), NULL, 0, NULL, 0);
+        status = fdb_get(snap_db[1], rdoc);
         TEST_CHK(status == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
+        TEST_CHK(!memcmp(rdoc->body, bodybuf, rdoc->bodylen));
         fdb_doc_free(rdoc);
     }
-    // close db file
-    fdb_close(dbfile);
-
-    // ---- compaction daemon test -------------------
-    // db: DB instance to be compacted
-    // db_less: DB instance to be compacted but with much lower update throughput
-    // db_non: DB instance not to be compacted (auto compaction with threshold = 0)
-    // db_manual: DB instance not to be compacted (manual compaction)
-
-    // open & create db_less, db_non and db_manual
-    status = fdb_open(&dbfile_less, "dummy_less", &fconfig);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
-    status = fdb_kvs_open_default(dbfile_less, &db_less, &kvs_config);
+    // the snapshot taken after the update sees the new value
+    fdb_doc_create(&rdoc, (void*)"key0", 4, NULL, 0, NULL, 0);
+    status = fdb_get(snap_db[2], rdoc);
     TEST_CHK(status == FDB_RESULT_SUCCESS);
+    TEST_CHK(rdoc->bodylen == 7 && !memcmp(rdoc->body, "updated", 7));
+    fdb_doc_free(rdoc);
 
-    fconfig.compaction_threshold = 0;
-    status = fdb_open(&dbfile_non, "dummy_non", &fconfig);
+    // uncommitted documents in a transaction are visible only to
+    // the snapshot of the transaction
+    fdb_begin_transaction(dbfile_txn, FDB_ISOLATION_READ_COMMITTED);
+    fdb_doc_create(&doc, (void*)"key_txn", 7, NULL, 0, (void*)"txn", 3);
+    fdb_set(db_txn, doc);
+    fdb_doc_free(doc);
+    status = fdb_snapshot_open(db_txn, &snap_db[3], FDB_SNAPSHOT_INMEM);
     TEST_CHK(status == FDB_RESULT_SUCCESS);
-    status = fdb_kvs_open_default(dbfile_non, &db_non, &kvs_config);
+    fdb_doc_create(&rdoc, (void*)"key_txn", 7, NULL, 0, NULL, 0);
+    status = fdb_get(snap_db[3], rdoc);
     TEST_CHK(status == FDB_RESULT_SUCCESS);
+    fdb_doc_free(rdoc);
+    fdb_kvs_close(snap_db[3]);
 
-    fconfig.compaction_mode = FDB_COMPACTION_MANUAL;
-    status = fdb_open(&dbfile_manual, "dummy_manual", &fconfig);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
-    status = fdb_kvs_open_default(dbfile_manual, &db_manual, &kvs_config);
+    status = fdb_snapshot_open(db, &snap_db[3], FDB_SNAPSHOT_INMEM);
     TEST_CHK(status == FDB_RESULT_SUCCESS);
+    fdb_doc_create(&rdoc, (void*)"key_txn", 7, NULL, 0, NULL, 0);
+    status = fdb_get(snap_db[3], rdoc);
+    TEST_CHK(status != FDB_RESULT_SUCCESS);
+    fdb_doc_free(rdoc);
+    fdb_kvs_close(snap_db[3]);
+    fdb_abort_transaction(dbfile_txn);
+    fdb_kvs_close(snap_db[1]);
+    fdb_kvs_close(snap_db[2]);
 
-    // reopen db file
-    fconfig.compaction_threshold = 30;
-    fconfig.compaction_mode = FDB_COMPACTION_AUTO;
-    status = fdb_open(&dbfile, "dummy", &fconfig);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
-    status = fdb_kvs_open_default(dbfile, &db, &kvs_config);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
-    status = fdb_set_log_callback(db, logCallbackFunc,
-                                  (void *) "compaction_daemon_test");
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
-    // continuously update documents
-    printf("wait for %d seconds..\n", (int)time_sec);
-    gettimeofday(&ts_begin, NULL);
-    while(!escape) {
-        for (i=0;i<n;++i){
-            // update db
-            fdb_set(db, doc[i]);
+    // writes interleaved with snapshot opens: each snapshot sees exactly
+    // the documents written before it, while all of them share the same
+    // WAL entries updated by the writes and commits in the meantime
+    fdb_begin_transaction(dbfile_txn, FDB_ISOLATION_READ_COMMITTED);
+    for (r=0;r<3;++r){
+        sprintf(keybuf, "key_w%d", r);
+        fdb_doc_create(&doc, (void*)keybuf, strlen(keybuf),
+            NULL, 0, (void*)keybuf, strlen(keybuf));
+        fdb_set(db, doc);
+        fdb_set(db_txn, doc);
+        fdb_doc_free(doc);
+        status = fdb_snapshot_open(db, &snap_db[r], FDB_SNAPSHOT_INMEM);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        if (r == 1) {
             fdb_commit(dbfile, FDB_COMMIT_NORMAL);
-
-            // update db_less (1/100 throughput)
-            if (i%100 == 0){
-                fdb_set(db_less, doc[i]);
-                fdb_commit(dbfile_less, FDB_COMMIT_NORMAL);
+        }
+    }
+    // overwrite a document seen by all the snapshots
+    fdb_doc_create(&doc, (void*)"key_w0", 6, NULL, 0, (void*)"new", 3);
+    fdb_set(db, doc);
+    fdb_doc_free(doc);
+    status = fdb_snapshot_open(db, &snap_db[3], FDB_SNAPSHOT_INMEM);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    for (r=0;r<3;++r){
+        for (i=0;i<3;++i){
+            sprintf(keybuf, "key_w%d", i);
+            fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf),
+                           NULL, 0, NULL, 0);
+            status = fdb_get(snap_db[r], rdoc);
+            if (i <= r) {
+                TEST_CHK(status == FDB_RESULT_SUCCESS);
+                TEST_CHK(!memcmp(rdoc->body, keybuf, rdoc->bodylen));
+            } else {
+                TEST_CHK(status != FDB_RESULT_SUCCESS);
             }
-
-            // update db_non
-            fdb_set(db_non, doc[i]);
-            fdb_commit(dbfile_non, FDB_COMMIT_NORMAL);
-
-            // update db_manual
-            fdb_set(db_manual, doc[i]);
-            fdb_commit(dbfile_manual, FDB_COMMIT_NORMAL);
-
-            gettimeofday(&ts_cur, NULL);
-            ts_gap = _utime_gap(ts_begin, ts_cur);
-            if (ts_gap.tv_sec >= time_sec) {
-                escape = 1;
+            fdb_doc_free(rdoc);
+        }
+        // sequence iteration returns the versions visible to the snapshot
+        fdb_iterator *iterator;
+        status = fdb_iterator_sequence_init(snap_db[r], &iterator, 0, 0,
+                                            FDB_ITR_NONE);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        i = 0;
+        while (1) {
+            status = fdb_iterator_next(iterator, &rdoc);
+            if (status != FDB_RESULT_SUCCESS) {
                 break;
             }
+            if (!strncmp((char *)rdoc->key, "key_w", 5)) {
+                TEST_CHK(rdoc->bodylen == rdoc->keylen);
+                TEST_CHK(!memcmp(rdoc->body, rdoc->key, rdoc->keylen));
+                i++;
+            }
+            fdb_doc_free(rdoc);
         }
+        TEST_CHK(i == r + 1);
+        fdb_iterator_close(iterator);
+        fdb_kvs_close(snap_db[r]);
     }
-
-    // perform manual compaction of auto-compact file
-    status = fdb_compact(dbfile_non, NULL);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
-
-    // perform manual compaction of manual-compact file
-    status = fdb_compact(dbfile_manual, "dummy_manual_compacted");
+    fdb_doc_create(&rdoc, (void*)"key_w0", 6, NULL, 0, NULL, 0);
+    status = fdb_get(snap_db[3], rdoc);
     TEST_CHK(status == FDB_RESULT_SUCCESS);
+    TEST_CHK(rdoc->bodylen == 3 && !memcmp(rdoc->body, "new", 3));
+    fdb_doc_free(rdoc);
+    fdb_kvs_close(snap_db[3]);
+    fdb_abort_transaction(dbfile_txn);
 
-    // open dummy_manual_compacted using new db handle
-    fconfig.compaction_mode = FDB_COMPACTION_MANUAL;
-    status = fdb_open(&dbfile_new, "dummy_manual_compacted", &fconfig);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    // close db file
+    fdb_kvs_close(db);
+    fdb_kvs_close(db_txn);
+    fdb_close(dbfile);
+    fdb_close(dbfile_txn);
 
-    // try to switch compaction mode
-    status = fdb_switch_compaction_mode(dbfile_manual, FDB_COMPACTION_AUTO, 30);
-    TEST_CHK(status == FDB_RESULT_FILE_IS_BUSY);
+    // free all resources
+    fdb_shutdown();
 
-    // close db_new
-    status = fdb_close(dbfile_new);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    memleak_end();
 
-    // switch compaction mode of 'db_manual' from MANUAL to AUTO
-    status = fdb_switch_compaction_mode(dbfile_manual, FDB_COMPACTION_AUTO, 30);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    TEST_RESULT("in-memory snapshot share test");
+}
 
-    // close and open with auto-compact option
-    status = fdb_close(dbfile_manual);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
-    fconfig.compaction_mode = FDB_COMPACTION_AUTO;
-    status = fdb_open(&dbfile_manual, "dummy_manual_compacted", &fconfig);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
+void rollback_test()
+{
+    TEST_INIT();
 
-    // switch compaction mode of 'db_non' from AUTO to MANUAL
-    status = fdb_switch_compaction_mode(dbfile_non, FDB_COMPACTION_MANUAL, 0);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    memleak_start();
 
-    // close and open with manual-compact option
-    status = fdb_close(dbfile_non);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
-    fconfig.compaction_mode = FDB_COMPACTION_MANUAL;
-    status = fdb_open(&dbfile_non, "dummy_non", &fconfig);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    int i, r;
+    int n = 20;
+    int count;
+    fdb_file_handle *dbfile, *dbfile_txn;
+    fdb_kvs_handle *db, *db_txn;
+    fdb_seqnum_t rollback_seq;
+    fdb_doc **doc = alca(fdb_doc*, n);
+    fdb_doc *rdoc;
+    fdb_kvs_info kvs_info;
+    fdb_status status;
+    fdb_iterator *iterator;
 
-    // Now perform one manual compaction on dummy_non
-    fdb_compact(dbfile_non, "dummy_non.manual");
+    char keybuf[256], metabuf[256], bodybuf[256];
 
-    // close all db files except dummy_non
-    fdb_close(dbfile);
-    fdb_close(dbfile_less);
-    fdb_close(dbfile_manual);
+    // remove previous dummy files
+    r = system(SHELL_DEL" dummy* > errorlog.txt");
+    (void)r;
 
-    // open manual compact file (dummy_non) using auto compact mode
-    fconfig.compaction_mode = FDB_COMPACTION_AUTO;
-    status = fdb_open(&dbfile, "dummy_non.manual", &fconfig);
-    TEST_CHK(status == FDB_RESULT_INVALID_COMPACTION_MODE);
+    fdb_config fconfig = fdb_get_default_config();
+    fdb_kvs_config kvs_config = fdb_get_default_kvs_config();
+    fconfig.buffercache_size = 0;
+    fconfig.wal_threshold = 1024;
+    fconfig.flags = FDB_OPEN_FLAG_CREATE;
+    fconfig.compaction_threshold = 0;
 
-    // Attempt to destroy manual compact file using auto compact mode
-    status = fdb_destroy("dummy_non.manual", &fconfig);
-    TEST_CHK(status == FDB_RESULT_INVALID_COMPACTION_MODE);
+    // remove previous dummy files
+    r = system(SHELL_DEL" dummy* > errorlog.txt");
+    (void)r;
 
-    // open auto copmact file (dummy_manual_compacted) using manual compact mode
-    fconfig.compaction_mode = FDB_COMPACTION_MANUAL;
-    status = fdb_open(&dbfile, "dummy_manual_compacted", &fconfig);
-    TEST_CHK(status == FDB_RESULT_INVALID_COMPACTION_MODE);
+    // open db
+    fdb_open(&dbfile, "./dummy1", &fconfig);
+    fdb_kvs_open_default(dbfile, &db, &kvs_config);
 
-    // Attempt to destroy auto copmact file using manual compact mode
-    status = fdb_destroy("dummy_manual_compacted", &fconfig);
-    TEST_CHK(status == FDB_RESULT_INVALID_COMPACTION_MODE);
+   // ------- Setup test ----------------------------------
+   // insert documents of 0-4
+    for (i=0; i<n/4; i++){
+        sprintf(keybuf, "key%d", i);
+        sprintf(metabuf, "meta%d", i);
+        sprintf(bodybuf, "body%d", i);
+        fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
+            (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
+        fdb_set(db, doc[i]);
+    }
 
-    // DESTROY auto copmact file with correct mode
-    fconfig.compaction_mode = FDB_COMPACTION_AUTO;
-    status = fdb_destroy("dummy_manual_compacted", &fconfig);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    // commit with a manual WAL flush (these docs go into HB-trie)
+    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
 
-    // DESTROY manual compacted file with past version open!
-    fconfig.compaction_mode = FDB_COMPACTION_MANUAL;
-    status = fdb_destroy("dummy_non.manual", &fconfig);
-    TEST_CHK(status == FDB_RESULT_FILE_IS_BUSY);
+    // insert documents from 4 - 9
+    for (; i < n/2; i++){
+        sprintf(keybuf, "key%d", i);
+        sprintf(metabuf, "meta%d", i);
+        sprintf(bodybuf, "body%d", i);
+        fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
+            (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
+        fdb_set(db, doc[i]);
+    }
 
-    // Simulate a database crash by doing a premature shutdown
-    // Note that db_non was never closed properly
-    status = fdb_shutdown();
+    // commit again without a WAL flush
+    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+
+    // ROLLBACK POINT: pick up sequence number of a commit without a WAL flush
+    rollback_seq = doc[i-1]->seqnum;
+
+    // insert documents from 10-14 into HB-trie
+    for (; i < (n/2 + n/4); i++){
+        sprintf(keybuf, "key%d", i);
+        sprintf(metabuf, "meta%d", i);
+        sprintf(bodybuf, "body%d", i);
+        fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
+            (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
+        fdb_set(db, doc[i]);
+    }
+    // manually flush WAL & commit
+    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
+
+    // insert documents from 15 - 19 on file into the WAL
+    for (; i < n; i++){
+        sprintf(keybuf, "key%d", i);
+        sprintf(metabuf, "meta%d", i);
+        sprintf(bodybuf, "body%d", i);
+        fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
+            (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
+        fdb_set(db, doc[i]);
+    }
+    // commit without a WAL flush
+    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+
+    status = fdb_set_log_callback(db, logCallbackFunc,
+                                  (void *) "rollback_test");
     TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-    status = fdb_destroy("dummy_non.manual", &fconfig);
+    // ---------- Rollback tests begin -----------------------
+    // We have DB file with 5 HB-trie docs, 5 unflushed WAL docs occuring twice
+    // Attempt to rollback to out-of-range marker..
+    status = fdb_rollback(&db, 999999);
+    TEST_CHK(status == FDB_RESULT_NO_DB_INSTANCE);
+
+    // Open another handle & begin transaction
+    fdb_open(&dbfile_txn, "./dummy1", &fconfig);
+    fdb_kvs_open_default(dbfile_txn, &db_txn, &kvs_config);
+    fdb_begin_transaction(dbfile_txn, FDB_ISOLATION_READ_COMMITTED);
+    // Attempt to rollback while the transaction is active
+    status =  fdb_rollback(&db, rollback_seq);
+    // Must fail
+    TEST_CHK(status == FDB_RESULT_FAIL_BY_TRANSACTION);
+    fdb_abort_transaction(dbfile_txn);
+    fdb_kvs_close(db_txn);
+    fdb_close(dbfile_txn);
+
+    // Rollback to saved marker from above
+    status = fdb_rollback(&db, rollback_seq);
     TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-    // Attempt to read-only auto compacted and destroyed file
-    fconfig.flags = FDB_OPEN_FLAG_RDONLY;
-    status = fdb_open(&dbfile, "./dummy_manual_compacted", &fconfig);
-    TEST_CHK(status == FDB_RESULT_NO_SUCH_FILE);
+    // check handle's sequence number
+    fdb_get_kvs_info(db, &kvs_info);
+    TEST_CHK(kvs_info.last_seqnum == rollback_seq);
 
-    status = fdb_open(&dbfile, "./dummy_manual_compacted.meta", &fconfig);
-    TEST_CHK(status == FDB_RESULT_NO_SUCH_FILE);
+    // Modify an item and update into the rollbacked file..
+    i = n/2;
+    *(char *)doc[i]->body = 'B';
+    fdb_set(db, doc[i]);
+    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
 
-    // Attempt to read-only past version of manually compacted destroyed file
-    status = fdb_open(&dbfile, "dummy_non", &fconfig);
-    TEST_CHK(status == FDB_RESULT_NO_SUCH_FILE);
+    // create an iterator on the rollback for full range
+    fdb_iterator_sequence_init(db, &iterator, 0, 0, FDB_ITR_NONE);
 
-    // Attempt to read-only current version of manually compacted destroyed file
-    status = fdb_open(&dbfile, "dummy_non.manual", &fconfig);
-    TEST_CHK(status == FDB_RESULT_NO_SUCH_FILE);
+    // repeat until fail
+    i=0;
+    count=0;
+    while(1){
+        status = fdb_iterator_next(iterator, &rdoc);
+        if (status == FDB_RESULT_ITERATOR_FAIL) break;
+
+        TEST_CHK(!memcmp(rdoc->key, doc[i]->key, rdoc->keylen));
+        TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
+        TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
+
+        fdb_doc_free(rdoc);
+        i ++;
+        count++;
+    }
+
+    TEST_CHK(count==n/2 + 1); // Items from first half and newly set item
+
+    fdb_iterator_close(iterator);
+
+    // close db file
+    fdb_kvs_close(db);
+    fdb_close(dbfile);
 
     // free all documents
     for (i=0;i<n;++i){
@@ -5219,91 +5308,93 @@ void compaction_daemon_test(size_t time_sec)
 
     memleak_end();
 
-    TEST_RESULT("compaction daemon test");
+    TEST_RESULT("rollback test");
 }
 
-void api_wrapper_test()
+void rollback_and_snapshot_test()
 {
     TEST_INIT();
 
     memleak_start();
 
-    int i, r;
-    int n = 10;
-    size_t valuelen;
-    void *value;
-    fdb_file_handle *dbfile;
-    fdb_kvs_handle *db;
+    fdb_seqnum_t seqnum, rollback_seqnum;
+    fdb_kvs_info kvs_info;
     fdb_status status;
-
-    char keybuf[256], bodybuf[256], temp[256];
+    fdb_config config;
+    fdb_kvs_config kvs_config;
+    fdb_file_handle *dbfile;
+    fdb_kvs_handle *db,  *snapshot;
+    int r;
 
     // remove previous dummy files
     r = system(SHELL_DEL" dummy* > errorlog.txt");
     (void)r;
 
-    fdb_config fconfig = fdb_get_default_config();
-    fdb_kvs_config kvs_config = fdb_get_default_kvs_config();
-    fconfig.buffercache_size = 0;
-    fconfig.wal_threshold = 1024;
-    fconfig.flags = FDB_OPEN_FLAG_CREATE;
-    fconfig.purging_interval = 0;
-    fconfig.compaction_threshold = 0;
+    // MB-12530 open db
+    config = fdb_get_default_config();
+    kvs_config = fdb_get_default_kvs_config();
+    status = fdb_open(&dbfile, "dummy", &config);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    status = fdb_kvs_open(dbfile, &db, NULL, &kvs_config);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-    // open db
-    fdb_open(&dbfile, "./dummy1", &fconfig);
-    fdb_kvs_open_default(dbfile, &db, &kvs_config);
-    status = fdb_set_log_callback(db, logCallbackFunc,
-                                  (void *) "api_wrapper_test");
+    // 2. Create Key 'a' and Commit
+    status = fdb_set_kv(db, (void *) "a", 1, (void *)"val-a", 5);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    status = fdb_commit(dbfile, FDB_COMMIT_NORMAL);
     TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-    // error check
-    status = fdb_set_kv(db, NULL, 0, NULL, 0);
-    TEST_CHK(status == FDB_RESULT_INVALID_ARGS);
+    status = fdb_get_kvs_info(db, &kvs_info);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-    // insert key-value pairs
-    for (i=0;i<n;++i){
-        sprintf(keybuf, "key%d", i);
-        sprintf(bodybuf, "body%d", i);
-        status = fdb_set_kv(db, keybuf, strlen(keybuf), bodybuf, strlen(bodybuf));
-        TEST_CHK(status == FDB_RESULT_SUCCESS);
-    }
+    // 3. Create Key 'b' and Commit
+    status = fdb_set_kv(db, (void *)"b", 1, (void *)"val-b", 5);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    status = fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-    // remove key5
-    sprintf(keybuf, "key%d", 5);
-    status = fdb_del_kv(db, keybuf, strlen(keybuf));
+    status = fdb_get_kvs_info(db, &kvs_info);
     TEST_CHK(status == FDB_RESULT_SUCCESS);
+    seqnum = kvs_info.last_seqnum;
 
-    // error check
-    status = fdb_del_kv(db, NULL, 0);
-    TEST_CHK(status == FDB_RESULT_INVALID_ARGS);
+    // 4.  Remember this as our rollback point
+    rollback_seqnum = seqnum;
 
-    // retrieve key-value pairs
-    for (i=0;i<n;++i){
-        sprintf(keybuf, "key%d", i);
-        status = fdb_get_kv(db, keybuf, strlen(keybuf), &value, &valuelen);
+    // 5. Create Key 'c' and Commit
+    status = fdb_set_kv(db, (void *)"c", 1,(void *) "val-c", 5);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    status = fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-        if (i != 5) {
-            // updated documents
-            TEST_CHK(status == FDB_RESULT_SUCCESS);
-            sprintf(temp, "body%d", i);
-            TEST_CHK(!memcmp(value, temp, valuelen));
-            free(value);
-        } else {
-            // removed document
-            TEST_CHK(status == FDB_RESULT_KEY_NOT_FOUND);
-        }
-    }
+    status = fdb_get_kvs_info(db, &kvs_info);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-    // error check
-    status = fdb_get_kv(db, NULL, 0, &value, &valuelen);
-    TEST_CHK(status == FDB_RESULT_INVALID_ARGS);
+    // 6. Rollback to rollback point (seq 2)
+    status = fdb_rollback(&db, rollback_seqnum);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-    status = fdb_get_kv(db, keybuf, strlen(keybuf), NULL, NULL);
-    TEST_CHK(status == FDB_RESULT_INVALID_ARGS);
+    status = fdb_get_kvs_info(db, &kvs_info);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    seqnum = kvs_info.last_seqnum;
+
+    // 7. Verify that Key 'c' is not found
+    void *val;
+    size_t vallen;
+    status = fdb_get_kv(db, (void *)"c", 1, &val, &vallen);
+    TEST_CHK(status == FDB_RESULT_KEY_NOT_FOUND);
+
+    // 8. Open a snapshot at the same point
+    status = fdb_snapshot_open(db, &snapshot, seqnum);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+
+    // 9. Verify that Key 'c' is not found
+    status = fdb_get_kv(snapshot, (void *)"c", 1, &val, &vallen);
+    TEST_CHK(status == FDB_RESULT_KEY_NOT_FOUND);
+
+    // close the snapshot db
+    fdb_kvs_close(snapshot);
 
     // close db file
-    fdb_kvs_close(db);
     fdb_close(dbfile);
 
     // free all resources
@@ -5311,10 +5402,10 @@ void api_wrapper_test()
 
     memleak_end();
 
-    TEST_RESULT("API wrapper test");
+    TEST_RESULT("rollback and snapshot test");
 }
 
-void transaction_test()
+void doc_compression_test()
 {
     TEST_INIT();
 
@@ -5322,13 +5413,14 @@ void transaction_test()
 
     int i, r;
     int n = 10;
-    fdb_file_handle *dbfile, *dbfile_txn1, *dbfile_txn2, *dbfile_txn3;
-    fdb_kvs_handle *db, *db_txn1, *db_txn2, *db_txn3;
+    int dummy_len = 32;
+    fdb_file_handle *dbfile;
+    fdb_kvs_handle *db;
     fdb_doc **doc = alca(fdb_doc*, n);
     fdb_doc *rdoc;
     fdb_status status;
 
-    char keybuf[256], metabuf[256], bodybuf[256];
+    char keybuf[256], metabuf[256], bodybuf[256], temp[256];
 
     // remove previous dummy files
     r = system(SHELL_DEL" dummy* > errorlog.txt");
@@ -5339,299 +5431,359 @@ void transaction_test()
     fconfig.buffercache_size = 0;
     fconfig.wal_threshold = 1024;
     fconfig.flags = FDB_OPEN_FLAG_CREATE;
-    fconfig.purging_interval = 0;
+    fconfig.compress_document_body = true;
     fconfig.compaction_threshold = 0;
 
     // open db
-    fdb_open(&dbfile, "dummy1", &fconfig);
+    fdb_open(&dbfile, "./dummy1", &fconfig);
     fdb_kvs_open_default(dbfile, &db, &kvs_config);
     status = fdb_set_log_callback(db, logCallbackFunc,
-                                  (void *) "transaction_test");
+                                  (void *) "doc_compression_test");
     TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-    // open db and begin transactions
-    fdb_open(&dbfile_txn1, "dummy1", &fconfig);
-    fdb_open(&dbfile_txn2, "dummy1", &fconfig);
-    fdb_kvs_open_default(dbfile_txn1, &db_txn1, &kvs_config);
-    fdb_kvs_open_default(dbfile_txn2, &db_txn2, &kvs_config);
-    fdb_begin_transaction(dbfile_txn1, FDB_ISOLATION_READ_COMMITTED);
-    fdb_begin_transaction(dbfile_txn2, FDB_ISOLATION_READ_COMMITTED);
+    // set dummy str
+    memset(temp, 'a', dummy_len);
+    temp[dummy_len]=0;
 
-    // insert half docs into txn1
-    for (i=0;i<n/2;++i){
+    // insert documents
+    for (i=0;i<n;++i){
         sprintf(keybuf, "key%d", i);
         sprintf(metabuf, "meta%d", i);
-        sprintf(bodybuf, "body%d", i);
+        sprintf(bodybuf, "body%d_%s", i, temp);
         fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
-                                (void*)metabuf, strlen(metabuf),
-                                (void*)bodybuf, strlen(bodybuf));
-        fdb_set(db_txn1, doc[i]);
+            (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
+        fdb_set(db, doc[i]);
     }
 
-    // insert other half docs into txn2
-    for (i=n/2;i<n;++i){
-        sprintf(keybuf, "key%d", i);
-        sprintf(metabuf, "meta%d", i);
-        sprintf(bodybuf, "body%d", i);
-        fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
-                                (void*)metabuf, strlen(metabuf),
-                                (void*)bodybuf, strlen(bodybuf));
-        fdb_set(db_txn2, doc[i]);
+    // remove document #5
+    fdb_doc_create(&rdoc, doc[5]->key, doc[5]->keylen, doc[5]->meta, doc[5]->metalen, NULL, 0);
+    status = fdb_del(db, rdoc);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    fdb_doc_free(rdoc);
+
+    // commit
+    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+
+    // close the db
+    fdb_kvs_close(db);
+    fdb_close(dbfile);
+
+    // reopen
+    fdb_open(&dbfile, "./dummy1", &fconfig);
+    fdb_kvs_open_default(dbfile, &db, &kvs_config);
+    status = fdb_set_log_callback(db, logCallbackFunc,
+                                  (void *) "doc_compression_test");
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+
+    // update dummy str
+    dummy_len = 64;
+    memset(temp, 'b', dummy_len);
+    temp[dummy_len]=0;
+
+    // update document #0 and #1
+    for (i=0;i<2;++i){
+        sprintf(metabuf, "newmeta%d", i);
+        sprintf(bodybuf, "newbody%d_%s", i, temp);
+        fdb_doc_update(&doc[i], (void *)metabuf, strlen(metabuf),
+            (void *)bodybuf, strlen(bodybuf));
+        fdb_set(db, doc[i]);
     }
 
-    // uncommitted docs should not be read by the other transaction that
-    // doesn't allow uncommitted reads.
+    // commit
+    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+
+    // retrieve documents
     for (i=0;i<n;++i){
-        sprintf(keybuf, "key%d", i);
-        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf), NULL, 0, NULL, 0);
-        status = fdb_get(db_txn1, rdoc);
-        if (i<n/2) {
+        // search by key
+        fdb_doc_create(&rdoc, doc[i]->key, doc[i]->keylen, NULL, 0, NULL, 0);
+        status = fdb_get(db, rdoc);
+
+        if (i != 5) {
+            // updated documents
             TEST_CHK(status == FDB_RESULT_SUCCESS);
+            TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
+            TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
         } else {
-            TEST_CHK(status != FDB_RESULT_SUCCESS);
+            // removed document
+            TEST_CHK(status == FDB_RESULT_KEY_NOT_FOUND);
         }
-        fdb_doc_free(rdoc);
-    }
 
-    // uncommitted docs can be read by the transaction that allows uncommitted reads.
-    fdb_open(&dbfile_txn3, "dummy1", &fconfig);
-    fdb_kvs_open_default(dbfile_txn3, &db_txn3, &kvs_config);
-    fdb_begin_transaction(dbfile_txn3, FDB_ISOLATION_READ_UNCOMMITTED);
-    for (i=0;i<n;++i){
-        sprintf(keybuf, "key%d", i);
-        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf), NULL, 0, NULL, 0);
-        status = fdb_get(db_txn3, rdoc);
-        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        // free result document
         fdb_doc_free(rdoc);
     }
-    fdb_end_transaction(dbfile_txn3, FDB_COMMIT_NORMAL);
-    fdb_close(dbfile_txn3);
 
-    // commit and end txn1
-    fdb_end_transaction(dbfile_txn1, FDB_COMMIT_NORMAL);
+    // do compaction
+    fdb_compact(dbfile, (char *) "./dummy2");
 
-    // uncommitted docs should not be read generally
+    // retrieve documents after compaction
     for (i=0;i<n;++i){
-        sprintf(keybuf, "key%d", i);
-        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf), NULL, 0, NULL, 0);
+        // search by key
+        fdb_doc_create(&rdoc, doc[i]->key, doc[i]->keylen, NULL, 0, NULL, 0);
         status = fdb_get(db, rdoc);
-        if (i<n/2) {
+
+        if (i != 5) {
+            // updated documents
             TEST_CHK(status == FDB_RESULT_SUCCESS);
+            TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
+            TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
         } else {
-            TEST_CHK(status != FDB_RESULT_SUCCESS);
+            // removed document
+            TEST_CHK(status == FDB_RESULT_KEY_NOT_FOUND);
         }
+
+        // free result document
         fdb_doc_free(rdoc);
     }
 
-    // read uncommitted docs using the same transaction
+    // free all documents
     for (i=0;i<n;++i){
-        sprintf(keybuf, "key%d", i);
-        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf), NULL, 0, NULL, 0);
-        status = fdb_get(db_txn2, rdoc);
-        TEST_CHK(status == FDB_RESULT_SUCCESS);
-        fdb_doc_free(rdoc);
+        fdb_doc_free(doc[i]);
     }
 
-    // abort txn2
-    fdb_abort_transaction(dbfile_txn2);
-
-    // close & re-open db file
+    // close db file
+    fdb_kvs_close(db);
     fdb_close(dbfile);
-    fdb_open(&dbfile, "dummy1", &fconfig);
+
+    // free all resources
+    fdb_shutdown();
+
+    memleak_end();
+
+    TEST_RESULT("document compression test");
+}
+
+void read_doc_by_offset_test()
+{
+    TEST_INIT();
+    memleak_start();
+
+    int i, r;
+    int n = 100;
+    fdb_file_handle *dbfile;
+    fdb_kvs_handle *db;
+    fdb_doc **doc = alca(fdb_doc*, n);
+    fdb_doc *rdoc;
+    fdb_status status;
+
+    char keybuf[256], metabuf[256], bodybuf[256];
+
+    // remove previous dummy files
+    r = system(SHELL_DEL" dummy* > errorlog.txt");
+    (void)r;
+
+    fdb_config fconfig = fdb_get_default_config();
+    fdb_kvs_config kvs_config = fdb_get_default_kvs_config();
+    fconfig.buffercache_size = 0;
+    fconfig.wal_threshold = 1024;
+    fconfig.flags = FDB_OPEN_FLAG_CREATE;
+    fconfig.purging_interval = 3600;
+    fconfig.compaction_threshold = 0;
+
+    // open db
+    fdb_open(&dbfile, "./dummy1", &fconfig);
     fdb_kvs_open_default(dbfile, &db, &kvs_config);
     status = fdb_set_log_callback(db, logCallbackFunc,
-                                  (void *) "transaction_test");
+                                  (void *) "read_doc_by_offset_test");
     TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-    // uncommitted docs should not be read after reopening the file either
+    // insert documents
     for (i=0;i<n;++i){
         sprintf(keybuf, "key%d", i);
-        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf), NULL, 0, NULL, 0);
-        status = fdb_get(db, rdoc);
-        if (i<n/2) {
-            TEST_CHK(status == FDB_RESULT_SUCCESS);
-        } else {
-            TEST_CHK(status != FDB_RESULT_SUCCESS);
-        }
-        fdb_doc_free(rdoc);
+        sprintf(metabuf, "meta%d", i);
+        sprintf(bodybuf, "body%d", i);
+        fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
+            (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
+        fdb_set(db, doc[i]);
     }
 
-    // insert other half docs & commit
-    for (i=n/2;i<n;++i){
+    // commit
+    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+
+    // update documents from #0 to #49
+    for (i=0;i<n/2;++i){
+        sprintf(metabuf, "meta2%d", i);
+        sprintf(bodybuf, "body2%d", i);
+        fdb_doc_update(&doc[i], (void *)metabuf, strlen(metabuf),
+            (void *)bodybuf, strlen(bodybuf));
         fdb_set(db, doc[i]);
     }
+
+    // remove document #50
+    fdb_doc_create(&rdoc, doc[50]->key, doc[50]->keylen, doc[50]->meta,
+                   doc[50]->metalen, NULL, 0);
+    status = fdb_del(db, rdoc);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    fdb_doc_free(rdoc);
+
+    // commit
     fdb_commit(dbfile, FDB_COMMIT_NORMAL);
 
-    // now all docs can be read generally
+    fdb_doc_create(&rdoc, doc[5]->key, doc[5]->keylen, NULL, 0, NULL, 0);
+    status = fdb_get_metaonly(db, rdoc);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    TEST_CHK(rdoc->deleted == false);
+    TEST_CHK(!memcmp(rdoc->meta, doc[5]->meta, rdoc->metalen));
+    // Fetch #5 doc using its offset.
+    status = fdb_get_byoffset(db, rdoc);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    TEST_CHK(rdoc->deleted == false);
+    TEST_CHK(!memcmp(rdoc->meta, doc[5]->meta, rdoc->metalen));
+    TEST_CHK(!memcmp(rdoc->body, doc[5]->body, rdoc->bodylen));
+    fdb_doc_free(rdoc);
+
+    // do compaction
+    fdb_compact(dbfile, (char *) "./dummy2");
+
+    fdb_doc_create(&rdoc, doc[50]->key, doc[50]->keylen, NULL, 0, NULL, 0);
+    status = fdb_get_metaonly(db, rdoc);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    TEST_CHK(rdoc->deleted == true);
+    TEST_CHK(!memcmp(rdoc->meta, doc[50]->meta, rdoc->metalen));
+    // Fetch #50 doc using its offset.
+    status = fdb_get_byoffset(db, rdoc);
+    TEST_CHK(status == FDB_RESULT_KEY_NOT_FOUND);
+    TEST_CHK(rdoc->deleted == true);
+    fdb_doc_free(rdoc);
+
+    // free all documents
     for (i=0;i<n;++i){
-        sprintf(keybuf, "key%d", i);
-        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf), NULL, 0, NULL, 0);
-        status = fdb_get(db, rdoc);
-        TEST_CHK(status == FDB_RESULT_SUCCESS);
-        fdb_doc_free(rdoc);
+        fdb_doc_free(doc[i]);
     }
 
-    // begin transactions
-    fdb_begin_transaction(dbfile_txn1, FDB_ISOLATION_READ_COMMITTED);
-    fdb_begin_transaction(dbfile_txn2, FDB_ISOLATION_READ_COMMITTED);
+    // close db file
+    fdb_kvs_close(db);
+    fdb_close(dbfile);
 
-    // concurrently update docs
+    // free all resources
+    fdb_shutdown();
+
+    memleak_end();
+
+    TEST_RESULT("read_doc_by_offset test");
+}
+
+void purge_logically_deleted_doc_test()
+{
+    TEST_INIT();
+
+    memleak_start();
+
+    int i, r;
+    int n = 10;
+    fdb_file_handle *dbfile;
+    fdb_kvs_handle *db;
+    fdb_doc **doc = alca(fdb_doc*, n);
+    fdb_doc *rdoc;
+    fdb_status status;
+
+    char keybuf[256], metabuf[256], bodybuf[256];
+
+    // remove previous dummy files
+    r = system(SHELL_DEL" dummy* fdb_test_config.json > errorlog.txt");
+    (void)r;
+
+    fdb_config fconfig = fdb_get_default_config();
+    fdb_kvs_config kvs_config = fdb_get_default_kvs_config();
+    fconfig.buffercache_size = 0;
+    fconfig.wal_threshold = 1024;
+    fconfig.flags = FDB_OPEN_FLAG_CREATE;
+    fconfig.purging_interval = 2;
+    fconfig.compaction_threshold = 0;
+
+    // open db
+    fdb_open(&dbfile, "./dummy1", &fconfig);
+    fdb_kvs_open_default(dbfile, &db, &kvs_config);
+    status = fdb_set_log_callback(db, logCallbackFunc,
+                                  (void *) "purge_logically_deleted_doc_test");
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+
+    // insert documents
     for (i=0;i<n;++i){
         sprintf(keybuf, "key%d", i);
         sprintf(metabuf, "meta%d", i);
-        sprintf(bodybuf, "body%d_txn1", i);
-        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf),
-                                (void*)metabuf, strlen(metabuf),
-                                (void*)bodybuf, strlen(bodybuf));
-        fdb_set(db_txn1, rdoc);
-        fdb_doc_free(rdoc);
-
-        sprintf(bodybuf, "body%d_txn2", i);
-        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf),
-                                (void*)metabuf, strlen(metabuf),
-                                (void*)bodybuf, strlen(bodybuf));
-        fdb_set(db_txn2, rdoc);
-        fdb_doc_free(rdoc);
+        sprintf(bodybuf, "body%d", i);
+        fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
+            (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
+        fdb_set(db, doc[i]);
     }
 
-    // retrieve check
-    for (i=0;i<n;++i){
-        // general retrieval
-        sprintf(keybuf, "key%d", i);
-        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf), NULL, 0, NULL, 0);
-        status = fdb_get(db, rdoc);
-        TEST_CHK(status == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
-        fdb_doc_free(rdoc);
+    // remove document #5
+    fdb_doc_create(&rdoc, doc[5]->key, doc[5]->keylen, doc[5]->meta, doc[5]->metalen, NULL, 0);
+    status = fdb_del(db, rdoc);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    fdb_doc_free(rdoc);
 
-        // get from txn1
-        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf), NULL, 0, NULL, 0);
-        status = fdb_get(db_txn1, rdoc);
-        TEST_CHK(status == FDB_RESULT_SUCCESS);
-        sprintf(bodybuf, "body%d_txn1", i);
-        TEST_CHK(!memcmp(rdoc->body, bodybuf, rdoc->bodylen));
-        fdb_doc_free(rdoc);
+    // commit
+    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
 
-        // get from txn2
-        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf), NULL, 0, NULL, 0);
-        status = fdb_get(db_txn2, rdoc);
-        TEST_CHK(status == FDB_RESULT_SUCCESS);
-        sprintf(bodybuf, "body%d_txn2", i);
-        TEST_CHK(!memcmp(rdoc->body, bodybuf, rdoc->bodylen));
-        fdb_doc_free(rdoc);
-    }
+    // do compaction
+    fdb_compact(dbfile, (char *) "./dummy2");
 
-    // commit txn2 & retrieve check
-    fdb_end_transaction(dbfile_txn2, FDB_COMMIT_NORMAL);
+    // retrieve documents after compaction
     for (i=0;i<n;++i){
-        // general retrieval
-        sprintf(keybuf, "key%d", i);
-        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf), NULL, 0, NULL, 0);
+        // search by key
+        fdb_doc_create(&rdoc, doc[i]->key, doc[i]->keylen, NULL, 0, NULL, 0);
         status = fdb_get(db, rdoc);
-        TEST_CHK(status == FDB_RESULT_SUCCESS);
-        sprintf(bodybuf, "body%d_txn2", i);
-        TEST_CHK(!memcmp(rdoc->body, bodybuf, rdoc->bodylen));
-        fdb_doc_free(rdoc);
 
-        // get from txn1
-        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf), NULL, 0, NULL, 0);
-        status = fdb_get(db_txn1, rdoc);
-        TEST_CHK(status == FDB_RESULT_SUCCESS);
-        sprintf(bodybuf, "body%d_txn1", i);
-        TEST_CHK(!memcmp(rdoc->body, bodybuf, rdoc->bodylen));
+        if (i != 5) {
+            // updated documents
+            TEST_CHK(status == FDB_RESULT_SUCCESS);
+            TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
+            TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
+        } else {
+            // removed document
+            TEST_CHK(status == FDB_RESULT_KEY_NOT_FOUND);
+        }
+        // free result document
         fdb_doc_free(rdoc);
-    }
 
-    // commit txn1 & retrieve check
-    fdb_end_transaction(dbfile_txn1, FDB_COMMIT_NORMAL);
-    for (i=0;i<n;++i){
-        // general retrieval
-        sprintf(keybuf, "key%d", i);
-        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf), NULL, 0, NULL, 0);
-        status = fdb_get(db, rdoc);
+        // retrieve metadata
+        // all documents including logically deleted document should exist
+        fdb_doc_create(&rdoc, doc[i]->key, doc[i]->keylen, NULL, 0, NULL, 0);
+        status = fdb_get_metaonly(db, rdoc);
         TEST_CHK(status == FDB_RESULT_SUCCESS);
-        sprintf(bodybuf, "body%d_txn1", i);
-        TEST_CHK(!memcmp(rdoc->body, bodybuf, rdoc->bodylen));
         fdb_doc_free(rdoc);
     }
 
-    // begin new transaction
-    fdb_begin_transaction(dbfile_txn1, FDB_ISOLATION_READ_COMMITTED);
-    // update doc#5
-    i = 5;
-    sprintf(keybuf, "key%d", i);
-    sprintf(metabuf, "meta%d", i);
-    sprintf(bodybuf, "body%d_before_compaction", i);
-    fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf),
-                            (void*)metabuf, strlen(metabuf),
-                            (void*)bodybuf, strlen(bodybuf));
-    fdb_set(db_txn1, rdoc);
-    fdb_doc_free(rdoc);
-
-    // do compaction
-    fdb_compact(dbfile, "dummy2");
-
-    // retrieve doc#5
-    // using txn1
-    fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf), NULL, 0, NULL, 0);
-    status = fdb_get(db_txn1, rdoc);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
-    TEST_CHK(!memcmp(rdoc->body, bodybuf, rdoc->bodylen));
-    fdb_doc_free(rdoc);
+    printf("wait for 3 seconds..\n");
+    sleep(3);
 
-    // general retrieval
-    fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf), NULL, 0, NULL, 0);
-    status = fdb_get(db, rdoc);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
-    sprintf(bodybuf, "body%d_txn1", i);
-    TEST_CHK(!memcmp(rdoc->body, bodybuf, rdoc->bodylen));
-    fdb_doc_free(rdoc);
+    // do one more compaction
+    fdb_compact(dbfile, (char *) "./dummy3");
 
-    // commit transaction
-    fdb_end_transaction(dbfile_txn1, FDB_COMMIT_NORMAL);
-    // retrieve check
+    // retrieve documents after compaction
     for (i=0;i<n;++i){
-        // general get
-        sprintf(keybuf, "key%d", i);
-        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf), NULL, 0, NULL, 0);
+        // search by key
+        fdb_doc_create(&rdoc, doc[i]->key, doc[i]->keylen, NULL, 0, NULL, 0);
         status = fdb_get(db, rdoc);
-        TEST_CHK(status == FDB_RESULT_SUCCESS);
+
         if (i != 5) {
-            sprintf(bodybuf, "body%d_txn1", i);
+            // updated documents
+            TEST_CHK(status == FDB_RESULT_SUCCESS);
+            TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
+            TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
         } else {
-            sprintf(bodybuf, "body%d_before_compaction", i);
+            // removed document
+            TEST_CHK(status == FDB_RESULT_KEY_NOT_FOUND);
         }
-        TEST_CHK(!memcmp(rdoc->body, bodybuf, rdoc->bodylen));
+        // free result document
         fdb_doc_free(rdoc);
-    }
 
-    // close & re-open db file
-    fdb_close(dbfile);
-    fdb_open(&dbfile, "dummy2", &fconfig);
-    fdb_kvs_open_default(dbfile, &db, &kvs_config);
-    status = fdb_set_log_callback(db, logCallbackFunc,
-                                  (void *) "transaction_test");
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
-    // retrieve check again
-    for (i=0;i<n;++i){
-        // general get
-        sprintf(keybuf, "key%d", i);
-        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf), NULL, 0, NULL, 0);
-        status = fdb_get(db, rdoc);
-        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        // retrieve metadata
+        fdb_doc_create(&rdoc, doc[i]->key, doc[i]->keylen, NULL, 0, NULL, 0);
+        status = fdb_get_metaonly(db, rdoc);
         if (i != 5) {
-            sprintf(bodybuf, "body%d_txn1", i);
+            TEST_CHK(status == FDB_RESULT_SUCCESS);
         } else {
-            sprintf(bodybuf, "body%d_before_compaction", i);
+            // logically deletec document must be purged during the compaction
+            TEST_CHK(status == FDB_RESULT_KEY_NOT_FOUND);
         }
-        TEST_CHK(!memcmp(rdoc->body, bodybuf, rdoc->bodylen));
         fdb_doc_free(rdoc);
     }
 
     // close db file
+    fdb_kvs_close(db);
     fdb_close(dbfile);
-    fdb_close(dbfile_txn1);
-    fdb_close(dbfile_txn2);
 
     // free all documents
     for (i=0;i<n;++i){
@@ -5643,24 +5795,29 @@ void transaction_test()
 
     memleak_end();
 
-    TEST_RESULT("transaction test");
+    TEST_RESULT("purge logically deleted doc test");
 }
 
-void transaction_simple_api_test()
+void compaction_daemon_test(size_t time_sec)
 {
     TEST_INIT();
 
     memleak_start();
 
     int i, r;
-    int n = 10;
-    size_t valuelen;
-    void *value;
-    fdb_file_handle *dbfile, *dbfile_txn1, *dbfile_txn2;
-    fdb_kvs_handle *db, *db_txn1, *db_txn2;
+    int n = 10000;
+    int compaction_threshold = 30;
+    int escape = 0;
+    fdb_file_handle *dbfile, *dbfile_less, *dbfile_non, *dbfile_manual, *dbfile_new;
+    fdb_kvs_handle *db, *db_less, *db_non, *db_manual;
+    fdb_kvs_handle *snapshot;
+    fdb_doc **doc = alca(fdb_doc*, n);
+    fdb_doc *rdoc;
+    fdb_file_info info;
     fdb_status status;
+    struct timeval ts_begin, ts_cur, ts_gap;
 
-    char keybuf[256], bodybuf[256];
+    char keybuf[256], metabuf[256], bodybuf[256];
 
     // remove previous dummy files
     r = system(SHELL_DEL" dummy* > errorlog.txt");
@@ -5671,242 +5828,285 @@ void transaction_simple_api_test()
     fconfig.buffercache_size = 0;
     fconfig.wal_threshold = 1024;
     fconfig.flags = FDB_OPEN_FLAG_CREATE;
-    fconfig.purging_interval = 0;
-    fconfig.compaction_threshold = 0;
+    fconfig.compaction_mode = FDB_COMPACTION_AUTO;
+    fconfig.compaction_threshold = compaction_threshold;
+    fconfig.compactor_sleep_duration = 1; // for quick test
 
     // open db
-    fdb_open(&dbfile, "./dummy1", &fconfig);
+    fdb_open(&dbfile, "dummy", &fconfig);
     fdb_kvs_open_default(dbfile, &db, &kvs_config);
     status = fdb_set_log_callback(db, logCallbackFunc,
-                                  (void *) "transaction_simple_api_test");
+                                  (void *) "compaction_daemon_test");
     TEST_CHK(status == FDB_RESULT_SUCCESS);
-
-    // insert key-value pairs
-    for (i=0;i<n;++i){
-        sprintf(keybuf, "key%d", i);
-        sprintf(bodybuf, "body%d", i);
-        status = fdb_set_kv(db, keybuf, strlen(keybuf), bodybuf, strlen(bodybuf));
-        TEST_CHK(status == FDB_RESULT_SUCCESS);
+    // insert documents
+    printf("Initialize..\n");
+    for (i=0;i<n;++i){
+        sprintf(keybuf, "key%04d", i);
+        sprintf(metabuf, "meta%04d", i);
+        sprintf(bodybuf, "body%04d", i);
+        fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf)+1,
+            (void*)metabuf, strlen(metabuf)+1, (void*)bodybuf, strlen(bodybuf)+1);
+        fdb_set(db, doc[i]);
     }
-
     // commit
     fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+    // close db file
+    fdb_close(dbfile);
 
-    // open db and begin transactions
-    fdb_open(&dbfile_txn1, "./dummy1", &fconfig);
-    fdb_open(&dbfile_txn2, "./dummy1", &fconfig);
-    fdb_kvs_open_default(dbfile_txn1, &db_txn1, &kvs_config);
-    fdb_kvs_open_default(dbfile_txn2, &db_txn2, &kvs_config);
-    fdb_begin_transaction(dbfile_txn1, FDB_ISOLATION_READ_COMMITTED);
-    fdb_begin_transaction(dbfile_txn2, FDB_ISOLATION_READ_COMMITTED);
-
-    // concurrently update docs
-    for (i=0;i<n;++i){
-        sprintf(keybuf, "key%d", i);
-        sprintf(bodybuf, "body%d_txn1", i);
-        fdb_set_kv(db_txn1, keybuf, strlen(keybuf), bodybuf, strlen(bodybuf));
-
-        sprintf(keybuf, "key%d", i);
-        sprintf(bodybuf, "body%d_txn2", i);
-        fdb_set_kv(db_txn2, keybuf, strlen(keybuf), bodybuf, strlen(bodybuf));
-    }
+    // ---- basic retrieve test ------------------------
+    // reopen db file
+    status = fdb_open(&dbfile, "dummy", &fconfig);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    status = fdb_kvs_open_default(dbfile, &db, &kvs_config);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    status = fdb_set_log_callback(db, logCallbackFunc,
+                                  (void *) "compaction_daemon_test");
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    // check db filename
+    fdb_get_file_info(dbfile, &info);
+    TEST_CHK(!strcmp(info.filename, "dummy"));
 
-    // retrieve key-value pairs
+    // retrieve documents
     for (i=0;i<n;++i){
-        // general retrieval
-        sprintf(keybuf, "key%d", i);
-        sprintf(bodybuf, "body%d", i);
-        status = fdb_get_kv(db, keybuf, strlen(keybuf), &value, &valuelen);
+        sprintf(keybuf, "key%04d", i);
+        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf)+1,
+            NULL, 0, NULL, 0);
+        status = fdb_get(db, rdoc);
+        //printf("%s %s\n", rdoc->key, rdoc->body);
         TEST_CHK(status == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, bodybuf, valuelen));
-        free(value);
+        TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
+        fdb_doc_free(rdoc);
+    }
 
-        // txn1
-        sprintf(keybuf, "key%d", i);
-        sprintf(bodybuf, "body%d_txn1", i);
-        status = fdb_get_kv(db_txn1, keybuf, strlen(keybuf), &value, &valuelen);
-        TEST_CHK(status == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, bodybuf, valuelen));
-        free(value);
+    // create a snapshot
+    status = fdb_snapshot_open(db, &snapshot, n);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    // close snapshot
+    fdb_kvs_close(snapshot);
 
-        // txn2
-        sprintf(keybuf, "key%d", i);
-        sprintf(bodybuf, "body%d_txn2", i);
-        status = fdb_get_kv(db_txn2, keybuf, strlen(keybuf), &value, &valuelen);
-        TEST_CHK(status == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, bodybuf, valuelen));
-        free(value);
-    }
+    // close db file
+    fdb_close(dbfile);
 
-    // commit txn1
-    fdb_end_transaction(dbfile_txn1, FDB_COMMIT_NORMAL);
+    // ---- handling when metafile is removed ------------
+    // remove meta file
+    r = system(SHELL_DEL" dummy.meta > errorlog.txt");
+    (void)r;
+    // reopen db file
+    status = fdb_open(&dbfile, "dummy", &fconfig);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    status = fdb_kvs_open_default(dbfile, &db, &kvs_config);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    status = fdb_set_log_callback(db, logCallbackFunc,
+                                  (void *) "compaction_daemon_test");
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    // retrieve documents
     for (i=0;i<n;++i){
-        // general retrieval
-        sprintf(keybuf, "key%d", i);
-        sprintf(bodybuf, "body%d_txn1", i);
-        status = fdb_get_kv(db, keybuf, strlen(keybuf), &value, &valuelen);
-        TEST_CHK(status == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, bodybuf, valuelen));
-        free(value);
-
-        // txn2
-        sprintf(keybuf, "key%d", i);
-        sprintf(bodybuf, "body%d_txn2", i);
-        status = fdb_get_kv(db_txn2, keybuf, strlen(keybuf), &value, &valuelen);
+        sprintf(keybuf, "key%04d", i);
+        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf)+1,
+            NULL, 0, NULL, 0);
+        status = fdb_get(db, rdoc);
+        //printf("%s %s\n", rdoc->key, rdoc->body);
         TEST_CHK(status == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, bodybuf, valuelen));
-        free(value);
+        TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
+        fdb_doc_free(rdoc);
     }
+    // close db file
+    fdb_close(dbfile);
 
-    // commit txn2
-    fdb_end_transaction(dbfile_txn2, FDB_COMMIT_NORMAL);
+    // ---- handling when metafile points to non-exist file ------------
+    // remove meta file
+    r = system(SHELL_MOVE" dummy.0 dummy.23 > errorlog.txt");
+    (void)r;
+    // reopen db file
+    status = fdb_open(&dbfile, "dummy", &fconfig);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    status = fdb_kvs_open_default(dbfile, &db, &kvs_config);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    status = fdb_set_log_callback(db, logCallbackFunc,
+                                  (void *) "compaction_daemon_test");
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    // retrieve documents
     for (i=0;i<n;++i){
-        // general retrieval
-        sprintf(keybuf, "key%d", i);
-        sprintf(bodybuf, "body%d_txn2", i);
-        status = fdb_get_kv(db, keybuf, strlen(keybuf), &value, &valuelen);
+        sprintf(keybuf, "key%04d", i);
+        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf)+1,
+            NULL, 0, NULL, 0);
+        status = fdb_get(db, rdoc);
+        //printf("%s %s\n", rdoc->key, rdoc->body);
         TEST_CHK(status == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, bodybuf, valuelen));
-        free(value);
+        TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
+        fdb_doc_free(rdoc);
     }
-
     // close db file
     fdb_close(dbfile);
-    fdb_close(dbfile_txn1);
-    fdb_close(dbfile_txn2);
 
-    // free all resources
-    fdb_shutdown();
+    // ---- compaction daemon test -------------------
+    // db: DB instance to be compacted
+    // db_less: DB instance to be compacted but with much lower update throughput
+    // db_non: DB instance not to be compacted (auto compaction with threshold = 0)
+    // db_manual: DB instance not to be compacted (manual compaction)
 
-    memleak_end();
+    // open & create db_less, db_non and db_manual
+    status = fdb_open(&dbfile_less, "dummy_less", &fconfig);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    status = fdb_kvs_open_default(dbfile_less, &db_less, &kvs_config);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-    TEST_RESULT("transaction simple API test");
-}
+    fconfig.compaction_threshold = 0;
+    status = fdb_open(&dbfile_non, "dummy_non", &fconfig);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    status = fdb_kvs_open_default(dbfile_non, &db_non, &kvs_config);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-void flush_before_commit_test()
-{
-    TEST_INIT();
+    fconfig.compaction_mode = FDB_COMPACTION_MANUAL;
+    status = fdb_open(&dbfile_manual, "dummy_manual", &fconfig);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    status = fdb_kvs_open_default(dbfile_manual, &db_manual, &kvs_config);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-    memleak_start();
+    // reopen db file
+    fconfig.compaction_threshold = 30;
+    fconfig.compaction_mode = FDB_COMPACTION_AUTO;
+    status = fdb_open(&dbfile, "dummy", &fconfig);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    status = fdb_kvs_open_default(dbfile, &db, &kvs_config);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    status = fdb_set_log_callback(db, logCallbackFunc,
+                                  (void *) "compaction_daemon_test");
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    // continuously update documents
+    printf("wait for %d seconds..\n", (int)time_sec);
+    gettimeofday(&ts_begin, NULL);
+    while(!escape) {
+        for (i=0;i<n;++i){
+            // update db
+            fdb_set(db, doc[i]);
+            fdb_commit(dbfile, FDB_COMMIT_NORMAL);
 
-    int i, r;
-    int n = 30;
-    fdb_file_handle *dbfile, *dbfile_txn;
-    fdb_kvs_handle *db, *db_txn;
-    fdb_doc **doc = alca(fdb_doc*, n);
-    fdb_status status;
+            // update db_less (1/100 throughput)
+            if (i%100 == 0){
+                fdb_set(db_less, doc[i]);
+                fdb_commit(dbfile_less, FDB_COMMIT_NORMAL);
+            }
 
-    char keybuf[256], metabuf[256], bodybuf[256];
+            // update db_non
+            fdb_set(db_non, doc[i]);
+            fdb_commit(dbfile_non, FDB_COMMIT_NORMAL);
 
-    // remove previous dummy files
-    r = system(SHELL_DEL" dummy* > errorlog.txt");
-    (void)r;
+            // update db_manual
+            fdb_set(db_manual, doc[i]);
+            fdb_commit(dbfile_manual, FDB_COMMIT_NORMAL);
 
-    fdb_config fconfig = fdb_get_default_config();
-    fdb_kvs_config kvs_config = fdb_get_default_kvs_config();
-    fconfig.buffercache_size = 0;
-    fconfig.wal_threshold = 5;
-    fconfig.flags = FDB_OPEN_FLAG_CREATE;
-    fconfig.purging_interval = 0;
-    fconfig.compaction_threshold = 0;
-    fconfig.wal_flush_before_commit = true;
+            gettimeofday(&ts_cur, NULL);
+            ts_gap = _utime_gap(ts_begin, ts_cur);
+            if (ts_gap.tv_sec >= time_sec) {
+                escape = 1;
+                break;
+            }
+        }
+    }
 
-    // open db
-    fdb_open(&dbfile, "dummy1", &fconfig);
-    fdb_open(&dbfile_txn, "dummy1", &fconfig);
-    fdb_kvs_open_default(dbfile, &db, &kvs_config);
-    fdb_kvs_open_default(dbfile_txn, &db_txn, &kvs_config);
-    status = fdb_set_log_callback(db_txn, logCallbackFunc,
-                                  (void *) "flush_before_commit_test");
+    // perform manual compaction of auto-compact file
+    status = fdb_compact(dbfile_non, NULL);
     TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-    // create docs
-    for (i=0;i<n;++i){
-        sprintf(keybuf, "key%d", i);
-        sprintf(metabuf, "meta%d", i);
-        sprintf(bodybuf, "body%d", i);
-        fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
-                                (void*)metabuf, strlen(metabuf),
-                                (void*)bodybuf, strlen(bodybuf));
-    }
-
-    // non-transactional commit first, transactional commit next
-    fdb_begin_transaction(dbfile_txn, FDB_ISOLATION_READ_COMMITTED);
-    for (i=0;i<2;++i){
-        fdb_set(db, doc[i]);
-    }
-    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
-    for (i=0;i<2;++i){
-        fdb_set(db_txn, doc[i]);
-    }
-    fdb_end_transaction(dbfile_txn, FDB_COMMIT_NORMAL);
-    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
-
-    // transactional commit first, non-transactional commit next
-    fdb_begin_transaction(dbfile_txn, FDB_ISOLATION_READ_COMMITTED);
-    for (i=0;i<2;++i){
-        fdb_set(db_txn, doc[i]);
-    }
-    fdb_end_transaction(dbfile_txn, FDB_COMMIT_NORMAL);
-    for (i=0;i<2;++i){
-        fdb_set(db, doc[i]);
-    }
-    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
-    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
+    // perform manual compaction of manual-compact file
+    status = fdb_compact(dbfile_manual, "dummy_manual_compacted");
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-    // concurrent update (non-txn commit first, txn commit next)
-    fdb_begin_transaction(dbfile_txn, FDB_ISOLATION_READ_COMMITTED);
-    for (i=0;i<2;++i){
-        fdb_set(db_txn, doc[i]);
-    }
-    for (i=0;i<2;++i){
-        fdb_set(db, doc[i]);
-    }
-    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
-    fdb_end_transaction(dbfile_txn, FDB_COMMIT_NORMAL);
-    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
+    // open dummy_manual_compacted using new db handle
+    fconfig.compaction_mode = FDB_COMPACTION_MANUAL;
+    status = fdb_open(&dbfile_new, "dummy_manual_compacted", &fconfig);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-    // concurrent update (txn commit first, non-txn commit next)
-    fdb_begin_transaction(dbfile_txn, FDB_ISOLATION_READ_COMMITTED);
-    for (i=0;i<2;++i){
-        fdb_set(db, doc[i]);
-    }
-    for (i=0;i<2;++i){
-        fdb_set(db_txn, doc[i]);
-    }
-    fdb_end_transaction(dbfile_txn, FDB_COMMIT_NORMAL);
-    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
-    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
+    // try to switch compaction mode
+    status = fdb_switch_compaction_mode(dbfile_manual, FDB_COMPACTION_AUTO, 30);
+    TEST_CHK(status == FDB_RESULT_FILE_IS_BUSY);
 
-    // begin transaction
-    fdb_begin_transaction(dbfile_txn, FDB_ISOLATION_READ_COMMITTED);
+    // close db_new
+    status = fdb_close(dbfile_new);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-    // insert docs using transaction
-    for (i=0;i<10;++i){
-        fdb_set(db_txn, doc[i]);
-    }
+    // switch compaction mode of 'db_manual' from MANUAL to AUTO
+    status = fdb_switch_compaction_mode(dbfile_manual, FDB_COMPACTION_AUTO, 30);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-    // insert docs without transaction
-    for (i=10;i<20;++i){
-        fdb_set(db, doc[i]);
-    }
+    // close and open with auto-compact option
+    status = fdb_close(dbfile_manual);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    fconfig.compaction_mode = FDB_COMPACTION_AUTO;
+    status = fdb_open(&dbfile_manual, "dummy_manual_compacted", &fconfig);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-    // do compaction
-    fdb_compact(dbfile, "dummy2");
+    // switch compaction mode of 'db_non' from AUTO to MANUAL
+    status = fdb_switch_compaction_mode(dbfile_non, FDB_COMPACTION_MANUAL, 0);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-    for (i=20;i<25;++i){
-        fdb_set(db_txn, doc[i]);
-    }
-    // end transaction
-    fdb_end_transaction(dbfile_txn, FDB_COMMIT_NORMAL);
+    // close and open with manual-compact option
+    status = fdb_close(dbfile_non);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    fconfig.compaction_mode = FDB_COMPACTION_MANUAL;
+    status = fdb_open(&dbfile_non, "dummy_non", &fconfig);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-    for (i=25;i<30;++i){
-        fdb_set(db, doc[i]);
-    }
+    // Now perform one manual compaction on dummy_non
+    fdb_compact(dbfile_non, "dummy_non.manual");
 
-    // close db file
+    // close all db files except dummy_non
     fdb_close(dbfile);
-    fdb_close(dbfile_txn);
+    fdb_close(dbfile_less);
+    fdb_close(dbfile_manual);
+
+    // open manual compact file (dummy_non) using auto compact mode
+    fconfig.compaction_mode = FDB_COMPACTION_AUTO;
+    status = fdb_open(&dbfile, "dummy_non.manual", &fconfig);
+    TEST_CHK(status == FDB_RESULT_INVALID_COMPACTION_MODE);
+
+    // Attempt to destroy manual compact file using auto compact mode
+    status = fdb_destroy("dummy_non.manual", &fconfig);
+    TEST_CHK(status == FDB_RESULT_INVALID_COMPACTION_MODE);
+
+    // open auto copmact file (dummy_manual_compacted) using manual compact mode
+    fconfig.compaction_mode = FDB_COMPACTION_MANUAL;
+    status = fdb_open(&dbfile, "dummy_manual_compacted", &fconfig);
+    TEST_CHK(status == FDB_RESULT_INVALID_COMPACTION_MODE);
+
+    // Attempt to destroy auto copmact file using manual compact mode
+    status = fdb_destroy("dummy_manual_compacted", &fconfig);
+    TEST_CHK(status == FDB_RESULT_INVALID_COMPACTION_MODE);
+
+    // DESTROY auto copmact file with correct mode
+    fconfig.compaction_mode = FDB_COMPACTION_AUTO;
+    status = fdb_destroy("dummy_manual_compacted", &fconfig);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+
+    // DESTROY manual compacted file with past version open!
+    fconfig.compaction_mode = FDB_COMPACTION_MANUAL;
+    status = fdb_destroy("dummy_non.manual", &fconfig);
+    TEST_CHK(status == FDB_RESULT_FILE_IS_BUSY);
+
+    // Simulate a database crash by doing a premature shutdown
+    // Note that db_non was never closed properly
+    status = fdb_shutdown();
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+
+    status = fdb_destroy("dummy_non.manual", &fconfig);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+
+    // Attempt to read-only auto compacted and destroyed file
+    fconfig.flags = FDB_OPEN_FLAG_RDONLY;
+    status = fdb_open(&dbfile, "./dummy_manual_compacted", &fconfig);
+    TEST_CHK(status == FDB_RESULT_NO_SUCH_FILE);
+
+    status = fdb_open(&dbfile, "./dummy_manual_compacted.meta", &fconfig);
+    TEST_CHK(status == FDB_RESULT_NO_SUCH_FILE);
+
+    // Attempt to read-only past version of manually compacted destroyed file
+    status = fdb_open(&dbfile, "dummy_non", &fconfig);
+    TEST_CHK(status == FDB_RESULT_NO_SUCH_FILE);
+
+    // Attempt to read-only current version of manually compacted destroyed file
+    status = fdb_open(&dbfile, "dummy_non.manual", &fconfig);
+    TEST_CHK(status == FDB_RESULT_NO_SUCH_FILE);
 
     // free all documents
     for (i=0;i<n;++i){
@@ -5918,10 +6118,10 @@ void flush_before_commit_test()
 
     memleak_end();
 
-    TEST_RESULT("flush before commit test");
+    TEST_RESULT("compaction daemon test");
 }
 
-void flush_before_commit_multi_writers_test()
+void api_wrapper_test()
 {
     TEST_INIT();
 
@@ -5929,151 +6129,100 @@ void flush_before_commit_multi_writers_test()
 
     int i, r;
     int n = 10;
-    fdb_file_handle *dbfile1, *dbfile2;
-    fdb_kvs_handle *db1, *db2;
-    fdb_doc **doc = alca(fdb_doc*, n);
-    fdb_doc *rdoc;
+    size_t valuelen;
+    void *value;
+    fdb_file_handle *dbfile;
+    fdb_kvs_handle *db;
     fdb_status status;
-    fdb_config fconfig;
-    fdb_kvs_config kvs_config;
 
-    char keybuf[256], metabuf[256], bodybuf[256];
+    char keybuf[256], bodybuf[256], temp[256];
 
     // remove previous dummy files
     r = system(SHELL_DEL" dummy* > errorlog.txt");
     (void)r;
 
-    fconfig = fdb_get_default_config();
+    fdb_config fconfig = fdb_get_default_config();
+    fdb_kvs_config kvs_config = fdb_get_default_kvs_config();
     fconfig.buffercache_size = 0;
-    fconfig.wal_threshold = 8;
+    fconfig.wal_threshold = 1024;
     fconfig.flags = FDB_OPEN_FLAG_CREATE;
     fconfig.purging_interval = 0;
     fconfig.compaction_threshold = 0;
-    fconfig.wal_flush_before_commit = true;
-
-    kvs_config = fdb_get_default_kvs_config();
 
     // open db
-    fdb_open(&dbfile1, "dummy1", &fconfig);
-    fdb_kvs_open(dbfile1, &db1, NULL, &kvs_config);
+    fdb_open(&dbfile, "./dummy1", &fconfig);
+    fdb_kvs_open_default(dbfile, &db, &kvs_config);
+    status = fdb_set_log_callback(db, logCallbackFunc,
+                                  (void *) "api_wrapper_test");
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-    // create & insert docs
+    // error check
+    status = fdb_set_kv(db, NULL, 0, NULL, 0);
+    TEST_CHK(status == FDB_RESULT_INVALID_ARGS);
+
+    // insert key-value pairs
     for (i=0;i<n;++i){
         sprintf(keybuf, "key%d", i);
-        sprintf(metabuf, "meta%d", i);
         sprintf(bodybuf, "body%d", i);
-        fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
-                                (void*)metabuf, strlen(metabuf),
-                                (void*)bodybuf, strlen(bodybuf));
-        fdb_set(db1, doc[i]);
+        status = fdb_set_kv(db, keybuf, strlen(keybuf), bodybuf, strlen(bodybuf));
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
     }
-    fdb_commit(dbfile1, FDB_COMMIT_MANUAL_WAL_FLUSH);
 
-    // open second writer
-    fdb_open(&dbfile2, "dummy1", &fconfig);
-    fdb_kvs_open(dbfile2, &db2, NULL, &kvs_config);
+    // remove key5
+    sprintf(keybuf, "key%d", 5);
+    status = fdb_del_kv(db, keybuf, strlen(keybuf));
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-    for (i=0;i<n/2;++i){
-        sprintf(metabuf, "meta2%d", i);
-        sprintf(bodybuf, "body2%d(db2)", i);
-        fdb_doc_update(&doc[i], (void *)metabuf, strlen(metabuf),
-            (void *)bodybuf, strlen(bodybuf));
-        fdb_set(db2, doc[i]);
-    }
-    for (i=n/2;i<n;++i){
-        sprintf(metabuf, "meta2%d", i);
-        sprintf(bodybuf, "body2%d(db1)", i);
-        fdb_doc_update(&doc[i], (void *)metabuf, strlen(metabuf),
-            (void *)bodybuf, strlen(bodybuf));
-        fdb_set(db1, doc[i]);
-    }
+    // error check
+    status = fdb_del_kv(db, NULL, 0);
+    TEST_CHK(status == FDB_RESULT_INVALID_ARGS);
 
-    // retrieve before commit
+    // retrieve key-value pairs
     for (i=0;i<n;++i){
         sprintf(keybuf, "key%d", i);
-        sprintf(metabuf, "meta2%d", i);
-        if (i < n/2) {
-            sprintf(bodybuf, "body2%d(db2)", i);
+        status = fdb_get_kv(db, keybuf, strlen(keybuf), &value, &valuelen);
+
+        if (i != 5) {
+            // updated documents
+            TEST_CHK(status == FDB_RESULT_SUCCESS);
+            sprintf(temp, "body%d", i);
+            TEST_CHK(!memcmp(value, temp, valuelen));
+            free(value);
         } else {
-            sprintf(bodybuf, "body2%d(db1)", i);
+            // removed document
+            TEST_CHK(status == FDB_RESULT_KEY_NOT_FOUND);
         }
-        // retrieve through db1
-        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf),
-                                NULL, 0, NULL, 0);
-        status = fdb_get(db1, rdoc);
-        TEST_CHK(status == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(metabuf, rdoc->meta, rdoc->metalen));
-        TEST_CHK(!memcmp(bodybuf, rdoc->body, rdoc->bodylen));
-        fdb_doc_free(rdoc);
+    }
 
-        // retrieve through db2
-        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf),
-                                NULL, 0, NULL, 0);
-        status = fdb_get(db2, rdoc);
-        TEST_CHK(status == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(metabuf, rdoc->meta, rdoc->metalen));
-        TEST_CHK(!memcmp(bodybuf, rdoc->body, rdoc->bodylen));
-        fdb_doc_free(rdoc);
-    }
-
-    fdb_commit(dbfile1, FDB_COMMIT_NORMAL);
-    fdb_commit(dbfile2, FDB_COMMIT_NORMAL);
-
-    // retrieve after commit
-    for (i=0;i<n;++i){
-        sprintf(keybuf, "key%d", i);
-        sprintf(metabuf, "meta2%d", i);
-        if (i < n/2) {
-            sprintf(bodybuf, "body2%d(db2)", i);
-        } else {
-            sprintf(bodybuf, "body2%d(db1)", i);
-        }
-        // retrieve through db1
-        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf),
-                                NULL, 0, NULL, 0);
-        status = fdb_get(db1, rdoc);
-        TEST_CHK(status == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(metabuf, rdoc->meta, rdoc->metalen));
-        TEST_CHK(!memcmp(bodybuf, rdoc->body, rdoc->bodylen));
-        fdb_doc_free(rdoc);
+    // error check
+    status = fdb_get_kv(db, NULL, 0, &value, &valuelen);
+    TEST_CHK(status == FDB_RESULT_INVALID_ARGS);
 
-        // retrieve through db2
-        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf),
-                                NULL, 0, NULL, 0);
-        status = fdb_get(db2, rdoc);
-        TEST_CHK(status == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(metabuf, rdoc->meta, rdoc->metalen));
-        TEST_CHK(!memcmp(bodybuf, rdoc->body, rdoc->bodylen));
-        fdb_doc_free(rdoc);
-    }
+    status = fdb_get_kv(db, keybuf, strlen(keybuf), NULL, NULL);
+    TEST_CHK(status == FDB_RESULT_INVALID_ARGS);
 
     // close db file
-    fdb_close(dbfile1);
-    fdb_close(dbfile2);
-
-    // free all documents
-    for (i=0;i<n;++i){
-        fdb_doc_free(doc[i]);
-    }
+    fdb_kvs_close(db);
+    fdb_close(dbfile);
 
     // free all resources
     fdb_shutdown();
 
     memleak_end();
 
-    TEST_RESULT("flush before commit with multi writers test");
+    TEST_RESULT("API wrapper test");
 }
 
-void last_wal_flush_header_test()
+void transaction_test()
 {
     TEST_INIT();
 
     memleak_start();
 
     int i, r;
-    int n = 30;
-    fdb_file_handle *dbfile, *dbfile_txn1, *dbfile_txn2;
-    fdb_kvs_handle *db, *db_txn1, *db_txn2;
+    int n = 10;
+    fdb_file_handle *dbfile, *dbfile_txn1, *dbfile_txn2, *dbfile_txn3;
+    fdb_kvs_handle *db, *db_txn1, *db_txn2, *db_txn3;
     fdb_doc **doc = alca(fdb_doc*, n);
     fdb_doc *rdoc;
     fdb_status status;
@@ -6087,51 +6236,55 @@ void last_wal_flush_header_test()
     fdb_config fconfig = fdb_get_default_config();
     fdb_kvs_config kvs_config = fdb_get_default_kvs_config();
     fconfig.buffercache_size = 0;
+    fconfig.wal_threshold = 1024;
     fconfig.flags = FDB_OPEN_FLAG_CREATE;
     fconfig.purging_interval = 0;
     fconfig.compaction_threshold = 0;
 
     // open db
     fdb_open(&dbfile, "dummy1", &fconfig);
-    fdb_open(&dbfile_txn1, "dummy1", &fconfig);
     fdb_kvs_open_default(dbfile, &db, &kvs_config);
+    status = fdb_set_log_callback(db, logCallbackFunc,
+                                  (void *) "transaction_test");
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+
+    // open db and begin transactions
+    fdb_open(&dbfile_txn1, "dummy1", &fconfig);
+    fdb_open(&dbfile_txn2, "dummy1", &fconfig);
     fdb_kvs_open_default(dbfile_txn1, &db_txn1, &kvs_config);
+    fdb_kvs_open_default(dbfile_txn2, &db_txn2, &kvs_config);
+    fdb_begin_transaction(dbfile_txn1, FDB_ISOLATION_READ_COMMITTED);
+    fdb_begin_transaction(dbfile_txn2, FDB_ISOLATION_READ_COMMITTED);
 
-    // create docs
-    for (i=0;i<n;++i){
+    // insert half docs into txn1
+    for (i=0;i<n/2;++i){
         sprintf(keybuf, "key%d", i);
         sprintf(metabuf, "meta%d", i);
         sprintf(bodybuf, "body%d", i);
         fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
                                 (void*)metabuf, strlen(metabuf),
                                 (void*)bodybuf, strlen(bodybuf));
-    }
-
-    // insert docs without transaction
-    for (i=0;i<2;++i) {
-        fdb_set(db, doc[i]);
-    }
-    // insert docs using transaction
-    fdb_begin_transaction(dbfile_txn1, FDB_ISOLATION_READ_COMMITTED);
-    for (i=2;i<4;++i){
         fdb_set(db_txn1, doc[i]);
     }
-    // commit without transaction
-    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
 
-    // close & reopen db
-    fdb_close(dbfile);
-    fdb_close(dbfile_txn1);
-    fdb_open(&dbfile, "dummy1", &fconfig);
-    fdb_open(&dbfile_txn1, "dummy1", &fconfig);
-    fdb_kvs_open_default(dbfile, &db, &kvs_config);
-    fdb_kvs_open_default(dbfile_txn1, &db_txn1, &kvs_config);
+    // insert other half docs into txn2
+    for (i=n/2;i<n;++i){
+        sprintf(keybuf, "key%d", i);
+        sprintf(metabuf, "meta%d", i);
+        sprintf(bodybuf, "body%d", i);
+        fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
+                                (void*)metabuf, strlen(metabuf),
+                                (void*)bodybuf, strlen(bodybuf));
+        fdb_set(db_txn2, doc[i]);
+    }
 
-    // retrieve check
-    for (i=0;i<4;++i){
-        fdb_doc_create(&rdoc, doc[i]->key, doc[i]->keylen, NULL, 0, NULL, 0);
-        status = fdb_get(db, rdoc);
-        if (i<2) {
+    // uncommitted docs should not be read by the other transaction that
+    // doesn't allow uncommitted reads.
+    for (i=0;i<n;++i){
+        sprintf(keybuf, "key%d", i);
+        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf), NULL, 0, NULL, 0);
+        status = fdb_get(db_txn1, rdoc);
+        if (i<n/2) {
             TEST_CHK(status == FDB_RESULT_SUCCESS);
         } else {
             TEST_CHK(status != FDB_RESULT_SUCCESS);
@@ -6139,68 +6292,62 @@ void last_wal_flush_header_test()
         fdb_doc_free(rdoc);
     }
 
-    // insert docs using transaction
-    fdb_begin_transaction(dbfile_txn1, FDB_ISOLATION_READ_COMMITTED);
-    for (i=2;i<4;++i){
-        fdb_set(db_txn1, doc[i]);
-    }
-    // insert docs without transaction
-    for (i=4;i<6;++i){
-        fdb_set(db, doc[i]);
+    // uncommitted docs can be read by the transaction that allows uncommitted reads.
+    fdb_open(&dbfile_txn3, "dummy1", &fconfig);
+    fdb_kvs_open_default(dbfile_txn3, &db_txn3, &kvs_config);
+    fdb_begin_transaction(dbfile_txn3, FDB_ISOLATION_READ_UNCOMMITTED);
+    for (i=0;i<n;++i){
+        sprintf(keybuf, "key%d", i);
+        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf), NULL, 0, NULL, 0);
+        status = fdb_get(db_txn3, rdoc);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        fdb_doc_free(rdoc);
     }
-    fdb_end_transaction(dbfile_txn1, FDB_COMMIT_MANUAL_WAL_FLUSH);
+    fdb_end_transaction(dbfile_txn3, FDB_COMMIT_NORMAL);
+    fdb_close(dbfile_txn3);
 
-    // close & reopen db
-    fdb_close(dbfile);
-    fdb_close(dbfile_txn1);
-    fdb_open(&dbfile, "dummy1", &fconfig);
-    fdb_open(&dbfile_txn1, "dummy1", &fconfig);
-    fdb_kvs_open_default(dbfile, &db, &kvs_config);
-    fdb_kvs_open_default(dbfile_txn1, &db_txn1, &kvs_config);
+    // commit and end txn1
+    fdb_end_transaction(dbfile_txn1, FDB_COMMIT_NORMAL);
 
-    // retrieve check
-    for (i=0;i<6;++i){
-        fdb_doc_create(&rdoc, doc[i]->key, doc[i]->keylen, NULL, 0, NULL, 0);
+    // uncommitted docs should not be read generally
+    for (i=0;i<n;++i){
+        sprintf(keybuf, "key%d", i);
+        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf), NULL, 0, NULL, 0);
         status = fdb_get(db, rdoc);
-        if (i<4) {
+        if (i<n/2) {
             TEST_CHK(status == FDB_RESULT_SUCCESS);
         } else {
-            // doesn't matter
+            TEST_CHK(status != FDB_RESULT_SUCCESS);
         }
         fdb_doc_free(rdoc);
     }
 
-    // insert docs without transaction
-    for (i=4;i<6;++i) {
-        fdb_set(db, doc[i]);
-    }
-    fdb_begin_transaction(dbfile_txn1, FDB_ISOLATION_READ_COMMITTED);
-    for (i=6;i<8;++i) {
-        fdb_set(db_txn1, doc[i]);
+    // read uncommitted docs using the same transaction
+    for (i=0;i<n;++i){
+        sprintf(keybuf, "key%d", i);
+        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf), NULL, 0, NULL, 0);
+        status = fdb_get(db_txn2, rdoc);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        fdb_doc_free(rdoc);
     }
-    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
 
-    // begin another transaction
-    fdb_open(&dbfile_txn2, "dummy1", &fconfig);
-    fdb_kvs_open_default(dbfile_txn2, &db_txn2, &kvs_config);
-    fdb_begin_transaction(dbfile_txn2, FDB_ISOLATION_READ_COMMITTED);
-    for (i=8;i<10;++i){
-        fdb_set(db_txn2, doc[i]);
-    }
-    fdb_end_transaction(dbfile_txn2, FDB_COMMIT_MANUAL_WAL_FLUSH);
+    // abort txn2
+    fdb_abort_transaction(dbfile_txn2);
 
-    // close & reopen db
+    // close & re-open db file
     fdb_close(dbfile);
-    fdb_close(dbfile_txn1);
-    fdb_close(dbfile_txn2);
     fdb_open(&dbfile, "dummy1", &fconfig);
     fdb_kvs_open_default(dbfile, &db, &kvs_config);
+    status = fdb_set_log_callback(db, logCallbackFunc,
+                                  (void *) "transaction_test");
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-    // retrieve check
-    for (i=0;i<10;++i){
-        fdb_doc_create(&rdoc, doc[i]->key, doc[i]->keylen, NULL, 0, NULL, 0);
+    // uncommitted docs should not be read after reopening the file either
+    for (i=0;i<n;++i){
+        sprintf(keybuf, "key%d", i);
+        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf), NULL, 0, NULL, 0);
         status = fdb_get(db, rdoc);
-        if (i<6 || i>=8) {
+        if (i<n/2) {
             TEST_CHK(status == FDB_RESULT_SUCCESS);
         } else {
             TEST_CHK(status != FDB_RESULT_SUCCESS);
@@ -6208,156 +6355,185 @@ void last_wal_flush_header_test()
         fdb_doc_free(rdoc);
     }
 
-    fdb_open(&dbfile_txn1, "dummy1", &fconfig);
-    fdb_open(&dbfile_txn2, "dummy1", &fconfig);
-    fdb_kvs_open_default(dbfile_txn1, &db_txn1, &kvs_config);
-    fdb_kvs_open_default(dbfile_txn2, &db_txn2, &kvs_config);
-    fdb_begin_transaction(dbfile_txn1, FDB_ISOLATION_READ_COMMITTED);
-
-    fdb_set(db, doc[10]);
-    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
-
-    fdb_set(db, doc[11]);
-    fdb_set(db_txn1, doc[12]);
-    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
-
-    fdb_set(db_txn1, doc[13]);
-    fdb_begin_transaction(dbfile_txn2, FDB_ISOLATION_READ_COMMITTED);
-    fdb_set(db_txn2, doc[14]);
-    fdb_end_transaction(dbfile_txn1, FDB_COMMIT_MANUAL_WAL_FLUSH);
-
-    fdb_set(db_txn2, doc[15]);
-    fdb_set(db, doc[16]);
-    fdb_end_transaction(dbfile_txn2, FDB_COMMIT_MANUAL_WAL_FLUSH);
-
-    fdb_set(db, doc[17]);
+    // insert other half docs & commit
+    for (i=n/2;i<n;++i){
+        fdb_set(db, doc[i]);
+    }
     fdb_commit(dbfile, FDB_COMMIT_NORMAL);
 
-    fdb_close(dbfile);
-    fdb_close(dbfile_txn1);
-    fdb_close(dbfile_txn2);
-    fdb_open(&dbfile, "dummy1", &fconfig);
-    fdb_kvs_open_default(dbfile, &db, &kvs_config);
-
-    // retrieve check
-    for (i=10;i<18;++i){
-        fdb_doc_create(&rdoc, doc[i]->key, doc[i]->keylen, NULL, 0, NULL, 0);
+    // now all docs can be read generally
+    for (i=0;i<n;++i){
+        sprintf(keybuf, "key%d", i);
+        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf), NULL, 0, NULL, 0);
         status = fdb_get(db, rdoc);
         TEST_CHK(status == FDB_RESULT_SUCCESS);
         fdb_doc_free(rdoc);
     }
 
-    fdb_open(&dbfile_txn1, "dummy1", &fconfig);
-    fdb_kvs_open_default(dbfile_txn1, &db_txn1, &kvs_config);
+    // begin transactions
     fdb_begin_transaction(dbfile_txn1, FDB_ISOLATION_READ_COMMITTED);
-    fdb_set(db_txn1, doc[20]);
-
-    fdb_compact(dbfile, "dummy2");
-
-    fdb_end_transaction(dbfile_txn1, FDB_COMMIT_MANUAL_WAL_FLUSH);
-    fdb_close(dbfile);
-    fdb_close(dbfile_txn1);
+    fdb_begin_transaction(dbfile_txn2, FDB_ISOLATION_READ_COMMITTED);
 
-    // free all documents
+    // concurrently update docs
     for (i=0;i<n;++i){
-        fdb_doc_free(doc[i]);
-    }
-
-    // free all resources
-    fdb_shutdown();
-
-    memleak_end();
-
-    TEST_RESULT("last wal flush header test");
-}
+        sprintf(keybuf, "key%d", i);
+        sprintf(metabuf, "meta%d", i);
+        sprintf(bodybuf, "body%d_txn1", i);
+        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf),
+                                (void*)metabuf, strlen(metabuf),
+                                (void*)bodybuf, strlen(bodybuf));
+        fdb_set(db_txn1, rdoc);
+        fdb_doc_free(rdoc);
 
-void long_key_test()
-{
-    TEST_INIT();
+        sprintf(bodybuf, "body%d_txn2", i);
+        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf),
+                                (void*)metabuf, strlen(metabuf),
+                                (void*)bodybuf, strlen(bodybuf));
+        fdb_set(db_txn2, rdoc);
+        fdb_doc_free(rdoc);
+    }
 
-    memleak_start();
+    // retrieve check
+    for (i=0;i<n;++i){
+        // general retrieval
+        sprintf(keybuf, "key%d", i);
+        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf), NULL, 0, NULL, 0);
+        status = fdb_get(db, rdoc);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
+        fdb_doc_free(rdoc);
 
-    int i, j, idx, r;
-    int n=300, m=20; // n: # prefixes, m: # postfixes
-    int keylen_limit;
-    fdb_file_handle *dbfile;
-    fdb_kvs_handle *db;
-    fdb_doc **doc = alca(fdb_doc*, n*m);
-    fdb_doc *rdoc;
-    fdb_status status;
+        // get from txn1
+        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf), NULL, 0, NULL, 0);
+        status = fdb_get(db_txn1, rdoc);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        sprintf(bodybuf, "body%d_txn1", i);
+        TEST_CHK(!memcmp(rdoc->body, bodybuf, rdoc->bodylen));
+        fdb_doc_free(rdoc);
 
-    char *keybuf;
-    char metabuf[256], bodybuf[256], temp[256];
+        // get from txn2
+        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf), NULL, 0, NULL, 0);
+        status = fdb_get(db_txn2, rdoc);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        sprintf(bodybuf, "body%d_txn2", i);
+        TEST_CHK(!memcmp(rdoc->body, bodybuf, rdoc->bodylen));
+        fdb_doc_free(rdoc);
+    }
 
-    // remove previous dummy files
-    r = system(SHELL_DEL" dummy* > errorlog.txt");
-    (void)r;
+    // commit txn2 & retrieve check
+    fdb_end_transaction(dbfile_txn2, FDB_COMMIT_NORMAL);
+    for (i=0;i<n;++i){
+        // general retrieval
+        sprintf(keybuf, "key%d", i);
+        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf), NULL, 0, NULL, 0);
+        status = fdb_get(db, rdoc);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        sprintf(bodybuf, "body%d_txn2", i);
+        TEST_CHK(!memcmp(rdoc->body, bodybuf, rdoc->bodylen));
+        fdb_doc_free(rdoc);
 
-    fdb_config fconfig = fdb_get_default_config();
-    fdb_kvs_config kvs_config = fdb_get_default_kvs_config();
-    fconfig.buffercache_size = 0;
-    fconfig.flags = FDB_OPEN_FLAG_CREATE;
-    fconfig.purging_interval = 0;
-    fconfig.compaction_threshold = 0;
+        // get from txn1
+        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf), NULL, 0, NULL, 0);
+        status = fdb_get(db_txn1, rdoc);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        sprintf(bodybuf, "body%d_txn1", i);
+        TEST_CHK(!memcmp(rdoc->body, bodybuf, rdoc->bodylen));
+        fdb_doc_free(rdoc);
+    }
 
-    keylen_limit = fconfig.blocksize - 256;
-    keybuf = alca(char, keylen_limit);
+    // commit txn1 & retrieve check
+    fdb_end_transaction(dbfile_txn1, FDB_COMMIT_NORMAL);
+    for (i=0;i<n;++i){
+        // general retrieval
+        sprintf(keybuf, "key%d", i);
+        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf), NULL, 0, NULL, 0);
+        status = fdb_get(db, rdoc);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        sprintf(bodybuf, "body%d_txn1", i);
+        TEST_CHK(!memcmp(rdoc->body, bodybuf, rdoc->bodylen));
+        fdb_doc_free(rdoc);
+    }
 
-    // open db
-    fdb_open(&dbfile, "dummy1", &fconfig);
-    fdb_kvs_open_default(dbfile, &db, &kvs_config);
+    // begin new transaction
+    fdb_begin_transaction(dbfile_txn1, FDB_ISOLATION_READ_COMMITTED);
+    // update doc#5
+    i = 5;
+    sprintf(keybuf, "key%d", i);
+    sprintf(metabuf, "meta%d", i);
+    sprintf(bodybuf, "body%d_before_compaction", i);
+    fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf),
+                            (void*)metabuf, strlen(metabuf),
+                            (void*)bodybuf, strlen(bodybuf));
+    fdb_set(db_txn1, rdoc);
+    fdb_doc_free(rdoc);
 
-    // key structure:
-    // <------------ <keylen_limit> bytes ------------->
-    // <-- 8 bytes -->             <-- 8 bytes  -->< 1 >
-    // [prefix number]____ ... ____[postfix number][ \0]
-    // e.g.)
-    // 00000001____ ... ____00000013[\0]
+    // do compaction
+    fdb_compact(dbfile, "dummy2");
 
-    // create docs
-    for (i=0;i<keylen_limit-1;++i){
-        keybuf[i] = '_';
-    }
-    keybuf[keylen_limit-1] = 0;
+    // retrieve doc#5
+    // using txn1
+    fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf), NULL, 0, NULL, 0);
+    status = fdb_get(db_txn1, rdoc);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    TEST_CHK(!memcmp(rdoc->body, bodybuf, rdoc->bodylen));
+    fdb_doc_free(rdoc);
+
+    // general retrieval
+    fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf), NULL, 0, NULL, 0);
+    status = fdb_get(db, rdoc);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    sprintf(bodybuf, "body%d_txn1", i);
+    TEST_CHK(!memcmp(rdoc->body, bodybuf, rdoc->bodylen));
+    fdb_doc_free(rdoc);
 
+    // commit transaction
+    fdb_end_transaction(dbfile_txn1, FDB_COMMIT_NORMAL);
+    // retrieve check
     for (i=0;i<n;++i){
-        // set prefix
-        sprintf(temp, "%08d", i);
-        memcpy(keybuf, temp, 8);
-        for (j=0;j<m;++j){
-            idx = i*m + j;
-            // set postfix
-            sprintf(temp, "%08d", j);
-            memcpy(keybuf + (keylen_limit-1) - 8, temp, 8);
-            sprintf(metabuf, "meta%d", idx);
-            sprintf(bodybuf, "body%d", idx);
-            fdb_doc_create(&doc[idx], (void*)keybuf, strlen(keybuf)+1,
-                                    (void*)metabuf, strlen(metabuf)+1,
-                                    (void*)bodybuf, strlen(bodybuf)+1);
+        // general get
+        sprintf(keybuf, "key%d", i);
+        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf), NULL, 0, NULL, 0);
+        status = fdb_get(db, rdoc);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        if (i != 5) {
+            sprintf(bodybuf, "body%d_txn1", i);
+        } else {
+            sprintf(bodybuf, "body%d_before_compaction", i);
         }
+        TEST_CHK(!memcmp(rdoc->body, bodybuf, rdoc->bodylen));
+        fdb_doc_free(rdoc);
     }
 
-    // insert docs
-    for (i=0;i<n*m;++i) {
-        fdb_set(db, doc[i]);
-    }
-    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
-
-    // retrieval check
-    for (i=0;i<n*m;++i){
-        fdb_doc_create(&rdoc, doc[i]->key, doc[i]->keylen, NULL, 0, NULL, 0);
+    // close & re-open db file
+    fdb_close(dbfile);
+    fdb_open(&dbfile, "dummy2", &fconfig);
+    fdb_kvs_open_default(dbfile, &db, &kvs_config);
+    status = fdb_set_log_callback(db, logCallbackFunc,
+                                  (void *) "transaction_test");
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    // retrieve check again
+    for (i=0;i<n;++i){
+        // general get
+        sprintf(keybuf, "key%d", i);
+        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf), NULL, 0, NULL, 0);
         status = fdb_get(db, rdoc);
         TEST_CHK(status == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(rdoc->key, doc[i]->key, rdoc->keylen));
-        TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
-        TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
+        if (i != 5) {
+            sprintf(bodybuf, "body%d_txn1", i);
+        } else {
+            sprintf(bodybuf, "body%d_before_compaction", i);
+        }
+        TEST_CHK(!memcmp(rdoc->body, bodybuf, rdoc->bodylen));
         fdb_doc_free(rdoc);
     }
 
+    // close db file
     fdb_close(dbfile);
+    fdb_close(dbfile_txn1);
+    fdb_close(dbfile_txn2);
 
     // free all documents
-    for (i=0;i<n*m;++i){
+    for (i=0;i<n;++i){
         fdb_doc_free(doc[i]);
     }
 
@@ -6366,1051 +6542,1014 @@ void long_key_test()
 
     memleak_end();
 
-    TEST_RESULT("long key test");
-}
-
-// lexicographically compares two variable-length binary streams
-#define MIN(a,b) (((a)<(b))?(a):(b))
-static int _multi_kv_test_keycmp(void *key1, size_t keylen1, void *key2, size_t keylen2)
-{
-    if (keylen1 == keylen2) {
-        return memcmp(key1, key2, keylen1);
-    }else {
-        size_t len = MIN(keylen1, keylen2);
-        int cmp = memcmp(key1, key2, len);
-        if (cmp != 0) return cmp;
-        else {
-            return (int)((int)keylen1 - (int)keylen2);
-        }
-    }
+    TEST_RESULT("transaction test");
 }
 
-#define MULTI_KV_VAR_CMP (0x1)
-void multi_kv_test(uint8_t opt)
+void transaction_simple_api_test()
 {
     TEST_INIT();
 
-    int n = 100;
+    memleak_start();
+
     int i, r;
-    char key[256], meta[256], value[256];
-    char keystr[] = "key%06d";
-    char metastr[] = "meta%06d";
-    char metastr_kv[] = "meta%06d(kv)";
-    char valuestr[] = "value%08d";
-    char valuestr_kv[] = "value%08d (kv instance)";
-    void *value_out;
+    int n = 10;
     size_t valuelen;
+    void *value;
+    fdb_file_handle *dbfile, *dbfile_txn1, *dbfile_txn2;
+    fdb_kvs_handle *db, *db_txn1, *db_txn2;
+    fdb_status status;
 
-    char *kvs_names[] = {NULL, (char*)"kv1"};
-    fdb_custom_cmp_variable functions[] = {_multi_kv_test_keycmp,
-                                           _multi_kv_test_keycmp};
-
-    fdb_file_handle *dbfile;
-    fdb_kvs_handle *db, *kv1;
-    fdb_config config;
-    fdb_kvs_config kvs_config;
-    fdb_doc *doc;
-    fdb_file_info file_info;
-    fdb_kvs_info kvs_info;
-    fdb_status s;
+    char keybuf[256], bodybuf[256];
 
-    sprintf(value, SHELL_DEL" dummy*");
-    r = system(value);
+    // remove previous dummy files
+    r = system(SHELL_DEL" dummy* > errorlog.txt");
     (void)r;
 
-    memleak_start();
-
-    config = fdb_get_default_config();
-    kvs_config = fdb_get_default_kvs_config();
-    config.multi_kv_instances = true;
-    config.wal_threshold = 50;
-    config.buffercache_size = 0;
+    fdb_config fconfig = fdb_get_default_config();
+    fdb_kvs_config kvs_config = fdb_get_default_kvs_config();
+    fconfig.buffercache_size = 0;
+    fconfig.wal_threshold = 1024;
+    fconfig.flags = FDB_OPEN_FLAG_CREATE;
+    fconfig.purging_interval = 0;
+    fconfig.compaction_threshold = 0;
 
-    s = fdb_open(&dbfile, "./dummy", &config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    if (opt & MULTI_KV_VAR_CMP) {
-        kvs_config.custom_cmp = _multi_kv_test_keycmp;
-    }
-    s = fdb_kvs_open_default(dbfile, &db, &kvs_config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    // open db
+    fdb_open(&dbfile, "./dummy1", &fconfig);
+    fdb_kvs_open_default(dbfile, &db, &kvs_config);
+    status = fdb_set_log_callback(db, logCallbackFunc,
+                                  (void *) "transaction_simple_api_test");
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-    // insert using 'default' instance
-    for (i=0;i<n;++i) {
-        sprintf(key, keystr, i);
-        sprintf(meta, metastr, i);
-        sprintf(value, valuestr, i);
-        fdb_doc_create(&doc, key, strlen(key)+1, meta,
-                           strlen(meta)+1, value, strlen(value)+1);
-        s = fdb_set(db, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        fdb_doc_free(doc);
+    // insert key-value pairs
+    for (i=0;i<n;++i){
+        sprintf(keybuf, "key%d", i);
+        sprintf(bodybuf, "body%d", i);
+        status = fdb_set_kv(db, keybuf, strlen(keybuf), bodybuf, strlen(bodybuf));
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
     }
 
-    // retrieve from WAL
-    for (i=0;i<n;++i){
-        // by key
-        sprintf(key, keystr, i);
-        sprintf(meta, metastr, i);
-        sprintf(value, valuestr, i);
-        s = fdb_get_kv(db, key, strlen(key)+1, &value_out, &valuelen);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, value_out, valuelen));
-        free(value_out);
+    // commit
+    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
 
-        // metaonly by key
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get_metaonly(db, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(doc->key, key, doc->keylen));
-        TEST_CHK(!memcmp(doc->meta, meta, doc->metalen));
-        fdb_doc_free(doc);
+    // open db and begin transactions
+    fdb_open(&dbfile_txn1, "./dummy1", &fconfig);
+    fdb_open(&dbfile_txn2, "./dummy1", &fconfig);
+    fdb_kvs_open_default(dbfile_txn1, &db_txn1, &kvs_config);
+    fdb_kvs_open_default(dbfile_txn2, &db_txn2, &kvs_config);
+    fdb_begin_transaction(dbfile_txn1, FDB_ISOLATION_READ_COMMITTED);
+    fdb_begin_transaction(dbfile_txn2, FDB_ISOLATION_READ_COMMITTED);
 
-        // by seq
-        fdb_doc_create(&doc, NULL, 0, NULL, 0, NULL, 0);
-        doc->seqnum = i+1;
-        s = fdb_get_byseq(db, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(doc->key, key, doc->keylen));
-        TEST_CHK(!memcmp(doc->body, value, doc->bodylen));
-        fdb_doc_free(doc);
+    // concurrently update docs
+    for (i=0;i<n;++i){
+        sprintf(keybuf, "key%d", i);
+        sprintf(bodybuf, "body%d_txn1", i);
+        fdb_set_kv(db_txn1, keybuf, strlen(keybuf), bodybuf, strlen(bodybuf));
 
-        // metaonly by seq
-        fdb_doc_create(&doc, NULL, 0, NULL, 0, NULL, 0);
-        doc->seqnum = i+1;
-        s = fdb_get_metaonly_byseq(db, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(doc->key, key, doc->keylen));
-        TEST_CHK(!memcmp(doc->meta, meta, doc->metalen));
-        fdb_doc_free(doc);
+        sprintf(keybuf, "key%d", i);
+        sprintf(bodybuf, "body%d_txn2", i);
+        fdb_set_kv(db_txn2, keybuf, strlen(keybuf), bodybuf, strlen(bodybuf));
     }
-    s = fdb_commit(dbfile, FDB_COMMIT_NORMAL);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
 
-    kvs_config.create_if_missing = false;
-    s = fdb_kvs_open(dbfile, &kv1, "kv1", &kvs_config);
-    TEST_CHK(s != FDB_RESULT_SUCCESS); // must fail
+    // retrieve key-value pairs
+    for (i=0;i<n;++i){
+        // general retrieval
+        sprintf(keybuf, "key%d", i);
+        sprintf(bodybuf, "body%d", i);
+        status = fdb_get_kv(db, keybuf, strlen(keybuf), &value, &valuelen);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, bodybuf, valuelen));
+        free(value);
 
-    kvs_config.create_if_missing = true;
-    s = fdb_kvs_open(dbfile, &kv1, "kv1", &kvs_config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
+        // txn1
+        sprintf(keybuf, "key%d", i);
+        sprintf(bodybuf, "body%d_txn1", i);
+        status = fdb_get_kv(db_txn1, keybuf, strlen(keybuf), &value, &valuelen);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, bodybuf, valuelen));
+        free(value);
 
-    // insert using 'kv1' instance
-    for (i=0;i<n;++i){
-        sprintf(key, keystr, i);
-        sprintf(meta, metastr_kv, i);
-        sprintf(value, valuestr_kv, i);
-        fdb_doc_create(&doc, key, strlen(key)+1, meta,
-                           strlen(meta)+1, value, strlen(value)+1);
-        s = fdb_set(kv1, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        fdb_doc_free(doc);
+        // txn2
+        sprintf(keybuf, "key%d", i);
+        sprintf(bodybuf, "body%d_txn2", i);
+        status = fdb_get_kv(db_txn2, keybuf, strlen(keybuf), &value, &valuelen);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, bodybuf, valuelen));
+        free(value);
     }
 
-    // retrieve from WAL
+    // commit txn1
+    fdb_end_transaction(dbfile_txn1, FDB_COMMIT_NORMAL);
     for (i=0;i<n;++i){
-        // by key
-        sprintf(key, keystr, i);
-        sprintf(meta, metastr_kv, i);
-        sprintf(value, valuestr_kv, i);
-        s = fdb_get_kv(kv1, key, strlen(key)+1, &value_out, &valuelen);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, value_out, valuelen));
-        free(value_out);
-
-        // metaonly by key
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get_metaonly(kv1, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(doc->key, key, doc->keylen));
-        TEST_CHK(!memcmp(doc->meta, meta, doc->metalen));
-        fdb_doc_free(doc);
-
-        // by seq
-        fdb_doc_create(&doc, NULL, 0, NULL, 0, NULL, 0);
-        doc->seqnum = i+1;
-        s = fdb_get_byseq(kv1, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(doc->key, key, doc->keylen));
-        TEST_CHK(!memcmp(doc->body, value, doc->bodylen));
-        fdb_doc_free(doc);
+        // general retrieval
+        sprintf(keybuf, "key%d", i);
+        sprintf(bodybuf, "body%d_txn1", i);
+        status = fdb_get_kv(db, keybuf, strlen(keybuf), &value, &valuelen);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, bodybuf, valuelen));
+        free(value);
 
-        // metaonly by seq
-        fdb_doc_create(&doc, NULL, 0, NULL, 0, NULL, 0);
-        doc->seqnum = i+1;
-        s = fdb_get_metaonly_byseq(kv1, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(doc->key, key, doc->keylen));
-        TEST_CHK(!memcmp(doc->meta, meta, doc->metalen));
-        fdb_doc_free(doc);
+        // txn2
+        sprintf(keybuf, "key%d", i);
+        sprintf(bodybuf, "body%d_txn2", i);
+        status = fdb_get_kv(db_txn2, keybuf, strlen(keybuf), &value, &valuelen);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, bodybuf, valuelen));
+        free(value);
     }
-    s = fdb_commit(dbfile, FDB_COMMIT_NORMAL);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
 
-    // retrieve from hb+trie
+    // commit txn2
+    fdb_end_transaction(dbfile_txn2, FDB_COMMIT_NORMAL);
     for (i=0;i<n;++i){
-        // ==== the default instance ====
-        // by key
-        sprintf(key, keystr, i);
-        sprintf(meta, metastr, i);
-        sprintf(value, valuestr, i);
-        s = fdb_get_kv(db, key, strlen(key)+1, &value_out, &valuelen);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, value_out, valuelen));
-        free(value_out);
+        // general retrieval
+        sprintf(keybuf, "key%d", i);
+        sprintf(bodybuf, "body%d_txn2", i);
+        status = fdb_get_kv(db, keybuf, strlen(keybuf), &value, &valuelen);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, bodybuf, valuelen));
+        free(value);
+    }
 
-        // metaonly by key
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get_metaonly(db, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(doc->key, key, doc->keylen));
-        TEST_CHK(!memcmp(doc->meta, meta, doc->metalen));
-        fdb_doc_free(doc);
+    // close db file
+    fdb_close(dbfile);
+    fdb_close(dbfile_txn1);
+    fdb_close(dbfile_txn2);
 
-        // by seq
-        fdb_doc_create(&doc, NULL, 0, NULL, 0, NULL, 0);
-        doc->seqnum = i+1;
-        s = fdb_get_byseq(db, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(doc->key, key, doc->keylen));
-        TEST_CHK(!memcmp(doc->body, value, doc->bodylen));
-        fdb_doc_free(doc);
+    // free all resources
+    fdb_shutdown();
 
-        // metaonly by seq
-        fdb_doc_create(&doc, NULL, 0, NULL, 0, NULL, 0);
-        doc->seqnum = i+1;
-        s = fdb_get_metaonly_byseq(db, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(doc->key, key, doc->keylen));
-        TEST_CHK(!memcmp(doc->meta, meta, doc->metalen));
+    memleak_end();
 
-        // by offset
-        s = fdb_get_byoffset(db, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(doc->key, key, doc->keylen));
-        TEST_CHK(!memcmp(doc->body, value, doc->bodylen));
-        fdb_doc_free(doc);
+    TEST_RESULT("transaction simple API test");
+}
 
-        // ==== 'kv1' instance ====
-        // by key
-        sprintf(meta, metastr_kv, i);
-        sprintf(value, valuestr_kv, i);
-        s = fdb_get_kv(kv1, key, strlen(key)+1, &value_out, &valuelen);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, value_out, valuelen));
-        free(value_out);
+void flush_before_commit_test()
+{
+    TEST_INIT();
 
-        // metaonly by key
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get_metaonly(kv1, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(doc->key, key, doc->keylen));
-        TEST_CHK(!memcmp(doc->meta, meta, doc->metalen));
-        fdb_doc_free(doc);
-
-        // by seq
-        fdb_doc_create(&doc, NULL, 0, NULL, 0, NULL, 0);
-        doc->seqnum = i+1;
-        s = fdb_get_byseq(kv1, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(doc->key, key, doc->keylen));
-        TEST_CHK(!memcmp(doc->body, value, doc->bodylen));
-        fdb_doc_free(doc);
+    memleak_start();
 
-        // metaonly by seq
-        fdb_doc_create(&doc, NULL, 0, NULL, 0, NULL, 0);
-        doc->seqnum = i+1;
-        s = fdb_get_metaonly_byseq(kv1, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(doc->key, key, doc->keylen));
-        TEST_CHK(!memcmp(doc->meta, meta, doc->metalen));
+    int i, r;
+    int n = 30;
+    fdb_file_handle *dbfile, *dbfile_txn;
+    fdb_kvs_handle *db, *db_txn;
+    fdb_doc **doc = alca(fdb_doc*, n);
+    fdb_status status;
 
-        // by offset
-        s = fdb_get_byoffset(kv1, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(doc->key, key, doc->keylen));
-        TEST_CHK(!memcmp(doc->body, value, doc->bodylen));
-        fdb_doc_free(doc);
-    }
+    char keybuf[256], metabuf[256], bodybuf[256];
 
-    // info check
-    s = fdb_get_file_info(dbfile, &file_info);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    TEST_CHK(file_info.doc_count == n*2);
-    s = fdb_get_kvs_info(db, &kvs_info);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    TEST_CHK(kvs_info.doc_count == n);
-    s = fdb_get_kvs_info(kv1, &kvs_info);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    TEST_CHK(kvs_info.doc_count == n);
+    // remove previous dummy files
+    r = system(SHELL_DEL" dummy* > errorlog.txt");
+    (void)r;
 
-    s = fdb_kvs_close(kv1);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_close(dbfile);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    fdb_config fconfig = fdb_get_default_config();
+    fdb_kvs_config kvs_config = fdb_get_default_kvs_config();
+    fconfig.buffercache_size = 0;
+    fconfig.wal_threshold = 5;
+    fconfig.flags = FDB_OPEN_FLAG_CREATE;
+    fconfig.purging_interval = 0;
+    fconfig.compaction_threshold = 0;
+    fconfig.wal_flush_before_commit = true;
 
-    if (opt & MULTI_KV_VAR_CMP) {
-        s = fdb_open_custom_cmp(&dbfile, "./dummy", &config,
-                                2, kvs_names, functions);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-    } else {
-        s = fdb_open(&dbfile, "./dummy", &config);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-    }
-    s = fdb_kvs_open(dbfile, &db, NULL, &kvs_config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_kvs_open(dbfile, &kv1, "kv1", &kvs_config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    // open db
+    fdb_open(&dbfile, "dummy1", &fconfig);
+    fdb_open(&dbfile_txn, "dummy1", &fconfig);
+    fdb_kvs_open_default(dbfile, &db, &kvs_config);
+    fdb_kvs_open_default(dbfile_txn, &db_txn, &kvs_config);
+    status = fdb_set_log_callback(db_txn, logCallbackFunc,
+                                  (void *) "flush_before_commit_test");
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-    // retrieve check after reopen
+    // create docs
     for (i=0;i<n;++i){
-        sprintf(key, keystr, i);
-        sprintf(value, valuestr, i);
-        s = fdb_get_kv(db, key, strlen(key)+1, &value_out, &valuelen);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, value_out, valuelen));
-        free(value_out);
+        sprintf(keybuf, "key%d", i);
+        sprintf(metabuf, "meta%d", i);
+        sprintf(bodybuf, "body%d", i);
+        fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
+                                (void*)metabuf, strlen(metabuf),
+                                (void*)bodybuf, strlen(bodybuf));
+    }
 
-        sprintf(value, valuestr_kv, i);
-        s = fdb_get_kv(kv1, key, strlen(key)+1, &value_out, &valuelen);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, value_out, valuelen));
-        free(value_out);
+    // non-transactional commit first, transactional commit next
+    fdb_begin_transaction(dbfile_txn, FDB_ISOLATION_READ_COMMITTED);
+    for (i=0;i<2;++i){
+        fdb_set(db, doc[i]);
     }
-    // info check after reopen
-    s = fdb_get_file_info(dbfile, &file_info);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    TEST_CHK(file_info.doc_count == n*2);
-    s = fdb_get_kvs_info(db, &kvs_info);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    TEST_CHK(kvs_info.doc_count == n);
-    s = fdb_get_kvs_info(kv1, &kvs_info);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    TEST_CHK(kvs_info.doc_count == n);
+    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+    for (i=0;i<2;++i){
+        fdb_set(db_txn, doc[i]);
+    }
+    fdb_end_transaction(dbfile_txn, FDB_COMMIT_NORMAL);
+    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
 
-    s = fdb_compact(dbfile, "./dummy2");
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    // retrieve check after compaction
-    for (i=0;i<n;++i){
-        sprintf(key, keystr, i);
-        sprintf(value, valuestr, i);
-        s = fdb_get_kv(db, key, strlen(key)+1, &value_out, &valuelen);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, value_out, valuelen));
-        free(value_out);
+    // transactional commit first, non-transactional commit next
+    fdb_begin_transaction(dbfile_txn, FDB_ISOLATION_READ_COMMITTED);
+    for (i=0;i<2;++i){
+        fdb_set(db_txn, doc[i]);
+    }
+    fdb_end_transaction(dbfile_txn, FDB_COMMIT_NORMAL);
+    for (i=0;i<2;++i){
+        fdb_set(db, doc[i]);
+    }
+    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
 
-        sprintf(value, valuestr_kv, i);
-        s = fdb_get_kv(kv1, key, strlen(key)+1, &value_out, &valuelen);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, value_out, valuelen));
-        free(value_out);
+    // concurrent update (non-txn commit first, txn commit next)
+    fdb_begin_transaction(dbfile_txn, FDB_ISOLATION_READ_COMMITTED);
+    for (i=0;i<2;++i){
+        fdb_set(db_txn, doc[i]);
     }
-    // info check after compaction
-    s = fdb_get_file_info(dbfile, &file_info);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    TEST_CHK(file_info.doc_count == n*2);
-    s = fdb_get_kvs_info(db, &kvs_info);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    TEST_CHK(kvs_info.doc_count == n);
-    s = fdb_get_kvs_info(kv1, &kvs_info);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    TEST_CHK(kvs_info.doc_count == n);
+    for (i=0;i<2;++i){
+        fdb_set(db, doc[i]);
+    }
+    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+    fdb_end_transaction(dbfile_txn, FDB_COMMIT_NORMAL);
+    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
 
-    // reopen using "default" KVS name
-    fdb_kvs_close(db);
-    s = fdb_kvs_open(dbfile, &db, "default", &kvs_config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    for (i=0;i<n;++i){
-        sprintf(key, keystr, i);
-        sprintf(value, valuestr, i);
-        s = fdb_get_kv(db, key, strlen(key)+1, &value_out, &valuelen);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, value_out, valuelen));
-        free(value_out);
+    // concurrent update (txn commit first, non-txn commit next)
+    fdb_begin_transaction(dbfile_txn, FDB_ISOLATION_READ_COMMITTED);
+    for (i=0;i<2;++i){
+        fdb_set(db, doc[i]);
     }
+    for (i=0;i<2;++i){
+        fdb_set(db_txn, doc[i]);
+    }
+    fdb_end_transaction(dbfile_txn, FDB_COMMIT_NORMAL);
+    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
 
-    s = fdb_kvs_remove(dbfile, "kv1");
-    // must fail due to opened handle
-    TEST_CHK(s != FDB_RESULT_SUCCESS);
+    // begin transaction
+    fdb_begin_transaction(dbfile_txn, FDB_ISOLATION_READ_COMMITTED);
 
-    // closing super handle also closes all other sub-handles;
-    s = fdb_close(dbfile);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    // insert docs using transaction
+    for (i=0;i<10;++i){
+        fdb_set(db_txn, doc[i]);
+    }
 
-    // re-open
-    if (opt & MULTI_KV_VAR_CMP) {
-        s = fdb_open_custom_cmp(&dbfile, "./dummy2", &config,
-                                2, kvs_names, functions);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-    } else {
-        s = fdb_open(&dbfile, "./dummy2", &config);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
+    // insert docs without transaction
+    for (i=10;i<20;++i){
+        fdb_set(db, doc[i]);
     }
 
-    // remove "kv1" instance
-    s = fdb_kvs_remove(dbfile, "kv1");
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_kvs_open(dbfile, &db, "default", &kvs_config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_kvs_open(dbfile, &kv1, "kv1", &kvs_config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    for (i=0;i<n;++i){
-        sprintf(key, keystr, i);
-        sprintf(value, valuestr, i);
-        s = fdb_get_kv(db, key, strlen(key)+1, &value_out, &valuelen);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, value_out, valuelen));
-        free(value_out);
+    // do compaction
+    fdb_compact(dbfile, "dummy2");
 
-        s = fdb_get_kv(kv1, key, strlen(key)+1, &value_out, &valuelen);
-        TEST_CHK(s != FDB_RESULT_SUCCESS);
+    for (i=20;i<25;++i){
+        fdb_set(db_txn, doc[i]);
     }
-    s = fdb_kvs_close(db);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_kvs_close(kv1);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    // end transaction
+    fdb_end_transaction(dbfile_txn, FDB_COMMIT_NORMAL);
 
-    // remove "default" instance
-    s = fdb_kvs_remove(dbfile, "default");
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_kvs_open(dbfile, &db, "default", &kvs_config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    for (i=0;i<n;++i){
-        sprintf(key, keystr, i);
-        s = fdb_get_kv(db, key, strlen(key)+1, &value_out, &valuelen);
-        TEST_CHK(s != FDB_RESULT_SUCCESS);
+    for (i=25;i<30;++i){
+        fdb_set(db, doc[i]);
     }
-    s = fdb_kvs_close(db);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
 
-    // remove the empty "kv1" instance
-    s = fdb_kvs_remove(dbfile, "kv1");
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    // close db file
+    fdb_close(dbfile);
+    fdb_close(dbfile_txn);
 
-    s = fdb_close(dbfile);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    // free all documents
+    for (i=0;i<n;++i){
+        fdb_doc_free(doc[i]);
+    }
+
+    // free all resources
+    fdb_shutdown();
 
-    s = fdb_shutdown();
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
     memleak_end();
 
-    if (opt & MULTI_KV_VAR_CMP) {
-        TEST_RESULT("multiple KV instances basic test "
-                    "(custom key order)");
-    } else {
-        TEST_RESULT("multiple KV instances basic test");
-    }
+    TEST_RESULT("flush before commit test");
 }
 
-void multi_kv_iterator_key_test(uint8_t opt)
+void flush_before_commit_multi_writers_test()
 {
     TEST_INIT();
 
-    int n = 100;
+    memleak_start();
+
     int i, r;
-    char key[256], value[256];
-    char keystr[] = "key%06d";
-    char valuestr[] = "value%08d(%s)";
-    fdb_file_handle *dbfile;
-    fdb_kvs_handle *db, *kv1, *kv2;
-    fdb_config config;
+    int n = 10;
+    fdb_file_handle *dbfile1, *dbfile2;
+    fdb_kvs_handle *db1, *db2;
+    fdb_doc **doc = alca(fdb_doc*, n);
+    fdb_doc *rdoc;
+    fdb_status status;
+    fdb_config fconfig;
     fdb_kvs_config kvs_config;
-    fdb_doc *doc;
-    fdb_iterator *it;
-    fdb_status s;
 
-    sprintf(value, SHELL_DEL" dummy*");
-    r = system(value);
+    char keybuf[256], metabuf[256], bodybuf[256];
+
+    // remove previous dummy files
+    r = system(SHELL_DEL" dummy* > errorlog.txt");
     (void)r;
 
-    memleak_start();
+    fconfig = fdb_get_default_config();
+    fconfig.buffercache_size = 0;
+    fconfig.wal_threshold = 8;
+    fconfig.flags = FDB_OPEN_FLAG_CREATE;
+    fconfig.purging_interval = 0;
+    fconfig.compaction_threshold = 0;
+    fconfig.wal_flush_before_commit = true;
 
-    config = fdb_get_default_config();
     kvs_config = fdb_get_default_kvs_config();
-    config.multi_kv_instances = true;
-    config.wal_threshold = 1000;
-    config.buffercache_size = 0;
-
-    s = fdb_open(&dbfile, "./dummy", &config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    if (opt & MULTI_KV_VAR_CMP) {
-        kvs_config.custom_cmp = _multi_kv_test_keycmp;
-    }
-    s = fdb_kvs_open(dbfile, &db, NULL, &kvs_config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_kvs_open(dbfile, &kv1, "kv1", &kvs_config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_kvs_open(dbfile, &kv2, "kv2", &kvs_config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
 
-    for (i=0;i<n;i+=2) {
-        sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "default");
-        s = fdb_set_kv(db, key, strlen(key)+1, value, strlen(value)+1);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        sprintf(value, valuestr, i, "kv1");
-        s = fdb_set_kv(kv1, key, strlen(key)+1, value, strlen(value)+1);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        sprintf(value, valuestr, i, "kv2");
-        s = fdb_set_kv(kv2, key, strlen(key)+1, value, strlen(value)+1);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-    }
-    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
+    // open db
+    fdb_open(&dbfile1, "dummy1", &fconfig);
+    fdb_kvs_open(dbfile1, &db1, NULL, &kvs_config);
 
-    for (i=1;i<n;i+=2) {
-        sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "default");
-        s = fdb_set_kv(db, key, strlen(key)+1, value, strlen(value)+1);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        sprintf(value, valuestr, i, "kv1");
-        s = fdb_set_kv(kv1, key, strlen(key)+1, value, strlen(value)+1);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        sprintf(value, valuestr, i, "kv2");
-        s = fdb_set_kv(kv2, key, strlen(key)+1, value, strlen(value)+1);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
+    // create & insert docs
+    for (i=0;i<n;++i){
+        sprintf(keybuf, "key%d", i);
+        sprintf(metabuf, "meta%d", i);
+        sprintf(bodybuf, "body%d", i);
+        fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
+                                (void*)metabuf, strlen(metabuf),
+                                (void*)bodybuf, strlen(bodybuf));
+        fdb_set(db1, doc[i]);
     }
-    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+    fdb_commit(dbfile1, FDB_COMMIT_MANUAL_WAL_FLUSH);
 
-    // iterate in default KV instance
-    i = 0;
-    s = fdb_iterator_init(db, &it, NULL, 0, NULL, 0, FDB_ITR_NONE);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    while (fdb_iterator_next(it, &doc) == FDB_RESULT_SUCCESS) {
-        sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "default");
-        TEST_CHK(!memcmp(doc->key, key, doc->keylen));
-        TEST_CHK(!memcmp(doc->body, value, doc->bodylen));
-        r = ((i%2 == 0)?(i/2):(50+i/2)) +1;
-        TEST_CHK(doc->seqnum == r);
-        fdb_doc_free(doc);
-        i++;
-    }
-    TEST_CHK(i == n);
-    fdb_iterator_close(it);
+    // open second writer
+    fdb_open(&dbfile2, "dummy1", &fconfig);
+    fdb_kvs_open(dbfile2, &db2, NULL, &kvs_config);
 
-    // iterate in kv1 instance
-    i = 0;
-    s = fdb_iterator_init(kv1, &it, NULL, 0, NULL, 0, FDB_ITR_NONE);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    while (fdb_iterator_next(it, &doc) == FDB_RESULT_SUCCESS) {
-        sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "kv1");
-        TEST_CHK(!memcmp(doc->key, key, doc->keylen));
-        TEST_CHK(!memcmp(doc->body, value, doc->bodylen));
-        r = ((i%2 == 0)?(i/2):(50+i/2)) +1;
-        TEST_CHK(doc->seqnum == r);
-        fdb_doc_free(doc);
-        i++;
+    for (i=0;i<n/2;++i){
+        sprintf(metabuf, "meta2%d", i);
+        sprintf(bodybuf, "body2%d(db2)", i);
+        fdb_doc_update(&doc[i], (void *)metabuf, strlen(metabuf),
+            (void *)bodybuf, strlen(bodybuf));
+        fdb_set(db2, doc[i]);
     }
-    TEST_CHK(i == n);
-    // reverse iterate in kv1 instance
-    while (fdb_iterator_prev(it, &doc) == FDB_RESULT_SUCCESS) {
-        i--;
-        sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "kv1");
-        TEST_CHK(!memcmp(doc->key, key, doc->keylen));
-        TEST_CHK(!memcmp(doc->body, value, doc->bodylen));
-        r = ((i%2 == 0)?(i/2):(50+i/2)) +1;
-        TEST_CHK(doc->seqnum == r);
-        fdb_doc_free(doc);
+    for (i=n/2;i<n;++i){
+        sprintf(metabuf, "meta2%d", i);
+        sprintf(bodybuf, "body2%d(db1)", i);
+        fdb_doc_update(&doc[i], (void *)metabuf, strlen(metabuf),
+            (void *)bodybuf, strlen(bodybuf));
+        fdb_set(db1, doc[i]);
     }
-    TEST_CHK(i == 0);
-    fdb_iterator_close(it);
 
-    // iterate in kv2 instance
-    i = 0;
-    s = fdb_iterator_init(kv2, &it, NULL, 0, NULL, 0, FDB_ITR_NONE);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    while (fdb_iterator_next(it, &doc) == FDB_RESULT_SUCCESS) {
-        sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "kv2");
-        TEST_CHK(!memcmp(doc->key, key, doc->keylen));
-        TEST_CHK(!memcmp(doc->body, value, doc->bodylen));
-        fdb_doc_free(doc);
-        i++;
-    }
-    TEST_CHK(i == n);
-    fdb_iterator_close(it);
+    // retrieve before commit
+    for (i=0;i<n;++i){
+        sprintf(keybuf, "key%d", i);
+        sprintf(metabuf, "meta2%d", i);
+        if (i < n/2) {
+            sprintf(bodybuf, "body2%d(db2)", i);
+        } else {
+            sprintf(bodybuf, "body2%d(db1)", i);
+        }
+        // retrieve through db1
+        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf),
+                                NULL, 0, NULL, 0);
+        status = fdb_get(db1, rdoc);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(metabuf, rdoc->meta, rdoc->metalen));
+        TEST_CHK(!memcmp(bodybuf, rdoc->body, rdoc->bodylen));
+        fdb_doc_free(rdoc);
 
-    // partial iterate in kv1 instance
-    i = 40;
-    char key2[256];
-    sprintf(key, keystr, 40);
-    sprintf(key2, keystr, 59);
-    s = fdb_iterator_init(kv1, &it, key, strlen(key)+1, key2, strlen(key2)+1, FDB_ITR_NONE);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    while (fdb_iterator_next(it, &doc) == FDB_RESULT_SUCCESS) {
-        sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "kv1");
-        TEST_CHK(!memcmp(doc->key, key, doc->keylen));
-        TEST_CHK(!memcmp(doc->body, value, doc->bodylen));
-        fdb_doc_free(doc);
-        i++;
+        // retrieve through db2
+        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf),
+                                NULL, 0, NULL, 0);
+        status = fdb_get(db2, rdoc);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(metabuf, rdoc->meta, rdoc->metalen));
+        TEST_CHK(!memcmp(bodybuf, rdoc->body, rdoc->bodylen));
+        fdb_doc_free(rdoc);
     }
-    TEST_CHK(i == 60);
-    fdb_iterator_close(it);
-
-    s = fdb_kvs_close(kv1);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_kvs_close(kv2);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_close(dbfile);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_shutdown();
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
 
-    memleak_end();
+    fdb_commit(dbfile1, FDB_COMMIT_NORMAL);
+    fdb_commit(dbfile2, FDB_COMMIT_NORMAL);
 
-    if (opt & MULTI_KV_VAR_CMP) {
-        TEST_RESULT("multiple KV instances iterator test "
-                    "(custom key order)");
-    } else {
-        TEST_RESULT("multiple KV instances iterator test");
-    }
-}
+    // retrieve after commit
+    for (i=0;i<n;++i){
+        sprintf(keybuf, "key%d", i);
+        sprintf(metabuf, "meta2%d", i);
+        if (i < n/2) {
+            sprintf(bodybuf, "body2%d(db2)", i);
+        } else {
+            sprintf(bodybuf, "body2%d(db1)", i);
+        }
+        // retrieve through db1
+        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf),
+                                NULL, 0, NULL, 0);
+        status = fdb_get(db1, rdoc);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(metabuf, rdoc->meta, rdoc->metalen));
+        TEST_CHK(!memcmp(bodybuf, rdoc->body, rdoc->bodylen));
+        fdb_doc_free(rdoc);
 
-void multi_kv_iterator_seq_test(uint8_t opt)
-{
-    TEST_INIT();
+        // retrieve through db2
+        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf),
+                                NULL, 0, NULL, 0);
+        status = fdb_get(db2, rdoc);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(metabuf, rdoc->meta, rdoc->metalen));
+        TEST_CHK(!memcmp(bodybuf, rdoc->body, rdoc->bodylen));
+        fdb_doc_free(rdoc);
+    }
 
-    int n = 100;
-    int i, r;
-    char key[256], value[256];
-    char keystr[] = "key%06d";
-    char valuestr[] = "value%08d(%s)";
-    fdb_file_handle *dbfile;
-    fdb_kvs_handle *db, *kv1, *kv2;
-    fdb_config config;
-    fdb_kvs_config kvs_config;
-    fdb_doc *doc;
-    fdb_iterator *it;
-    fdb_status s;
-    fdb_seqnum_t seqnum;
+    // close db file
+    fdb_close(dbfile1);
+    fdb_close(dbfile2);
 
-    sprintf(value, SHELL_DEL" dummy*");
-    r = system(value);
-    (void)r;
+    // free all documents
+    for (i=0;i<n;++i){
+        fdb_doc_free(doc[i]);
+    }
+
+    // free all resources
+    fdb_shutdown();
+
+    memleak_end();
+
+    TEST_RESULT("flush before commit with multi writers test");
+}
+
+void last_wal_flush_header_test()
+{
+    TEST_INIT();
 
     memleak_start();
 
-    config = fdb_get_default_config();
-    kvs_config = fdb_get_default_kvs_config();
-    config.multi_kv_instances = true;
-    config.wal_threshold = 1000;
-    config.buffercache_size = 0;
+    int i, r;
+    int n = 30;
+    fdb_file_handle *dbfile, *dbfile_txn1, *dbfile_txn2;
+    fdb_kvs_handle *db, *db_txn1, *db_txn2;
+    fdb_doc **doc = alca(fdb_doc*, n);
+    fdb_doc *rdoc;
+    fdb_status status;
 
-    s = fdb_open(&dbfile, "./dummy", &config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    if (opt & MULTI_KV_VAR_CMP) {
-        kvs_config.custom_cmp = _multi_kv_test_keycmp;
-    }
-    s = fdb_kvs_open(dbfile, &db, NULL, &kvs_config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_kvs_open(dbfile, &kv1, "kv1", &kvs_config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_kvs_open(dbfile, &kv2, "kv2", &kvs_config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    char keybuf[256], metabuf[256], bodybuf[256];
 
-    // write documents first time
-    for (i=0;i<n;++i){
-        sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "default");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
-        s = fdb_set(db, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv1");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
-        s = fdb_set(kv1, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv2");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
-        s = fdb_set(kv2, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        fdb_doc_free(doc);
-    }
-    s = fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    // remove previous dummy files
+    r = system(SHELL_DEL" dummy* > errorlog.txt");
+    (void)r;
 
-    // re-write documents
+    fdb_config fconfig = fdb_get_default_config();
+    fdb_kvs_config kvs_config = fdb_get_default_kvs_config();
+    fconfig.buffercache_size = 0;
+    fconfig.flags = FDB_OPEN_FLAG_CREATE;
+    fconfig.purging_interval = 0;
+    fconfig.compaction_threshold = 0;
+
+    // open db
+    fdb_open(&dbfile, "dummy1", &fconfig);
+    fdb_open(&dbfile_txn1, "dummy1", &fconfig);
+    fdb_kvs_open_default(dbfile, &db, &kvs_config);
+    fdb_kvs_open_default(dbfile_txn1, &db_txn1, &kvs_config);
+
+    // create docs
     for (i=0;i<n;++i){
-        sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "default_second");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
-        s = fdb_set(db, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv1_second");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
-        s = fdb_set(kv1, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv2_second");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
-        s = fdb_set(kv2, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        fdb_doc_free(doc);
+        sprintf(keybuf, "key%d", i);
+        sprintf(metabuf, "meta%d", i);
+        sprintf(bodybuf, "body%d", i);
+        fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
+                                (void*)metabuf, strlen(metabuf),
+                                (void*)bodybuf, strlen(bodybuf));
     }
-    s = fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
 
-    // write third time (even number docs only)
-    for (i=0;i<n;i+=2){
-        sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "default_third");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
-        s = fdb_set(db, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv1_third");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
-        s = fdb_set(kv1, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv2_third");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
-        s = fdb_set(kv2, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        fdb_doc_free(doc);
+    // insert docs without transaction
+    for (i=0;i<2;++i) {
+        fdb_set(db, doc[i]);
     }
-    s = fdb_commit(dbfile, FDB_COMMIT_NORMAL);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-
-    // iterate in default KV instance
-    i = 0;
-    s = fdb_iterator_sequence_init(db, &it, 0, 0, FDB_ITR_NONE);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    while (fdb_iterator_next(it, &doc) == FDB_RESULT_SUCCESS) {
-        fdb_doc_free(doc);
-        i++;
+    // insert docs using transaction
+    fdb_begin_transaction(dbfile_txn1, FDB_ISOLATION_READ_COMMITTED);
+    for (i=2;i<4;++i){
+        fdb_set(db_txn1, doc[i]);
     }
-    TEST_CHK(i == n);
-    fdb_iterator_close(it);
+    // commit without transaction
+    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
 
-    // iterate in KV1
-    i = 0;
-    s = fdb_iterator_sequence_init(kv1, &it, 0, 0, FDB_ITR_NONE);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    while (fdb_iterator_next(it, &doc) == FDB_RESULT_SUCCESS) {
-        if (i < 50) {
-            r = i*2 + 1;
-            seqnum = 100 + (i+1)*2;
-            sprintf(value, valuestr, r, "kv1_second");
+    // close & reopen db
+    fdb_close(dbfile);
+    fdb_close(dbfile_txn1);
+    fdb_open(&dbfile, "dummy1", &fconfig);
+    fdb_open(&dbfile_txn1, "dummy1", &fconfig);
+    fdb_kvs_open_default(dbfile, &db, &kvs_config);
+    fdb_kvs_open_default(dbfile_txn1, &db_txn1, &kvs_config);
+
+    // retrieve check
+    for (i=0;i<4;++i){
+        fdb_doc_create(&rdoc, doc[i]->key, doc[i]->keylen, NULL, 0, NULL, 0);
+        status = fdb_get(db, rdoc);
+        if (i<2) {
+            TEST_CHK(status == FDB_RESULT_SUCCESS);
         } else {
-            r = (i-50)*2;
-            seqnum = 151 + i;
-            sprintf(value, valuestr, r, "kv1_third");
+            TEST_CHK(status != FDB_RESULT_SUCCESS);
         }
-        sprintf(key, keystr, r);
-        TEST_CHK(!memcmp(key, doc->key, doc->keylen));
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
-        TEST_CHK(doc->seqnum == seqnum);
-        fdb_doc_free(doc);
-        i++;
+        fdb_doc_free(rdoc);
     }
-    TEST_CHK(i == n);
-    // reverse iterate in KV1
-    while (fdb_iterator_prev(it, &doc) == FDB_RESULT_SUCCESS) {
-        i--;
-        if (i < 50) {
-            r = i*2 + 1;
-            seqnum = 100 + (i+1)*2;
-            sprintf(value, valuestr, r, "kv1_second");
+
+    // insert docs using transaction
+    fdb_begin_transaction(dbfile_txn1, FDB_ISOLATION_READ_COMMITTED);
+    for (i=2;i<4;++i){
+        fdb_set(db_txn1, doc[i]);
+    }
+    // insert docs without transaction
+    for (i=4;i<6;++i){
+        fdb_set(db, doc[i]);
+    }
+    fdb_end_transaction(dbfile_txn1, FDB_COMMIT_MANUAL_WAL_FLUSH);
+
+    // close & reopen db
+    fdb_close(dbfile);
+    fdb_close(dbfile_txn1);
+    fdb_open(&dbfile, "dummy1", &fconfig);
+    fdb_open(&dbfile_txn1, "dummy1", &fconfig);
+    fdb_kvs_open_default(dbfile, &db, &kvs_config);
+    fdb_kvs_open_default(dbfile_txn1, &db_txn1, &kvs_config);
+
+    // retrieve check
+    for (i=0;i<6;++i){
+        fdb_doc_create(&rdoc, doc[i]->key, doc[i]->keylen, NULL, 0, NULL, 0);
+        status = fdb_get(db, rdoc);
+        if (i<4) {
+            TEST_CHK(status == FDB_RESULT_SUCCESS);
         } else {
-            r = (i-50)*2;
-            seqnum = 151 + i;
-            sprintf(value, valuestr, r, "kv1_third");
+            // doesn't matter
         }
-        sprintf(key, keystr, r);
-        TEST_CHK(!memcmp(key, doc->key, doc->keylen));
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
-        TEST_CHK(doc->seqnum == seqnum);
-        fdb_doc_free(doc);
+        fdb_doc_free(rdoc);
     }
-    TEST_CHK(i == 0);
-    fdb_iterator_close(it);
 
-    // iterate in KV2
-    i = 0;
-    s = fdb_iterator_sequence_init(kv2, &it, 0, 0, FDB_ITR_NONE);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    while (fdb_iterator_next(it, &doc) == FDB_RESULT_SUCCESS) {
-        if (i < 50) {
-            r = i*2 + 1;
-            seqnum = 100 + (i+1)*2;
-            sprintf(value, valuestr, r, "kv2_second");
-        } else {
-            r = (i-50)*2;
-            seqnum = 151 + i;
-            sprintf(value, valuestr, r, "kv2_third");
-        }
-        (void)seqnum;
-        sprintf(key, keystr, r);
-        fdb_doc_free(doc);
-        i++;
+    // insert docs without transaction
+    for (i=4;i<6;++i) {
+        fdb_set(db, doc[i]);
     }
-    TEST_CHK(i == n);
-    fdb_iterator_close(it);
+    fdb_begin_transaction(dbfile_txn1, FDB_ISOLATION_READ_COMMITTED);
+    for (i=6;i<8;++i) {
+        fdb_set(db_txn1, doc[i]);
+    }
+    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
 
-    // partial iterate in KV1
-    i = 0;
-    s = fdb_iterator_sequence_init(kv1, &it, 150, 220, FDB_ITR_NONE);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    while (fdb_iterator_next(it, &doc) == FDB_RESULT_SUCCESS) {
-        //printf("%d %s %s %d\n", i, (char*)doc->key, (char*)doc->body, (int)doc->seqnum);
-        if (i<26) {
-            r = 49 + i*2;
-            seqnum = i*2 + 150;
-            sprintf(value, valuestr, r, "kv1_second");
+    // begin another transaction
+    fdb_open(&dbfile_txn2, "dummy1", &fconfig);
+    fdb_kvs_open_default(dbfile_txn2, &db_txn2, &kvs_config);
+    fdb_begin_transaction(dbfile_txn2, FDB_ISOLATION_READ_COMMITTED);
+    for (i=8;i<10;++i){
+        fdb_set(db_txn2, doc[i]);
+    }
+    fdb_end_transaction(dbfile_txn2, FDB_COMMIT_MANUAL_WAL_FLUSH);
+
+    // close & reopen db
+    fdb_close(dbfile);
+    fdb_close(dbfile_txn1);
+    fdb_close(dbfile_txn2);
+    fdb_open(&dbfile, "dummy1", &fconfig);
+    fdb_kvs_open_default(dbfile, &db, &kvs_config);
+
+    // retrieve check
+    for (i=0;i<10;++i){
+        fdb_doc_create(&rdoc, doc[i]->key, doc[i]->keylen, NULL, 0, NULL, 0);
+        status = fdb_get(db, rdoc);
+        if (i<6 || i>=8) {
+            TEST_CHK(status == FDB_RESULT_SUCCESS);
         } else {
-            r = (i-26)*2;
-            seqnum = 201 + (i-26);
-            sprintf(value, valuestr, r, "kv1_third");
+            TEST_CHK(status != FDB_RESULT_SUCCESS);
         }
-        (void)seqnum;
-        fdb_doc_free(doc);
-        i++;
+        fdb_doc_free(rdoc);
     }
-    TEST_CHK(i == 46);
-    fdb_iterator_close(it);
 
-    s = fdb_kvs_close(kv1);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_kvs_close(kv2);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_close(dbfile);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_shutdown();
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    fdb_open(&dbfile_txn1, "dummy1", &fconfig);
+    fdb_open(&dbfile_txn2, "dummy1", &fconfig);
+    fdb_kvs_open_default(dbfile_txn1, &db_txn1, &kvs_config);
+    fdb_kvs_open_default(dbfile_txn2, &db_txn2, &kvs_config);
+    fdb_begin_transaction(dbfile_txn1, FDB_ISOLATION_READ_COMMITTED);
 
-    memleak_end();
+    fdb_set(db, doc[10]);
+    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
 
-    if (opt & MULTI_KV_VAR_CMP) {
-        TEST_RESULT("multiple KV instances sequence iterator test "
-                    "(custom key order)");
-    } else {
-        TEST_RESULT("multiple KV instances sequence iterator test");
+    fdb_set(db, doc[11]);
+    fdb_set(db_txn1, doc[12]);
+    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
+
+    fdb_set(db_txn1, doc[13]);
+    fdb_begin_transaction(dbfile_txn2, FDB_ISOLATION_READ_COMMITTED);
+    fdb_set(db_txn2, doc[14]);
+    fdb_end_transaction(dbfile_txn1, FDB_COMMIT_MANUAL_WAL_FLUSH);
+
+    fdb_set(db_txn2, doc[15]);
+    fdb_set(db, doc[16]);
+    fdb_end_transaction(dbfile_txn2, FDB_COMMIT_MANUAL_WAL_FLUSH);
+
+    fdb_set(db, doc[17]);
+    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+
+    fdb_close(dbfile);
+    fdb_close(dbfile_txn1);
+    fdb_close(dbfile_txn2);
+    fdb_open(&dbfile, "dummy1", &fconfig);
+    fdb_kvs_open_default(dbfile, &db, &kvs_config);
+
+    // retrieve check
+    for (i=10;i<18;++i){
+        fdb_doc_create(&rdoc, doc[i]->key, doc[i]->keylen, NULL, 0, NULL, 0);
+        status = fdb_get(db, rdoc);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        fdb_doc_free(rdoc);
+    }
+
+    fdb_open(&dbfile_txn1, "dummy1", &fconfig);
+    fdb_kvs_open_default(dbfile_txn1, &db_txn1, &kvs_config);
+    fdb_begin_transaction(dbfile_txn1, FDB_ISOLATION_READ_COMMITTED);
+    fdb_set(db_txn1, doc[20]);
+
+    fdb_compact(dbfile, "dummy2");
+
+    fdb_end_transaction(dbfile_txn1, FDB_COMMIT_MANUAL_WAL_FLUSH);
+    fdb_close(dbfile);
+    fdb_close(dbfile_txn1);
+
+    // free all documents
+    for (i=0;i<n;++i){
+        fdb_doc_free(doc[i]);
     }
+
+    // free all resources
+    fdb_shutdown();
+
+    memleak_end();
+
+    TEST_RESULT("last wal flush header test");
 }
 
-void multi_kv_txn_test(uint8_t opt)
+void long_key_test()
 {
     TEST_INIT();
 
-    int n = 100;
-    int i, r;
-    char key[256], value[256];
-    char keystr[] = "key%06d";
-    char valuestr[] = "value%08d(%s)";
-    fdb_file_handle *dbfile, *dbfile_txn1;
-    fdb_kvs_handle *db, *kv1, *kv2;
-    fdb_kvs_handle *txn1, *txn1_kv1, *txn1_kv2;
-    fdb_config config;
-    fdb_kvs_config kvs_config;
-    fdb_doc *doc;
-    fdb_status s;
+    memleak_start();
 
-    char *kvs_names[] = {(char*)"default", (char*)"kv1", (char*)"kv2"};
-    fdb_custom_cmp_variable functions[] = {_multi_kv_test_keycmp,
-                                           _multi_kv_test_keycmp,
-                                           _multi_kv_test_keycmp};
+    int i, j, idx, r;
+    int n=300, m=20; // n: # prefixes, m: # postfixes
+    int keylen_limit;
+    fdb_file_handle *dbfile;
+    fdb_kvs_handle *db;
+    fdb_doc **doc = alca(fdb_doc*, n*m);
+    fdb_doc *rdoc;
+    fdb_status status;
 
-    sprintf(value, SHELL_DEL" dummy*");
-    r = system(value);
+    char *keybuf;
+    char metabuf[256], bodybuf[256], temp[256];
+
+    // remove previous dummy files
+    r = system(SHELL_DEL" dummy* > errorlog.txt");
     (void)r;
 
-    memleak_start();
+    fdb_config fconfig = fdb_get_default_config();
+    fdb_kvs_config kvs_config = fdb_get_default_kvs_config();
+    fconfig.buffercache_size = 0;
+    fconfig.flags = FDB_OPEN_FLAG_CREATE;
+    fconfig.purging_interval = 0;
+    fconfig.compaction_threshold = 0;
 
-    config = fdb_get_default_config();
-    kvs_config = fdb_get_default_kvs_config();
-    config.multi_kv_instances = true;
-    config.wal_threshold = 1000;
-    config.buffercache_size = 0;
+    keylen_limit = fconfig.blocksize - 256;
+    keybuf = alca(char, keylen_limit);
 
-    s = fdb_open(&dbfile, "./dummy", &config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    if (opt & MULTI_KV_VAR_CMP) {
-        kvs_config.custom_cmp = _multi_kv_test_keycmp;
+    // open db
+    fdb_open(&dbfile, "dummy1", &fconfig);
+    fdb_kvs_open_default(dbfile, &db, &kvs_config);
+
+    // key structure:
+    // <------------ <keylen_limit> bytes ------------->
+    // <-- 8 bytes -->             <-- 8 bytes  -->< 1 >
+    // [prefix number]____ ... ____[postfix number][ \0]
+    // e.g.)
+    // 00000001____ ... ____00000013[\0]
+
+    // create docs
+    for (i=0;i<keylen_limit-1;++i){
+        keybuf[i] = '_';
     }
-    s = fdb_kvs_open(dbfile, &db, NULL, &kvs_config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_kvs_open(dbfile, &kv1, "kv1", &kvs_config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_kvs_open(dbfile, &kv2, "kv2", &kvs_config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    keybuf[keylen_limit-1] = 0;
 
-    // write documents first time
     for (i=0;i<n;++i){
-        sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "default");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
-        s = fdb_set(db, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv1");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
-        s = fdb_set(kv1, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv2");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
-        s = fdb_set(kv2, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        fdb_doc_free(doc);
+        // set prefix
+        sprintf(temp, "%08d", i);
+        memcpy(keybuf, temp, 8);
+        for (j=0;j<m;++j){
+            idx = i*m + j;
+            // set postfix
+            sprintf(temp, "%08d", j);
+            memcpy(keybuf + (keylen_limit-1) - 8, temp, 8);
+            sprintf(metabuf, "meta%d", idx);
+            sprintf(bodybuf, "body%d", idx);
+            fdb_doc_create(&doc[idx], (void*)keybuf, strlen(keybuf)+1,
+                                    (void*)metabuf, strlen(metabuf)+1,
+                                    (void*)bodybuf, strlen(bodybuf)+1);
+        }
     }
-    s = fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
 
-    // begin a transaction
-    if (opt & MULTI_KV_VAR_CMP) {
-        s = fdb_open_custom_cmp(&dbfile_txn1, "./dummy", &config,
-                                3, kvs_names, functions);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-    } else {
-        s = fdb_open(&dbfile_txn1, "./dummy", &config);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
+    // insert docs
+    for (i=0;i<n*m;++i) {
+        fdb_set(db, doc[i]);
     }
-    s = fdb_kvs_open(dbfile_txn1, &txn1, NULL, &kvs_config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_kvs_open(dbfile_txn1, &txn1_kv1, "kv1", &kvs_config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_kvs_open(dbfile_txn1, &txn1_kv2, "kv2", &kvs_config);
+    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
+
+    // retrieval check
+    for (i=0;i<n*m;++i){
+        fdb_doc_create(&rdoc, doc[i]->key, doc[i]->keylen, NULL, 0, NULL, 0);
+        status = fdb_get(db, rdoc);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(rdoc->key, doc[i]->key, rdoc->keylen));
+        TEST_CHK(!memcmp(rdoc->meta, doc[i]->meta, rdoc->metalen));
+        TEST_CHK(!memcmp(rdoc->body, doc[i]->body, rdoc->bodylen));
+        fdb_doc_free(rdoc);
+    }
+
+    fdb_close(dbfile);
+
+    // free all documents
+    for (i=0;i<n*m;++i){
+        fdb_doc_free(doc[i]);
+    }
+
+    // free all resources
+    fdb_shutdown();
+
+    memleak_end();
+
+    TEST_RESULT("long key test");
+}
+
+// lexicographically compares two variable-length binary streams
+#define MIN(a,b) (((a)<(b))?(a):(b))
+static int _multi_kv_test_keycmp(void *key1, size_t keylen1, void *key2, size_t keylen2)
+{
+    if (keylen1 == keylen2) {
+        return memcmp(key1, key2, keylen1);
+    }else {
+        size_t len = MIN(keylen1, keylen2);
+        int cmp = memcmp(key1, key2, len);
+        if (cmp != 0) return cmp;
+        else {
+            return (int)((int)keylen1 - (int)keylen2);
+        }
+    }
+}
+
+#define MULTI_KV_VAR_CMP (0x1)
+void multi_kv_test(uint8_t opt)
+{
+    TEST_INIT();
+
+    int n = 100;
+    int i, r;
+    char key[256], meta[256], value[256];
+    char keystr[] = "key%06d";
+    char metastr[] = "meta%06d";
+    char metastr_kv[] = "meta%06d(kv)";
+    char valuestr[] = "value%08d";
+    char valuestr_kv[] = "value%08d (kv instance)";
+    void *value_out;
+    size_t valuelen;
+
+    char *kvs_names[] = {NULL, (char*)"kv1"};
+    fdb_custom_cmp_variable functions[] = {_multi_kv_test_keycmp,
+                                           _multi_kv_test_keycmp};
+
+    fdb_file_handle *dbfile;
+    fdb_kvs_handle *db, *kv1;
+    fdb_config config;
+    fdb_kvs_config kvs_config;
+    fdb_doc *doc;
+    fdb_file_info file_info;
+    fdb_kvs_info kvs_info;
+    fdb_status s;
+
+    sprintf(value, SHELL_DEL" dummy*");
+    r = system(value);
+    (void)r;
+
+    memleak_start();
+
+    config = fdb_get_default_config();
+    kvs_config = fdb_get_default_kvs_config();
+    config.multi_kv_instances = true;
+    config.wal_threshold = 50;
+    config.buffercache_size = 0;
+
+    s = fdb_open(&dbfile, "./dummy", &config);
     TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_begin_transaction(dbfile_txn1, FDB_ISOLATION_READ_COMMITTED);
+    if (opt & MULTI_KV_VAR_CMP) {
+        kvs_config.custom_cmp = _multi_kv_test_keycmp;
+    }
+    s = fdb_kvs_open_default(dbfile, &db, &kvs_config);
     TEST_CHK(s == FDB_RESULT_SUCCESS);
 
-    for (i=0;i<n;++i){
+    // insert using 'default' instance
+    for (i=0;i<n;++i) {
         sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "default(txn)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
-        s = fdb_set(txn1, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv1(txn)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
-        s = fdb_set(txn1_kv1, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv2(txn)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
-        s = fdb_set(txn1_kv2, doc);
+        sprintf(meta, metastr, i);
+        sprintf(value, valuestr, i);
+        fdb_doc_create(&doc, key, strlen(key)+1, meta,
+                           strlen(meta)+1, value, strlen(value)+1);
+        s = fdb_set(db, doc);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
         fdb_doc_free(doc);
     }
 
-    // retrieve before commit (dirty read through the transaction)
+    // retrieve from WAL
     for (i=0;i<n;++i){
+        // by key
         sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "default(txn)");
+        sprintf(meta, metastr, i);
+        sprintf(value, valuestr, i);
+        s = fdb_get_kv(db, key, strlen(key)+1, &value_out, &valuelen);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, value_out, valuelen));
+        free(value_out);
+
+        // metaonly by key
         fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(txn1, doc);
+        s = fdb_get_metaonly(db, doc);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        TEST_CHK(!memcmp(doc->key, key, doc->keylen));
+        TEST_CHK(!memcmp(doc->meta, meta, doc->metalen));
         fdb_doc_free(doc);
+
+        // by seq
+        fdb_doc_create(&doc, NULL, 0, NULL, 0, NULL, 0);
+        doc->seqnum = i+1;
+        s = fdb_get_byseq(db, doc);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
-        sprintf(value, valuestr, i, "kv1(txn)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(txn1_kv1, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        TEST_CHK(!memcmp(doc->key, key, doc->keylen));
+        TEST_CHK(!memcmp(doc->body, value, doc->bodylen));
         fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv2(txn)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(txn1_kv2, doc);
+
+        // metaonly by seq
+        fdb_doc_create(&doc, NULL, 0, NULL, 0, NULL, 0);
+        doc->seqnum = i+1;
+        s = fdb_get_metaonly_byseq(db, doc);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        TEST_CHK(!memcmp(doc->key, key, doc->keylen));
+        TEST_CHK(!memcmp(doc->meta, meta, doc->metalen));
         fdb_doc_free(doc);
     }
+    s = fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
 
-    // retrieve before commit (isolation test)
+    kvs_config.create_if_missing = false;
+    s = fdb_kvs_open(dbfile, &kv1, "kv1", &kvs_config);
+    TEST_CHK(s != FDB_RESULT_SUCCESS); // must fail
+
+    kvs_config.create_if_missing = true;
+    s = fdb_kvs_open(dbfile, &kv1, "kv1", &kvs_config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    // insert using 'kv1' instance
     for (i=0;i<n;++i){
         sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "default");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(db, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
-        fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv1");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(kv1, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
-        fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv2");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(kv2, doc);
+        sprintf(meta, metastr_kv, i);
+        sprintf(value, valuestr_kv, i);
+        fdb_doc_create(&doc, key, strlen(key)+1, meta,
+                           strlen(meta)+1, value, strlen(value)+1);
+        s = fdb_set(kv1, doc);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
         fdb_doc_free(doc);
     }
 
-    s = fdb_end_transaction(dbfile_txn1, FDB_COMMIT_NORMAL);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-
-    // retrieve after commit (through the transaction)
+    // retrieve from WAL
     for (i=0;i<n;++i){
+        // by key
         sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "default(txn)");
+        sprintf(meta, metastr_kv, i);
+        sprintf(value, valuestr_kv, i);
+        s = fdb_get_kv(kv1, key, strlen(key)+1, &value_out, &valuelen);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, value_out, valuelen));
+        free(value_out);
+
+        // metaonly by key
         fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(txn1, doc);
+        s = fdb_get_metaonly(kv1, doc);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        TEST_CHK(!memcmp(doc->key, key, doc->keylen));
+        TEST_CHK(!memcmp(doc->meta, meta, doc->metalen));
         fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv1(txn)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(txn1_kv1, doc);
+
+        // by seq
+        fdb_doc_create(&doc, NULL, 0, NULL, 0, NULL, 0);
+        doc->seqnum = i+1;
+        s = fdb_get_byseq(kv1, doc);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        TEST_CHK(!memcmp(doc->key, key, doc->keylen));
+        TEST_CHK(!memcmp(doc->body, value, doc->bodylen));
         fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv2(txn)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(txn1_kv2, doc);
+
+        // metaonly by seq
+        fdb_doc_create(&doc, NULL, 0, NULL, 0, NULL, 0);
+        doc->seqnum = i+1;
+        s = fdb_get_metaonly_byseq(kv1, doc);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        TEST_CHK(!memcmp(doc->key, key, doc->keylen));
+        TEST_CHK(!memcmp(doc->meta, meta, doc->metalen));
         fdb_doc_free(doc);
     }
+    s = fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
 
-    // retrieve after commit (isolation test)
+    // retrieve from hb+trie
     for (i=0;i<n;++i){
+        // ==== the default instance ====
+        // by key
         sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "default(txn)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(db, doc);
+        sprintf(meta, metastr, i);
+        sprintf(value, valuestr, i);
+        s = fdb_get_kv(db, key, strlen(key)+1, &value_out, &valuelen);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
-        fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv1(txn)");
+        TEST_CHK(!memcmp(value, value_out, valuelen));
+        free(value_out);
+
+        // metaonly by key
         fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(kv1, doc);
+        s = fdb_get_metaonly(db, doc);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        TEST_CHK(!memcmp(doc->key, key, doc->keylen));
+        TEST_CHK(!memcmp(doc->meta, meta, doc->metalen));
         fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv2(txn)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(kv2, doc);
+
+        // by seq
+        fdb_doc_create(&doc, NULL, 0, NULL, 0, NULL, 0);
+        doc->seqnum = i+1;
+        s = fdb_get_byseq(db, doc);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        TEST_CHK(!memcmp(doc->key, key, doc->keylen));
+        TEST_CHK(!memcmp(doc->body, value, doc->bodylen));
+        fdb_doc_free(doc);
+
+        // metaonly by seq
+        fdb_doc_create(&doc, NULL, 0, NULL, 0, NULL, 0);
+        doc->seqnum = i+1;
+        s = fdb_get_metaonly_byseq(db, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(doc->key, key, doc->keylen));
+        TEST_CHK(!memcmp(doc->meta, meta, doc->metalen));
+
+        // by offset
+        s = fdb_get_byoffset(db, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(doc->key, key, doc->keylen));
+        TEST_CHK(!memcmp(doc->body, value, doc->bodylen));
+        fdb_doc_free(doc);
+
+        // ==== 'kv1' instance ====
+        // by key
+        sprintf(meta, metastr_kv, i);
+        sprintf(value, valuestr_kv, i);
+        s = fdb_get_kv(kv1, key, strlen(key)+1, &value_out, &valuelen);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, value_out, valuelen));
+        free(value_out);
+
+        // metaonly by key
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get_metaonly(kv1, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(doc->key, key, doc->keylen));
+        TEST_CHK(!memcmp(doc->meta, meta, doc->metalen));
+        fdb_doc_free(doc);
+
+        // by seq
+        fdb_doc_create(&doc, NULL, 0, NULL, 0, NULL, 0);
+        doc->seqnum = i+1;
+        s = fdb_get_byseq(kv1, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(doc->key, key, doc->keylen));
+        TEST_CHK(!memcmp(doc->body, value, doc->bodylen));
+        fdb_doc_free(doc);
+
+        // metaonly by seq
+        fdb_doc_create(&doc, NULL, 0, NULL, 0, NULL, 0);
+        doc->seqnum = i+1;
+        s = fdb_get_metaonly_byseq(kv1, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(doc->key, key, doc->keylen));
+        TEST_CHK(!memcmp(doc->meta, meta, doc->metalen));
+
+        // by offset
+        s = fdb_get_byoffset(kv1, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(doc->key, key, doc->keylen));
+        TEST_CHK(!memcmp(doc->body, value, doc->bodylen));
         fdb_doc_free(doc);
     }
 
-    // reopen
-    s = fdb_kvs_close(txn1_kv1);
+    // info check
+    s = fdb_get_file_info(dbfile, &file_info);
     TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_kvs_close(txn1_kv2);
+    TEST_CHK(file_info.doc_count == n*2);
+    s = fdb_get_kvs_info(db, &kvs_info);
     TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_close(dbfile_txn1);
+    TEST_CHK(kvs_info.doc_count == n);
+    s = fdb_get_kvs_info(kv1, &kvs_info);
     TEST_CHK(s == FDB_RESULT_SUCCESS);
+    TEST_CHK(kvs_info.doc_count == n);
+
     s = fdb_kvs_close(kv1);
     TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_kvs_close(kv2);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
     s = fdb_close(dbfile);
     TEST_CHK(s == FDB_RESULT_SUCCESS);
 
     if (opt & MULTI_KV_VAR_CMP) {
         s = fdb_open_custom_cmp(&dbfile, "./dummy", &config,
-                                3, kvs_names, functions);
+                                2, kvs_names, functions);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
     } else {
         s = fdb_open(&dbfile, "./dummy", &config);
@@ -7420,156 +7559,148 @@ void multi_kv_txn_test(uint8_t opt)
     TEST_CHK(s == FDB_RESULT_SUCCESS);
     s = fdb_kvs_open(dbfile, &kv1, "kv1", &kvs_config);
     TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_kvs_open(dbfile, &kv2, "kv2", &kvs_config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
 
-    // retrieve after reopen
+    // retrieve check after reopen
     for (i=0;i<n;++i){
         sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "default(txn)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(db, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
-        fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv1(txn)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(kv1, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
-        fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv2(txn)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(kv2, doc);
+        sprintf(value, valuestr, i);
+        s = fdb_get_kv(db, key, strlen(key)+1, &value_out, &valuelen);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
-        fdb_doc_free(doc);
-    }
+        TEST_CHK(!memcmp(value, value_out, valuelen));
+        free(value_out);
 
-    // begin a transaction
-    if (opt & MULTI_KV_VAR_CMP) {
-        s = fdb_open_custom_cmp(&dbfile_txn1, "./dummy", &config,
-                                3, kvs_names, functions);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-    } else {
-        s = fdb_open(&dbfile_txn1, "./dummy", &config);
+        sprintf(value, valuestr_kv, i);
+        s = fdb_get_kv(kv1, key, strlen(key)+1, &value_out, &valuelen);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, value_out, valuelen));
+        free(value_out);
     }
-    s = fdb_kvs_open(dbfile_txn1, &txn1, NULL, &kvs_config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_kvs_open(dbfile_txn1, &txn1_kv1, "kv1", &kvs_config);
+    // info check after reopen
+    s = fdb_get_file_info(dbfile, &file_info);
     TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_kvs_open(dbfile_txn1, &txn1_kv2, "kv2", &kvs_config);
+    TEST_CHK(file_info.doc_count == n*2);
+    s = fdb_get_kvs_info(db, &kvs_info);
     TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_begin_transaction(dbfile_txn1, FDB_ISOLATION_READ_COMMITTED);
+    TEST_CHK(kvs_info.doc_count == n);
+    s = fdb_get_kvs_info(kv1, &kvs_info);
     TEST_CHK(s == FDB_RESULT_SUCCESS);
+    TEST_CHK(kvs_info.doc_count == n);
 
+    s = fdb_compact(dbfile, "./dummy2");
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    // retrieve check after compaction
     for (i=0;i<n;++i){
         sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "default(txn_abort)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
-        s = fdb_set(txn1, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv1(txn_abort)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
-        s = fdb_set(txn1_kv1, doc);
+        sprintf(value, valuestr, i);
+        s = fdb_get_kv(db, key, strlen(key)+1, &value_out, &valuelen);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
-        fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv2(txn_abort)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
-        s = fdb_set(txn1_kv2, doc);
+        TEST_CHK(!memcmp(value, value_out, valuelen));
+        free(value_out);
+
+        sprintf(value, valuestr_kv, i);
+        s = fdb_get_kv(kv1, key, strlen(key)+1, &value_out, &valuelen);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
-        fdb_doc_free(doc);
+        TEST_CHK(!memcmp(value, value_out, valuelen));
+        free(value_out);
     }
-
-    // abort the transaction
-    s = fdb_abort_transaction(dbfile_txn1);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-
-    // reopen
-    s = fdb_kvs_close(txn1_kv1);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_kvs_close(txn1_kv2);
+    // info check after compaction
+    s = fdb_get_file_info(dbfile, &file_info);
     TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_close(dbfile_txn1);
+    TEST_CHK(file_info.doc_count == n*2);
+    s = fdb_get_kvs_info(db, &kvs_info);
     TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_kvs_close(kv1);
+    TEST_CHK(kvs_info.doc_count == n);
+    s = fdb_get_kvs_info(kv1, &kvs_info);
     TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_kvs_close(kv2);
+    TEST_CHK(kvs_info.doc_count == n);
+
+    // reopen using "default" KVS name
+    fdb_kvs_close(db);
+    s = fdb_kvs_open(dbfile, &db, "default", &kvs_config);
     TEST_CHK(s == FDB_RESULT_SUCCESS);
+    for (i=0;i<n;++i){
+        sprintf(key, keystr, i);
+        sprintf(value, valuestr, i);
+        s = fdb_get_kv(db, key, strlen(key)+1, &value_out, &valuelen);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, value_out, valuelen));
+        free(value_out);
+    }
+
+    s = fdb_kvs_remove(dbfile, "kv1");
+    // must fail due to opened handle
+    TEST_CHK(s != FDB_RESULT_SUCCESS);
+
+    // closing super handle also closes all other sub-handles;
     s = fdb_close(dbfile);
     TEST_CHK(s == FDB_RESULT_SUCCESS);
 
+    // re-open
     if (opt & MULTI_KV_VAR_CMP) {
-        s = fdb_open_custom_cmp(&dbfile, "./dummy", &config,
-                                3, kvs_names, functions);
+        s = fdb_open_custom_cmp(&dbfile, "./dummy2", &config,
+                                2, kvs_names, functions);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
     } else {
-        s = fdb_open(&dbfile, "./dummy", &config);
+        s = fdb_open(&dbfile, "./dummy2", &config);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
     }
-    s = fdb_kvs_open(dbfile, &db, NULL, &kvs_config);
+
+    // remove "kv1" instance
+    s = fdb_kvs_remove(dbfile, "kv1");
     TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_kvs_open(dbfile, &kv1, "kv1", &kvs_config);
+    s = fdb_kvs_open(dbfile, &db, "default", &kvs_config);
     TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_kvs_open(dbfile, &kv2, "kv2", &kvs_config);
+    s = fdb_kvs_open(dbfile, &kv1, "kv1", &kvs_config);
     TEST_CHK(s == FDB_RESULT_SUCCESS);
-
-    // retrieve after reopen
     for (i=0;i<n;++i){
         sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "default(txn)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(db, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
-        fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv1(txn)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(kv1, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
-        fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv2(txn)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(kv2, doc);
+        sprintf(value, valuestr, i);
+        s = fdb_get_kv(db, key, strlen(key)+1, &value_out, &valuelen);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
-        fdb_doc_free(doc);
-    }
+        TEST_CHK(!memcmp(value, value_out, valuelen));
+        free(value_out);
 
-    // get KVS names
-    fdb_kvs_name_list kvs_name_list;
-    s = fdb_get_kvs_name_list(dbfile, &kvs_name_list);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    TEST_CHK(kvs_name_list.num_kvs_names == 3);
-    for (i=0;i<kvs_name_list.num_kvs_names;++i){
-        TEST_CHK(!strcmp(kvs_name_list.kvs_names[i], kvs_names[i]));
+        s = fdb_get_kv(kv1, key, strlen(key)+1, &value_out, &valuelen);
+        TEST_CHK(s != FDB_RESULT_SUCCESS);
     }
-    fdb_free_kvs_name_list(&kvs_name_list);
-
+    s = fdb_kvs_close(db);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
     s = fdb_kvs_close(kv1);
     TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_kvs_close(kv2);
+
+    // remove "default" instance
+    s = fdb_kvs_remove(dbfile, "default");
     TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_close(dbfile);
+    s = fdb_kvs_open(dbfile, &db, "default", &kvs_config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    for (i=0;i<n;++i){
+        sprintf(key, keystr, i);
+        s = fdb_get_kv(db, key, strlen(key)+1, &value_out, &valuelen);
+        TEST_CHK(s != FDB_RESULT_SUCCESS);
+    }
+    s = fdb_kvs_close(db);
     TEST_CHK(s == FDB_RESULT_SUCCESS);
 
-    s = fdb_shutdown();
+    // remove the empty "kv1" instance
+    s = fdb_kvs_remove(dbfile, "kv1");
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    s = fdb_close(dbfile);
     TEST_CHK(s == FDB_RESULT_SUCCESS);
 
+    s = fdb_shutdown();
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
     memleak_end();
 
     if (opt & MULTI_KV_VAR_CMP) {
-        TEST_RESULT("multiple KV instances transaction test "
+        TEST_RESULT("multiple KV instances basic test "
                     "(custom key order)");
     } else {
-        TEST_RESULT("multiple KV instances transaction test");
+        TEST_RESULT("multiple KV instances basic test");
     }
 }
 
-void multi_kv_snapshot_test(uint8_t opt)
+void multi_kv_iterator_key_test(uint8_t opt)
 {
     TEST_INIT();
 
@@ -7580,11 +7711,10 @@ void multi_kv_snapshot_test(uint8_t opt)
     char valuestr[] = "value%08d(%s)";
     fdb_file_handle *dbfile;
     fdb_kvs_handle *db, *kv1, *kv2;
-    fdb_kvs_handle *snap1, *snap2;
-    fdb_seqnum_t seq1, seq2;
     fdb_config config;
     fdb_kvs_config kvs_config;
     fdb_doc *doc;
+    fdb_iterator *it;
     fdb_status s;
 
     sprintf(value, SHELL_DEL" dummy*");
@@ -7611,118 +7741,112 @@ void multi_kv_snapshot_test(uint8_t opt)
     s = fdb_kvs_open(dbfile, &kv2, "kv2", &kvs_config);
     TEST_CHK(s == FDB_RESULT_SUCCESS);
 
-    // write documents first time
-    for (i=0;i<n;++i){
+    for (i=0;i<n;i+=2) {
         sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "default(commit1)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
-        s = fdb_set(db, doc);
+        sprintf(value, valuestr, i, "default");
+        s = fdb_set_kv(db, key, strlen(key)+1, value, strlen(value)+1);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
-        fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv1(commit1)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
-        s = fdb_set(kv1, doc);
+        sprintf(value, valuestr, i, "kv1");
+        s = fdb_set_kv(kv1, key, strlen(key)+1, value, strlen(value)+1);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
-        fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv2(commit1)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
-        s = fdb_set(kv2, doc);
+        sprintf(value, valuestr, i, "kv2");
+        s = fdb_set_kv(kv2, key, strlen(key)+1, value, strlen(value)+1);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
-        fdb_doc_free(doc);
     }
-    s = fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_get_kvs_seqnum(kv1, &seq1);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
 
-    // write documents second time
-    for (i=0;i<n;++i){
+    for (i=1;i<n;i+=2) {
         sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "default(commit2)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
-        s = fdb_set(db, doc);
+        sprintf(value, valuestr, i, "default");
+        s = fdb_set_kv(db, key, strlen(key)+1, value, strlen(value)+1);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
-        fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv1(commit2)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
-        s = fdb_set(kv1, doc);
+        sprintf(value, valuestr, i, "kv1");
+        s = fdb_set_kv(kv1, key, strlen(key)+1, value, strlen(value)+1);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
-        fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv2(commit2)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
-        s = fdb_set(kv2, doc);
+        sprintf(value, valuestr, i, "kv2");
+        s = fdb_set_kv(kv2, key, strlen(key)+1, value, strlen(value)+1);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
-        fdb_doc_free(doc);
     }
-    s = fdb_commit(dbfile, FDB_COMMIT_NORMAL);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_get_kvs_seqnum(kv2, &seq2);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
 
-    // write documents third time
-    for (i=0;i<n;++i){
+    // iterate in default KV instance
+    i = 0;
+    s = fdb_iterator_init(db, &it, NULL, 0, NULL, 0, FDB_ITR_NONE);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    while (fdb_iterator_next(it, &doc) == FDB_RESULT_SUCCESS) {
         sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "default(commit3)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
-        s = fdb_set(db, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv1(commit3)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
-        s = fdb_set(kv1, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv2(commit3)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
-        s = fdb_set(kv2, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        sprintf(value, valuestr, i, "default");
+        TEST_CHK(!memcmp(doc->key, key, doc->keylen));
+        TEST_CHK(!memcmp(doc->body, value, doc->bodylen));
+        r = ((i%2 == 0)?(i/2):(50+i/2)) +1;
+        TEST_CHK(doc->seqnum == r);
         fdb_doc_free(doc);
+        i++;
     }
-    s = fdb_commit(dbfile, FDB_COMMIT_NORMAL);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    TEST_CHK(i == n);
+    fdb_iterator_close(it);
 
-    // create snapshots
-    s = fdb_snapshot_open(kv1, &snap1, seq1);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_snapshot_open(kv2, &snap2, seq2);
+    // iterate in kv1 instance
+    i = 0;
+    s = fdb_iterator_init(kv1, &it, NULL, 0, NULL, 0, FDB_ITR_NONE);
     TEST_CHK(s == FDB_RESULT_SUCCESS);
-
-    // retrieve
-    for (i=0;i<n;++i){
+    while (fdb_iterator_next(it, &doc) == FDB_RESULT_SUCCESS) {
         sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "kv1(commit3)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(kv1, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
-        fdb_doc_free(doc);
-
-        sprintf(value, valuestr, i, "kv2(commit3)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(kv2, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        sprintf(value, valuestr, i, "kv1");
+        TEST_CHK(!memcmp(doc->key, key, doc->keylen));
+        TEST_CHK(!memcmp(doc->body, value, doc->bodylen));
+        r = ((i%2 == 0)?(i/2):(50+i/2)) +1;
+        TEST_CHK(doc->seqnum == r);
         fdb_doc_free(doc);
-
-        sprintf(value, valuestr, i, "kv1(commit1)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(snap1, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        i++;
+    }
+    TEST_CHK(i == n);
+    // reverse iterate in kv1 instance
+    while (fdb_iterator_prev(it, &doc) == FDB_RESULT_SUCCESS) {
+        i--;
+        sprintf(key, keystr, i);
+        sprintf(value, valuestr, i, "kv1");
+        TEST_CHK(!memcmp(doc->key, key, doc->keylen));
+        TEST_CHK(!memcmp(doc->body, value, doc->bodylen));
+        r = ((i%2 == 0)?(i/2):(50+i/2)) +1;
+        TEST_CHK(doc->seqnum == r);
         fdb_doc_free(doc);
+    }
+    TEST_CHK(i == 0);
+    fdb_iterator_close(it);
 
-        sprintf(value, valuestr, i, "kv2(commit2)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(snap2, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+    // iterate in kv2 instance
+    i = 0;
+    s = fdb_iterator_init(kv2, &it, NULL, 0, NULL, 0, FDB_ITR_NONE);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    while (fdb_iterator_next(it, &doc) == FDB_RESULT_SUCCESS) {
+        sprintf(key, keystr, i);
+        sprintf(value, valuestr, i, "kv2");
+        TEST_CHK(!memcmp(doc->key, key, doc->keylen));
+        TEST_CHK(!memcmp(doc->body, value, doc->bodylen));
         fdb_doc_free(doc);
+        i++;
     }
+    TEST_CHK(i == n);
+    fdb_iterator_close(it);
 
-    s = fdb_kvs_close(snap1);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_kvs_close(snap2);
+    // partial iterate in kv1 instance
+    i = 40;
+    char key2[256];
+    sprintf(key, keystr, 40);
+    sprintf(key2, keystr, 59);
+    s = fdb_iterator_init(kv1, &it, key, strlen(key)+1, key2, strlen(key2)+1, FDB_ITR_NONE);
     TEST_CHK(s == FDB_RESULT_SUCCESS);
+    while (fdb_iterator_next(it, &doc) == FDB_RESULT_SUCCESS) {
+        sprintf(key, keystr, i);
+        sprintf(value, valuestr, i, "kv1");
+        TEST_CHK(!memcmp(doc->key, key, doc->keylen));
+        TEST_CHK(!memcmp(doc->body, value, doc->bodylen));
+        fdb_doc_free(doc);
+        i++;
+    }
+    TEST_CHK(i == 60);
+    fdb_iterator_close(it);
 
     s = fdb_kvs_close(kv1);
     TEST_CHK(s == FDB_RESULT_SUCCESS);
@@ -7730,21 +7854,20 @@ void multi_kv_snapshot_test(uint8_t opt)
     TEST_CHK(s == FDB_RESULT_SUCCESS);
     s = fdb_close(dbfile);
     TEST_CHK(s == FDB_RESULT_SUCCESS);
-
     s = fdb_shutdown();
     TEST_CHK(s == FDB_RESULT_SUCCESS);
 
     memleak_end();
 
     if (opt & MULTI_KV_VAR_CMP) {
-        TEST_RESULT("multiple KV instances snapshot test "
+        TEST_RESULT("multiple KV instances iterator test "
                     "(custom key order)");
     } else {
-        TEST_RESULT("multiple KV instances snapshot test");
+        TEST_RESULT("multiple KV instances iterator test");
     }
 }
 
-void multi_kv_rollback_test(uint8_t opt)
+void multi_kv_iterator_seq_test(uint8_t opt)
 {
     TEST_INIT();
 
@@ -7755,16 +7878,12 @@ void multi_kv_rollback_test(uint8_t opt)
     char valuestr[] = "value%08d(%s)";
     fdb_file_handle *dbfile;
     fdb_kvs_handle *db, *kv1, *kv2;
-    fdb_seqnum_t seq1, seq2, seq3;
     fdb_config config;
     fdb_kvs_config kvs_config;
     fdb_doc *doc;
+    fdb_iterator *it;
     fdb_status s;
-
-    char *kvs_names[] = {NULL, (char*)"kv1", (char*)"kv2"};
-    fdb_custom_cmp_variable functions[] = {_multi_kv_test_keycmp,
-                                           _multi_kv_test_keycmp,
-                                           _multi_kv_test_keycmp};
+    fdb_seqnum_t seqnum;
 
     sprintf(value, SHELL_DEL" dummy*");
     r = system(value);
@@ -7778,13 +7897,10 @@ void multi_kv_rollback_test(uint8_t opt)
     config.wal_threshold = 1000;
     config.buffercache_size = 0;
 
+    s = fdb_open(&dbfile, "./dummy", &config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
     if (opt & MULTI_KV_VAR_CMP) {
-        s = fdb_open_custom_cmp(&dbfile, "./dummy", &config,
-                                3, kvs_names, functions);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-    } else {
-        s = fdb_open(&dbfile, "./dummy", &config);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        kvs_config.custom_cmp = _multi_kv_test_keycmp;
     }
     s = fdb_kvs_open(dbfile, &db, NULL, &kvs_config);
     TEST_CHK(s == FDB_RESULT_SUCCESS);
@@ -7796,187 +7912,331 @@ void multi_kv_rollback_test(uint8_t opt)
     // write documents first time
     for (i=0;i<n;++i){
         sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "default(commit1)");
+        sprintf(value, valuestr, i, "default");
         fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
         s = fdb_set(db, doc);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
         fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv1(commit1)");
+        sprintf(value, valuestr, i, "kv1");
         fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
         s = fdb_set(kv1, doc);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
-        if (i%15 == 0) s = fdb_set(kv1, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
         fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv2(commit1)");
+        sprintf(value, valuestr, i, "kv2");
         fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
         s = fdb_set(kv2, doc);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
-        if (i%27 == 0) s = fdb_set(kv2, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
         fdb_doc_free(doc);
     }
     s = fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
     TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_get_kvs_seqnum(kv1, &seq1);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
 
-    // write documents second time
+    // re-write documents
     for (i=0;i<n;++i){
         sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "default(commit2)");
+        sprintf(value, valuestr, i, "default_second");
         fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
         s = fdb_set(db, doc);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
         fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv1(commit2)");
+        sprintf(value, valuestr, i, "kv1_second");
         fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
         s = fdb_set(kv1, doc);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
-        if (i%15 == 0) s = fdb_set(kv1, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
         fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv2(commit2)");
+        sprintf(value, valuestr, i, "kv2_second");
         fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
         s = fdb_set(kv2, doc);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
-        if (i%27 == 0) s = fdb_set(kv2, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
         fdb_doc_free(doc);
     }
     s = fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
     TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_get_kvs_seqnum(db, &seq2);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
 
-    // write documents third time
-    for (i=0;i<n;++i){
+    // write third time (even number docs only)
+    for (i=0;i<n;i+=2){
         sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "default(commit3)");
+        sprintf(value, valuestr, i, "default_third");
         fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
         s = fdb_set(db, doc);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
         fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv1(commit3)");
+        sprintf(value, valuestr, i, "kv1_third");
         fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
         s = fdb_set(kv1, doc);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
-        if (i%15 == 0) s = fdb_set(kv1, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
         fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv2(commit3)");
+        sprintf(value, valuestr, i, "kv2_third");
         fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
         s = fdb_set(kv2, doc);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
-        if (i%27 == 0) s = fdb_set(kv2, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
         fdb_doc_free(doc);
     }
     s = fdb_commit(dbfile, FDB_COMMIT_NORMAL);
     TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_get_kvs_seqnum(kv2, &seq3);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
 
-    // write documents third time
-    for (i=0;i<n;++i){
-        sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "default(commit4)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
+    // iterate in default KV instance
+    i = 0;
+    s = fdb_iterator_sequence_init(db, &it, 0, 0, FDB_ITR_NONE);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    while (fdb_iterator_next(it, &doc) == FDB_RESULT_SUCCESS) {
+        fdb_doc_free(doc);
+        i++;
+    }
+    TEST_CHK(i == n);
+    fdb_iterator_close(it);
+
+    // iterate in KV1
+    i = 0;
+    s = fdb_iterator_sequence_init(kv1, &it, 0, 0, FDB_ITR_NONE);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    while (fdb_iterator_next(it, &doc) == FDB_RESULT_SUCCESS) {
+        if (i < 50) {
+            r = i*2 + 1;
+            seqnum = 100 + (i+1)*2;
+            sprintf(value, valuestr, r, "kv1_second");
+        } else {
+            r = (i-50)*2;
+            seqnum = 151 + i;
+            sprintf(value, valuestr, r, "kv1_third");
+        }
+        sprintf(key, keystr, r);
+        TEST_CHK(!memcmp(key, doc->key, doc->keylen));
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        TEST_CHK(doc->seqnum == seqnum);
+        fdb_doc_free(doc);
+        i++;
+    }
+    TEST_CHK(i == n);
+    // reverse iterate in KV1
+    while (fdb_iterator_prev(it, &doc) == FDB_RESULT_SUCCESS) {
+        i--;
+        if (i < 50) {
+            r = i*2 + 1;
+            seqnum = 100 + (i+1)*2;
+            sprintf(value, valuestr, r, "kv1_second");
+        } else {
+            r = (i-50)*2;
+            seqnum = 151 + i;
+            sprintf(value, valuestr, r, "kv1_third");
+        }
+        sprintf(key, keystr, r);
+        TEST_CHK(!memcmp(key, doc->key, doc->keylen));
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        TEST_CHK(doc->seqnum == seqnum);
+        fdb_doc_free(doc);
+    }
+    TEST_CHK(i == 0);
+    fdb_iterator_close(it);
+
+    // iterate in KV2
+    i = 0;
+    s = fdb_iterator_sequence_init(kv2, &it, 0, 0, FDB_ITR_NONE);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    while (fdb_iterator_next(it, &doc) == FDB_RESULT_SUCCESS) {
+        if (i < 50) {
+            r = i*2 + 1;
+            seqnum = 100 + (i+1)*2;
+            sprintf(value, valuestr, r, "kv2_second");
+        } else {
+            r = (i-50)*2;
+            seqnum = 151 + i;
+            sprintf(value, valuestr, r, "kv2_third");
+        }
+        (void)seqnum;
+        sprintf(key, keystr, r);
+        fdb_doc_free(doc);
+        i++;
+    }
+    TEST_CHK(i == n);
+    fdb_iterator_close(it);
+
+    // partial iterate in KV1
+    i = 0;
+    s = fdb_iterator_sequence_init(kv1, &it, 150, 220, FDB_ITR_NONE);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    while (fdb_iterator_next(it, &doc) == FDB_RESULT_SUCCESS) {
+        //printf("%d %s %s %d\n", i, (char*)doc->key, (char*)doc->body, (int)doc->seqnum);
+        if (i<26) {
+            r = 49 + i*2;
+            seqnum = i*2 + 150;
+            sprintf(value, valuestr, r, "kv1_second");
+        } else {
+            r = (i-26)*2;
+            seqnum = 201 + (i-26);
+            sprintf(value, valuestr, r, "kv1_third");
+        }
+        (void)seqnum;
+        fdb_doc_free(doc);
+        i++;
+    }
+    TEST_CHK(i == 46);
+    fdb_iterator_close(it);
+
+    s = fdb_kvs_close(kv1);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_kvs_close(kv2);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_close(dbfile);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_shutdown();
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    memleak_end();
+
+    if (opt & MULTI_KV_VAR_CMP) {
+        TEST_RESULT("multiple KV instances sequence iterator test "
+                    "(custom key order)");
+    } else {
+        TEST_RESULT("multiple KV instances sequence iterator test");
+    }
+}
+
+void multi_kv_txn_test(uint8_t opt)
+{
+    TEST_INIT();
+
+    int n = 100;
+    int i, r;
+    char key[256], value[256];
+    char keystr[] = "key%06d";
+    char valuestr[] = "value%08d(%s)";
+    fdb_file_handle *dbfile, *dbfile_txn1;
+    fdb_kvs_handle *db, *kv1, *kv2;
+    fdb_kvs_handle *txn1, *txn1_kv1, *txn1_kv2;
+    fdb_config config;
+    fdb_kvs_config kvs_config;
+    fdb_doc *doc;
+    fdb_status s;
+
+    char *kvs_names[] = {(char*)"default", (char*)"kv1", (char*)"kv2"};
+    fdb_custom_cmp_variable functions[] = {_multi_kv_test_keycmp,
+                                           _multi_kv_test_keycmp,
+                                           _multi_kv_test_keycmp};
+
+    sprintf(value, SHELL_DEL" dummy*");
+    r = system(value);
+    (void)r;
+
+    memleak_start();
+
+    config = fdb_get_default_config();
+    kvs_config = fdb_get_default_kvs_config();
+    config.multi_kv_instances = true;
+    config.wal_threshold = 1000;
+    config.buffercache_size = 0;
+
+    s = fdb_open(&dbfile, "./dummy", &config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    if (opt & MULTI_KV_VAR_CMP) {
+        kvs_config.custom_cmp = _multi_kv_test_keycmp;
+    }
+    s = fdb_kvs_open(dbfile, &db, NULL, &kvs_config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_kvs_open(dbfile, &kv1, "kv1", &kvs_config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_kvs_open(dbfile, &kv2, "kv2", &kvs_config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    // write documents first time
+    for (i=0;i<n;++i){
+        sprintf(key, keystr, i);
+        sprintf(value, valuestr, i, "default");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
         s = fdb_set(db, doc);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
         fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv1(commit4)");
+        sprintf(value, valuestr, i, "kv1");
         fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
         s = fdb_set(kv1, doc);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
-        if (i%15 == 0) s = fdb_set(kv1, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
         fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv2(commit4)");
+        sprintf(value, valuestr, i, "kv2");
         fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
         s = fdb_set(kv2, doc);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
-        if (i%27 == 0) s = fdb_set(kv2, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
         fdb_doc_free(doc);
     }
-    s = fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+    s = fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
     TEST_CHK(s == FDB_RESULT_SUCCESS);
 
-    // rollback kv1 using seq1
-    s = fdb_rollback(&kv1, seq1);
+    // begin a transaction
+    if (opt & MULTI_KV_VAR_CMP) {
+        s = fdb_open_custom_cmp(&dbfile_txn1, "./dummy", &config,
+                                3, kvs_names, functions);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+    } else {
+        s = fdb_open(&dbfile_txn1, "./dummy", &config);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+    }
+    s = fdb_kvs_open(dbfile_txn1, &txn1, NULL, &kvs_config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_kvs_open(dbfile_txn1, &txn1_kv1, "kv1", &kvs_config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_kvs_open(dbfile_txn1, &txn1_kv2, "kv2", &kvs_config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_begin_transaction(dbfile_txn1, FDB_ISOLATION_READ_COMMITTED);
     TEST_CHK(s == FDB_RESULT_SUCCESS);
 
-    // retrieve check
     for (i=0;i<n;++i){
         sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "default(commit4)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(db, doc);
+        sprintf(value, valuestr, i, "default(txn)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
+        s = fdb_set(txn1, doc);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
         fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv1(commit1)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(kv1, doc);
+        sprintf(value, valuestr, i, "kv1(txn)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
+        s = fdb_set(txn1_kv1, doc);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
         fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv2(commit4)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(kv2, doc);
+        sprintf(value, valuestr, i, "kv2(txn)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
+        s = fdb_set(txn1_kv2, doc);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
         fdb_doc_free(doc);
     }
 
-    // rollback db using seq2
-    s = fdb_rollback(&db, seq2);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-
-    // retrieve check
+    // retrieve before commit (dirty read through the transaction)
     for (i=0;i<n;++i){
         sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "default(commit2)");
+        sprintf(value, valuestr, i, "default(txn)");
         fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(db, doc);
+        s = fdb_get(txn1, doc);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
         TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
         fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv1(commit1)");
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        sprintf(value, valuestr, i, "kv1(txn)");
         fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(kv1, doc);
+        s = fdb_get(txn1_kv1, doc);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
         TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
         fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv2(commit4)");
+        sprintf(value, valuestr, i, "kv2(txn)");
         fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(kv2, doc);
+        s = fdb_get(txn1_kv2, doc);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
         TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
         fdb_doc_free(doc);
     }
 
-    // rollback db using seq3
-    s = fdb_rollback(&kv2, seq3);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-
-    // retrieve check
+    // retrieve before commit (isolation test)
     for (i=0;i<n;++i){
         sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "default(commit2)");
+        sprintf(value, valuestr, i, "default");
         fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
         s = fdb_get(db, doc);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
         TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
         fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv1(commit1)");
+        sprintf(value, valuestr, i, "kv1");
         fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
         s = fdb_get(kv1, doc);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
         TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
         fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv2(commit3)");
+        sprintf(value, valuestr, i, "kv2");
         fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
         s = fdb_get(kv2, doc);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
@@ -7984,12 +8244,67 @@ void multi_kv_rollback_test(uint8_t opt)
         fdb_doc_free(doc);
     }
 
-    // close & re-open
-    s = fdb_kvs_close(kv1);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_kvs_close(kv2);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_close(dbfile);
+    s = fdb_end_transaction(dbfile_txn1, FDB_COMMIT_NORMAL);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    // retrieve after commit (through the transaction)
+    for (i=0;i<n;++i){
+        sprintf(key, keystr, i);
+        sprintf(value, valuestr, i, "default(txn)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get(txn1, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        fdb_doc_free(doc);
+        sprintf(value, valuestr, i, "kv1(txn)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get(txn1_kv1, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        fdb_doc_free(doc);
+        sprintf(value, valuestr, i, "kv2(txn)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get(txn1_kv2, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        fdb_doc_free(doc);
+    }
+
+    // retrieve after commit (isolation test)
+    for (i=0;i<n;++i){
+        sprintf(key, keystr, i);
+        sprintf(value, valuestr, i, "default(txn)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get(db, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        fdb_doc_free(doc);
+        sprintf(value, valuestr, i, "kv1(txn)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get(kv1, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        fdb_doc_free(doc);
+        sprintf(value, valuestr, i, "kv2(txn)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get(kv2, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        fdb_doc_free(doc);
+    }
+
+    // reopen
+    s = fdb_kvs_close(txn1_kv1);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_kvs_close(txn1_kv2);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_close(dbfile_txn1);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_kvs_close(kv1);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_kvs_close(kv2);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_close(dbfile);
     TEST_CHK(s == FDB_RESULT_SUCCESS);
 
     if (opt & MULTI_KV_VAR_CMP) {
@@ -8000,27 +8315,122 @@ void multi_kv_rollback_test(uint8_t opt)
         s = fdb_open(&dbfile, "./dummy", &config);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
     }
+    s = fdb_kvs_open(dbfile, &db, NULL, &kvs_config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_kvs_open(dbfile, &kv1, "kv1", &kvs_config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_kvs_open(dbfile, &kv2, "kv2", &kvs_config);
     TEST_CHK(s == FDB_RESULT_SUCCESS);
-    fdb_kvs_open(dbfile, &db, NULL, &kvs_config);
-    fdb_kvs_open(dbfile, &kv1, "kv1", &kvs_config);
-    fdb_kvs_open(dbfile, &kv2, "kv2", &kvs_config);
 
-    // retrieve check after re-open
+    // retrieve after reopen
     for (i=0;i<n;++i){
         sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "default(commit2)");
+        sprintf(value, valuestr, i, "default(txn)");
         fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
         s = fdb_get(db, doc);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
         TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
         fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv1(commit1)");
+        sprintf(value, valuestr, i, "kv1(txn)");
         fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
         s = fdb_get(kv1, doc);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
         TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
         fdb_doc_free(doc);
-        sprintf(value, valuestr, i, "kv2(commit3)");
+        sprintf(value, valuestr, i, "kv2(txn)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get(kv2, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        fdb_doc_free(doc);
+    }
+
+    // begin a transaction
+    if (opt & MULTI_KV_VAR_CMP) {
+        s = fdb_open_custom_cmp(&dbfile_txn1, "./dummy", &config,
+                                3, kvs_names, functions);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+    } else {
+        s = fdb_open(&dbfile_txn1, "./dummy", &config);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+    }
+    s = fdb_kvs_open(dbfile_txn1, &txn1, NULL, &kvs_config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_kvs_open(dbfile_txn1, &txn1_kv1, "kv1", &kvs_config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_kvs_open(dbfile_txn1, &txn1_kv2, "kv2", &kvs_config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_begin_transaction(dbfile_txn1, FDB_ISOLATION_READ_COMMITTED);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    for (i=0;i<n;++i){
+        sprintf(key, keystr, i);
+        sprintf(value, valuestr, i, "default(txn_abort)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
+        s = fdb_set(txn1, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        fdb_doc_free(doc);
+        sprintf(value, valuestr, i, "kv1(txn_abort)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
+        s = fdb_set(txn1_kv1, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        fdb_doc_free(doc);
+        sprintf(value, valuestr, i, "kv2(txn_abort)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
+        s = fdb_set(txn1_kv2, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        fdb_doc_free(doc);
+    }
+
+    // abort the transaction
+    s = fdb_abort_transaction(dbfile_txn1);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    // reopen
+    s = fdb_kvs_close(txn1_kv1);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_kvs_close(txn1_kv2);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_close(dbfile_txn1);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_kvs_close(kv1);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_kvs_close(kv2);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_close(dbfile);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    if (opt & MULTI_KV_VAR_CMP) {
+        s = fdb_open_custom_cmp(&dbfile, "./dummy", &config,
+                                3, kvs_names, functions);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+    } else {
+        s = fdb_open(&dbfile, "./dummy", &config);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+    }
+    s = fdb_kvs_open(dbfile, &db, NULL, &kvs_config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_kvs_open(dbfile, &kv1, "kv1", &kvs_config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_kvs_open(dbfile, &kv2, "kv2", &kvs_config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    // retrieve after reopen
+    for (i=0;i<n;++i){
+        sprintf(key, keystr, i);
+        sprintf(value, valuestr, i, "default(txn)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get(db, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        fdb_doc_free(doc);
+        sprintf(value, valuestr, i, "kv1(txn)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get(kv1, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        fdb_doc_free(doc);
+        sprintf(value, valuestr, i, "kv2(txn)");
         fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
         s = fdb_get(kv2, doc);
         TEST_CHK(s == FDB_RESULT_SUCCESS);
@@ -8028,654 +8438,2881 @@ void multi_kv_rollback_test(uint8_t opt)
         fdb_doc_free(doc);
     }
 
-    fdb_kvs_close(kv1);
-    fdb_kvs_close(kv2);
-    fdb_close(dbfile);
+    // get KVS names
+    fdb_kvs_name_list kvs_name_list;
+    s = fdb_get_kvs_name_list(dbfile, &kvs_name_list);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    TEST_CHK(kvs_name_list.num_kvs_names == 3);
+    for (i=0;i<kvs_name_list.num_kvs_names;++i){
+        TEST_CHK(!strcmp(kvs_name_list.kvs_names[i], kvs_names[i]));
+    }
+    fdb_free_kvs_name_list(&kvs_name_list);
+
+    s = fdb_kvs_close(kv1);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_kvs_close(kv2);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_close(dbfile);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    s = fdb_shutdown();
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    memleak_end();
+
+    if (opt & MULTI_KV_VAR_CMP) {
+        TEST_RESULT("multiple KV instances transaction test "
+                    "(custom key order)");
+    } else {
+        TEST_RESULT("multiple KV instances transaction test");
+    }
+}
+
+void multi_kv_snapshot_test(uint8_t opt)
+{
+    TEST_INIT();
+
+    int n = 100;
+    int i, r;
+    char key[256], value[256];
+    char keystr[] = "key%06d";
+    char valuestr[] = "value%08d(%s)";
+    fdb_file_handle *dbfile;
+    fdb_kvs_handle *db, *kv1, *kv2;
+    fdb_kvs_handle *snap1, *snap2;
+    fdb_seqnum_t seq1, seq2;
+    fdb_config config;
+    fdb_kvs_config kvs_config;
+    fdb_doc *doc;
+    fdb_status s;
+
+    sprintf(value, SHELL_DEL" dummy*");
+    r = system(value);
+    (void)r;
+
+    memleak_start();
+
+    config = fdb_get_default_config();
+    kvs_config = fdb_get_default_kvs_config();
+    config.multi_kv_instances = true;
+    config.wal_threshold = 1000;
+    config.buffercache_size = 0;
+
+    s = fdb_open(&dbfile, "./dummy", &config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    if (opt & MULTI_KV_VAR_CMP) {
+        kvs_config.custom_cmp = _multi_kv_test_keycmp;
+    }
+    s = fdb_kvs_open(dbfile, &db, NULL, &kvs_config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_kvs_open(dbfile, &kv1, "kv1", &kvs_config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_kvs_open(dbfile, &kv2, "kv2", &kvs_config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    // write documents first time
+    for (i=0;i<n;++i){
+        sprintf(key, keystr, i);
+        sprintf(value, valuestr, i, "default(commit1)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
+        s = fdb_set(db, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        fdb_doc_free(doc);
+        sprintf(value, valuestr, i, "kv1(commit1)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
+        s = fdb_set(kv1, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        fdb_doc_free(doc);
+        sprintf(value, valuestr, i, "kv2(commit1)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
+        s = fdb_set(kv2, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        fdb_doc_free(doc);
+    }
+    s = fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_get_kvs_seqnum(kv1, &seq1);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    // write documents second time
+    for (i=0;i<n;++i){
+        sprintf(key, keystr, i);
+        sprintf(value, valuestr, i, "default(commit2)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
+        s = fdb_set(db, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        fdb_doc_free(doc);
+        sprintf(value, valuestr, i, "kv1(commit2)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
+        s = fdb_set(kv1, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        fdb_doc_free(doc);
+        sprintf(value, valuestr, i, "kv2(commit2)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
+        s = fdb_set(kv2, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        fdb_doc_free(doc);
+    }
+    s = fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_get_kvs_seqnum(kv2, &seq2);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    // write documents third time
+    for (i=0;i<n;++i){
+        sprintf(key, keystr, i);
+        sprintf(value, valuestr, i, "default(commit3)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
+        s = fdb_set(db, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        fdb_doc_free(doc);
+        sprintf(value, valuestr, i, "kv1(commit3)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
+        s = fdb_set(kv1, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        fdb_doc_free(doc);
+        sprintf(value, valuestr, i, "kv2(commit3)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
+        s = fdb_set(kv2, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        fdb_doc_free(doc);
+    }
+    s = fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    // create snapshots
+    s = fdb_snapshot_open(kv1, &snap1, seq1);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_snapshot_open(kv2, &snap2, seq2);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    // retrieve
+    for (i=0;i<n;++i){
+        sprintf(key, keystr, i);
+        sprintf(value, valuestr, i, "kv1(commit3)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get(kv1, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        fdb_doc_free(doc);
+
+        sprintf(value, valuestr, i, "kv2(commit3)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get(kv2, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        fdb_doc_free(doc);
+
+        sprintf(value, valuestr, i, "kv1(commit1)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get(snap1, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        fdb_doc_free(doc);
+
+        sprintf(value, valuestr, i, "kv2(commit2)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get(snap2, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        fdb_doc_free(doc);
+    }
+
+    s = fdb_kvs_close(snap1);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_kvs_close(snap2);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    s = fdb_kvs_close(kv1);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_kvs_close(kv2);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_close(dbfile);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    s = fdb_shutdown();
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    memleak_end();
+
+    if (opt & MULTI_KV_VAR_CMP) {
+        TEST_RESULT("multiple KV instances snapshot test "
+                    "(custom key order)");
+    } else {
+        TEST_RESULT("multiple KV instances snapshot test");
+    }
+}
+
+void multi_kv_rollback_test(uint8_t opt)
+{
+    TEST_INIT();
+
+    int n = 100;
+    int i, r;
+    char key[256], value[256];
+    char keystr[] = "key%06d";
+    char valuestr[] = "value%08d(%s)";
+    fdb_file_handle *dbfile;
+    fdb_kvs_handle *db, *kv1, *kv2;
+    fdb_seqnum_t seq1, seq2, seq3;
+    fdb_config config;
+    fdb_kvs_config kvs_config;
+    fdb_doc *doc;
+    fdb_status s;
+
+    char *kvs_names[] = {NULL, (char*)"kv1", (char*)"kv2"};
+    fdb_custom_cmp_variable functions[] = {_multi_kv_test_keycmp,
+                                           _multi_kv_test_keycmp,
+                                           _multi_kv_test_keycmp};
+
+    sprintf(value, SHELL_DEL" dummy*");
+    r = system(value);
+    (void)r;
+
+    memleak_start();
+
+    config = fdb_get_default_config();
+    kvs_config = fdb_get_default_kvs_config();
+    config.multi_kv_instances = true;
+    config.wal_threshold = 1000;
+    config.buffercache_size = 0;
+
+    if (opt & MULTI_KV_VAR_CMP) {
+        s = fdb_open_custom_cmp(&dbfile, "./dummy", &config,
+                                3, kvs_names, functions);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+    } else {
+        s = fdb_open(&dbfile, "./dummy", &config);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+    }
+    s = fdb_kvs_open(dbfile, &db, NULL, &kvs_config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_kvs_open(dbfile, &kv1, "kv1", &kvs_config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_kvs_open(dbfile, &kv2, "kv2", &kvs_config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    // write documents first time
+    for (i=0;i<n;++i){
+        sprintf(key, keystr, i);
+        sprintf(value, valuestr, i, "default(commit1)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
+        s = fdb_set(db, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        fdb_doc_free(doc);
+        sprintf(value, valuestr, i, "kv1(commit1)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
+        s = fdb_set(kv1, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        if (i%15 == 0) s = fdb_set(kv1, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        fdb_doc_free(doc);
+        sprintf(value, valuestr, i, "kv2(commit1)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
+        s = fdb_set(kv2, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        if (i%27 == 0) s = fdb_set(kv2, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        fdb_doc_free(doc);
+    }
+    s = fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_get_kvs_seqnum(kv1, &seq1);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    // write documents second time
+    for (i=0;i<n;++i){
+        sprintf(key, keystr, i);
+        sprintf(value, valuestr, i, "default(commit2)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
+        s = fdb_set(db, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        fdb_doc_free(doc);
+        sprintf(value, valuestr, i, "kv1(commit2)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
+        s = fdb_set(kv1, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        if (i%15 == 0) s = fdb_set(kv1, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        fdb_doc_free(doc);
+        sprintf(value, valuestr, i, "kv2(commit2)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
+        s = fdb_set(kv2, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        if (i%27 == 0) s = fdb_set(kv2, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        fdb_doc_free(doc);
+    }
+    s = fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_get_kvs_seqnum(db, &seq2);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    // write documents third time
+    for (i=0;i<n;++i){
+        sprintf(key, keystr, i);
+        sprintf(value, valuestr, i, "default(commit3)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
+        s = fdb_set(db, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        fdb_doc_free(doc);
+        sprintf(value, valuestr, i, "kv1(commit3)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
+        s = fdb_set(kv1, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        if (i%15 == 0) s = fdb_set(kv1, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        fdb_doc_free(doc);
+        sprintf(value, valuestr, i, "kv2(commit3)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
+        s = fdb_set(kv2, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        if (i%27 == 0) s = fdb_set(kv2, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        fdb_doc_free(doc);
+    }
+    s = fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_get_kvs_seqnum(kv2, &seq3);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    // write documents third time
+    for (i=0;i<n;++i){
+        sprintf(key, keystr, i);
+        sprintf(value, valuestr, i, "default(commit4)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
+        s = fdb_set(db, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        fdb_doc_free(doc);
+        sprintf(value, valuestr, i, "kv1(commit4)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
+        s = fdb_set(kv1, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        if (i%15 == 0) s = fdb_set(kv1, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        fdb_doc_free(doc);
+        sprintf(value, valuestr, i, "kv2(commit4)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
+        s = fdb_set(kv2, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        if (i%27 == 0) s = fdb_set(kv2, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        fdb_doc_free(doc);
+    }
+    s = fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    // rollback kv1 using seq1
+    s = fdb_rollback(&kv1, seq1);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    // retrieve check
+    for (i=0;i<n;++i){
+        sprintf(key, keystr, i);
+        sprintf(value, valuestr, i, "default(commit4)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get(db, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        fdb_doc_free(doc);
+        sprintf(value, valuestr, i, "kv1(commit1)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get(kv1, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        fdb_doc_free(doc);
+        sprintf(value, valuestr, i, "kv2(commit4)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get(kv2, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        fdb_doc_free(doc);
+    }
+
+    // rollback db using seq2
+    s = fdb_rollback(&db, seq2);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    // retrieve check
+    for (i=0;i<n;++i){
+        sprintf(key, keystr, i);
+        sprintf(value, valuestr, i, "default(commit2)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get(db, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        fdb_doc_free(doc);
+        sprintf(value, valuestr, i, "kv1(commit1)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get(kv1, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        fdb_doc_free(doc);
+        sprintf(value, valuestr, i, "kv2(commit4)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get(kv2, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        fdb_doc_free(doc);
+    }
+
+    // rollback db using seq3
+    s = fdb_rollback(&kv2, seq3);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    // retrieve check
+    for (i=0;i<n;++i){
+        sprintf(key, keystr, i);
+        sprintf(value, valuestr, i, "default(commit2)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get(db, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        fdb_doc_free(doc);
+        sprintf(value, valuestr, i, "kv1(commit1)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get(kv1, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        fdb_doc_free(doc);
+        sprintf(value, valuestr, i, "kv2(commit3)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get(kv2, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        fdb_doc_free(doc);
+    }
+
+    // close & re-open
+    s = fdb_kvs_close(kv1);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_kvs_close(kv2);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_close(dbfile);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    if (opt & MULTI_KV_VAR_CMP) {
+        s = fdb_open_custom_cmp(&dbfile, "./dummy", &config,
+                                3, kvs_names, functions);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+    } else {
+        s = fdb_open(&dbfile, "./dummy", &config);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+    }
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    fdb_kvs_open(dbfile, &db, NULL, &kvs_config);
+    fdb_kvs_open(dbfile, &kv1, "kv1", &kvs_config);
+    fdb_kvs_open(dbfile, &kv2, "kv2", &kvs_config);
+
+    // retrieve check after re-open
+    for (i=0;i<n;++i){
+        sprintf(key, keystr, i);
+        sprintf(value, valuestr, i, "default(commit2)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get(db, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        fdb_doc_free(doc);
+        sprintf(value, valuestr, i, "kv1(commit1)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get(kv1, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        fdb_doc_free(doc);
+        sprintf(value, valuestr, i, "kv2(commit3)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get(kv2, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        fdb_doc_free(doc);
+    }
+
+    fdb_kvs_close(kv1);
+    fdb_kvs_close(kv2);
+    fdb_close(dbfile);
+
+    fdb_shutdown();
+
+    memleak_end();
+
+    if (opt & MULTI_KV_VAR_CMP) {
+        TEST_RESULT("multiple KV instances rollback test "
+                    "(custom key order)");
+    } else {
+        TEST_RESULT("multiple KV instances rollback test");
+    }
+}
+
+void multi_kv_custom_cmp_test()
+{
+    TEST_INIT();
+
+    int n = 1000;
+    int i, r;
+    char key[256], value[256];
+    char keystr[] = "key%06d";
+    char valuestr[] = "value%08d(%s)";
+    fdb_file_handle *dbfile;
+    fdb_kvs_handle *db, *kv1, *kv2;
+    fdb_config config;
+    fdb_kvs_config kvs_config;
+    fdb_doc *doc;
+    fdb_iterator *it;
+    fdb_status s;
+
+    sprintf(value, SHELL_DEL" dummy*");
+    r = system(value);
+    (void)r;
+
+    memleak_start();
+
+    config = fdb_get_default_config();
+    kvs_config = fdb_get_default_kvs_config();
+    config.multi_kv_instances = true;
+    config.wal_threshold = 256;
+    config.wal_flush_before_commit = false;
+    config.buffercache_size = 0;
+
+    s = fdb_open(&dbfile, "./dummy", &config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_kvs_open(dbfile, &db, NULL, &kvs_config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    // insert using 'default' instance
+    for (i=0;i<n;++i) {
+        sprintf(key, keystr, i);
+        sprintf(value, valuestr, i, "default");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
+        s = fdb_set(db, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        fdb_doc_free(doc);
+    }
+    s = fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    // create 'kv1' using custom cmp function
+    kvs_config.custom_cmp = _multi_kv_test_keycmp;
+    s = fdb_kvs_open(dbfile, &kv1, "kv1", &kvs_config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    // insert using 'kv1' instance
+    for (i=0;i<n;++i) {
+        sprintf(key, keystr, i);
+        sprintf(value, valuestr, i, "kv1_custom_cmp");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
+        s = fdb_set(kv1, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        fdb_doc_free(doc);
+    }
+    s = fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    // retrieve check
+    for (i=0;i<n;++i) {
+        sprintf(key, keystr, i);
+        sprintf(value, valuestr, i, "default");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get(db, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        fdb_doc_free(doc);
+
+        sprintf(value, valuestr, i, "kv1_custom_cmp");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get(kv1, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        fdb_doc_free(doc);
+    }
+
+    // close & reopen handles
+    s = fdb_close(dbfile);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    kvs_config.custom_cmp = NULL;
+    s = fdb_open(&dbfile, "./dummy", &config);
+    TEST_CHK(s != FDB_RESULT_SUCCESS); // must fail
+
+    { // retry with wrong cmp function
+        char *kvs_names[] = {NULL};
+        fdb_custom_cmp_variable functions[] = {_multi_kv_test_keycmp};
+        s = fdb_open_custom_cmp(&dbfile, "./dummy", &config,
+                                1, kvs_names, functions);
+        TEST_CHK(s != FDB_RESULT_SUCCESS); // must fail
+    }
+
+    { // retry with correct function
+        char *kvs_names[] = {(char*)"kv1"};
+        fdb_custom_cmp_variable functions[] = {_multi_kv_test_keycmp};
+        s = fdb_open_custom_cmp(&dbfile, "./dummy", &config,
+                                1, kvs_names, functions);
+        TEST_CHK(s == FDB_RESULT_SUCCESS); // must succeed this time
+    }
+
+    s = fdb_kvs_open(dbfile, &db, NULL, &kvs_config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_kvs_open(dbfile, &kv1, "kv1", &kvs_config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    // retrieve check
+    for (i=0;i<n;++i) {
+        sprintf(key, keystr, i);
+        sprintf(value, valuestr, i, "default");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get(db, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        fdb_doc_free(doc);
+
+        sprintf(value, valuestr, i, "kv1_custom_cmp");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get(kv1, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        fdb_doc_free(doc);
+    }
+
+    // create one more KV store
+    kvs_config.custom_cmp = NULL;
+    s = fdb_kvs_open(dbfile, &kv2, "kv2", &kvs_config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    // insert using 'kv2' instance
+    for (i=0;i<n;++i) {
+        sprintf(key, keystr, i);
+        sprintf(value, valuestr, i, "kv2");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
+        s = fdb_set(kv2, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        fdb_doc_free(doc);
+    }
+    s = fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    // retrieve check
+    for (i=0;i<n;++i) {
+        sprintf(key, keystr, i);
+        sprintf(value, valuestr, i, "default");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get(db, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        fdb_doc_free(doc);
+
+        sprintf(value, valuestr, i, "kv1_custom_cmp");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get(kv1, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        fdb_doc_free(doc);
+
+        sprintf(value, valuestr, i, "kv2");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get(kv2, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        fdb_doc_free(doc);
+    }
+
+    // update all documents
+    for (i=0;i<n;++i) {
+        sprintf(key, keystr, i);
+        sprintf(value, valuestr, i, "default(updated)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
+        s = fdb_set(db, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        fdb_doc_free(doc);
+
+        sprintf(key, keystr, i);
+        sprintf(value, valuestr, i, "kv1_custom_cmp(updated)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
+        s = fdb_set(kv1, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        fdb_doc_free(doc);
+
+        sprintf(key, keystr, i);
+        sprintf(value, valuestr, i, "kv2(updated)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
+        s = fdb_set(kv2, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        fdb_doc_free(doc);
+    }
+    // WAL flush at once
+    s = fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    // retrieve check
+    for (i=0;i<n;++i) {
+        sprintf(key, keystr, i);
+        sprintf(value, valuestr, i, "default(updated)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get(db, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        fdb_doc_free(doc);
+
+        sprintf(value, valuestr, i, "kv1_custom_cmp(updated)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get(kv1, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        fdb_doc_free(doc);
+
+        sprintf(value, valuestr, i, "kv2(updated)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get(kv2, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        fdb_doc_free(doc);
+    }
+
+    // do compaction
+    s = fdb_compact(dbfile, "./dummy2");
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    // retrieve check
+    for (i=0;i<n;++i) {
+        sprintf(key, keystr, i);
+        sprintf(value, valuestr, i, "default(updated)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get(db, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        fdb_doc_free(doc);
+
+        sprintf(value, valuestr, i, "kv1_custom_cmp(updated)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get(kv1, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        fdb_doc_free(doc);
+
+        sprintf(value, valuestr, i, "kv2(updated)");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get(kv2, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        fdb_doc_free(doc);
+    }
+
+    // create full iterator for 'kv1'
+    i = 0;
+    s = fdb_iterator_init(kv1, &it, NULL, 0, NULL, 0, FDB_ITR_NONE);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    while (fdb_iterator_next(it, &doc) == FDB_RESULT_SUCCESS) {
+        sprintf(key, keystr, i);
+        sprintf(value, valuestr, i, "kv1_custom_cmp(updated)");
+        TEST_CHK(!memcmp(doc->key, key, doc->keylen));
+        TEST_CHK(!memcmp(doc->body, value, doc->bodylen));
+        fdb_doc_free(doc);
+        i++;
+    }
+    TEST_CHK(i == n);
+    s = fdb_iterator_close(it);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    s = fdb_close(dbfile);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_shutdown();
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    memleak_end();
+
+    TEST_RESULT("multiple KV instances custom comparison function test");
+}
+
+void multi_kv_fdb_open_custom_cmp_test()
+{
+    // Unit test for MB-12593
+    TEST_INIT();
+
+    int n = 1000;
+    int i, r;
+    char key[256], value[256];
+    char keystr[] = "key%06d";
+    char valuestr[] = "value%08d(%s)";
+    fdb_file_handle *dbfile;
+    fdb_kvs_handle *db, *kv1, *kv2;
+    fdb_config config;
+    fdb_kvs_config kvs_config;
+    fdb_doc *doc;
+    fdb_status s;
+
+    char *kvs_names[] = {(char*)"default", (char*)"kv1", (char*)"kv2"};
+    fdb_custom_cmp_variable functions[] = {_multi_kv_test_keycmp,
+                                           _multi_kv_test_keycmp,
+                                           NULL};
+
+    sprintf(value, SHELL_DEL" dummy*");
+    r = system(value);
+    (void)r;
+
+    memleak_start();
+
+    config = fdb_get_default_config();
+    kvs_config = fdb_get_default_kvs_config();
+    config.multi_kv_instances = true;
+    config.wal_threshold = 256;
+    config.wal_flush_before_commit = false;
+    config.buffercache_size = 0;
+
+    s = fdb_open_custom_cmp(&dbfile, "./dummy", &config,
+                            3, kvs_names, functions);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_kvs_open(dbfile, &db, NULL, &kvs_config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_kvs_open(dbfile, &kv1, "kv1", &kvs_config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    kvs_config.custom_cmp = _multi_kv_test_keycmp;
+    s = fdb_kvs_open(dbfile, &kv2, "kv2", &kvs_config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    // insert using 'default' instance
+    for (i=0;i<n;++i) {
+        sprintf(key, keystr, i);
+        sprintf(value, valuestr, i, "default");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
+        s = fdb_set(db, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        fdb_doc_free(doc);
+    }
+
+    // insert using 'kv1' instance
+    for (i=0;i<n;++i) {
+        sprintf(key, keystr, i);
+        sprintf(value, valuestr, i, "kv1_custom_cmp");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
+        s = fdb_set(kv1, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        fdb_doc_free(doc);
+    }
+
+    // insert using 'kv2' instance
+    for (i=0;i<n;++i) {
+        sprintf(key, keystr, i);
+        sprintf(value, valuestr, i, "kv2");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
+        s = fdb_set(kv2, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        fdb_doc_free(doc);
+    }
+    s = fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_close(dbfile);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    s = fdb_open(&dbfile, "./dummy", &config);
+    TEST_CHK(s != FDB_RESULT_SUCCESS); // must fail
+
+    s = fdb_open_custom_cmp(&dbfile, "./dummy", &config,
+                            3, kvs_names, functions);
+    TEST_CHK(s != FDB_RESULT_SUCCESS); // must fail
+
+    functions[2] = _multi_kv_test_keycmp;
+    s = fdb_open_custom_cmp(&dbfile, "./dummy", &config,
+                            3, kvs_names, functions);
+    TEST_CHK(s == FDB_RESULT_SUCCESS); // must succeed
+    s = fdb_kvs_open(dbfile, &db, NULL, &kvs_config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_kvs_open(dbfile, &kv1, "kv1", &kvs_config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_kvs_open(dbfile, &kv2, "kv2", &kvs_config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    // retrieve check
+    for (i=0;i<n;++i) {
+        sprintf(key, keystr, i);
+        sprintf(value, valuestr, i, "default");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get(db, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        fdb_doc_free(doc);
+
+        sprintf(value, valuestr, i, "kv1_custom_cmp");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get(kv1, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        fdb_doc_free(doc);
+
+        sprintf(value, valuestr, i, "kv2");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get(kv2, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        fdb_doc_free(doc);
+    }
+
+    s = fdb_close(dbfile);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_shutdown();
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    memleak_end();
+
+    TEST_RESULT("multiple KV instances fdb_open_custom_cmp test");
+}
+
+void multi_kv_use_existing_mode_test()
+{
+    TEST_INIT();
+
+    int n = 1000;
+    int i, r;
+    char key[256], value[256];
+    char keystr[] = "key%06d";
+    char valuestr[] = "value%08d(%s)";
+    fdb_file_handle *dbfile;
+    fdb_kvs_handle *db;
+    fdb_config config;
+    fdb_kvs_config kvs_config;
+    fdb_doc *doc;
+    fdb_status s;
+
+    sprintf(value, SHELL_DEL" dummy*");
+    r = system(value);
+    (void)r;
+
+    memleak_start();
+
+    config = fdb_get_default_config();
+    kvs_config = fdb_get_default_kvs_config();
+    config.wal_threshold = 256;
+    config.buffercache_size = 0;
+
+    // create DB file under multi KV instance mode
+    config.multi_kv_instances = true;
+    s = fdb_open(&dbfile, "./dummy_multi", &config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_kvs_open(dbfile, &db, NULL, &kvs_config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    // insert using 'default' instance
+    for (i=0;i<n;++i) {
+        sprintf(key, keystr, i);
+        sprintf(value, valuestr, i, "default");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
+        s = fdb_set(db, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        fdb_doc_free(doc);
+    }
+
+    s = fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_close(dbfile);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    // open under single KV instance mode
+    config.multi_kv_instances = false;
+    s = fdb_open(&dbfile, "./dummy_multi", &config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS); // must succeed
+    s = fdb_kvs_open(dbfile, &db, NULL, &kvs_config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    // retrieve check
+    for (i=0;i<n;++i) {
+        sprintf(key, keystr, i);
+        sprintf(value, valuestr, i, "default");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get(db, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        fdb_doc_free(doc);
+    }
+
+    s = fdb_close(dbfile);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    // create DB file under single KV instance mode
+    config.multi_kv_instances = false;
+    s = fdb_open(&dbfile, "./dummy_single", &config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_kvs_open(dbfile, &db, NULL, &kvs_config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    // insert using 'default' instance
+    for (i=0;i<n;++i) {
+        sprintf(key, keystr, i);
+        sprintf(value, valuestr, i, "default");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
+        s = fdb_set(db, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        fdb_doc_free(doc);
+    }
+
+    s = fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    s = fdb_close(dbfile);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    // open under multi KV instance mode
+    config.multi_kv_instances = true;
+    s = fdb_open(&dbfile, "./dummy_single", &config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS); // must succeed
+    s = fdb_kvs_open(dbfile, &db, NULL, &kvs_config);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    // retrieve check
+    for (i=0;i<n;++i) {
+        sprintf(key, keystr, i);
+        sprintf(value, valuestr, i, "default");
+        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
+        s = fdb_get(db, doc);
+        TEST_CHK(s == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+        fdb_doc_free(doc);
+    }
+
+    s = fdb_close(dbfile);
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+
+    s = fdb_shutdown();
+    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    memleak_end();
+
+    TEST_RESULT("multiple KV instances use existing mode test");
+}
+
+void multi_kv_close_test()
+{
+    TEST_INIT();
+    memleak_start();
+
+    int i, r;
+    int n = 10;
+    fdb_file_handle *dbfile1;
+    fdb_kvs_handle *db1, *db2, *db3, *db4, *db5;
+    fdb_doc **doc = alca(fdb_doc*, n);
+    fdb_doc *rdoc;
+    fdb_status status;
+    fdb_config fconfig;
+    fdb_kvs_config kvs_config;
+
+    char keybuf[256], metabuf[256], bodybuf[256];
+
+    // remove previous dummy files
+    r = system(SHELL_DEL" dummy* > errorlog.txt");
+    (void)r;
+
+    fconfig = fdb_get_default_config();
+    fconfig.buffercache_size = 0;
+    fconfig.wal_threshold = 8;
+    fconfig.flags = FDB_OPEN_FLAG_CREATE;
+    fconfig.purging_interval = 0;
+    fconfig.compaction_threshold = 0;
+    fconfig.wal_flush_before_commit = true;
+
+    kvs_config = fdb_get_default_kvs_config();
+
+    // open db
+    fdb_open(&dbfile1, "dummy1", &fconfig);
+    fdb_kvs_open(dbfile1, &db1, "db1", &kvs_config);
+    fdb_kvs_open(dbfile1, &db2, "db2", &kvs_config);
+    fdb_kvs_open(dbfile1, &db3, "db3", &kvs_config);
+    fdb_kvs_open(dbfile1, &db4, "db4", &kvs_config);
+    fdb_kvs_open(dbfile1, &db5, "db5", &kvs_config);
+
+    // insert documents
+    for (i=0;i<n;++i){
+        sprintf(keybuf, "key%d", i);
+        sprintf(metabuf, "meta%d", i);
+        sprintf(bodybuf, "body%d", i);
+        fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
+            (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
+        fdb_set(db1, doc[i]);
+        fdb_set(db2, doc[i]);
+        fdb_set(db3, doc[i]);
+        fdb_set(db4, doc[i]);
+        fdb_set(db5, doc[i]);
+    }
+    // close db3,4
+    fdb_kvs_close(db3);
+    fdb_kvs_close(db4);
+
+
+    // insert documents
+    for (i=0;i<n;++i){
+        fdb_set(db1, doc[i]);
+        fdb_set(db2, doc[i]);
+        fdb_set(db5, doc[i]);
+    }
+
+    // remove db1
+    fdb_kvs_close(db1);
+    status = fdb_kvs_remove(dbfile1,"db1");
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+
+    // commit
+    status = fdb_commit(dbfile1, FDB_COMMIT_NORMAL);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+
+    // remove db5
+    fdb_kvs_close(db5);
+    status = fdb_kvs_remove(dbfile1, "db5");
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+
+    // attempt to read from remaining open kvs
+    for (i=0; i<n; i++){
+        fdb_doc_create(&rdoc, doc[i]->key, doc[i]->keylen, NULL, 0, NULL, 0);
+        status = fdb_get(db2, rdoc);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        fdb_doc_free(rdoc);
+    }
+
+    // close db2
+    status = fdb_kvs_close(db2);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+
+    // free resources
+    for (i=0; i<n; i++){
+       status = fdb_doc_free(doc[i]);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+    }
+
+    status = fdb_close(dbfile1);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    status = fdb_shutdown();
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+
+    memleak_end();
+    TEST_RESULT("multi KV close");
+}
+
+void multi_kv_drop_test()
+{
+    TEST_INIT();
+    memleak_start();
+
+    int i, r;
+    int n = 1000;
+    uint64_t file_size;
+    fdb_file_handle *dbfile;
+    fdb_kvs_handle *kv1, *kv2;
+    fdb_doc *doc, *rdoc;
+    fdb_status status;
+    fdb_config fconfig;
+    fdb_kvs_config kvs_config;
+    fdb_file_info file_info;
+    fdb_kvs_info kvs_info;
+
+    char keybuf[256], bodybuf[256];
+
+    // remove previous dummy files
+    r = system(SHELL_DEL" dummy* > errorlog.txt");
+    (void)r;
+
+    fconfig = fdb_get_default_config();
+    fconfig.buffercache_size = 0;
+    fconfig.wal_threshold = 64;
+    fconfig.flags = FDB_OPEN_FLAG_CREATE;
+    fconfig.purging_interval = 0;
+    fconfig.compaction_threshold = 0;
+
+    kvs_config = fdb_get_default_kvs_config();
+
+    // open db
+    fdb_open(&dbfile, "./dummy1", &fconfig);
+    fdb_kvs_open(dbfile, &kv1, "kv1", &kvs_config);
+    fdb_kvs_open(dbfile, &kv2, "kv2", &kvs_config);
+
+    // insert documents into both KV stores
+    memset(bodybuf, 'x', sizeof(bodybuf));
+    bodybuf[sizeof(bodybuf)-1] = 0;
+    for (i=0;i<n;++i){
+        sprintf(keybuf, "key%d", i);
+        fdb_doc_create(&doc, (void*)keybuf, strlen(keybuf),
+                       NULL, 0, (void*)bodybuf, strlen(bodybuf));
+        status = fdb_set(kv1, doc);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        status = fdb_set(kv2, doc);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        fdb_doc_free(doc);
+    }
+    status = fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+
+    // drop kv1
+    fdb_kvs_close(kv1);
+    status = fdb_kvs_remove(dbfile, "kv1");
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+
+    status = fdb_get_file_info(dbfile, &file_info);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    TEST_CHK(file_info.doc_count == (uint64_t)n);
+    file_size = file_info.file_size;
+
+    // close & re-open the file
+    fdb_kvs_close(kv2);
+    status = fdb_close(dbfile);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    fdb_open(&dbfile, "./dummy1", &fconfig);
+    fdb_kvs_open(dbfile, &kv2, "kv2", &kvs_config);
+
+    // re-create kv1 .. it must be empty
+    fdb_kvs_open(dbfile, &kv1, "kv1", &kvs_config);
+    for (i=0;i<n;++i){
+        sprintf(keybuf, "key%d", i);
+        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf), NULL, 0, NULL, 0);
+        status = fdb_get(kv1, rdoc);
+        TEST_CHK(status != FDB_RESULT_SUCCESS);
+        fdb_doc_free(rdoc);
+    }
+    sprintf(keybuf, "key%d", 0);
+    fdb_doc_create(&doc, (void*)keybuf, strlen(keybuf),
+                   NULL, 0, (void*)"new", 3);
+    status = fdb_set(kv1, doc);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    fdb_doc_free(doc);
+    status = fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+
+    // compaction skips the documents of the dropped KV store
+    status = fdb_compact(dbfile, "./dummy2");
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+
+    status = fdb_get_file_info(dbfile, &file_info);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    TEST_CHK(file_info.doc_count == (uint64_t)n + 1);
+    TEST_CHK(file_info.file_size + (uint64_t)n * strlen(bodybuf) / 2 <
+             file_size);
+
+    status = fdb_get_kvs_info(kv1, &kvs_info);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    TEST_CHK(kvs_info.doc_count == 1);
+
+    for (i=0;i<n;++i){
+        sprintf(keybuf, "key%d", i);
+        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf), NULL, 0, NULL, 0);
+        status = fdb_get(kv2, rdoc);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(rdoc->body, bodybuf, rdoc->bodylen));
+        fdb_doc_free(rdoc);
+
+        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf), NULL, 0, NULL, 0);
+        status = fdb_get(kv1, rdoc);
+        if (i == 0) {
+            TEST_CHK(status == FDB_RESULT_SUCCESS);
+            TEST_CHK(!memcmp(rdoc->body, "new", 3));
+        } else {
+            TEST_CHK(status != FDB_RESULT_SUCCESS);
+        }
+        fdb_doc_free(rdoc);
+    }
+
+    status = fdb_close(dbfile);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    status = fdb_shutdown();
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+
+    memleak_end();
+    TEST_RESULT("multi KV drop test");
+}
+
+void range_delete_test()
+{
+    TEST_INIT();
+    memleak_start();
+
+    int i, r;
+    int n = 100;
+    fdb_file_handle *dbfile;
+    fdb_kvs_handle *db, *kv1;
+    fdb_doc *doc, *rdoc;
+    fdb_iterator *iterator;
+    fdb_status status;
+    fdb_config fconfig;
+    fdb_kvs_config kvs_config;
+
+    char keybuf[256], bodybuf[256];
+
+    // remove previous dummy files
+    r = system(SHELL_DEL" dummy* > errorlog.txt");
+    (void)r;
+
+    fconfig = fdb_get_default_config();
+    fconfig.buffercache_size = 0;
+    fconfig.wal_threshold = 64;
+    fconfig.flags = FDB_OPEN_FLAG_CREATE;
+    fconfig.purging_interval = 0;
+    fconfig.compaction_threshold = 0;
+
+    kvs_config = fdb_get_default_kvs_config();
+
+    // open db
+    fdb_open(&dbfile, "./dummy1", &fconfig);
+    fdb_kvs_open_default(dbfile, &db, &kvs_config);
+    fdb_kvs_open(dbfile, &kv1, "kv1", &kvs_config);
+
+    // insert documents into both KV stores
+    for (i=0;i<n;++i){
+        sprintf(keybuf, "key%04d", i);
+        sprintf(bodybuf, "body%04d", i);
+        fdb_doc_create(&doc, (void*)keybuf, strlen(keybuf),
+                       NULL, 0, (void*)bodybuf, strlen(bodybuf));
+        status = fdb_set(db, doc);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        status = fdb_set(kv1, doc);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        fdb_doc_free(doc);
+    }
+    status = fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+
+    // delete [key0020, key0039] in the default KV store,
+    // and [key0090, +inf) in 'kv1'
+    status = fdb_del_range(db, "key0020", 7, "key0039", 7);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    status = fdb_del_range(kv1, "key0090", 7, NULL, 0);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+
+    // re-insert a key in the deleted range
+    sprintf(keybuf, "key%04d", 30);
+    fdb_doc_create(&doc, (void*)keybuf, strlen(keybuf),
+                   NULL, 0, (void*)"new", 3);
+    status = fdb_set(db, doc);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    fdb_doc_free(doc);
+
+    for (r=0;r<3;++r){
+        if (r == 1) {
+            // range tombstones should be persisted by commit
+            status = fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
+            TEST_CHK(status == FDB_RESULT_SUCCESS);
+            fdb_kvs_close(kv1);
+            fdb_kvs_close(db);
+            status = fdb_close(dbfile);
+            TEST_CHK(status == FDB_RESULT_SUCCESS);
+            fdb_open(&dbfile, "./dummy1", &fconfig);
+            fdb_kvs_open_default(dbfile, &db, &kvs_config);
+            fdb_kvs_open(dbfile, &kv1, "kv1", &kvs_config);
+        } else if (r == 2) {
+            // compaction physically removes the deleted documents
+            status = fdb_compact(dbfile, "./dummy2");
+            TEST_CHK(status == FDB_RESULT_SUCCESS);
+        }
+
+        for (i=0;i<n;++i){
+            sprintf(keybuf, "key%04d", i);
+            fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf),
+                           NULL, 0, NULL, 0);
+            status = fdb_get(db, rdoc);
+            if (i == 30) {
+                TEST_CHK(status == FDB_RESULT_SUCCESS);
+                TEST_CHK(!memcmp(rdoc->body, "new", 3));
+            } else if (i >= 20 && i < 40) {
+                TEST_CHK(status == FDB_RESULT_KEY_NOT_FOUND);
+            } else {
+                TEST_CHK(status == FDB_RESULT_SUCCESS);
+            }
+            fdb_doc_free(rdoc);
+
+            fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf),
+                           NULL, 0, NULL, 0);
+            status = fdb_get(kv1, rdoc);
+            if (i >= 90) {
+                TEST_CHK(status == FDB_RESULT_KEY_NOT_FOUND);
+            } else {
+                TEST_CHK(status == FDB_RESULT_SUCCESS);
+            }
+            fdb_doc_free(rdoc);
+        }
+
+        // iterators should skip the deleted documents
+        i = 0;
+        status = fdb_iterator_init(db, &iterator, NULL, 0, NULL, 0,
+                                   FDB_ITR_NONE);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        while (fdb_iterator_next(iterator, &rdoc) == FDB_RESULT_SUCCESS) {
+            TEST_CHK(memcmp(rdoc->key, "key0020", 7) < 0 ||
+                     memcmp(rdoc->key, "key0039", 7) > 0 ||
+                     !memcmp(rdoc->key, "key0030", 7));
+            fdb_doc_free(rdoc);
+            i++;
+        }
+        fdb_iterator_close(iterator);
+        TEST_CHK(i == n - 19);
+
+        i = 0;
+        status = fdb_iterator_sequence_init(kv1, &iterator, 0, 0,
+                                            FDB_ITR_NONE);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        while (fdb_iterator_next(iterator, &rdoc) == FDB_RESULT_SUCCESS) {
+            TEST_CHK(memcmp(rdoc->key, "key0090", 7) < 0);
+            fdb_doc_free(rdoc);
+            i++;
+        }
+        fdb_iterator_close(iterator);
+        TEST_CHK(i == n - 10);
+    }
+
+    fdb_kvs_close(kv1);
+    fdb_kvs_close(db);
+    status = fdb_close(dbfile);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    status = fdb_shutdown();
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+
+    memleak_end();
+    TEST_RESULT("range delete test");
+}
+
+void bloom_filter_test()
+{
+    TEST_INIT();
+    memleak_start();
+
+    int i, r;
+    int n = 5000;
+    fdb_file_handle *dbfile;
+    fdb_kvs_handle *db, *kv1;
+    fdb_doc *doc, *rdoc;
+    fdb_status status;
+    fdb_config fconfig;
+    fdb_kvs_config kvs_config;
+    fdb_bloom_stats stats;
+
+    char keybuf[256], bodybuf[256];
+
+    // remove previous dummy files
+    r = system(SHELL_DEL" dummy* > errorlog.txt");
+    (void)r;
+
+    fconfig = fdb_get_default_config();
+    fconfig.buffercache_size = 0;
+    fconfig.wal_threshold = 1024;
+    fconfig.flags = FDB_OPEN_FLAG_CREATE;
+    fconfig.purging_interval = 0;
+    fconfig.compaction_threshold = 0;
+
+    kvs_config = fdb_get_default_kvs_config();
+
+    // a file created without the filter
+    fdb_open(&dbfile, "./dummy1", &fconfig);
+    fdb_kvs_open_default(dbfile, &db, &kvs_config);
+    fdb_doc_create(&doc, (void*)"key", 3, NULL, 0, (void*)"body", 4);
+    fdb_set(db, doc);
+    fdb_doc_free(doc);
+    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
+    status = fdb_get_bloom_stats(dbfile, &stats);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    TEST_CHK(stats.num_bits == 0);
+    fdb_kvs_close(db);
+    fdb_close(dbfile);
+
+    // the filter can be created only for an empty file
+    fconfig.bloom_filter_bits_per_key = 10;
+    fdb_open(&dbfile, "./dummy1", &fconfig);
+    fdb_get_bloom_stats(dbfile, &stats);
+    TEST_CHK(stats.num_bits == 0);
+    fdb_close(dbfile);
+
+    fdb_open(&dbfile, "./dummy2", &fconfig);
+    fdb_kvs_open_default(dbfile, &db, &kvs_config);
+    fdb_kvs_open(dbfile, &kv1, "kv1", &kvs_config);
+
+    // insert more keys than the initial capacity of the filter
+    for (i=0;i<n;++i){
+        sprintf(keybuf, "key%06d", i);
+        sprintf(bodybuf, "body%06d", i);
+        fdb_doc_create(&doc, (void*)keybuf, strlen(keybuf),
+                       NULL, 0, (void*)bodybuf, strlen(bodybuf));
+        status = fdb_set(db, doc);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        status = fdb_set(kv1, doc);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        fdb_doc_free(doc);
+    }
+    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
+
+    // keys in WAL only
+    fdb_doc_create(&doc, (void*)"wal_key", 7, NULL, 0, (void*)"body", 4);
+    fdb_set(db, doc);
+    fdb_doc_free(doc);
+
+    for (r=0;r<3;++r){
+        if (r == 1) {
+            // the filter should be persisted by commit
+            fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+            fdb_kvs_close(kv1);
+            fdb_kvs_close(db);
+            status = fdb_close(dbfile);
+            TEST_CHK(status == FDB_RESULT_SUCCESS);
+            fdb_open(&dbfile, "./dummy2", &fconfig);
+            fdb_kvs_open_default(dbfile, &db, &kvs_config);
+            fdb_kvs_open(dbfile, &kv1, "kv1", &kvs_config);
+        } else if (r == 2) {
+            // compaction rebuilds the filter
+            status = fdb_compact(dbfile, "./dummy3");
+            TEST_CHK(status == FDB_RESULT_SUCCESS);
+        }
+
+        fdb_get_bloom_stats(dbfile, &stats);
+        TEST_CHK(stats.num_keys >= (uint64_t)n * 2 * 99 / 100);
+        TEST_CHK(stats.memory_used >= stats.num_bits / 8);
+        if (r < 2) {
+            TEST_CHK(stats.num_stages > 1);
+        } else {
+            TEST_CHK(stats.num_stages == 1);
+        }
+
+        // existing keys
+        for (i=0;i<n;++i){
+            sprintf(keybuf, "key%06d", i);
+            fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf),
+                           NULL, 0, NULL, 0);
+            status = fdb_get(db, rdoc);
+            TEST_CHK(status == FDB_RESULT_SUCCESS);
+            fdb_doc_free(rdoc);
+            fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf),
+                           NULL, 0, NULL, 0);
+            status = fdb_get_metaonly(kv1, rdoc);
+            TEST_CHK(status == FDB_RESULT_SUCCESS);
+            fdb_doc_free(rdoc);
+        }
+        fdb_doc_create(&rdoc, (void*)"wal_key", 7, NULL, 0, NULL, 0);
+        status = fdb_get(db, rdoc);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        fdb_doc_free(rdoc);
+
+        // non-existing keys
+        for (i=0;i<n;++i){
+            sprintf(keybuf, "key%06d", i + n);
+            fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf),
+                           NULL, 0, NULL, 0);
+            status = fdb_get(db, rdoc);
+            TEST_CHK(status == FDB_RESULT_KEY_NOT_FOUND);
+            fdb_doc_free(rdoc);
+            fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf),
+                           NULL, 0, NULL, 0);
+            status = fdb_get_metaonly(kv1, rdoc);
+            TEST_CHK(status == FDB_RESULT_KEY_NOT_FOUND);
+            fdb_doc_free(rdoc);
+        }
+
+        fdb_get_bloom_stats(dbfile, &stats);
+        TEST_CHK(stats.num_checks >= (uint64_t)n * 2);
+        // most of lookups for non-existing keys should be filtered out
+        TEST_CHK(stats.num_negatives >= (uint64_t)n * 2 * 9 / 10);
+        TEST_CHK(stats.observed_fp_rate < 0.1);
+        TEST_CHK(stats.estimated_fp_rate > 0 &&
+                 stats.estimated_fp_rate < 0.1);
+    }
+
+    fdb_kvs_close(kv1);
+    fdb_kvs_close(db);
+    status = fdb_close(dbfile);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    status = fdb_shutdown();
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+
+    memleak_end();
+    TEST_RESULT("bloom filter test");
+}
+
+void baseline_file_compat_test()
+{
+    TEST_INIT();
+    memleak_start();
+
+    int i, r;
+    int n = 100;
+    fdb_file_handle *dbfile;
+    fdb_kvs_handle *db, *kv1;
+    fdb_doc *rdoc;
+    fdb_status status;
+    fdb_config fconfig;
+    fdb_kvs_config kvs_config;
+    char keybuf[256], bodybuf[256];
+    char cmd[SHELL_MAX_PATHLEN];
+    const char *filename = "./dummy1";
+
+    // remove previous dummy files
+    r = system(SHELL_DEL" dummy* > errorlog.txt");
+    (void)r;
+
+    // 'baseline.fdb' was written by the version before the DB header got
+    // the range tombstone and Bloom filter offsets. It contains 'key0000' to
+    // 'key0099' in both the default KV store and 'kv1', every 10th key of
+    // the default KV store is deleted, and 'key0001', 'key0011', ... were
+    // updated after compaction from './baseline_tmp.fdb' and committed
+    // without WAL flushing.
+    sprintf(cmd, SHELL_COPY " %s" SHELL_DMT "baseline.fdb dummy1 > errorlog.txt",
+            FDB_TEST_DATA_DIR);
+    r = system(cmd);
+    (void)r;
+
+    fconfig = fdb_get_default_config();
+    fconfig.buffercache_size = 0;
+    fconfig.wal_threshold = 1024;
+    fconfig.compaction_threshold = 0;
+    fconfig.bloom_filter_bits_per_key = 10;
+    kvs_config = fdb_get_default_kvs_config();
+
+    for (r=0;r<3;++r){
+        status = fdb_open(&dbfile, filename, &fconfig);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        fdb_kvs_open_default(dbfile, &db, &kvs_config);
+        status = fdb_kvs_open(dbfile, &kv1, "kv1", &kvs_config);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+
+        for (i=0;i<n;++i){
+            sprintf(keybuf, "key%04d", i);
+            fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf),
+                           NULL, 0, NULL, 0);
+            status = fdb_get(db, rdoc);
+            if (i % 10 == 0 || (r > 0 && i >= 50 && i < 60)) {
+                TEST_CHK(status == FDB_RESULT_KEY_NOT_FOUND);
+            } else {
+                TEST_CHK(status == FDB_RESULT_SUCCESS);
+                if (i % 10 == 1) {
+                    sprintf(bodybuf, "upd%04d", i);
+                } else {
+                    sprintf(bodybuf, "body%04d", i);
+                }
+                TEST_CHK(!memcmp(rdoc->body, bodybuf, rdoc->bodylen));
+            }
+            fdb_doc_free(rdoc);
+
+            fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf),
+                           NULL, 0, NULL, 0);
+            status = fdb_get(kv1, rdoc);
+            TEST_CHK(status == FDB_RESULT_SUCCESS);
+            sprintf(bodybuf, "kv1_body%04d", i);
+            TEST_CHK(!memcmp(rdoc->body, bodybuf, rdoc->bodylen));
+            fdb_doc_free(rdoc);
+        }
+
+        if (r == 0) {
+            // headers written from now on carry the new fields
+            status = fdb_del_range(db, "key0050", 7, "key0059", 7);
+            TEST_CHK(status == FDB_RESULT_SUCCESS);
+            status = fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
+            TEST_CHK(status == FDB_RESULT_SUCCESS);
+        } else if (r == 1) {
+            status = fdb_compact(dbfile, "./dummy2");
+            TEST_CHK(status == FDB_RESULT_SUCCESS);
+            filename = "./dummy2";
+        }
+
+        fdb_kvs_close(kv1);
+        fdb_kvs_close(db);
+        status = fdb_close(dbfile);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+    }
+    status = fdb_shutdown();
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+
+    memleak_end();
+    TEST_RESULT("baseline file compatibility test");
+}
+
+void node_format_test()
+{
+    TEST_INIT();
+    memleak_start();
+
+    int i, j, r;
+    int n = 3000;
+    fdb_file_handle *dbfile;
+    fdb_kvs_handle *db, *kv1, *kv2, *kvs[3];
+    fdb_doc *rdoc;
+    fdb_iterator *iterator;
+    fdb_status status;
+    fdb_config fconfig;
+    fdb_kvs_config kvs_config, kvs_config_cmp;
+    char keybuf[256], bodybuf[256];
+    char *kvs_names[] = {(char*)"kv2"};
+    fdb_custom_cmp_variable functions[] = {_multi_kv_test_keycmp};
+
+    // remove previous dummy files
+    r = system(SHELL_DEL" dummy* > errorlog.txt");
+    (void)r;
+
+    fconfig = fdb_get_default_config();
+    fconfig.buffercache_size = 0;
+    fconfig.wal_threshold = 256;
+    fconfig.compaction_threshold = 0;
+    kvs_config = fdb_get_default_kvs_config();
+    // KV store with a custom compare function uses leaf b-trees
+    kvs_config_cmp = kvs_config;
+    kvs_config_cmp.custom_cmp = _multi_kv_test_keycmp;
+
+    fconfig.node_format = 0xff;
+    status = fdb_open(&dbfile, "./dummy1", &fconfig);
+    TEST_CHK(status == FDB_RESULT_INVALID_CONFIG);
+
+    // half of the documents are indexed in the new node format,
+    // and the rest in the old one; then compaction rewrites all of them
+    // in the new format
+    for (r=0;r<3;++r){
+        fconfig.node_format = (r == 1)?(FDB_NODE_FORMAT_V1):
+                                       (FDB_NODE_FORMAT_V2);
+        status = fdb_open_custom_cmp(&dbfile,
+                                     (r < 2)?("./dummy1"):("./dummy2"),
+                                     &fconfig, 1, kvs_names, functions);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        fdb_kvs_open_default(dbfile, &db, &kvs_config);
+        fdb_kvs_open(dbfile, &kv1, "kv1", &kvs_config);
+        fdb_kvs_open(dbfile, &kv2, "kv2", &kvs_config_cmp);
+        kvs[0] = db;
+        kvs[1] = kv1;
+        kvs[2] = kv2;
+
+        if (r < 2) {
+            for (i=r*n/2;i<(r+1)*n/2;++i){
+                sprintf(keybuf, "key%06d", i);
+                sprintf(bodybuf, "body%06d", i);
+                fdb_set_kv(db, keybuf, strlen(keybuf),
+                           bodybuf, strlen(bodybuf));
+                fdb_set_kv(kv1, keybuf, strlen(keybuf),
+                           bodybuf, strlen(bodybuf));
+                fdb_set_kv(kv2, keybuf, strlen(keybuf),
+                           bodybuf, strlen(bodybuf));
+            }
+            fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
+        }
+        if (r == 1) {
+            fdb_kvs_close(kv2);
+            fdb_kvs_close(kv1);
+            fdb_kvs_close(db);
+            fdb_close(dbfile);
+            fconfig.node_format = FDB_NODE_FORMAT_V2;
+            fdb_open_custom_cmp(&dbfile, "./dummy1", &fconfig,
+                                1, kvs_names, functions);
+            status = fdb_compact(dbfile, "./dummy2");
+            TEST_CHK(status == FDB_RESULT_SUCCESS);
+            fdb_close(dbfile);
+            continue;
+        }
+
+        for (j=0;j<3;++j){
+            for (i=0;i<((r == 0)?(n/2):(n));++i){
+                sprintf(keybuf, "key%06d", i);
+                sprintf(bodybuf, "body%06d", i);
+                fdb_doc_create(&rdoc, keybuf, strlen(keybuf), NULL, 0, NULL, 0);
+                status = fdb_get(kvs[j], rdoc);
+                TEST_CHK(status == FDB_RESULT_SUCCESS);
+                TEST_CHK(!memcmp(rdoc->body, bodybuf, rdoc->bodylen));
+                fdb_doc_free(rdoc);
+            }
+        }
+        i = 0;
+        fdb_iterator_sequence_init(db, &iterator, 0, 0, FDB_ITR_NONE);
+        while (fdb_iterator_next(iterator, &rdoc) == FDB_RESULT_SUCCESS) {
+            fdb_doc_free(rdoc);
+            i++;
+        }
+        fdb_iterator_close(iterator);
+        TEST_CHK(i == ((r == 0)?(n/2):(n)));
+
+        // keys of the custom compare KV store in order
+        i = 0;
+        fdb_iterator_init(kv2, &iterator, NULL, 0, NULL, 0, FDB_ITR_NONE);
+        while (fdb_iterator_next(iterator, &rdoc) == FDB_RESULT_SUCCESS) {
+            sprintf(keybuf, "key%06d", i);
+            TEST_CHK(!memcmp(rdoc->key, keybuf, rdoc->keylen));
+            fdb_doc_free(rdoc);
+            i++;
+        }
+        fdb_iterator_close(iterator);
+        TEST_CHK(i == ((r == 0)?(n/2):(n)));
+
+        fdb_kvs_close(kv2);
+        fdb_kvs_close(kv1);
+        fdb_kvs_close(db);
+        fdb_close(dbfile);
+    }
+    status = fdb_shutdown();
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+
+    memleak_end();
+    TEST_RESULT("node format test");
+}
+
+// count the B+tree node blocks of the file by their checksum algorithm,
+// which is tagged right after the 4-byte CRC at offset 8 of each node
+// (0xff: legacy CRC32, 0x01: CRC32C)
+static void _count_node_crc_types(const char *filename, size_t blocksize,
+                                  int *nlegacy, int *ncrc32c)
+{
+    uint8_t *buf = (uint8_t *)malloc(blocksize);
+    FILE *fp = fopen(filename, "rb");
+
+    *nlegacy = *ncrc32c = 0;
+    while (fp && fread(buf, 1, blocksize, fp) == blocksize) {
+        if (buf[blocksize-1] != 0xff) {
+            continue; // not a node block
+        }
+        if (buf[8 + 4] == 0xff) {
+            (*nlegacy)++;
+        } else if (buf[8 + 4] == 0x01) {
+            (*ncrc32c)++;
+        }
+    }
+    if (fp) {
+        fclose(fp);
+    }
+    free(buf);
+}
+
+void node_crc_format_test()
+{
+    TEST_INIT();
+    memleak_start();
+
+    int i, r, nlegacy, ncrc32c;
+    int n = 3000;
+    fdb_file_handle *dbfile;
+    fdb_kvs_handle *db;
+    fdb_doc *rdoc;
+    fdb_status status;
+    fdb_config fconfig;
+    fdb_kvs_config kvs_config;
+    char keybuf[256], bodybuf[256];
+
+    // remove previous dummy files
+    r = system(SHELL_DEL" dummy* > errorlog.txt");
+    (void)r;
+
+    fconfig = fdb_get_default_config();
+    fconfig.buffercache_size = 0;
+    fconfig.wal_threshold = 256;
+    fconfig.compaction_threshold = 0;
+    kvs_config = fdb_get_default_kvs_config();
+
+    // V1 files (the default) keep legacy checksums across compaction,
+    // while V2 files switch to CRC32C
+    for (r=0;r<2;++r){
+        fconfig.node_format = (r == 0)?(FDB_NODE_FORMAT_V1):
+                                       (FDB_NODE_FORMAT_V2);
+        status = fdb_open(&dbfile, (r == 0)?("./dummy1"):("./dummy3"),
+                          &fconfig);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        fdb_kvs_open_default(dbfile, &db, &kvs_config);
+        for (i=0;i<n;++i){
+            sprintf(keybuf, "key%06d", i);
+            sprintf(bodybuf, "body%06d", i);
+            fdb_set_kv(db, keybuf, strlen(keybuf), bodybuf, strlen(bodybuf));
+        }
+        fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
+
+        _count_node_crc_types((r == 0)?("./dummy1"):("./dummy3"),
+                              fconfig.blocksize, &nlegacy, &ncrc32c);
+        TEST_CHK(nlegacy > 0 || ncrc32c > 0);
+        TEST_CHK((r == 0)?(ncrc32c == 0):(nlegacy == 0));
+
+        status = fdb_compact(dbfile, (r == 0)?("./dummy2"):("./dummy4"));
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        _count_node_crc_types((r == 0)?("./dummy2"):("./dummy4"),
+                              fconfig.blocksize, &nlegacy, &ncrc32c);
+        TEST_CHK(nlegacy > 0 || ncrc32c > 0);
+        TEST_CHK((r == 0)?(ncrc32c == 0):(nlegacy == 0));
+
+        // the compacted file is readable and keeps its checksum algorithm
+        // after reopening
+        fdb_kvs_close(db);
+        fdb_close(dbfile);
+        status = fdb_open(&dbfile, (r == 0)?("./dummy2"):("./dummy4"),
+                          &fconfig);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        fdb_kvs_open_default(dbfile, &db, &kvs_config);
+        for (i=0;i<n;++i){
+            sprintf(keybuf, "key%06d", i);
+            sprintf(bodybuf, "body%06d", i);
+            fdb_doc_create(&rdoc, keybuf, strlen(keybuf), NULL, 0, NULL, 0);
+            status = fdb_get(db, rdoc);
+            TEST_CHK(status == FDB_RESULT_SUCCESS);
+            TEST_CHK(!memcmp(rdoc->body, bodybuf, rdoc->bodylen));
+            fdb_doc_free(rdoc);
+        }
+        sprintf(keybuf, "key%06d", n);
+        sprintf(bodybuf, "body%06d", n);
+        fdb_set_kv(db, keybuf, strlen(keybuf), bodybuf, strlen(bodybuf));
+        fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
+        _count_node_crc_types((r == 0)?("./dummy2"):("./dummy4"),
+                              fconfig.blocksize, &nlegacy, &ncrc32c);
+        TEST_CHK((r == 0)?(ncrc32c == 0):(nlegacy == 0));
+
+        fdb_kvs_close(db);
+        fdb_close(dbfile);
+    }
+    status = fdb_shutdown();
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+
+    memleak_end();
+    TEST_RESULT("node crc format test");
+}
+
+void latency_stats_test()
+{
+    TEST_INIT();
+    memleak_start();
+
+    int i, r;
+    int n = 1000;
+    fdb_file_handle *dbfile;
+    fdb_kvs_handle *db;
+    fdb_doc *doc, *rdoc;
+    fdb_status status;
+    fdb_config fconfig;
+    fdb_kvs_config kvs_config;
+    fdb_latency_stat stat;
+
+    char keybuf[256], bodybuf[256];
+
+    // remove previous dummy files
+    r = system(SHELL_DEL" dummy* > errorlog.txt");
+    (void)r;
+
+    fconfig = fdb_get_default_config();
+    fconfig.buffercache_size = 0;
+    fconfig.wal_threshold = 1024;
+    fconfig.flags = FDB_OPEN_FLAG_CREATE;
+    fconfig.purging_interval = 0;
+    fconfig.compaction_threshold = 0;
+
+    kvs_config = fdb_get_default_kvs_config();
+
+    fdb_open(&dbfile, "./dummy1", &fconfig);
+    fdb_kvs_open_default(dbfile, &db, &kvs_config);
+
+    for (i=0;i<n;++i){
+        sprintf(keybuf, "key%06d", i);
+        sprintf(bodybuf, "body%06d", i);
+        fdb_doc_create(&doc, (void*)keybuf, strlen(keybuf),
+                       NULL, 0, (void*)bodybuf, strlen(bodybuf));
+        fdb_set(db, doc);
+        fdb_doc_free(doc);
+    }
+    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
+
+    for (i=0;i<n;++i){
+        sprintf(keybuf, "key%06d", i);
+        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf), NULL, 0, NULL, 0);
+        status = fdb_get(db, rdoc);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        fdb_doc_free(rdoc);
+    }
+
+    status = fdb_get_latency_stats(dbfile, &stat, FDB_LATENCY_SETS);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    TEST_CHK(stat.count == (uint64_t)n);
+    TEST_CHK(stat.min <= stat.p50 && stat.p50 <= stat.p90 &&
+             stat.p90 <= stat.p99 && stat.p99 <= stat.p999 &&
+             stat.p999 <= stat.max);
+    TEST_CHK(stat.min <= stat.avg && stat.avg <= stat.max);
+
+    fdb_get_latency_stats(dbfile, &stat, FDB_LATENCY_GETS);
+    TEST_CHK(stat.count == (uint64_t)n);
+    fdb_get_latency_stats(dbfile, &stat, FDB_LATENCY_COMMITS);
+    TEST_CHK(stat.count == 1);
+    fdb_get_latency_stats(dbfile, &stat, FDB_LATENCY_WAL_FLUSH);
+    TEST_CHK(stat.count >= 1);
+    // all blocks are read from disk without the buffer cache
+    fdb_get_latency_stats(dbfile, &stat, FDB_LATENCY_READ_MISS);
+    TEST_CHK(stat.count > 0);
+    fdb_get_latency_stats(dbfile, &stat, FDB_LATENCY_FSYNC);
+    TEST_CHK(stat.count > 0);
+
+    status = fdb_get_latency_stats(dbfile, &stat, FDB_LATENCY_NUM_STATS);
+    TEST_CHK(status == FDB_RESULT_INVALID_ARGS);
+    TEST_CHK(!strcmp(fdb_latency_stat_name(FDB_LATENCY_GETS), "get"));
+    TEST_CHK(fdb_latency_stat_name(FDB_LATENCY_NUM_STATS) == NULL);
+
+    // stats are carried over to the new file by compaction
+    status = fdb_compact(dbfile, "./dummy2");
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    fdb_get_latency_stats(dbfile, &stat, FDB_LATENCY_SETS);
+    TEST_CHK(stat.count == (uint64_t)n);
+    fdb_get_latency_stats(dbfile, &stat, FDB_LATENCY_COMPACT_FLUSH);
+    TEST_CHK(stat.count == 1);
+    fdb_get_latency_stats(dbfile, &stat, FDB_LATENCY_COMPACT_MOVE);
+    TEST_CHK(stat.count == 1);
+    fdb_get_latency_stats(dbfile, &stat, FDB_LATENCY_COMPACT_SWITCH);
+    TEST_CHK(stat.count == 1);
+
+    // reset
+    status = fdb_reset_latency_stats(dbfile);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    for (i=0;i<FDB_LATENCY_NUM_STATS;++i){
+        fdb_get_latency_stats(dbfile, &stat, i);
+        TEST_CHK(stat.count == 0 && stat.max == 0);
+    }
+    fdb_doc_create(&rdoc, (void*)"key000000", 9, NULL, 0, NULL, 0);
+    fdb_get(db, rdoc);
+    fdb_doc_free(rdoc);
+    fdb_get_latency_stats(dbfile, &stat, FDB_LATENCY_GETS);
+    TEST_CHK(stat.count == 1 && stat.min == stat.max);
+
+    fdb_kvs_close(db);
+    status = fdb_close(dbfile);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    status = fdb_shutdown();
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+
+    memleak_end();
+    TEST_RESULT("latency stats test");
+}
+
+void buffer_cache_stats_test()
+{
+    TEST_INIT();
+    memleak_start();
+
+    int i, r;
+    int n = 3000;
+    fdb_file_handle *dbfile, *dbfile2;
+    fdb_kvs_handle *db, *db2;
+    fdb_doc *doc, *rdoc;
+    fdb_status status;
+    fdb_config fconfig;
+    fdb_kvs_config kvs_config;
+    fdb_buffer_cache_stats fstats, fstats2, gstats;
+
+    char keybuf[256], bodybuf[256];
+
+    // remove previous dummy files
+    r = system(SHELL_DEL" dummy* > errorlog.txt");
+    (void)r;
+
+    fconfig = fdb_get_default_config();
+    // small cache, so that blocks are evicted
+    fconfig.buffercache_size = 64 * fconfig.blocksize;
+    fconfig.wal_threshold = 1024;
+    fconfig.flags = FDB_OPEN_FLAG_CREATE;
+    fconfig.purging_interval = 0;
+    fconfig.compaction_threshold = 0;
+
+    kvs_config = fdb_get_default_kvs_config();
+
+    fdb_open(&dbfile, "./dummy1", &fconfig);
+    fdb_kvs_open_default(dbfile, &db, &kvs_config);
+    fdb_open(&dbfile2, "./dummy2", &fconfig);
+    fdb_kvs_open_default(dbfile2, &db2, &kvs_config);
+
+    status = fdb_get_buffer_cache_stats(NULL, &fstats, NULL);
+    TEST_CHK(status == FDB_RESULT_INVALID_ARGS);
+
+    for (i=0;i<n;++i){
+        sprintf(keybuf, "key%06d", i);
+        sprintf(bodybuf, "body%06d", i);
+        fdb_doc_create(&doc, (void*)keybuf, strlen(keybuf),
+                       NULL, 0, (void*)bodybuf, strlen(bodybuf));
+        fdb_set(db, doc);
+        fdb_doc_free(doc);
+    }
+    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
+
+    // a few blocks in the other file
+    fdb_doc_create(&doc, (void*)"key", 3, NULL, 0, (void*)"body", 4);
+    fdb_set(db2, doc);
+    fdb_doc_free(doc);
+    fdb_commit(dbfile2, FDB_COMMIT_MANUAL_WAL_FLUSH);
+
+    for (r=0;r<2;++r){
+        for (i=0;i<n;++i){
+            sprintf(keybuf, "key%06d", i);
+            fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf),
+                           NULL, 0, NULL, 0);
+            status = fdb_get(db, rdoc);
+            TEST_CHK(status == FDB_RESULT_SUCCESS);
+            fdb_doc_free(rdoc);
+        }
+    }
+
+    status = fdb_get_buffer_cache_stats(dbfile, &fstats, &gstats);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    fdb_get_buffer_cache_stats(dbfile2, &fstats2, NULL);
+
+    TEST_CHK(fstats.num_hits > 0 && fstats.num_misses > 0);
+    TEST_CHK(fstats.num_clean_evictions + fstats.num_dirty_evictions > 0);
+    TEST_CHK(fstats.num_dirty_writebacks > 0);
+    TEST_CHK(fstats.num_cached_blocks > 0);
+    TEST_CHK(fstats.num_index_blocks > 0 && fstats.num_doc_blocks > 0);
+    TEST_CHK(fstats.num_index_blocks + fstats.num_doc_blocks <=
+             fstats.num_cached_blocks);
+    TEST_CHK(fstats.num_dirty_blocks <= fstats.num_cached_blocks);
+    // global-only fields
+    TEST_CHK(fstats.num_total_blocks == 0 && fstats.num_victim_selections == 0);
+
+    // global stats cover both files
+    TEST_CHK(gstats.num_total_blocks == 64);
+    TEST_CHK(gstats.num_cached_blocks + gstats.num_free_blocks ==
+             gstats.num_total_blocks);
+    TEST_CHK(gstats.num_cached_blocks ==
+             fstats.num_cached_blocks + fstats2.num_cached_blocks);
+    TEST_CHK(gstats.num_hits == fstats.num_hits + fstats2.num_hits);
+    TEST_CHK(gstats.num_misses == fstats.num_misses + fstats2.num_misses);
+    TEST_CHK(gstats.num_victim_selections > 0);
+
+    // counters of a closed file remain in the global stats
+    fdb_kvs_close(db2);
+    fdb_close(dbfile2);
+    fdb_get_buffer_cache_stats(dbfile, &fstats, &gstats);
+    TEST_CHK(gstats.num_hits == fstats.num_hits + fstats2.num_hits);
+    TEST_CHK(gstats.num_cached_blocks == fstats.num_cached_blocks);
+
+    fdb_kvs_close(db);
+    status = fdb_close(dbfile);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    status = fdb_shutdown();
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+
+    memleak_end();
+    TEST_RESULT("buffer cache stats test");
+}
+
+/*
+ * Test: io_stats_test
+ *
+ * verifies that reads and writes are accounted by category, that the stats
+ * are carried over by compaction, and that bytes written by compaction are
+ * accounted separately
+ */
+void io_stats_test()
+{
+    TEST_INIT();
+    memleak_start();
+
+    int i, r;
+    int n = 3000;
+    uint64_t user_bytes = 0;
+    fdb_file_handle *dbfile;
+    fdb_kvs_handle *db;
+    fdb_doc *doc, *rdoc;
+    fdb_status status;
+    fdb_config fconfig;
+    fdb_kvs_config kvs_config;
+    fdb_io_stats stats;
+
+    char keybuf[256], bodybuf[256];
+
+    // remove previous dummy files
+    r = system(SHELL_DEL" dummy* > errorlog.txt");
+    (void)r;
+
+    fconfig = fdb_get_default_config();
+    fconfig.buffercache_size = 64 * fconfig.blocksize;
+    fconfig.wal_threshold = 1024;
+    fconfig.flags = FDB_OPEN_FLAG_CREATE;
+    fconfig.purging_interval = 0;
+    fconfig.compaction_threshold = 0;
+
+    kvs_config = fdb_get_default_kvs_config();
+
+    fdb_open(&dbfile, "./dummy1", &fconfig);
+    fdb_kvs_open_default(dbfile, &db, &kvs_config);
+
+    status = fdb_get_io_stats(NULL, &stats);
+    TEST_CHK(status == FDB_RESULT_INVALID_ARGS);
+
+    for (i=0;i<n;++i){
+        sprintf(keybuf, "key%06d", i);
+        sprintf(bodybuf, "body%06d", i);
+        fdb_doc_create(&doc, (void*)keybuf, strlen(keybuf),
+                       NULL, 0, (void*)bodybuf, strlen(bodybuf));
+        fdb_set(db, doc);
+        user_bytes += strlen(keybuf) + strlen(bodybuf);
+        fdb_doc_free(doc);
+    }
+    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
+
+    status = fdb_get_io_stats(dbfile, &stats);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    TEST_CHK(stats.user_bytes == user_bytes);
+    TEST_CHK(stats.write_bytes > user_bytes);
+    TEST_CHK(stats.num_writes > 0 && stats.num_syncs > 0);
+    TEST_CHK(stats.doc_bytes > 0 && stats.index_bytes > 0);
+    TEST_CHK(stats.header_bytes > 0 && stats.kv_header_bytes > 0);
+    TEST_CHK(stats.doc_bytes + stats.index_bytes + stats.header_bytes <=
+             stats.write_bytes);
+    TEST_CHK(stats.compaction_bytes == 0);
 
-    fdb_shutdown();
+    // reads that miss the small cache
+    for (i=0;i<n;++i){
+        sprintf(keybuf, "key%06d", i);
+        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf),
+                       NULL, 0, NULL, 0);
+        status = fdb_get(db, rdoc);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        fdb_doc_free(rdoc);
+    }
+    fdb_get_io_stats(dbfile, &stats);
+    TEST_CHK(stats.num_reads > 0);
+    TEST_CHK(stats.read_bytes == stats.num_reads * fconfig.blocksize);
+
+    fdb_reset_io_stats(dbfile);
+    fdb_get_io_stats(dbfile, &stats);
+    TEST_CHK(stats.num_reads == 0 && stats.write_bytes == 0);
+    TEST_CHK(stats.user_bytes == 0);
+
+    // write amplification caused by compaction is accounted separately,
+    // and the stats are carried over to the new file
+    fdb_doc_create(&doc, (void*)"key", 3, NULL, 0, (void*)"body", 4);
+    fdb_set(db, doc);
+    fdb_doc_free(doc);
+    fdb_commit(dbfile, FDB_COMMIT_NORMAL);
+    status = fdb_compact(dbfile, "./dummy2");
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    fdb_get_io_stats(dbfile, &stats);
+    TEST_CHK(stats.user_bytes == 7);
+    TEST_CHK(stats.compaction_bytes > user_bytes);
+    TEST_CHK(stats.doc_bytes + stats.index_bytes + stats.header_bytes +
+             stats.compaction_bytes <= stats.write_bytes);
+
+    fdb_kvs_close(db);
+    status = fdb_close(dbfile);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    status = fdb_shutdown();
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
 
     memleak_end();
+    TEST_RESULT("I/O stats test");
+}
 
-    if (opt & MULTI_KV_VAR_CMP) {
-        TEST_RESULT("multiple KV instances rollback test "
-                    "(custom key order)");
-    } else {
-        TEST_RESULT("multiple KV instances rollback test");
-    }
+static int trace_nbegins[FDB_TRACE_NUM_EVENTS];
+static int trace_nends[FDB_TRACE_NUM_EVENTS];
+
+static void _trace_begin(fdb_trace_event event, void *ctx)
+{
+    (void)ctx;
+    trace_nbegins[event]++;
 }
 
-void multi_kv_custom_cmp_test()
+static void _trace_end(fdb_trace_event event, void *ctx)
+{
+    (void)ctx;
+    trace_nends[event]++;
+}
+
+/*
+ * Test: trace_test
+ *
+ * verifies that the trace callbacks are invoked in pairs at internal phase
+ * boundaries, if tracing is compiled in
+ */
+void trace_test()
 {
     TEST_INIT();
+    memleak_start();
 
-    int n = 1000;
     int i, r;
-    char key[256], value[256];
-    char keystr[] = "key%06d";
-    char valuestr[] = "value%08d(%s)";
+    int n = 3000;
     fdb_file_handle *dbfile;
-    fdb_kvs_handle *db, *kv1, *kv2;
-    fdb_config config;
+    fdb_kvs_handle *db;
+    fdb_doc *doc, *rdoc;
+    fdb_status status;
+    fdb_config fconfig;
     fdb_kvs_config kvs_config;
-    fdb_doc *doc;
-    fdb_iterator *it;
-    fdb_status s;
 
-    sprintf(value, SHELL_DEL" dummy*");
-    r = system(value);
+    char keybuf[256], bodybuf[256];
+
+    TEST_CHK(!strcmp(fdb_trace_event_name(FDB_TRACE_COMMIT), "commit"));
+    TEST_CHK(fdb_trace_event_name(FDB_TRACE_NUM_EVENTS) == NULL);
+
+    status = fdb_set_trace_callbacks(_trace_begin, _trace_end, NULL);
+    if (status == FDB_RESULT_INVALID_CONFIG) {
+        // trace points are compiled out
+        memleak_end();
+        TEST_RESULT("trace test (disabled)");
+        return;
+    }
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+
+    // remove previous dummy files
+    r = system(SHELL_DEL" dummy* > errorlog.txt");
     (void)r;
 
-    memleak_start();
+    fconfig = fdb_get_default_config();
+    fconfig.buffercache_size = 64 * fconfig.blocksize;
+    fconfig.wal_threshold = 1024;
+    fconfig.flags = FDB_OPEN_FLAG_CREATE;
+    fconfig.purging_interval = 0;
+    fconfig.compaction_threshold = 0;
 
-    config = fdb_get_default_config();
     kvs_config = fdb_get_default_kvs_config();
-    config.multi_kv_instances = true;
-    config.wal_threshold = 256;
-    config.wal_flush_before_commit = false;
-    config.buffercache_size = 0;
 
-    s = fdb_open(&dbfile, "./dummy", &config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_kvs_open(dbfile, &db, NULL, &kvs_config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    fdb_open(&dbfile, "./dummy1", &fconfig);
+    fdb_kvs_open_default(dbfile, &db, &kvs_config);
 
-    // insert using 'default' instance
-    for (i=0;i<n;++i) {
-        sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "default");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
-        s = fdb_set(db, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
+    for (i=0;i<n;++i){
+        sprintf(keybuf, "key%06d", i);
+        sprintf(bodybuf, "body%06d", i);
+        fdb_doc_create(&doc, (void*)keybuf, strlen(keybuf),
+                       NULL, 0, (void*)bodybuf, strlen(bodybuf));
+        fdb_set(db, doc);
         fdb_doc_free(doc);
     }
-    s = fdb_commit(dbfile, FDB_COMMIT_NORMAL);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-
-    // create 'kv1' using custom cmp function
-    kvs_config.custom_cmp = _multi_kv_test_keycmp;
-    s = fdb_kvs_open(dbfile, &kv1, "kv1", &kvs_config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-
-    // insert using 'kv1' instance
-    for (i=0;i<n;++i) {
-        sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "kv1_custom_cmp");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
-        s = fdb_set(kv1, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        fdb_doc_free(doc);
+    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
+    for (i=0;i<n;++i){
+        sprintf(keybuf, "key%06d", i);
+        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf),
+                       NULL, 0, NULL, 0);
+        status = fdb_get(db, rdoc);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        fdb_doc_free(rdoc);
     }
-    s = fdb_commit(dbfile, FDB_COMMIT_NORMAL);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    status = fdb_compact(dbfile, "./dummy2");
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-    // retrieve check
-    for (i=0;i<n;++i) {
-        sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "default");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(db, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
-        fdb_doc_free(doc);
+    fdb_kvs_close(db);
+    fdb_close(dbfile);
+    fdb_set_trace_callbacks(NULL, NULL, NULL);
 
-        sprintf(value, valuestr, i, "kv1_custom_cmp");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(kv1, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
-        fdb_doc_free(doc);
+    for (i=0;i<FDB_TRACE_NUM_EVENTS;++i){
+        TEST_CHK(trace_nbegins[i] == trace_nends[i]);
+        TEST_CHK(trace_nbegins[i] > 0);
     }
 
-    // close & reopen handles
-    s = fdb_close(dbfile);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    kvs_config.custom_cmp = NULL;
-    s = fdb_open(&dbfile, "./dummy", &config);
-    TEST_CHK(s != FDB_RESULT_SUCCESS); // must fail
+    status = fdb_shutdown();
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-    { // retry with wrong cmp function
-        char *kvs_names[] = {NULL};
-        fdb_custom_cmp_variable functions[] = {_multi_kv_test_keycmp};
-        s = fdb_open_custom_cmp(&dbfile, "./dummy", &config,
-                                1, kvs_names, functions);
-        TEST_CHK(s != FDB_RESULT_SUCCESS); // must fail
-    }
+    memleak_end();
+    TEST_RESULT("trace test");
+}
 
-    { // retry with correct function
-        char *kvs_names[] = {(char*)"kv1"};
-        fdb_custom_cmp_variable functions[] = {_multi_kv_test_keycmp};
-        s = fdb_open_custom_cmp(&dbfile, "./dummy", &config,
-                                1, kvs_names, functions);
-        TEST_CHK(s == FDB_RESULT_SUCCESS); // must succeed this time
+static int slow_op_nentries;
+static char slow_op_last_msg[1024];
+
+static void _slow_op_log_cb(int err_code, const char *err_msg, void *ctx)
+{
+    if (err_code == FDB_RESULT_SUCCESS && !strncmp(err_msg, "slow op=", 8)) {
+        slow_op_nentries++;
+        strncpy(slow_op_last_msg, err_msg, sizeof(slow_op_last_msg) - 1);
     }
+}
 
-    s = fdb_kvs_open(dbfile, &db, NULL, &kvs_config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_kvs_open(dbfile, &kv1, "kv1", &kvs_config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
+void slow_op_test()
+{
+    TEST_INIT();
+    memleak_start();
 
-    // retrieve check
-    for (i=0;i<n;++i) {
-        sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "default");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(db, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
-        fdb_doc_free(doc);
+    int i, r, pass;
+    int n = 20000;
+    fdb_file_handle *dbfile;
+    fdb_kvs_handle *db;
+    fdb_iterator *it;
+    fdb_doc *doc, *rdoc;
+    fdb_status status;
+    fdb_config fconfig;
+    fdb_kvs_config kvs_config;
 
-        sprintf(value, valuestr, i, "kv1_custom_cmp");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(kv1, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
-        fdb_doc_free(doc);
-    }
+    char keybuf[256], bodybuf[256];
 
-    // create one more KV store
-    kvs_config.custom_cmp = NULL;
-    s = fdb_kvs_open(dbfile, &kv2, "kv2", &kvs_config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    // remove previous dummy files
+    r = system(SHELL_DEL" dummy* > errorlog.txt");
+    (void)r;
 
-    // insert using 'kv2' instance
-    for (i=0;i<n;++i) {
-        sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "kv2");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
-        s = fdb_set(kv2, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        fdb_doc_free(doc);
-    }
-    s = fdb_commit(dbfile, FDB_COMMIT_NORMAL);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    fconfig = fdb_get_default_config();
+    fconfig.wal_threshold = n;
+    fconfig.flags = FDB_OPEN_FLAG_CREATE;
+    fconfig.purging_interval = 0;
+    fconfig.compaction_threshold = 0;
+    kvs_config = fdb_get_default_kvs_config();
 
-    // retrieve check
-    for (i=0;i<n;++i) {
-        sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "default");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(db, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
-        fdb_doc_free(doc);
+    // pass 0: disabled, pass 1: 1ms threshold
+    for (pass=0; pass<2; ++pass) {
+        fconfig.slow_op_threshold = pass;
+        slow_op_nentries = 0;
 
-        sprintf(value, valuestr, i, "kv1_custom_cmp");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(kv1, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
-        fdb_doc_free(doc);
+        sprintf(keybuf, "./dummy%d", pass + 1);
+        fdb_open(&dbfile, keybuf, &fconfig);
+        fdb_kvs_open_default(dbfile, &db, &kvs_config);
+        status = fdb_set_log_callback(db, _slow_op_log_cb, NULL);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-        sprintf(value, valuestr, i, "kv2");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(kv2, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
-        fdb_doc_free(doc);
-    }
+        for (i=0;i<n;++i){
+            sprintf(keybuf, "key%06d", i);
+            sprintf(bodybuf, "body%06d", i);
+            fdb_doc_create(&doc, (void*)keybuf, strlen(keybuf),
+                           NULL, 0, (void*)bodybuf, strlen(bodybuf));
+            fdb_set(db, doc);
+            fdb_doc_free(doc);
+        }
+        // flushing the whole WAL into the main index takes more than 1ms
+        status = fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-    // update all documents
-    for (i=0;i<n;++i) {
-        sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "default(updated)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
-        s = fdb_set(db, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        fdb_doc_free(doc);
+        for (i=0;i<n;i+=100){
+            sprintf(keybuf, "key%06d", i);
+            fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf),
+                           NULL, 0, NULL, 0);
+            status = fdb_get(db, rdoc);
+            TEST_CHK(status == FDB_RESULT_SUCCESS);
+            fdb_doc_free(rdoc);
+        }
+        status = fdb_iterator_init(db, &it, NULL, 0, NULL, 0,
+                                   FDB_ITR_NONE);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        i = 0;
+        while (fdb_iterator_next(it, &rdoc) == FDB_RESULT_SUCCESS) {
+            fdb_doc_free(rdoc);
+            i++;
+        }
+        TEST_CHK(i == n);
+        fdb_iterator_close(it);
 
-        sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "kv1_custom_cmp(updated)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
-        s = fdb_set(kv1, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        fdb_doc_free(doc);
+        if (pass == 0) {
+            TEST_CHK(slow_op_nentries == 0);
+        } else {
+            TEST_CHK(slow_op_nentries > 0);
+            TEST_CHK(strstr(slow_op_last_msg, " total_us="));
+            TEST_CHK(strstr(slow_op_last_msg, " wal_lookup_us="));
+            TEST_CHK(strstr(slow_op_last_msg, " hbtrie_us="));
+            TEST_CHK(strstr(slow_op_last_msg, " cache_miss_count="));
+            TEST_CHK(strstr(slow_op_last_msg, " docio_read_us="));
+            TEST_CHK(strstr(slow_op_last_msg, " lock_wait_us="));
+            TEST_CHK(strstr(slow_op_last_msg, " wal_flush_us="));
+            TEST_CHK(strstr(slow_op_last_msg, " fsync_us="));
+        }
 
-        sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "kv2(updated)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
-        s = fdb_set(kv2, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        fdb_doc_free(doc);
+        fdb_kvs_close(db);
+        fdb_close(dbfile);
     }
-    // WAL flush at once
-    s = fdb_commit(dbfile, FDB_COMMIT_NORMAL);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
 
-    // retrieve check
-    for (i=0;i<n;++i) {
-        sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "default(updated)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(db, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
-        fdb_doc_free(doc);
+    status = fdb_shutdown();
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-        sprintf(value, valuestr, i, "kv1_custom_cmp(updated)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(kv1, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
-        fdb_doc_free(doc);
+    memleak_end();
+    TEST_RESULT("slow operation log test");
+}
 
-        sprintf(value, valuestr, i, "kv2(updated)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(kv2, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
-        fdb_doc_free(doc);
+void lock_stats_test()
+{
+    TEST_INIT();
+    memleak_start();
+
+    int i, r;
+    int n = 3000;
+    fdb_file_handle *dbfile;
+    fdb_kvs_handle *db;
+    fdb_doc *doc, *rdoc;
+    fdb_status status;
+    fdb_config fconfig;
+    fdb_kvs_config kvs_config;
+    fdb_lock_stats stats;
+
+    char keybuf[256], bodybuf[256];
+
+    TEST_CHK(!strcmp(fdb_lock_site_name(FDB_LOCK_WAL), "wal"));
+    TEST_CHK(fdb_lock_site_name(FDB_LOCK_NUM_SITES) == NULL);
+
+    status = fdb_reset_lock_stats();
+    if (status == FDB_RESULT_INVALID_CONFIG) {
+        // locks are not profiled
+        TEST_CHK(fdb_get_lock_stats(&stats) == FDB_RESULT_INVALID_CONFIG);
+        memleak_end();
+        TEST_RESULT("lock stats test (disabled)");
+        return;
     }
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    TEST_CHK(fdb_get_lock_stats(NULL) == FDB_RESULT_INVALID_ARGS);
 
-    // do compaction
-    s = fdb_compact(dbfile, "./dummy2");
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    // remove previous dummy files
+    r = system(SHELL_DEL" dummy* > errorlog.txt");
+    (void)r;
 
-    // retrieve check
-    for (i=0;i<n;++i) {
-        sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "default(updated)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(db, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
-        fdb_doc_free(doc);
+    fconfig = fdb_get_default_config();
+    fconfig.buffercache_size = 64 * fconfig.blocksize;
+    fconfig.wal_threshold = 1024;
+    fconfig.flags = FDB_OPEN_FLAG_CREATE;
+    fconfig.purging_interval = 0;
+    fconfig.compaction_threshold = 0;
 
-        sprintf(value, valuestr, i, "kv1_custom_cmp(updated)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(kv1, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
-        fdb_doc_free(doc);
+    kvs_config = fdb_get_default_kvs_config();
 
-        sprintf(value, valuestr, i, "kv2(updated)");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(kv2, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
+    fdb_open(&dbfile, "./dummy1", &fconfig);
+    fdb_kvs_open_default(dbfile, &db, &kvs_config);
+
+    for (i=0;i<n;++i){
+        sprintf(keybuf, "key%06d", i);
+        sprintf(bodybuf, "body%06d", i);
+        fdb_doc_create(&doc, (void*)keybuf, strlen(keybuf),
+                       NULL, 0, (void*)bodybuf, strlen(bodybuf));
+        fdb_set(db, doc);
         fdb_doc_free(doc);
     }
+    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
+    for (i=0;i<n;++i){
+        sprintf(keybuf, "key%06d", i);
+        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf),
+                       NULL, 0, NULL, 0);
+        status = fdb_get(db, rdoc);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        fdb_doc_free(rdoc);
+    }
 
-    // create full iterator for 'kv1'
-    i = 0;
-    s = fdb_iterator_init(kv1, &it, NULL, 0, NULL, 0, FDB_ITR_NONE);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    while (fdb_iterator_next(it, &doc) == FDB_RESULT_SUCCESS) {
-        sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "kv1_custom_cmp(updated)");
-        TEST_CHK(!memcmp(doc->key, key, doc->keylen));
-        TEST_CHK(!memcmp(doc->body, value, doc->bodylen));
-        fdb_doc_free(doc);
-        i++;
+    status = fdb_get_lock_stats(&stats);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    TEST_CHK(stats.sites[FDB_LOCK_BCACHE].acquisitions > 0);
+    TEST_CHK(stats.sites[FDB_LOCK_BCACHE_FILE].acquisitions > 0);
+    TEST_CHK(stats.sites[FDB_LOCK_FILEMGR_MUTEX].acquisitions > 0);
+    TEST_CHK(stats.sites[FDB_LOCK_WAL].acquisitions > 0);
+    for (i=0;i<FDB_LOCK_NUM_SITES;++i){
+        if (i != FDB_LOCK_PLOCK) {
+            // plock_lock may wait for more than one overlapping range
+            TEST_CHK(stats.sites[i].contended <= stats.sites[i].acquisitions);
+        }
     }
-    TEST_CHK(i == n);
-    s = fdb_iterator_close(it);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
 
-    s = fdb_close(dbfile);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_shutdown();
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    memleak_end();
+    fdb_kvs_close(db);
+    fdb_close(dbfile);
 
-    TEST_RESULT("multiple KV instances custom comparison function test");
+    status = fdb_shutdown();
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+
+    fdb_reset_lock_stats();
+    fdb_get_lock_stats(&stats);
+    for (i=0;i<FDB_LOCK_NUM_SITES;++i){
+        TEST_CHK(stats.sites[i].acquisitions == 0);
+        TEST_CHK(stats.sites[i].contended == 0);
+        TEST_CHK(stats.sites[i].wait_time == 0);
+    }
+
+    memleak_end();
+    TEST_RESULT("lock stats test");
 }
 
-void multi_kv_fdb_open_custom_cmp_test()
+void cache_warmup_test()
 {
-    // Unit test for MB-12593
     TEST_INIT();
+    memleak_start();
 
-    int n = 1000;
     int i, r;
-    char key[256], value[256];
-    char keystr[] = "key%06d";
-    char valuestr[] = "value%08d(%s)";
+    int n = 3000;
+    uint64_t nblocks;
+    FILE *fp;
     fdb_file_handle *dbfile;
-    fdb_kvs_handle *db, *kv1, *kv2;
-    fdb_config config;
+    fdb_kvs_handle *db;
+    fdb_doc *doc, *rdoc;
+    fdb_status status;
+    fdb_config fconfig;
     fdb_kvs_config kvs_config;
-    fdb_doc *doc;
-    fdb_status s;
+    fdb_buffer_cache_stats fstats;
 
-    char *kvs_names[] = {(char*)"default", (char*)"kv1", (char*)"kv2"};
-    fdb_custom_cmp_variable functions[] = {_multi_kv_test_keycmp,
-                                           _multi_kv_test_keycmp,
-                                           NULL};
+    char keybuf[256], bodybuf[256];
 
-    sprintf(value, SHELL_DEL" dummy*");
-    r = system(value);
+    // remove previous dummy files
+    r = system(SHELL_DEL" dummy* > errorlog.txt");
     (void)r;
 
-    memleak_start();
+    fconfig = fdb_get_default_config();
+    fconfig.buffercache_size = 16 * 1024 * 1024;
+    fconfig.wal_threshold = 1024;
+    fconfig.flags = FDB_OPEN_FLAG_CREATE;
+    fconfig.purging_interval = 0;
+    fconfig.compaction_threshold = 0;
+    fconfig.prefetch_duration = 0;
+    fconfig.cache_warmup = true;
 
-    config = fdb_get_default_config();
     kvs_config = fdb_get_default_kvs_config();
-    config.multi_kv_instances = true;
-    config.wal_threshold = 256;
-    config.wal_flush_before_commit = false;
-    config.buffercache_size = 0;
-
-    s = fdb_open_custom_cmp(&dbfile, "./dummy", &config,
-                            3, kvs_names, functions);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_kvs_open(dbfile, &db, NULL, &kvs_config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_kvs_open(dbfile, &kv1, "kv1", &kvs_config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
 
-    kvs_config.custom_cmp = _multi_kv_test_keycmp;
-    s = fdb_kvs_open(dbfile, &kv2, "kv2", &kvs_config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-
-    // insert using 'default' instance
-    for (i=0;i<n;++i) {
-        sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "default");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
-        s = fdb_set(db, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
+    fdb_open(&dbfile, "./dummy1", &fconfig);
+    fdb_kvs_open_default(dbfile, &db, &kvs_config);
+    for (i=0;i<n;++i){
+        sprintf(keybuf, "key%06d", i);
+        sprintf(bodybuf, "body%06d", i);
+        fdb_doc_create(&doc, (void*)keybuf, strlen(keybuf),
+                       NULL, 0, (void*)bodybuf, strlen(bodybuf));
+        fdb_set(db, doc);
         fdb_doc_free(doc);
     }
+    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
+    status = fdb_get_buffer_cache_stats(dbfile, &fstats, NULL);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    nblocks = fstats.num_cached_blocks;
+    TEST_CHK(nblocks > 0);
+    fdb_kvs_close(db);
+    fdb_close(dbfile);
 
-    // insert using 'kv1' instance
-    for (i=0;i<n;++i) {
-        sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "kv1_custom_cmp");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
-        s = fdb_set(kv1, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        fdb_doc_free(doc);
-    }
+    // the warm-up list is saved when the file is closed
+    fp = fopen("./dummy1.warmup", "rb");
+    TEST_CHK(fp != NULL);
+    fclose(fp);
+    fdb_shutdown();
 
-    // insert using 'kv2' instance
-    for (i=0;i<n;++i) {
-        sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "kv2");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
-        s = fdb_set(kv2, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        fdb_doc_free(doc);
+    // the list is loaded in the background, and consumed on open
+    fdb_open(&dbfile, "./dummy1", &fconfig);
+    fdb_kvs_open_default(dbfile, &db, &kvs_config);
+    fp = fopen("./dummy1.warmup", "rb");
+    TEST_CHK(fp == NULL);
+    for (i=0;i<10;++i){
+        fdb_get_buffer_cache_stats(dbfile, &fstats, NULL);
+        if (fstats.num_cached_blocks >= nblocks) {
+            break;
+        }
+        sleep(1);
     }
-    s = fdb_commit(dbfile, FDB_COMMIT_NORMAL);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_close(dbfile);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-
-    s = fdb_open(&dbfile, "./dummy", &config);
-    TEST_CHK(s != FDB_RESULT_SUCCESS); // must fail
-
-    s = fdb_open_custom_cmp(&dbfile, "./dummy", &config,
-                            3, kvs_names, functions);
-    TEST_CHK(s != FDB_RESULT_SUCCESS); // must fail
+    TEST_CHK(fstats.num_cached_blocks >= nblocks);
+    TEST_CHK(fstats.num_index_blocks > 0);
 
-    functions[2] = _multi_kv_test_keycmp;
-    s = fdb_open_custom_cmp(&dbfile, "./dummy", &config,
-                            3, kvs_names, functions);
-    TEST_CHK(s == FDB_RESULT_SUCCESS); // must succeed
-    s = fdb_kvs_open(dbfile, &db, NULL, &kvs_config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_kvs_open(dbfile, &kv1, "kv1", &kvs_config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_kvs_open(dbfile, &kv2, "kv2", &kvs_config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    // all documents are served from the warmed-up cache
+    fdb_get_buffer_cache_stats(dbfile, &fstats, NULL);
+    nblocks = fstats.num_misses;
+    for (i=0;i<n;++i){
+        sprintf(keybuf, "key%06d", i);
+        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf),
+                       NULL, 0, NULL, 0);
+        status = fdb_get(db, rdoc);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        fdb_doc_free(rdoc);
+    }
+    fdb_get_buffer_cache_stats(dbfile, &fstats, NULL);
+    TEST_CHK(fstats.num_misses == nblocks);
 
-    // retrieve check
-    for (i=0;i<n;++i) {
-        sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "default");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(db, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
-        fdb_doc_free(doc);
+    fdb_kvs_close(db);
+    fdb_close(dbfile);
 
-        sprintf(value, valuestr, i, "kv1_custom_cmp");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(kv1, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
-        fdb_doc_free(doc);
+    // the list is removed along with the file
+    fdb_destroy("./dummy1", &fconfig);
+    fp = fopen("./dummy1.warmup", "rb");
+    TEST_CHK(fp == NULL);
 
-        sprintf(value, valuestr, i, "kv2");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(kv2, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
-        fdb_doc_free(doc);
-    }
+    status = fdb_shutdown();
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-    s = fdb_close(dbfile);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_shutdown();
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
     memleak_end();
-
-    TEST_RESULT("multiple KV instances fdb_open_custom_cmp test");
+    TEST_RESULT("buffer cache warm-up test");
 }
 
-void multi_kv_use_existing_mode_test()
+void index_prefetch_test()
 {
     TEST_INIT();
+    memleak_start();
 
-    int n = 1000;
     int i, r;
-    char key[256], value[256];
-    char keystr[] = "key%06d";
-    char valuestr[] = "value%08d(%s)";
+    int n = 3000;
+    uint64_t nindex;
     fdb_file_handle *dbfile;
     fdb_kvs_handle *db;
-    fdb_config config;
+    fdb_doc *doc, *rdoc;
+    fdb_status status;
+    fdb_config fconfig;
     fdb_kvs_config kvs_config;
-    fdb_doc *doc;
-    fdb_status s;
+    fdb_buffer_cache_stats fstats;
 
-    sprintf(value, SHELL_DEL" dummy*");
-    r = system(value);
+    char keybuf[256], bodybuf[256];
+
+    // remove previous dummy files
+    r = system(SHELL_DEL" dummy* > errorlog.txt");
     (void)r;
 
-    memleak_start();
+    fconfig = fdb_get_default_config();
+    fconfig.buffercache_size = 16 * 1024 * 1024;
+    fconfig.wal_threshold = 1024;
+    fconfig.flags = FDB_OPEN_FLAG_CREATE;
+    fconfig.purging_interval = 0;
+    fconfig.compaction_threshold = 0;
+    fconfig.prefetch_duration = 0;
 
-    config = fdb_get_default_config();
     kvs_config = fdb_get_default_kvs_config();
-    config.wal_threshold = 256;
-    config.buffercache_size = 0;
-
-    // create DB file under multi KV instance mode
-    config.multi_kv_instances = true;
-    s = fdb_open(&dbfile, "./dummy_multi", &config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_kvs_open(dbfile, &db, NULL, &kvs_config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
 
-    // insert using 'default' instance
-    for (i=0;i<n;++i) {
-        sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "default");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
-        s = fdb_set(db, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
+    fdb_open(&dbfile, "./dummy1", &fconfig);
+    fdb_kvs_open_default(dbfile, &db, &kvs_config);
+    for (i=0;i<n;++i){
+        sprintf(keybuf, "key%06d", i);
+        sprintf(bodybuf, "body%06d", i);
+        fdb_doc_create(&doc, (void*)keybuf, strlen(keybuf),
+                       NULL, 0, (void*)bodybuf, strlen(bodybuf));
+        fdb_set(db, doc);
         fdb_doc_free(doc);
     }
+    fdb_commit(dbfile, FDB_COMMIT_MANUAL_WAL_FLUSH);
+    fdb_kvs_close(db);
+    fdb_close(dbfile);
+    fdb_shutdown();
 
-    s = fdb_commit(dbfile, FDB_COMMIT_NORMAL);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_close(dbfile);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-
-    // open under single KV instance mode
-    config.multi_kv_instances = false;
-    s = fdb_open(&dbfile, "./dummy_multi", &config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS); // must succeed
-    s = fdb_kvs_open(dbfile, &db, NULL, &kvs_config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-
-    // retrieve check
-    for (i=0;i<n;++i) {
-        sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "default");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(db, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
-        fdb_doc_free(doc);
+    // count the index blocks read by retrieving all documents
+    fdb_open(&dbfile, "./dummy1", &fconfig);
+    fdb_kvs_open_default(dbfile, &db, &kvs_config);
+    for (i=0;i<n;++i){
+        sprintf(keybuf, "key%06d", i);
+        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf),
+                       NULL, 0, NULL, 0);
+        status = fdb_get(db, rdoc);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        fdb_doc_free(rdoc);
     }
+    status = fdb_get_buffer_cache_stats(dbfile, &fstats, NULL);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    nindex = fstats.num_index_blocks;
+    TEST_CHK(nindex > 0);
+    fdb_kvs_close(db);
+    fdb_close(dbfile);
+    fdb_shutdown();
 
-    s = fdb_close(dbfile);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-
-    // create DB file under single KV instance mode
-    config.multi_kv_instances = false;
-    s = fdb_open(&dbfile, "./dummy_single", &config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_kvs_open(dbfile, &db, NULL, &kvs_config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-
-    // insert using 'default' instance
-    for (i=0;i<n;++i) {
-        sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "default");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, value, strlen(value)+1);
-        s = fdb_set(db, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        fdb_doc_free(doc);
+    // all index blocks are loaded in the background without any retrieval
+    fconfig.prefetch_mode = FDB_PREFETCH_INDEX;
+    fdb_open(&dbfile, "./dummy1", &fconfig);
+    fdb_kvs_open_default(dbfile, &db, &kvs_config);
+    for (i=0;i<10;++i){
+        fdb_get_buffer_cache_stats(dbfile, &fstats, NULL);
+        if (fstats.num_index_blocks >= nindex) {
+            break;
+        }
+        sleep(1);
     }
+    TEST_CHK(fstats.num_index_blocks >= nindex);
+    fdb_kvs_close(db);
+    fdb_close(dbfile);
+    fdb_shutdown();
 
-    s = fdb_commit(dbfile, FDB_COMMIT_NORMAL);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-    s = fdb_close(dbfile);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-
-    // open under multi KV instance mode
-    config.multi_kv_instances = true;
-    s = fdb_open(&dbfile, "./dummy_single", &config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS); // must succeed
-    s = fdb_kvs_open(dbfile, &db, NULL, &kvs_config);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
-
-    // retrieve check
-    for (i=0;i<n;++i) {
-        sprintf(key, keystr, i);
-        sprintf(value, valuestr, i, "default");
-        fdb_doc_create(&doc, key, strlen(key)+1, NULL, 0, NULL, 0);
-        s = fdb_get(db, doc);
-        TEST_CHK(s == FDB_RESULT_SUCCESS);
-        TEST_CHK(!memcmp(value, doc->body, doc->bodylen));
-        fdb_doc_free(doc);
-    }
+    // invalid prefetch options
+    fconfig.prefetch_cache_ratio = 101;
+    status = fdb_open(&dbfile, "./dummy1", &fconfig);
+    TEST_CHK(status == FDB_RESULT_INVALID_CONFIG);
 
-    s = fdb_close(dbfile);
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
+    status = fdb_shutdown();
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
 
-    s = fdb_shutdown();
-    TEST_CHK(s == FDB_RESULT_SUCCESS);
     memleak_end();
-
-    TEST_RESULT("multiple KV instances use existing mode test");
+    TEST_RESULT("index-first prefetch test");
 }
 
-void multi_kv_close_test()
+void mmap_read_test()
 {
     TEST_INIT();
     memleak_start();
 
     int i, r;
-    int n = 10;
-    fdb_file_handle *dbfile1;
-    fdb_kvs_handle *db1, *db2, *db3, *db4, *db5;
-    fdb_doc **doc = alca(fdb_doc*, n);
-    fdb_doc *rdoc;
+    int n = 1000;
+    fdb_file_handle *dbfile, *dbfile_w;
+    fdb_kvs_handle *db, *db_w;
+    fdb_doc *doc, *rdoc;
     fdb_status status;
-    fdb_config fconfig;
+    fdb_config fconfig, fconfig_r;
     fdb_kvs_config kvs_config;
+    fdb_buffer_cache_stats fstats;
+    fdb_io_stats iostats;
 
-    char keybuf[256], metabuf[256], bodybuf[256];
+    char keybuf[256], bodybuf[256];
 
     // remove previous dummy files
     r = system(SHELL_DEL" dummy* > errorlog.txt");
     (void)r;
 
     fconfig = fdb_get_default_config();
-    fconfig.buffercache_size = 0;
-    fconfig.wal_threshold = 8;
+    fconfig.buffercache_size = 16 * 1024 * 1024;
+    fconfig.wal_threshold = 1024;
     fconfig.flags = FDB_OPEN_FLAG_CREATE;
     fconfig.purging_interval = 0;
     fconfig.compaction_threshold = 0;
-    fconfig.wal_flush_before_commit = true;
+    fconfig_r = fconfig;
+    fconfig_r.flags = FDB_OPEN_FLAG_RDONLY;
+    fconfig_r.mmap_readonly = true;
 
     kvs_config = fdb_get_default_kvs_config();
 
-    // open db
-    fdb_open(&dbfile1, "dummy1", &fconfig);
-    fdb_kvs_open(dbfile1, &db1, "db1", &kvs_config);
-    fdb_kvs_open(dbfile1, &db2, "db2", &kvs_config);
-    fdb_kvs_open(dbfile1, &db3, "db3", &kvs_config);
-    fdb_kvs_open(dbfile1, &db4, "db4", &kvs_config);
-    fdb_kvs_open(dbfile1, &db5, "db5", &kvs_config);
-
-    // insert documents
+    fdb_open(&dbfile_w, "./dummy1", &fconfig);
+    fdb_kvs_open_default(dbfile_w, &db_w, &kvs_config);
     for (i=0;i<n;++i){
-        sprintf(keybuf, "key%d", i);
-        sprintf(metabuf, "meta%d", i);
-        sprintf(bodybuf, "body%d", i);
-        fdb_doc_create(&doc[i], (void*)keybuf, strlen(keybuf),
-            (void*)metabuf, strlen(metabuf), (void*)bodybuf, strlen(bodybuf));
-        fdb_set(db1, doc[i]);
-        fdb_set(db2, doc[i]);
-        fdb_set(db3, doc[i]);
-        fdb_set(db4, doc[i]);
-        fdb_set(db5, doc[i]);
+        sprintf(keybuf, "key%06d", i);
+        sprintf(bodybuf, "body%06d", i);
+        fdb_doc_create(&doc, (void*)keybuf, strlen(keybuf),
+                       NULL, 0, (void*)bodybuf, strlen(bodybuf));
+        fdb_set(db_w, doc);
+        fdb_doc_free(doc);
     }
-    // close db3,4
-    fdb_kvs_close(db3);
-    fdb_kvs_close(db4);
-
+    fdb_commit(dbfile_w, FDB_COMMIT_MANUAL_WAL_FLUSH);
+    fdb_kvs_close(db_w);
+    fdb_close(dbfile_w);
+    fdb_shutdown();
 
-    // insert documents
+    // committed blocks are read from the mapping without any read call
+    // or buffer cache block
+    status = fdb_open(&dbfile, "./dummy1", &fconfig_r);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    fdb_kvs_open_default(dbfile, &db, &kvs_config);
+    fdb_reset_io_stats(dbfile);
     for (i=0;i<n;++i){
-        fdb_set(db1, doc[i]);
-        fdb_set(db2, doc[i]);
-        fdb_set(db5, doc[i]);
+        sprintf(keybuf, "key%06d", i);
+        sprintf(bodybuf, "body%06d", i);
+        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf),
+                       NULL, 0, NULL, 0);
+        status = fdb_get(db, rdoc);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(rdoc->body, bodybuf, rdoc->bodylen));
+        fdb_doc_free(rdoc);
     }
+    fdb_get_io_stats(dbfile, &iostats);
+    TEST_CHK(iostats.num_reads == 0);
+    fdb_get_buffer_cache_stats(dbfile, &fstats, NULL);
+    TEST_CHK(fstats.num_cached_blocks == 0);
+
+    // a writer sharing the file grows it beyond the mapping
+    fdb_open(&dbfile_w, "./dummy1", &fconfig);
+    fdb_kvs_open_default(dbfile_w, &db_w, &kvs_config);
+    for (i=n;i<n*4;++i){
+        sprintf(keybuf, "key%06d", i);
+        sprintf(bodybuf, "body%06d", i);
+        fdb_doc_create(&doc, (void*)keybuf, strlen(keybuf),
+                       NULL, 0, (void*)bodybuf, strlen(bodybuf));
+        fdb_set(db_w, doc);
+        fdb_doc_free(doc);
+    }
+    fdb_commit(dbfile_w, FDB_COMMIT_MANUAL_WAL_FLUSH);
+    for (i=0;i<n*4;++i){
+        sprintf(keybuf, "key%06d", i);
+        sprintf(bodybuf, "body%06d", i);
+        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf),
+                       NULL, 0, NULL, 0);
+        status = fdb_get(db_w, rdoc);
+        TEST_CHK(status == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(rdoc->body, bodybuf, rdoc->bodylen));
+        fdb_doc_free(rdoc);
+    }
+    // the writer reads through the buffer cache
+    fdb_get_buffer_cache_stats(dbfile_w, &fstats, NULL);
+    TEST_CHK(fstats.num_cached_blocks > 0);
 
-    // remove db1
-    fdb_kvs_close(db1);
-    status = fdb_kvs_remove(dbfile1,"db1");
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
-
-    // commit
-    status = fdb_commit(dbfile1, FDB_COMMIT_NORMAL);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
-
-    // remove db5
-    fdb_kvs_close(db5);
-    status = fdb_kvs_remove(dbfile1, "db5");
+    // the reader switches to the mapping of the compacted file
+    status = fdb_compact(dbfile_w, "./dummy2");
     TEST_CHK(status == FDB_RESULT_SUCCESS);
-
-    // attempt to read from remaining open kvs
-    for (i=0; i<n; i++){
-        fdb_doc_create(&rdoc, doc[i]->key, doc[i]->keylen, NULL, 0, NULL, 0);
-        status = fdb_get(db2, rdoc);
+    fdb_kvs_close(db_w);
+    fdb_close(dbfile_w);
+    for (i=0;i<n*4;++i){
+        sprintf(keybuf, "key%06d", i);
+        sprintf(bodybuf, "body%06d", i);
+        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf),
+                       NULL, 0, NULL, 0);
+        status = fdb_get(db, rdoc);
         TEST_CHK(status == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(rdoc->body, bodybuf, rdoc->bodylen));
         fdb_doc_free(rdoc);
     }
 
-    // close db2
-    status = fdb_kvs_close(db2);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    fdb_kvs_close(db);
+    fdb_close(dbfile);
 
-    // free resources
-    for (i=0; i<n; i++){
-       status = fdb_doc_free(doc[i]);
+    // the reader still reads from the mapping when a writer opened first
+    fdb_open(&dbfile_w, "./dummy2", &fconfig);
+    fdb_kvs_open_default(dbfile_w, &db_w, &kvs_config);
+    status = fdb_open(&dbfile, "./dummy2", &fconfig_r);
+    TEST_CHK(status == FDB_RESULT_SUCCESS);
+    fdb_kvs_open_default(dbfile, &db, &kvs_config);
+    fdb_reset_io_stats(dbfile);
+    for (i=0;i<n*4;++i){
+        sprintf(keybuf, "key%06d", i);
+        sprintf(bodybuf, "body%06d", i);
+        fdb_doc_create(&rdoc, (void*)keybuf, strlen(keybuf),
+                       NULL, 0, NULL, 0);
+        status = fdb_get(db, rdoc);
         TEST_CHK(status == FDB_RESULT_SUCCESS);
+        TEST_CHK(!memcmp(rdoc->body, bodybuf, rdoc->bodylen));
+        fdb_doc_free(rdoc);
     }
+    fdb_get_io_stats(dbfile, &iostats);
+    TEST_CHK(iostats.num_reads == 0);
+
+    fdb_kvs_close(db);
+    fdb_close(dbfile);
+    fdb_kvs_close(db_w);
+    fdb_close(dbfile_w);
 
-    status = fdb_close(dbfile1);
-    TEST_CHK(status == FDB_RESULT_SUCCESS);
     status = fdb_shutdown();
     TEST_CHK(status == FDB_RESULT_SUCCESS);
 
     memleak_end();
-    TEST_RESULT("multi KV close");
+    TEST_RESULT("memory-mapped read-only mode test");
 }
 
 int main(){
@@ -8699,12 +11336,18 @@ int main(){
     iterator_test();
     iterator_with_concurrent_updates_test();
     iterator_seek_test();
+    iterator_prefetch_test();
+    iterator_batch_test();
+    iterator_keys_only_test();
+    iterator_split_test();
+    estimate_range_test();
     sequence_iterator_test();
     sequence_iterator_duplicate_test();
     custom_compare_primitive_test();
     custom_compare_variable_test();
     snapshot_test();
     in_memory_snapshot_test();
+    in_memory_snapshot_share_test();
     rollback_test();
     rollback_and_snapshot_test();
     reverse_sequence_iterator_test();
@@ -8735,6 +11378,21 @@ int main(){
     multi_kv_fdb_open_custom_cmp_test();
     multi_kv_use_existing_mode_test();
     multi_kv_close_test();
+    multi_kv_drop_test();
+    range_delete_test();
+    bloom_filter_test();
+    baseline_file_compat_test();
+    node_format_test();
+    node_crc_format_test();
+    latency_stats_test();
+    buffer_cache_stats_test();
+    io_stats_test();
+    trace_test();
+    slow_op_test();
+    lock_stats_test();
+    cache_warmup_test();
+    index_prefetch_test();
+    mmap_read_test();
 
     purge_logically_deleted_doc_test();
     compaction_daemon_test(20);
@@ -116,6 +116,16 @@ void _filemgr_anomalous_get_errno_str(char *buf, size_t size) {
     return normal_filemgr_ops->get_errno_str(buf, size);
 }
 
+void *_filemgr_anomalous_mmap(int fd, size_t len)
+{
+    return normal_filemgr_ops->mmap(fd, len);
+}
+
+int _filemgr_anomalous_munmap(void *addr, size_t len)
+{
+    return normal_filemgr_ops->munmap(addr, len);
+}
+
 struct filemgr_ops anomalous_ops = {
     _filemgr_anomalous_open,
     _filemgr_anomalous_pwrite,
@@ -125,7 +135,9 @@ struct filemgr_ops anomalous_ops = {
     _filemgr_anomalous_file_size,
     _filemgr_anomalous_fdatasync,
     _filemgr_anomalous_fsync,
-    _filemgr_anomalous_get_errno_str
+    _filemgr_anomalous_get_errno_str,
+    _filemgr_anomalous_mmap,
+    _filemgr_anomalous_munmap
 };
 
 struct filemgr_ops * get_anomalous_filemgr_ops()
@@ -870,6 +870,102 @@ void hbtrie_partial_update_test()
     TEST_RESULT("HB+trie partial update test");
 }
 
+void hbtrie_path_cache_test()
+{
+    TEST_INIT();
+
+    int blocksize = 256;
+    struct btreeblk_handle bhandle;
+    struct docio_handle dhandle;
+    struct filemgr *file;
+    struct hbtrie trie;
+    struct docio_object doc;
+    struct filemgr_config config;
+    uint64_t offset, offset_old, _offset, nhits;
+    char keybuf[256], metabuf[256], bodybuf[256];
+    char dockey[256];
+    uint8_t valuebuf[8];
+    hbtrie_result r;
+    int i, j, n = 200, rr;
+
+    memleak_start();
+
+    rr = system(SHELL_DEL " dummy");
+    (void)rr;
+
+    doc.key = (void*)keybuf;
+    doc.meta = (void*)metabuf;
+    doc.body = (void*)bodybuf;
+
+    memset(&config, 0, sizeof(config));
+    config.blocksize = blocksize;
+    config.ncacheblock = 0;
+    config.flag = 0x0;
+    config.options = FILEMGR_CREATE;
+
+    filemgr_open_result result = filemgr_open((char *) "./dummy",
+                                              get_filemgr_ops(), &config, NULL);
+    file = result.file;
+    docio_init(&dhandle, file, false);
+    btreeblk_init(&bhandle, file, blocksize);
+
+    hbtrie_init(&trie, 8, 8, blocksize, BLK_NOT_FOUND,
+        (void*)&bhandle, btreeblk_get_ops(), (void*)&dhandle, _readkey_wrap);
+
+    for (j=0;j<3;++j) {
+        // keys sharing long prefixes create multiple levels of sub-trees
+        for (i=j*n/2;i<(j+2)*n/2;++i){
+            sprintf(dockey, "tenant%02d/region%02d/object%04d", i % 4, i % 8, i);
+            _set_doc(&doc, dockey, (char*)"meta", (char*)"body");
+            offset = docio_append_doc(&dhandle, &doc, 0, 0);
+            _offset = _endian_encode(offset);
+            hbtrie_insert(&trie, (void*)dockey, strlen(dockey),
+                          (void*)&_offset, (void*)&offset_old);
+            btreeblk_end(&bhandle);
+        }
+
+        // the root node is not committed yet .. path cache should not be used
+        nhits = trie.path_cache->nhits;
+        for (i=0;i<(j+2)*n/2;++i){
+            sprintf(dockey, "tenant%02d/region%02d/object%04d", i % 4, i % 8, i);
+            r = hbtrie_find(&trie, (void*)dockey, strlen(dockey), valuebuf);
+            btreeblk_end(&bhandle);
+            TEST_CHK(r == HBTRIE_RESULT_SUCCESS);
+        }
+        TEST_CHK(trie.path_cache->nhits == nhits);
+
+        filemgr_commit(file, NULL);
+
+        // lookups in the sorted order share the upper levels of path
+        for (i=0;i<(j+2)*n/2;++i){
+            sprintf(dockey, "tenant%02d/region%02d/object%04d",
+                    (i / 8) % 4, i % 8, i);
+            r = hbtrie_find(&trie, (void*)dockey, strlen(dockey), valuebuf);
+            btreeblk_end(&bhandle);
+            if (i % 4 == (i / 8) % 4) {
+                TEST_CHK(r == HBTRIE_RESULT_SUCCESS);
+                memcpy(&offset, valuebuf, 8);
+                offset = _endian_decode(offset);
+                docio_read_doc(&dhandle, offset, &doc);
+                TEST_CHK(doc.length.keylen == strlen(dockey));
+                TEST_CHK(!memcmp(doc.key, dockey, doc.length.keylen));
+            } else {
+                TEST_CHK(r == HBTRIE_RESULT_FAIL);
+            }
+        }
+        TEST_CHK(trie.path_cache->nhits > nhits);
+    }
+
+    hbtrie_free(&trie);
+    btreeblk_free(&bhandle);
+    docio_free(&dhandle);
+    filemgr_close(file, true, NULL, NULL);
+    filemgr_shutdown();
+    memleak_end();
+
+    TEST_RESULT("HB+trie path cache test");
+}
+
 int main(){
 #ifdef _MEMPOOL
     mempool_init();
@@ -880,6 +976,7 @@ int main(){
     skew_basic_test();
     hbtrie_reverse_iterator_test();
     hbtrie_partial_update_test();
+    hbtrie_path_cache_test();
     //large_test();
 
     return 0;
@@ -36,6 +36,8 @@
 #include "common.h"
 #include "wal.h"
 #include "snapshot.h"
+#include "range_del.h"
+#include "bloom.h"
 #include "filemgr_ops.h"
 #include "configuration.h"
 #include "internal_types.h"
@@ -109,6 +111,8 @@ void print_header(fdb_kvs_handle *db)
     uint64_t last_header_bid;
     uint64_t kv_info_offset;
     uint64_t header_flags;
+    uint64_t range_del_offset;
+    uint64_t bloom_offset;
     size_t header_len;
     size_t subblock_no, idx;
     char *compacted_filename = NULL;
@@ -126,7 +130,8 @@ void print_header(fdb_kvs_handle *db)
         fdb_fetch_header(header_buf, &trie_root_bid,
                          &seq_root_bid, &ndocs, &nlivenodes,
                          &datasize, &last_header_bid, &kv_info_offset,
-                         &header_flags, &compacted_filename, &prev_filename);
+                         &header_flags, &range_del_offset, &bloom_offset,
+                         &compacted_filename, &prev_filename);
         revnum = filemgr_get_header_revnum(db->file);
 
         bid = filemgr_get_header_bid(db->file);
@@ -177,6 +182,19 @@ void print_header(fdb_kvs_handle *db)
             printf("    DB header BID of the last WAL flush: not exist\n");
         }
 
+        if (range_del_offset != BLK_NOT_FOUND) {
+            printf("    Range tombstones: %" _F64 " (byte offset: %" _F64 ")\n",
+                   (uint64_t)range_del_get_count(db->file), range_del_offset);
+        }
+
+        if (bloom_offset != BLK_NOT_FOUND) {
+            fdb_bloom_stats stats;
+            bloom_get_stats(db->file, &stats);
+            printf("    Bloom filter: %" _F64 " keys, %" _F64 " bits "
+                   "(byte offset: %" _F64 ")\n",
+                   stats.num_keys, stats.num_bits, bloom_offset);
+        }
+
         if (db->config.multi_kv_instances) {
             // multi KV instance mode
             int i;
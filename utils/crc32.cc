@@ -372,3 +372,164 @@ uint32_t crc32_8_last8(void *data, size_t len, uint32_t prev_value)
     return crc32_8(src, min, prev_value);
 }
 
+
+/*
+ * CRC32C (Castagnoli polynomial). Unlike the CRC32 above, it is supported
+ * by the SSE4.2 'crc32' instruction on x86-64 and by the CRC extension of
+ * ARMv8 (enabled by compiling with '-march=armv8-a+crc'). The fastest
+ * available implementation is chosen once when the library is loaded.
+ */
+#define CRC32C_POLYNOMIAL (0x82F63B78)
+
+static uint32_t crc32c_lookup[8][256];
+
+static void _crc32c_init_lookup()
+{
+    int i, j;
+    uint32_t crc;
+    for (i=0; i<=0xff; ++i) {
+        crc = i;
+        for (j=0; j<8; ++j) {
+            crc = (crc >> 1) ^ ((crc & 1) * CRC32C_POLYNOMIAL);
+        }
+        crc32c_lookup[0][i] = crc;
+    }
+    for (i=0; i<=0xff; ++i) {
+        for (j=1; j<8; ++j) {
+            crc32c_lookup[j][i] = (crc32c_lookup[j-1][i] >> 8) ^
+                                  crc32c_lookup[0][crc32c_lookup[j-1][i] & 0xff];
+        }
+    }
+}
+
+uint32_t crc32c_8(void *data, size_t len, uint32_t prev_value)
+{
+    uint32_t *cur = (uint32_t*) data;
+    uint32_t crc = ~prev_value;
+
+    while (len >= 8) {
+#ifdef _BIG_ENDIAN
+        uint32_t one = *cur++ ^ bitswap32(crc);
+        uint32_t two = *cur++;
+        crc =
+            crc32c_lookup[7][(one>>24) & 0xFF] ^
+            crc32c_lookup[6][(one>>16) & 0xFF] ^
+            crc32c_lookup[5][(one>> 8) & 0xFF] ^
+            crc32c_lookup[4][(one    ) & 0xFF] ^
+            crc32c_lookup[3][(two>>24) & 0xFF] ^
+            crc32c_lookup[2][(two>>16) & 0xFF] ^
+            crc32c_lookup[1][(two>> 8) & 0xFF] ^
+            crc32c_lookup[0][(two    ) & 0xFF];
+#else
+        uint32_t one = *cur++ ^ crc;
+        uint32_t two = *cur++;
+        crc =
+            crc32c_lookup[7][(one    ) & 0xFF] ^
+            crc32c_lookup[6][(one>> 8) & 0xFF] ^
+            crc32c_lookup[5][(one>>16) & 0xFF] ^
+            crc32c_lookup[4][(one>>24) & 0xFF] ^
+            crc32c_lookup[3][(two    ) & 0xFF] ^
+            crc32c_lookup[2][(two>> 8) & 0xFF] ^
+            crc32c_lookup[1][(two>>16) & 0xFF] ^
+            crc32c_lookup[0][(two>>24) & 0xFF];
+#endif
+        len -= 8;
+    }
+
+    unsigned char *cur_byte = (unsigned char*) cur;
+    while (len--)
+        crc = (crc >> 8) ^ crc32c_lookup[0][(crc & 0xFF) ^ *cur_byte++];
+
+    return ~crc;
+}
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define __CRC32C_SSE42
+#include <nmmintrin.h>
+
+__attribute__((target("sse4.2")))
+static uint32_t _crc32c_sse42(void *data, size_t len, uint32_t prev_value)
+{
+    const uint8_t *cur = (const uint8_t*) data;
+    uint64_t crc = ~prev_value;
+    uint64_t word;
+
+    // align to 8 bytes
+    while (len && ((uintptr_t)cur & 0x7)) {
+        crc = _mm_crc32_u8((uint32_t)crc, *cur++);
+        len--;
+    }
+    while (len >= 8) {
+        memcpy(&word, cur, sizeof(word));
+        crc = _mm_crc32_u64(crc, word);
+        cur += 8;
+        len -= 8;
+    }
+    while (len--) {
+        crc = _mm_crc32_u8((uint32_t)crc, *cur++);
+    }
+
+    return ~(uint32_t)crc;
+}
+
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#define __CRC32C_ARMV8
+#include <arm_acle.h>
+
+static uint32_t _crc32c_armv8(void *data, size_t len, uint32_t prev_value)
+{
+    const uint8_t *cur = (const uint8_t*) data;
+    uint32_t crc = ~prev_value;
+    uint64_t word;
+
+    while (len && ((uintptr_t)cur & 0x7)) {
+        crc = __crc32cb(crc, *cur++);
+        len--;
+    }
+    while (len >= 8) {
+        memcpy(&word, cur, sizeof(word));
+        crc = __crc32cd(crc, word);
+        cur += 8;
+        len -= 8;
+    }
+    while (len--) {
+        crc = __crc32cb(crc, *cur++);
+    }
+
+    return ~crc;
+}
+#endif
+
+typedef uint32_t crc32c_func(void *data, size_t len, uint32_t prev_value);
+
+static const char *crc32c_name;
+
+static crc32c_func * _crc32c_select()
+{
+    _crc32c_init_lookup();
+#if defined(__CRC32C_SSE42)
+    // required as this is called during static initialization
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.2")) {
+        crc32c_name = "sse4.2";
+        return _crc32c_sse42;
+    }
+#elif defined(__CRC32C_ARMV8)
+    crc32c_name = "armv8";
+    return _crc32c_armv8;
+#endif
+    crc32c_name = "slicing-8";
+    return crc32c_8;
+}
+
+static crc32c_func *crc32c_impl = _crc32c_select();
+
+uint32_t crc32c(void *data, size_t len, uint32_t prev_value)
+{
+    return crc32c_impl(data, len, prev_value);
+}
+
+const char * crc32c_impl_name(void)
+{
+    return crc32c_name;
+}
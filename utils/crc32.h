@@ -9,6 +9,13 @@ uint32_t crc32_1(void* data, size_t len, uint32_t prev_value);
 uint32_t crc32_8(void* data, size_t len, uint32_t prev_value);
 uint32_t crc32_8_last8(void *data, size_t len, uint32_t prev_value);
 
+// CRC32C (Castagnoli): hardware-accelerated if available
+uint32_t crc32c(void *data, size_t len, uint32_t prev_value);
+// CRC32C using the table-driven slicing-by-8 algorithm
+uint32_t crc32c_8(void *data, size_t len, uint32_t prev_value);
+// name of the implementation used by crc32c()
+const char * crc32c_impl_name(void);
+
 #ifdef __cplusplus
 }
 #endif
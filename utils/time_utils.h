@@ -19,8 +19,11 @@
 #define _JSAHN_TIME_UTILS_H
 
 #include <time.h>
+#include <stdint.h>
 #if defined(WIN32) || defined(_WIN32)
 #include <Windows.h>
+#elif defined(__APPLE__)
+#include <mach/mach_time.h>
 #endif
 
 #ifdef __cplusplus
@@ -40,6 +43,27 @@ static inline struct timeval _utime_gap(struct timeval a, struct timeval b)
     return ret;
 }
 
+// monotonic timestamp in nanoseconds, for measuring short intervals
+static inline uint64_t get_monotonic_ts()
+{
+#if defined(WIN32) || defined(_WIN32)
+    LARGE_INTEGER count, freq;
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&freq);
+    return (uint64_t)((double)count.QuadPart * 1000000000.0 / freq.QuadPart);
+#elif defined(__APPLE__)
+    static mach_timebase_info_data_t timebase;
+    if (timebase.denom == 0) {
+        mach_timebase_info(&timebase);
+    }
+    return mach_absolute_time() * timebase.numer / timebase.denom;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
 #ifdef __cplusplus
 }
 #endif